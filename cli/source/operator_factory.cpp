@@ -30,7 +30,7 @@ auto ParseReinserter(std::string const& str, ComparisonCallback&& comp) -> std::
     return reinserter;
 }
 
-auto ParseSelector(std::string const& str, ComparisonCallback&& comp) -> std::unique_ptr<Operon::SelectorBase>
+auto ParseSelector(std::string const& str, ComparisonCallback&& comp, Evaluator const* evaluator, uint64_t seed) -> std::unique_ptr<Operon::SelectorBase>
 {
     auto tok = Split(str, ':');
     auto name = tok[0];
@@ -51,6 +51,11 @@ auto ParseSelector(std::string const& str, ComparisonCallback&& comp) -> std::un
         dynamic_cast<Operon::RankTournamentSelector*>(selector.get())->SetTournamentSize(tournamentSize);
     } else if (name == "random") {
         selector = std::make_unique<Operon::RandomSelector>();
+    } else if (name == "lexicase") {
+        if (evaluator == nullptr) { throw std::runtime_error("The lexicase selector needs a single error metric\n"); }
+        size_t cases{Operon::LexicaseSelector::DefaultCases};
+        if (tok.size() > 1) { scn::scan(tok[1], "{}", cases); }
+        selector = std::make_unique<Operon::LexicaseSelector>(*evaluator, cases, seed);
     }
         
     return selector;
@@ -130,16 +135,22 @@ auto ParseGenerator(std::string const& str, EvaluatorBase& eval, CrossoverBase&
     } else if (name == "os") {
         size_t maxSelectionPressure{100};
         double comparisonFactor{0};
+        double successRatio{1};
         if (tok.size() > 1) { scn::scan(tok[1], "{}", maxSelectionPressure); }
         if (tok.size() > 2) { scn::scan(tok[2], "{}", comparisonFactor); }
+        if (tok.size() > 3) { scn::scan(tok[3], "{}", successRatio); }
         generator = std::make_unique<OffspringSelectionGenerator>(eval, cx, mut, femSel, maleSel);
         dynamic_cast<OffspringSelectionGenerator*>(generator.get())->MaxSelectionPressure(maxSelectionPressure);
         dynamic_cast<OffspringSelectionGenerator*>(generator.get())->ComparisonFactor(comparisonFactor);
+        dynamic_cast<OffspringSelectionGenerator*>(generator.get())->SuccessRatio(successRatio);
     } else if (name == "brood") {
         generator = std::make_unique<BroodOffspringGenerator>(eval, cx, mut, femSel, maleSel);
         size_t broodSize{5};
+        size_t broodThreads{0};
         if (tok.size() > 1) { scn::scan(tok[1], "{}", broodSize); }
+        if (tok.size() > 2) { scn::scan(tok[2], "{}", broodThreads); }
         dynamic_cast<BroodOffspringGenerator*>(generator.get())->BroodSize(broodSize);
+        dynamic_cast<BroodOffspringGenerator*>(generator.get())->BroodThreads(broodThreads);
     } else if (name == "poly") {
         generator = std::make_unique<BroodOffspringGenerator>(eval, cx, mut, femSel, maleSel);
         size_t polygenicSize{5};
@@ -13,6 +13,7 @@
 #include "operon/core/individual.hpp"          // for Comparison
 #include "operon/interpreter/interpreter.hpp"  // for Interpreter
 #include "util.hpp"                            // for Split
+namespace Operon { class Evaluator; }
 namespace Operon { class EvaluatorBase; }
 namespace Operon { class KeepBestReinserter; }
 namespace Operon { class OffspringGeneratorBase; }
@@ -31,7 +32,8 @@ namespace Operon {
 
 auto ParseReinserter(std::string const& str, ComparisonCallback&& comp) -> std::unique_ptr<ReinserterBase>;
 
-auto ParseSelector(std::string const& str, ComparisonCallback&& comp) -> std::unique_ptr<SelectorBase>;
+// the lexicase selector needs the evaluator (with a single error metric) to compute the errors on the cases
+auto ParseSelector(std::string const& str, ComparisonCallback&& comp, Evaluator const* evaluator = nullptr, uint64_t seed = 0) -> std::unique_ptr<SelectorBase>;
 
 auto ParseCreator(std::string const& str, PrimitiveSet const& pset, Operon::Span<Variable const> inputs) -> std::unique_ptr<CreatorBase>;
 
@@ -0,0 +1,49 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <cstdlib>
+#include <string>
+
+#include <cxxopts.hpp>
+#include <fmt/core.h>
+
+#include "operon/core/dataset.hpp"
+
+auto main(int argc, char** argv) -> int
+{
+    cxxopts::Options opts("operon_convert_dataset", "Convert a csv dataset into the binary (memory mappable) format");
+
+    opts.add_options()
+        ("input", "Input file name (csv) (required)", cxxopts::value<std::string>())
+        ("output", "Output file name (required)", cxxopts::value<std::string>())
+        ("no-header", "The csv file has no header row (the variables are named X1, X2, ...)", cxxopts::value<bool>()->default_value("false"))
+        ("help", "Print help");
+
+    cxxopts::ParseResult result;
+    try {
+        result = opts.parse(argc, argv);
+    } catch (cxxopts::OptionParseException const& ex) {
+        fmt::print(stderr, "error: {}. rerun with --help to see available options.\n", ex.what());
+        return EXIT_FAILURE;
+    };
+
+    if (result.arguments().empty() || result.count("help") > 0) {
+        fmt::print("{}\n", opts.help());
+        return EXIT_SUCCESS;
+    }
+
+    if (result.count("input") == 0 || result.count("output") == 0) {
+        fmt::print(stderr, "error: both the input and the output file must be specified.\n");
+        return EXIT_FAILURE;
+    }
+
+    try {
+        Operon::Dataset ds(result["input"].as<std::string>(), /*hasHeader=*/!result["no-header"].as<bool>());
+        ds.WriteBinary(result["output"].as<std::string>());
+        fmt::print("wrote {} rows and {} columns\n", ds.Rows(), ds.Cols());
+    } catch (std::exception const& ex) {
+        fmt::print(stderr, "error: {}\n", ex.what());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
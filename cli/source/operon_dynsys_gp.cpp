@@ -15,7 +15,9 @@
 #include <taskflow/algorithm/reduce.hpp>
 #endif
 #include "operon/algorithms/gp.hpp"
+#include "operon/algorithms/model_report.hpp"
 #include "operon/core/format.hpp"
+#include "operon/core/indexed_dataset.hpp"
 #include "operon/core/version.hpp"
 #include "operon/core/problem.hpp"
 #include "operon/interpreter/interpreter.hpp"
@@ -25,6 +27,7 @@
 #include "operon/operators/generator.hpp"
 #include "operon/operators/initializer.hpp"
 #include "operon/operators/mutation.hpp"
+#include "operon/operators/ode_evaluator.hpp"
 #include "operon/operators/reinserter.hpp"
 #include "operon/operators/selector.hpp"
 
@@ -48,6 +51,10 @@ auto init_ode_options(std::string const& name, std::string const& desc) -> cxxop
         ("inputs", "Comma-separated list of input variables", cxxopts::value<std::string>())
         ("epsilon", "Tolerance for fitness comparison (needed e.g. for eps-dominance)", cxxopts::value<Operon::Scalar>()->default_value("1e-6"))
         ("error-metric", "The error metric used for calculating fitness", cxxopts::value<std::string>()->default_value("r2"))
+        ("step", "Time between two consecutive rows of the dataset", cxxopts::value<Operon::Scalar>()->default_value("1"))
+        ("ode-method", "Integration method for the trajectories (rk4, rk45)", cxxopts::value<std::string>()->default_value("rk4"))
+        ("ode-substeps", "Integration steps between two rows (rk4)", cxxopts::value<size_t>()->default_value("1"))
+        ("ode-tolerance", "Local error tolerance (rk45)", cxxopts::value<Operon::Scalar>()->default_value("1e-6"))
         ("population-size", "Population size", cxxopts::value<size_t>()->default_value("1000"))
         ("pool-size", "Recombination pool size (how many generated offspring per generation)", cxxopts::value<size_t>()->default_value("1000"))
         ("seed", "Random number seed", cxxopts::value<Operon::RandomGenerator::result_type>()->default_value("0"))
@@ -117,7 +124,6 @@ auto main(int argc, char** argv) -> int
 
             if (key == "dataset") {
                 dataset = std::make_unique<Operon::Dataset>(value, true);
-                ENSURE(!dataset->IsView());
             }
             if (key == "seed") {
                 config.Seed = kv.as<size_t>();
@@ -255,7 +261,13 @@ auto main(int argc, char** argv) -> int
         auto const& [error, scale] = Operon::ParseErrorMetric(result["error-metric"].as<std::string>());
 
         Operon::Interpreter interpreter;
-        Operon::Evaluator evaluator(problem, interpreter, *error, scale);
+        // the models are right-hand sides of the target, the linear scaling does not apply to integrated trajectories
+        Operon::OdeEvaluator evaluator(problem, interpreter, result["step"].as<Operon::Scalar>(), *error);
+        Operon::OdeOptions odeOptions;
+        odeOptions.Method = result["ode-method"].as<std::string>() == "rk45" ? Operon::OdeMethod::RK45 : Operon::OdeMethod::RK4;
+        odeOptions.Substeps = result["ode-substeps"].as<size_t>();
+        odeOptions.Tolerance = result["ode-tolerance"].as<Operon::Scalar>();
+        evaluator.SetOptions(odeOptions);
 
         evaluator.SetLocalOptimizationIterations(config.Iterations);
         evaluator.SetBudget(config.Evaluations);
@@ -272,7 +284,14 @@ auto main(int argc, char** argv) -> int
 
         Operon::RandomGenerator random(config.Seed);
         if (result["shuffle"].as<bool>()) {
-            problem.GetDataset().Shuffle(random);
+            // in place, unless the dataset is a (read-only) memory mapped view: its rows are gathered through an index permutation
+            auto& ds = problem.GetDataset();
+            if (ds.IsView()) {
+                auto shuffled = Operon::IndexedDataset::Shuffled(ds, random).Materialize();
+                ds.Swap(shuffled);
+            } else {
+                ds.Shuffle(random);
+            }
         }
         if (result["standardize"].as<bool>()) {
             problem.StandardizeData(problem.TrainingRange());
@@ -284,10 +303,6 @@ auto main(int argc, char** argv) -> int
 
         Operon::GeneticProgrammingAlgorithm gp { problem, config, treeInitializer, *coeffInitializer, *generator, *reinserter };
 
-        auto targetValues = problem.TargetValues();
-        auto targetTrain = targetValues.subspan(trainingRange.Start(), trainingRange.Size());
-        auto targetTest = targetValues.subspan(testRange.Start(), testRange.Size());
-
         // some boilerplate for reporting results
         const size_t idx { 0 };
         auto getBest = [&](Operon::Span<Operon::Individual const> pop) -> Operon::Individual {
@@ -299,6 +314,7 @@ auto main(int argc, char** argv) -> int
         auto getSize = [](Operon::Individual const& ind) { return sizeof(ind) + sizeof(ind.Genotype) + sizeof(Operon::Node) * ind.Genotype.Nodes().capacity(); };
 
         tf::Executor exe(threads);
+        Operon::ModelReport modelReport(problem, interpreter);
 
         auto report = [&]() {
             auto const& pop = gp.Parents();
@@ -306,71 +322,11 @@ auto main(int argc, char** argv) -> int
 
             best = getBest(pop);
 
-            Operon::Vector<Operon::Scalar> estimatedTrain;
-            Operon::Vector<Operon::Scalar> estimatedTest;
+            // the statistics of the best model are computed by the report worker meanwhile
+            auto statistics = modelReport.Submit(best.Genotype);
 
             tf::Taskflow taskflow;
 
-            auto evalTrain = taskflow.emplace([&]() {
-                estimatedTrain = interpreter.Evaluate<Operon::Scalar>(best.Genotype, problem.GetDataset(), trainingRange);
-            });
-
-            auto evalTest = taskflow.emplace([&]() {
-                estimatedTest = interpreter.Evaluate<Operon::Scalar>(best.Genotype, problem.GetDataset(), testRange);
-            });
-
-            // scale values
-            Operon::Scalar a{};
-            Operon::Scalar b{};
-            auto linearScaling = taskflow.emplace([&]() {
-                auto [a_, b_] = Operon::FitLeastSquares(estimatedTrain, targetTrain);
-                a = static_cast<Operon::Scalar>(a_);
-                b = static_cast<Operon::Scalar>(b_);
-                // add scaling terms to the tree
-                auto& nodes = best.Genotype.Nodes();
-                auto const sz = nodes.size();
-                if (std::abs(a - Operon::Scalar{1}) > std::numeric_limits<Operon::Scalar>::epsilon()) {
-                    nodes.emplace_back(Operon::Node::Constant(a));
-                    nodes.emplace_back(Operon::Node(Operon::NodeType::Mul));
-                }
-                if (std::abs(b) > std::numeric_limits<Operon::Scalar>::epsilon()) {
-                    nodes.emplace_back(Operon::Node::Constant(b));
-                    nodes.emplace_back(Operon::Node(Operon::NodeType::Add));
-                }
-                if (nodes.size() > sz) {
-                    best.Genotype.UpdateNodes();
-                }
-            });
-
-            double r2Train{};
-            double r2Test{};
-            double nmseTrain{};
-            double nmseTest{};
-            double maeTrain{};
-            double maeTest{};
-
-            auto scaleTrain = taskflow.emplace([&]() {
-                Eigen::Map<Eigen::Array<Operon::Scalar, -1, 1>> estimated(estimatedTrain.data(), estimatedTrain.size());
-                estimated = estimated * a + b;
-            });
-
-            auto scaleTest = taskflow.emplace([&]() {
-                Eigen::Map<Eigen::Array<Operon::Scalar, -1, 1>> estimated(estimatedTest.data(), estimatedTest.size());
-                estimated = estimated * a + b;
-            });
-
-            auto calcStats = taskflow.emplace([&]() {
-                // negate the R2 because this is an internal fitness measure (minimization) which we here repurpose
-                r2Train = -Operon::R2{}(estimatedTrain, targetTrain);
-                r2Test = -Operon::R2{}(estimatedTest, targetTest);
-
-                nmseTrain = Operon::NMSE{}(estimatedTrain, targetTrain);
-                nmseTest = Operon::NMSE{}(estimatedTest, targetTest);
-
-                maeTrain = Operon::MAE{}(estimatedTrain, targetTrain);
-                maeTest = Operon::MAE{}(estimatedTest, targetTest);
-            });
-
             double avgLength = 0;
             double avgQuality = 0;
             double totalMemory = 0;
@@ -380,14 +336,26 @@ auto main(int argc, char** argv) -> int
             auto calculatePopMemory = taskflow.transform_reduce(pop.begin(), pop.end(), totalMemory, std::plus{}, [&](auto const& ind) { return getSize(ind); });
             auto calculateOffMemory = taskflow.transform_reduce(off.begin(), off.end(), totalMemory, std::plus{}, [&](auto const& ind) { return getSize(ind); });
 
-            // define task graph
-            linearScaling.succeed(evalTrain, evalTest);
-            linearScaling.precede(scaleTrain, scaleTest);
-            calcStats.succeed(scaleTrain, scaleTest);
-            calcStats.precede(calculateLength, calculateQuality, calculatePopMemory, calculateOffMemory);
-
             exe.run(taskflow).wait();
 
+            auto const model = statistics.get();
+            // add scaling terms to the tree
+            auto const a = static_cast<Operon::Scalar>(model.Scale);
+            auto const b = static_cast<Operon::Scalar>(model.Offset);
+            auto& nodes = best.Genotype.Nodes();
+            auto const sz = nodes.size();
+            if (std::abs(a - Operon::Scalar{1}) > std::numeric_limits<Operon::Scalar>::epsilon()) {
+                nodes.emplace_back(Operon::Node::Constant(a));
+                nodes.emplace_back(Operon::Node(Operon::NodeType::Mul));
+            }
+            if (std::abs(b) > std::numeric_limits<Operon::Scalar>::epsilon()) {
+                nodes.emplace_back(Operon::Node::Constant(b));
+                nodes.emplace_back(Operon::Node(Operon::NodeType::Add));
+            }
+            if (nodes.size() > sz) {
+                best.Genotype.UpdateNodes();
+            }
+
             avgLength /= static_cast<double>(pop.size());
             avgQuality /= static_cast<double>(pop.size());
 
@@ -398,12 +366,12 @@ auto main(int argc, char** argv) -> int
             auto const* format = ":>#8.3g";
             std::array stats {
                 T{ "iteration", gp.Generation(), ":>" },
-                T{ "r2_tr", r2Train, format },
-                T{ "r2_te", r2Test, format },
-                T{ "mae_tr", maeTrain, format },
-                T{ "mae_te", maeTest, format },
-                T{ "nmse_tr", nmseTrain, format },
-                T{ "nmse_te", nmseTest, format },
+                T{ "r2_tr", model.R2Train, format },
+                T{ "r2_te", model.R2Test, format },
+                T{ "mae_tr", model.MaeTrain, format },
+                T{ "mae_te", model.MaeTest, format },
+                T{ "nmse_tr", model.NmseTrain, format },
+                T{ "nmse_te", model.NmseTest, format },
                 T{ "avg_fit", avgQuality, format },
                 T{ "avg_len", avgLength, format },
                 T{ "eval_cnt", evaluator.EvaluationCount() , ":>" },
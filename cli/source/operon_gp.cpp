@@ -8,17 +8,41 @@
 #include <cxxopts.hpp>
 #include <fmt/core.h>
 
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <future>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
 #include <thread>
 #include <taskflow/taskflow.hpp>
 #if TF_MINOR_VERSION > 2
 #include <taskflow/algorithm/reduce.hpp>
 #endif
+#include "operon/algorithms/async_gp.hpp"
+#include "operon/algorithms/batch.hpp"
+#include "operon/algorithms/checkpoint.hpp"
 #include "operon/algorithms/gp.hpp"
+#include "operon/algorithms/model_report.hpp"
+#include "operon/algorithms/termination.hpp"
+#include "operon/core/affinity.hpp"
+#include "operon/core/allocation.hpp"
 #include "operon/core/format.hpp"
+#include "operon/core/instrumentation.hpp"
+#include "operon/core/indexed_dataset.hpp"
+#include "operon/core/memory.hpp"
+#include "operon/core/metrics.hpp"
 #include "operon/core/version.hpp"
 #include "operon/core/problem.hpp"
+#include "operon/core/serialization.hpp"
+#include "operon/core/trace.hpp"
 #include "operon/interpreter/interpreter.hpp"
+#include "operon/interpreter/plugin.hpp"
 #include "operon/operators/creator.hpp"
 #include "operon/operators/crossover.hpp"
 #include "operon/operators/evaluator.hpp"
@@ -27,15 +51,45 @@
 #include "operon/operators/mutation.hpp"
 #include "operon/operators/reinserter.hpp"
 #include "operon/operators/selector.hpp"
+#include "operon/operators/semantic_sketch.hpp"
 
 #include "util.hpp"
 #include "operator_factory.hpp"
+#include "service.hpp"
 
-auto main(int argc, char** argv) -> int
+
+namespace {
+// appends the linear scaling terms of the model statistics to the tree
+auto AddScaling(Operon::Tree& tree, Operon::ModelStatistics const& model) -> void
 {
-    auto opts = Operon::InitOptions("operon_gp", "Genetic programming symbolic regression");
-    auto result = Operon::ParseOptions(std::move(opts), argc, argv);
+    auto const a = static_cast<Operon::Scalar>(model.Scale);
+    auto const b = static_cast<Operon::Scalar>(model.Offset);
+    auto& nodes = tree.Nodes();
+    auto const sz = nodes.size();
+    if (std::abs(a - Operon::Scalar{1}) > std::numeric_limits<Operon::Scalar>::epsilon()) {
+        nodes.emplace_back(Operon::Node::Constant(a));
+        nodes.emplace_back(Operon::Node(Operon::NodeType::Mul));
+    }
+    if (std::abs(b) > std::numeric_limits<Operon::Scalar>::epsilon()) {
+        nodes.emplace_back(Operon::Node::Constant(b));
+        nodes.emplace_back(Operon::Node(Operon::NodeType::Add));
+    }
+    if (nodes.size() > sz) {
+        tree.UpdateNodes();
+    }
+}
+
+// the outcome of a run: the statistics and the best model, with its scaling terms
+struct Fit {
+    Operon::BatchRunner::Summary Summary;
+    Operon::Tree Model;
+};
 
+// one run of the algorithm with the options on the dataset and the executor. with an output the statistics of every
+// generation and the best model are printed to it (e.g. stdout or a client of the service mode), the runs of a batch
+// only return their outcome
+auto RunConfiguration(cxxopts::ParseResult const& result, Operon::Dataset const& dataset, tf::Executor& executor, std::FILE* out) -> Fit
+{
     // parse and set default values
     Operon::GeneticAlgorithmConfig config;
     config.Generations = result["generations"].as<size_t>();
@@ -51,10 +105,7 @@ auto main(int argc, char** argv) -> int
     // parse remaining config options
     Operon::Range trainingRange;
     Operon::Range testRange;
-    std::unique_ptr<Operon::Dataset> dataset;
     std::string target;
-    bool showPrimitiveSet = false;
-    auto threads = std::thread::hardware_concurrency();
     Operon::NodeType primitiveSetConfig = Operon::PrimitiveSet::Arithmetic;
 
     auto maxLength = result["maxlength"].as<size_t>();
@@ -63,313 +114,591 @@ auto main(int argc, char** argv) -> int
 
     auto symbolic = result["symbolic"].as<bool>();
 
-    try {
-        for (const auto& kv : result.arguments()) {
-            const auto& key = kv.key();
-            const auto& value = kv.value();
+    for (const auto& kv : result.arguments()) {
+        const auto& key = kv.key();
+        const auto& value = kv.value();
 
-            if (key == "dataset") {
-                dataset = std::make_unique<Operon::Dataset>(value, true);
-                ENSURE(!dataset->IsView());
-            }
-            if (key == "seed") {
-                config.Seed = kv.as<size_t>();
-            }
-            if (key == "train") {
-                trainingRange = Operon::ParseRange(value);
-            }
-            if (key == "test") {
-                testRange = Operon::ParseRange(value);
-            }
-            if (key == "target") {
-                target = value;
-            }
-            if (key == "maxlength") {
-                maxLength = kv.as<size_t>();
-            }
-            if (key == "maxdepth") {
-                maxDepth = kv.as<size_t>();
-            }
-            if (key == "enable-symbols") {
-                auto mask = Operon::ParsePrimitiveSetConfig(value);
-                primitiveSetConfig |= mask;
-            }
-            if (key == "disable-symbols") {
-                auto mask = ~Operon::ParsePrimitiveSetConfig(value);
-                primitiveSetConfig &= mask;
-            }
-            if (key == "threads") {
-                threads = static_cast<decltype(threads)>(kv.as<size_t>());
-            }
-            if (key == "show-primitives") {
-                showPrimitiveSet = true;
-            }
+        if (key == "seed") {
+            config.Seed = kv.as<size_t>();
         }
-
-        if (showPrimitiveSet) {
-            Operon::PrintPrimitives(primitiveSetConfig);
-            return EXIT_SUCCESS;
+        if (key == "train") {
+            trainingRange = Operon::ParseRange(value);
         }
-        if (auto res = dataset->GetVariable(target); !res.has_value()) {
-            fmt::print(stderr, "error: target variable {} does not exist in the dataset.", target);
-            return EXIT_FAILURE;
+        if (key == "test") {
+            testRange = Operon::ParseRange(value);
         }
-        if (result.count("train") == 0) {
-            trainingRange = Operon::Range{ 0, 2 * dataset->Rows() / 3 }; // by default use 66% of the data as training
+        if (key == "target") {
+            target = value;
         }
-        if (result.count("test") == 0) {
-            // if no test range is specified, we try to infer a reasonable range based on the trainingRange
-            if (trainingRange.Start() > 0) {
-                testRange = Operon::Range{ 0, trainingRange.Start() };
-            } else if (trainingRange.End() < dataset->Rows()) {
-                testRange = Operon::Range{ trainingRange.End(), dataset->Rows() };
-            } else {
-                testRange = Operon::Range{ 0, 1};
-            }
+        if (key == "maxlength") {
+            maxLength = kv.as<size_t>();
         }
-        // validate training range
-        if (trainingRange.Start() >= dataset->Rows() || trainingRange.End() > dataset->Rows()) {
-            fmt::print(stderr, "error: the training range {}:{} exceeds the available data range ({} rows)\n", trainingRange.Start(), trainingRange.End(), dataset->Rows());
-            return EXIT_FAILURE;
+        if (key == "maxdepth") {
+            maxDepth = kv.as<size_t>();
         }
-
-        if (trainingRange.Start() > trainingRange.End()) {
-            fmt::print(stderr, "error: invalid training range {}:{}\n", trainingRange.Start(), trainingRange.End());
-            return EXIT_FAILURE;
+        if (key == "enable-symbols") {
+            auto mask = Operon::ParsePrimitiveSetConfig(value);
+            primitiveSetConfig |= mask;
+        }
+        if (key == "disable-symbols") {
+            auto mask = ~Operon::ParsePrimitiveSetConfig(value);
+            primitiveSetConfig &= mask;
         }
+    }
 
-        std::vector<Operon::Variable> inputs;
-        if (result.count("inputs") == 0) {
-            auto variables = dataset->Variables();
-            std::copy_if(variables.begin(), variables.end(), std::back_inserter(inputs), [&](auto const& var) { return var.Name != target; });
+    if (auto res = dataset.GetVariable(target); !res.has_value()) {
+        throw std::runtime_error(fmt::format("target variable {} does not exist in the dataset", target));
+    }
+    if (result.count("train") == 0) {
+        trainingRange = Operon::Range{ 0, 2 * dataset.Rows() / 3 }; // by default use 66% of the data as training
+    }
+    if (result.count("test") == 0) {
+        // if no test range is specified, we try to infer a reasonable range based on the trainingRange
+        if (trainingRange.Start() > 0) {
+            testRange = Operon::Range{ 0, trainingRange.Start() };
+        } else if (trainingRange.End() < dataset.Rows()) {
+            testRange = Operon::Range{ trainingRange.End(), dataset.Rows() };
         } else {
-            auto str = result["inputs"].as<std::string>();
-            auto tokens = Operon::Split(str, ',');
-
-            for (auto const& tok : tokens) {
-                if (auto res = dataset->GetVariable(tok); res.has_value()) {
-                    inputs.push_back(res.value());
-                } else {
-                    fmt::print(stderr, "error: variable {} does not exist in the dataset.", tok);
-                    return EXIT_FAILURE;
-                }
-            }
+            testRange = Operon::Range{ 0, 1};
         }
+    }
+    // validate training range
+    if (trainingRange.Start() >= dataset.Rows() || trainingRange.End() > dataset.Rows()) {
+        throw std::runtime_error(fmt::format("the training range {}:{} exceeds the available data range ({} rows)", trainingRange.Start(), trainingRange.End(), dataset.Rows()));
+    }
 
-        auto problem = Operon::Problem(*dataset).Inputs(inputs).Target(target).TrainingRange(trainingRange).TestRange(testRange);
-        problem.GetPrimitiveSet().SetConfig(primitiveSetConfig);
-
-        std::unique_ptr<Operon::CreatorBase> creator;
-        creator = ParseCreator(result["tree-creator"].as<std::string>(), problem.GetPrimitiveSet(), problem.InputVariables());
-
-        auto [amin, amax] = problem.GetPrimitiveSet().FunctionArityLimits();
-        Operon::UniformTreeInitializer treeInitializer(*creator);
-        treeInitializer.ParameterizeDistribution(amin+1, maxLength);
-        treeInitializer.SetMinDepth(1);
-        treeInitializer.SetMaxDepth(1000); // NOLINT
-                                           //
-        std::unique_ptr<Operon::CoefficientInitializerBase> coeffInitializer;
-        std::unique_ptr<Operon::MutatorBase> onePoint;
-        if (symbolic) {
-            using Dist = std::uniform_int_distribution<int>;
-            coeffInitializer = std::make_unique<Operon::CoefficientInitializer<Dist>>();
-            int constexpr range{5};
-            dynamic_cast<Operon::CoefficientInitializer<Dist>*>(coeffInitializer.get())->ParameterizeDistribution(-range, +range);
-            onePoint = std::make_unique<Operon::OnePointMutation<Dist>>();
-            dynamic_cast<Operon::OnePointMutation<Dist>*>(onePoint.get())->ParameterizeDistribution(-range, +range);
-        } else {
-            using Dist = std::normal_distribution<Operon::Scalar>;
-            coeffInitializer = std::make_unique<Operon::CoefficientInitializer<Dist>>();
-            dynamic_cast<Operon::NormalCoefficientInitializer*>(coeffInitializer.get())->ParameterizeDistribution(Operon::Scalar{0}, Operon::Scalar{1});
-            onePoint = std::make_unique<Operon::OnePointMutation<Dist>>();
-            dynamic_cast<Operon::OnePointMutation<Dist>*>(onePoint.get())->ParameterizeDistribution(Operon::Scalar{0}, Operon::Scalar{1});
+    if (trainingRange.Start() > trainingRange.End()) {
+        throw std::runtime_error(fmt::format("invalid training range {}:{}", trainingRange.Start(), trainingRange.End()));
+    }
+
+    std::vector<Operon::Variable> inputs;
+    if (result.count("inputs") == 0) {
+        auto variables = dataset.Variables();
+        std::copy_if(variables.begin(), variables.end(), std::back_inserter(inputs), [&](auto const& var) { return var.Name != target; });
+    } else {
+        auto str = result["inputs"].as<std::string>();
+        auto tokens = Operon::Split(str, ',');
+
+        for (auto const& tok : tokens) {
+            if (auto res = dataset.GetVariable(tok); res.has_value()) {
+                inputs.push_back(res.value());
+            } else {
+                throw std::runtime_error(fmt::format("variable {} does not exist in the dataset", tok));
+            }
         }
+    }
 
-        Operon::SubtreeCrossover crossover{ crossoverInternalProbability, maxDepth, maxLength };
-        Operon::MultiMutation mutator{};
-
-        Operon::ChangeVariableMutation changeVar { problem.InputVariables() };
-        Operon::ChangeFunctionMutation changeFunc { problem.GetPrimitiveSet() };
-        Operon::ReplaceSubtreeMutation replaceSubtree { *creator, *coeffInitializer, maxDepth, maxLength };
-        Operon::InsertSubtreeMutation insertSubtree { *creator, *coeffInitializer, maxDepth, maxLength };
-        Operon::RemoveSubtreeMutation removeSubtree { problem.GetPrimitiveSet() };
-        Operon::DiscretePointMutation discretePoint;
-        for (auto v : Operon::Math::Constants) {
-            discretePoint.Add(static_cast<Operon::Scalar>(v), 1);
+    auto problem = Operon::Problem(dataset).Inputs(inputs).Target(target).TrainingRange(trainingRange).TestRange(testRange);
+    problem.GetPrimitiveSet().SetConfig(primitiveSetConfig);
+    // the primitives of the plugins are added to the primitive set and registered in the interpreter below
+    std::vector<Operon::Plugin::Primitive> plugins;
+    if (result.count("plugin") != 0) {
+        for (auto const& path : Operon::Split(result["plugin"].as<std::string>(), ',')) {
+            for (auto& p : Operon::Plugin::Load(path)) {
+                Operon::Plugin::Add(problem.GetPrimitiveSet(), p);
+                plugins.push_back(std::move(p));
+            }
         }
-        mutator.Add(*onePoint, 1.0);
-        mutator.Add(changeVar, 1.0);
-        mutator.Add(changeFunc, 1.0);
-        mutator.Add(replaceSubtree, 1.0);
-        mutator.Add(insertSubtree, 1.0);
-        mutator.Add(removeSubtree, 1.0);
-        mutator.Add(discretePoint, 1.0);
+    }
 
-        auto const& [error, scale] = Operon::ParseErrorMetric(result["error-metric"].as<std::string>());
+    std::unique_ptr<Operon::CreatorBase> creator;
+    creator = ParseCreator(result["tree-creator"].as<std::string>(), problem.GetPrimitiveSet(), problem.InputVariables());
+
+    auto [amin, amax] = problem.GetPrimitiveSet().FunctionArityLimits();
+    Operon::UniformTreeInitializer treeInitializer(*creator);
+    treeInitializer.ParameterizeDistribution(amin+1, maxLength);
+    treeInitializer.SetMinDepth(1);
+    treeInitializer.SetMaxDepth(1000); // NOLINT
+                                       //
+    std::unique_ptr<Operon::CoefficientInitializerBase> coeffInitializer;
+    std::unique_ptr<Operon::MutatorBase> onePoint;
+    if (symbolic) {
+        using Dist = std::uniform_int_distribution<int>;
+        coeffInitializer = std::make_unique<Operon::CoefficientInitializer<Dist>>();
+        int constexpr range{5};
+        dynamic_cast<Operon::CoefficientInitializer<Dist>*>(coeffInitializer.get())->ParameterizeDistribution(-range, +range);
+        onePoint = std::make_unique<Operon::OnePointMutation<Dist>>();
+        dynamic_cast<Operon::OnePointMutation<Dist>*>(onePoint.get())->ParameterizeDistribution(-range, +range);
+    } else {
+        using Dist = std::normal_distribution<Operon::Scalar>;
+        coeffInitializer = std::make_unique<Operon::CoefficientInitializer<Dist>>();
+        dynamic_cast<Operon::NormalCoefficientInitializer*>(coeffInitializer.get())->ParameterizeDistribution(Operon::Scalar{0}, Operon::Scalar{1});
+        onePoint = std::make_unique<Operon::OnePointMutation<Dist>>();
+        dynamic_cast<Operon::OnePointMutation<Dist>*>(onePoint.get())->ParameterizeDistribution(Operon::Scalar{0}, Operon::Scalar{1});
+    }
 
-        Operon::Interpreter interpreter;
-        Operon::Evaluator evaluator(problem, interpreter, *error, scale);
+    Operon::SubtreeCrossover crossover{ crossoverInternalProbability, maxDepth, maxLength };
+    Operon::MultiMutation mutator{};
+
+    Operon::ChangeVariableMutation changeVar { problem.InputVariables() };
+    Operon::ChangeFunctionMutation changeFunc { problem.GetPrimitiveSet() };
+    Operon::ReplaceSubtreeMutation replaceSubtree { *creator, *coeffInitializer, maxDepth, maxLength };
+    Operon::InsertSubtreeMutation insertSubtree { *creator, *coeffInitializer, maxDepth, maxLength };
+    Operon::RemoveSubtreeMutation removeSubtree { problem.GetPrimitiveSet() };
+    Operon::DiscretePointMutation discretePoint;
+    for (auto v : Operon::Math::Constants) {
+        discretePoint.Add(static_cast<Operon::Scalar>(v), 1);
+    }
+    mutator.Add(*onePoint, 1.0);
+    mutator.Add(changeVar, 1.0);
+    mutator.Add(changeFunc, 1.0);
+    mutator.Add(replaceSubtree, 1.0);
+    mutator.Add(insertSubtree, 1.0);
+    mutator.Add(removeSubtree, 1.0);
+    mutator.Add(discretePoint, 1.0);
+
+    auto const& [error, scale] = Operon::ParseErrorMetric(result["error-metric"].as<std::string>());
+
+    Operon::Interpreter interpreter;
+    for (auto const& p : plugins) { Operon::Plugin::Register(interpreter.GetDispatchTable(), p); }
+    interpreter.SetKernel(Operon::ParseKernel(result["interpreter-kernel"].as<std::string>(), primitiveSetConfig));
+    Operon::CoefficientCache coefficientCache;
+    Operon::Evaluator evaluator(problem, interpreter, *error, scale);
+
+    evaluator.SetLocalOptimizationIterations(config.Iterations);
+    evaluator.SetVariableProjection(result["variable-projection"].as<bool>());
+    evaluator.SetNormalEquations(result["normal-equations"].as<bool>());
+    evaluator.SetMiniBatchSize(result["mini-batch"].as<size_t>());
+    evaluator.SetSimplification(result["simplify"].as<bool>());
+    if (result["warm-start"].as<bool>()) {
+        evaluator.SetCoefficientCache(&coefficientCache);
+    }
+    std::unique_ptr<Operon::FingerprintCache> fingerprintCache;
+    if (auto rows = result["fingerprint-rows"].as<size_t>(); rows > 0) {
+        fingerprintCache = std::make_unique<Operon::FingerprintCache>(problem, rows);
+        evaluator.SetFingerprintCache(fingerprintCache.get());
+    }
+    evaluator.SetBudget(config.Evaluations);
+
+    EXPECT(problem.TrainingRange().Size() > 0);
+
+    // optionally evaluate the offspring with the tiled batch evaluator, or on a random subset of the training data
+    // which changes every generation
+    Operon::EvaluatorBase* eval = &evaluator;
+    std::unique_ptr<Operon::BatchEvaluator> batchEvaluator;
+    std::unique_ptr<Operon::SubsampledEvaluator> subsampledEvaluator;
+    if (result["batch-evaluation"].as<bool>()) {
+        batchEvaluator = std::make_unique<Operon::BatchEvaluator>(problem, interpreter, *error, scale);
+        batchEvaluator->SetLocalOptimizationIterations(config.Iterations);
+        batchEvaluator->SetSimplification(result["simplify"].as<bool>());
+        batchEvaluator->SetBudget(config.Evaluations);
+        eval = batchEvaluator.get();
+    } else if (auto fraction = result["subsample"].as<double>(); fraction < 1.0) {
+        subsampledEvaluator = std::make_unique<Operon::SubsampledEvaluator>(problem, evaluator, fraction, Operon::SubsampledEvaluator::DefaultRacingQuantile, config.Seed);
+        subsampledEvaluator->SetBudget(config.Evaluations);
+        eval = subsampledEvaluator.get();
+    }
+
+    // the evaluator which counts the evaluations of the run
+    Operon::EvaluatorBase const& counter = batchEvaluator ? *batchEvaluator : static_cast<Operon::EvaluatorBase const&>(evaluator);
+
+    auto comp = [](auto const& lhs, auto const& rhs) { return lhs[0] < rhs[0]; };
+
+    auto femaleSelector = Operon::ParseSelector(result["female-selector"].as<std::string>(), comp, &evaluator, config.Seed);
+    // the lexicase selectors draw their cases from distinct streams
+    auto maleSelector = Operon::ParseSelector(result["male-selector"].as<std::string>(), comp, &evaluator, Operon::Random::Stream(config.Seed, 0, 1)());
+    // the tournaments compare precomputed keys equivalent to comp
+    femaleSelector->SetKey(Operon::ObjectiveKey(0));
+    maleSelector->SetKey(Operon::ObjectiveKey(0));
+
+    auto generator = Operon::ParseGenerator(result["offspring-generator"].as<std::string>(), *eval, crossover, mutator, *femaleSelector, *maleSelector);
+    // the children which would be discarded anyway are rejected before their evaluation
+    auto& filter = generator->Filter();
+    if (result["reject-oversized"].as<bool>()) {
+        filter.MaxLength(maxLength);
+        filter.MaxDepth(maxDepth);
+    }
+    filter.RejectClones(result["reject-clones"].as<bool>());
+    filter.TarpeianProbability(result["tarpeian"].as<double>());
+    auto reinserter = Operon::ParseReinserter(result["reinserter"].as<std::string>(), comp);
+    reinserter->SetKey(Operon::ObjectiveKey(0));
+
+    Operon::RandomGenerator random(config.Seed);
+    if (result["shuffle"].as<bool>()) {
+        // in place, unless the dataset is a (read-only) memory mapped view: its rows are gathered through an index permutation
+        auto& ds = problem.GetDataset();
+        if (ds.IsView()) {
+            auto shuffled = Operon::IndexedDataset::Shuffled(ds, random).Materialize();
+            ds.Swap(shuffled);
+        } else {
+            ds.Shuffle(random);
+        }
+    }
+    if (result["standardize"].as<bool>()) {
+        problem.StandardizeData(problem.TrainingRange());
+    }
+    if (result["pack-inputs"].as<bool>()) {
+        // the inputs in row tiles of one batch, read by the evaluator instead of the dataset columns
+        problem.PackInputs(Operon::detail::BatchSize<Operon::Scalar>::Value);
+    }
 
-        evaluator.SetLocalOptimizationIterations(config.Iterations);
-        evaluator.SetBudget(config.Evaluations);
+    // the offspring are screened on a single precision sample of the (preprocessed) training rows
+    std::unique_ptr<Operon::ScreeningEvaluator> screening;
+    if (auto fraction = result["screening"].as<double>(); fraction > 0) {
+        screening = std::make_unique<Operon::ScreeningEvaluator>(problem, *error, scale, fraction, result["screening-quantile"].as<double>());
+        generator->SetScreening(screening.get());
+    }
 
-        EXPECT(problem.TrainingRange().Size() > 0);
+    // the surrogate learns from the exact evaluations, its features are computed on a sample of the training rows
+    std::unique_ptr<Operon::SurrogateModel> surrogate;
+    if (result["surrogate"].as<bool>()) {
+        surrogate = std::make_unique<Operon::SurrogateModel>(problem, interpreter, *error, scale);
+        generator->SetSurrogate(surrogate.get());
+    }
 
-        auto comp = [](auto const& lhs, auto const& rhs) { return lhs[0] < rhs[0]; };
+    // the sketches of the outputs are recorded by the evaluator, the diversity is estimated in the report
+    std::unique_ptr<Operon::SemanticSketch> sketch;
+    if (auto dimensions = result["semantic-diversity"].as<size_t>(); dimensions > 0) {
+        sketch = std::make_unique<Operon::SemanticSketch>(problem, interpreter, scale, dimensions, Operon::SemanticSketch::DefaultRows, config.Seed);
+        evaluator.SetSemanticSketch(sketch.get());
+    }
 
-        auto femaleSelector = Operon::ParseSelector(result["female-selector"].as<std::string>(), comp);
-        auto maleSelector = Operon::ParseSelector(result["male-selector"].as<std::string>(), comp);
+    // per numa node copies of the (preprocessed) dataset, read by the workers bound to the node
+    std::unique_ptr<Operon::ReplicatedDataset> replicas;
+    if (result["replicate-dataset"].as<bool>()) {
+        replicas = std::make_unique<Operon::ReplicatedDataset>(problem.GetDataset());
+        evaluator.SetReplicatedDataset(replicas.get());
+    }
 
-        auto generator = Operon::ParseGenerator(result["offspring-generator"].as<std::string>(), evaluator, crossover, mutator, *femaleSelector, *maleSelector);
-        auto reinserter = Operon::ParseReinserter(result["reinserter"].as<std::string>(), comp);
+    // memory accounting (see Operon::Memory), the soft limit makes the caches evict and the buffers shrink
+    Operon::Memory::Account datasetMemory(Operon::Memory::Subsystem::Dataset, Operon::Memory::Footprint(problem.GetDataset()));
+    Operon::Memory::SetSoftLimit(result["memory-limit"].as<size_t>() << 20U);
+    bool memoryWarning{false};
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+
+    // some boilerplate for reporting results
+    const size_t idx { 0 };
+    auto getBest = [&](Operon::Span<Operon::Individual const> pop) -> Operon::Individual {
+        const auto *minElem = std::min_element(pop.begin(), pop.end(), [&](auto const& lhs, auto const& rhs) { return lhs[idx] < rhs[idx]; });
+        return *minElem;
+    };
+
+    // the statistics of every generation are computed on a separate executor, the report runs inside the taskflow
+    std::optional<tf::Executor> exe;
+    if (out != nullptr) { exe.emplace(executor.num_workers()); }
+    Operon::ModelReport modelReport(problem, interpreter);
+
+    // structured metrics of every generation, written by a background thread
+    std::unique_ptr<Operon::MetricsSink> metrics;
+    if (result.count("metrics") != 0 || result.count("metrics-prometheus") != 0) {
+        Operon::MetricsConfig metricsConfig;
+        if (result.count("metrics") != 0) { metricsConfig.JsonLines = result["metrics"].as<std::string>(); }
+        if (result.count("metrics-prometheus") != 0) { metricsConfig.Prometheus = result["metrics-prometheus"].as<std::string>(); }
+        metrics = std::make_unique<Operon::MetricsSink>(metricsConfig);
+    }
 
-        Operon::RandomGenerator random(config.Seed);
-        if (result["shuffle"].as<bool>()) {
-            problem.GetDataset().Shuffle(random);
-        }
-        if (result["standardize"].as<bool>()) {
-            problem.StandardizeData(problem.TrainingRange());
+    // the parents of every generation, each frame delta encoded against the previous one (see Serialization::DeltaEncoder)
+    std::unique_ptr<Operon::Serialization::DeltaEncoder> populationLog;
+    std::ofstream populationLogFile;
+    if (result.count("population-log") != 0) {
+        auto const path = result["population-log"].as<std::string>();
+        populationLogFile.open(path, std::ios::binary | std::ios::trunc);
+        if (!populationLogFile) { throw std::runtime_error(fmt::format("{}: cannot open the population log\n", path)); }
+        auto const precision = Operon::ParsePrecision(result["population-log-precision"].as<std::string>());
+        populationLog = std::make_unique<Operon::Serialization::DeltaEncoder>(Operon::Serialization::CompactCodec(problem.GetDataset(), precision));
+    }
+
+    // the lines of the generations whose model statistics are still computed by the report worker, oldest first
+    std::deque<std::pair<std::future<Operon::ModelStatistics>, std::function<void(Operon::ModelStatistics const&)>>> pending;
+    // prints the lines of the finished reports in order, waiting for the remaining ones if asked to
+    auto flush = [&](bool wait) {
+        while (!pending.empty()) {
+            auto& [statistics, print] = pending.front();
+            if (!wait && statistics.wait_for(std::chrono::seconds(0)) != std::future_status::ready) { break; }
+            print(statistics.get());
+            pending.pop_front();
         }
+    };
 
-        tf::Executor executor(threads);
+    // the report works with both the generational and the asynchronous algorithm
+    auto report = [&](auto const& gp) {
+        auto const& pop = gp.Parents();
+        auto const& off = gp.Offspring();
 
-        auto t0 = std::chrono::high_resolution_clock::now();
+        auto const best = getBest(pop);
 
-        Operon::GeneticProgrammingAlgorithm gp { problem, config, treeInitializer, *coeffInitializer, *generator, *reinserter };
+        // the statistics of the best model are computed by the report worker meanwhile, the line of the generation is
+        // printed once they are ready (by a later report at the latest after the run) so the main loop never waits on them
+        auto statistics = modelReport.Submit(best.Genotype);
 
-        auto targetValues = problem.TargetValues();
-        auto targetTrain = targetValues.subspan(trainingRange.Start(), trainingRange.Size());
-        auto targetTest = targetValues.subspan(testRange.Start(), testRange.Size());
+        tf::Taskflow taskflow;
 
-        // some boilerplate for reporting results
-        const size_t idx { 0 };
-        auto getBest = [&](Operon::Span<Operon::Individual const> pop) -> Operon::Individual {
-            const auto *minElem = std::min_element(pop.begin(), pop.end(), [&](auto const& lhs, auto const& rhs) { return lhs[idx] < rhs[idx]; });
-            return *minElem;
-        };
+        double avgLength = 0;
+        double avgQuality = 0;
+        double totalMemory = 0;
 
-        Operon::Individual best(1);
-        auto getSize = [](Operon::Individual const& ind) { return sizeof(ind) + sizeof(ind.Genotype) + sizeof(Operon::Node) * ind.Genotype.Nodes().capacity(); };
+        auto calculateLength = taskflow.transform_reduce(pop.begin(), pop.end(), avgLength, std::plus<double>{}, [](auto const& ind) { return ind.Genotype.Length(); });
+        auto calculateQuality = taskflow.transform_reduce(pop.begin(), pop.end(), avgQuality, std::plus<double>{}, [idx=idx](auto const& ind) { return ind[idx]; });
+        auto calculatePopMemory = taskflow.transform_reduce(pop.begin(), pop.end(), totalMemory, std::plus{}, [](auto const& ind) { return Operon::Memory::Footprint(ind); });
+        auto calculateOffMemory = taskflow.transform_reduce(off.begin(), off.end(), totalMemory, std::plus{}, [](auto const& ind) { return Operon::Memory::Footprint(ind); });
+        if (sketch) { taskflow.emplace([&](tf::Subflow& subflow) { sketch->Prepare(subflow, pop); }).name("semantic diversity"); }
 
-        tf::Executor exe(threads);
+        exe->run(taskflow).wait();
 
-        auto report = [&]() {
-            auto const& pop = gp.Parents();
-            auto const& off = gp.Offspring();
+        avgLength /= static_cast<double>(pop.size());
+        avgQuality /= static_cast<double>(pop.size());
 
-            best = getBest(pop);
+        auto t1 = std::chrono::high_resolution_clock::now();
+        auto elapsed = static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count()) / 1e6;
 
-            Operon::Vector<Operon::Scalar> estimatedTrain;
-            Operon::Vector<Operon::Scalar> estimatedTest;
+        if (!memoryWarning && Operon::Memory::OverLimit()) {
+            memoryWarning = true;
+            fmt::print(stderr, "warning: the accounted memory ({}) exceeds the soft limit\n", Operon::FormatBytes(Operon::Memory::Total()));
+        }
+        if (populationLog) {
+            auto const frame = populationLog->Encode(pop);
+            populationLogFile.write(reinterpret_cast<char const*>(frame.data()), static_cast<std::streamsize>(frame.size())); // NOLINT
+        }
 
-            tf::Taskflow taskflow;
+        // the counters of the generation, read now
+        using T = std::tuple<std::string, double, std::string>;
+        auto const* format = ":>#8.3g";
+        std::array counters {
+            T{ "avg_fit", avgQuality, format },
+            T{ "avg_len", avgLength, format },
+            T{ "eval_cnt", counter.EvaluationCount() , ":>" },
+            T{ "res_eval", counter.ResidualEvaluations(), ":>" },
+            T{ "jac_eval", counter.JacobianEvaluations(), ":>" },
+            T{ "seed", config.Seed, ":>" },
+            T{ "elapsed", elapsed, ":>"},
+        };
+        std::vector<std::pair<std::string, double>> extra;
+        extra.emplace_back("memory_bytes", totalMemory);
+        extra.emplace_back("filtered", generator->Filter().TotalStatistics().Rejected());
+        if (screening) { extra.emplace_back("screened_out", screening->Screened() - screening->Promoted()); }
+        if (sketch) { extra.emplace_back("semantic_diversity", sketch->Diversity()); }
+        if (surrogate) {
+            extra.emplace_back("surrogate_eval", eval->SurrogateEvaluations());
+            extra.emplace_back("surrogate_discarded", surrogate->Discarded());
+        }
+        auto const generation = gp.Generation();
+        auto const totalEvaluations = counter.TotalEvaluations();
+
+        auto print = [&, format, generation, elapsed, totalEvaluations, counters, extra = std::move(extra)](Operon::ModelStatistics const& model) {
+            std::vector stats {
+                T{ "iteration", generation, ":>" },
+                T{ "r2_tr", model.R2Train, format },
+                T{ "r2_te", model.R2Test, format },
+                T{ "mae_tr", model.MaeTrain, format },
+                T{ "mae_te", model.MaeTest, format },
+                T{ "nmse_tr", model.NmseTrain, format },
+                T{ "nmse_te", model.NmseTest, format },
+            };
+            stats.insert(stats.end(), counters.begin(), counters.end());
+            Operon::PrintStats(stats, generation == 0, out);
+
+            if (metrics) {
+                Operon::MetricsSample sample{ generation, elapsed, totalEvaluations, {} };
+                for (auto const& s : stats) { sample.Values.emplace_back(std::get<0>(s), std::get<1>(s)); }
+                sample.Values.insert(sample.Values.end(), extra.begin(), extra.end());
+                metrics->Push(std::move(sample));
+            }
+        };
+        pending.emplace_back(std::move(statistics), std::move(print));
+        flush(/*wait=*/false);
+    };
+
+    // the statistics of the best model at the end of the run
+    Fit fit;
+    auto summarize = [&](auto const& gp) {
+        auto last = getBest(gp.Parents());
+        auto const model = modelReport(last.Genotype);
+        fit.Summary = {
+            { "seed", static_cast<double>(config.Seed) },
+            { "iteration", static_cast<double>(gp.Generation()) },
+            { "r2_tr", model.R2Train },
+            { "r2_te", model.R2Test },
+            { "mae_tr", model.MaeTrain },
+            { "mae_te", model.MaeTest },
+            { "nmse_tr", model.NmseTrain },
+            { "nmse_te", model.NmseTest },
+            { "length", static_cast<double>(last.Genotype.Length()) },
+            { "eval_cnt", static_cast<double>(counter.EvaluationCount()) },
+            { "filtered", static_cast<double>(generator->Filter().TotalStatistics().Rejected()) },
+        };
+        AddScaling(last.Genotype, model);
+        fit.Model = std::move(last.Genotype);
+    };
+
+    if (result["async"].as<bool>()) {
+        Operon::AsyncGeneticProgrammingAlgorithm gp { problem, config, treeInitializer, *coeffInitializer, *generator };
+        gp.Run(executor, random, [&]() { if (out != nullptr) { report(gp); } });
+        flush(/*wait=*/true);
+        summarize(gp);
+    } else {
+        Operon::GeneticProgrammingAlgorithm gp { problem, config, treeInitializer, *coeffInitializer, *generator, *reinserter };
+        gp.SetPipelined(result["pipelined"].as<bool>());
+        gp.SetCostAwareScheduling(result["cost-aware-scheduling"].as<bool>());
+        std::unique_ptr<Operon::FitnessStagnation> stagnation;
+        if (auto window = result["stagnation-window"].as<size_t>(); window > 0) {
+            stagnation = std::make_unique<Operon::FitnessStagnation>(window, result["stagnation-threshold"].as<double>());
+            gp.SetTermination(stagnation.get());
+        }
+        if (result.count("resume") != 0) {
+            auto buffer = Operon::Checkpoint::Load(result["resume"].as<std::string>());
+            gp.RestoreState({ buffer.data(), buffer.size() }, random);
+        }
 
-            auto evalTrain = taskflow.emplace([&]() {
-                estimatedTrain = interpreter.Evaluate<Operon::Scalar>(best.Genotype, problem.GetDataset(), trainingRange);
-            });
+        // the checkpoints are taken in the report, which must not overlap with the next generation
+        auto const checkpoint = result.count("checkpoint") != 0 ? result["checkpoint"].as<std::string>() : std::string{};
+        auto const interval = std::max(size_t{1}, result["checkpoint-interval"].as<size_t>());
+        if (!checkpoint.empty() && gp.Pipelined()) {
+            throw std::runtime_error("--checkpoint cannot be combined with --pipelined");
+        }
+        Operon::CheckpointWriter writer;
+        gp.Run(executor, random, [&]() {
+            if (out != nullptr) { report(gp); }
+            if (!checkpoint.empty() && gp.Generation() % interval == 0) {
+                writer.Write(gp.SaveState(random), checkpoint);
+            }
+        });
+        writer.Wait();
+        flush(/*wait=*/true);
+        summarize(gp);
+    }
+    if (out != nullptr) {
+        fmt::print(out, "{}\n", Operon::InfixFormatter::Format(Operon::RestoreInputs(fit.Model, problem.GetDataset()), problem.GetDataset(), 6));
+    }
+    return fit;
+}
+} // namespace
 
-            auto evalTest = taskflow.emplace([&]() {
-                estimatedTest = interpreter.Evaluate<Operon::Scalar>(best.Genotype, problem.GetDataset(), testRange);
-            });
+auto main(int argc, char** argv) -> int
+{
+    auto opts = Operon::InitOptions("operon_gp", "Genetic programming symbolic regression");
+    auto result = Operon::ParseOptions(std::move(opts), argc, argv);
 
-            // scale values
-            Operon::Scalar a{};
-            Operon::Scalar b{};
-            auto linearScaling = taskflow.emplace([&]() {
-                auto [a_, b_] = Operon::FitLeastSquares(estimatedTrain, targetTrain);
-                a = static_cast<Operon::Scalar>(a_);
-                b = static_cast<Operon::Scalar>(b_);
-                // add scaling terms to the tree
-                auto& nodes = best.Genotype.Nodes();
-                auto const sz = nodes.size();
-                if (std::abs(a - Operon::Scalar{1}) > std::numeric_limits<Operon::Scalar>::epsilon()) {
-                    nodes.emplace_back(Operon::Node::Constant(a));
-                    nodes.emplace_back(Operon::Node(Operon::NodeType::Mul));
-                }
-                if (std::abs(b) > std::numeric_limits<Operon::Scalar>::epsilon()) {
-                    nodes.emplace_back(Operon::Node::Constant(b));
-                    nodes.emplace_back(Operon::Node(Operon::NodeType::Add));
-                }
-                if (nodes.size() > sz) {
-                    best.Genotype.UpdateNodes();
-                }
-            });
+    std::unique_ptr<Operon::Dataset> dataset;
+    std::string datasetPath;
+    bool showPrimitiveSet = false;
+    auto threads = std::thread::hardware_concurrency();
+    Operon::NodeType primitiveSetConfig = Operon::PrimitiveSet::Arithmetic;
 
-            double r2Train{};
-            double r2Test{};
-            double nmseTrain{};
-            double nmseTest{};
-            double maeTrain{};
-            double maeTest{};
+    try {
+        // the policy applies to the allocations made after it is set, so before the dataset is read
+        Operon::Memory::SetAllocationPolicy({ Operon::Memory::ParsePagePolicy(result["huge-pages"].as<std::string>()) });
 
-            auto scaleTrain = taskflow.emplace([&]() {
-                Eigen::Map<Eigen::Array<Operon::Scalar, -1, 1>> estimated(estimatedTrain.data(), estimatedTrain.size());
-                estimated = estimated * a + b;
-            });
+        for (const auto& kv : result.arguments()) {
+            const auto& key = kv.key();
+            const auto& value = kv.value();
 
-            auto scaleTest = taskflow.emplace([&]() {
-                Eigen::Map<Eigen::Array<Operon::Scalar, -1, 1>> estimated(estimatedTest.data(), estimatedTest.size());
-                estimated = estimated * a + b;
-            });
+            if (key == "dataset") {
+                datasetPath = value;
+            }
+            if (key == "enable-symbols") {
+                auto mask = Operon::ParsePrimitiveSetConfig(value);
+                primitiveSetConfig |= mask;
+            }
+            if (key == "disable-symbols") {
+                auto mask = ~Operon::ParsePrimitiveSetConfig(value);
+                primitiveSetConfig &= mask;
+            }
+            if (key == "threads") {
+                threads = static_cast<decltype(threads)>(kv.as<size_t>());
+            }
+            if (key == "show-primitives") {
+                showPrimitiveSet = true;
+            }
+        }
 
-            auto calcStats = taskflow.emplace([&]() {
-                // negate the R2 because this is an internal fitness measure (minimization) which we here repurpose
-                r2Train = -Operon::R2{}(estimatedTrain, targetTrain);
-                r2Test = -Operon::R2{}(estimatedTest, targetTest);
+        if (showPrimitiveSet) {
+            Operon::PrintPrimitives(primitiveSetConfig);
+            return EXIT_SUCCESS;
+        }
 
-                nmseTrain = Operon::NMSE{}(estimatedTrain, targetTrain);
-                nmseTest = Operon::NMSE{}(estimatedTest, targetTest);
+        if (result.count("serve") == 0) { // the service reads its datasets on demand
+            dataset = std::make_unique<Operon::Dataset>(datasetPath, true);
+        }
+
+        tf::Executor executor(threads);
+        if (!Operon::Affinity::Pin(executor, Operon::Affinity::ParsePolicy(result["affinity"].as<std::string>()))) {
+            fmt::print(stderr, "warning: the worker threads could not be bound\n");
+        }
+        auto const profileCounters = result["profile-counters"].as<bool>();
+        auto const profile = result["profile"].as<bool>() || profileCounters;
+        auto const profilePrimitives = result["profile-primitives"].as<bool>();
+        if ((profile || profilePrimitives) && !Operon::Instrumentation::Available()) {
+            fmt::print(stderr, "warning: the timings are not recorded by this build (see USE_INSTRUMENTATION)\n");
+        }
+        Operon::Instrumentation::SetEnabled(profile);
+        Operon::Instrumentation::SetPrimitiveProfiling(profilePrimitives);
+        if (profileCounters && !Operon::Instrumentation::SetHardwareCounting(true)) {
+            fmt::print(stderr, "warning: the hardware events cannot be counted (see kernel.perf_event_paranoid)\n");
+        }
+
+        // the tasks run by the workers, written as a chrome trace at the end of the run
+        std::shared_ptr<Operon::TraceObserver> trace;
+        if (result.count("trace") != 0) { trace = executor.make_observer<Operon::TraceObserver>(); }
 
-                maeTrain = Operon::MAE{}(estimatedTrain, targetTrain);
-                maeTest = Operon::MAE{}(estimatedTest, targetTest);
+        if (result.count("serve") != 0) {
+#if !defined(_WIN32)
+            Operon::Service service(executor, [&executor](std::vector<std::string> const& arguments, Operon::Service& service, std::FILE* out) {
+                auto request = Operon::ParseArguments(Operon::InitOptions("operon_gp", "Genetic programming symbolic regression"), arguments);
+                auto const dataset = service.GetDataset(request["dataset"].as<std::string>());
+                return RunConfiguration(request, dataset->View(), executor, out).Model;
             });
+            service.GetDataset(datasetPath); // resident from the start
+            Operon::Serve(service, static_cast<uint16_t>(result["serve"].as<size_t>()), result["serve-connections"].as<size_t>());
+#else
+            throw std::runtime_error("--serve is not supported on this platform");
+#endif
+        } else if (result.count("batch") == 0) {
+            RunConfiguration(result, *dataset, executor, stdout);
+        } else {
+            // every line of the batch file holds the options of a run, added to the command line options (which they
+            // override). the runs share the executor and a view of the dataset read above
+            std::ifstream file(result["batch"].as<std::string>());
+            if (!file) { throw std::runtime_error(fmt::format("cannot open the batch file {}", result["batch"].as<std::string>())); }
+            std::vector<cxxopts::ParseResult> configurations;
+            for (std::string line; std::getline(file, line);) {
+                std::istringstream tokens(line);
+                std::vector<std::string> args(argv, argv + argc); // NOLINT
+                for (std::string tok; tokens >> tok;) { args.push_back(tok); }
+                if (args.size() == static_cast<size_t>(argc) || args[static_cast<size_t>(argc)].front() == '#') { continue; } // empty line or comment
+                configurations.push_back(Operon::ParseArguments(Operon::InitOptions("operon_gp", "Genetic programming symbolic regression"), std::move(args)));
+            }
 
-            double avgLength = 0;
-            double avgQuality = 0;
-            double totalMemory = 0;
-
-            auto calculateLength = taskflow.transform_reduce(pop.begin(), pop.end(), avgLength, std::plus<double>{}, [](auto const& ind) { return ind.Genotype.Length(); });
-            auto calculateQuality = taskflow.transform_reduce(pop.begin(), pop.end(), avgQuality, std::plus<double>{}, [idx=idx](auto const& ind) { return ind[idx]; });
-            auto calculatePopMemory = taskflow.transform_reduce(pop.begin(), pop.end(), totalMemory, std::plus{}, [&](auto const& ind) { return getSize(ind); });
-            auto calculateOffMemory = taskflow.transform_reduce(off.begin(), off.end(), totalMemory, std::plus{}, [&](auto const& ind) { return getSize(ind); });
-
-            // define task graph
-            linearScaling.succeed(evalTrain, evalTest);
-            linearScaling.precede(scaleTrain, scaleTest);
-            calcStats.succeed(scaleTrain, scaleTest);
-            calcStats.precede(calculateLength, calculateQuality, calculatePopMemory, calculateOffMemory);
-
-            exe.run(taskflow).wait();
-
-            avgLength /= static_cast<double>(pop.size());
-            avgQuality /= static_cast<double>(pop.size());
-
-            auto t1 = std::chrono::high_resolution_clock::now();
-            auto elapsed = static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count()) / 1e6;
-
-            using T = std::tuple<std::string, double, std::string>;
-            auto const* format = ":>#8.3g";
-            std::array stats {
-                T{ "iteration", gp.Generation(), ":>" },
-                T{ "r2_tr", r2Train, format },
-                T{ "r2_te", r2Test, format },
-                T{ "mae_tr", maeTrain, format },
-                T{ "mae_te", maeTest, format },
-                T{ "nmse_tr", nmseTrain, format },
-                T{ "nmse_te", nmseTest, format },
-                T{ "avg_fit", avgQuality, format },
-                T{ "avg_len", avgLength, format },
-                T{ "eval_cnt", evaluator.EvaluationCount() , ":>" },
-                T{ "res_eval", evaluator.ResidualEvaluations(), ":>" },
-                T{ "jac_eval", evaluator.JacobianEvaluations(), ":>" },
-                T{ "seed", config.Seed, ":>" },
-                T{ "elapsed", elapsed, ":>"},
-            };
-            Operon::PrintStats({ stats.begin(), stats.end() }, gp.Generation() == 0);
-        };
+            auto const view = dataset->View();
+            Operon::BatchRunner batch(result["batch-concurrency"].as<size_t>());
+            for (auto const& configuration : configurations) {
+                batch.Add([&](tf::Executor& ex) { return RunConfiguration(configuration, view, ex, nullptr).Summary; });
+            }
 
-        gp.Run(executor, random, report);
-        fmt::print("{}\n", Operon::InfixFormatter::Format(best.Genotype, problem.GetDataset(), 6));
+            // one line per run as the runs finish, then the mean over the successful runs
+            auto stats = [](Operon::BatchRunner::Summary const& values, double elapsed) {
+                std::vector<std::tuple<std::string, double, std::string>> row;
+                for (auto const& [name, value] : values) { row.emplace_back(name, value, ":>#8.3g"); }
+                row.emplace_back("elapsed", elapsed, ":>");
+                return row;
+            };
+            std::mutex lock;
+            bool header{true};
+            auto results = batch.Run(executor, [&](auto const& r) {
+                std::lock_guard<std::mutex> guard(lock);
+                if (!r.Succeeded()) {
+                    fmt::print(stderr, "error: run {}: {}\n", r.Index, r.Error);
+                    return;
+                }
+                auto row = stats(r.Values, r.Elapsed);
+                row.insert(row.begin(), std::tuple<std::string, double, std::string>{ "run", static_cast<double>(r.Index), ":>" });
+                Operon::PrintStats(row, header);
+                header = false;
+            });
+            auto const succeeded = std::count_if(results.begin(), results.end(), [](auto const& r) { return r.Succeeded(); });
+            if (succeeded > 0) {
+                double elapsed{0};
+                for (auto const& r : results) { elapsed += r.Succeeded() ? r.Elapsed : 0; }
+                fmt::print("mean of {} runs\n", succeeded);
+                Operon::PrintStats(stats(Operon::BatchRunner::Mean(results), elapsed / static_cast<double>(succeeded)));
+            }
+            if (std::any_of(results.begin(), results.end(), [](auto const& r) { return !r.Succeeded(); })) {
+                return EXIT_FAILURE;
+            }
+        }
+        if (profile) { Operon::PrintProfile(); }
+        if (profilePrimitives) { Operon::PrintPrimitiveProfile(); }
+        if (trace) { trace->Dump(result["trace"].as<std::string>()); }
     } catch (std::exception& e) {
         fmt::print(stderr, "error: {}\n", e.what());
         return EXIT_FAILURE;
@@ -377,4 +706,3 @@ auto main(int argc, char** argv) -> int
 
     return 0;
 }
-
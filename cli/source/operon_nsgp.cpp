@@ -7,17 +7,32 @@
 
 #include <fmt/core.h>
 
+#include <fstream>
 #include <memory>
 #include <thread>
 #include <taskflow/taskflow.hpp>
 #if TF_MINOR_VERSION > 2
 #include <taskflow/algorithm/reduce.hpp>
 #endif
+#include "operon/algorithms/checkpoint.hpp"
+#include "operon/algorithms/model_report.hpp"
 #include "operon/algorithms/nsga2.hpp"
+#include "operon/algorithms/termination.hpp"
+#include "operon/core/affinity.hpp"
+#include "operon/core/allocation.hpp"
 #include "operon/core/format.hpp"
+#include "operon/core/instrumentation.hpp"
+#include "operon/core/indexed_dataset.hpp"
+#include "operon/core/memory.hpp"
+#include "operon/core/metrics.hpp"
+#include "operon/core/model_archive.hpp"
+#include "operon/core/pareto_archive.hpp"
 #include "operon/core/version.hpp"
 #include "operon/core/problem.hpp"
+#include "operon/core/serialization.hpp"
+#include "operon/core/trace.hpp"
 #include "operon/interpreter/interpreter.hpp"
+#include "operon/interpreter/plugin.hpp"
 #include "operon/operators/creator.hpp"
 #include "operon/operators/crossover.hpp"
 #include "operon/operators/evaluator.hpp"
@@ -27,6 +42,7 @@
 #include "operon/operators/non_dominated_sorter.hpp"
 #include "operon/operators/reinserter.hpp"
 #include "operon/operators/selector.hpp"
+#include "operon/operators/semantic_sketch.hpp"
 
 #include "util.hpp"
 #include "operator_factory.hpp"
@@ -65,13 +81,15 @@ auto main(int argc, char** argv) -> int
     auto symbolic = result["symbolic"].as<bool>();
 
     try {
+        // the policy applies to the allocations made after it is set, so before the dataset is read
+        Operon::Memory::SetAllocationPolicy({ Operon::Memory::ParsePagePolicy(result["huge-pages"].as<std::string>()) });
+
         for (const auto& kv : result.arguments()) {
             const auto& key = kv.key();
             const auto& value = kv.value();
 
             if (key == "dataset") {
                 dataset = std::make_unique<Operon::Dataset>(value, true);
-                ENSURE(!dataset->IsView());
             }
             if (key == "seed") {
                 config.Seed = kv.as<size_t>();
@@ -159,6 +177,16 @@ auto main(int argc, char** argv) -> int
 
         auto problem = Operon::Problem(*dataset).Inputs(inputs).Target(target).TrainingRange(trainingRange).TestRange(testRange);
         problem.GetPrimitiveSet().SetConfig(primitiveSetConfig);
+        // the primitives of the plugins are added to the primitive set and registered in the interpreter below
+        std::vector<Operon::Plugin::Primitive> plugins;
+        if (result.count("plugin") != 0) {
+            for (auto const& path : Operon::Split(result["plugin"].as<std::string>(), ',')) {
+                for (auto& p : Operon::Plugin::Load(path)) {
+                    Operon::Plugin::Add(problem.GetPrimitiveSet(), p);
+                    plugins.push_back(std::move(p));
+                }
+            }
+        }
 
         std::unique_ptr<Operon::CreatorBase> creator;
         creator = ParseCreator(result["tree-creator"].as<std::string>(), problem.GetPrimitiveSet(), problem.InputVariables());
@@ -206,45 +234,172 @@ auto main(int argc, char** argv) -> int
         mutator.Add(removeSubtree, 1.0);
         mutator.Add(discretePoint, 1.0);
 
-        auto const& [error, scale] = Operon::ParseErrorMetric(result["error-metric"].as<std::string>());
+        // a comma-separated list of error metrics becomes a set of objectives sharing the same model response
+        std::vector<std::unique_ptr<Operon::ErrorMetric>> errors;
+        std::vector<std::reference_wrapper<Operon::ErrorMetric const>> metrics;
+        bool scale{true};
+        for (auto const& name : Operon::Split(result["error-metric"].as<std::string>(), ',')) {
+            auto [e, s] = Operon::ParseErrorMetric(name);
+            scale = scale && s;
+            metrics.emplace_back(*e);
+            errors.push_back(std::move(e));
+        }
         Operon::Interpreter interpreter;
-        Operon::Evaluator errorEvaluator(problem, interpreter, *error, scale);
-        errorEvaluator.SetLocalOptimizationIterations(config.Iterations);
-        errorEvaluator.SetBudget(config.Evaluations);
+        for (auto const& p : plugins) { Operon::Plugin::Register(interpreter.GetDispatchTable(), p); }
+        interpreter.SetKernel(Operon::ParseKernel(result["interpreter-kernel"].as<std::string>(), primitiveSetConfig));
+        Operon::CoefficientCache coefficientCache;
+        std::unique_ptr<Operon::EvaluatorBase> errorEvaluator;
+        if (metrics.size() == 1) {
+            errorEvaluator = std::make_unique<Operon::Evaluator>(problem, interpreter, metrics.front().get(), scale);
+        } else {
+            errorEvaluator = std::make_unique<Operon::MultiMetricEvaluator>(problem, interpreter, metrics, scale);
+        }
+        errorEvaluator->SetLocalOptimizationIterations(config.Iterations);
+        errorEvaluator->SetVariableProjection(result["variable-projection"].as<bool>());
+        errorEvaluator->SetNormalEquations(result["normal-equations"].as<bool>());
+        errorEvaluator->SetMiniBatchSize(result["mini-batch"].as<size_t>());
+        errorEvaluator->SetSimplification(result["simplify"].as<bool>());
+        if (result["warm-start"].as<bool>()) {
+            errorEvaluator->SetCoefficientCache(&coefficientCache);
+        }
+        std::unique_ptr<Operon::FingerprintCache> fingerprintCache;
+        if (auto rows = result["fingerprint-rows"].as<size_t>(); rows > 0) {
+            fingerprintCache = std::make_unique<Operon::FingerprintCache>(problem, rows);
+            errorEvaluator->SetFingerprintCache(fingerprintCache.get());
+        }
+        errorEvaluator->SetBudget(config.Evaluations);
         Operon::LengthEvaluator lengthEvaluator(problem);
 
         Operon::MultiEvaluator evaluator(problem);
         evaluator.SetBudget(config.Evaluations);
-        evaluator.Add(errorEvaluator);
+        evaluator.Add(*errorEvaluator);
         evaluator.Add(lengthEvaluator);
 
         EXPECT(problem.TrainingRange().Size() > 0);
 
         Operon::CrowdedComparison comp;
 
-        auto femaleSelector = Operon::ParseSelector(result["female-selector"].as<std::string>(), comp);
-        auto maleSelector = Operon::ParseSelector(result["male-selector"].as<std::string>(), comp);
+        auto femaleSelector = Operon::ParseSelector(result["female-selector"].as<std::string>(), comp, dynamic_cast<Operon::Evaluator const*>(errorEvaluator.get()), config.Seed);
+        // the lexicase selectors draw their cases from distinct streams
+        auto maleSelector = Operon::ParseSelector(result["male-selector"].as<std::string>(), comp, dynamic_cast<Operon::Evaluator const*>(errorEvaluator.get()), Operon::Random::Stream(config.Seed, 0, 1)());
+        // the tournaments compare precomputed keys equivalent to comp
+        femaleSelector->SetKey(Operon::CrowdedKey());
+        maleSelector->SetKey(Operon::CrowdedKey());
 
         auto generator = Operon::ParseGenerator(result["offspring-generator"].as<std::string>(), evaluator, crossover, mutator, *femaleSelector, *maleSelector);
+        // the children which would be discarded anyway are rejected before their evaluation
+        auto& filter = generator->Filter();
+        if (result["reject-oversized"].as<bool>()) {
+            filter.MaxLength(maxLength);
+            filter.MaxDepth(maxDepth);
+        }
+        filter.RejectClones(result["reject-clones"].as<bool>());
+        filter.TarpeianProbability(result["tarpeian"].as<double>());
         auto reinserter = Operon::ParseReinserter(result["reinserter"].as<std::string>(), comp);
 
         Operon::RandomGenerator random(config.Seed);
         if (result["shuffle"].as<bool>()) {
-            problem.GetDataset().Shuffle(random);
+            // in place, unless the dataset is a (read-only) memory mapped view: its rows are gathered through an index permutation
+            auto& ds = problem.GetDataset();
+            if (ds.IsView()) {
+                auto shuffled = Operon::IndexedDataset::Shuffled(ds, random).Materialize();
+                ds.Swap(shuffled);
+            } else {
+                ds.Shuffle(random);
+            }
         }
         if (result["standardize"].as<bool>()) {
             problem.StandardizeData(problem.TrainingRange());
         }
+        if (result["pack-inputs"].as<bool>()) {
+            // the inputs in row tiles of one batch, read by the evaluator instead of the dataset columns
+            problem.PackInputs(Operon::detail::BatchSize<Operon::Scalar>::Value);
+        }
 
         tf::Executor executor(threads);
+        if (!Operon::Affinity::Pin(executor, Operon::Affinity::ParsePolicy(result["affinity"].as<std::string>()))) {
+            fmt::print(stderr, "warning: the worker threads could not be bound\n");
+        }
+        auto const profileCounters = result["profile-counters"].as<bool>();
+        auto const profile = result["profile"].as<bool>() || profileCounters;
+        auto const profilePrimitives = result["profile-primitives"].as<bool>();
+        if ((profile || profilePrimitives) && !Operon::Instrumentation::Available()) {
+            fmt::print(stderr, "warning: the timings are not recorded by this build (see USE_INSTRUMENTATION)\n");
+        }
+        Operon::Instrumentation::SetEnabled(profile);
+        Operon::Instrumentation::SetPrimitiveProfiling(profilePrimitives);
+        if (profileCounters && !Operon::Instrumentation::SetHardwareCounting(true)) {
+            fmt::print(stderr, "warning: the hardware events cannot be counted (see kernel.perf_event_paranoid)\n");
+        }
+
+        // the tasks run by the workers, written as a chrome trace at the end of the run
+        std::shared_ptr<Operon::TraceObserver> trace;
+        if (result.count("trace") != 0) { trace = executor.make_observer<Operon::TraceObserver>(); }
+
+        // the offspring are screened on a single precision sample of the (preprocessed) training rows, by the first error metric
+        std::unique_ptr<Operon::ScreeningEvaluator> screening;
+        if (auto fraction = result["screening"].as<double>(); fraction > 0) {
+            screening = std::make_unique<Operon::ScreeningEvaluator>(problem, metrics.front().get(), scale, fraction, result["screening-quantile"].as<double>());
+            generator->SetScreening(screening.get());
+        }
+
+        // the surrogate learns from the exact evaluations, by the first error metric
+        std::unique_ptr<Operon::SurrogateModel> surrogate;
+        if (result["surrogate"].as<bool>()) {
+            surrogate = std::make_unique<Operon::SurrogateModel>(problem, interpreter, metrics.front().get(), scale);
+            generator->SetSurrogate(surrogate.get());
+        }
+
+        // the sketches of the outputs are recorded by the evaluator, the diversity is estimated in the report
+        std::unique_ptr<Operon::SemanticSketch> sketch;
+        if (auto dimensions = result["semantic-diversity"].as<size_t>(); dimensions > 0) {
+            sketch = std::make_unique<Operon::SemanticSketch>(problem, interpreter, scale, dimensions, Operon::SemanticSketch::DefaultRows, config.Seed);
+            errorEvaluator->SetSemanticSketch(sketch.get());
+        }
+
+        // per numa node copies of the (preprocessed) dataset, read by the workers bound to the node
+        std::unique_ptr<Operon::ReplicatedDataset> replicas;
+        if (result["replicate-dataset"].as<bool>()) {
+            replicas = std::make_unique<Operon::ReplicatedDataset>(problem.GetDataset());
+            errorEvaluator->SetReplicatedDataset(replicas.get());
+        }
+
+        // memory accounting (see Operon::Memory), the soft limit makes the caches evict and the buffers shrink
+        Operon::Memory::Account datasetMemory(Operon::Memory::Subsystem::Dataset, Operon::Memory::Footprint(problem.GetDataset()));
+        Operon::Memory::SetSoftLimit(result["memory-limit"].as<size_t>() << 20U);
+        bool memoryWarning{false};
 
         auto t0 = std::chrono::high_resolution_clock::now();
         Operon::RankIntersectSorter sorter;
         Operon::NSGA2 gp { problem, config, treeInitializer, *coeffInitializer, *generator, *reinserter, sorter };
+        gp.SetHypervolume(result["hypervolume"].as<bool>());
+        gp.SetPipelined(result["pipelined"].as<bool>());
+        gp.SetCostAwareScheduling(result["cost-aware-scheduling"].as<bool>());
+        std::unique_ptr<Operon::HypervolumeStagnation> stagnation;
+        if (auto window = result["stagnation-window"].as<size_t>(); window > 0) {
+            stagnation = std::make_unique<Operon::HypervolumeStagnation>(window, result["stagnation-threshold"].as<double>());
+            gp.SetTermination(stagnation.get());
+        }
 
-        auto targetValues = problem.TargetValues();
-        auto targetTrain = targetValues.subspan(trainingRange.Start(), trainingRange.Size());
-        auto targetTest = targetValues.subspan(testRange.Start(), testRange.Size());
+        // the epsilon-non-dominated models of the whole run (the error metrics and the length)
+        std::unique_ptr<Operon::ParetoArchive> archive;
+        if (result.count("pareto-archive") != 0) {
+            std::vector<Operon::Scalar> epsilon;
+            for (auto const& v : Operon::Split(result["archive-epsilon"].as<std::string>(), ',')) {
+                epsilon.push_back(static_cast<Operon::Scalar>(std::stod(v)));
+            }
+            auto const objectives = metrics.size() + 1;
+            if (epsilon.size() == 1) { epsilon.resize(objectives, epsilon.front()); }
+            if (epsilon.size() != objectives) {
+                throw std::runtime_error(fmt::format("--archive-epsilon expects one value or {} values", objectives));
+            }
+            archive = std::make_unique<Operon::ParetoArchive>(epsilon);
+            gp.SetArchive(archive.get());
+        }
+        if (result.count("resume") != 0) {
+            auto buffer = Operon::Checkpoint::Load(result["resume"].as<std::string>());
+            gp.RestoreState({ buffer.data(), buffer.size() }, random);
+        }
 
         // some boilerplate for reporting results
         const size_t idx { 0 };
@@ -256,9 +411,29 @@ auto main(int argc, char** argv) -> int
         Operon::Individual best(1);
         //auto const& pop = gp.Parents();
 
-        auto getSize = [](Operon::Individual const& ind) { return sizeof(ind) + sizeof(ind.Genotype) + sizeof(Operon::Node) * ind.Genotype.Nodes().capacity(); };
 
         tf::Executor exe(threads);
+        Operon::ModelReport modelReport(problem, interpreter);
+
+        // structured metrics of every generation, written by a background thread
+        std::unique_ptr<Operon::MetricsSink> metricsSink;
+        if (result.count("metrics") != 0 || result.count("metrics-prometheus") != 0) {
+            Operon::MetricsConfig metricsConfig;
+            if (result.count("metrics") != 0) { metricsConfig.JsonLines = result["metrics"].as<std::string>(); }
+            if (result.count("metrics-prometheus") != 0) { metricsConfig.Prometheus = result["metrics-prometheus"].as<std::string>(); }
+            metricsSink = std::make_unique<Operon::MetricsSink>(metricsConfig);
+        }
+
+        // the parents of every generation, each frame delta encoded against the previous one (see Serialization::DeltaEncoder)
+        std::unique_ptr<Operon::Serialization::DeltaEncoder> populationLog;
+        std::ofstream populationLogFile;
+        if (result.count("population-log") != 0) {
+            auto const path = result["population-log"].as<std::string>();
+            populationLogFile.open(path, std::ios::binary | std::ios::trunc);
+            if (!populationLogFile) { throw std::runtime_error(fmt::format("{}: cannot open the population log\n", path)); }
+            auto const precision = Operon::ParsePrecision(result["population-log-precision"].as<std::string>());
+            populationLog = std::make_unique<Operon::Serialization::DeltaEncoder>(Operon::Serialization::CompactCodec(problem.GetDataset(), precision));
+        }
 
         auto report = [&]() {
             auto const& pop = gp.Parents();
@@ -266,88 +441,41 @@ auto main(int argc, char** argv) -> int
 
             best = getBest(pop);
 
-            Operon::Vector<Operon::Scalar> estimatedTrain;
-            Operon::Vector<Operon::Scalar> estimatedTest;
+            // the statistics of the best model are computed by the report worker meanwhile
+            auto statistics = modelReport.Submit(best.Genotype);
 
             tf::Taskflow taskflow;
 
-            auto evalTrain = taskflow.emplace([&]() {
-                estimatedTrain = interpreter.Evaluate<Operon::Scalar>(best.Genotype, problem.GetDataset(), trainingRange);
-            });
-
-            auto evalTest = taskflow.emplace([&]() {
-                estimatedTest = interpreter.Evaluate<Operon::Scalar>(best.Genotype, problem.GetDataset(), testRange);
-            });
-
-            // scale values
-            Operon::Scalar a{};
-            Operon::Scalar b{};
-            auto linearScaling = taskflow.emplace([&]() {
-                auto [a_, b_] = Operon::FitLeastSquares(estimatedTrain, targetTrain);
-                a = static_cast<Operon::Scalar>(a_);
-                b = static_cast<Operon::Scalar>(b_);
-                // add scaling terms to the tree
-                auto& nodes = best.Genotype.Nodes();
-                auto const sz = nodes.size();
-                if (std::abs(a - Operon::Scalar{1}) > std::numeric_limits<Operon::Scalar>::epsilon()) {
-                    nodes.emplace_back(Operon::Node::Constant(a));
-                    nodes.emplace_back(Operon::Node(Operon::NodeType::Mul));
-                }
-                if (std::abs(b) > std::numeric_limits<Operon::Scalar>::epsilon()) {
-                    nodes.emplace_back(Operon::Node::Constant(b));
-                    nodes.emplace_back(Operon::Node(Operon::NodeType::Add));
-                }
-                if (nodes.size() > sz) {
-                    best.Genotype.UpdateNodes();
-                }
-            });
-
-            double r2Train{};
-            double r2Test{};
-            double nmseTrain{};
-            double nmseTest{};
-            double maeTrain{};
-            double maeTest{};
-
-            auto scaleTrain = taskflow.emplace([&]() {
-                Eigen::Map<Eigen::Array<Operon::Scalar, -1, 1>> estimated(estimatedTrain.data(), estimatedTrain.size());
-                estimated = estimated * a + b;
-            });
-
-            auto scaleTest = taskflow.emplace([&]() {
-                Eigen::Map<Eigen::Array<Operon::Scalar, -1, 1>> estimated(estimatedTest.data(), estimatedTest.size());
-                estimated = estimated * a + b;
-            });
-
-            auto calcStats = taskflow.emplace([&]() {
-                // negate the R2 because this is an internal fitness measure (minimization) which we here repurpose
-                r2Train = -Operon::R2{}(estimatedTrain, targetTrain);
-                r2Test = -Operon::R2{}(estimatedTest, targetTest);
-
-                nmseTrain = Operon::NMSE{}(estimatedTrain, targetTrain);
-                nmseTest = Operon::NMSE{}(estimatedTest, targetTest);
-
-                maeTrain = Operon::MAE{}(estimatedTrain, targetTrain);
-                maeTest = Operon::MAE{}(estimatedTest, targetTest);
-            });
-
             double avgLength = 0;
             double avgQuality = 0;
             double totalMemory = 0;
 
             auto calculateLength = taskflow.transform_reduce(pop.begin(), pop.end(), avgLength, std::plus<double>{}, [](auto const& ind) { return ind.Genotype.Length(); });
             auto calculateQuality = taskflow.transform_reduce(pop.begin(), pop.end(), avgQuality, std::plus<double>{}, [idx=idx](auto const& ind) { return ind[idx]; });
-            auto calculatePopMemory = taskflow.transform_reduce(pop.begin(), pop.end(), totalMemory, std::plus{}, [&](auto const& ind) { return getSize(ind); });
-            auto calculateOffMemory = taskflow.transform_reduce(off.begin(), off.end(), totalMemory, std::plus{}, [&](auto const& ind) { return getSize(ind); });
-
-            // define task graph
-            linearScaling.succeed(evalTrain, evalTest);
-            linearScaling.precede(scaleTrain, scaleTest);
-            calcStats.succeed(scaleTrain, scaleTest);
-            calcStats.precede(calculateLength, calculateQuality, calculatePopMemory, calculateOffMemory);
+            auto calculatePopMemory = taskflow.transform_reduce(pop.begin(), pop.end(), totalMemory, std::plus{}, [](auto const& ind) { return Operon::Memory::Footprint(ind); });
+            auto calculateOffMemory = taskflow.transform_reduce(off.begin(), off.end(), totalMemory, std::plus{}, [](auto const& ind) { return Operon::Memory::Footprint(ind); });
+            if (sketch) { taskflow.emplace([&](tf::Subflow& subflow) { sketch->Prepare(subflow, pop); }).name("semantic diversity"); }
 
             exe.run(taskflow).wait();
 
+            auto const model = statistics.get();
+            // add scaling terms to the tree
+            auto const a = static_cast<Operon::Scalar>(model.Scale);
+            auto const b = static_cast<Operon::Scalar>(model.Offset);
+            auto& nodes = best.Genotype.Nodes();
+            auto const sz = nodes.size();
+            if (std::abs(a - Operon::Scalar{1}) > std::numeric_limits<Operon::Scalar>::epsilon()) {
+                nodes.emplace_back(Operon::Node::Constant(a));
+                nodes.emplace_back(Operon::Node(Operon::NodeType::Mul));
+            }
+            if (std::abs(b) > std::numeric_limits<Operon::Scalar>::epsilon()) {
+                nodes.emplace_back(Operon::Node::Constant(b));
+                nodes.emplace_back(Operon::Node(Operon::NodeType::Add));
+            }
+            if (nodes.size() > sz) {
+                best.Genotype.UpdateNodes();
+            }
+
             avgLength /= static_cast<double>(pop.size());
             avgQuality /= static_cast<double>(pop.size());
 
@@ -358,12 +486,12 @@ auto main(int argc, char** argv) -> int
             auto const* format = ":>#8.3g"; // see https://fmt.dev/latest/syntax.html
             std::array stats {
                 T{ "iteration", gp.Generation(), ":>" },
-                T{ "r2_tr", r2Train, format },
-                T{ "r2_te", r2Test, format },
-                T{ "mae_tr", maeTrain, format },
-                T{ "mae_te", maeTest, format },
-                T{ "nmse_tr", nmseTrain, format },
-                T{ "nmse_te", nmseTest, format },
+                T{ "r2_tr", model.R2Train, format },
+                T{ "r2_te", model.R2Test, format },
+                T{ "mae_tr", model.MaeTrain, format },
+                T{ "mae_te", model.MaeTest, format },
+                T{ "nmse_tr", model.NmseTrain, format },
+                T{ "nmse_te", model.NmseTest, format },
                 T{ "avg_fit", avgQuality, format },
                 T{ "avg_len", avgLength, format },
                 T{ "eval_cnt", evaluator.EvaluationCount() , ":>" },
@@ -373,10 +501,53 @@ auto main(int argc, char** argv) -> int
                 T{ "elapsed", elapsed, ":>"},
             };
             Operon::PrintStats({ stats.begin(), stats.end() }, gp.Generation() == 0);
+            if (!memoryWarning && Operon::Memory::OverLimit()) {
+                memoryWarning = true;
+                fmt::print(stderr, "warning: the accounted memory ({}) exceeds the soft limit\n", Operon::FormatBytes(Operon::Memory::Total()));
+            }
+
+            if (metricsSink) {
+                Operon::MetricsSample sample{ gp.Generation(), elapsed, evaluator.TotalEvaluations(), {} };
+                for (auto const& s : stats) { sample.Values.emplace_back(std::get<0>(s), std::get<1>(s)); }
+                sample.Values.emplace_back("memory_bytes", totalMemory);
+                sample.Values.emplace_back("filtered", generator->Filter().TotalStatistics().Rejected());
+                if (screening) { sample.Values.emplace_back("screened_out", screening->Screened() - screening->Promoted()); }
+                if (sketch) { sample.Values.emplace_back("semantic_diversity", sketch->Diversity()); }
+                if (surrogate) {
+                    sample.Values.emplace_back("surrogate_eval", evaluator.SurrogateEvaluations());
+                    sample.Values.emplace_back("surrogate_discarded", surrogate->Discarded());
+                }
+                if (archive) { sample.Values.emplace_back("archive_size", archive->Size()); }
+                metricsSink->Push(std::move(sample));
+            }
+            if (populationLog) {
+                auto const frame = populationLog->Encode(pop);
+                populationLogFile.write(reinterpret_cast<char const*>(frame.data()), static_cast<std::streamsize>(frame.size())); // NOLINT
+            }
         };
 
-        gp.Run(executor, random, report);
-        fmt::print("{}\n", Operon::InfixFormatter::Format(best.Genotype, problem.GetDataset(), 6));
+        // the checkpoints are taken in the report, which must not overlap with the next generation
+        auto const checkpoint = result.count("checkpoint") != 0 ? result["checkpoint"].as<std::string>() : std::string{};
+        auto const interval = std::max(size_t{1}, result["checkpoint-interval"].as<size_t>());
+        if (!checkpoint.empty() && gp.Pipelined()) {
+            throw std::runtime_error("--checkpoint cannot be combined with --pipelined");
+        }
+        Operon::CheckpointWriter writer;
+        gp.Run(executor, random, [&]() {
+            report();
+            if (!checkpoint.empty() && gp.Generation() % interval == 0) {
+                writer.Write(gp.SaveState(random), checkpoint);
+            }
+        });
+        writer.Wait();
+        if (archive) {
+            auto members = archive->Members();
+            Operon::ModelArchive::Write(result["pareto-archive"].as<std::string>(), { members.data(), members.size() }, problem.GetDataset().Variables());
+        }
+        fmt::print("{}\n", Operon::InfixFormatter::Format(Operon::RestoreInputs(best.Genotype, problem.GetDataset()), problem.GetDataset(), 6));
+        if (profile) { Operon::PrintProfile(); }
+        if (profilePrimitives) { Operon::PrintPrimitiveProfile(); }
+        if (trace) { trace->Dump(result["trace"].as<std::string>()); }
     } catch (std::exception& e) {
         fmt::print(stderr, "error: {}\n", e.what());
         return EXIT_FAILURE;
@@ -1,19 +1,296 @@
 // SPDX-License-Identifier: MIT
 // SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
 
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <cxxopts.hpp>
 #include <fmt/core.h>
 #include <scn/scn.h>
+#include <taskflow/taskflow.hpp>
 
 #include "operon/core/dataset.hpp"
 #include "operon/core/format.hpp"
+#include "operon/hash/hash.hpp"
 #include "operon/parser/infix.hpp"
 #include "operon/interpreter/interpreter.hpp"
 #include "operon/operators/evaluator.hpp"
 #include "util.hpp"
 
+namespace {
+// reads a csv file with a header row block by block, so that the memory does not depend on the size of the file
+class CsvBlockReader {
+public:
+    explicit CsvBlockReader(std::string const& path)
+        : in_(path)
+    {
+        if (!in_) { throw std::runtime_error(fmt::format("{}: cannot open file", path)); }
+        if (!std::getline(in_, line_)) { throw std::runtime_error(fmt::format("{}: the file is empty", path)); }
+        for (auto const& name : Operon::Split(line_, ',')) { names_.push_back(Trim(name)); }
+    }
+
+    [[nodiscard]] auto Names() const -> std::vector<std::string> const& { return names_; }
+
+    // returns the number of rows skipped
+    auto Skip(size_t rows) -> size_t
+    {
+        size_t n{0};
+        while (n < rows && std::getline(in_, line_)) { ++n; }
+        return n;
+    }
+
+    // at most the given number of rows, nothing at the end of the file. the values are stored column by column
+    // in one buffer owned by the dataset (so the dataset is a view, see Dataset::FromColumns)
+    auto Read(size_t rows) -> std::optional<Operon::Dataset>
+    {
+        auto const cols = names_.size();
+        std::vector<Operon::Scalar> values; // row-major
+        values.reserve(rows * cols);
+        size_t n{0};
+        while (n < rows && std::getline(in_, line_)) {
+            if (Trim(line_).empty()) { continue; }
+            auto const* p = line_.c_str();
+            for (size_t j = 0; j < cols; ++j) {
+                char* end{nullptr};
+                auto v = std::strtod(p, &end);
+                values.push_back(end == p ? std::numeric_limits<Operon::Scalar>::quiet_NaN() : static_cast<Operon::Scalar>(v));
+                p = std::strchr(end, ',');
+                if (p == nullptr) { p = end + std::strlen(end); } else { ++p; }
+            }
+            ++n;
+        }
+        if (n == 0) { return std::nullopt; }
+
+        auto storage = std::make_shared<std::vector<Operon::Scalar>>(n * cols);
+        std::vector<Operon::Span<Operon::Scalar const>> columns;
+        for (size_t j = 0; j < cols; ++j) {
+            auto* col = storage->data() + j * n;
+            for (size_t i = 0; i < n; ++i) { col[i] = values[i * cols + j]; }
+            columns.emplace_back(col, n);
+        }
+        return Operon::Dataset::FromColumns(names_, columns, storage);
+    }
+
+private:
+    static auto Trim(std::string str) -> std::string
+    {
+        auto const* ws = " \t\r\n\"";
+        auto b = str.find_first_not_of(ws);
+        auto e = str.find_last_not_of(ws);
+        return b == std::string::npos ? std::string{} : str.substr(b, e - b + 1);
+    }
+
+    std::ifstream in_;
+    std::vector<std::string> names_;
+    std::string line_;
+};
+
+// evaluates the model on the csv file block by block: the blocks of a group (one per thread) are evaluated in parallel
+// while the next group is read, the predictions are written in order as soon as their group is done
+auto Stream(cxxopts::ParseResult const& result, std::string const& infix) -> int
+{
+    auto const blockRows = result["stream"].as<size_t>();
+    if (blockRows == 0) {
+        fmt::print(stderr, "error: the block size must be positive.\n");
+        return EXIT_FAILURE;
+    }
+    if (result.count("target") > 0 || result.count("emit-c") > 0) {
+        fmt::print(stderr, "error: --stream only writes the model output (--target and --emit-c need the whole dataset).\n");
+        return EXIT_FAILURE;
+    }
+
+    CsvBlockReader reader(result["dataset"].as<std::string>());
+    robin_hood::unordered_flat_map<std::string, Operon::Hash> vmap;
+    for (auto const& name : reader.Names()) {
+        vmap.insert({ name, Operon::Hasher{}(reinterpret_cast<uint8_t const*>(name.c_str()), name.size()) }); // NOLINT
+    }
+    auto model = Operon::InfixParser::Parse(infix, Operon::InfixParser::DefaultTokens(), vmap);
+
+    // the rows [a, b) of the file
+    size_t first{0};
+    size_t last{std::numeric_limits<size_t>::max()};
+    if (result["range"].count() > 0) {
+        scn::scan(result["range"].as<std::string>(), "{}:{}", first, last);
+    }
+    reader.Skip(first);
+    auto remaining = last > first ? last - first : size_t{0};
+
+    auto const binary = result["binary"].as<bool>();
+    std::FILE* out = stdout;
+    std::unique_ptr<std::FILE, int(*)(std::FILE*)> file(nullptr, std::fclose);
+    if (result.count("output") > 0) {
+        file.reset(std::fopen(result["output"].as<std::string>().c_str(), binary ? "wb" : "w"));
+        if (file == nullptr) {
+            fmt::print(stderr, "error: cannot open {} for writing.\n", result["output"].as<std::string>());
+            return EXIT_FAILURE;
+        }
+        out = file.get();
+    }
+
+    auto threads = result["threads"].as<size_t>();
+    if (threads == 0) { threads = std::thread::hardware_concurrency(); }
+    tf::Executor executor(threads);
+    Operon::Interpreter interpreter;
+    auto const format = fmt::format("{{{}}}\n", result["format"].as<std::string>());
+
+    struct Block {
+        Operon::Dataset Data;
+        Operon::Vector<Operon::Scalar> Values;
+    };
+    auto readGroup = [&]() {
+        std::vector<Block> group;
+        while (group.size() < threads && remaining > 0) {
+            auto ds = reader.Read(std::min(blockRows, remaining));
+            if (!ds) { remaining = 0; break; }
+            remaining -= ds->Rows();
+            group.push_back({ std::move(*ds), {} });
+        }
+        return group;
+    };
+    auto write = [&](std::vector<Block> const& group) {
+        for (auto const& block : group) {
+            if (binary) {
+                std::fwrite(block.Values.data(), sizeof(Operon::Scalar), block.Values.size(), out);
+                continue;
+            }
+            fmt::memory_buffer buf;
+            for (auto v : block.Values) { fmt::format_to(buf, format, v); }
+            std::fwrite(buf.data(), 1, buf.size(), out);
+        }
+    };
+
+    auto current = readGroup();
+    size_t rows{0};
+    while (!current.empty()) {
+        tf::Taskflow taskflow;
+        taskflow.for_each_index(size_t{0}, current.size(), size_t{1}, [&](size_t i) {
+            auto& block = current[i];
+            block.Values = interpreter.Evaluate<Operon::Scalar>(model, block.Data, Operon::Range { 0, block.Data.Rows() });
+        });
+        auto done = executor.run(taskflow);
+        auto next = readGroup();
+        done.wait();
+        write(current);
+        for (auto const& block : current) { rows += block.Values.size(); }
+        current = std::move(next);
+    }
+    std::fflush(out);
+
+    if (result["debug"].as<bool>()) {
+        fmt::print(stderr, "Streamed {} rows in blocks of {} rows\n", rows, blockRows);
+    }
+    return EXIT_SUCCESS;
+}
+
+// applies the linear scaling (the given one or the least squares fit) to the model output and returns the error metrics
+auto Score(Operon::Span<Operon::Scalar> est, Operon::Span<Operon::Scalar const> tgt, cxxopts::ParseResult const& result, std::string const& format) -> std::vector<std::tuple<std::string, double, std::string>>
+{
+    Operon::Scalar a{0};
+    Operon::Scalar b{0};
+    if (result["scale"].count() > 0) {
+        scn::scan(result["scale"].as<std::string>(), "{}:{}", a, b);
+    } else {
+        auto [a_, b_] = Operon::FitLeastSquares(est, tgt);
+        a = static_cast<Operon::Scalar>(a_);
+        b = static_cast<Operon::Scalar>(b_);
+    }
+
+    std::transform(est.begin(), est.end(), est.begin(), [&](auto v) { return v * a + b; });
+    auto r2 = -Operon::R2{}(est, tgt);
+    auto rs = -Operon::C2{}(est, tgt);
+    auto mae = Operon::MAE{}(est, tgt);
+    auto mse = Operon::MSE{}(est, tgt);
+    auto rmse = Operon::RMSE{}(est, tgt);
+    auto nmse = Operon::NMSE{}(est, tgt);
+
+    return {
+        {"slope", a, format},
+        {"intercept", b, format},
+        {"r2", r2, format},
+        {"rs", rs, format},
+        {"mae", mae, format},
+        {"mse", mse, format},
+        {"rmse", rmse, format},
+        {"nmse", nmse, format},
+    };
+}
+
+// scores every model of the file (one infix expression per line, empty lines and lines starting with # are ignored)
+// in one pass over the data: the range is split into chunks which are evaluated in parallel, each chunk evaluates all
+// the models on its rows (see Interpreter::EvaluateBatch). prints one row of metrics per model if there is a target,
+// otherwise the prediction matrix (one column per model)
+auto ScoreModels(cxxopts::ParseResult const& result, Operon::Dataset const& ds, Operon::Range range, tf::Executor& executor) -> int
+{
+    std::ifstream in(result["models"].as<std::string>());
+    if (!in) {
+        fmt::print(stderr, "error: cannot open {}.\n", result["models"].as<std::string>());
+        return EXIT_FAILURE;
+    }
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line.front() == '#' || line.find_first_not_of(" \t\r") == std::string::npos) { continue; }
+        lines.push_back(line);
+    }
+    Operon::ModelParser parser(ds.Variables());
+    auto models = parser.ParseMany(executor, lines);
+    if (models.empty()) {
+        fmt::print(stderr, "error: no models were found in {}.\n", result["models"].as<std::string>());
+        return EXIT_FAILURE;
+    }
+
+    Operon::Interpreter interpreter;
+    std::vector<Operon::Vector<Operon::Scalar>> predictions(models.size(), Operon::Vector<Operon::Scalar>(range.Size()));
+    auto const chunks = (range.Size() + Operon::DefaultParallelBatchSize - 1) / Operon::DefaultParallelBatchSize;
+    tf::Taskflow taskflow;
+    taskflow.for_each_index(size_t{0}, chunks, size_t{1}, [&](size_t i) {
+        auto const offset = i * Operon::DefaultParallelBatchSize;
+        Operon::Range chunk { range.Start() + offset, std::min(range.Start() + offset + Operon::DefaultParallelBatchSize, range.End()) };
+        std::vector<Operon::Span<Operon::Scalar>> views;
+        views.reserve(models.size());
+        for (auto& p : predictions) { views.emplace_back(p.data() + offset, chunk.Size()); }
+        interpreter.EvaluateBatch<Operon::Scalar>({ models.data(), models.size() }, ds, chunk, { views.data(), views.size() });
+    });
+    executor.run(taskflow).wait();
+
+    std::string format = result["format"].as<std::string>();
+    if (result["target"].count() > 0) {
+        auto tgt = ds.GetValues(result["target"].as<std::string>()).subspan(range.Start(), range.Size());
+        for (size_t i = 0; i < models.size(); ++i) {
+            auto stats = Score({ predictions[i].data(), predictions[i].size() }, tgt, result, format);
+            stats.insert(stats.begin(), { "model", static_cast<double>(i), ":>5.0f" });
+            Operon::PrintStats(stats, /*printHeader=*/i == 0);
+        }
+        return EXIT_SUCCESS;
+    }
+
+    auto out = fmt::memory_buffer();
+    for (size_t i = 0; i < models.size(); ++i) {
+        fmt::format_to(std::back_inserter(out), "{}model{}", i == 0 ? "" : ",", i);
+    }
+    fmt::format_to(std::back_inserter(out), "\n");
+    auto const cell = fmt::format("{{{}}}", format);
+    for (size_t r = 0; r < range.Size(); ++r) {
+        for (size_t i = 0; i < models.size(); ++i) {
+            if (i > 0) { fmt::format_to(std::back_inserter(out), ","); }
+            fmt::format_to(out, cell, predictions[i][r]);
+        }
+        fmt::format_to(std::back_inserter(out), "\n");
+    }
+    fmt::print("{}", fmt::to_string(out));
+    return EXIT_SUCCESS;
+}
+} // namespace
+
 auto main(int argc, char** argv) -> int
 {
     cxxopts::Options opts("operon_parse_model", "Parse and evaluate a model in infix form");
@@ -23,8 +300,14 @@ auto main(int argc, char** argv) -> int
         ("target", "Name of the target variable (if none provided, model output will be printed)", cxxopts::value<std::string>())
         ("range", "Data range [A:B)", cxxopts::value<std::string>())
         ("scale", "Linear scaling slope:intercept", cxxopts::value<std::string>())
+        ("threads", "Number of threads to use for evaluation (0 = all available)", cxxopts::value<size_t>()->default_value("0"))
         ("debug", "Show some debugging information", cxxopts::value<bool>()->default_value("false"))
         ("format", "Format string (see https://fmt.dev/latest/syntax.html)", cxxopts::value<std::string>()->default_value(":>#8.4g"))
+        ("emit-c", "Print the model as a self-contained C function with the given name instead of evaluating it", cxxopts::value<std::string>())
+        ("models", "Score all the models of the file (one infix string per line) in one pass over the data, instead of a single infix string", cxxopts::value<std::string>())
+        ("stream", "Read the dataset (csv) in blocks of the given number of rows and write the model output as it is computed", cxxopts::value<size_t>())
+        ("output", "Write the model output to this file instead of the standard output (with --stream)", cxxopts::value<std::string>())
+        ("binary", "Write the model output as raw scalars instead of text (with --stream)", cxxopts::value<bool>()->default_value("false"))
         ("help", "Print help");
 
     opts.allow_unrecognised_options();
@@ -47,13 +330,42 @@ auto main(int argc, char** argv) -> int
         return EXIT_FAILURE;
     }
 
+    if (result.count("models") > 0) {
+        try {
+            Operon::Dataset ds(result["dataset"].as<std::string>(), /*hasHeader=*/true);
+            Operon::Range range{0, ds.Rows()};
+            if (result["range"].count() > 0) {
+                size_t a{0};
+                size_t b{0};
+                scn::scan(result["range"].as<std::string>(), "{}:{}", a, b);
+                range = Operon::Range{a, b};
+            }
+            auto threads = result["threads"].as<size_t>();
+            if (threads == 0) { threads = std::thread::hardware_concurrency(); }
+            tf::Executor executor(threads);
+            return ScoreModels(result, ds, range, executor);
+        } catch (std::exception const& e) {
+            fmt::print(stderr, "error: {}\n", e.what());
+            return EXIT_FAILURE;
+        }
+    }
+
     if (result.unmatched().empty()) {
         fmt::print(stderr, "error: no infix string was provided.\n");
         return EXIT_FAILURE;
     }
 
-    Operon::Dataset ds(result["dataset"].as<std::string>(), /*hasHeader=*/true);
     auto infix = result.unmatched().front();
+    if (result.count("stream") > 0) {
+        try {
+            return Stream(result, infix);
+        } catch (std::exception const& e) {
+            fmt::print(stderr, "error: {}\n", e.what());
+            return EXIT_FAILURE;
+        }
+    }
+
+    Operon::Dataset ds(result["dataset"].as<std::string>(), /*hasHeader=*/true);
     auto tmap = Operon::InfixParser::DefaultTokens();
     robin_hood::unordered_flat_map<std::string, Operon::Hash> vmap;
     for (auto const& v : ds.Variables()) {
@@ -78,41 +390,25 @@ auto main(int argc, char** argv) -> int
         fmt::print("Scale: {}\n", result["scale"].count() > 0 ? result["scale"].as<std::string>() : std::string("auto"));
     }
 
-    auto est = interpreter.Evaluate<Operon::Scalar>(model, ds, range);
+    if (result.count("emit-c") > 0) {
+        try {
+            fmt::print("{}", Operon::CodeFormatter::Format(model, ds, result["emit-c"].as<std::string>()));
+        } catch (std::exception const& e) {
+            fmt::print(stderr, "error: {}\n", e.what());
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    auto threads = result["threads"].as<size_t>();
+    if (threads == 0) { threads = std::thread::hardware_concurrency(); }
+    tf::Executor executor(threads);
+    auto est = Operon::EvaluateParallel(executor, interpreter, model, ds, range);
 
     std::string format = result["format"].as<std::string>();
     if (result["target"].count() > 0) {
         auto tgt = ds.GetValues(result["target"].as<std::string>()).subspan(range.Start(), range.Size());
-
-        Operon::Scalar a{0};
-        Operon::Scalar b{0};
-        if (result["scale"].count() > 0) {
-            scn::scan(result["scale"].as<std::string>(), "{}:{}", a, b);
-        } else {
-            auto [a_, b_] = Operon::FitLeastSquares(est, tgt);
-            a = static_cast<Operon::Scalar>(a_);
-            b = static_cast<Operon::Scalar>(b_);
-        }
-
-        std::transform(est.begin(), est.end(), est.begin(), [&](auto v) { return v * a + b; });
-        auto r2 = -Operon::R2{}(Operon::Span<Operon::Scalar>{est}, tgt);
-        auto rs = -Operon::C2{}(Operon::Span<Operon::Scalar>{est}, tgt);
-        auto mae = Operon::MAE{}(Operon::Span<Operon::Scalar>{est}, tgt);
-        auto mse = Operon::MSE{}(Operon::Span<Operon::Scalar>{est}, tgt);
-        auto rmse = Operon::RMSE{}(Operon::Span<Operon::Scalar>{est}, tgt);
-        auto nmse = Operon::NMSE{}(Operon::Span<Operon::Scalar>{est}, tgt);
-
-        std::vector<std::tuple<std::string, double, std::string>> stats{
-            {"slope", a, format},
-            {"intercept", b, format},
-            {"r2", r2, format},
-            {"rs", rs, format},
-            {"mae", mae, format},
-            {"mse", mse, format},
-            {"rmse", rmse, format},
-            {"nmse", nmse, format},
-        };
-        Operon::PrintStats(stats);
+        Operon::PrintStats(Score(est, tgt, result, format));
     } else {
         auto out = fmt::memory_buffer();
         for (auto v : est) {
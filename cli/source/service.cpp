@@ -0,0 +1,200 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include "service.hpp"
+
+#include <algorithm>
+#include <csignal>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include <fmt/core.h>
+#include <fmt/format.h>
+
+#include "operon/core/range.hpp"
+#include "operon/interpreter/interpreter.hpp"
+
+#if !defined(_WIN32)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+namespace Operon {
+
+namespace {
+    // <start>:<end>
+    auto ParseRows(std::string const& str) -> Operon::Range
+    {
+        auto const sep = str.find(':');
+        if (sep == std::string::npos) { throw std::runtime_error(fmt::format("invalid range {}", str)); }
+        return { std::stoul(str.substr(0, sep)), std::stoul(str.substr(sep + 1)) };
+    }
+} // namespace
+
+auto Service::GetDataset(std::string const& path) -> std::shared_ptr<Operon::Dataset const>
+{
+    std::lock_guard<std::mutex> guard(lock_);
+    auto& ds = datasets_[path];
+    if (!ds) {
+        try {
+            ds = std::make_shared<Operon::Dataset const>(path, true);
+        } catch (...) {
+            datasets_.erase(path);
+            throw;
+        }
+    }
+    return ds;
+}
+
+auto Service::RemoveDataset(std::string const& path) -> void
+{
+    std::lock_guard<std::mutex> guard(lock_);
+    if (datasets_.erase(path) == 0) { throw std::runtime_error(fmt::format("unknown dataset {}", path)); }
+}
+
+auto Service::GetModel(size_t id) -> Operon::Tree
+{
+    std::lock_guard<std::mutex> guard(lock_);
+    auto it = models_.find(id);
+    if (it == models_.end()) { throw std::runtime_error(fmt::format("unknown model {}", id)); }
+    return it->second;
+}
+
+auto Service::AddModel(Operon::Tree model) -> size_t
+{
+    std::lock_guard<std::mutex> guard(lock_);
+    auto const id = nextModel_++;
+    models_.insert({ id, std::move(model) });
+    return id;
+}
+
+auto Service::RemoveModel(size_t id) -> void
+{
+    std::lock_guard<std::mutex> guard(lock_);
+    if (models_.erase(id) == 0) { throw std::runtime_error(fmt::format("unknown model {}", id)); }
+}
+
+auto Service::DatasetCount() const -> size_t
+{
+    std::lock_guard<std::mutex> guard(lock_);
+    return datasets_.size();
+}
+
+auto Service::ModelCount() const -> size_t
+{
+    std::lock_guard<std::mutex> guard(lock_);
+    return models_.size();
+}
+
+auto Service::Handle(std::string const& line, std::FILE* out) -> bool
+{
+    std::istringstream stream(line);
+    std::vector<std::string> tokens;
+    for (std::string tok; stream >> tok;) { tokens.push_back(tok); }
+    if (tokens.empty()) { return true; }
+    auto const& command = tokens.front();
+    try {
+        if (command == "quit") { return false; }
+        if (command == "load" && tokens.size() == 2) {
+            auto const ds = GetDataset(tokens[1]);
+            fmt::print(out, "done {} {}\n", ds->Rows(), ds->Cols());
+        } else if (command == "unload" && tokens.size() == 2) {
+            RemoveDataset(tokens[1]);
+            fmt::print(out, "done\n");
+        } else if (command == "fit") {
+            tokens.front() = "operon_gp";
+            auto model = [&]() {
+                std::lock_guard<std::mutex> guard(fitLock_);
+                return fit_(tokens, *this, out);
+            }();
+            fmt::print(out, "done {}\n", AddModel(std::move(model)));
+        } else if (command == "predict" && (tokens.size() == 3 || tokens.size() == 4)) {
+            auto const model = GetModel(std::stoul(tokens[1]));
+            auto const ds = GetDataset(tokens[2]);
+            auto const range = tokens.size() == 4 ? ParseRows(tokens[3]) : Operon::Range { 0, ds->Rows() };
+            if (range.End() > ds->Rows() || range.Start() > range.End()) { throw std::runtime_error("invalid range"); }
+            Operon::Interpreter interpreter;
+            auto const values = Operon::EvaluateParallel(executor_, interpreter, model, *ds, range);
+            auto buf = fmt::memory_buffer();
+            for (auto v : values) { fmt::format_to(buf, "{}\n", v); }
+            fmt::print(out, "{}done {}\n", fmt::to_string(buf), values.size());
+        } else if (command == "drop" && tokens.size() == 2) {
+            RemoveModel(std::stoul(tokens[1]));
+            fmt::print(out, "done\n");
+        } else {
+            throw std::runtime_error(fmt::format("invalid request: {}", line));
+        }
+    } catch (std::exception const& e) {
+        fmt::print(out, "error {}\n", e.what());
+    }
+    std::fflush(out);
+    return true;
+}
+
+#if !defined(_WIN32)
+auto ServeConnection(Service& service, int connection) -> void
+{
+    // one stream per direction, over two descriptors of the socket
+    auto const copy = ::dup(connection);
+    auto* in = ::fdopen(connection, "r");
+    auto* out = copy < 0 ? nullptr : ::fdopen(copy, "w");
+    if (in == nullptr || out == nullptr) {
+        if (in != nullptr) { std::fclose(in); } else { ::close(connection); }
+        if (out != nullptr) { std::fclose(out); } else if (copy >= 0) { ::close(copy); }
+        return;
+    }
+    std::setvbuf(out, nullptr, _IOLBF, BUFSIZ); // the generations are streamed as they are reported
+    std::string line;
+    for (int c = std::fgetc(in); c != EOF; c = std::fgetc(in)) {
+        if (c != '\n') { line.push_back(static_cast<char>(c)); continue; }
+        if (!line.empty() && line.back() == '\r') { line.pop_back(); }
+        if (!service.Handle(line, out)) { break; }
+        line.clear();
+    }
+    std::fclose(out);
+    std::fclose(in);
+}
+
+auto Serve(Service& service, uint16_t port, size_t connections) -> void
+{
+    auto const listener = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0) { throw std::runtime_error("cannot create the socket"); }
+    int const yes{1};
+    ::setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    if (::bind(listener, reinterpret_cast<sockaddr const*>(&address), sizeof(address)) != 0 || ::listen(listener, SOMAXCONN) != 0) { // NOLINT
+        ::close(listener);
+        throw std::runtime_error(fmt::format("cannot listen on port {}", port));
+    }
+    std::signal(SIGPIPE, SIG_IGN); // a client closing its connection must not stop the service
+    fmt::print("listening on 127.0.0.1:{}\n", port);
+    std::fflush(stdout);
+
+    // every handler accepts its next connection once it is done with the previous one
+    std::vector<std::thread> handlers;
+    for (size_t i = 0; i < std::max(connections, size_t{1}); ++i) {
+        handlers.emplace_back([&service, listener]() {
+            for (;;) {
+                auto const connection = ::accept(listener, nullptr, nullptr);
+                if (connection >= 0) {
+                    ServeConnection(service, connection);
+                } else if (errno != EINTR && errno != ECONNABORTED) {
+                    return;
+                }
+            }
+        });
+    }
+    for (auto& t : handlers) { t.join(); }
+    ::close(listener);
+}
+#endif
+
+} // namespace Operon
@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_CLI_SERVICE_HPP
+#define OPERON_CLI_SERVICE_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "operon/core/dataset.hpp"
+#include "operon/core/tree.hpp"
+
+namespace tf { class Executor; }
+
+namespace Operon {
+
+// the service mode: a long-lived process which keeps the executor warm and the datasets resident (read once by path,
+// the binary files are memory mapped) and serves the requests of its clients over a line based protocol:
+//   load <path>                       reads the dataset, replies "done <rows> <cols>"
+//   unload <path>                     releases the dataset (the running requests keep their copy), replies "done"
+//   fit <options>                     runs with the options (as on the command line, --dataset is served from memory),
+//                                     streams the statistics of every generation and the best model, replies "done <id>"
+//   predict <id> <path> [<range>]     the outputs of the fitted model on the rows (all by default), one per line,
+//                                     replies "done <rows>"
+//   drop <id>                         releases the model, replies "done"
+//   quit                              closes the connection
+// a failed request replies "error <message>" and the connection stays open
+// - the fits run one at a time: a run sets process wide state (the memory limit, the instrumentation), the other
+//   requests of the concurrent connections are served meanwhile
+class Service {
+public:
+    // runs the fit of a request (the arguments start with the program name) and returns the model, streaming its
+    // progress to the output. the datasets are looked up through the service
+    using FitFunction = std::function<Operon::Tree(std::vector<std::string> const& arguments, Service& service, std::FILE* out)>;
+
+    Service(tf::Executor& executor, FitFunction fit)
+        : executor_(executor)
+        , fit_(std::move(fit))
+    {
+    }
+
+    [[nodiscard]] auto Executor() const -> tf::Executor& { return executor_; }
+
+    auto GetDataset(std::string const& path) -> std::shared_ptr<Operon::Dataset const>;
+    auto RemoveDataset(std::string const& path) -> void;
+
+    auto GetModel(size_t id) -> Operon::Tree;
+    auto AddModel(Operon::Tree model) -> size_t;
+    auto RemoveModel(size_t id) -> void;
+
+    [[nodiscard]] auto DatasetCount() const -> size_t;
+    [[nodiscard]] auto ModelCount() const -> size_t;
+
+    // handles a request line, returns false if the client quits
+    auto Handle(std::string const& line, std::FILE* out) -> bool;
+
+private:
+    std::reference_wrapper<tf::Executor> executor_;
+    FitFunction fit_;
+    mutable std::mutex lock_;
+    std::mutex fitLock_;
+    std::unordered_map<std::string, std::shared_ptr<Operon::Dataset const>> datasets_;
+    std::unordered_map<size_t, Operon::Tree> models_;
+    size_t nextModel_{0};
+};
+
+#if !defined(_WIN32)
+// serves the requests read from the connected socket until the client quits or closes it, the socket is closed
+auto ServeConnection(Service& service, int connection) -> void;
+
+// accepts the connections on the loopback interface with a fixed number of handler threads (the other clients wait
+// in the backlog), returns once the socket fails
+auto Serve(Service& service, uint16_t port, size_t connections) -> void;
+#endif
+
+} // namespace Operon
+
+#endif
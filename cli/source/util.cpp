@@ -4,10 +4,15 @@
 #include "util.hpp"
 
 #include <memory>
+#include <stdexcept>
 #include <scn/scn.h>
 
+#include "operon/core/dataset.hpp"
+#include "operon/core/instrumentation.hpp"
 #include "operon/core/node.hpp"
 #include "operon/core/pset.hpp"
+#include "operon/core/serialization.hpp"
+#include "operon/core/tree.hpp"
 #include "operon/core/version.hpp"
 
 using Operon::NodeType;
@@ -99,6 +104,16 @@ auto ParsePrimitiveSetConfig(const std::string& options) -> PrimitiveSetConfig
     return config;
 }
 
+auto ParseKernel(std::string const& name, PrimitiveSetConfig config) -> PrimitiveSetConfig
+{
+    if (name == "auto") { return config; }
+    if (name == "generic") { return static_cast<PrimitiveSetConfig>(0); }
+    if (name == "arithmetic") { return PrimitiveSet::Arithmetic; }
+    if (name == "type-coherent") { return PrimitiveSet::TypeCoherent; }
+    if (name == "full") { return PrimitiveSet::Full; }
+    throw std::runtime_error(fmt::format("Unknown interpreter kernel {}\n", name));
+}
+
 auto PrintPrimitives(NodeType config) -> void
 {
     PrimitiveSet tmpSet;
@@ -115,28 +130,124 @@ auto PrintPrimitives(NodeType config) -> void
     }
 }
 
-auto PrintStats(std::vector<std::tuple<std::string, double, std::string>> const& stats, bool printHeader) -> void
+auto PrintStats(std::vector<std::tuple<std::string, double, std::string>> const& stats, bool printHeader, std::FILE* out) -> void
 {
     std::vector<size_t> widths;
-    auto out = fmt::memory_buffer();
+    auto buf = fmt::memory_buffer();
     for (auto const& [name, value, format] : stats) {
-        fmt::format_to(out, fmt::format("{{{}}}", format), value);
-        auto width = std::max(name.size(), fmt::to_string(out).size());
+        fmt::format_to(buf, fmt::format("{{{}}}", format), value);
+        auto width = std::max(name.size(), fmt::to_string(buf).size());
         widths.push_back(width);
-        out.clear();
+        buf.clear();
     }
     if (printHeader) {
         for (auto i = 0UL; i < stats.size(); ++i) {
-            fmt::print("{} ", fmt::format("{:>{}}", std::get<0>(stats[i]), widths[i]));
+            fmt::print(out, "{} ", fmt::format("{:>{}}", std::get<0>(stats[i]), widths[i]));
         }
-        fmt::print("\n");
+        fmt::print(out, "\n");
     }
     for (auto i = 0UL; i < stats.size(); ++i) {
-        fmt::format_to(out, fmt::format("{{{}}}", std::get<2>(stats[i])), std::get<1>(stats[i]));
-        fmt::print("{} ", fmt::format("{:>{}}", fmt::to_string(out), widths[i]));
-        out.clear();
+        fmt::format_to(buf, fmt::format("{{{}}}", std::get<2>(stats[i])), std::get<1>(stats[i]));
+        fmt::print(out, "{} ", fmt::format("{:>{}}", fmt::to_string(buf), widths[i]));
+        buf.clear();
+    }
+    fmt::print(out, "\n");
+}
+
+auto PrintProfile() -> void
+{
+    auto const profile = Instrumentation::Snapshot();
+    auto print = [](char const* name, Instrumentation::Timing const& t) {
+        if (t.Calls == 0 && t.Cpu == 0) { return; }
+        fmt::print(stderr, "{:>24} {:>12.3f} {:>12.3f} {:>12}\n", name, t.Wall, t.Cpu, t.Calls);
+    };
+    fmt::print(stderr, "{:>24} {:>12} {:>12} {:>12}\n", "stage", "wall (s)", "cpu (s)", "calls");
+    for (size_t i = 0; i < Instrumentation::StageCount; ++i) {
+        print(Instrumentation::Name(static_cast<Instrumentation::Stage>(i)), profile.Stages[i]);
+    }
+    fmt::print(stderr, "{:>24} {:>12} {:>12} {:>12}\n", "operator", "wall (s)", "cpu (s)", "calls");
+    for (size_t i = 0; i < Instrumentation::OperatorCount; ++i) {
+        print(Instrumentation::Name(static_cast<Instrumentation::Operator>(i)), profile.Operators[i]);
+    }
+    if (!Instrumentation::HardwareCounting()) { return; }
+
+    // the bandwidth is the estimated memory traffic over the wall time, summed over the calls for the operators
+    // (which gives the bandwidth used by one thread) and elapsed for the stages (the bandwidth used by all of them)
+    using Instrumentation::Event;
+    constexpr double giga{1e9};
+    auto printCounts = [&](auto const& name, Instrumentation::Timing const& t, double seconds) {
+        if (t[Event::Cycles] == 0 && t[Event::Instructions] == 0) { return; }
+        auto const bandwidth = seconds > 0 ? t.Traffic() / seconds / giga : 0.0;
+        fmt::print(stderr, "{:>24} {:>14} {:>14} {:>6.2f} {:>12} {:>12} {:>8.2f}\n", name, t[Event::Cycles], t[Event::Instructions], t.Ipc(), t[Event::CacheMisses], t[Event::BranchMisses], bandwidth);
+    };
+    auto header = [](char const* name) {
+        fmt::print(stderr, "{:>24} {:>14} {:>14} {:>6} {:>12} {:>12} {:>8}\n", name, "cycles", "instructions", "ipc", "cache miss", "branch miss", "GB/s");
+    };
+    header("stage");
+    for (size_t i = 0; i < Instrumentation::StageCount; ++i) {
+        printCounts(Instrumentation::Name(static_cast<Instrumentation::Stage>(i)), profile.Stages[i], profile.Stages[i].Wall);
+    }
+    header("operator");
+    for (size_t i = 0; i < Instrumentation::OperatorCount; ++i) {
+        printCounts(Instrumentation::Name(static_cast<Instrumentation::Operator>(i)), profile.Operators[i], profile.Operators[i].Wall);
+    }
+    // the stages of a thread do not overlap, so their sum is the work of the thread (over its cpu time)
+    header("thread");
+    auto const threads = Instrumentation::ThreadSnapshot();
+    for (size_t k = 0; k < threads.size(); ++k) {
+        Instrumentation::Timing total;
+        for (auto const& t : threads[k].Stages) {
+            total.Cpu += t.Cpu;
+            for (size_t e = 0; e < Instrumentation::EventCount; ++e) { total.Events[e] += t.Events[e]; }
+        }
+        printCounts(fmt::format("{}", k), total, total.Cpu);
+    }
+}
+
+auto PrintPrimitiveProfile() -> void
+{
+    auto const profile = Instrumentation::PrimitiveSnapshot();
+    double total{0};
+    for (auto const& p : profile.Primitives) { total += p.Time; }
+
+    constexpr double ns{1e9};
+    constexpr double pct{100};
+    fmt::print(stderr, "{:>16} {:>8} {:>12} {:>14} {:>12} {:>10} {:>8}\n", "primitive", "type", "batches", "rows", "time (s)", "ns/row", "share");
+    for (auto const& p : profile.Primitives) {
+        auto name = p.Type == NodeType::Dynamic ? fmt::format("dyn {:#x}", p.HashValue) : Node(p.Type).Name();
+        auto perRow = p.Rows > 0 ? p.Time * ns / static_cast<double>(p.Rows) : 0.0;
+        auto share = total > 0 ? p.Time / total * pct : 0.0;
+        fmt::print(stderr, "{:>16} {:>8} {:>12} {:>14} {:>12.3f} {:>10.2f} {:>7.1f}%\n", name, Instrumentation::Name(p.Kind), p.Calls, p.Rows, p.Time, perRow, share);
     }
-    fmt::print("\n");
+    fmt::print(stderr, "reverse mode jacobians: {} calls, {} rows, {:.3f} s\n", profile.JacobianCalls, profile.JacobianRows, profile.JacobianTime);
+}
+
+auto RestoreInputs(Operon::Tree const& tree, Operon::Dataset const& dataset) -> Operon::Tree
+{
+    // w * (x - s) / k is (w / k) * x - w * s / k, the leaves are replaced in postfix order
+    Operon::Vector<Operon::Node> nodes;
+    nodes.reserve(tree.Length());
+    for (auto const& node : tree.Nodes()) {
+        auto const t = node.IsVariable() ? dataset.Transform(node.HashValue) : ColumnTransform{};
+        if (t.IsIdentity()) {
+            nodes.push_back(node);
+            continue;
+        }
+        auto const w = static_cast<double>(node.Value);
+        auto& v = nodes.emplace_back(node);
+        v.Value = static_cast<Operon::Scalar>(w / t.Scale);
+        nodes.emplace_back(Node::Constant(-w * t.Shift / t.Scale));
+        nodes.emplace_back(NodeType::Add);
+    }
+    return Operon::Tree(std::move(nodes)).UpdateNodes();
+}
+
+auto ParsePrecision(std::string const& name) -> Serialization::Precision
+{
+    if (name == "exact") { return Serialization::Precision::Exact; }
+    if (name == "single") { return Serialization::Precision::Single; }
+    if (name == "bfloat16") { return Serialization::Precision::BFloat16; }
+    throw std::runtime_error(fmt::format("Unknown precision {}\n", name));
 }
 
 auto InitOptions(std::string const& name, std::string const& desc, int width) -> cxxopts::Options
@@ -162,6 +273,21 @@ auto InitOptions(std::string const& name, std::string const& desc, int width) ->
         ("generations", "Number of generations", cxxopts::value<size_t>()->default_value("1000"))
         ("evaluations", "Evaluation budget", cxxopts::value<size_t>()->default_value("1000000"))
         ("iterations", "Local optimization iterations", cxxopts::value<size_t>()->default_value("0"))
+        ("variable-projection", "Solve for the linearly entering coefficients in closed form during local optimization", cxxopts::value<bool>()->default_value("false"))
+        ("normal-equations", "Accumulate the normal equations block by block during local optimization (less memory on large datasets)", cxxopts::value<bool>()->default_value("false"))
+        ("mini-batch", "Optimize the coefficients by Adam over mini-batches of this many rows (0 disables it, each local optimization iteration evaluates one mini-batch)", cxxopts::value<size_t>()->default_value("0"))
+        ("warm-start", "Warm start the local optimization from the cached coefficients of inherited subtrees", cxxopts::value<bool>()->default_value("false"))
+        ("simplify", "Simplify the offspring (constant folding, identities) before evaluation", cxxopts::value<bool>()->default_value("false"))
+        ("batch-evaluation", "Evaluate the offspring with the batch evaluator, which streams the rows of every model tile by tile into the error metric (the local optimization only uses the iterations and the simplification, not combined with subsample)", cxxopts::value<bool>()->default_value("false"))
+        ("fingerprint-rows", "Give the offspring with the same outputs as an evaluated model on this many sampled training rows its fitness instead of evaluating them (0 disables it)", cxxopts::value<size_t>()->default_value("0"))
+        ("reject-oversized", "Discard the offspring longer or deeper than the maximum length and depth before their evaluation", cxxopts::value<bool>()->default_value("false"))
+        ("reject-clones", "Discard the offspring identical to a parent before their evaluation", cxxopts::value<bool>()->default_value("false"))
+        ("tarpeian", "Discard the offspring longer than the average parent with this probability before their evaluation (tarpeian bloat control, 0 disables it)", cxxopts::value<double>()->default_value("0"))
+        ("screening", "Screen the offspring of the brood and the offspring selection generators in single precision on this fraction of the training rows, only the promoted ones are evaluated (0 disables it)", cxxopts::value<double>()->default_value("0"))
+        ("screening-quantile", "Promote the screened offspring not worse than this quantile of the screened population", cxxopts::value<double>()->default_value("0.75"))
+        ("semantic-diversity", "Estimate the semantic diversity of the population from random projections of the outputs of the models on this many dimensions, reported with the metrics (0 disables it)", cxxopts::value<size_t>()->default_value("0"))
+        ("surrogate", "Discard the offspring of the brood and the offspring selection generators predicted to be clearly worse than the population by an online surrogate model of the fitness, before their evaluation", cxxopts::value<bool>()->default_value("false"))
+        ("subsample", "Fraction of the training data used to evaluate offspring (the best are re-evaluated on all the training data)", cxxopts::value<double>()->default_value("1.0"))
         ("selection-pressure", "Selection pressure", cxxopts::value<size_t>()->default_value("100"))
         ("maxlength", "Maximum length", cxxopts::value<size_t>()->default_value("50"))
         ("maxdepth", "Maximum depth", cxxopts::value<size_t>()->default_value("10"))
@@ -169,12 +295,42 @@ auto InitOptions(std::string const& name, std::string const& desc, int width) ->
         ("crossover-internal-probability", "Crossover bias towards swapping function nodes", cxxopts::value<Operon::Scalar>()->default_value("0.9"))
         ("mutation-probability", "The probability to apply mutation", cxxopts::value<Operon::Scalar>()->default_value("0.25"))
         ("tree-creator", "Tree creator operator to initialize the population with.", cxxopts::value<std::string>()->default_value("btc"))
-        ("female-selector", "Female selection operator, with optional parameters separated by : (eg, --selector tournament:5)", cxxopts::value<std::string>()->default_value("tournament"))
-        ("male-selector", "Male selection operator, with optional parameters separated by : (eg, --selector tournament:5)", cxxopts::value<std::string>()->default_value("tournament"))
+        ("female-selector", "Female selection operator, with optional parameters separated by : (eg, --selector tournament:5, lexicase:64)", cxxopts::value<std::string>()->default_value("tournament"))
+        ("male-selector", "Male selection operator, with optional parameters separated by : (eg, --selector tournament:5, lexicase:64)", cxxopts::value<std::string>()->default_value("tournament"))
         ("offspring-generator", "OffspringGenerator operator, with optional parameters separated by : (eg --offspring-generator brood:10:10)", cxxopts::value<std::string>()->default_value("basic"))
+        ("async", "Run the asynchronous steady-state algorithm without generation barriers (operon_gp only)", cxxopts::value<bool>()->default_value("false"))
+        ("batch", "Run the configurations of this file concurrently on one executor and one dataset, one run per line given by the options added to the command line (operon_gp only)", cxxopts::value<std::string>())
+        ("batch-concurrency", "The number of batch runs in progress at once (0: one per thread)", cxxopts::value<size_t>()->default_value("0"))
+        ("serve", "Serve load, fit and predict requests on this local tcp port, keeping the executor and the datasets resident (operon_gp only)", cxxopts::value<size_t>())
+        ("serve-connections", "The clients served at the same time by --serve, the others wait for a free connection", cxxopts::value<size_t>()->default_value("8"))
+        ("pipelined", "Overlap the report on each generation with the variation of the next one", cxxopts::value<bool>()->default_value("false"))
+        ("cost-aware-scheduling", "Evaluate the offspring longest first, with dynamic load balancing (basic offspring generator only)", cxxopts::value<bool>()->default_value("false"))
+        ("stagnation-window", "Stop when the best error (operon_gp) or the hypervolume of the first front (operon_nsgp) improved by at most the stagnation threshold over this many generations (0 disables it)", cxxopts::value<size_t>()->default_value("0"))
+        ("stagnation-threshold", "The improvement over the stagnation window below which the run stops", cxxopts::value<double>()->default_value("0"))
+        ("affinity", "Bind the worker threads to cores or numa nodes (none, cores, numa)", cxxopts::value<std::string>()->default_value("none"))
+        ("huge-pages", "Back the datasets, the packed inputs and the optimizer workspaces by 2 MiB pages (none, transparent, explicit)", cxxopts::value<std::string>()->default_value("none"))
+        ("profile", "Print the time spent in the stages of the main loop and in the operators (requires a build with USE_INSTRUMENTATION)", cxxopts::value<bool>()->default_value("false"))
+        ("profile-counters", "Also count the cycles, instructions, cache and branch misses of the stages, the operators and the worker threads with the linux perf events (implies --profile)", cxxopts::value<bool>()->default_value("false"))
+        ("interpreter-kernel", "Evaluate with the interpreter loop specialized for a primitive set (auto, generic, arithmetic, type-coherent, full), auto picks the smallest one containing the enabled symbols", cxxopts::value<std::string>()->default_value("auto"))
+        ("profile-primitives", "Print the time spent in every primitive of the interpreter (requires a build with USE_INSTRUMENTATION, slows down the evaluation)", cxxopts::value<bool>()->default_value("false"))
+        ("memory-limit", "Soft limit on the accounted memory in MiB: over it the subtree caches evict and the evaluation buffers shrink (0: no limit)", cxxopts::value<size_t>()->default_value("0"))
+        ("metrics", "Append the metrics of every generation to this file (json lines)", cxxopts::value<std::string>())
+        ("population-log", "Write the parents of every generation to this file, delta encoded against the previous generation (see Serialization::DeltaEncoder)", cxxopts::value<std::string>())
+        ("population-log-precision", "Precision of the node values in the population log (exact, single or bfloat16)", cxxopts::value<std::string>()->default_value("single"))
+        ("metrics-prometheus", "Keep the latest metrics in this file in the prometheus text format (e.g. for the textfile collector of the node exporter)", cxxopts::value<std::string>())
+        ("trace", "Write the tasks run by the worker threads to this file (chrome trace format, viewable in chrome://tracing or ui.perfetto.dev)", cxxopts::value<std::string>())
+        ("checkpoint", "Save the state of the run to this file every checkpoint-interval generations (written in the background)", cxxopts::value<std::string>())
+        ("checkpoint-interval", "Number of generations between two checkpoints", cxxopts::value<size_t>()->default_value("10"))
+        ("resume", "Continue the run saved in this checkpoint (requires the same data and parameters)", cxxopts::value<std::string>())
+        ("replicate-dataset", "Keep a copy of the dataset on every numa node, read by the workers bound to the node (see --affinity numa)", cxxopts::value<bool>()->default_value("false"))
+        ("pack-inputs", "Evaluate on a copy of the input variables laid out in row tiles of one interpreter batch (faster on wide datasets)", cxxopts::value<bool>()->default_value("false"))
+        ("pareto-archive", "Keep the epsilon-non-dominated models of the whole run and write them to this model archive at the end (NSGA2 only)", cxxopts::value<std::string>())
+        ("archive-epsilon", "Box size of the pareto archive, one value for all the objectives or a comma-separated list with one per objective", cxxopts::value<std::string>()->default_value("0.001"))
+        ("hypervolume", "Rank the individuals of each front by their hypervolume contribution instead of the crowding distance (NSGA2 only)", cxxopts::value<bool>()->default_value("false"))
         ("reinserter", "Reinsertion operator merging offspring in the recombination pool back into the population", cxxopts::value<std::string>()->default_value("keep-best"))
         ("enable-symbols", "Comma-separated list of enabled symbols ("+symbols+")", cxxopts::value<std::string>())
         ("disable-symbols", "Comma-separated list of disabled symbols ("+symbols+")", cxxopts::value<std::string>())
+        ("plugin", "Comma-separated list of primitive plugins (shared libraries, see operon/interpreter/plugin.h) whose primitives are added to the primitive set", cxxopts::value<std::string>())
         ("symbolic", "Operate in symbolic mode - no coefficient tuning or coefficient mutation", cxxopts::value<bool>()->default_value("false"))
         ("show-primitives", "Display the primitive set used by the algorithm")
         ("threads", "Number of threads to use for parallelism", cxxopts::value<size_t>()->default_value("0"))
@@ -211,4 +367,22 @@ auto ParseOptions(cxxopts::Options&& opts, int argc, char** argv) -> cxxopts::Pa
     }
     return result;
 }
+auto ParseArguments(cxxopts::Options&& opts, std::vector<std::string> args) -> cxxopts::ParseResult
+{
+    std::vector<char*> ptrs;
+    ptrs.reserve(args.size());
+    for (auto& a : args) { ptrs.push_back(a.data()); }
+    auto argc = static_cast<int>(ptrs.size());
+    auto* argv = ptrs.data();
+    cxxopts::ParseResult result;
+    try {
+        result = opts.parse(argc, argv);
+    } catch (cxxopts::OptionParseException const& ex) {
+        throw std::runtime_error(ex.what());
+    }
+    if (result.count("target") == 0) { throw std::runtime_error("no target variable was specified"); }
+    if (result.count("dataset") == 0) { throw std::runtime_error("no dataset was specified"); }
+    return result;
+}
+
 } // namespace Operon
@@ -5,10 +5,12 @@
 #define OPERON_CLI_UTIL_HPP
 
 #include <charconv>
+#include <cstdio>
 #include <chrono>
 #include <fmt/core.h>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include <cxxopts.hpp>
 
@@ -16,6 +18,13 @@
 
 namespace Operon {
 
+class Dataset;
+class Tree;
+
+namespace Serialization {
+enum class Precision : uint8_t;
+} // namespace Serialization
+
 constexpr int optionsWidth = 200;
 
 auto ParseRange(std::string const& str) -> std::pair<size_t, size_t>;
@@ -23,11 +32,24 @@ auto Split(const std::string& s, char delimiter) -> std::vector<std::string>;
 auto FormatBytes(size_t bytes) -> std::string;
 auto FormatDuration(std::chrono::duration<double> d) -> std::string;
 auto ParsePrimitiveSetConfig(const std::string& options) -> NodeType;
+// the primitives of the interpreter kernel (see GenericInterpreter::SetKernel), auto uses the enabled primitives
+auto ParseKernel(std::string const& name, PrimitiveSetConfig config) -> PrimitiveSetConfig;
 auto PrintPrimitives(PrimitiveSetConfig config) -> void;
-auto PrintStats(std::vector<std::tuple<std::string, double, std::string>> const& stats, bool printHeader = true) -> void;
+auto PrintStats(std::vector<std::tuple<std::string, double, std::string>> const& stats, bool printHeader = true, std::FILE* out = stdout) -> void;
+// prints the stage and operator timings recorded so far (see Instrumentation) to stderr
+auto PrintProfile() -> void;
+// the time spent in the primitives of the interpreter, by decreasing time
+auto PrintPrimitiveProfile() -> void;
+// the model in the units of the original inputs, undoing the transforms of the dataset columns (see Dataset::Preprocess)
+auto RestoreInputs(Operon::Tree const& tree, Operon::Dataset const& dataset) -> Operon::Tree;
+// exact, single or bfloat16 (see Serialization::Precision)
+auto ParsePrecision(std::string const& name) -> Serialization::Precision;
 
 auto InitOptions(std::string const& name, std::string const& desc, int width = optionsWidth) -> cxxopts::Options;
 auto ParseOptions(cxxopts::Options&& opts, int argc, char** argv) -> cxxopts::ParseResult;
+// parses the arguments of a request (e.g. a line of a batch file or of the service mode, the first one being the
+// program name), the errors are thrown instead of ending the process
+auto ParseArguments(cxxopts::Options&& opts, std::vector<std::string> args) -> cxxopts::ParseResult;
 
 } // namespace Operon
 #endif
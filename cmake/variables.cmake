@@ -13,12 +13,24 @@ if(PROJECT_IS_TOP_LEVEL)
   set(JEMALLOC_DESCRIPTION             "Link against jemalloc, a general purpose malloc(3) implementation that emphasizes fragmentation avoidance and scalable concurrency support [default=OFF].")
   set(USE_SINGLE_PRECISION_DESCRIPTION "Perform model evaluation using floats (single precision) instead of doubles. Great for reducing runtime, might not be appropriate for all purposes [default=OFF].")
   set(USE_CERES_NNLS_DESCRIPTION       "Use the non-linear least squares optimizer from Ceres solver to tune model coefficients (if OFF, Eigen::LevenbergMarquardt will be used instead).")
+  set(USE_ARROW_DESCRIPTION            "Read parquet files using Apache Arrow [default=OFF].")
+  set(USE_VECTORIZED_MATH_DESCRIPTION  "Evaluate the transcendental primitives using the explicit SIMD kernels from vectorclass, x86 only (if OFF, Eigen array expressions will be used instead) [default=OFF].")
+  set(USE_INSTRUMENTATION_DESCRIPTION  "Record the wall and cpu times of the algorithm stages and of the operators (see operon/core/instrumentation.hpp) [default=OFF].")
+  set(USE_JIT_DESCRIPTION              "Compile long trees evaluated on many rows to native code with the system C compiler (see operon/interpreter/jit.hpp) [default=OFF].")
+  set(SVE_VECTOR_BITS_DESCRIPTION      "Vector length in bits of the SVE units of the ARM target, the portable SIMD kernels are compiled for SVE if it is set (if 0, NEON is used instead) [default=0].")
+  set(INTERPRETER_BATCH_BYTES_DESCRIPTION "Capacity in bytes of the interpreter batch columns, the rows per batch times the size of the value type (see operon/interpreter/dispatch_table.hpp) [default=512].")
   
   # option descriptions
   option(USE_OPENLIBM         ${OPENLIBM_DESCRIPTION}             ON)
   option(USE_JEMALLOC         ${JEMALLOC_DESCRIPTION}             OFF)
   option(USE_SINGLE_PRECISION ${USE_SINGLE_PRECISION_DESCRIPTION} ON)
   option(USE_CERES_NNLS       ${USE_CERES_NNLS_DESCRIPTION}       OFF)
+  option(USE_VECTORIZED_MATH  ${USE_VECTORIZED_MATH_DESCRIPTION}  OFF)
+  option(USE_ARROW            ${USE_ARROW_DESCRIPTION}            OFF)
+  option(USE_INSTRUMENTATION  ${USE_INSTRUMENTATION_DESCRIPTION}  OFF)
+  option(USE_JIT              ${USE_JIT_DESCRIPTION}              OFF)
+  set(INTERPRETER_BATCH_BYTES 512 CACHE STRING ${INTERPRETER_BATCH_BYTES_DESCRIPTION})
+  set(SVE_VECTOR_BITS 0 CACHE STRING ${SVE_VECTOR_BITS_DESCRIPTION})
   
   # provide a summary of configured options
   include(FeatureSummary)
@@ -26,6 +38,10 @@ if(PROJECT_IS_TOP_LEVEL)
   add_feature_info(USE_JEMALLOC         USE_JEMALLOC         ${JEMALLOC_DESCRIPTION})
   add_feature_info(USE_SINGLE_PRECISION USE_SINGLE_PRECISION ${USE_SINGLE_PRECISION_DESCRIPTION})
   add_feature_info(USE_CERES_NNLS       USE_CERES_NNLS       ${USE_CERES_NNLS_DESCRIPTION})
+  add_feature_info(USE_VECTORIZED_MATH  USE_VECTORIZED_MATH  ${USE_VECTORIZED_MATH_DESCRIPTION})
+  add_feature_info(USE_ARROW            USE_ARROW            ${USE_ARROW_DESCRIPTION})
+  add_feature_info(USE_INSTRUMENTATION  USE_INSTRUMENTATION  ${USE_INSTRUMENTATION_DESCRIPTION})
+  add_feature_info(USE_JIT              USE_JIT              ${USE_JIT_DESCRIPTION})
   set(CMAKE_EXPORT_COMPILE_COMMANDS ON CACHE INTERNAL "")
   if(CMAKE_EXPORT_COMPILE_COMMANDS)
     set(CMAKE_CXX_STANDARD_INCLUDE_DIRECTORIES ${CMAKE_CXX_IMPLICIT_INCLUDE_DIRECTORIES})
@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_ASYNC_GP_HPP
+#define OPERON_ASYNC_GP_HPP
+
+#include <atomic>                          // for atomic
+#include <cstddef>                         // for size_t
+#include <functional>                      // for reference_wrapper, function
+#include <mutex>                           // for mutex
+#include <shared_mutex>                    // for shared_mutex
+#include <operon/operon_export.hpp>        // for OPERON_EXPORT
+#include <vector>                          // for vector
+#include "operon/algorithms/config.hpp"    // for GeneticAlgorithmConfig
+#include "operon/core/individual.hpp"      // for Individual
+#include "operon/core/types.hpp"           // for Span, Vector, RandomGenerator
+#include "operon/operators/generator.hpp"  // for OffspringGeneratorBase
+
+// forward declaration
+namespace tf { class Executor; }
+
+namespace Operon {
+
+class Problem;
+struct CoefficientInitializerBase;
+struct TreeInitializerBase;
+
+// asynchronous steady-state GP: there are no generation barriers, every worker of the executor repeatedly selects
+// parents by tournament, applies the variation operators of the generator, evaluates the child and inserts it in place
+// of the worst individual of a replacement tournament (if the child is better, on the first objective).
+// - every individual is guarded by its own lock, which is only held while the individual is copied or replaced,
+//   so selection, variation and evaluation of different workers overlap freely
+// - a generation corresponds to PoolSize insertion attempts, the report callback is invoked once per generation while
+//   the population is locked (so it can read Parents() safely)
+class OPERON_EXPORT AsyncGeneticProgrammingAlgorithm {
+    std::reference_wrapper<const Problem> problem_;
+    std::reference_wrapper<const GeneticAlgorithmConfig> config_;
+
+    std::reference_wrapper<const TreeInitializerBase> treeInit_;
+    std::reference_wrapper<const CoefficientInitializerBase> coeffInit_;
+    std::reference_wrapper<const OffspringGeneratorBase> generator_;
+
+    Operon::Vector<Individual> individuals_;
+    std::vector<std::mutex> locks_;
+    std::shared_mutex populationLock_; // held exclusively while reporting
+
+    size_t selectionSize_;
+    size_t replacementSize_;
+
+    std::atomic_size_t attempts_{0}; // number of offspring which competed for a place in the population
+    std::atomic_size_t generation_{0};
+
+public:
+    static constexpr size_t DefaultTournamentSize = 5;
+
+    explicit AsyncGeneticProgrammingAlgorithm(Problem const& problem, GeneticAlgorithmConfig const& config, TreeInitializerBase const& treeInit, CoefficientInitializerBase const& coeffInit, OffspringGeneratorBase const& generator, size_t selectionSize = DefaultTournamentSize, size_t replacementSize = DefaultTournamentSize)
+        : problem_(problem)
+        , config_(config)
+        , treeInit_(treeInit)
+        , coeffInit_(coeffInit)
+        , generator_(generator)
+        , individuals_(config.PopulationSize)
+        , locks_(config.PopulationSize)
+        , selectionSize_(selectionSize)
+        , replacementSize_(replacementSize)
+    {
+    }
+
+    [[nodiscard]] auto Parents() const -> Operon::Span<Individual const> { return { individuals_.data(), individuals_.size() }; }
+    // there is no separate offspring pool, the children are inserted directly into the population
+    [[nodiscard]] auto Offspring() const -> Operon::Span<Individual const> { return {}; }
+
+    [[nodiscard]] auto GetProblem() const -> const Problem& { return problem_.get(); }
+    [[nodiscard]] auto GetConfig() const -> const GeneticAlgorithmConfig& { return config_.get(); }
+
+    [[nodiscard]] auto GetTreeInitializer() const -> TreeInitializerBase const& { return treeInit_.get(); }
+    [[nodiscard]] auto GetCoefficientInitializer() const -> CoefficientInitializerBase const& { return coeffInit_.get(); }
+    [[nodiscard]] auto GetGenerator() const -> const OffspringGeneratorBase& { return generator_.get(); }
+
+    [[nodiscard]] auto Generation() const -> size_t { return generation_; }
+
+    void Reset()
+    {
+        generation_ = 0;
+        attempts_ = 0;
+        generator_.get().Evaluator().Reset();
+    }
+
+    auto Run(tf::Executor& /*executor*/, Operon::RandomGenerator&/*rng*/, std::function<void()> /*report*/ = nullptr) -> void;
+    auto Run(Operon::RandomGenerator& /*rng*/, std::function<void()> /*report*/ = nullptr, size_t /*threads*/= 0) -> void;
+};
+} // namespace Operon
+
+#endif
@@ -0,0 +1,74 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_BATCH_HPP
+#define OPERON_BATCH_HPP
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "operon/operon_export.hpp"
+
+// forward declaration
+namespace tf { class Executor; }
+
+namespace Operon {
+
+// runs many independent algorithms (GeneticProgrammingAlgorithm, NSGA2, ...) concurrently on one executor, e.g. the
+// configurations of a hyperparameter sweep or the seeds of a repeated experiment
+// - a job builds its algorithm and runs it on the executor it receives, returning a summary of the run. building the
+//   operators inside the job only keeps the runs in progress in memory. the problems of the jobs can share one
+//   read-only dataset through views (see Dataset::View), each job needs its own operators
+// - at most Concurrency jobs are in progress, the others wait and start in the order they were added as soon as a job
+//   finishes. the workers of the executor steal the tasks of all the jobs in progress, so the generations of the
+//   concurrent runs are interleaved and a job waiting at a sequential step leaves its workers to the others
+// - the jobs are driven by lightweight threads which only wait for their taskflows (see IslandModel)
+// - an exception thrown by a job ends that job only, its message is kept in the result
+class OPERON_EXPORT BatchRunner {
+public:
+    // named values describing the outcome of a run (e.g. the test error of the best model)
+    using Summary = std::vector<std::pair<std::string, double>>;
+    using Job = std::function<Summary(tf::Executor&)>;
+
+    struct Result {
+        size_t Index{0};    // of the job, in the order they were added
+        double Elapsed{0};  // wall clock seconds from the start to the end of the job
+        Summary Values;
+        std::string Error;  // empty if the job succeeded
+
+        [[nodiscard]] auto Succeeded() const -> bool { return Error.empty(); }
+    };
+
+    // with zero as many jobs run concurrently as the executor has workers
+    explicit BatchRunner(size_t concurrency = 0)
+        : concurrency_(concurrency)
+    {
+    }
+
+    auto Add(Job job) -> size_t
+    {
+        jobs_.push_back(std::move(job));
+        return jobs_.size() - 1;
+    }
+
+    [[nodiscard]] auto Size() const -> size_t { return jobs_.size(); }
+    [[nodiscard]] auto Concurrency() const -> size_t { return concurrency_; }
+
+    // runs all the jobs and returns their results in the order of the jobs. the callback receives every result as
+    // soon as its job finished, it is called concurrently by the driving threads
+    auto Run(tf::Executor& executor, std::function<void(Result const&)> done = nullptr) const -> std::vector<Result>;
+
+    // the mean of every value over the successful results (in the order of first appearance)
+    [[nodiscard]] static auto Mean(std::vector<Result> const& results) -> Summary;
+
+private:
+    size_t concurrency_;
+    std::vector<Job> jobs_;
+};
+
+} // namespace Operon
+
+#endif
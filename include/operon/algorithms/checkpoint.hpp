@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_CHECKPOINT_HPP
+#define OPERON_CHECKPOINT_HPP
+
+#include <cstddef>                     // for size_t, byte
+#include <future>                      // for future
+#include <string>                      // for string
+#include <vector>                      // for vector
+#include "operon/core/individual.hpp"  // for Individual
+#include "operon/core/types.hpp"       // for Span, RandomGenerator
+#include "operon/operon_export.hpp"    // for OPERON_EXPORT
+
+namespace Operon {
+
+// the state of an algorithm between two generations, besides its individuals
+struct CheckpointState {
+    size_t Generation{0};
+    size_t ResidualEvaluations{0};
+    size_t JacobianEvaluations{0};
+    size_t EvaluationCount{0};
+    size_t Fronts{0}; // number of fronts of the last non-dominated sort (NSGA2)
+    uint64_t StreamSeed{0}; // the seed of the task streams of the algorithm (see Random::Stream)
+    // the generator passed to Run
+    std::vector<Operon::RandomGenerator::state_type> RandomStates;
+};
+
+// binary checkpoints of a run (see GeneticProgrammingAlgorithm::SaveState, NSGA2::SaveState)
+// - the genotypes are stored as a shared forest (see SharedForest), each distinct subtree once with its nodes as they
+//   are in memory, followed by the fitness, rank and distance of the individuals, so a restored run continues bit for bit
+// - the values are written in the native layout and byte order: the checkpoint can only be restored by the same build,
+//   which is checked by the header
+namespace Checkpoint {
+    [[nodiscard]] auto OPERON_EXPORT Encode(CheckpointState const& state, Operon::Span<Individual const> individuals) -> std::vector<std::byte>;
+    // decodes the state and returns the individuals
+    [[nodiscard]] auto OPERON_EXPORT Decode(Operon::Span<std::byte const> buffer, CheckpointState& state) -> std::vector<Individual>;
+
+    // the file is replaced atomically (the buffer is written to a temporary file which is then renamed)
+    auto OPERON_EXPORT Save(Operon::Span<std::byte const> buffer, std::string const& path) -> void;
+    [[nodiscard]] auto OPERON_EXPORT Load(std::string const& path) -> std::vector<std::byte>;
+} // namespace Checkpoint
+
+// writes the checkpoints in the background, so the run continues while a (large) checkpoint goes to disk
+class OPERON_EXPORT CheckpointWriter {
+    std::future<void> pending_;
+
+public:
+    CheckpointWriter() = default;
+    CheckpointWriter(CheckpointWriter const&) = delete;
+    CheckpointWriter(CheckpointWriter&&) = delete;
+    auto operator=(CheckpointWriter const&) -> CheckpointWriter& = delete;
+    auto operator=(CheckpointWriter&&) -> CheckpointWriter& = delete;
+    ~CheckpointWriter();
+
+    // waits for the previous write to finish, then starts writing the buffer
+    auto Write(std::vector<std::byte> buffer, std::string path) -> void;
+    // waits for the pending write and rethrows its error, if any
+    auto Wait() -> void;
+};
+
+} // namespace Operon
+
+#endif
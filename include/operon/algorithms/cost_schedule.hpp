@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_COST_SCHEDULE_HPP
+#define OPERON_COST_SCHEDULE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "operon/core/individual.hpp"
+#include "operon/core/types.hpp"
+#include "operon/operon_export.hpp"
+
+// forward declaration
+namespace tf { class Executor; class Subflow; }
+
+namespace Operon {
+
+class OffspringGeneratorBase;
+
+// cost-aware generation (for separable generators): the offspring are created first, variation being cheap, and
+// then evaluated in the order of their estimated cost, longest first, by one task per worker which pulls the next
+// offspring from a shared counter. the short evaluations at the end fill the gaps left by the long ones, which
+// shrinks the tail of the generation (see GeneticProgrammingAlgorithm and NSGA2, SetCostAware)
+class OPERON_EXPORT CostSchedule {
+public:
+    // called by the evaluating worker with every evaluated offspring
+    using Callback = std::function<void(Individual const&)>;
+
+    // the streams of the tasks (see Random::Stream) and the evaluation buffers of the workers
+    struct Context {
+        uint64_t Seed{0};
+        size_t Generation{0}; // the offspring of generation g use the streams of generation g + 1
+        double CrossoverProbability{0};
+        double MutationProbability{0};
+        std::vector<Operon::Vector<Operon::Scalar>>* Slots{nullptr}; // one per worker, not owned
+    };
+
+    // adds the tasks generating and evaluating the offspring [first, target.size()) to the subflow. the previous
+    // occupants of the slots are released, and terminate is set once the generator reports that the budget is spent
+    // (the offspring not generated by then are left empty)
+    auto Generate(tf::Executor& executor, tf::Subflow& subflow, OffspringGeneratorBase const& generator, Context const& context,
+        Operon::Span<Individual> target, size_t first, std::atomic_bool& terminate, Callback evaluated) -> void;
+
+private:
+    std::vector<size_t> order_;
+    std::vector<double> cost_;
+    std::atomic_size_t next_{0};
+};
+
+} // namespace Operon
+
+#endif
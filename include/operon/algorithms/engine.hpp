@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_ENGINE_HPP
+#define OPERON_ENGINE_HPP
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "operon/core/types.hpp"
+#include "operon/operon_export.hpp"
+
+// forward declaration
+namespace tf { class Executor; }
+
+namespace Operon {
+
+// the resources of the runs which outlive them, for workloads of many short runs (e.g. many small problems, each with
+// its own algorithm): the executor and the per-worker evaluation buffers, which only grow. the worker threads are
+// started once, and with them their node pools (see NodePool) and the thread local scratch space of the operators stay
+// warm from one run to the next. the graph of a run is rebuilt by Run, it is a handful of tasks (the generations are
+// dynamic subflows, rebuilt at every generation in any case)
+// - GeneticProgrammingAlgorithm::Run(Engine&, ...) and NSGA2::Run(Engine&, ...) use the engine, the per-run state of an
+//   algorithm is reset by its Reset method as before
+// - the runs of an engine must not overlap (they share the buffers), use the executor overloads of Run for concurrent
+//   runs (see BatchRunner)
+class OPERON_EXPORT Engine {
+public:
+    // with zero threads one per hardware thread
+    explicit Engine(size_t threads = 0);
+    Engine(Engine const&) = delete;
+    Engine(Engine&&) = delete;
+    auto operator=(Engine const&) -> Engine& = delete;
+    auto operator=(Engine&&) -> Engine& = delete;
+    ~Engine();
+
+    [[nodiscard]] auto Executor() -> tf::Executor& { return *executor_; }
+    // the evaluation buffer of every worker
+    [[nodiscard]] auto Buffers() -> std::vector<Operon::Vector<Operon::Scalar>>& { return buffers_; }
+    [[nodiscard]] auto Workers() const -> size_t { return buffers_.size(); }
+
+private:
+    std::unique_ptr<tf::Executor> executor_;
+    std::vector<Operon::Vector<Operon::Scalar>> buffers_;
+};
+
+} // namespace Operon
+
+#endif
@@ -4,12 +4,13 @@
 #ifndef GP_HPP
 #define GP_HPP
 
-#include <cstddef>                         // for size_t
+#include <cstddef>                         // for size_t, byte
 #include <functional>                      // for reference_wrapper, function
 #include <nonstd/span.hpp>                 // for span<>::pointer
 #include <operon/operon_export.hpp>        // for OPERON_EXPORT
 #include <thread>                          // for thread
 #include <utility>                         // for move
+#include <vector>                          // for vector
 #include "operon/algorithms/config.hpp"    // for GeneticAlgorithmConfig
 #include "operon/core/individual.hpp"      // for Individual
 #include "operon/core/types.hpp"           // for Span, Vector, RandomGenerator
@@ -21,8 +22,11 @@ namespace tf { class Executor; }
 
 namespace Operon {
 
+class Engine;
+class ModelArchive;
 class Problem;
 class ReinserterBase;
+class TerminationCriterion;
 struct CoefficientInitializerBase;
 struct TreeInitializerBase;
 
@@ -38,8 +42,19 @@ class OPERON_EXPORT GeneticProgrammingAlgorithm {
     Operon::Vector<Individual> individuals_;
     Operon::Span<Individual> parents_;
     Operon::Span<Individual> offspring_;
+    Operon::Span<Individual> spare_; // second offspring buffer, used by the pipelined loop
 
     size_t generation_;
+    bool pipelined_{false};
+    bool costAware_{false};
+    bool restored_{false}; // the next run continues from a checkpoint
+    ModelArchive const* seeds_{nullptr};
+    TerminationCriterion* termination_{nullptr};
+
+    uint64_t seed_{0}; // the seed of the task streams, drawn at the start of a run
+
+    // the run on the executor with (at least) one evaluation buffer per worker
+    auto Run(tf::Executor& executor, std::vector<Operon::Vector<Operon::Scalar>>& slots, Operon::RandomGenerator& random, std::function<void()> report) -> void;
 
 public:
     explicit GeneticProgrammingAlgorithm(Problem const& problem, GeneticAlgorithmConfig const& config, TreeInitializerBase const& treeInit, CoefficientInitializerBase const& coeffInit, OffspringGeneratorBase const& generator, ReinserterBase const& reinserter)
@@ -57,6 +72,8 @@ public:
     }
 
     [[nodiscard]] auto Parents() const -> Operon::Span<Individual const> { return { parents_.data(), parents_.size() }; }
+    // mutable access for the island model, which exchanges individuals between generations
+    [[nodiscard]] auto Parents() -> Operon::Span<Individual> { return parents_; }
     [[nodiscard]] auto Offspring() const -> Operon::Span<Individual const> { return { offspring_.data(), offspring_.size() }; }
 
     [[nodiscard]] auto GetProblem() const -> const Problem& { return problem_.get(); }
@@ -69,13 +86,45 @@ public:
 
     [[nodiscard]] auto Generation() const -> size_t { return generation_; }
 
+    // overlap the report on a generation with the variation of the next one (the offspring are generated into a
+    // second buffer, which is swapped in before reinsertion). the report callback must only read the state of the
+    // algorithm, it may be invoked while the offspring of the next generation are being evaluated.
+    void SetPipelined(bool value) { pipelined_ = value; }
+    [[nodiscard]] auto Pipelined() const -> bool { return pipelined_; }
+
+    // evaluate the offspring longest first (see EvaluatorBase::Cost), with dynamic load balancing between the workers
+    // (only for separable generators, see OffspringGeneratorBase::Separable)
+    void SetCostAwareScheduling(bool value) { costAware_ = value; }
+    [[nodiscard]] auto CostAwareScheduling() const -> bool { return costAware_; }
+
     void Reset()
     {
         generation_ = 0;
         generator_.get().Evaluator().Reset();
     }
 
+    // the state of the run as a binary checkpoint (see Checkpoint): the individuals, the generation, the evaluation
+    // counters, the random generator and the seed of the task streams. it has to be taken between two generations, eg.
+    // from the report callback (unless the loop is pipelined) or after Run returned.
+    [[nodiscard]] auto SaveState(Operon::RandomGenerator const& random) const -> std::vector<std::byte>;
+    // restores a checkpoint of an algorithm with the same configuration, the next call to Run (with the same random
+    // generator) continues the checkpointed run exactly. the evaluator caches are not part of the checkpoint and the
+    // time limit counts from the restart.
+    auto RestoreState(Operon::Span<std::byte const> buffer, Operon::RandomGenerator& random) -> void;
+
+    // the first individuals of the initial population are the models of the archive (e.g. the front of an earlier run,
+    // remapped to the variables of the problem) instead of random trees. the archive must outlive the runs
+    auto SetSeeds(ModelArchive const* seeds) -> void { seeds_ = seeds; }
+    [[nodiscard]] auto Seeds() const -> ModelArchive const* { return seeds_; }
+
+    // an additional termination criterion (e.g. FitnessStagnation), checked after the initialization and after every
+    // generation. it is reset at the start of every run (including a restored one) and must outlive the runs
+    auto SetTermination(TerminationCriterion* termination) -> void { termination_ = termination; }
+    [[nodiscard]] auto Termination() const -> TerminationCriterion* { return termination_; }
+
     auto Run(tf::Executor& /*executor*/, Operon::RandomGenerator&/*rng*/, std::function<void()> /*report*/ = nullptr) -> void;
+    // reuses the executor and the evaluation buffers of the engine (see Engine)
+    auto Run(Engine& /*engine*/, Operon::RandomGenerator&/*rng*/, std::function<void()> /*report*/ = nullptr) -> void;
     auto Run(Operon::RandomGenerator& /*rng*/, std::function<void()> /*report*/ = nullptr, size_t /*threads*/= 0) -> void;
 };
 } // namespace Operon
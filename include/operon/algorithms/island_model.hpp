@@ -0,0 +1,178 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_ISLAND_MODEL_HPP
+#define OPERON_ISLAND_MODEL_HPP
+
+#include <algorithm>                          // for stable_sort, transform
+#include <atomic>                             // for atomic_size_t
+#include <cstddef>                            // for size_t
+#include <functional>                         // for reference_wrapper, function
+#include <limits>                             // for numeric_limits
+#include <memory>                             // for unique_ptr
+#include <numeric>                            // for iota
+#include <random>                             // for uniform_int_distribution
+#include <thread>                             // for thread
+#include <utility>                            // for move
+#include <vector>                             // for vector
+#include "operon/core/concurrent_queue.hpp"   // for ConcurrentQueue
+#include "operon/core/contracts.hpp"          // for EXPECT
+#include "operon/core/individual.hpp"         // for Individual, KeyCallback
+#include "operon/core/node_pool.hpp"          // for NodePool
+#include "operon/core/types.hpp"              // for RandomGenerator
+
+// forward declaration
+namespace tf { class Executor; }
+
+namespace Operon {
+
+enum class MigrationTopology {
+    Ring,  // island k sends its emigrants to island k + 1
+    Random // every migration goes to an island chosen uniformly among the others
+};
+
+struct IslandModelConfig {
+    size_t MigrationInterval; // number of generations between migrations
+    size_t MigrationSize;     // number of emigrants per migration
+    MigrationTopology Topology;
+};
+
+// runs several instances of an algorithm (GeneticProgrammingAlgorithm, NSGA2) side by side on the same executor
+// - the islands are constructed by the caller, they can share the (read-only) problem and dataset but each of them
+//   needs its own generator: selectors and evaluators keep per-population state
+// - every MigrationInterval generations an island copies its best individuals into the queue of the target island and
+//   replaces its worst individuals with the immigrants waiting in its own queue. the queues are lock-free and bounded,
+//   emigrants which do not fit are dropped, so a slow island never holds back a fast one
+// - best and worst are given by the key (eg. ObjectiveKey(0) for GP, CrowdedKey() for NSGA2). migration happens in
+//   the report step, after reinsertion: for NSGA2 the worst individuals belong to the last front and the immigrants
+//   are ranked again (as if they were offspring) at the next non-dominated sort
+namespace detail {
+    // the indices of the individuals from best to worst
+    inline auto MigrationOrder(Operon::Span<Individual const> pop, KeyCallback const& key) -> std::vector<size_t>
+    {
+        std::vector<ComparisonKey> keys(pop.size());
+        std::vector<size_t> idx(pop.size());
+        std::transform(pop.begin(), pop.end(), keys.begin(), key);
+        std::iota(idx.begin(), idx.end(), size_t{0});
+        std::stable_sort(idx.begin(), idx.end(), [&](auto a, auto b) { return keys[a] < keys[b]; });
+        return idx;
+    }
+
+    // the immigrant takes the place of the individual, its rank is unknown until the next non-dominated sort
+    inline auto Replace(Individual& ind, Individual&& immigrant) -> void
+    {
+        NodePool::Release(std::move(ind.Genotype));
+        ind = std::move(immigrant);
+        ind.Rank = std::numeric_limits<size_t>::max();
+        ind.Distance = 0;
+    }
+} // namespace detail
+
+template<typename Algorithm>
+class IslandModel {
+    std::vector<std::reference_wrapper<Algorithm>> islands_;
+    IslandModelConfig config_;
+    KeyCallback key_;
+
+    std::vector<std::unique_ptr<ConcurrentQueue<Individual>>> queues_;
+    std::atomic_size_t migrants_{0};
+
+    auto Target(size_t island, Operon::RandomGenerator& random) const -> size_t
+    {
+        auto const n = islands_.size();
+        if (config_.Topology == MigrationTopology::Ring) { return (island + 1) % n; }
+        auto t = std::uniform_int_distribution<size_t>(0, n - 2)(random);
+        return t < island ? t : t + 1; // any island but this one
+    }
+
+    auto Migrate(size_t island, Operon::RandomGenerator& random) -> void
+    {
+        auto pop = islands_[island].get().Parents();
+        auto const n = pop.size();
+        auto const count = std::min(config_.MigrationSize, n);
+        auto idx = detail::MigrationOrder({ pop.data(), pop.size() }, key_);
+
+        auto& target = *queues_[Target(island, random)];
+        for (size_t i = 0; i < count; ++i) {
+            auto const& ind = pop[idx[i]];
+            Individual emigrant(ind.Size());
+            emigrant.Genotype = NodePool::Copy(ind.Genotype);
+            emigrant.Fitness = ind.Fitness;
+            if (!target.TryPush(emigrant)) {
+                NodePool::Release(std::move(emigrant.Genotype));
+                break;
+            }
+        }
+
+        // the immigrants take the places of the worst individuals
+        auto& queue = *queues_[island];
+        for (size_t i = 0; i < n; ++i) {
+            auto immigrant = queue.TryPop();
+            if (!immigrant) { break; }
+            detail::Replace(pop[idx[n - 1 - i]], std::move(immigrant.value()));
+            ++migrants_;
+        }
+    }
+
+public:
+    IslandModel(std::vector<std::reference_wrapper<Algorithm>> islands, IslandModelConfig config, KeyCallback key)
+        : islands_(std::move(islands))
+        , config_(config)
+        , key_(std::move(key))
+    {
+        EXPECT(!islands_.empty());
+        EXPECT(config_.MigrationInterval > 0);
+        auto const capacity = std::max(config_.MigrationSize, size_t{1}) * islands_.size();
+        for (size_t i = 0; i < islands_.size(); ++i) {
+            queues_.push_back(std::make_unique<ConcurrentQueue<Individual>>(capacity));
+        }
+    }
+
+    [[nodiscard]] auto Size() const -> size_t { return islands_.size(); }
+    [[nodiscard]] auto Island(size_t i) const -> Algorithm const& { return islands_[i].get(); }
+    [[nodiscard]] auto GetConfig() const -> IslandModelConfig const& { return config_; }
+
+    // total number of immigrants which were received by the islands
+    [[nodiscard]] auto Migrants() const -> size_t { return migrants_; }
+
+    // the report callback receives the index of the island, it is called concurrently by different islands
+    auto Run(tf::Executor& executor, Operon::RandomGenerator& random, std::function<void(size_t)> report = nullptr) -> void
+    {
+        auto const n = islands_.size();
+        for (auto const& island : islands_) {
+            EXPECT(!island.get().Pipelined()); // the migration writes the parents from the report step
+        }
+        std::vector<Operon::RandomGenerator> rngs;
+        std::vector<Operon::RandomGenerator> migration;
+        for (size_t i = 0; i < n; ++i) {
+            rngs.emplace_back(random());
+            migration.emplace_back(random());
+        }
+
+        // the islands submit their taskflows to the same executor, they are driven by lightweight threads which only
+        // wait for their taskflow to finish (waiting inside a worker would take the worker away from the executor)
+        std::vector<std::thread> threads;
+        threads.reserve(n);
+        for (size_t k = 0; k < n; ++k) {
+            threads.emplace_back([&, k]() {
+                auto& island = islands_[k].get();
+                island.Run(executor, rngs[k], [&, k]() {
+                    auto generation = island.Generation();
+                    if (n > 1 && generation > 0 && generation % config_.MigrationInterval == 0) {
+                        Migrate(k, migration[k]);
+                    }
+                    if (report) { std::invoke(report, k); }
+                });
+            });
+        }
+        for (auto& t : threads) { t.join(); }
+
+        // discard the migrants which were never received
+        for (auto& q : queues_) {
+            while (auto ind = q->TryPop()) { NodePool::Release(std::move(ind->Genotype)); }
+        }
+    }
+};
+} // namespace Operon
+
+#endif
@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_MODEL_REPORT_HPP
+#define OPERON_MODEL_REPORT_HPP
+
+#include <condition_variable>                 // for condition_variable
+#include <deque>                              // for deque
+#include <future>                             // for future, packaged_task
+#include <mutex>                              // for mutex
+#include <thread>                             // for thread
+#include "operon/core/problem.hpp"            // for Problem
+#include "operon/core/tree.hpp"               // for Tree
+#include "operon/core/types.hpp"              // for Scalar, Vector
+#include "operon/interpreter/interpreter.hpp" // for Interpreter
+#include "operon/operon_export.hpp"           // for OPERON_EXPORT
+
+namespace Operon {
+
+// the quality of a model on the training and the test data, after linear scaling fitted on the training data
+struct ModelStatistics {
+    double Scale{1};
+    double Offset{0};
+
+    double R2Train{0};
+    double R2Test{0};
+    double NmseTrain{0};
+    double NmseTest{0};
+    double MaeTrain{0};
+    double MaeTest{0};
+};
+
+// evaluates a model on the training and the test range of a problem and reports its statistics
+// - the tree is compiled once and both ranges are evaluated into the same buffer, which is kept between the calls
+// - the scaling, the R2 and the NMSE of both ranges are computed in closed form from the moments of the unscaled
+//   values (see Kernels::Moments), only the MAE needs another pass over the scaled values
+// - Submit runs the report on an owned worker thread with a low scheduling priority (where supported), so a report
+//   never stalls the evolutionary loop; the reports run one after another in the order they were submitted
+class OPERON_EXPORT ModelReport {
+    Problem const& problem_;
+    Interpreter const& interpreter_;
+    Operon::Vector<Operon::Scalar> buffer_; // of the reports on the calling thread, the worker has its own
+
+    std::mutex lock_;
+    std::condition_variable wake_;
+    std::deque<std::packaged_task<ModelStatistics(Operon::Vector<Operon::Scalar>&)>> tasks_;
+    bool stop_{false};
+    std::thread worker_;
+
+    auto Run() -> void;
+
+public:
+    ModelReport(Problem const& problem, Interpreter const& interpreter)
+        : problem_(problem)
+        , interpreter_(interpreter)
+    {
+    }
+
+    ModelReport(ModelReport const&) = delete;
+    ModelReport(ModelReport&&) = delete;
+    auto operator=(ModelReport const&) -> ModelReport& = delete;
+    auto operator=(ModelReport&&) -> ModelReport& = delete;
+    // finishes the submitted reports
+    ~ModelReport();
+
+    // reports on the calling thread
+    auto operator()(Tree const& tree) -> ModelStatistics;
+
+    // reports on the worker thread (started by the first call), the tree is copied
+    auto Submit(Tree tree) -> std::future<ModelStatistics>;
+};
+
+} // namespace Operon
+
+#endif
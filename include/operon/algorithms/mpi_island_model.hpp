@@ -0,0 +1,249 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_MPI_ISLAND_MODEL_HPP
+#define OPERON_MPI_ISLAND_MODEL_HPP
+
+#include <algorithm>                            // for min
+#include <cstdint>                              // for uint32_t, uint64_t
+#include <cstring>                              // for memcpy
+#include <functional>                           // for reference_wrapper, function
+#include <list>                                 // for list
+#include <mpi.h>                                // for MPI_Issend, MPI_Iprobe, ...
+#include <random>                               // for uniform_int_distribution
+#include <vector>                               // for vector
+#include "operon/algorithms/island_model.hpp"   // for IslandModelConfig, MigrationTopology
+#include "operon/core/serialization.hpp"        // for Serialization::CompactCodec
+
+namespace Operon {
+
+// the distributed counterpart of IslandModel: every MPI rank runs one island (GeneticProgrammingAlgorithm, NSGA2)
+// against its own copy of the dataset. the header is not part of the library, applications using it link MPI.
+// - migration happens in the report step every MigrationInterval generations: the best individuals are serialized
+//   (see Serialization::CompactCodec, exact values) and sent with non-blocking sends, the immigrants which have arrived in the meantime replace
+//   the worst individuals. nothing waits for the other ranks, the transfers overlap with the evaluation of the next
+//   generations
+// - evaluation budget: EvaluatorBase::Budget() is interpreted as a global budget. the ranks report their evaluation
+//   counts to rank 0, which tells all ranks to stop once the sum exceeds the budget (the termination of the islands
+//   is triggered through their evaluator, see OffspringGeneratorBase::Terminate)
+// - when its island is done a rank keeps receiving (and discarding) messages until every rank is done, using
+//   synchronous sends and a non-blocking barrier (the NBX protocol), so no message is ever left unmatched
+template<typename Algorithm>
+class MpiIslandModel {
+    enum Tag : int {
+        Migration = 1,
+        Evaluations = 2,
+        Stop = 3
+    };
+    static constexpr int Root = 0;
+
+    std::reference_wrapper<Algorithm> island_;
+    IslandModelConfig config_;
+    KeyCallback key_;
+    Serialization::CompactCodec codec_; // by the variables of the dataset, which is the same on all the ranks
+
+    MPI_Comm comm_{}; // a duplicate of the communicator, so the tags cannot collide with the messages of the application
+    int rank_{};
+    int size_{};
+
+    struct Message {
+        std::vector<std::byte> Buffer;
+        MPI_Request Request{MPI_REQUEST_NULL};
+    };
+    std::list<Message> pending_; // the buffers must stay alive (and in place) until their send completes
+
+    std::vector<uint64_t> evaluations_; // on the root: the last evaluation count reported by each rank
+    bool stop_{false};
+    size_t migrants_{0};
+    size_t globalEvaluations_{0};
+
+    auto Send(std::vector<std::byte> buffer, int target, int tag) -> void
+    {
+        auto& message = pending_.emplace_back();
+        message.Buffer = std::move(buffer);
+        MPI_Issend(message.Buffer.data(), static_cast<int>(message.Buffer.size()), MPI_BYTE, target, tag, comm_, &message.Request);
+    }
+
+    // releases the buffers of the completed sends
+    auto Progress() -> void
+    {
+        for (auto it = pending_.begin(); it != pending_.end();) {
+            int done{0};
+            MPI_Test(&it->Request, &done, MPI_STATUS_IGNORE);
+            it = done != 0 ? pending_.erase(it) : std::next(it);
+        }
+    }
+
+    // handles all the messages which have arrived
+    auto Receive(std::vector<Individual>& immigrants) -> void
+    {
+        for (;;) {
+            int flag{0};
+            MPI_Status status;
+            MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, comm_, &flag, &status);
+            if (flag == 0) { return; }
+
+            int count{0};
+            MPI_Get_count(&status, MPI_BYTE, &count);
+            std::vector<std::byte> buffer(static_cast<size_t>(count));
+            MPI_Recv(buffer.data(), count, MPI_BYTE, status.MPI_SOURCE, status.MPI_TAG, comm_, MPI_STATUS_IGNORE);
+
+            if (status.MPI_TAG == Migration) {
+                for (auto& ind : codec_.Decode({ buffer.data(), buffer.size() })) {
+                    immigrants.push_back(std::move(ind));
+                }
+            } else if (status.MPI_TAG == Evaluations) {
+                std::memcpy(&evaluations_[static_cast<size_t>(status.MPI_SOURCE)], buffer.data(), sizeof(uint64_t));
+            } else if (status.MPI_TAG == Stop) {
+                stop_ = true;
+            }
+        }
+    }
+
+    auto Target(Operon::RandomGenerator& random) const -> int
+    {
+        if (config_.Topology == MigrationTopology::Ring) { return (rank_ + 1) % size_; }
+        auto t = std::uniform_int_distribution<int>(0, size_ - 2)(random);
+        return t < rank_ ? t : t + 1; // any rank but this one
+    }
+
+    auto Exchange(Operon::RandomGenerator& random, size_t budget) -> void
+    {
+        auto& island = island_.get();
+        auto& evaluator = island.GetGenerator().Evaluator();
+        auto pop = island.Parents();
+        auto const n = pop.size();
+        auto idx = detail::MigrationOrder({ pop.data(), pop.size() }, key_);
+
+        std::vector<Individual> immigrants;
+        Receive(immigrants);
+        Progress();
+
+        // the evaluation budget is checked on the root
+        uint64_t local = evaluator.TotalEvaluations();
+        if (rank_ == Root) {
+            evaluations_[Root] = local;
+            uint64_t total{0};
+            for (auto e : evaluations_) { total += e; }
+            if (!stop_ && total > budget) {
+                stop_ = true;
+                for (int r = 0; r < size_; ++r) {
+                    if (r != Root) { Send({}, r, Stop); }
+                }
+            }
+        } else {
+            std::vector<std::byte> buffer(sizeof(uint64_t));
+            std::memcpy(buffer.data(), &local, sizeof(uint64_t));
+            Send(std::move(buffer), Root, Evaluations);
+        }
+
+        if (size_ > 1) {
+            auto const count = std::min(config_.MigrationSize, n);
+            std::vector<Individual> emigrants;
+            emigrants.reserve(count);
+            for (size_t i = 0; i < count; ++i) { emigrants.push_back(pop[idx[i]]); }
+            Send(codec_.Encode({ emigrants.data(), emigrants.size() }), Target(random), Migration);
+        }
+
+        // the immigrants take the places of the worst individuals (the surplus is discarded)
+        for (size_t i = 0; i < immigrants.size(); ++i) {
+            if (i < n) {
+                detail::Replace(pop[idx[n - 1 - i]], std::move(immigrants[i]));
+                ++migrants_;
+            } else {
+                NodePool::Release(std::move(immigrants[i].Genotype));
+            }
+        }
+
+        // an exhausted budget makes the generator of the island terminate the run
+        if (stop_) { evaluator.SetBudget(0); }
+    }
+
+    // NBX: a rank joins the barrier once all its (synchronous) sends were received, when the barrier completes no
+    // message can be in flight anymore
+    auto Finish() -> void
+    {
+        MPI_Request barrier{MPI_REQUEST_NULL};
+        bool active{false};
+        std::vector<Individual> discarded;
+        for (;;) {
+            Receive(discarded);
+            for (auto& ind : discarded) { NodePool::Release(std::move(ind.Genotype)); }
+            discarded.clear();
+            Progress();
+            if (!active) {
+                if (pending_.empty()) {
+                    MPI_Ibarrier(comm_, &barrier);
+                    active = true;
+                }
+            } else {
+                int done{0};
+                MPI_Test(&barrier, &done, MPI_STATUS_IGNORE);
+                if (done != 0) { break; }
+            }
+        }
+    }
+
+public:
+    // collective: all the ranks of the communicator have to construct the model
+    MpiIslandModel(Algorithm& island, IslandModelConfig config, KeyCallback key, MPI_Comm comm = MPI_COMM_WORLD)
+        : island_(island)
+        , config_(config)
+        , key_(std::move(key))
+        , codec_(island.GetProblem().GetDataset())
+    {
+        EXPECT(config_.MigrationInterval > 0);
+        MPI_Comm_dup(comm, &comm_);
+        MPI_Comm_rank(comm_, &rank_);
+        MPI_Comm_size(comm_, &size_);
+        evaluations_.resize(static_cast<size_t>(size_), 0);
+    }
+
+    MpiIslandModel(MpiIslandModel const&) = delete;
+    MpiIslandModel(MpiIslandModel&&) = delete;
+    auto operator=(MpiIslandModel const&) -> MpiIslandModel& = delete;
+    auto operator=(MpiIslandModel&&) -> MpiIslandModel& = delete;
+
+    ~MpiIslandModel()
+    {
+        MPI_Comm_free(&comm_);
+    }
+
+    [[nodiscard]] auto Rank() const -> int { return rank_; }
+    [[nodiscard]] auto Size() const -> int { return size_; }
+    [[nodiscard]] auto Island() const -> Algorithm const& { return island_.get(); }
+    [[nodiscard]] auto GetConfig() const -> IslandModelConfig const& { return config_; }
+
+    // the number of immigrants received by this rank
+    [[nodiscard]] auto Migrants() const -> size_t { return migrants_; }
+    // the number of evaluations summed over all ranks (available after Run)
+    [[nodiscard]] auto GlobalEvaluations() const -> size_t { return globalEvaluations_; }
+
+    // collective: every rank runs its island, the seeds should differ between the ranks
+    auto Run(tf::Executor& executor, Operon::RandomGenerator& random, std::function<void()> report = nullptr) -> void
+    {
+        auto& island = island_.get();
+        EXPECT(!island.Pipelined()); // the migration writes the parents from the report step
+        auto& evaluator = island.GetGenerator().Evaluator();
+        auto const budget = evaluator.Budget();
+        Operon::RandomGenerator migration(random());
+
+        island.Run(executor, random, [&]() {
+            auto generation = island.Generation();
+            if (generation > 0 && generation % config_.MigrationInterval == 0) {
+                Exchange(migration, budget);
+            }
+            if (report) { std::invoke(report); }
+        });
+        Finish();
+
+        uint64_t local = evaluator.TotalEvaluations();
+        uint64_t total{0};
+        MPI_Allreduce(&local, &total, 1, MPI_UINT64_T, MPI_SUM, comm_);
+        globalEvaluations_ = total;
+        evaluator.SetBudget(budget);
+    }
+};
+} // namespace Operon
+
+#endif
@@ -4,6 +4,7 @@
 #ifndef OPERON_NSGA2_HPP
 #define OPERON_NSGA2_HPP
 
+#include <cstddef>                         // for size_t, byte
 #include <functional>                      // for reference_wrapper, function
 #include <nonstd/span.hpp>                 // for span<>::pointer
 #include <operon/operon_export.hpp>        // for OPERON_EXPORT
@@ -17,13 +18,17 @@
 #include "operon/operators/generator.hpp"  // for OffspringGeneratorBase
 
 // forward declaration
-namespace tf { class Executor; }
+namespace tf { class Executor; class Subflow; }
 
 namespace Operon {
 
+class Engine;
+class ModelArchive;
+class ParetoArchive;
 class NondominatedSorterBase; 
 class Problem; 
 class ReinserterBase; 
+class TerminationCriterion;
 struct CoefficientInitializerBase; 
 struct TreeInitializerBase; 
 
@@ -40,15 +45,47 @@ class OPERON_EXPORT NSGA2 {
     Operon::Vector<Individual> individuals_;
     Operon::Span<Individual> parents_;
     Operon::Span<Individual> offspring_;
+    Operon::Span<Individual> spare_; // second offspring buffer, used by the pipelined loop
 
     size_t generation_;
+    bool pipelined_{false};
+    bool costAware_{false};
+    bool restored_{false}; // the next run continues from a checkpoint
+    ModelArchive const* seeds_{nullptr};
+    TerminationCriterion* termination_{nullptr};
+    ParetoArchive* archive_{nullptr};
+
+    uint64_t seed_{0}; // the seed of the task streams, drawn at the start of a run
     std::vector<std::vector<size_t>> fronts_;
 
-    // best pareto front
-    Operon::Vector<Individual> best_;
+    // scratch space for Sort: the row-major (n x m) fitness matrix of the sorted population
+    std::vector<Operon::Scalar> fitness_;
+    std::vector<Operon::Scalar> sorted_;
+    std::vector<size_t> order_;
+    std::vector<size_t> duplicates_;
+    std::vector<bool> visited_;
 
-    auto UpdateDistance(Operon::Span<Individual> pop) -> void;
+    // scratch space for UpdateDistance: the column-major fitness matrix and the per-objective order of the rows
+    std::vector<Operon::Scalar> columns_;
+    std::vector<size_t> columnOrder_;
+    std::vector<size_t> rank_;
+    std::vector<size_t> offsets_;
+
+    bool hypervolume_{false};
+    std::vector<Operon::Scalar> reference_;
+
+    // the fitness matrix of the first front, gathered from fitness_ for the termination criterion
+    std::vector<Operon::Scalar> front_;
+
+    // the parents followed by the offspring (without the spare buffer)
+    [[nodiscard]] auto Population() -> Operon::Span<Individual> { return { individuals_.data(), parents_.size() + offspring_.size() }; }
+
+    auto UpdateDistance(tf::Subflow& subflow, Operon::Span<Individual> pop) -> void;
     auto Sort(Operon::Span<Individual> pop) -> void;
+    // keeps the fronts of the parents and inserts the offspring (requires an incremental sorter)
+    auto Update() -> void;
+    // the run on the executor with (at least) one evaluation buffer per worker
+    auto Run(tf::Executor& executor, std::vector<Operon::Vector<Operon::Scalar>>& slots, Operon::RandomGenerator& random, std::function<void()> report) -> void;
 
 public:
     explicit NSGA2(Problem const& problem, GeneticAlgorithmConfig const& config, TreeInitializerBase const& treeInit, CoefficientInitializerBase const& coeffInit, OffspringGeneratorBase const& generator, ReinserterBase const& reinserter, NondominatedSorterBase const& sorter)
@@ -67,8 +104,11 @@ public:
     }
 
     [[nodiscard]] auto Parents() const -> Operon::Span<Individual const> { return { parents_.data(), parents_.size() }; }
+    // mutable access for the island model, which exchanges individuals between generations
+    [[nodiscard]] auto Parents() -> Operon::Span<Individual> { return parents_; }
     [[nodiscard]] auto Offspring() const -> Operon::Span<Individual const> { return { offspring_.data(), offspring_.size() }; }
-    [[nodiscard]] auto Best() const -> Operon::Span<Individual const> { return { best_.data(), best_.size() }; }
+    // the non-dominated individuals of the current population (a copy, made on demand)
+    [[nodiscard]] auto Best() const -> std::vector<Individual>;
 
     [[nodiscard]] auto GetProblem() const -> const Problem& { return problem_.get(); }
     [[nodiscard]] auto GetConfig() const -> const GeneticAlgorithmConfig& { return config_.get(); }
@@ -80,13 +120,54 @@ public:
 
     [[nodiscard]] auto Generation() const -> size_t { return generation_; }
 
+    // rank the members of each front by their exclusive hypervolume contribution instead of the crowding distance
+    // (exact up to Hypervolume::MaxExactObjectives objectives, estimated above), better suited to many objectives
+    void SetHypervolume(bool value) { hypervolume_ = value; }
+    [[nodiscard]] auto UsesHypervolume() const -> bool { return hypervolume_; }
+
+    // overlap the report on a generation with the variation of the next one (see GeneticProgrammingAlgorithm)
+    void SetPipelined(bool value) { pipelined_ = value; }
+    [[nodiscard]] auto Pipelined() const -> bool { return pipelined_; }
+
+    // evaluate the offspring longest first (see EvaluatorBase::Cost), with dynamic load balancing between the workers
+    // (only for separable generators, see OffspringGeneratorBase::Separable)
+    void SetCostAwareScheduling(bool value) { costAware_ = value; }
+    [[nodiscard]] auto CostAwareScheduling() const -> bool { return costAware_; }
+
     void Reset()
     {
         generation_ = 0;
         GetGenerator().Evaluator().Reset();
     }
 
+    // the state of the run as a binary checkpoint (see Checkpoint): the individuals, the generation, the evaluation
+    // counters, the random generator and the seed of the task streams. it has to be taken between two generations, eg.
+    // from the report callback (unless the loop is pipelined) or after Run returned.
+    [[nodiscard]] auto SaveState(Operon::RandomGenerator const& random) const -> std::vector<std::byte>;
+    // restores a checkpoint of an algorithm with the same configuration, the next call to Run (with the same random
+    // generator) continues the checkpointed run exactly. the evaluator caches are not part of the checkpoint and the
+    // time limit counts from the restart.
+    auto RestoreState(Operon::Span<std::byte const> buffer, Operon::RandomGenerator& random) -> void;
+
+    // the first individuals of the initial population are the models of the archive (e.g. the front of an earlier run,
+    // remapped to the variables of the problem) instead of random trees. the archive must outlive the runs
+    auto SetSeeds(ModelArchive const* seeds) -> void { seeds_ = seeds; }
+    [[nodiscard]] auto Seeds() const -> ModelArchive const* { return seeds_; }
+
+    // an additional termination criterion (e.g. FitnessStagnation), checked after the initialization and after every
+    // generation. it is reset at the start of every run (including a restored one) and must outlive the runs
+    auto SetTermination(TerminationCriterion* termination) -> void { termination_ = termination; }
+    [[nodiscard]] auto Termination() const -> TerminationCriterion* { return termination_; }
+
+    // every evaluated individual is offered to the archive (by the evaluating task), which keeps the epsilon-non-dominated
+    // individuals of the whole run and can be read from the report callback. the archive is not part of the checkpoints
+    // and must outlive the runs
+    auto SetArchive(ParetoArchive* archive) -> void { archive_ = archive; }
+    [[nodiscard]] auto Archive() const -> ParetoArchive* { return archive_; }
+
     auto Run(tf::Executor& /*executor*/, Operon::RandomGenerator&/*rng*/, std::function<void()> /*report*/ = nullptr) -> void;
+    // reuses the executor and the evaluation buffers of the engine (see Engine)
+    auto Run(Engine& /*engine*/, Operon::RandomGenerator&/*rng*/, std::function<void()> /*report*/ = nullptr) -> void;
     auto Run(Operon::RandomGenerator& /*rng*/, std::function<void()> /*report*/ = nullptr, size_t /*threads*/= 0) -> void;
 };
 } // namespace Operon
@@ -0,0 +1,179 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_TERMINATION_HPP
+#define OPERON_TERMINATION_HPP
+
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "operon/core/individual.hpp"
+#include "operon/core/types.hpp"
+#include "operon/operon_export.hpp"
+
+namespace Operon {
+
+// what the algorithms know about a run when they check for termination (after the initialization and after every
+// generation). nothing in it requires a pass over the population: the best individual is tracked by the evaluating
+// tasks (see BestSoFar) and the first front is a by-product of the non-dominated sort
+struct TerminationState {
+    size_t Generation{0};
+    // the best individual evaluated so far on the first objective (null before the first evaluation)
+    Individual const* Best{nullptr};
+    // the row-major fitness matrix of the first front, with Objectives columns (NSGA2 only, empty otherwise)
+    Operon::Span<Operon::Scalar const> Front;
+    size_t Objectives{1};
+};
+
+// a criterion stopping a run before its generation, time or evaluation budget is spent, checked by the loop condition
+// of GeneticProgrammingAlgorithm and NSGA2 (see SetTermination). the criteria keep their own state, which the
+// algorithms reset at the start of every run
+class OPERON_EXPORT TerminationCriterion {
+public:
+    TerminationCriterion() = default;
+    TerminationCriterion(TerminationCriterion const&) = default;
+    TerminationCriterion(TerminationCriterion&&) = default;
+    auto operator=(TerminationCriterion const&) -> TerminationCriterion& = default;
+    auto operator=(TerminationCriterion&&) -> TerminationCriterion& = default;
+    virtual ~TerminationCriterion() = default;
+
+    // returns true if the run should stop
+    virtual auto operator()(TerminationState const& state) -> bool = 0;
+    virtual auto Reset() -> void = 0;
+};
+
+// the last Window + 1 values of a quantity to minimize (one per generation), in a ring buffer: the progress over the
+// window is the difference between the oldest and the newest value, so a push is constant time
+class OPERON_EXPORT StagnationWindow {
+public:
+    explicit StagnationWindow(size_t window, double threshold)
+        : values_(window + 1), threshold_(threshold)
+    {
+    }
+
+    // adds the value of the current generation, returns true if it improved by at most the threshold over the window
+    auto Push(double value) -> bool;
+    auto Reset() -> void { count_ = 0; head_ = 0; }
+
+    [[nodiscard]] auto Window() const -> size_t { return values_.size() - 1; }
+    [[nodiscard]] auto Threshold() const -> double { return threshold_; }
+    // the improvement over the (possibly incomplete) window
+    [[nodiscard]] auto Improvement() const -> double;
+
+private:
+    std::vector<double> values_;
+    double threshold_;
+    size_t count_{0}; // the number of values pushed (saturating at the capacity)
+    size_t head_{0};  // the position of the next value
+};
+
+// stops when the best fitness (first objective) improved by at most the threshold over the last window generations
+class OPERON_EXPORT FitnessStagnation final : public TerminationCriterion {
+public:
+    explicit FitnessStagnation(size_t window, double threshold = 0)
+        : window_(window, threshold)
+    {
+    }
+
+    auto operator()(TerminationState const& state) -> bool override;
+    auto Reset() -> void override { window_.Reset(); }
+
+private:
+    StagnationWindow window_;
+};
+
+// stops when the hypervolume of the first front improved by at most the threshold over the last window generations.
+// without a reference point it is fixed from the first front seen (see Hypervolume::Reference), after which the
+// points outside of it do not count. the hypervolume is computed once per generation on the first front only
+class OPERON_EXPORT HypervolumeStagnation final : public TerminationCriterion {
+public:
+    explicit HypervolumeStagnation(size_t window, double threshold = 0, std::vector<Operon::Scalar> reference = {})
+        : window_(window, threshold)
+        , reference_(std::move(reference))
+        , fixed_(!reference_.empty())
+    {
+    }
+
+    auto operator()(TerminationState const& state) -> bool override;
+    auto Reset() -> void override
+    {
+        window_.Reset();
+        if (!fixed_) { reference_.clear(); }
+    }
+
+    [[nodiscard]] auto Reference() const -> Operon::Span<Operon::Scalar const> { return { reference_.data(), reference_.size() }; }
+
+private:
+    StagnationWindow window_;
+    std::vector<Operon::Scalar> reference_;
+    bool fixed_;
+};
+
+// stops when the best validation score (lower is better) of the best individuals improved by at most the threshold over
+// the last window generations. the score (e.g. the error on a held-out range) is only computed when the best
+// individual changed, the generations without a new best reuse the last score
+class OPERON_EXPORT ValidationPlateau final : public TerminationCriterion {
+public:
+    using Score = std::function<double(Individual const&)>;
+
+    explicit ValidationPlateau(Score score, size_t window, double threshold = 0)
+        : score_(std::move(score))
+        , window_(window, threshold)
+    {
+    }
+
+    auto operator()(TerminationState const& state) -> bool override;
+    auto Reset() -> void override
+    {
+        window_.Reset();
+        fitness_ = std::numeric_limits<Operon::Scalar>::quiet_NaN();
+        best_ = std::numeric_limits<double>::max();
+    }
+
+    [[nodiscard]] auto BestScore() const -> double { return best_; }
+
+private:
+    Score score_;
+    StagnationWindow window_;
+    Operon::Scalar fitness_{std::numeric_limits<Operon::Scalar>::quiet_NaN()}; // the fitness of the last scored individual
+    double best_{std::numeric_limits<double>::max()};
+};
+
+// the best individual (on the first objective) evaluated by each worker: the evaluating tasks offer the individuals
+// to the slot of their worker, so the best of the run is found in O(workers) without scanning the population
+class OPERON_EXPORT BestSoFar {
+public:
+    explicit BestSoFar(size_t workers)
+        : slots_(workers)
+    {
+    }
+
+    auto Offer(size_t worker, Individual const& individual) -> void
+    {
+        auto& slot = slots_[worker];
+        if (!individual.Fitness.empty() && individual[0] < slot.Value) {
+            slot.Value = individual[0];
+            slot.Best = individual;
+        }
+    }
+
+    // the best individual of all the workers, null if none was offered
+    [[nodiscard]] auto Best() const -> Individual const*;
+    auto Reset() -> void;
+
+private:
+    static constexpr size_t CacheLine = 64;
+
+    struct alignas(CacheLine) Slot {
+        Operon::Scalar Value{std::numeric_limits<Operon::Scalar>::max()};
+        Individual Best;
+    };
+    std::vector<Slot> slots_;
+};
+
+} // namespace Operon
+
+#endif
@@ -32,6 +32,10 @@ public:
         return diversity_;
     }
 
+    // signatureSize > 0 estimates the diversity from MinHash signatures (see Distance::MeanJaccardMinHash)
+    void SetSignatureSize(size_t signatureSize) { signatureSize_ = signatureSize; }
+    [[nodiscard]] auto SignatureSize() const -> size_t { return signatureSize_; }
+
     void Prepare(Operon::Span<T> pop)
     {
         std::vector<size_t> indices(pop.size());
@@ -43,22 +47,17 @@ public:
         std::transform(indices.begin(), indices.end(), std::back_inserter(hashes),
                 [&](auto i) { return MakeHashes(pop[i], M); });
 
-        vstat::univariate_accumulator<double> acc(Operon::Distance::Jaccard(hashes[0], hashes[1]));
-        for (auto j = 2UL; j < pop.size(); ++j) {
-            acc(Operon::Distance::Jaccard(hashes[0], hashes[j]));
-        }
-
-        for (auto i = 1UL; i < pop.size() - 1; ++i) {
-            for (auto j = i+1; j < pop.size(); ++j) {
-                acc(Operon::Distance::Jaccard(hashes[i], hashes[j]));
-            }
-        }
-
-        diversity_ = vstat::univariate_statistics(acc).mean;
+        Operon::Span<Operon::Vector<Operon::Hash> const> sets(hashes.data(), hashes.size());
+        auto distances = signatureSize_ > 0
+            ? Operon::Distance::MeanJaccardMinHash(sets, signatureSize_)
+            : Operon::Distance::PairwiseMeans(sets);
+        // the mean over all pairs equals the mean of the per-individual means
+        diversity_ = vstat::univariate::accumulate<double>(distances.data(), distances.size()).mean;
     }
 
     private:
         double diversity_{};
+        size_t signatureSize_{0};
     };
 } // namespace Operon
 
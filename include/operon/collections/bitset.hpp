@@ -4,15 +4,27 @@
 #ifndef OPERON_COLLECTIONS_BITSET_HPP
 #define OPERON_COLLECTIONS_BITSET_HPP
 
+#include <algorithm>
+#include <bitset>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <climits>
 #include <functional>
 #include <limits>
+#include <memory>
+#include <new>
 #include <numeric>
 #include <ostream>
+#include <type_traits>
 #include <vector>
 
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 #if defined(_M_IX86) || defined(_M_ARM) || defined(_M_X64) || defined(_M_ARM64)
 #include <intrin.h>
 #pragma intrinsic(_BitScanForward)
@@ -22,6 +34,123 @@
 #endif
 
 namespace Operon {
+    // kernels over arrays of 64-bit blocks, vectorized with AVX-512, AVX2 or NEON when the target supports them
+    namespace BitOps {
+#if defined(__AVX2__) && !defined(__AVX512VPOPCNTDQ__)
+        namespace detail {
+            // the bit counts of the four 64-bit lanes, with a nibble lookup table (Mula et al.)
+            inline auto PopCount(__m256i v) noexcept -> __m256i
+            {
+                auto const table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4); // NOLINT
+                auto const mask = _mm256_set1_epi8(0x0f); // NOLINT
+                auto const lo = _mm256_shuffle_epi8(table, _mm256_and_si256(v, mask));
+                auto const hi = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(v, 4), mask));
+                return _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256());
+            }
+
+            inline auto HorizontalAdd(__m256i v) noexcept -> size_t
+            {
+                return static_cast<size_t>(_mm256_extract_epi64(v, 0) + _mm256_extract_epi64(v, 1) + _mm256_extract_epi64(v, 2) + _mm256_extract_epi64(v, 3));
+            }
+        } // namespace detail
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+        namespace detail {
+            // the bit counts of the two 64-bit lanes: the byte counts added pairwise up to the lane width
+            inline auto PopCount(uint64x2_t v) noexcept -> uint64x2_t
+            {
+                return vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(vcntq_u8(vreinterpretq_u8_u64(v)))));
+            }
+        } // namespace detail
+#endif
+
+        // the number of bits set in a single block
+        template <typename U, std::enable_if_t<std::is_integral_v<U> && std::is_unsigned_v<U>, bool> = true>
+        inline auto PopCount(U block) noexcept -> size_t
+        {
+#if defined(__clang__) || defined(__GNUC__)
+            if constexpr (sizeof(U) <= sizeof(unsigned int)) {
+                return static_cast<size_t>(__builtin_popcount(static_cast<unsigned int>(block)));
+            } else if constexpr (sizeof(U) <= sizeof(unsigned long)) {
+                return static_cast<size_t>(__builtin_popcountl(static_cast<unsigned long>(block)));
+            } else {
+                return static_cast<size_t>(__builtin_popcountll(static_cast<unsigned long long>(block)));
+            }
+#else
+            return std::bitset<std::numeric_limits<U>::digits>(block).count();
+#endif
+        }
+
+        // p[i] &= q[i] for i < n
+        inline auto Intersect(uint64_t* p, uint64_t const* q, size_t n) noexcept -> void
+        {
+            size_t i = 0;
+#if defined(__AVX512F__)
+            for (; i + 8 <= n; i += 8) { // NOLINT
+                _mm512_storeu_si512(p + i, _mm512_and_si512(_mm512_loadu_si512(p + i), _mm512_loadu_si512(q + i)));
+            }
+#elif defined(__AVX2__)
+            for (; i + 4 <= n; i += 4) { // NOLINT
+                auto* a = reinterpret_cast<__m256i*>(p + i); // NOLINT
+                auto const* b = reinterpret_cast<__m256i const*>(q + i); // NOLINT
+                _mm256_storeu_si256(a, _mm256_and_si256(_mm256_loadu_si256(a), _mm256_loadu_si256(b)));
+            }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+            for (; i + 2 <= n; i += 2) { vst1q_u64(p + i, vandq_u64(vld1q_u64(p + i), vld1q_u64(q + i))); }
+#endif
+            for (; i < n; ++i) { p[i] &= q[i]; }
+        }
+
+        // the number of bits set in p[i] for i < n
+        inline auto PopCount(uint64_t const* p, size_t n) noexcept -> size_t
+        {
+            size_t i = 0;
+            size_t count = 0;
+#if defined(__AVX512VPOPCNTDQ__)
+            auto acc = _mm512_setzero_si512();
+            for (; i + 8 <= n; i += 8) { acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(_mm512_loadu_si512(p + i))); } // NOLINT
+            count = static_cast<size_t>(_mm512_reduce_add_epi64(acc));
+#elif defined(__AVX2__)
+            auto acc = _mm256_setzero_si256();
+            for (; i + 4 <= n; i += 4) { acc = _mm256_add_epi64(acc, detail::PopCount(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(p + i)))); } // NOLINT
+            count = detail::HorizontalAdd(acc);
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+            auto acc = vdupq_n_u64(0);
+            for (; i + 2 <= n; i += 2) { acc = vaddq_u64(acc, detail::PopCount(vld1q_u64(p + i))); }
+            count = static_cast<size_t>(vaddvq_u64(acc));
+#endif
+            for (; i < n; ++i) { count += PopCount(p[i]); }
+            return count;
+        }
+
+        // the number of bits set in p[i] & q[i] for i < n, without storing the intersection
+        inline auto IntersectCount(uint64_t const* p, uint64_t const* q, size_t n) noexcept -> size_t
+        {
+            size_t i = 0;
+            size_t count = 0;
+#if defined(__AVX512VPOPCNTDQ__)
+            auto acc = _mm512_setzero_si512();
+            for (; i + 8 <= n; i += 8) { // NOLINT
+                acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(_mm512_and_si512(_mm512_loadu_si512(p + i), _mm512_loadu_si512(q + i))));
+            }
+            count = static_cast<size_t>(_mm512_reduce_add_epi64(acc));
+#elif defined(__AVX2__)
+            auto acc = _mm256_setzero_si256();
+            for (; i + 4 <= n; i += 4) { // NOLINT
+                auto const a = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p + i)); // NOLINT
+                auto const b = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(q + i)); // NOLINT
+                acc = _mm256_add_epi64(acc, detail::PopCount(_mm256_and_si256(a, b)));
+            }
+            count = detail::HorizontalAdd(acc);
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+            auto acc = vdupq_n_u64(0);
+            for (; i + 2 <= n; i += 2) { acc = vaddq_u64(acc, detail::PopCount(vandq_u64(vld1q_u64(p + i), vld1q_u64(q + i)))); }
+            count = static_cast<size_t>(vaddvq_u64(acc));
+#endif
+            for (; i < n; ++i) { count += PopCount(p[i] & q[i]); }
+            return count;
+        }
+    } // namespace BitOps
+
     template<typename T = uint64_t /* block type */, size_t S = std::numeric_limits<T>::digits /* block size in bits */>
     class Bitset {
         std::vector<T> blocks_;
@@ -63,7 +192,11 @@ namespace Operon {
         }
 
         [[nodiscard]] auto PopCount() const -> size_t {
-            return std::transform_reduce(blocks_.begin(), blocks_.end(), size_t{0}, std::plus<>{}, [](auto b) { return __builtin_popcountl(b); });
+            if constexpr (std::is_same_v<T, uint64_t>) {
+                return BitOps::PopCount(blocks_.data(), blocks_.size());
+            } else {
+                return std::transform_reduce(blocks_.begin(), blocks_.end(), size_t{0}, std::plus<>{}, [](auto b) { return BitOps::PopCount(b); });
+            }
         }
 
         [[nodiscard]] auto Size() const -> size_t { return numBits_; }
@@ -254,6 +387,61 @@ namespace Operon {
             }
         }
     };
+
+    // a dense matrix of bits in a single allocation: the rows are aligned to the cache line and padded to a multiple of
+    // it, so that they can be processed with aligned vector loads and two rows never share a line
+    template<typename T = uint64_t /* block type */>
+    class BitMatrix {
+        struct Free {
+            auto operator()(T* p) const noexcept -> void { ::operator delete[](p, std::align_val_t{Alignment}); }
+        };
+
+        std::unique_ptr<T[], Free> blocks_; // NOLINT
+        size_t rows_{0};
+        size_t cols_{0};
+        size_t stride_{0};
+        size_t capacity_{0};
+
+        public:
+        static constexpr size_t Alignment = 64; // bytes
+        static constexpr size_t BlockSize = std::numeric_limits<T>::digits;
+        using Block = T;
+
+        // the blocks of a row of cols bits, including the padding
+        static constexpr auto Stride(size_t cols) -> size_t
+        {
+            constexpr size_t line = Alignment / sizeof(T);
+            auto const nb = (cols + BlockSize - 1) / BlockSize;
+            return (nb + line - 1) / line * line;
+        }
+
+        BitMatrix() = default;
+        BitMatrix(size_t rows, size_t cols) { Resize(rows, cols); }
+
+        // the allocation is kept when it is large enough, the bits are unspecified after resizing
+        auto Resize(size_t rows, size_t cols) -> void
+        {
+            rows_ = rows;
+            cols_ = cols;
+            stride_ = Stride(cols);
+            if (rows * stride_ > capacity_) {
+                capacity_ = rows * stride_;
+                blocks_.reset(static_cast<T*>(::operator new[](capacity_ * sizeof(T), std::align_val_t{Alignment})));
+            }
+        }
+
+        auto Fill(T value) -> void { std::fill_n(blocks_.get(), rows_ * stride_, value); }
+
+        [[nodiscard]] auto Row(size_t i) -> T* { assert(i < rows_); return blocks_.get() + i * stride_; }
+        [[nodiscard]] auto Row(size_t i) const -> T const* { assert(i < rows_); return blocks_.get() + i * stride_; }
+
+        [[nodiscard]] auto Rows() const -> size_t { return rows_; }
+        [[nodiscard]] auto Cols() const -> size_t { return cols_; }
+        [[nodiscard]] auto Stride() const -> size_t { return stride_; }
+        // the blocks of a row holding bits, without the padding
+        [[nodiscard]] auto NumBlocks() const -> size_t { return (cols_ + BlockSize - 1) / BlockSize; }
+        [[nodiscard]] auto Bytes() const -> size_t { return capacity_ * sizeof(T); }
+    };
 } // namespace Operon
 
 #endif
@@ -0,0 +1,41 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_CORE_AFFINITY_HPP
+#define OPERON_CORE_AFFINITY_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "operon/operon_export.hpp"
+
+// forward declaration
+namespace tf { class Executor; }
+
+namespace Operon::Affinity {
+    enum class Policy {
+        None,     // leave the placement to the operating system
+        Cores,    // bind every worker to its own core (round robin over the available cores)
+        NumaNodes // bind every worker to the cores of a numa node (round robin over the nodes)
+    };
+
+    // "none", "cores" or "numa"
+    [[nodiscard]] auto OPERON_EXPORT ParsePolicy(std::string const& str) -> Policy;
+
+    // the cores available to the process grouped by numa node (read from sysfs on linux), a single group if the
+    // topology is not known
+    [[nodiscard]] auto OPERON_EXPORT Nodes() -> std::vector<std::vector<int>>;
+
+    // binds the workers of the executor according to the policy, returns false if that is not supported (the placement
+    // is then left unchanged). the executor must be idle: the binding runs one task on every worker.
+    auto OPERON_EXPORT Pin(tf::Executor& executor, Policy policy) -> bool;
+
+    // binds the calling thread to the cores of the numa node, returns false if that is not supported
+    auto OPERON_EXPORT BindToNode(size_t node) -> bool;
+
+    // the numa node the calling thread was bound to (by Pin or BindToNode), 0 for threads which were not bound
+    [[nodiscard]] auto OPERON_EXPORT CurrentNode() -> size_t;
+} // namespace Operon::Affinity
+
+#endif
@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_CORE_ALLOCATION_HPP
+#define OPERON_CORE_ALLOCATION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "operon/operon_export.hpp"
+
+// the allocation policy of the large buffers read by the hot loops: the packed inputs, the scratch space of the local
+// optimization and (by advice, see Advise) the values of the datasets
+// - the buffers are aligned to a cache line
+// - with datasets of several gigabytes the interpreter touches more pages than the tlb covers: the buffers at least
+//   as large as a huge page can be backed by 2 MiB pages, either transparent ones (madvise(MADV_HUGEPAGE), the kernel
+//   falls back to small pages when it has no huge page) or explicit ones (mmap(MAP_HUGETLB) from the pool reserved in
+//   /proc/sys/vm/nr_hugepages, falling back to transparent pages when the pool is empty)
+// - the policy applies to the allocations made after it was set, so it is set before the data is loaded (see the
+//   --huge-pages option of the cli programs). huge pages are only supported on linux, elsewhere the policy only aligns
+namespace Operon::Memory {
+    enum class PagePolicy : uint8_t {
+        Default,     // small pages
+        Transparent, // transparent huge pages
+        Explicit     // explicit huge pages, or transparent ones when the pool is empty
+    };
+
+    static constexpr size_t HugePageSize = size_t{2} << 20U;
+    static constexpr size_t DefaultAlignment = 64;
+
+    struct AllocationPolicy {
+        PagePolicy Pages{PagePolicy::Default};
+        size_t Alignment{DefaultAlignment}; // a power of two
+        size_t Threshold{HugePageSize};      // the smallest allocation backed by huge pages
+
+        [[nodiscard]] auto operator==(AllocationPolicy const& rhs) const -> bool
+        {
+            return Pages == rhs.Pages && Alignment == rhs.Alignment && Threshold == rhs.Threshold;
+        }
+        [[nodiscard]] auto operator!=(AllocationPolicy const& rhs) const -> bool { return !(*this == rhs); }
+    };
+
+    // "none", "transparent" or "explicit"
+    [[nodiscard]] auto OPERON_EXPORT ParsePagePolicy(std::string const& str) -> PagePolicy;
+
+    auto OPERON_EXPORT SetAllocationPolicy(AllocationPolicy const& policy) -> void;
+    [[nodiscard]] auto OPERON_EXPORT GetAllocationPolicy() -> AllocationPolicy;
+
+    // a buffer is released with the policy it was allocated with
+    [[nodiscard]] auto OPERON_EXPORT Allocate(AllocationPolicy const& policy, size_t bytes) -> void*;
+    auto OPERON_EXPORT Deallocate(AllocationPolicy const& policy, void* data, size_t bytes) noexcept -> void;
+
+    // asks for transparent huge pages on the huge page aligned part of a buffer allocated elsewhere (e.g. the values of
+    // a dataset, held by eigen) if the current policy uses huge pages. the pages already touched are collapsed later by
+    // the kernel (khugepaged), so the advice is given as soon as the buffer is allocated
+    auto OPERON_EXPORT Advise(void const* data, size_t bytes) -> void;
+
+    // a standard allocator with the policy in effect at its construction, which the copies of a container keep
+    template<typename T>
+    class Allocator {
+        template<typename U>
+        friend class Allocator;
+
+        AllocationPolicy policy_;
+
+    public:
+        using value_type = T;
+        using propagate_on_container_copy_assignment = std::true_type;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+
+        Allocator()
+            : policy_(GetAllocationPolicy())
+        {
+        }
+
+        template<typename U>
+        Allocator(Allocator<U> const& other) noexcept // NOLINT(google-explicit-constructor)
+            : policy_(other.policy_)
+        {
+        }
+
+        [[nodiscard]] auto allocate(size_t n) -> T* { return static_cast<T*>(Allocate(policy_, n * sizeof(T))); } // NOLINT(readability-identifier-naming)
+        auto deallocate(T* data, size_t n) noexcept -> void { Deallocate(policy_, data, n * sizeof(T)); } // NOLINT(readability-identifier-naming)
+
+        [[nodiscard]] auto Policy() const -> AllocationPolicy const& { return policy_; }
+
+        template<typename U>
+        [[nodiscard]] auto operator==(Allocator<U> const& rhs) const -> bool { return policy_ == rhs.policy_; }
+        template<typename U>
+        [[nodiscard]] auto operator!=(Allocator<U> const& rhs) const -> bool { return policy_ != rhs.policy_; }
+    };
+
+    template<typename T>
+    using AlignedVector = std::vector<T, Allocator<T>>;
+} // namespace Operon::Memory
+
+#endif
@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_CHUNKED_DATASET_HPP
+#define OPERON_CHUNKED_DATASET_HPP
+
+#include <algorithm>
+#include <functional>
+#include <string>
+
+#include "dataset.hpp"
+#include "range.hpp"
+#include "operon/operon_export.hpp"
+
+namespace Operon {
+
+// a dataset in the binary format (see Dataset::WriteBinary) which is larger than the available memory
+// - the file is memory mapped, so the interpreter reads the values in place and the os pages them in on demand
+// - rows are processed in fixed-size blocks: the next block is prefetched asynchronously (by the os) while
+//   the current block is evaluated, and finished blocks are optionally released from memory
+class OPERON_EXPORT ChunkedDataset {
+public:
+    static constexpr size_t DefaultBlockRows = 1UL << 20U;
+
+    explicit ChunkedDataset(std::string const& path, size_t blockRows = DefaultBlockRows, bool releaseBlocks = false);
+
+    // the mapped dataset, to be used for the Problem so that programs are compiled against the mapped columns
+    [[nodiscard]] auto GetDataset() const -> Dataset const& { return dataset_; }
+
+    [[nodiscard]] auto Rows() const -> size_t { return dataset_.Rows(); }
+    [[nodiscard]] auto Cols() const -> size_t { return dataset_.Cols(); }
+    [[nodiscard]] auto BlockRows() const -> size_t { return blockRows_; }
+
+    // ask the os to page in the rows of the range (returns immediately)
+    void Prefetch(Range range) const;
+
+    // drop the rows of the range from memory (they are read from the file again if accessed)
+    void Release(Range range) const;
+
+    // calls callback(Range block) for consecutive blocks of the range until it returns false
+    template <typename Callback>
+    void ForEachBlock(Range range, Callback&& callback) const
+    {
+        for (auto start = range.Start(); start < range.End(); start += blockRows_) {
+            Range block { start, std::min(range.End(), start + blockRows_) };
+            if (block.End() < range.End()) {
+                Prefetch({ block.End(), std::min(range.End(), block.End() + blockRows_) });
+            }
+            auto next = std::invoke(callback, block);
+            if (releaseBlocks_) { Release(block); }
+            if (!next) { break; }
+        }
+    }
+
+private:
+    Dataset dataset_;
+    size_t blockRows_;
+    bool releaseBlocks_;
+};
+
+} // namespace Operon
+
+#endif
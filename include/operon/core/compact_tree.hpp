@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_CORE_COMPACT_TREE_HPP
+#define OPERON_CORE_COMPACT_TREE_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "operon/operon_export.hpp"
+#include "node.hpp"
+#include "tree.hpp"
+#include "types.hpp"
+
+namespace Operon {
+
+// the structural part of a node in 16 bytes (a Node takes 40 bytes with double precision)
+// - depth, level and parent are derived from arity and length, so they are not stored
+// - the calculated (subtree) hash values are not stored, they are recomputed on demand
+// - the node values are stored in a separate array (see CompactTree)
+struct CompactNode {
+    Operon::Hash HashValue; // symbol hash (variables and dynamic nodes), otherwise the node type
+    uint16_t Arity;
+    uint16_t Length;
+    uint8_t Type; // index of the node type (see NodeTypes::GetIndex)
+    bool IsEnabled;
+
+    [[nodiscard]] auto GetType() const noexcept -> NodeType { return static_cast<NodeType>(1U << Type); }
+    [[nodiscard]] auto IsLeaf() const noexcept -> bool { return Arity == 0; }
+};
+
+static_assert(sizeof(CompactNode) == 16);
+
+// structure-of-arrays tree storage: the nodes (postfix order, as in Tree) and their values are kept in separate
+// arrays. meant for keeping large numbers of trees around (e.g. populations and archives), the variation and
+// evaluation operators work on Tree, use ToTree to convert at the boundary.
+class OPERON_EXPORT CompactTree {
+public:
+    CompactTree() = default;
+    explicit CompactTree(Tree const& tree);
+
+    // the tree with updated node information (depth, level, parent), call Hash to recompute the subtree hashes
+    [[nodiscard]] auto ToTree() const -> Tree;
+
+    // the hash of the tree at the time of the conversion (the root node hash)
+    [[nodiscard]] auto HashValue() const noexcept -> Operon::Hash { return hash_; }
+
+    [[nodiscard]] auto Nodes() const noexcept -> std::vector<CompactNode> const& { return nodes_; }
+    [[nodiscard]] auto Values() const noexcept -> std::vector<Operon::Scalar> const& { return values_; }
+
+    [[nodiscard]] auto Length() const noexcept -> size_t { return nodes_.size(); }
+    [[nodiscard]] auto Empty() const noexcept -> bool { return nodes_.empty(); }
+
+    // the same coefficient order as Tree::GetCoefficients and Tree::SetCoefficients
+    [[nodiscard]] auto GetCoefficients() const -> std::vector<Operon::Scalar>;
+    void SetCoefficients(Operon::Span<Operon::Scalar const> coefficients);
+
+    // memory used by the nodes (not counting unused capacity)
+    [[nodiscard]] auto MemoryUsage() const noexcept -> size_t { return nodes_.size() * (sizeof(CompactNode) + sizeof(Operon::Scalar)); }
+
+private:
+    std::vector<CompactNode> nodes_;
+    std::vector<Operon::Scalar> values_;
+    Operon::Hash hash_{0};
+};
+
+} // namespace Operon
+
+#endif
@@ -4,10 +4,14 @@
 #ifndef OPERON_COMPARISON_HPP
 #define OPERON_COMPARISON_HPP
 
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
 #include <iterator>
 #include <type_traits>
 
+#include "simd.hpp"
+
 namespace Operon {
 
 enum class Dominance : int { Left = 0,
@@ -81,6 +85,65 @@ struct Equal {
     }
 };
 
+namespace detail {
+    inline constexpr auto MakeDominance(bool better, bool worse) noexcept -> Dominance
+    {
+        if (better) {
+            return worse ? Dominance::None : Dominance::Left;
+        }
+        return worse ? Dominance::Right : Dominance::Equal;
+    }
+
+    // the smallest power of two not less than n
+    inline constexpr auto NextPowerOfTwo(size_t n) noexcept -> size_t
+    {
+        size_t p{1};
+        while (p < n) { p <<= 1U; }
+        return p;
+    }
+
+    // the smallest vector of at least 16 bytes holding M values (the unused lanes are zero on both sides, so they never decide)
+    template <typename T, size_t M>
+    using DominanceVector = Simd::Vec<T, std::max(NextPowerOfTwo(M), 16 / sizeof(T))>;
+
+    // dominance of two rows with a number of objectives known at compile time, a - b > eps is the same as LessEqual(b, a)
+    // (and as Less(b, a)) without the NaN check. the fixed sizes used by the sorters are 2, 3, 4 and 8.
+    template <size_t M, typename T>
+    inline auto FixedDominance(T const* lhs, T const* rhs, T eps) noexcept -> Dominance
+    {
+        if constexpr ((std::is_same_v<T, float> || std::is_same_v<T, double>) && M <= 8) {
+            using V = DominanceVector<T, M>;
+            auto const a = M == V::Size ? V::Load(lhs) : V::LoadPartial(lhs, M);
+            auto const b = M == V::Size ? V::Load(rhs) : V::LoadPartial(rhs, M);
+            V const e(eps);
+            return MakeDominance(Simd::Any(b - a > e), Simd::Any(a - b > e));
+        } else
+        {
+            bool better { false };
+            bool worse { false };
+            for (size_t i = 0; i < M; ++i) {
+                better |= rhs[i] - lhs[i] > eps;
+                worse |= lhs[i] - rhs[i] > eps;
+            }
+            return MakeDominance(better, worse);
+        }
+    }
+} // namespace detail
+
+// calls f with std::integral_constant<size_t, M> for the objective counts that have a fixed size kernel and with
+// std::integral_constant<size_t, 0> otherwise, so that the callee can dispatch at compile time
+template <typename F>
+inline auto DispatchObjectives(size_t m, F&& f)
+{
+    switch (m) {
+    case 2: return f(std::integral_constant<size_t, 2>{});
+    case 3: return f(std::integral_constant<size_t, 3>{});
+    case 4: return f(std::integral_constant<size_t, 4>{});
+    case 8: return f(std::integral_constant<size_t, 8>{});
+    default: return f(std::integral_constant<size_t, 0>{});
+    }
+}
+
 template <bool Strict = false, bool CheckNan = false>
 struct ParetoDominance {
     template <typename Input1, typename Input2>
@@ -93,13 +156,18 @@ struct ParetoDominance {
             better |= cmp(*first1, *first2, eps);
             worse |= cmp(*first2, *first1, eps);
         }
-        if (better) {
-            return worse ? Dominance::None : Dominance::Left;
-        }
-        if (worse) {
-            return better ? Dominance::None : Dominance::Right;
+        return detail::MakeDominance(better, worse);
+    }
+
+    // rows of M objectives (M == 0 means m objectives, given at runtime)
+    template <size_t M, typename T>
+    auto Compare(T const* lhs, T const* rhs, size_t m, T eps = 0.0) const noexcept -> Dominance
+    {
+        if constexpr (M > 0 && !CheckNan) {
+            return detail::FixedDominance<M>(lhs, rhs, eps);
+        } else {
+            return (*this)(lhs, lhs + m, rhs, rhs + m, eps);
         }
-        return Dominance::Equal;
     }
 
     template<typename Cont1, typename Cont2>
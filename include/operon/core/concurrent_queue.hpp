@@ -0,0 +1,103 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_CORE_CONCURRENT_QUEUE_HPP
+#define OPERON_CORE_CONCURRENT_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <utility>
+
+#include "contracts.hpp"
+
+namespace Operon {
+
+// bounded lock-free multi-producer multi-consumer queue (D. Vyukov's array based design)
+// - every cell carries a sequence number which tells producers and consumers whether it is free or full
+// - the capacity is rounded up to a power of two, pushing into a full queue fails instead of blocking
+template<typename T>
+class ConcurrentQueue {
+    struct Cell {
+        std::atomic_size_t Sequence;
+        T Value;
+    };
+
+    // keep the producer and the consumer counters on separate cache lines
+    static constexpr size_t CacheLine = 64;
+
+    std::unique_ptr<Cell[]> cells_; // NOLINT(cppcoreguidelines-avoid-c-arrays,hicpp-avoid-c-arrays,modernize-avoid-c-arrays)
+    size_t mask_;
+    alignas(CacheLine) std::atomic_size_t head_{0}; // next cell to push into
+    alignas(CacheLine) std::atomic_size_t tail_{0}; // next cell to pop from
+
+public:
+    explicit ConcurrentQueue(size_t capacity)
+    {
+        EXPECT(capacity > 0);
+        size_t size{1};
+        while (size < capacity) { size <<= 1U; }
+        cells_ = std::make_unique<Cell[]>(size); // NOLINT(cppcoreguidelines-avoid-c-arrays,hicpp-avoid-c-arrays,modernize-avoid-c-arrays)
+        mask_ = size - 1;
+        for (size_t i = 0; i < size; ++i) {
+            cells_[i].Sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ConcurrentQueue(ConcurrentQueue const&) = delete;
+    ConcurrentQueue(ConcurrentQueue&&) = delete;
+    auto operator=(ConcurrentQueue const&) -> ConcurrentQueue& = delete;
+    auto operator=(ConcurrentQueue&&) -> ConcurrentQueue& = delete;
+    ~ConcurrentQueue() = default;
+
+    [[nodiscard]] auto Capacity() const -> size_t { return mask_ + 1; }
+
+    // returns false (leaving the value untouched) if the queue is full
+    auto TryPush(T& value) -> bool
+    {
+        auto pos = head_.load(std::memory_order_relaxed);
+        for (;;) {
+            auto& cell = cells_[pos & mask_];
+            auto seq = cell.Sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.Value = std::move(value);
+                    cell.Sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // full
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // returns an empty optional if the queue is empty
+    auto TryPop() -> std::optional<T>
+    {
+        auto pos = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            auto& cell = cells_[pos & mask_];
+            auto seq = cell.Sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    std::optional<T> value{ std::move(cell.Value) };
+                    cell.Sequence.store(pos + mask_ + 1, std::memory_order_release);
+                    return value;
+                }
+            } else if (diff < 0) {
+                return std::nullopt; // empty
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+};
+
+} // namespace Operon
+
+#endif
@@ -5,8 +5,14 @@
 #define DATASET_H
 
 #include <Eigen/Core>
+#include <robin_hood.h>
 
+#include <array>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <tuple>
 
 #include "operon/operon_export.hpp"
 #include "contracts.hpp"
@@ -18,40 +24,132 @@ namespace Operon {
 
 // a dataset variable described by: name, hash value (for hashing), data column index
 
+// univariate statistics of a column over a range of rows
+struct ColumnStatistics {
+    double Count{0};
+    double Mean{0};
+    double Variance{0}; // population variance
+    double Min{0};
+    double Max{0};
+};
+
+// the affine transform of a column by Standardize or Normalize, x' = (x - Shift) / Scale (see Dataset::Transform)
+struct ColumnTransform {
+    double Shift{0};
+    double Scale{1};
+
+    [[nodiscard]] auto Apply(double x) const -> double { return (x - Shift) / Scale; }
+    [[nodiscard]] auto Invert(double x) const -> double { return x * Scale + Shift; }
+    [[nodiscard]] auto IsIdentity() const -> bool { return Shift == 0 && Scale == 1; }
+};
+
+enum class ColumnScaling : uint8_t { Standardize, Normalize };
+
 class OPERON_EXPORT Dataset {
 public:
     // some useful aliases
     using Matrix = Eigen::Array<Operon::Scalar, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor>;
     using Map = Eigen::Map<Matrix const>;
+    using SingleMatrix = Eigen::Array<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor>;
+
+    // a column derived from another variable instead of being read from the data (see AddLag, AddDerivative)
+    struct VirtualColumn {
+        enum class Kind : uint8_t { Lag, Derivative };
+
+        Kind Type;
+        Operon::Hash Source;
+        size_t Lag{0};            // the rows between a value and its source row
+        Operon::Scalar Step{1};   // the distance between two rows (derivatives only)
+        std::shared_ptr<Operon::Vector<Operon::Scalar> const> Values; // the computed values (derivatives only)
+        std::shared_ptr<std::vector<float> const> Single;             // their single precision copy (see StoreSinglePrecision)
+    };
 
 private:
     std::vector<Variable> variables_;
+    robin_hood::unordered_flat_map<Operon::Hash, Eigen::Index> columns_; // variable hash -> column index
     Matrix values_;
     Map map_;
+    std::shared_ptr<void const> storage_; // keeps external data alive (e.g. a memory mapped file)
+    SingleMatrix single_; // optional single precision copy of the values (only when Operon::Scalar is double)
+    std::vector<Variable> virtualVariables_;    // their index follows the columns of the values
+    std::vector<VirtualColumn> virtualColumns_; // in the order of the virtual variables
+
+    // cache of the column statistics keyed by (column, start, end), not copied and cleared when the values change
+    struct StatisticsCache {
+        std::map<std::tuple<Operon::Hash, size_t, size_t>, ColumnStatistics> Map;
+        std::mutex Mutex;
+
+        void Clear()
+        {
+            std::lock_guard<std::mutex> lock(Mutex);
+            Map.clear();
+        }
+    };
+    mutable StatisticsCache statistics_;
+    robin_hood::unordered_flat_map<Operon::Hash, ColumnTransform> transforms_; // the composed transforms of the columns
 
     Dataset();
 
     // read data from a csv file and return a map (view of the data)
     auto ReadCsv(std::string const& path, bool hasHeader) -> Matrix;
 
+    // map a file in the binary format (see WriteBinary) into memory as a view
+    auto ReadBinary(std::string const& path) -> void;
+
     // this method ensures the same ordering of variables in the variables vector
     // based on index, name, hash value
     void InitializeVariables(std::vector<std::string> const&);
 
+    // rebuild the hash to column lookup table (must be called whenever the variables change)
+    void IndexColumns();
+
+    // the virtual column of the variable, nullptr for the columns of the values
+    [[nodiscard]] auto FindVirtual(Operon::Hash hashValue) const noexcept -> VirtualColumn const*;
+
+    // the variable of a new virtual column, the name must not exist yet
+    auto AddVirtual(std::string name, VirtualColumn column) -> Variable;
+
+    // (re)compute the values of the derivative from its source, of all the derivatives (after the values changed)
+    void ComputeDerivative(VirtualColumn& column);
+    void ComputeDerivatives();
+    [[nodiscard]] auto GetSingleValues(Operon::Hash hashValue) const noexcept -> Operon::Span<float const>;
+    // the owned values follow the huge page policy (see Memory::Advise), as soon as they are allocated
+    void AdvisePages() const;
+
 public:
+    // binary format: a header with the variable metadata followed by the column-major values (64-byte aligned)
+    static constexpr std::array<char, 8> BinaryMagic { 'O', 'P', 'E', 'R', 'O', 'N', 'D', 'S' };
+    static constexpr uint32_t BinaryVersion = 1;
+    static constexpr size_t BinaryAlignment = 64;
+
+    // csv files are parsed into an owned matrix, files in the binary format are memory mapped as a view,
+    // parquet files are read with ReadParquet
     explicit Dataset(const std::string& path, bool hasHeader = false);
 
     Dataset(Dataset const& rhs)
         : variables_(rhs.variables_)
+        , columns_(rhs.columns_)
         , values_(rhs.values_)
-        , map_(values_.data(), values_.rows(), values_.cols())
+        , map_(rhs.IsView() ? rhs.map_.data() : values_.data(), rhs.map_.rows(), rhs.map_.cols())
+        , storage_(rhs.storage_)
+        , single_(rhs.single_)
+        , virtualVariables_(rhs.virtualVariables_)
+        , virtualColumns_(rhs.virtualColumns_)
+        , transforms_(rhs.transforms_)
     {
+        AdvisePages();
     }
 
     Dataset(Dataset&& rhs) noexcept
         : variables_(std::move(rhs.variables_))
+        , columns_(std::move(rhs.columns_))
         , values_(std::move(rhs.values_))
         , map_(rhs.map_)
+        , storage_(std::move(rhs.storage_))
+        , single_(std::move(rhs.single_))
+        , virtualVariables_(std::move(rhs.virtualVariables_))
+        , virtualColumns_(std::move(rhs.virtualColumns_))
+        , transforms_(std::move(rhs.transforms_))
     {
     }
 
@@ -60,12 +158,14 @@ public:
         , map_(nullptr, static_cast<Eigen::Index>(vals[0].size()), static_cast<Eigen::Index>(vals.size()))
     {
         values_ = Matrix(map_.rows(), map_.cols());
+        AdvisePages();
 
         for (Eigen::Index i = 0; i < values_.cols(); ++i) {
             auto m = Eigen::Map<Eigen::Matrix<Operon::Scalar, Eigen::Dynamic, 1, Eigen::ColMajor> const>(vals[static_cast<size_t>(i)].data(), map_.rows());
             values_.col(i) = m;
         }
         new (&map_) Map(values_.data(), values_.rows(), values_.cols()); // we use placement new (no allocation)
+        IndexColumns();
     }
 
     explicit Dataset(std::vector<std::vector<Operon::Scalar>> const& vals);
@@ -87,7 +187,14 @@ public:
     {
         if (this != &rhs) {
             variables_ = std::move(rhs.variables_);
+            columns_ = std::move(rhs.columns_);
             values_ = std::move(rhs.values_);
+            storage_ = std::move(rhs.storage_);
+            single_ = std::move(rhs.single_);
+            virtualVariables_ = std::move(rhs.virtualVariables_);
+            virtualColumns_ = std::move(rhs.virtualColumns_);
+            transforms_ = std::move(rhs.transforms_);
+            statistics_.Clear();
             new (&map_) Map(rhs.map_.data(), rhs.map_.rows(), rhs.map_.cols()); // we use placement new (no allocation)
         }
         return *this;
@@ -95,9 +202,23 @@ public:
 
     void Swap(Dataset& rhs) noexcept
     {
+        Map lhsMap = map_;
+        Map rhsMap = rhs.map_;
+        auto const lhsView = IsView();
+        auto const rhsView = rhs.IsView();
         variables_.swap(rhs.variables_);
+        columns_.swap(rhs.columns_);
         values_.swap(rhs.values_);
-        new (&map_) Map(values_.data(), values_.rows(), values_.cols()); // we use placement new (no allocation)
+        storage_.swap(rhs.storage_);
+        single_.swap(rhs.single_);
+        virtualVariables_.swap(rhs.virtualVariables_);
+        virtualColumns_.swap(rhs.virtualColumns_);
+        transforms_.swap(rhs.transforms_);
+        statistics_.Clear();
+        rhs.statistics_.Clear();
+        // we use placement new (no allocation)
+        new (&map_) Map(rhsView ? rhsMap.data() : values_.data(), rhsMap.rows(), rhsMap.cols());
+        new (&rhs.map_) Map(lhsView ? lhsMap.data() : rhs.values_.data(), lhsMap.rows(), lhsMap.cols());
     }
 
     auto operator==(Dataset const& rhs) const noexcept -> bool
@@ -107,18 +228,40 @@ public:
             Cols() == rhs.Cols() &&
             variables_.size() == rhs.variables_.size() &&
             std::equal(variables_.begin(), variables_.end(), rhs.variables_.begin()) &&
-            values_.isApprox(rhs.values_);
+            map_.isApprox(rhs.map_);
     }
 
     // check if we own the data or if we are a view over someone else's data
     [[nodiscard]] auto IsView() const noexcept -> bool { return values_.data() != map_.data(); }
 
+    // a view of the values with the same variables, without copying them (e.g. for the problems of several runs over one
+    // dataset). the dataset must outlive the view and must not be modified meanwhile, a view cannot be modified
+    [[nodiscard]] auto View() const -> Dataset;
+
     [[nodiscard]] auto Rows() const -> size_t { return static_cast<size_t>(map_.rows()); }
     [[nodiscard]] auto Cols() const -> size_t { return static_cast<size_t>(map_.cols()); }
     [[nodiscard]] auto Dimensions() const -> std::pair<size_t, size_t> { return { Rows(), Cols() }; }
 
     [[nodiscard]] auto Values() const -> Eigen::Ref<Matrix const> { return map_; }
 
+    // write the dataset in the binary format, which can be memory mapped by the constructor
+    void WriteBinary(std::string const& path) const;
+
+    // check if the file starts with the binary format magic bytes
+    static auto IsBinary(std::string const& path) -> bool;
+
+    // build a dataset from named columns of equal length (e.g. the buffers of an Apache Arrow table)
+    // - if the columns are laid out back to back in memory the dataset is a view, otherwise they are copied
+    // - the owner (if given) is kept alive for as long as the dataset views the data
+    static auto FromColumns(std::vector<std::string> const& names, std::vector<Operon::Span<Operon::Scalar const>> const& columns, std::shared_ptr<void const> owner = nullptr) -> Dataset;
+
+    // read the given columns (all if empty) from a parquet file, converting them to Operon::Scalar
+    // (missing values become NaN). requires operon to be built with USE_ARROW, otherwise this throws
+    static auto ReadParquet(std::string const& path, std::vector<std::string> const& columns = {}) -> Dataset;
+
+    // check if the file starts with the parquet magic bytes
+    static auto IsParquet(std::string const& path) -> bool;
+
     auto VariableNames() -> std::vector<std::string>;
     void SetVariableNames(std::vector<std::string> const& names);
 
@@ -127,17 +270,82 @@ public:
     [[nodiscard]] auto GetValues(int index) const noexcept -> Operon::Span<const Operon::Scalar>;
     [[nodiscard]] auto GetValues(Variable const& variable) const noexcept -> Operon::Span<const Operon::Scalar> { return GetValues(variable.Hash); }
 
+    // virtual columns: variables derived from another variable, which the interpreter reads like the columns of the
+    // values. they are not part of Variables(), Cols() or Values() (see VirtualVariables), their index follows the
+    // columns. the virtual columns are defined again over the rows of Gather and the copies and views keep them
+    // - a lag view stores nothing: its row r is the row r - lag of the source, read from the column of the source.
+    //   it has no values on the first rows (see FirstRow), the ranges evaluated with it have to start after them (the
+    //   statistics and the samples of a range starting before throw)
+    // - a derivative is computed once by central differences (one-sided on the first and the last row) and stored,
+    //   again after the source is normalized or standardized
+    // the default names are "<source>_lag<lag>" and "d<source>"
+    auto AddLag(Variable const& source, size_t lag, std::string name = {}) -> Variable;
+    auto AddDerivative(Variable const& source, Operon::Scalar step = 1, std::string name = {}) -> Variable;
+
+    [[nodiscard]] auto VirtualVariables() const noexcept -> Operon::Span<const Variable> { return { virtualVariables_.data(), virtualVariables_.size() }; }
+    [[nodiscard]] auto IsVirtual(Operon::Hash hashValue) const noexcept -> bool { return FindVirtual(hashValue) != nullptr; }
+
+    // the first row with a value: GetValues returns the values of the rows [FirstRow, Rows()), zero except for the
+    // lag views (and the virtual columns derived from them)
+    [[nodiscard]] auto FirstRow(Operon::Hash hashValue) const noexcept -> size_t;
+
+    // the bytes stored for the virtual columns
+    [[nodiscard]] auto VirtualSizeInBytes() const noexcept -> size_t;
+
+    // single precision storage: evaluating in float halves the memory traffic of the variable columns, while
+    // the error metrics and the coefficient optimization keep accumulating in Operon::Scalar (double).
+    // when Operon::Scalar is float the values are already stored in single precision and this does nothing
+    void StoreSinglePrecision();
+    [[nodiscard]] auto HasSinglePrecision() const noexcept -> bool { return std::is_same_v<Operon::Scalar, float> || single_.size() == map_.size(); }
+
+    // the column in the storage used for evaluation in T (float selects the single precision copy, which must be
+    // stored: the interpreter casts the columns of the datasets without it)
+    template <typename T>
+    [[nodiscard]] auto GetValuesAs(Operon::Hash hashValue) const noexcept -> Operon::Span<std::conditional_t<std::is_same_v<T, float>, float, Operon::Scalar> const>
+    {
+        if constexpr (std::is_same_v<T, float> && !std::is_same_v<Operon::Scalar, float>) {
+            EXPECT(HasSinglePrecision());
+            return GetSingleValues(hashValue);
+        } else {
+            return GetValues(hashValue);
+        }
+    }
+
     [[nodiscard]] auto GetVariable(const std::string& name) const noexcept -> std::optional<Variable>;
     [[nodiscard]] auto GetVariable(Operon::Hash hashValue) const noexcept -> std::optional<Variable>;
 
     [[nodiscard]] auto Variables() const noexcept -> Operon::Span<const Variable> { return {variables_.data(), variables_.size()}; }
 
+    // permutes the owned values in place (see IndexedDataset for shuffling without modifying the data). throws with
+    // virtual columns, which depend on the order of the rows
     void Shuffle(Operon::RandomGenerator& random);
 
+    // statistics of the column over the range, computed once and cached (thread-safe)
+    [[nodiscard]] auto Statistics(Operon::Hash hashValue, Range range) const -> ColumnStatistics;
+    [[nodiscard]] auto Statistics(Variable const& variable, Range range) const -> ColumnStatistics { return Statistics(variable.Hash, range); }
+
+    // a new dataset with the given rows (in the given order) and the same variables, works with views too
+    [[nodiscard]] auto Gather(Operon::Span<size_t const> rows) const -> Dataset;
+
+    // a new dataset with the given number of rows evenly spaced over the range (at most all of them), the virtual
+    // columns are sampled into columns of their own (e.g. the small samples evaluated by the caches and the screening)
+    [[nodiscard]] auto Sample(Range range, size_t rows) const -> Dataset;
+
+    // the virtual columns are not scaled themselves (the index of a virtual variable does nothing), they follow
+    // their sources
     void Normalize(size_t i, Range range);
 
     // standardize column i using mean and stddev calculated over the specified range
     void Standardize(size_t i, Range range);
+
+    // standardizes or normalizes the columns with their statistics over the range, in parallel over the columns (on
+    // this many threads, zero for all the hardware threads): one pass over the range, one over the column, then a
+    // single update of the derivatives and the single precision copy. the statistics of the transformed columns over
+    // the range are cached (see Statistics) and the transforms are kept to be inverted (see Transform)
+    void Preprocess(Operon::Span<size_t const> columns, Range range, ColumnScaling scaling, size_t threads = 0);
+
+    // the composition of the transforms applied to the column so far, the identity if it was never transformed
+    [[nodiscard]] auto Transform(Operon::Hash hashValue) const -> ColumnTransform;
 };
 } // namespace Operon
 
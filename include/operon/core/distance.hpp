@@ -7,9 +7,37 @@
 #include "types.hpp"
 #include "operon/operon_export.hpp"
 
+namespace tf {
+class Executor;
+} // namespace tf
+
 namespace Operon::Distance {
     auto OPERON_EXPORT Jaccard(Operon::Vector<Operon::Hash> const& lhs, Operon::Vector<Operon::Hash> const& rhs) noexcept -> double;
     auto OPERON_EXPORT SorensenDice(Operon::Vector<Operon::Hash> const& lhs, Operon::Vector<Operon::Hash> const& rhs) noexcept -> double;
+
+    using DistanceFunction = auto (*)(Operon::Vector<Operon::Hash> const&, Operon::Vector<Operon::Hash> const&) noexcept -> double;
+
+    // number of sets per side of a tile (each tile covers DefaultBlockSize^2 pairs)
+    static constexpr size_t DefaultBlockSize = 64;
+
+    // computes the symmetric matrix of pairwise distances (row-major, n x n) between the given sets
+    // - the upper triangle is split into tiles which are evaluated in parallel
+    auto OPERON_EXPORT PairwiseMatrix(tf::Executor& executor, Operon::Span<Operon::Vector<Operon::Hash> const> sets, Operon::Span<double> result, DistanceFunction distance = Jaccard, size_t blockSize = DefaultBlockSize) -> void;
+
+    // reduce-only variant of PairwiseMatrix: the mean distance between each set and all the other sets
+    auto OPERON_EXPORT PairwiseMeans(tf::Executor& executor, Operon::Span<Operon::Vector<Operon::Hash> const> sets, DistanceFunction distance = Jaccard, size_t blockSize = DefaultBlockSize) -> Operon::Vector<double>;
+    // same as above, on the shared executor with the given number of threads (0 means hardware concurrency)
+    auto OPERON_EXPORT PairwiseMeans(Operon::Span<Operon::Vector<Operon::Hash> const> sets, size_t threads = 0, DistanceFunction distance = Jaccard, size_t blockSize = DefaultBlockSize) -> Operon::Vector<double>;
+
+    static constexpr size_t DefaultSignatureSize = 64;
+
+    // computes the MinHash signature of a set of hash values (one minimum per hash function)
+    auto OPERON_EXPORT MinHash(Operon::Vector<Operon::Hash> const& hashes, Operon::Span<Operon::Hash> signature) noexcept -> void;
+
+    // estimates the mean Jaccard distance between each set and all the other sets from their MinHash signatures
+    // - within each signature slot, matching values are counted with a hash map, so the cost is O(n k) instead of O(n^2)
+    // - the work is distributed over the shared executor with the given number of threads (0 means hardware concurrency)
+    auto OPERON_EXPORT MeanJaccardMinHash(Operon::Span<Operon::Vector<Operon::Hash> const> sets, size_t signatureSize = DefaultSignatureSize, size_t threads = 0) -> Operon::Vector<double>;
 } // namespace Operon::Distance
 
 #endif
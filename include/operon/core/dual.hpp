@@ -4,6 +4,11 @@
 #ifndef OPERON_CORE_DUAL_HPP
 #define OPERON_CORE_DUAL_HPP
 
+#include <array>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
 #include "types.hpp"
 
 #if defined(HAVE_CERES)
@@ -13,7 +18,51 @@
 #endif
 
 namespace Operon {
-using Dual = ceres::Jet<Operon::Scalar, 4 * sizeof(double) / sizeof(Scalar)>;
+template<int N>
+using DualN = ceres::Jet<Operon::Scalar, N>;
+
+using Dual = DualN<4 * sizeof(double) / sizeof(Scalar)>;
+
+template<typename T>
+struct IsDual : std::false_type { };
+
+template<int N>
+struct IsDual<DualN<N>> : std::true_type { };
+
+// the jet widths the interpreter is instantiated for (see Operon::Interpreter). narrower jets are not worth it: the
+// fixed cost of a pass dominates, so a single coefficient is differentiated as fast with four lanes as with one
+static constexpr std::array<int, 3> JetWidths { 4, 8, 16 }; // NOLINT
+
+// the jet width which minimizes the dual work of a forward mode jacobian with the given number of parameters: the
+// jacobian takes ceil(k / n) passes, every pass computes n derivative lanes and has a fixed cost worth about
+// JetPassOverhead lanes (measured by the "Jet width" benchmark: 4 lanes up to 4 parameters, 8 up to 8, then 16)
+static constexpr size_t JetPassOverhead = 10;
+
+constexpr auto JetWidth(size_t parameters) -> int
+{
+    int best { JetWidths.front() };
+    auto cost { std::numeric_limits<size_t>::max() };
+    for (auto n : JetWidths) {
+        auto const w = static_cast<size_t>(n);
+        auto const c = (parameters + w - 1) / w * (w + JetPassOverhead);
+        if (c < cost) {
+            best = n;
+            cost = c;
+        }
+    }
+    return best;
+}
+
+// calls f with a (default constructed) jet of the given width, which must be one of JetWidths
+template<typename F>
+auto DispatchJetWidth(int width, F&& f) -> decltype(auto)
+{
+    switch (width) {
+    case 4: return std::forward<F>(f)(DualN<4>{});  // NOLINT
+    case 8: return std::forward<F>(f)(DualN<8>{});  // NOLINT
+    default: return std::forward<F>(f)(DualN<16>{}); // NOLINT
+    }
+}
 } // namespace Operon
 
 #endif
@@ -0,0 +1,22 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_CORE_EXECUTOR_HPP
+#define OPERON_CORE_EXECUTOR_HPP
+
+#include <cstddef>
+
+#include "operon/operon_export.hpp"
+
+// forward declaration
+namespace tf { class Executor; }
+
+namespace Operon {
+    // a process wide executor with the given number of workers (0 means hardware concurrency), started by the first
+    // request and shared by all the later ones, for the library calls which take a thread count instead of an executor
+    // (the workers are not started again on every call)
+    // - it must not be waited for from one of its own workers, the calls made from a task take the executor of the task
+    [[nodiscard]] auto OPERON_EXPORT SharedExecutor(size_t threads = 0) -> tf::Executor&;
+} // namespace Operon
+
+#endif
@@ -5,29 +5,66 @@
 #define OPERON_FORMAT_HPP
 
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include "individual.hpp"
 #include "tree.hpp"
 
+// forward declaration
+namespace tf { class Executor; }
+
 namespace Operon {
 
 class Dataset;
 
 class OPERON_EXPORT TreeFormatter {
-    static void FormatNode(Tree const& tree, std::unordered_map<Operon::Hash, std::string> variableNames, size_t i, std::string& current, std::string indent, bool isLast, bool initialMarker, int decimalPrecision);
-
 public:
-    static auto Format(Tree const& tree, Dataset const& dataset, int decimalPrecision = 2) -> std::string;
+    // appends to the buffer
+    static void Format(TreeView tree, std::unordered_map<Operon::Hash, std::string> const& variableNames, fmt::memory_buffer& out, int decimalPrecision = 2);
+
+    static auto Format(TreeView tree, Dataset const& dataset, int decimalPrecision = 2) -> std::string;
 
-    static auto Format(Tree const& tree, std::unordered_map<Operon::Hash, std::string> const& variableNames, int decimalPrecision = 2) -> std::string;
+    static auto Format(TreeView tree, std::unordered_map<Operon::Hash, std::string> const& variableNames, int decimalPrecision = 2) -> std::string;
 };
 
 class OPERON_EXPORT InfixFormatter {
-    static void FormatNode(Tree const& tree, std::unordered_map<Operon::Hash, std::string> const& variableNames, size_t i, fmt::memory_buffer& current, int decimalPrecision);
+public:
+    // appends to the buffer, e.g. to write many models without allocating a string for each
+    static void Format(TreeView tree, std::unordered_map<Operon::Hash, std::string> const& variableNames, fmt::memory_buffer& out, int decimalPrecision = 2);
+
+    static auto Format(TreeView tree, Dataset const& dataset, int decimalPrecision = 2) -> std::string;
+
+    static auto Format(TreeView tree, std::unordered_map<Operon::Hash, std::string> const& variableNames, int decimalPrecision = 2) -> std::string;
+
+    // formats a population (e.g. for an audit log of every generation) in parallel, in the order of the models
+    static auto FormatMany(tf::Executor& executor, Operon::Span<Tree const> trees, std::unordered_map<Operon::Hash, std::string> const& variableNames, int decimalPrecision = 2) -> std::vector<std::string>;
+
+    static auto FormatMany(tf::Executor& executor, Operon::Span<Individual const> individuals, Dataset const& dataset, int decimalPrecision = 2) -> std::vector<std::string>;
+};
+
+// emits the model as a self-contained C function (also valid C++), for deployment without the library:
+//     void name(Scalar const* const* columns, size_t rows, Scalar* result)
+// - columns[k] points to the values of the k-th input, in the order of the generated name_inputs array (the variables
+//   of the dataset which the model uses, in dataset order)
+// - the coefficients are baked in and every node is one temporary, in the evaluation order of the interpreter, so the
+//   function computes the same values as Interpreter::Evaluate (up to the rounding of the compiler's math library)
+// - the row loop has no dependencies between iterations and vectorizes where the math functions do (e.g. -O3
+//   -ffast-math with a vector math library)
+// - Scalar is float or double, following Operon::Scalar. dynamic (user defined) nodes cannot be exported.
+class OPERON_EXPORT CodeFormatter {
+    static auto Format(TreeView tree, std::vector<std::pair<Operon::Hash, std::string>> const& inputs, std::string const& name, bool parameterized) -> std::string;
 
 public:
-    static auto Format(Tree const& tree, Dataset const& dataset, int decimalPrecision = 2) -> std::string;
+    static auto Format(TreeView tree, Dataset const& dataset, std::string const& name = "model") -> std::string;
+
+    // the inputs are ordered by their first occurrence in the tree
+    static auto Format(TreeView tree, std::unordered_map<Operon::Hash, std::string> const& variableNames, std::string const& name = "model") -> std::string;
 
-    static auto Format(Tree const& tree, std::unordered_map<Operon::Hash, std::string> const& variableNames, int decimalPrecision = 2) -> std::string;
+    // a kernel of the tree structure (see operon/interpreter/jit.hpp): the k-th leaf reads its coefficient from p[k] and
+    // the k-th variable leaf reads the k-th column, so the kernel can be reused for any coefficients and any variables
+    //   void name(Scalar const* const* columns, Scalar const* p, size_t rows, Scalar* result)
+    static auto FormatKernel(TreeView tree, std::string const& name = "kernel") -> std::string;
 };
 } // namespace Operon
 
@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_HYPERVOLUME_HPP
+#define OPERON_HYPERVOLUME_HPP
+
+#include <vector>
+
+#include "types.hpp"
+#include "operon/operon_export.hpp"
+
+namespace Operon::Hypervolume {
+    // the points are given as a row-major (n x m) matrix of objective values (minimization), the region counted towards
+    // the hypervolume is bounded by the reference point. points which are not better than the reference point in every
+    // objective do not contribute.
+
+    // up to this number of objectives the contributions are computed exactly, above it they are estimated
+    static constexpr size_t MaxExactObjectives = 4;
+    static constexpr size_t DefaultSamples = 10000;
+
+    // exact hypervolume (WFG algorithm, with a sweep for two objectives)
+    auto OPERON_EXPORT Compute(Operon::Span<Operon::Scalar const> points, size_t m, Operon::Span<Operon::Scalar const> reference) -> double;
+
+    // exclusive contribution of each point (the hypervolume lost when the point is removed)
+    // - exact for m <= MaxExactObjectives, where the contribution of a point is its inclusive volume minus the
+    //   hypervolume of the remaining points limited to it
+    // - otherwise a Monte Carlo estimate: the samples are drawn uniformly from the box between the ideal and the reference
+    //   point and each sample dominated by exactly one point counts towards the contribution of that point
+    auto OPERON_EXPORT Contributions(Operon::RandomGenerator& random, Operon::Span<Operon::Scalar const> points, size_t m, Operon::Span<Operon::Scalar const> reference, size_t samples = DefaultSamples) -> std::vector<double>;
+
+    // a reference point slightly worse than the nadir of the points: max + margin * (max - min) in each objective
+    auto OPERON_EXPORT Reference(Operon::Span<Operon::Scalar const> points, size_t m, double margin = 0.1) -> std::vector<Operon::Scalar>;
+} // namespace Operon::Hypervolume
+
+#endif
@@ -0,0 +1,59 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_INDEXED_DATASET_HPP
+#define OPERON_INDEXED_DATASET_HPP
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "dataset.hpp"
+#include "range.hpp"
+#include "types.hpp"
+#include "operon/operon_export.hpp"
+
+namespace Operon {
+
+// a permutation or subset of the rows of a shared read-only dataset (e.g. a memory mapped view), expressed as
+// an index set. several runs with different seeds can shuffle the same dataset without copying or modifying it.
+// the interpreter needs contiguous columns, so the indexed rows are gathered into small owned datasets one
+// block at a time, on first access
+class OPERON_EXPORT IndexedDataset {
+public:
+    static constexpr size_t DefaultBlockRows = 1UL << 14U;
+
+    IndexedDataset(Dataset const& dataset, std::vector<size_t> indices, size_t blockRows = DefaultBlockRows);
+
+    // a random permutation of all the rows
+    static auto Shuffled(Dataset const& dataset, Operon::RandomGenerator& random, size_t blockRows = DefaultBlockRows) -> IndexedDataset;
+
+    // k disjoint index sets of (nearly) equal size covering a random permutation of the rows (for cross-validation:
+    // the training rows of fold i are the concatenation of all the other folds)
+    static auto Folds(size_t rows, size_t k, Operon::RandomGenerator& random) -> std::vector<std::vector<size_t>>;
+
+    [[nodiscard]] auto GetDataset() const -> Dataset const& { return dataset_; }
+    [[nodiscard]] auto Indices() const -> Operon::Span<size_t const> { return { indices_.data(), indices_.size() }; }
+    [[nodiscard]] auto Rows() const -> size_t { return indices_.size(); }
+    [[nodiscard]] auto BlockRows() const -> size_t { return blockRows_; }
+    [[nodiscard]] auto BlockCount() const -> size_t { return (Rows() + blockRows_ - 1) / blockRows_; }
+
+    // the rows [b * BlockRows(), (b + 1) * BlockRows()), gathered on first access (thread-safe)
+    [[nodiscard]] auto Block(size_t b) const -> Dataset const&;
+
+    // gathers the rows of the range into an owned dataset (e.g. for a Problem)
+    [[nodiscard]] auto Materialize(Range range) const -> Dataset;
+    [[nodiscard]] auto Materialize() const -> Dataset { return Materialize({ 0, Rows() }); }
+
+private:
+    std::reference_wrapper<Dataset const> dataset_;
+    std::vector<size_t> indices_;
+    size_t blockRows_;
+    mutable std::vector<std::unique_ptr<Dataset>> blocks_;
+    mutable std::unique_ptr<std::once_flag[]> once_; // NOLINT
+};
+
+} // namespace Operon
+
+#endif
@@ -9,6 +9,7 @@
 #include "types.hpp" 
 #include <cstddef>
 #include <functional>
+#include <utility>
 
 namespace Operon {
 
@@ -16,7 +17,7 @@ struct LexicographicalComparison; // fwd def
 
 struct Individual {
     Tree Genotype;
-    Operon::Vector<Operon::Scalar> Fitness;
+    Operon::FitnessVector Fitness;
     size_t Rank{}; // domination rank; used by NSGA2
     Operon::Scalar Distance{}; // crowding distance; used by NSGA2
 
@@ -93,6 +94,23 @@ struct CrowdedComparison {
 
 using ComparisonCallback = std::function<bool(Individual const&, Individual const&)>;
 
+// an optional sort key for operators which compare individuals many times (compared lexicographically, smaller is
+// better), extracting the keys once into a contiguous array is cheaper than calling a ComparisonCallback per pair
+using ComparisonKey = std::pair<Operon::Scalar, Operon::Scalar>;
+using KeyCallback = std::function<ComparisonKey(Individual const&)>;
+
+// the key equivalent of SingleObjectiveComparison
+inline auto ObjectiveKey(size_t obj) -> KeyCallback
+{
+    return [obj](Individual const& ind) { return ComparisonKey { ind[obj], 0 }; };
+}
+
+// the key equivalent of CrowdedComparison (lower rank, then larger crowding distance)
+inline auto CrowdedKey() -> KeyCallback
+{
+    return [](Individual const& ind) { return ComparisonKey { static_cast<Operon::Scalar>(ind.Rank), -ind.Distance }; };
+}
+
 } // namespace Operon
 
 #endif
@@ -0,0 +1,309 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_CORE_INSTRUMENTATION_HPP
+#define OPERON_CORE_INSTRUMENTATION_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "operon/core/node.hpp"
+#include "operon/operon_export.hpp"
+
+// timing of the stages of the main loop and of the operators
+// - the library records the timings only if it was built with USE_INSTRUMENTATION (OPERON_INSTRUMENTATION), otherwise
+//   the timers below are empty and compile to nothing
+// - when built in, the recording is switched on at runtime with SetEnabled (a disabled timer only checks the flag)
+// - every thread accumulates its timings in its own counters, Snapshot sums them over the threads
+// - the cost of the primitives in the interpreter is a separate switch (SetPrimitiveProfiling), since timing every
+//   instruction slows down the evaluation and would distort the other timings
+// - the timers can also read the hardware performance counters of their thread (SetHardwareCounting, linux only),
+//   which tells whether a stage is limited by the cores or by the memory
+namespace Operon::Instrumentation {
+    // the stages carry the names of the tasks of the algorithms (see gp.cpp and nsga2.cpp)
+    enum class Stage : uint8_t {
+        InitializePopulation,
+        PrepareEvaluator,
+        EvaluatePopulation,
+        KeepElite,
+        PrepareGenerator,
+        GenerateOffspring,
+        NonDominatedSort,
+        UpdateDistance,
+        Reinsert,
+        Report,
+        Count
+    };
+
+    enum class Operator : uint8_t {
+        Crossover,
+        Mutation,
+        Evaluation,        // includes the local optimization
+        LocalOptimization, // the nonlinear least squares optimizer
+        Count
+    };
+
+    // the hardware events counted in user space by the perf events of a thread
+    // - CacheMisses are the misses of the last level cache (as defined by the kernel for the cpu), each of them moves
+    //   one cache line from or to the memory, which gives an estimate of the memory traffic (see Timing::Traffic)
+    enum class Event : uint8_t {
+        Cycles,
+        Instructions,
+        CacheMisses,
+        BranchMisses,
+        Count
+    };
+
+    static constexpr size_t StageCount = static_cast<size_t>(Stage::Count);
+    static constexpr size_t OperatorCount = static_cast<size_t>(Operator::Count);
+    static constexpr size_t EventCount = static_cast<size_t>(Event::Count);
+    static constexpr size_t CacheLineSize = 64;
+
+    using EventCounts = std::array<uint64_t, EventCount>;
+
+    [[nodiscard]] auto OPERON_EXPORT Name(Stage stage) -> char const*;
+    [[nodiscard]] auto OPERON_EXPORT Name(Operator op) -> char const*;
+    [[nodiscard]] auto OPERON_EXPORT Name(Event event) -> char const*;
+
+    // accumulated times in seconds
+    // - stages: Wall is the elapsed time of the stage (from its start to the end of its last task), Cpu the cpu time
+    //   spent by all the threads in its tasks, Calls the number of times the stage ran
+    // - operators: Wall and Cpu are summed over the calls
+    // - Events are the hardware counts of the threads while they were in the stage or the operator (zero unless
+    //   hardware counting is on). an operator includes the operators it calls (e.g. the evaluation the local
+    //   optimization), likewise the stages of the tasks calling the operators
+    struct Timing {
+        double Wall{0};
+        double Cpu{0};
+        uint64_t Calls{0};
+        EventCounts Events{};
+
+        [[nodiscard]] auto operator[](Event event) const -> uint64_t { return Events[static_cast<size_t>(event)]; }
+
+        // instructions per cycle
+        [[nodiscard]] auto Ipc() const -> double
+        {
+            auto const cycles = (*this)[Event::Cycles];
+            return cycles > 0 ? static_cast<double>((*this)[Event::Instructions]) / static_cast<double>(cycles) : 0.0;
+        }
+
+        // the estimated memory traffic in bytes, divided by Wall it approximates the bandwidth used by a stage
+        [[nodiscard]] auto Traffic() const -> double
+        {
+            return static_cast<double>((*this)[Event::CacheMisses]) * static_cast<double>(CacheLineSize);
+        }
+    };
+
+    struct Profile {
+        std::array<Timing, StageCount> Stages{};
+        std::array<Timing, OperatorCount> Operators{};
+
+        [[nodiscard]] auto operator[](Stage stage) const -> Timing const& { return Stages[static_cast<size_t>(stage)]; }
+        [[nodiscard]] auto operator[](Operator op) const -> Timing const& { return Operators[static_cast<size_t>(op)]; }
+    };
+
+    // the value type of an interpreter evaluation: Dual values are used for the forward mode jacobians
+    enum class ValueKind : uint8_t {
+        Scalar,
+        Dual,
+        Count
+    };
+
+    static constexpr size_t ValueKindCount = static_cast<size_t>(ValueKind::Count);
+
+    [[nodiscard]] auto OPERON_EXPORT Name(ValueKind kind) -> char const*;
+
+    // the time spent evaluating one primitive, summed over the batches of rows (see GenericInterpreter::EvaluateBlock)
+    struct PrimitiveTiming {
+        NodeType Type;
+        Operon::Hash HashValue; // distinguishes the dynamic (user defined) primitives, 0 for the built-in ones
+        ValueKind Kind;
+        double Time{0}; // seconds
+        uint64_t Calls{0}; // batches
+        uint64_t Rows{0};
+    };
+
+    struct PrimitiveProfile {
+        std::vector<PrimitiveTiming> Primitives; // the evaluated primitives, by decreasing time
+        // reverse mode jacobians (GenericInterpreter::EvaluateJacobian), including their forward pass
+        double JacobianTime{0};
+        uint64_t JacobianCalls{0};
+        uint64_t JacobianRows{0};
+    };
+
+    // true if the library records the timings (it was built with USE_INSTRUMENTATION)
+    [[nodiscard]] auto OPERON_EXPORT Available() -> bool;
+
+    auto OPERON_EXPORT SetEnabled(bool value) -> void;
+    [[nodiscard]] auto OPERON_EXPORT Enabled() -> bool;
+
+    // time every instruction of the interpreter (requires the library and the code including the interpreter to be
+    // built with USE_INSTRUMENTATION)
+    auto OPERON_EXPORT SetPrimitiveProfiling(bool value) -> void;
+    [[nodiscard]] auto OPERON_EXPORT PrimitiveProfiling() -> bool;
+
+    // count the hardware events in the timers (linux perf events, requires the library to be built with
+    // USE_INSTRUMENTATION and the timings to be enabled). every thread opens its events with its first timer, switching
+    // it on returns false (and leaves it off) if the calling thread cannot open any of the events, e.g. without a pmu
+    // in a virtual machine or if kernel.perf_event_paranoid forbids it. the events which cannot be opened count zero
+    auto OPERON_EXPORT SetHardwareCounting(bool value) -> bool;
+    [[nodiscard]] auto OPERON_EXPORT HardwareCounting() -> bool;
+
+    // the timings of all the threads so far (they keep being accumulated until Reset)
+    [[nodiscard]] auto OPERON_EXPORT Snapshot() -> Profile;
+    // the same per thread (e.g. per worker of the executor), in the order in which the threads first recorded something
+    [[nodiscard]] auto OPERON_EXPORT ThreadSnapshot() -> std::vector<Profile>;
+    [[nodiscard]] auto OPERON_EXPORT PrimitiveSnapshot() -> PrimitiveProfile;
+    // clears the timings (including the ones of the primitives), should not be called while the timers are running
+    auto OPERON_EXPORT Reset() -> void;
+
+    // nanoseconds
+    [[nodiscard]] auto OPERON_EXPORT WallTime() -> uint64_t;
+    [[nodiscard]] auto OPERON_EXPORT ThreadCpuTime() -> uint64_t; // of the calling thread
+    // the hardware counts of the calling thread since it opened its events (zero if they are not open)
+    auto OPERON_EXPORT ReadEvents(EventCounts& counts) -> void;
+
+    auto OPERON_EXPORT Record(Stage stage, uint64_t wall, uint64_t cpu, uint64_t calls) -> void;
+    auto OPERON_EXPORT Record(Operator op, uint64_t wall, uint64_t cpu, uint64_t calls) -> void;
+    auto OPERON_EXPORT RecordPrimitive(ValueKind kind, Node const& node, uint64_t time, uint64_t rows) -> void;
+    auto OPERON_EXPORT RecordJacobian(uint64_t time, uint64_t rows) -> void;
+    auto OPERON_EXPORT RecordEvents(Stage stage, EventCounts const& counts) -> void;
+    auto OPERON_EXPORT RecordEvents(Operator op, EventCounts const& counts) -> void;
+
+#if defined(OPERON_INSTRUMENTATION)
+    // the hardware counts of a timer, recorded as the difference between its start and its end
+    class EventSample {
+        EventCounts start_{};
+        bool active_{false};
+
+    public:
+        auto Start() -> void
+        {
+            active_ = HardwareCounting();
+            if (active_) { ReadEvents(start_); }
+        }
+
+        template<typename Kind>
+        auto Stop(Kind kind) -> void
+        {
+            if (!active_) { return; }
+            EventCounts counts{};
+            ReadEvents(counts);
+            for (size_t i = 0; i < EventCount; ++i) { counts[i] -= start_[i]; }
+            RecordEvents(kind, counts);
+        }
+    };
+
+    // records the wall and the cpu time of the enclosing scope as one call
+    template<typename Kind>
+    class ScopedTimer {
+        Kind kind_;
+        bool active_;
+        uint64_t wall_{0};
+        uint64_t cpu_{0};
+        EventSample events_;
+
+    public:
+        explicit ScopedTimer(Kind kind)
+            : kind_(kind)
+            , active_(Enabled())
+        {
+            if (active_) {
+                events_.Start();
+                wall_ = WallTime();
+                cpu_ = ThreadCpuTime();
+            }
+        }
+
+        ScopedTimer(ScopedTimer const&) = delete;
+        ScopedTimer(ScopedTimer&&) = delete;
+        auto operator=(ScopedTimer const&) -> ScopedTimer& = delete;
+        auto operator=(ScopedTimer&&) -> ScopedTimer& = delete;
+
+        ~ScopedTimer()
+        {
+            if (active_) {
+                Record(kind_, WallTime() - wall_, ThreadCpuTime() - cpu_, 1);
+                events_.Stop(kind_);
+            }
+        }
+    };
+
+    // records the cpu time of the enclosing scope, for the tasks of a parallel stage (whose elapsed time is given by
+    // an Interval)
+    class CpuTimer {
+        Stage stage_;
+        bool active_;
+        uint64_t cpu_{0};
+        EventSample events_;
+
+    public:
+        explicit CpuTimer(Stage stage)
+            : stage_(stage)
+            , active_(Enabled())
+        {
+            if (active_) {
+                events_.Start();
+                cpu_ = ThreadCpuTime();
+            }
+        }
+
+        CpuTimer(CpuTimer const&) = delete;
+        CpuTimer(CpuTimer&&) = delete;
+        auto operator=(CpuTimer const&) -> CpuTimer& = delete;
+        auto operator=(CpuTimer&&) -> CpuTimer& = delete;
+
+        ~CpuTimer()
+        {
+            if (active_) {
+                Record(stage_, 0, ThreadCpuTime() - cpu_, 0);
+                events_.Stop(stage_);
+            }
+        }
+    };
+
+    // the elapsed time of a parallel stage, started by the task before the stage and stopped by the task after it
+    // (the tasks are ordered by the taskflow, so the interval needs no synchronization). stopping an interval which
+    // is not running does nothing.
+    class Interval {
+        uint64_t start_{0};
+        bool running_{false};
+
+    public:
+        auto Start() -> void
+        {
+            running_ = Enabled();
+            if (running_) { start_ = WallTime(); }
+        }
+
+        auto Stop(Stage stage) -> void
+        {
+            if (running_) {
+                Record(stage, WallTime() - start_, 0, 1);
+                running_ = false;
+            }
+        }
+    };
+#else
+    template<typename Kind>
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(Kind /*unused*/) { }
+    };
+
+    class CpuTimer {
+    public:
+        explicit CpuTimer(Stage /*unused*/) { }
+    };
+
+    class Interval {
+    public:
+        auto Start() -> void { }
+        auto Stop(Stage /*unused*/) -> void { }
+    };
+#endif
+} // namespace Operon::Instrumentation
+
+#endif
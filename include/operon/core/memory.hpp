@@ -0,0 +1,141 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_CORE_MEMORY_HPP
+#define OPERON_CORE_MEMORY_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "operon/core/types.hpp"
+#include "operon/operon_export.hpp"
+
+namespace Operon {
+class Dataset;
+struct Individual;
+} // namespace Operon
+
+// accounting of the memory held by the subsystems of a run
+// - every subsystem has a counter of the bytes it holds, updated by its owner when it grows or shrinks (the updates are
+//   rare: population footprints once per generation, buffers when they grow, caches on insertion and eviction)
+// - the counters are estimates of the large allocations (node arrays, fitness vectors, value columns), not of the
+//   allocator overhead, the resident size of the process is reported separately
+// - soft limit: when the accounted total exceeds it, Enforce asks the registered reclaimers (the subtree caches) to
+//   evict and the interpreter buffers to shrink back on their next use, and the caches stop inserting
+namespace Operon::Memory {
+    enum class Subsystem : uint8_t {
+        Population,  // the individuals of the algorithms (genotypes and fitness)
+        Evaluator,   // the per worker buffers for the model responses
+        Interpreter, // the per thread evaluation buffers of the interpreter
+        Cache,       // the subtree caches
+        Dataset,     // the datasets and their replicas
+        Count
+    };
+
+    static constexpr size_t SubsystemCount = static_cast<size_t>(Subsystem::Count);
+
+    [[nodiscard]] auto OPERON_EXPORT Name(Subsystem subsystem) -> char const*;
+
+    auto OPERON_EXPORT Add(Subsystem subsystem, int64_t bytes) -> void;
+    [[nodiscard]] auto OPERON_EXPORT Usage(Subsystem subsystem) -> size_t;
+    [[nodiscard]] auto OPERON_EXPORT Total() -> size_t;
+
+    struct Report {
+        std::array<size_t, SubsystemCount> Subsystems{};
+        size_t Total{0};
+        size_t Resident{0}; // the resident size of the process (0 where it is not known)
+        size_t Limit{0};
+
+        [[nodiscard]] auto operator[](Subsystem subsystem) const -> size_t { return Subsystems[static_cast<size_t>(subsystem)]; }
+    };
+
+    [[nodiscard]] auto OPERON_EXPORT Snapshot() -> Report;
+    // read from /proc/self/statm on linux, 0 elsewhere
+    [[nodiscard]] auto OPERON_EXPORT ResidentBytes() -> size_t;
+
+    // the estimated size of the allocations of an individual, a population and a dataset
+    [[nodiscard]] auto OPERON_EXPORT Footprint(Individual const& individual) -> size_t;
+    [[nodiscard]] auto OPERON_EXPORT Footprint(Operon::Span<Individual const> individuals) -> size_t;
+    [[nodiscard]] auto OPERON_EXPORT Footprint(Dataset const& dataset) -> size_t;
+
+    // 0 disables the limit
+    auto OPERON_EXPORT SetSoftLimit(size_t bytes) -> void;
+    [[nodiscard]] auto OPERON_EXPORT SoftLimit() -> size_t;
+    [[nodiscard]] auto OPERON_EXPORT OverLimit() -> bool;
+
+    // a reclaimer receives the number of bytes over the limit and returns the number of bytes it released
+    using Reclaimer = std::function<size_t(size_t)>;
+    [[nodiscard]] auto OPERON_EXPORT Register(Reclaimer reclaimer) -> size_t;
+    auto OPERON_EXPORT Unregister(size_t id) -> void;
+
+    // if the total is over the limit: runs the reclaimers and tells the buffers to shrink, returns the bytes released by
+    // the reclaimers (the algorithms call it once per generation)
+    auto OPERON_EXPORT Enforce() -> size_t;
+    // incremented by every Enforce which found the total over the limit, see Buffer
+    [[nodiscard]] auto OPERON_EXPORT Epoch() -> uint64_t;
+
+    // the bytes of one owner accounted to a subsystem, released on destruction
+    class Account {
+        Subsystem subsystem_;
+        size_t bytes_{0};
+
+    public:
+        explicit Account(Subsystem subsystem, size_t bytes = 0)
+            : subsystem_(subsystem)
+        {
+            Update(bytes);
+        }
+
+        Account(Account const&) = delete;
+        Account(Account&& other) noexcept
+            : subsystem_(other.subsystem_)
+            , bytes_(other.bytes_)
+        {
+            other.bytes_ = 0;
+        }
+        auto operator=(Account const&) -> Account& = delete;
+        auto operator=(Account&&) -> Account& = delete;
+        ~Account() { Update(0); }
+
+        auto Update(size_t bytes) -> void
+        {
+            if (bytes == bytes_) { return; }
+            Add(subsystem_, static_cast<int64_t>(bytes) - static_cast<int64_t>(bytes_));
+            bytes_ = bytes;
+        }
+
+        [[nodiscard]] auto Bytes() const -> size_t { return bytes_; }
+    };
+
+    // a growable buffer (a vector of fixed size elements) accounted to a subsystem, for the thread local scratch space:
+    // it only grows, except after an Enforce over the limit, when it is shrunk to the requested size on its next use.
+    // the contents are not preserved across a shrink.
+    template<typename Vector>
+    class Buffer {
+        Vector data_;
+        Account account_;
+        uint64_t epoch_;
+
+    public:
+        explicit Buffer(Subsystem subsystem)
+            : account_(subsystem)
+            , epoch_(Epoch())
+        {
+        }
+
+        auto Get(size_t size) -> Vector&
+        {
+            if (auto epoch = Epoch(); epoch != epoch_) {
+                epoch_ = epoch;
+                if (data_.size() > size) { Vector(size).swap(data_); }
+            }
+            if (data_.size() < size) { data_.resize(size); }
+            account_.Update(data_.capacity() * sizeof(typename Vector::value_type));
+            return data_;
+        }
+    };
+} // namespace Operon::Memory
+
+#endif
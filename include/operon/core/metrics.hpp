@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_CORE_METRICS_HPP
+#define OPERON_CORE_METRICS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "operon/core/concurrent_queue.hpp"
+#include "operon/operon_export.hpp"
+
+namespace Operon {
+
+struct MetricsConfig {
+    std::string JsonLines;   // the json lines file (one object per sample, appended), empty: none
+    std::string Prometheus;  // the prometheus text file (replaced after every sample, e.g. for the textfile collector of the node exporter), empty: none
+    std::string Prefix{"operon"};            // of the prometheus metric names
+    std::chrono::milliseconds Interval{200}; // how often the writer looks for new samples // NOLINT
+    size_t Capacity{1024};                   // samples waiting to be written, further samples are dropped // NOLINT
+};
+
+// the state of a run after a generation
+struct MetricsSample {
+    size_t Generation{0};
+    double Elapsed{0}; // seconds since the start of the run
+    size_t Evaluations{0};
+    std::vector<std::pair<std::string, double>> Values; // e.g. the best fitness, the average length, the memory
+};
+
+// structured metrics of a run, for dashboards
+// - Push only moves the sample into a lock-free queue: a background thread writes the files, so emitting metrics never
+//   blocks the evolutionary loop (if the writer falls behind the samples are dropped and counted)
+// - the writer adds the rates between consecutive samples (evaluations per second, seconds per generation) and, when
+//   the instrumentation is enabled, the accumulated stage and operator timings (see Instrumentation::Snapshot), and the
+//   memory held by the subsystems (see Memory::Snapshot)
+// - the destructor writes the remaining samples
+class OPERON_EXPORT MetricsSink {
+    MetricsConfig config_;
+    ConcurrentQueue<MetricsSample> queue_;
+
+    std::atomic_size_t dropped_{0};
+    std::atomic_size_t written_{0};
+
+    std::mutex lock_;
+    std::condition_variable wake_;
+    bool stop_{false};
+    std::thread writer_;
+
+    auto Run() -> void;
+
+public:
+    explicit MetricsSink(MetricsConfig config);
+
+    MetricsSink(MetricsSink const&) = delete;
+    MetricsSink(MetricsSink&&) = delete;
+    auto operator=(MetricsSink const&) -> MetricsSink& = delete;
+    auto operator=(MetricsSink&&) -> MetricsSink& = delete;
+    ~MetricsSink();
+
+    // returns false if the sample was dropped
+    auto Push(MetricsSample sample) -> bool;
+
+    [[nodiscard]] auto Dropped() const -> size_t { return dropped_.load(std::memory_order_relaxed); }
+    [[nodiscard]] auto Written() const -> size_t { return written_.load(std::memory_order_relaxed); }
+    [[nodiscard]] auto GetConfig() const -> MetricsConfig const& { return config_; }
+};
+
+} // namespace Operon
+
+#endif
@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_CORE_MODEL_ARCHIVE_HPP
+#define OPERON_CORE_MODEL_ARCHIVE_HPP
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <robin_hood.h>
+#include <string>
+#include <vector>
+
+#include "individual.hpp"
+#include "types.hpp"
+#include "variable.hpp"
+#include "operon/operon_export.hpp"
+
+namespace Operon {
+
+// an archive of models (e.g. the pareto front of a run) to seed the populations of later runs, without formatting the
+// models to infix and parsing them again
+// - the models are stored as their postfix node arrays as they are in memory (including the derived fields like length
+//   and parent, so the trees are usable as read), followed by their fitness. the nodes start at an aligned offset and
+//   the archive is memory mapped, so the models are copied straight out of the mapping
+// - the names of the variables are stored next to their hash values, so the models can be used with another dataset
+//   (e.g. with the columns in a different order or hashed differently): Remap translates the hashes by name
+// - the values are written in the native layout and byte order: the archive can only be read by the same build,
+//   which is checked by the header
+class OPERON_EXPORT ModelArchive {
+public:
+    static constexpr std::array<char, 8> Magic { 'O', 'P', 'E', 'R', 'O', 'N', 'M', 'A' };
+    static constexpr uint32_t Version = 1;
+    static constexpr size_t Alignment = 64;
+
+    // writes the genotypes and the fitness of the individuals (which must have the same number of objectives). the
+    // variables give the names of the variables used by the models, the metadata is stored as is (e.g. a json string)
+    static auto Write(std::string const& path, Operon::Span<Individual const> individuals, Operon::Span<Variable const> variables, std::string const& metadata = {}) -> void;
+
+    // maps the archive into memory
+    explicit ModelArchive(std::string const& path);
+
+    // translate the variable hashes of the models to those of the given variables with the same names (e.g. the
+    // variables of the dataset of the next run). throws if a variable of the archive is missing
+    auto Remap(Operon::Span<Variable const> variables) -> void;
+
+    [[nodiscard]] auto Size() const -> size_t { return index_.size(); }
+    [[nodiscard]] auto Objectives() const -> size_t { return objectives_; }
+    [[nodiscard]] auto Metadata() const -> std::string const& { return metadata_; }
+    // the variables used by the models, with their hash values as written
+    [[nodiscard]] auto Variables() const -> std::vector<Variable> const& { return variables_; }
+
+    // the nodes of model i in the mapping, with the variable hashes as written
+    [[nodiscard]] auto Nodes(size_t i) const -> Operon::Span<Node const>;
+    [[nodiscard]] auto Fitness(size_t i) const -> Operon::Span<Operon::Scalar const>;
+
+    // model i with the remapped variable hashes
+    [[nodiscard]] auto GetTree(size_t i) const -> Tree;
+    [[nodiscard]] auto GetIndividual(size_t i) const -> Individual;
+
+private:
+    struct Entry {
+        uint64_t First;  // index of the first node
+        uint64_t Length;
+    };
+
+    std::shared_ptr<void const> storage_; // the mapping
+    Operon::Span<Node const> nodes_;
+    std::vector<Entry> index_;
+    std::vector<Operon::Scalar> fitness_;
+    std::vector<Variable> variables_;
+    robin_hood::unordered_flat_map<Operon::Hash, Operon::Hash> remap_; // empty if the hashes are unchanged
+    std::string metadata_;
+    size_t objectives_ { 0 };
+};
+
+} // namespace Operon
+
+#endif
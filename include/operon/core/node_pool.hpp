@@ -0,0 +1,38 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_CORE_NODE_POOL_HPP
+#define OPERON_CORE_NODE_POOL_HPP
+
+#include "operon/operon_export.hpp"
+#include "node.hpp"
+#include "tree.hpp"
+#include "types.hpp"
+
+namespace Operon {
+
+// recycles the node buffers backing the trees, so that the evolutionary loop does not go through the global
+// allocator for every offspring: the algorithms release the trees of the discarded individuals and the variation
+// operators acquire their output buffers from the pool
+// - every thread keeps its own free list, acquiring and releasing buffers never locks
+// - the free lists are bounded (MaxBuffers), surplus buffers are deallocated
+struct OPERON_EXPORT NodePool {
+    static constexpr size_t MaxBuffers = 1024;
+
+    // an empty buffer with at least the requested capacity
+    [[nodiscard]] static auto Acquire(size_t capacity) -> Operon::Vector<Node>;
+
+    static void Release(Operon::Vector<Node>&& nodes);
+    static void Release(Tree&& tree) { Release(std::move(tree).Nodes()); }
+
+    // a copy of the tree whose nodes live in a recycled buffer
+    [[nodiscard]] static auto Copy(Tree const& tree) -> Tree;
+
+    // the number of buffers in the free list of the calling thread
+    [[nodiscard]] static auto Size() -> size_t;
+    static void Clear();
+};
+
+} // namespace Operon
+
+#endif
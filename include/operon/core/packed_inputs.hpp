@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_PACKED_INPUTS_HPP
+#define OPERON_PACKED_INPUTS_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include "allocation.hpp"
+#include "dataset.hpp"
+#include "types.hpp"
+#include "variable.hpp"
+#include "operon/operon_export.hpp"
+
+namespace Operon {
+
+// a copy of the input variables of a problem laid out in row tiles: tile t holds the rows [t * TileRows, (t + 1) *
+// TileRows) of all the inputs, one column after the other (tile-major, column-within-tile). with tiles of one
+// interpreter batch, the variables of a batch are a single contiguous block instead of one page per column, which
+// keeps the prefetcher and the tlb effective on wide datasets (see GenericInterpreter::Compile)
+// - the last tile is padded with zeros to the full tile size
+// - the copy follows the allocation policy (see Memory::AllocationPolicy): it is aligned to a cache line, so are its
+//   columns when the tile rows are a multiple of a cache line of scalars, and it can be backed by huge pages
+// - the copy is not updated with the dataset, it has to be built again after modifying the inputs
+class OPERON_EXPORT PackedInputs {
+public:
+    PackedInputs(Dataset const& dataset, Operon::Span<Variable const> inputs, size_t tileRows);
+
+    [[nodiscard]] auto Rows() const -> size_t { return rows_; }
+    [[nodiscard]] auto Cols() const -> size_t { return hashes_.size(); }
+    [[nodiscard]] auto TileRows() const -> size_t { return tileRows_; }
+    // the distance between two consecutive tiles (in scalars)
+    [[nodiscard]] auto TileStride() const -> size_t { return tileRows_ * Cols(); }
+    [[nodiscard]] auto Tiles() const -> size_t { return (rows_ + tileRows_ - 1) / tileRows_; }
+
+    // the position of the variable in a tile, -1 if it is not packed
+    [[nodiscard]] auto Column(Operon::Hash hash) const -> int64_t;
+
+    // the values of the column in the first tile: the row r of the column is found TileOffset(r) scalars further
+    [[nodiscard]] auto Values(size_t column) const -> Operon::Scalar const* { return values_.data() + column * tileRows_; }
+    [[nodiscard]] auto TileOffset(size_t row) const -> size_t { return row / tileRows_ * TileStride() + row % tileRows_; }
+
+    [[nodiscard]] auto Value(size_t row, size_t column) const -> Operon::Scalar { return Values(column)[TileOffset(row)]; }
+    [[nodiscard]] auto SizeInBytes() const -> size_t { return values_.size() * sizeof(Operon::Scalar); }
+
+private:
+    size_t rows_;
+    size_t tileRows_;
+    std::vector<Operon::Hash> hashes_;
+    Memory::AlignedVector<Operon::Scalar> values_;
+};
+
+} // namespace Operon
+
+#endif
@@ -0,0 +1,109 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_CORE_PARETO_ARCHIVE_HPP
+#define OPERON_CORE_PARETO_ARCHIVE_HPP
+
+#include <cstdint>
+#include <shared_mutex>
+#include <vector>
+
+#include "compact_tree.hpp"
+#include "individual.hpp"
+#include "types.hpp"
+#include "operon/operon_export.hpp"
+
+namespace Operon {
+
+// an epsilon-dominance archive of the non-dominated individuals seen during a run (Laumanns et al., 2002)
+// - the objective space (minimized) is divided into boxes of size epsilon, box_k = floor(f_k / epsilon_k). the archive
+//   holds at most one individual per box and only boxes which are not dominated by another box, so its size is bounded
+//   by the resolution and the good trade-offs are kept when they drop out of the population
+// - of two individuals in the same box the dominating one is kept, otherwise the one closer to the corner of the box
+//   (the earlier one on ties)
+// - the boxes are indexed by a kd-tree with the bounds of every subtree: the dominance queries only visit the
+//   subtrees intersecting the dominating (or dominated) orthant, which is logarithmic in the size of the archive for
+//   a few objectives. the tree is rebuilt balanced when the removed members or the depth grow too large
+// - Insert can be called concurrently (e.g. by the tasks evaluating the offspring) and with the queries: a candidate
+//   is first tested under a shared lock, so the rejected ones (most of them, later in a run) do not serialize
+// - the archive outlives the populations of a run, its members are kept as compact trees (see CompactTree) and turned
+//   back into individuals by Members
+class OPERON_EXPORT ParetoArchive {
+public:
+    // one epsilon per objective
+    explicit ParetoArchive(std::vector<Operon::Scalar> epsilon);
+    // the same epsilon for all the objectives
+    ParetoArchive(size_t objectives, Operon::Scalar epsilon)
+        : ParetoArchive(std::vector<Operon::Scalar>(objectives, epsilon))
+    {
+    }
+
+    // returns true if the individual was added (individuals with non-finite objectives are rejected)
+    auto Insert(Individual const& individual) -> bool;
+    // returns the number of individuals added
+    auto Insert(Operon::Span<Individual const> individuals) -> size_t;
+
+    // whether a member dominates the box of the objective values, or shares it and dominates them
+    [[nodiscard]] auto Dominates(Operon::Span<Operon::Scalar const> fitness) const -> bool;
+
+    // a copy of the members, in no particular order
+    [[nodiscard]] auto Members() const -> std::vector<Individual>;
+    [[nodiscard]] auto Size() const -> size_t;
+    [[nodiscard]] auto Objectives() const -> size_t { return epsilon_.size(); }
+    [[nodiscard]] auto Epsilon() const -> Operon::Span<Operon::Scalar const> { return { epsilon_.data(), epsilon_.size() }; }
+
+    auto Clear() -> void;
+
+private:
+    using Box = std::vector<int64_t>;
+
+    struct Node {
+        size_t Entry;
+        int64_t Left{-1};
+        int64_t Right{-1};
+        size_t Axis{0};
+    };
+
+    // the kind of the relation of a candidate to the members, see Query
+    struct Relation {
+        bool Dominated{false}; // a member box dominates the candidate box
+        int64_t Same{-1};      // the member sharing the box of the candidate
+    };
+
+    std::vector<Operon::Scalar> epsilon_;
+
+    mutable std::shared_mutex lock_;
+    struct Member {
+        CompactTree Genotype;
+        Operon::FitnessVector Fitness;
+    };
+    std::vector<Member> members_;
+    std::vector<int64_t> boxes_; // row-major (entries x objectives)
+    std::vector<bool> alive_;
+    size_t size_{0};
+
+    std::vector<Node> nodes_;
+    std::vector<int64_t> lower_; // the smallest box coordinates in the subtree of every node
+    std::vector<int64_t> upper_; // the largest box coordinates in the subtree of every node
+    int64_t root_{-1};
+    size_t depth_{0};
+    size_t rebuilt_{0}; // the number of entries after the last rebuild
+
+    [[nodiscard]] auto BoxOf(Operon::Span<Operon::Scalar const> fitness, Box& box) const -> bool;
+    [[nodiscard]] auto BoxOf(size_t entry) const -> int64_t const* { return boxes_.data() + entry * Objectives(); }
+
+    [[nodiscard]] auto Query(Box const& box) const -> Relation;
+    // whether the candidate loses against the member in its box
+    [[nodiscard]] auto Loses(Operon::Span<Operon::Scalar const> fitness, Box const& box, size_t member) const -> bool;
+    [[nodiscard]] auto Rejects(Operon::Span<Operon::Scalar const> fitness, Box const& box) const -> bool;
+
+    auto Remove(size_t entry) -> void;
+    // removes the members whose boxes are dominated by the box
+    auto RemoveDominated(Box const& box) -> void;
+    auto Add(Individual const& individual, Box const& box) -> void;
+    auto Rebuild() -> void;
+};
+
+} // namespace Operon
+
+#endif
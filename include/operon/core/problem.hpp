@@ -4,11 +4,13 @@
 #ifndef PROBLEM_HPP
 #define PROBLEM_HPP
 
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "dataset.hpp"
+#include "packed_inputs.hpp"
 #include "pset.hpp"
 #include "range.hpp"
 
@@ -67,12 +69,14 @@ public:
     }
 
     auto Inputs(std::vector<Variable> const& inputs) -> Problem& {
+        packed_.reset();
         inputVariables_.clear();
         std::copy(inputs.begin(), inputs.end(), std::back_inserter(inputVariables_));
         return *this;
     }
 
     auto Inputs(Operon::Span<const Variable> inputs) -> Problem& {
+        packed_.reset();
         inputVariables_.clear();
         std::copy(inputs.begin(), inputs.end(), std::back_inserter(inputVariables_));
         return *this;
@@ -87,6 +91,7 @@ public:
             }
             tmp.push_back(res.value());
         }
+        packed_.reset();
         inputVariables_.swap(tmp);
         return *this;
     }
@@ -104,20 +109,39 @@ public:
     [[nodiscard]]  auto InputVariables() const -> Operon::Span<const Variable> { return inputVariables_; }
     auto TargetValues() -> Operon::Span<const Operon::Scalar> { return dataset_.GetValues(target_.Hash); }
 
+    // builds the row tiled copy of the input variables evaluated by the interpreter instead of the dataset columns
+    // (see PackedInputs), with tiles of one batch (e.g. detail::BatchSize<Operon::Scalar>::Value). it is built after the
+    // preprocessing: changing the inputs or scaling the data drops it, other changes to the dataset need another call.
+    // the copies of the problem share it
+    auto PackInputs(size_t tileRows) -> Problem& {
+        packed_ = std::make_shared<PackedInputs const>(dataset_, InputVariables(), tileRows);
+        return *this;
+    }
+
+    // the packed inputs, nullptr if they were not built
+    [[nodiscard]] auto GetPackedInputs() const -> PackedInputs const* { return packed_.get(); }
+
+    // the input columns are transformed in parallel (see Dataset::Preprocess)
     void StandardizeData(Range range)
     {
-        for (auto const& var : inputVariables_) {
-            dataset_.Standardize(var.Index, range);
-        }
+        packed_.reset();
+        dataset_.Preprocess(InputColumns(), range, ColumnScaling::Standardize);
     }
 
     void NormalizeData(Range range) {
-        for (auto const& var : inputVariables_) {
-            dataset_.Normalize(var.Index, range);
-        }
+        packed_.reset();
+        dataset_.Preprocess(InputColumns(), range, ColumnScaling::Normalize);
     }
 
 private:
+    [[nodiscard]] auto InputColumns() const -> std::vector<size_t>
+    {
+        std::vector<size_t> columns;
+        columns.reserve(inputVariables_.size());
+        for (auto const& var : inputVariables_) { columns.push_back(var.Index); }
+        return columns;
+    }
+
     Dataset dataset_;
     PrimitiveSet pset_;
     Range training_;
@@ -125,6 +149,7 @@ private:
     Range validation_;
     Variable target_;
     std::vector<Variable> inputVariables_;
+    std::shared_ptr<PackedInputs const> packed_;
 };
 } // namespace Operon
 
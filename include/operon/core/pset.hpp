@@ -7,6 +7,7 @@
 #include <robin_hood.h>
 #include "contracts.hpp"
 #include "node.hpp"
+#include "operon/random/alias_table.hpp"
 
 
 namespace Operon {
@@ -34,6 +35,20 @@ class PrimitiveSet {
         return const_cast<Primitive&>(const_cast<PrimitiveSet const*>(this)->GetPrimitive(hash)); // NOLINT
     }
 
+    // symbol sampling tables, rebuilt by every modifying method so that sampling is lock- and allocation-free
+    // - the candidates are the enabled primitives with a nonzero frequency
+    // - there is one alias table for every arity range [lo, hi] with hi <= the largest candidate arity
+    //   (ranges are clamped to that arity), when the largest arity exceeds MaxTabulatedArity the candidates
+    //   are scanned instead
+    static constexpr size_t MaxTabulatedArity = 16;
+    std::vector<Primitive> candidates_;
+    std::vector<Node> enabled_;
+    size_t tabulatedArity_{0};
+    std::vector<Random::AliasTable> tables_; // indexed by lo * (tabulatedArity_ + 1) + hi
+    std::vector<std::vector<size_t>> members_; // the candidate indices of each table
+
+    OPERON_EXPORT void UpdateSamplingTables();
+
 public:
     static constexpr PrimitiveSetConfig Arithmetic = NodeType::Constant | NodeType::Variable | NodeType::Add | NodeType::Sub | NodeType::Mul | NodeType::Div;
     static constexpr PrimitiveSetConfig TypeCoherent = Arithmetic | NodeType::Pow | NodeType::Exp | NodeType::Log | NodeType::Sin | NodeType::Cos | NodeType::Square;
@@ -51,11 +66,16 @@ public:
     auto AddPrimitive(Operon::Node node, size_t frequency, size_t minArity, size_t maxArity) -> bool
     {
         auto [_, ok] = pset_.insert({ node.HashValue, Primitive { node, frequency, minArity, maxArity } });
+        UpdateSamplingTables();
         return ok;
     }
-    void RemovePrimitive(Operon::Node node) { pset_.erase(node.HashValue); }
+    void RemovePrimitive(Operon::Node node) { RemovePrimitive(node.HashValue); }
 
-    void RemovePrimitive(Operon::Hash hash) { pset_.erase(hash); }
+    void RemovePrimitive(Operon::Hash hash)
+    {
+        pset_.erase(hash);
+        UpdateSamplingTables();
+    }
 
     void SetConfig(PrimitiveSetConfig config)
     {
@@ -68,18 +88,10 @@ public:
                 pset_[n.HashValue] = { n, 1, n.Arity, n.Arity };
             }
         }
+        UpdateSamplingTables();
     }
 
-    [[nodiscard]] auto EnabledPrimitives() const -> std::vector<Node> {
-        std::vector<Node> nodes;
-        for (auto const& [k, v] : pset_) {
-            auto [node, freq, min_arity, max_arity] = v;
-            if (node.IsEnabled && freq > 0) {
-                nodes.push_back(node);
-            }
-        }
-        return nodes;
-    }
+    [[nodiscard]] auto EnabledPrimitives() const -> std::vector<Node> const& { return enabled_; }
 
     [[nodiscard]] auto Config() const -> PrimitiveSetConfig
     {
@@ -103,6 +115,7 @@ public:
     {
         auto& p = GetPrimitive(hash);
         std::get<FREQUENCY>(p) = frequency;
+        UpdateSamplingTables();
     }
 
     [[nodiscard]] auto Contains(Operon::Hash hash) const -> bool { return pset_.contains(hash); }
@@ -117,6 +130,7 @@ public:
     {
         auto& p = GetPrimitive(hash);
         std::get<NODE>(p).IsEnabled = enabled;
+        UpdateSamplingTables();
     }
 
     void Enable(Operon::Hash hash)
@@ -147,6 +161,7 @@ public:
         EXPECT(minArity <= MaximumArity(hash));
         auto& p = GetPrimitive(hash);
         std::get<MINARITY>(p) = minArity;
+        UpdateSamplingTables();
     }
 
     [[nodiscard]] auto MinimumArity(Operon::Hash hash) const -> size_t
@@ -160,6 +175,7 @@ public:
         EXPECT(maxArity >= MinimumArity(hash));
         auto& p = GetPrimitive(hash);
         std::get<MAXARITY>(p) = maxArity;
+        UpdateSamplingTables();
     }
 
     [[nodiscard]] auto MaximumArity(Operon::Hash hash) const -> size_t
@@ -180,6 +196,7 @@ public:
         auto& p = GetPrimitive(hash);
         std::get<MINARITY>(p) = minArity;
         std::get<MAXARITY>(p) = maxArity;
+        UpdateSamplingTables();
     }
 
     // convenience overloads
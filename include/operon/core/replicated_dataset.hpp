@@ -0,0 +1,40 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_CORE_REPLICATED_DATASET_HPP
+#define OPERON_CORE_REPLICATED_DATASET_HPP
+
+#include <memory>
+#include <vector>
+
+#include "dataset.hpp"
+#include "memory.hpp"
+#include "operon/operon_export.hpp"
+
+namespace Operon {
+
+// read-only copies of a dataset, one per numa node, so that the workers bound to a node (see Affinity::Pin) read
+// the training data from local memory instead of streaming it over the interconnect
+// - every copy is made by a thread bound to its node, the pages are first touched there and the operating system
+//   places them on that node
+// - views are materialized, so every replica owns its values
+// - the replicas are not updated: they must be created after the data was preprocessed (eg. standardized)
+class OPERON_EXPORT ReplicatedDataset {
+    std::vector<std::unique_ptr<Dataset const>> replicas_;
+    Memory::Account memory_{Memory::Subsystem::Dataset};
+
+public:
+    // one replica per numa node of the machine (see Affinity::Nodes)
+    explicit ReplicatedDataset(Dataset const& dataset);
+    ReplicatedDataset(Dataset const& dataset, size_t nodes);
+
+    [[nodiscard]] auto Size() const -> size_t { return replicas_.size(); }
+    [[nodiscard]] auto Replica(size_t node) const -> Dataset const& { return *replicas_[node % replicas_.size()]; }
+
+    // the replica of the numa node the calling thread is bound to
+    [[nodiscard]] auto Local() const -> Dataset const&;
+};
+
+} // namespace Operon
+
+#endif
@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_CORE_SERIALIZATION_HPP
+#define OPERON_CORE_SERIALIZATION_HPP
+
+#include <cstddef>
+#include <robin_hood.h>
+#include <utility>
+#include <vector>
+
+#include "individual.hpp"
+#include "types.hpp"
+#include "variable.hpp"
+#include "operon/operon_export.hpp"
+
+namespace Operon {
+class Dataset;
+} // namespace Operon
+
+namespace Operon::Serialization {
+    // compact binary encoding of individuals, used to migrate them between processes
+    // - a header with the number of nodes and the number of objectives, followed by the postfix nodes and the fitness
+    // - every node only keeps the fields which cannot be recomputed (hash, value, arity, type, enabled), the structure
+    //   of the tree (length, depth, level, parent) is restored with Tree::UpdateNodes on the receiving side
+    // - the values are written in the native byte order and with the native Operon::Scalar type, so the sending and
+    //   the receiving process must run the same build
+    static constexpr size_t NodeSize = sizeof(Operon::Hash) + sizeof(Operon::Scalar) + sizeof(uint16_t) + sizeof(uint32_t) + sizeof(uint8_t);
+    static constexpr size_t HeaderSize = 2 * sizeof(uint32_t);
+
+    // the number of bytes Write appends for this individual
+    [[nodiscard]] auto OPERON_EXPORT Size(Individual const& ind) -> size_t;
+
+    // appends the encoding of the individual to the buffer
+    auto OPERON_EXPORT Write(Individual const& ind, std::vector<std::byte>& buffer) -> void;
+
+    // decodes the individual starting at offset and advances the offset past it
+    [[nodiscard]] auto OPERON_EXPORT Read(Operon::Span<std::byte const> buffer, size_t& offset) -> Individual;
+
+    // a sequence of individuals: their count followed by their encodings
+    [[nodiscard]] auto OPERON_EXPORT Write(Operon::Span<Individual const> individuals) -> std::vector<std::byte>;
+    [[nodiscard]] auto OPERON_EXPORT Read(Operon::Span<std::byte const> buffer) -> std::vector<Individual>;
+
+    // the storage of the node values in the compact encoding: the native Operon::Scalar, a float, or a bfloat16 (the
+    // upper half of a float, about three significant digits)
+    enum class Precision : uint8_t { Exact, Single, BFloat16 };
+
+    // compact encoding of individuals for the network and the logs, several times smaller than the one above
+    // - a node starts with a tag byte: the index of its type (5 bits) and three flags (the arity is not the default of
+    //   the type, the value is not one, the node is disabled), followed by the arity as a varint if needed, the index
+    //   of the variable in the variable table as a varint, the hash of a dynamic primitive and the value if needed
+    // - an individual is the number of nodes and of objectives as varints, its nodes and its fitness (always exact)
+    // - both sides need the same variable table (e.g. the variables of the same dataset), the hashes of the variables
+    //   are not sent. the structure of the trees is restored with Tree::UpdateNodes like above
+    class OPERON_EXPORT CompactCodec {
+    public:
+        explicit CompactCodec(Operon::Span<Variable const> variables, Precision precision = Precision::Exact);
+        // the variables and the virtual variables of the dataset
+        explicit CompactCodec(Dataset const& dataset, Precision precision = Precision::Exact);
+
+        // the value as it is decoded
+        [[nodiscard]] auto Quantize(Operon::Scalar value) const -> Operon::Scalar;
+
+        auto Encode(Individual const& ind, std::vector<std::byte>& buffer) const -> void;
+        [[nodiscard]] auto Decode(Operon::Span<std::byte const> buffer, size_t& offset) const -> Individual;
+
+        // a sequence of individuals: their count (varint) followed by their encodings
+        [[nodiscard]] auto Encode(Operon::Span<Individual const> individuals) const -> std::vector<std::byte>;
+        [[nodiscard]] auto Decode(Operon::Span<std::byte const> buffer) const -> std::vector<Individual>;
+
+        // the nodes only, without the header of the individual (see DeltaEncoder)
+        auto EncodeNodes(Operon::Span<Node const> nodes, std::vector<std::byte>& buffer) const -> void;
+        auto DecodeNodes(Operon::Span<std::byte const> buffer, size_t& offset, size_t count, Operon::Vector<Node>& nodes) const -> void;
+
+        [[nodiscard]] auto GetPrecision() const -> Precision { return precision_; }
+
+    private:
+        std::vector<Operon::Hash> hashes_; // the variable hashes by index
+        robin_hood::unordered_flat_map<Operon::Hash, uint64_t> indices_;
+        Precision precision_;
+    };
+
+    // delta encoding of the successive populations of a run (e.g. a log of the parents of every generation), against
+    // the population of the previous frame
+    // - an individual refers to an individual of the previous population with which it shares a prefix and a suffix
+    //   of its postfix nodes, only the nodes in between are encoded. this covers the copies (elitism, reinsertion) and
+    //   the offspring of subtree crossover and mutation, which replace one subtree of a parent
+    // - the references are looked up by the nodes of the whole tree, of its first and of its last nodes
+    // - a frame starts with its size in bytes (varint), the frames of a run can be appended to a file and decoded in
+    //   order by a DeltaDecoder with the same codec
+    class OPERON_EXPORT DeltaEncoder {
+    public:
+        explicit DeltaEncoder(CompactCodec codec)
+            : codec_(std::move(codec))
+        {
+        }
+
+        // encodes the population against the previous one, which it then replaces
+        [[nodiscard]] auto Encode(Operon::Span<Individual const> individuals) -> std::vector<std::byte>;
+        // the next frame is encoded without reference (e.g. at the start of a new file)
+        auto Reset() -> void { reference_.clear(); }
+
+        [[nodiscard]] auto GetCodec() const -> CompactCodec const& { return codec_; }
+
+    private:
+        CompactCodec codec_;
+        std::vector<Operon::Vector<Node>> reference_; // the previous population, as the decoder sees it
+    };
+
+    class OPERON_EXPORT DeltaDecoder {
+    public:
+        explicit DeltaDecoder(CompactCodec codec)
+            : codec_(std::move(codec))
+        {
+        }
+
+        // decodes the frame starting at offset and advances the offset past it
+        [[nodiscard]] auto Decode(Operon::Span<std::byte const> buffer, size_t& offset) -> std::vector<Individual>;
+        auto Reset() -> void { reference_.clear(); }
+
+    private:
+        CompactCodec codec_;
+        std::vector<Operon::Vector<Node>> reference_;
+    };
+} // namespace Operon::Serialization
+
+#endif
@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_CORE_SHARDED_COUNTER_HPP
+#define OPERON_CORE_SHARDED_COUNTER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+
+#include "contracts.hpp"
+
+namespace Operon {
+
+// event counter for many concurrent writers
+// - every thread increments its own shard (threads are assigned to the shards round-robin), the shards live on
+//   separate cache lines so the writers do not invalidate each other's caches
+// - every Batch increments of a shard are published to a shared total, which is a cheap lower bound on the count:
+//   Approximate() <= Load() < Approximate() + Slack()
+// - Load() sums the shards and is exact once the writers are done
+template<size_t Batch = 64> // NOLINT
+class ShardedCounter {
+    static constexpr size_t CacheLine = 64;
+    static constexpr size_t MaxShards = 256;
+
+    struct alignas(CacheLine) Shard {
+        std::atomic_size_t Value{0};
+    };
+
+    std::unique_ptr<Shard[]> shards_; // NOLINT(cppcoreguidelines-avoid-c-arrays,hicpp-avoid-c-arrays,modernize-avoid-c-arrays)
+    size_t mask_;
+    alignas(CacheLine) std::atomic_size_t published_{0};
+
+    // the shard of the calling thread
+    static auto Index() noexcept -> size_t
+    {
+        static std::atomic_size_t next{0};
+        thread_local size_t const index = next.fetch_add(1, std::memory_order_relaxed);
+        return index;
+    }
+
+    static auto DefaultShards() -> size_t
+    {
+        return std::clamp(static_cast<size_t>(std::thread::hardware_concurrency()), size_t{1}, MaxShards);
+    }
+
+public:
+    static_assert(Batch > 0);
+
+    explicit ShardedCounter(size_t shards = DefaultShards())
+    {
+        EXPECT(shards > 0);
+        size_t size{1};
+        while (size < shards) { size <<= 1U; }
+        shards_ = std::make_unique<Shard[]>(size); // NOLINT(cppcoreguidelines-avoid-c-arrays,hicpp-avoid-c-arrays,modernize-avoid-c-arrays)
+        mask_ = size - 1;
+    }
+
+    ShardedCounter(ShardedCounter const&) = delete;
+    ShardedCounter(ShardedCounter&&) = delete;
+    auto operator=(ShardedCounter const&) -> ShardedCounter& = delete;
+    auto operator=(ShardedCounter&&) -> ShardedCounter& = delete;
+    ~ShardedCounter() = default;
+
+    auto Add(size_t inc) noexcept -> void
+    {
+        auto& value = shards_[Index() & mask_].Value;
+        auto const before = value.fetch_add(inc, std::memory_order_relaxed);
+        if (auto const batches = (before + inc) / Batch - before / Batch; batches > 0) {
+            published_.fetch_add(batches * Batch, std::memory_order_relaxed);
+        }
+    }
+
+    auto operator++() noexcept -> ShardedCounter& { Add(1); return *this; }
+    auto operator+=(size_t inc) noexcept -> ShardedCounter& { Add(inc); return *this; }
+
+    // replaces the count (concurrent increments may be lost, concurrent stores: the last one wins)
+    auto Store(size_t value) noexcept -> void
+    {
+        for (size_t i = 1; i <= mask_; ++i) {
+            shards_[i].Value.store(0, std::memory_order_relaxed);
+        }
+        shards_[0].Value.store(value, std::memory_order_relaxed);
+        published_.store(value / Batch * Batch, std::memory_order_relaxed);
+    }
+
+    auto operator=(size_t value) noexcept -> ShardedCounter& { Store(value); return *this; }
+
+    [[nodiscard]] auto Load() const noexcept -> size_t
+    {
+        size_t sum{0};
+        for (size_t i = 0; i <= mask_; ++i) {
+            sum += shards_[i].Value.load(std::memory_order_relaxed);
+        }
+        return sum;
+    }
+
+    operator size_t() const noexcept { return Load(); } // NOLINT(google-explicit-constructor,hicpp-explicit-conversions)
+
+    // a single load: the count without the increments which were not published yet
+    [[nodiscard]] auto Approximate() const noexcept -> size_t { return published_.load(std::memory_order_relaxed); }
+    // upper bound on the number of unpublished increments
+    [[nodiscard]] auto Slack() const noexcept -> size_t { return Shards() * Batch; }
+    [[nodiscard]] auto Shards() const noexcept -> size_t { return mask_ + 1; }
+};
+
+} // namespace Operon
+
+#endif
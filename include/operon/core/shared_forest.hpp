@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_CORE_SHARED_FOREST_HPP
+#define OPERON_CORE_SHARED_FOREST_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <robin_hood.h>
+#include <vector>
+
+#include "node.hpp"
+#include "tree.hpp"
+#include "types.hpp"
+#include "operon/operon_export.hpp"
+
+namespace Operon {
+
+// hash-consed storage of many trees: a DAG in which every distinct subtree is stored once, with reference counts
+// - later in a run most of the nodes of a population belong to subtrees shared by many individuals (inherited through
+//   crossover), so the forest stores a fraction of the nodes of the flat trees. meant for keeping large numbers of
+//   trees around (e.g. populations, archives and checkpoints), the operators work on Tree: use GetTree to convert
+// - a subtree is identified by its root node (the node fields except the level and the parent, including the
+//   calculated hash value) and the handles of its children, so the interning of a node is a single lookup and the
+//   sharing is exact whatever the hash mode of the trees
+// - the handles stay valid until their last reference is released, the slots of released subtrees are reused
+// - not thread safe
+class OPERON_EXPORT SharedForest {
+public:
+    using Handle = uint32_t;
+    // the handle of the empty tree, which is not stored
+    static constexpr Handle None = ~Handle{0};
+
+    // adds the tree with one reference and returns the handle of its root
+    auto Insert(Tree const& tree) -> Handle;
+    // adds a reference to the tree (e.g. for a copy of an individual)
+    auto Retain(Handle handle) -> void;
+    // removes a reference, the subtrees without references are freed
+    auto Release(Handle handle) -> void;
+
+    // the flat tree, with updated node information (depth, level, parent)
+    [[nodiscard]] auto GetTree(Handle handle) const -> Tree;
+    // the length of the flat tree
+    [[nodiscard]] auto Length(Handle handle) const -> size_t { return handle == None ? 0 : entries_[handle].Node.Length + size_t{1}; }
+    [[nodiscard]] auto References(Handle handle) const -> size_t { return handle == None ? 0 : entries_[handle].References; }
+
+    // appends the trees of the roots to the buffer, every shared subtree is written once
+    auto Write(Operon::Span<Handle const> roots, std::vector<std::byte>& buffer) const -> void;
+    // decodes the trees written by Write starting at offset and advances the offset past them
+    [[nodiscard]] static auto Read(Operon::Span<std::byte const> buffer, size_t& offset) -> std::vector<Tree>;
+
+    // the number of distinct subtrees (nodes of the DAG)
+    [[nodiscard]] auto Size() const -> size_t { return entries_.size() - free_.size(); }
+    [[nodiscard]] auto Empty() const -> bool { return Size() == 0; }
+    // memory used by the DAG (not counting unused capacity and the index)
+    [[nodiscard]] auto MemoryUsage() const -> size_t { return entries_.size() * sizeof(Entry) + children_.size() * sizeof(Handle); }
+
+    auto Clear() -> void;
+
+private:
+    struct Entry {
+        Operon::Node Node;    // the level and the parent are reset
+        uint32_t Children;    // the offset of the handles of the children (in postfix order) in children_
+        uint32_t References;  // of the parents and the roots
+        Handle Next;          // the next entry with the same key
+        uint64_t Key;
+    };
+
+    std::vector<Entry> entries_;
+    std::vector<Handle> children_;
+    std::vector<Handle> free_;
+    size_t garbage_{0}; // the handles in children_ of the freed entries
+    robin_hood::unordered_flat_map<uint64_t, Handle> index_; // the first entry of every key
+
+    // the handle of the node with the children, a new entry has no references
+    auto Intern(Node const& node, Operon::Span<Handle const> children) -> Handle;
+    auto Free(Handle handle) -> void;
+    // drops the children of the freed entries from children_
+    auto Compact() -> void;
+
+    [[nodiscard]] auto ChildrenOf(Entry const& entry) const -> Operon::Span<Handle const> { return { children_.data() + entry.Children, entry.Node.Arity }; }
+};
+
+} // namespace Operon
+
+#endif
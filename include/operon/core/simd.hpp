@@ -0,0 +1,314 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_CORE_SIMD_HPP
+#define OPERON_CORE_SIMD_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// a hint to fetch the cache line holding p ahead of a gathered (indirect) load, a no-op where it is not available
+#if defined(__GNUC__) || defined(__clang__)
+#define OPERON_PREFETCH(p) __builtin_prefetch(p)
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#define OPERON_PREFETCH(p) _mm_prefetch(reinterpret_cast<char const*>(p), _MM_HINT_T0)
+#else
+#define OPERON_PREFETCH(p) static_cast<void>(p)
+#endif
+
+// a small portable layer of fixed width vectors, used by the kernels which were vectorized explicitly (the set
+// intersections of the distances, the hashing of the signatures, the dominance checks and the reductions of the error
+// metrics)
+// - the vectors are the generic vector extensions of GCC and Clang, which are lowered to SSE/AVX on x86 and to NEON on
+//   ARM (and to SVE when the vector length is fixed at compile time with -msve-vector-bits). the other compilers get an
+//   array of lanes and the loops over the lanes are left to the auto-vectorizer
+// - the width of a vector is part of its type and does not depend on the target: a vector wider than the registers of
+//   the target is split by the compiler, so the kernels compute the same results everywhere
+// - the horizontal operations (Any, ReduceAdd), which the generic extensions do not provide, have SSE/AVX and NEON
+//   implementations for the register sized vectors
+#if defined(__GNUC__) || defined(__clang__)
+#define OPERON_SIMD_VECTOR_EXTENSIONS 1
+// the vectors wider than the registers of the target are passed differently by some ABIs, which does not matter for
+// the inline functions below
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+namespace Operon::Simd {
+
+// the width of the vector registers of the target and its name (reported by the benchmarks)
+#if defined(__AVX512F__)
+inline constexpr size_t NativeBytes = 64;
+inline constexpr char const* Target = "avx512";
+#elif defined(__AVX2__)
+inline constexpr size_t NativeBytes = 32;
+inline constexpr char const* Target = "avx2";
+#elif defined(__AVX__)
+inline constexpr size_t NativeBytes = 32;
+inline constexpr char const* Target = "avx";
+#elif defined(__SSE2__)
+inline constexpr size_t NativeBytes = 16;
+inline constexpr char const* Target = "sse2";
+#elif defined(__ARM_FEATURE_SVE) && defined(__ARM_FEATURE_SVE_BITS) && __ARM_FEATURE_SVE_BITS > 0
+inline constexpr size_t NativeBytes = __ARM_FEATURE_SVE_BITS / 8;
+inline constexpr char const* Target = "sve";
+#elif defined(__ARM_NEON)
+inline constexpr size_t NativeBytes = 16;
+inline constexpr char const* Target = "neon";
+#elif defined(OPERON_SIMD_VECTOR_EXTENSIONS)
+inline constexpr size_t NativeBytes = 16;
+inline constexpr char const* Target = "generic";
+#else
+inline constexpr size_t NativeBytes = 16;
+inline constexpr char const* Target = "scalar";
+#endif
+
+// the number of lanes of type T in a vector register
+template<typename T>
+inline constexpr size_t NativeLanes = NativeBytes / sizeof(T);
+
+namespace detail {
+    // the signed integer type of the lanes of the comparison masks
+    template<size_t S> struct MaskLane { };
+    template<> struct MaskLane<4> { using Type = int32_t; };
+    template<> struct MaskLane<8> { using Type = int64_t; };
+
+#if defined(OPERON_SIMD_VECTOR_EXTENSIONS)
+    template<typename T, size_t N>
+    struct Storage {
+        typedef T Type __attribute__((vector_size(N * sizeof(T)))); // NOLINT(modernize-use-using)
+    };
+#else
+    template<typename T, size_t N>
+    struct Storage {
+        using Type = std::array<T, N>;
+    };
+#endif
+} // namespace detail
+
+template<typename T, size_t N>
+class Vec;
+
+// the result of the comparisons, every lane is either all ones (true) or zero (false)
+template<typename T, size_t N>
+using Mask = Vec<typename detail::MaskLane<sizeof(T)>::Type, N>;
+
+template<typename T, size_t N>
+class Vec {
+    static_assert(std::is_arithmetic_v<T> && !std::is_const_v<T> && (sizeof(T) == 4 || sizeof(T) == 8), "the lanes are 32 or 64-bit integers or floating point values");
+    static_assert(N > 0 && (N & (N - 1)) == 0, "the number of lanes is a power of two");
+
+public:
+    using Scalar = T;
+    using Native = typename detail::Storage<T, N>::Type;
+    static constexpr size_t Size = N;
+
+    Vec() noexcept : v_{} { }
+    Vec(T value) noexcept // NOLINT(google-explicit-constructor,hicpp-explicit-conversions) broadcast, like a scalar operand
+    {
+#if defined(OPERON_SIMD_VECTOR_EXTENSIONS)
+        v_ = Native{} + value;
+#else
+        v_.fill(value);
+#endif
+    }
+
+    [[nodiscard]] static auto FromNative(Native v) noexcept -> Vec { Vec r; r.v_ = v; return r; }
+    [[nodiscard]] auto ToNative() const noexcept -> Native { return v_; }
+
+    // unaligned loads and stores. the partial load reads count < N values, the other lanes are zero
+    [[nodiscard]] static auto Load(T const* p) noexcept -> Vec { Vec r; std::memcpy(&r.v_, p, sizeof(Native)); return r; }
+    [[nodiscard]] static auto LoadPartial(T const* p, size_t count) noexcept -> Vec { Vec r; std::memcpy(&r.v_, p, count * sizeof(T)); return r; }
+    auto Store(T* p) const noexcept -> void { std::memcpy(p, &v_, sizeof(Native)); }
+
+    // 0, 1, ..., N-1
+    [[nodiscard]] static auto Iota() noexcept -> Vec
+    {
+        Vec r;
+        for (size_t i = 0; i < N; ++i) { r.v_[i] = static_cast<T>(i); }
+        return r;
+    }
+
+    [[nodiscard]] auto operator[](size_t i) const noexcept -> T { return v_[i]; }
+
+#if defined(OPERON_SIMD_VECTOR_EXTENSIONS)
+#define OPERON_SIMD_BINARY(op) \
+    friend auto operator op(Vec a, Vec b) noexcept -> Vec { return FromNative(a.v_ op b.v_); }
+#define OPERON_SIMD_COMPARISON(op) \
+    friend auto operator op(Vec a, Vec b) noexcept -> Mask<T, N> { return Mask<T, N>::FromNative(a.v_ op b.v_); }
+    friend auto operator-(Vec a) noexcept -> Vec { return FromNative(-a.v_); }
+    friend auto operator~(Vec a) noexcept -> Vec { return FromNative(~a.v_); }
+    friend auto operator>>(Vec a, int s) noexcept -> Vec { return FromNative(a.v_ >> s); }
+    friend auto operator<<(Vec a, int s) noexcept -> Vec { return FromNative(a.v_ << s); }
+#else
+#define OPERON_SIMD_BINARY(op) \
+    friend auto operator op(Vec a, Vec b) noexcept -> Vec { Vec r; for (size_t i = 0; i < N; ++i) { r.v_[i] = a.v_[i] op b.v_[i]; } return r; }
+#define OPERON_SIMD_COMPARISON(op) \
+    friend auto operator op(Vec a, Vec b) noexcept -> Mask<T, N> \
+    { \
+        using M = typename Mask<T, N>::Scalar; \
+        typename Mask<T, N>::Native r; \
+        for (size_t i = 0; i < N; ++i) { r[i] = a.v_[i] op b.v_[i] ? M{-1} : M{0}; } \
+        return Mask<T, N>::FromNative(r); \
+    }
+    friend auto operator-(Vec a) noexcept -> Vec { Vec r; for (size_t i = 0; i < N; ++i) { r.v_[i] = -a.v_[i]; } return r; }
+    friend auto operator~(Vec a) noexcept -> Vec { Vec r; for (size_t i = 0; i < N; ++i) { r.v_[i] = ~a.v_[i]; } return r; }
+    friend auto operator>>(Vec a, int s) noexcept -> Vec { Vec r; for (size_t i = 0; i < N; ++i) { r.v_[i] = a.v_[i] >> s; } return r; }
+    friend auto operator<<(Vec a, int s) noexcept -> Vec { Vec r; for (size_t i = 0; i < N; ++i) { r.v_[i] = a.v_[i] << s; } return r; }
+#endif
+    // the bitwise operators are only defined for the integer lanes (they are instantiated when used)
+    OPERON_SIMD_BINARY(+)
+    OPERON_SIMD_BINARY(-)
+    OPERON_SIMD_BINARY(*)
+    OPERON_SIMD_BINARY(/)
+    OPERON_SIMD_BINARY(&)
+    OPERON_SIMD_BINARY(|)
+    OPERON_SIMD_BINARY(^)
+    OPERON_SIMD_COMPARISON(==)
+    OPERON_SIMD_COMPARISON(!=)
+    OPERON_SIMD_COMPARISON(<)
+    OPERON_SIMD_COMPARISON(<=)
+    OPERON_SIMD_COMPARISON(>)
+    OPERON_SIMD_COMPARISON(>=)
+#undef OPERON_SIMD_BINARY
+#undef OPERON_SIMD_COMPARISON
+
+    auto operator+=(Vec b) noexcept -> Vec& { return *this = *this + b; }
+    auto operator-=(Vec b) noexcept -> Vec& { return *this = *this - b; }
+    auto operator*=(Vec b) noexcept -> Vec& { return *this = *this * b; }
+
+private:
+    Native v_;
+};
+
+// the lanes reinterpreted as another type of the same size
+template<typename U, typename T, size_t N>
+[[nodiscard]] inline auto BitCast(Vec<T, N> v) noexcept -> Vec<U, N>
+{
+    static_assert(sizeof(U) == sizeof(T));
+    typename Vec<U, N>::Native r;
+    auto const n = v.ToNative();
+    std::memcpy(&r, &n, sizeof(r));
+    return Vec<U, N>::FromNative(r);
+}
+
+// the lanes converted to another type (e.g. float to double)
+template<typename U, typename T, size_t N>
+[[nodiscard]] inline auto Convert(Vec<T, N> v) noexcept -> Vec<U, N>
+{
+#if defined(OPERON_SIMD_VECTOR_EXTENSIONS)
+    return Vec<U, N>::FromNative(__builtin_convertvector(v.ToNative(), typename Vec<U, N>::Native));
+#else
+    typename Vec<U, N>::Native r;
+    for (size_t i = 0; i < N; ++i) { r[i] = static_cast<U>(v[i]); }
+    return Vec<U, N>::FromNative(r);
+#endif
+}
+
+// m ? a : b, lane by lane
+template<typename T, size_t N>
+[[nodiscard]] inline auto Select(Mask<T, N> m, Vec<T, N> a, Vec<T, N> b) noexcept -> Vec<T, N>
+{
+    using M = typename Mask<T, N>::Scalar;
+    return BitCast<T>((BitCast<M>(a) & m) | (BitCast<M>(b) & ~m));
+}
+
+// the lanes at or past count set to zero
+template<typename T, size_t N>
+[[nodiscard]] inline auto Cutoff(Vec<T, N> v, size_t count) noexcept -> Vec<T, N>
+{
+    using M = typename Mask<T, N>::Scalar;
+    return Select(Mask<T, N>::Iota() < Mask<T, N>(static_cast<M>(count)), v, Vec<T, N>{});
+}
+
+template<typename T, size_t N>
+[[nodiscard]] inline auto Min(Vec<T, N> a, Vec<T, N> b) noexcept -> Vec<T, N> { return Select(a < b, a, b); }
+
+template<typename T, size_t N>
+[[nodiscard]] inline auto Max(Vec<T, N> a, Vec<T, N> b) noexcept -> Vec<T, N> { return Select(a > b, a, b); }
+
+template<typename T, size_t N>
+[[nodiscard]] inline auto Abs(Vec<T, N> v) noexcept -> Vec<T, N>
+{
+    if constexpr (std::is_floating_point_v<T>) {
+        // clear the sign bits
+        using M = typename Mask<T, N>::Scalar;
+        return BitCast<T>(BitCast<M>(v) & Mask<T, N>(std::numeric_limits<M>::max()));
+    } else if constexpr (std::is_signed_v<T>) {
+        return Select(v < Vec<T, N>{}, -v, v);
+    } else {
+        return v;
+    }
+}
+
+// true if any lane of the mask is set
+template<typename M, size_t N>
+[[nodiscard]] inline auto Any(Vec<M, N> m) noexcept -> bool
+{
+    constexpr auto bytes = N * sizeof(M);
+#if defined(__AVX2__)
+    if constexpr (bytes == 32) { // NOLINT
+        return _mm256_movemask_epi8(reinterpret_cast<__m256i>(m.ToNative())) != 0; // NOLINT
+    }
+#endif
+#if defined(__SSE2__)
+    if constexpr (bytes == 16) { // NOLINT
+        return _mm_movemask_epi8(reinterpret_cast<__m128i>(m.ToNative())) != 0; // NOLINT
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    if constexpr (bytes == 16) { // NOLINT
+        return vmaxvq_u32(reinterpret_cast<uint32x4_t>(m.ToNative())) != 0; // NOLINT
+    }
+#endif
+    // the union of the 64-bit words of the mask
+    std::array<uint64_t, (bytes + sizeof(uint64_t) - 1) / sizeof(uint64_t)> words{};
+    auto const n = m.ToNative();
+    std::memcpy(words.data(), &n, bytes);
+    uint64_t any{0};
+    for (auto w : words) { any |= w; }
+    return any != 0;
+}
+
+// true if every lane of the mask is set
+template<typename M, size_t N>
+[[nodiscard]] inline auto All(Vec<M, N> m) noexcept -> bool { return !Any(~m); }
+
+// the sum of the lanes, added pairwise (the halves first)
+template<typename T, size_t N>
+[[nodiscard]] inline auto ReduceAdd(Vec<T, N> v) noexcept -> T
+{
+#if defined(__ARM_NEON) && defined(__aarch64__)
+    if constexpr (std::is_same_v<T, double> && N == 2) { // NOLINT
+        return vaddvq_f64(reinterpret_cast<float64x2_t>(v.ToNative())); // NOLINT
+    } else if constexpr (std::is_same_v<T, float> && N == 4) { // NOLINT
+        return vaddvq_f32(reinterpret_cast<float32x4_t>(v.ToNative())); // NOLINT
+    }
+#endif
+    if constexpr (N == 1) {
+        return v[0];
+    } else {
+        std::array<T, N> lanes{};
+        v.Store(lanes.data());
+        using H = Vec<T, N / 2>;
+        return ReduceAdd(H::Load(lanes.data()) + H::Load(lanes.data() + N / 2));
+    }
+}
+
+} // namespace Operon::Simd
+
+#if defined(OPERON_SIMD_VECTOR_EXTENSIONS)
+#pragma GCC diagnostic pop
+#endif
+
+#endif
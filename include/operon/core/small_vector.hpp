@@ -0,0 +1,175 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_CORE_SMALL_VECTOR_HPP
+#define OPERON_CORE_SMALL_VECTOR_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+
+namespace Operon {
+
+// contiguous container which stores up to N elements inline and only allocates beyond that
+// - meant for short arrays of trivially copyable values created in great numbers (e.g. the fitness of the
+//   individuals, which has a handful of objectives): creating, copying and returning them does not allocate
+// - the subset of the std::vector interface the library uses (the elements are not destroyed or constructed
+//   individually, since they are trivially copyable)
+template<typename T, size_t N>
+class SmallVector {
+    static_assert(std::is_trivially_copyable_v<T>, "the elements are copied as raw values");
+    static_assert(N > 0);
+
+    std::array<T, N> inline_{};
+    std::unique_ptr<T[]> heap_; // NOLINT(cppcoreguidelines-avoid-c-arrays,hicpp-avoid-c-arrays,modernize-avoid-c-arrays)
+    size_t size_{0};
+    size_t capacity_{N};
+
+    // take over the elements of other, this must not own an allocation
+    auto Steal(SmallVector& other) noexcept -> void
+    {
+        if (other.heap_) {
+            heap_ = std::move(other.heap_);
+            capacity_ = other.capacity_;
+        } else {
+            std::copy_n(other.inline_.data(), other.size_, inline_.data());
+        }
+        size_ = other.size_;
+        other.size_ = 0;
+        other.capacity_ = N;
+    }
+
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T&;
+    using const_reference = T const&;
+    using pointer = T*;
+    using const_pointer = T const*;
+    using iterator = T*;
+    using const_iterator = T const*;
+
+    static constexpr size_t InlineCapacity = N;
+
+    SmallVector() noexcept = default;
+
+    explicit SmallVector(size_t n, T value = T{}) { resize(n, value); }
+
+    SmallVector(std::initializer_list<T> values) { assign(values.begin(), values.end()); }
+
+    template<typename Iterator, typename = typename std::iterator_traits<Iterator>::iterator_category>
+    SmallVector(Iterator first, Iterator last) { assign(first, last); }
+
+    SmallVector(SmallVector const& other) { assign(other.begin(), other.end()); }
+    SmallVector(SmallVector&& other) noexcept { Steal(other); }
+
+    ~SmallVector() = default;
+
+    auto operator=(SmallVector const& other) -> SmallVector&
+    {
+        if (this != &other) { assign(other.begin(), other.end()); }
+        return *this;
+    }
+
+    auto operator=(SmallVector&& other) noexcept -> SmallVector&
+    {
+        if (this != &other) {
+            heap_.reset();
+            capacity_ = N;
+            Steal(other);
+        }
+        return *this;
+    }
+
+    auto operator=(std::initializer_list<T> values) -> SmallVector&
+    {
+        assign(values.begin(), values.end());
+        return *this;
+    }
+
+    template<typename Iterator, typename = typename std::iterator_traits<Iterator>::iterator_category>
+    auto assign(Iterator first, Iterator last) -> void
+    {
+        auto const n = static_cast<size_t>(std::distance(first, last));
+        size_ = 0; // nothing to preserve when growing
+        reserve(n);
+        std::copy(first, last, data());
+        size_ = n;
+    }
+
+    auto assign(size_t n, T value) -> void
+    {
+        size_ = 0;
+        resize(n, value);
+    }
+
+    auto reserve(size_t n) -> void
+    {
+        if (n <= capacity_) { return; }
+        std::unique_ptr<T[]> storage(new T[n]); // NOLINT(cppcoreguidelines-avoid-c-arrays,hicpp-avoid-c-arrays,modernize-avoid-c-arrays,cppcoreguidelines-owning-memory)
+        std::copy_n(data(), size_, storage.get());
+        heap_ = std::move(storage);
+        capacity_ = n;
+    }
+
+    auto resize(size_t n, T value) -> void
+    {
+        reserve(n);
+        if (n > size_) { std::fill(data() + size_, data() + n, value); }
+        size_ = n;
+    }
+
+    auto resize(size_t n) -> void { resize(n, T{}); }
+
+    auto push_back(T value) -> void // NOLINT(readability-identifier-naming)
+    {
+        if (size_ == capacity_) { reserve(2 * capacity_); }
+        data()[size_++] = value;
+    }
+
+    auto clear() noexcept -> void { size_ = 0; }
+
+    [[nodiscard]] auto data() noexcept -> T* { return heap_ ? heap_.get() : inline_.data(); }
+    [[nodiscard]] auto data() const noexcept -> T const* { return heap_ ? heap_.get() : inline_.data(); }
+
+    [[nodiscard]] auto size() const noexcept -> size_t { return size_; }
+    [[nodiscard]] auto capacity() const noexcept -> size_t { return capacity_; }
+    [[nodiscard]] auto empty() const noexcept -> bool { return size_ == 0; }
+
+    // true if the elements are stored inline (no allocation is owned)
+    [[nodiscard]] auto IsInline() const noexcept -> bool { return !heap_; }
+
+    auto operator[](size_t i) noexcept -> T& { return data()[i]; }
+    auto operator[](size_t i) const noexcept -> T const& { return data()[i]; }
+
+    [[nodiscard]] auto front() noexcept -> T& { return data()[0]; }
+    [[nodiscard]] auto front() const noexcept -> T const& { return data()[0]; }
+    [[nodiscard]] auto back() noexcept -> T& { return data()[size_ - 1]; }
+    [[nodiscard]] auto back() const noexcept -> T const& { return data()[size_ - 1]; }
+
+    [[nodiscard]] auto begin() noexcept -> iterator { return data(); }
+    [[nodiscard]] auto end() noexcept -> iterator { return data() + size_; }
+    [[nodiscard]] auto begin() const noexcept -> const_iterator { return data(); }
+    [[nodiscard]] auto end() const noexcept -> const_iterator { return data() + size_; }
+    [[nodiscard]] auto cbegin() const noexcept -> const_iterator { return data(); }
+    [[nodiscard]] auto cend() const noexcept -> const_iterator { return data() + size_; }
+
+    friend auto operator==(SmallVector const& lhs, SmallVector const& rhs) noexcept -> bool
+    {
+        return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+    }
+
+    friend auto operator!=(SmallVector const& lhs, SmallVector const& rhs) noexcept -> bool
+    {
+        return !(lhs == rhs);
+    }
+};
+
+} // namespace Operon
+
+#endif
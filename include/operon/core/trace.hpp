@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_CORE_TRACE_HPP
+#define OPERON_CORE_TRACE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <taskflow/taskflow.hpp>
+#include <vector>
+
+#include "operon/operon_export.hpp"
+
+namespace Operon {
+
+// records the execution of the tasks on the workers of an executor and writes them in the chrome trace event format
+// (json, opened by chrome://tracing, ui.perfetto.dev or speedscope), one track per worker
+// - attach it with executor.make_observer<TraceObserver>() while the executor is idle
+// - every worker appends to its own buffer. the names of the tasks are interned (under a lock, the named tasks are
+//   few), the unnamed ones take no lock. Dump must not be called while a taskflow runs.
+// - the tasks carry the names given by the algorithms ("evaluate population", "generate offspring", ...), the items of
+//   a parallel stage run as unnamed tasks, which are labeled with the name of the last named task started before them
+//   (with concurrent stages, as in the pipelined loop, the label can be the one of the other stage)
+// - tasks running inside another task on the same worker (when a subflow joins) show up nested
+class OPERON_EXPORT TraceObserver : public tf::ObserverInterface {
+public:
+    struct Event {
+        uint32_t Name;  // index into Names()
+        uint64_t Begin; // nanoseconds since the observer was set up
+        uint64_t End;
+        uint32_t Depth;
+    };
+
+    TraceObserver() = default;
+
+    auto set_up(size_t workers) -> void final;
+    auto on_entry(tf::WorkerView wv, tf::TaskView tv) -> void final;
+    auto on_exit(tf::WorkerView wv, tf::TaskView tv) -> void final;
+
+    // the recorded events in the chrome trace event format
+    auto Dump(std::ostream& os) const -> void;
+    auto Dump(std::string const& path) const -> void;
+
+    [[nodiscard]] auto Events(size_t worker) const -> std::vector<Event> const&;
+    [[nodiscard]] auto Workers() const -> size_t { return lanes_.size(); }
+    [[nodiscard]] auto Names() const -> std::vector<std::string> const& { return names_; }
+
+    // drops the recorded events
+    auto Clear() -> void;
+
+private:
+    static constexpr size_t CacheLine = 64;
+
+    // the events of one worker, only written by that worker
+    struct alignas(CacheLine) Lane {
+        std::vector<Event> Events;
+        std::vector<size_t> Open; // indices of the events which have not ended yet
+    };
+
+    using clock = std::chrono::steady_clock;
+
+    clock::time_point origin_;
+    std::vector<Lane> lanes_;
+    std::mutex lock_;
+    std::vector<std::string> names_;
+    std::atomic<uint32_t> label_{0}; // the name of the last named task
+
+    [[nodiscard]] auto Now() const -> uint64_t;
+    auto Intern(std::string const& name) -> uint32_t;
+};
+
+} // namespace Operon
+
+#endif
@@ -16,6 +16,8 @@
 
 namespace Operon {
 
+class TreeView;
+
 template<typename T>
 class SubtreeIterator {
 public:
@@ -113,6 +115,12 @@ public:
     }
 
     auto UpdateNodes() -> Tree&;
+    // incremental version of UpdateNodes after a splice: the subtree of oldLength nodes starting at position start
+    // was replaced by newLength nodes (a complete subtree, or nothing when newLength is zero)
+    // - the arity, length and depth of the inserted nodes must be valid (e.g. copied from an updated tree)
+    // - only the inserted nodes and the ancestors of the splice are recomputed, other parent indices are shifted
+    // - the arity of the ancestors may have been changed by the caller (e.g. when removing a subtree)
+    auto UpdateNodes(size_t start, size_t oldLength, size_t newLength) -> Tree&;
     auto Sort() -> Tree&;
     auto Reduce() -> Tree&;
     auto Simplify() -> Tree&;
@@ -121,6 +129,10 @@ public:
     // aggregating hash values from the leafs towards the root node
     [[nodiscard]] auto Hash(Operon::HashMode mode) const -> Tree const&;
 
+    // the hash value of the root in the given mode, the hash values of the nodes are left as they were (e.g. for a
+    // lookup by strict hash in a tree hashed in relaxed mode by the operators)
+    [[nodiscard]] auto ComputeHash(Operon::HashMode mode) const -> Operon::Hash;
+
     [[nodiscard]] auto Subtree(size_t i) const -> Tree {
         EXPECT(i < Length());
         auto const& n = nodes_[i];
@@ -128,6 +140,9 @@ public:
         return Tree({it - n.Length, it + 1}).UpdateNodes();
     }
 
+    // a non-owning view of the subtree rooted at i (see TreeView), no nodes are copied
+    [[nodiscard]] inline auto View(size_t i) const -> TreeView;
+
     [[nodiscard]] auto ChildIndices(size_t i) const -> std::vector<size_t>;
     inline void SetEnabled(size_t i, bool enabled)
     {
@@ -147,6 +162,8 @@ public:
 
     void SetCoefficients(Operon::Span<Operon::Scalar const> coefficients);
     [[nodiscard]] auto GetCoefficients() const -> std::vector<Operon::Scalar>;
+    // fills the buffer with the coefficients, reusing its storage
+    void GetCoefficients(std::vector<Operon::Scalar>& coefficients) const;
 
     inline auto operator[](size_t i) noexcept -> Node& { return nodes_[i]; }
     inline auto operator[](size_t i) const noexcept -> Node const& { return nodes_[i]; }
@@ -164,6 +181,63 @@ public:
 private:
     Operon::Vector<Node> nodes_;
 };
+
+// non-owning view of a contiguous range of nodes forming a complete subtree (postfix order, root node last)
+// - arity, length and depth of the nodes are relative to the subtree and remain valid
+// - level and parent refer to the tree the view was taken from
+// - the view is invalidated by any change to the size of the underlying tree
+class OPERON_EXPORT TreeView {
+public:
+    TreeView() = default;
+    TreeView(Tree const& tree) // NOLINT (implicit conversion to use trees wherever views are accepted)
+        : nodes_(tree.Nodes())
+    {
+    }
+    explicit TreeView(Operon::Span<Node const> nodes)
+        : nodes_(nodes)
+    {
+        EXPECT(nodes_.empty() || nodes_.back().Length + 1UL == nodes_.size());
+    }
+
+    // hashes the nodes of the view in place (the hash values only depend on the subtree)
+    [[nodiscard]] auto Hash(Operon::HashMode mode) const -> TreeView const&;
+
+    [[nodiscard]] auto Subtree(size_t i) const -> TreeView
+    {
+        EXPECT(i < Length());
+        return TreeView(nodes_.subspan(i - nodes_[i].Length, nodes_[i].Length + 1UL));
+    }
+
+    [[nodiscard]] auto Nodes() const -> Operon::Span<Node const> { return nodes_; }
+    [[nodiscard]] auto CoefficientsCount() const
+    {
+        return std::count_if(nodes_.begin(), nodes_.end(), [](auto const& s) { return s.IsLeaf(); });
+    }
+    [[nodiscard]] auto GetCoefficients() const -> std::vector<Operon::Scalar>;
+
+    inline auto operator[](size_t i) const noexcept -> Node const& { return nodes_[i]; }
+
+    [[nodiscard]] auto Length() const noexcept -> size_t { return nodes_.size(); }
+    [[nodiscard]] auto Depth() const noexcept -> size_t { return nodes_.back().Depth; }
+    [[nodiscard]] auto Empty() const noexcept -> bool { return nodes_.empty(); }
+    [[nodiscard]] auto HashValue() const -> Operon::Hash { return nodes_.empty() ? 0 : nodes_.back().CalculatedHashValue; }
+
+    [[nodiscard]] auto Children(size_t i) const -> SubtreeIterator<TreeView const> { return SubtreeIterator(*this, i); }
+
+    // an owning copy of the nodes with updated level and parent indices
+    [[nodiscard]] auto ToTree() const -> Tree
+    {
+        return Tree(Operon::Vector<Node>(nodes_.begin(), nodes_.end())).UpdateNodes();
+    }
+
+private:
+    Operon::Span<Node const> nodes_;
+};
+
+inline auto Tree::View(size_t i) const -> TreeView
+{
+    return TreeView(*this).Subtree(i);
+}
 } // namespace Operon
 #endif // TREE_H
 
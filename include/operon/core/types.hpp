@@ -9,6 +9,7 @@
 #include <nonstd/span.hpp>
 
 #include "constants.hpp"
+#include "small_vector.hpp"
 #include "operon/random/random.hpp"
 
 namespace Operon {
@@ -28,6 +29,11 @@ using Scalar = float;
 #else
 using Scalar = double;
 #endif
+
+// the fitness values of an individual, stored inline up to InlineObjectives objectives (so that evaluating and
+// copying the individuals of the usual single and multi-objective runs does not allocate)
+constexpr size_t InlineObjectives = 4;
+using FitnessVector = SmallVector<Scalar, InlineObjectives>;
 } // namespace Operon
 
 #endif
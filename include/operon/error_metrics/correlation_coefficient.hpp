@@ -4,10 +4,12 @@
 #ifndef OPERON_METRICS_CORRELATION_COEFFICIENT_HPP
 #define OPERON_METRICS_CORRELATION_COEFFICIENT_HPP
 
+#include <cmath>
 #include <iterator>
 #include <type_traits>
 #include <vstat/vstat.hpp>
 #include "operon/core/types.hpp"
+#include "kernels.hpp"
 
 namespace Operon {
 
@@ -28,7 +30,12 @@ inline auto CorrelationCoefficient(Operon::Span<T const> x, Operon::Span<T const
     static_assert(std::is_arithmetic_v<T>, "T must be an arithmetic type.");
     EXPECT(x.size() == y.size());
     EXPECT(x.size() > 0);
-    return vstat::bivariate::accumulate<T>(x.data(), y.data(), x.size()).correlation;
+    if constexpr (std::is_floating_point_v<T>) {
+        auto m = Kernels::Moments(x, y);
+        return m.Covariance / std::sqrt(m.VarianceX * m.VarianceY);
+    } else {
+        return vstat::bivariate::accumulate<T>(x.data(), y.data(), x.size()).correlation;
+    }
 }
 } // namespace Operon
 
@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_METRICS_KERNELS_HPP
+#define OPERON_METRICS_KERNELS_HPP
+
+#include <cstdint>
+
+#include "operon/core/types.hpp"
+#include "operon/operon_export.hpp"
+
+// reductions over contiguous spans for the error metrics, vectorized explicitly with the portable vectors of operon/core/simd.hpp
+// - the values are widened to double and summed with Kahan compensation in every lane, so the result does not depend
+//   on whether the compiler vectorizes the loop and single precision inputs do not lose accuracy over many rows
+// - the moments use two passes (the means first), which is accurate also when the means are large
+// - the variances and the covariance are population moments (divided by n), like vstat
+namespace Operon::Kernels {
+    [[nodiscard]] auto OPERON_EXPORT SumOfSquaredErrors(Operon::Span<float const> x, Operon::Span<float const> y) noexcept -> double;
+    [[nodiscard]] auto OPERON_EXPORT SumOfSquaredErrors(Operon::Span<double const> x, Operon::Span<double const> y) noexcept -> double;
+
+    [[nodiscard]] auto OPERON_EXPORT SumOfAbsoluteErrors(Operon::Span<float const> x, Operon::Span<float const> y) noexcept -> double;
+    [[nodiscard]] auto OPERON_EXPORT SumOfAbsoluteErrors(Operon::Span<double const> x, Operon::Span<double const> y) noexcept -> double;
+
+    [[nodiscard]] auto OPERON_EXPORT Mean(Operon::Span<float const> x) noexcept -> double;
+    [[nodiscard]] auto OPERON_EXPORT Mean(Operon::Span<double const> x) noexcept -> double;
+
+    [[nodiscard]] auto OPERON_EXPORT Variance(Operon::Span<float const> x) noexcept -> double;
+    [[nodiscard]] auto OPERON_EXPORT Variance(Operon::Span<double const> x) noexcept -> double;
+
+    struct BivariateMoments {
+        double MeanX{0};
+        double MeanY{0};
+        double VarianceX{0};
+        double VarianceY{0};
+        double Covariance{0};
+    };
+
+    [[nodiscard]] auto OPERON_EXPORT Moments(Operon::Span<float const> x, Operon::Span<float const> y) noexcept -> BivariateMoments;
+    [[nodiscard]] auto OPERON_EXPORT Moments(Operon::Span<double const> x, Operon::Span<double const> y) noexcept -> BivariateMoments;
+
+    // the same reductions with the second operand gathered from a column, y[i] = column[rows[i]] (e.g. the target values
+    // of a subsample evaluated with Interpreter::Evaluate over a set of rows), without copying the column
+    [[nodiscard]] auto OPERON_EXPORT SumOfSquaredErrors(Operon::Span<float const> x, Operon::Span<float const> column, Operon::Span<uint32_t const> rows) noexcept -> double;
+    [[nodiscard]] auto OPERON_EXPORT SumOfSquaredErrors(Operon::Span<double const> x, Operon::Span<double const> column, Operon::Span<uint32_t const> rows) noexcept -> double;
+
+    [[nodiscard]] auto OPERON_EXPORT SumOfAbsoluteErrors(Operon::Span<float const> x, Operon::Span<float const> column, Operon::Span<uint32_t const> rows) noexcept -> double;
+    [[nodiscard]] auto OPERON_EXPORT SumOfAbsoluteErrors(Operon::Span<double const> x, Operon::Span<double const> column, Operon::Span<uint32_t const> rows) noexcept -> double;
+
+    [[nodiscard]] auto OPERON_EXPORT Moments(Operon::Span<float const> x, Operon::Span<float const> column, Operon::Span<uint32_t const> rows) noexcept -> BivariateMoments;
+    [[nodiscard]] auto OPERON_EXPORT Moments(Operon::Span<double const> x, Operon::Span<double const> column, Operon::Span<uint32_t const> rows) noexcept -> BivariateMoments;
+
+    // out[i] = column[rows[i]]
+    auto OPERON_EXPORT Gather(Operon::Span<float const> column, Operon::Span<uint32_t const> rows, Operon::Span<float> out) noexcept -> void;
+    auto OPERON_EXPORT Gather(Operon::Span<double const> column, Operon::Span<uint32_t const> rows, Operon::Span<double> out) noexcept -> void;
+} // namespace Operon::Kernels
+
+#endif
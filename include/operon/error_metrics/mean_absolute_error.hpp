@@ -8,6 +8,7 @@
 #include <type_traits>
 #include <vstat/vstat.hpp>
 #include "operon/core/types.hpp"
+#include "kernels.hpp"
 
 namespace Operon {
 
@@ -28,7 +29,11 @@ inline auto MeanAbsoluteError(Operon::Span<T const> x, Operon::Span<T const> y)
     static_assert(std::is_arithmetic_v<T>, "T must be an arithmetic type.");
     EXPECT(x.size() == y.size());
     EXPECT(x.size() > 0);
-    return vstat::univariate::accumulate<T>(x.data(), y.data(), x.size(), [](auto a, auto b) { return std::abs(a-b); }).mean;
+    if constexpr (std::is_floating_point_v<T>) {
+        return Kernels::SumOfAbsoluteErrors(x, y) / static_cast<double>(x.size());
+    } else {
+        return vstat::univariate::accumulate<T>(x.data(), y.data(), x.size(), [](auto a, auto b) { return std::abs(a-b); }).mean;
+    }
 }
 
 } // namespace Operon
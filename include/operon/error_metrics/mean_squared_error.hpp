@@ -8,6 +8,7 @@
 #include <type_traits>
 #include <vstat/vstat.hpp>
 #include "operon/core/types.hpp"
+#include "kernels.hpp"
 
 namespace Operon {
 
@@ -34,7 +35,11 @@ inline auto MeanSquaredError(Operon::Span<T const> x, Operon::Span<T const> y) n
     static_assert(std::is_arithmetic_v<T>, "T must be an arithmetic type.");
     EXPECT(x.size() == y.size());
     EXPECT(x.size() > 0);
-    return vstat::univariate::accumulate<T>(x.data(), y.data(), x.size(), [](auto a, auto b) { auto e = a - b; return e * e; }).mean;
+    if constexpr (std::is_floating_point_v<T>) {
+        return Kernels::SumOfSquaredErrors(x, y) / static_cast<double>(x.size());
+    } else {
+        return vstat::univariate::accumulate<T>(x.data(), y.data(), x.size(), [](auto a, auto b) { auto e = a - b; return e * e; }).mean;
+    }
 }
 
 template<typename T>
@@ -32,7 +32,18 @@ inline auto NormalizedMeanSquaredError(InputIt1 begin1, InputIt1 end1, InputIt2
 template<typename T>
 inline auto NormalizedMeanSquaredError(Operon::Span<T const> x, Operon::Span<T const> y) noexcept -> double
 {
-    return NormalizedMeanSquaredError(x.begin(), x.end(), y.begin());
+    if constexpr (std::is_floating_point_v<T>) {
+        EXPECT(x.size() == y.size());
+        EXPECT(x.size() > 0);
+        constexpr double eps{1e-12};
+        auto varY = Kernels::Variance(y);
+        if (std::abs(varY) < eps) {
+            return varY;
+        }
+        return MeanSquaredError(x, y) / varY;
+    } else {
+        return NormalizedMeanSquaredError(x.begin(), x.end(), y.begin());
+    }
 }
 } // namespace Operon
 
@@ -8,6 +8,7 @@
 #include <type_traits>
 #include <vstat/vstat.hpp>
 #include "operon/core/types.hpp"
+#include "kernels.hpp"
 
 namespace Operon {
 template<typename InputIt1, typename InputIt2>
@@ -34,7 +35,18 @@ template<typename T>
 inline auto R2Score(Operon::Span<T const> x, Operon::Span<T const> y) noexcept -> double
 {
     EXPECT(y.size() == x.size());
-    return R2Score(x.begin(), x.end(), y.begin());
+    if constexpr (std::is_floating_point_v<T>) {
+        EXPECT(x.size() > 0);
+        constexpr double eps{1e-12};
+        auto ssr = Kernels::SumOfSquaredErrors(x, y);
+        auto sst = Kernels::Variance(y) * static_cast<double>(y.size());
+        if (sst < eps) {
+            return std::numeric_limits<double>::min();
+        }
+        return 1.0 - ssr / sst;
+    } else {
+        return R2Score(x.begin(), x.end(), y.begin());
+    }
 }
 } // namespace Operon
 
@@ -0,0 +1,23 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_HASH_POPULATION_HPP
+#define OPERON_HASH_POPULATION_HPP
+
+#include "operon/core/tree.hpp"
+#include "operon/core/types.hpp"
+#include "operon/operon_export.hpp"
+
+namespace tf {
+class Executor;
+} // namespace tf
+
+namespace Operon {
+    // hashes all the trees in parallel, the hash values are identical to those computed by Tree::Hash
+    // - the trees are split into chunks of similar total length, so that a few long trees do not stall a worker
+    auto OPERON_EXPORT HashPopulation(tf::Executor& executor, Operon::Span<Tree const> trees, Operon::HashMode mode) -> void;
+    // same as above, on the shared executor with the given number of threads (0 means hardware concurrency)
+    auto OPERON_EXPORT HashPopulation(Operon::Span<Tree const> trees, Operon::HashMode mode, size_t threads = 0) -> void;
+} // namespace Operon
+
+#endif
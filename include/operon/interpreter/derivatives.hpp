@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_INTERPRETER_DERIVATIVES_HPP
+#define OPERON_INTERPRETER_DERIVATIVES_HPP
+
+#include "operon/core/node.hpp"
+#include "operon/core/types.hpp"
+#include "dispatch_table.hpp"
+
+namespace Operon::detail {
+    // propagates the adjoint of node i to its children (reverse-mode differentiation)
+    // - primal contains the node values computed by the forward pass
+    // - adjoint contains the partial derivatives of the output with respect to each node
+    // since the tree is stored in postfix order, calling this for i = n-1 ... 0 visits every parent before its children
+    template<typename T>
+    inline void Backpropagate(Operon::Span<Node const> nodes, Operon::Vector<Array<T>> const& primal, Operon::Vector<Array<T>>& adjoint, size_t i)
+    {
+        auto const& n = nodes[i];
+        if (n.IsLeaf()) { return; }
+
+        auto const& r = primal[i];
+        auto const& g = adjoint[i];
+        auto const next = [&](size_t j) { return j - (nodes[j].Length + 1); };
+        auto const c = i - 1; // first child
+
+        switch (n.Type) {
+        case NodeType::Add: {
+            for (size_t k = 0, j = c; k < n.Arity; ++k, j = next(j)) { adjoint[j] += g; }
+            break;
+        }
+        case NodeType::Sub: {
+            if (n.Arity == 1) { adjoint[c] -= g; break; }
+            adjoint[c] += g;
+            for (size_t k = 1, j = next(c); k < n.Arity; ++k, j = next(j)) { adjoint[j] -= g; }
+            break;
+        }
+        case NodeType::Mul: {
+            for (size_t k = 0, j = c; k < n.Arity; ++k, j = next(j)) {
+                Array<T> p = g;
+                for (size_t l = 0, q = c; l < n.Arity; ++l, q = next(q)) {
+                    if (q != j) { p *= primal[q]; }
+                }
+                adjoint[j] += p;
+            }
+            break;
+        }
+        case NodeType::Div: {
+            if (n.Arity == 1) { adjoint[c] -= g * r.square(); break; }
+            Array<T> d = Array<T>::Ones();
+            for (size_t k = 1, j = next(c); k < n.Arity; ++k, j = next(j)) { d *= primal[j]; }
+            adjoint[c] += g / d;
+            for (size_t k = 1, j = next(c); k < n.Arity; ++k, j = next(j)) { adjoint[j] -= g * r / primal[j]; }
+            break;
+        }
+        case NodeType::Fmin:
+        case NodeType::Fmax: {
+            // the derivative flows to the first argument that equals the result
+            Array<T> remaining = Array<T>::Ones();
+            for (size_t k = 0, j = c; k < n.Arity; ++k, j = next(j)) {
+                Array<T> mask = (primal[j] == r).template cast<T>() * remaining;
+                adjoint[j] += g * mask;
+                remaining -= mask;
+            }
+            break;
+        }
+        case NodeType::Aq: {
+            auto const& a = primal[c];
+            auto const& b = primal[next(c)];
+            Array<T> s = T{1} + b.square();
+            adjoint[c] += g / s.sqrt();
+            adjoint[next(c)] -= g * a * b / (s * s.sqrt());
+            break;
+        }
+        case NodeType::Pow: {
+            auto const& a = primal[c];
+            auto const& b = primal[next(c)];
+            adjoint[c] += g * b * a.pow(b - T{1});
+            adjoint[next(c)] += g * r * a.log();
+            break;
+        }
+        case NodeType::Abs:     { adjoint[c] += g * primal[c].sign(); break; }
+        case NodeType::Acos:    { adjoint[c] -= g / (T{1} - primal[c].square()).sqrt(); break; }
+        case NodeType::Asin:    { adjoint[c] += g / (T{1} - primal[c].square()).sqrt(); break; }
+        case NodeType::Atan:    { adjoint[c] += g / (T{1} + primal[c].square()); break; }
+        case NodeType::Cbrt:    { adjoint[c] += g / (T{3} * r.square()); break; }
+        case NodeType::Ceil:
+        case NodeType::Floor:   { break; }
+        case NodeType::Cos:     { adjoint[c] -= g * primal[c].sin(); break; }
+        case NodeType::Cosh:    { adjoint[c] += g * primal[c].sinh(); break; }
+        case NodeType::Exp:     { adjoint[c] += g * r; break; }
+        case NodeType::Log:
+        case NodeType::Logabs:  { adjoint[c] += g / primal[c]; break; }
+        case NodeType::Log1p:   { adjoint[c] += g / (T{1} + primal[c]); break; }
+        case NodeType::Sin:     { adjoint[c] += g * primal[c].cos(); break; }
+        case NodeType::Sinh:    { adjoint[c] += g * primal[c].cosh(); break; }
+        case NodeType::Sqrt:    { adjoint[c] += g / (T{2} * r); break; }
+        case NodeType::Sqrtabs: { adjoint[c] += g * primal[c].sign() / (T{2} * r); break; }
+        case NodeType::Tan:     { adjoint[c] += g * (T{1} + r.square()); break; }
+        case NodeType::Tanh:    { adjoint[c] += g * (T{1} - r.square()); break; }
+        case NodeType::Square:  { adjoint[c] += g * T{2} * primal[c]; break; }
+        default: { break; } // dynamic nodes are not supported (see GenericInterpreter::SupportsReverseMode)
+        }
+    }
+} // namespace Operon::detail
+
+#endif
@@ -7,8 +7,11 @@
 #include <Eigen/Dense>
 #include <fmt/core.h>
 #include <robin_hood.h>
+#include <algorithm>
+#include <array>
 #include <cstddef>
 #include <tuple>
+#include <utility>
 
 #include "operon/core/node.hpp"
 #include "operon/core/types.hpp"
@@ -17,10 +20,15 @@
 namespace Operon {
 
 namespace detail {
-    // this should be good enough - tests show 512 is about optimal
+    // the capacity of the batch columns in bytes (see INTERPRETER_BATCH_BYTES), 512 is a good default. the primitives
+    // always compute whole batch columns, so the batch size is a build setting rather than a runtime one
+#if !defined(OPERON_BATCH_BYTES)
+#define OPERON_BATCH_BYTES 512
+#endif
+
     template<typename T>
     struct BatchSize {
-        static const size_t Value = 512 / sizeof(T);
+        static const size_t Value = std::max(size_t{OPERON_BATCH_BYTES} / sizeof(T), size_t{1});
     };
 
     template<typename T>
@@ -34,11 +42,11 @@ namespace detail {
     // 1) improved performance: the naive method accumulates into the result for each argument, leading to unnecessary assignments
     // 2) minimizing the number of intermediate steps which might improve floating point accuracy of some operations
     //    if arity > 4, one accumulation is performed every 4 args
-    template<NodeType Type, typename T>
-    inline void DispatchOpNary(Operon::Vector<Array<T>>& m, Operon::Vector<Node> const& nodes, size_t parentIndex, size_t /* row number - not used */)
+    // the primitives are applied to views of the batch columns given by arg (see DispatchOpOutput)
+    template<NodeType Type, typename R, typename A>
+    inline void ApplyNary(R result, A const& arg, Operon::Span<Node const> nodes, size_t parentIndex)
     {
         static_assert(Type < NodeType::Aq);
-        auto result = Ref<T>(m[parentIndex]);
         const auto f = [](bool cont, decltype(result) res, auto&&... args) {
             if (cont) {
                 ContinuedFunction<Type>{}(res, std::forward<decltype(args)>(args)...);
@@ -52,26 +60,24 @@ namespace detail {
 
         bool continued = false;
 
-        using R = Ref<T>;
-
         int arity = nodes[parentIndex].Arity;
         while (arity > 0) {
             switch (arity) {
             case 1: {
-                f(continued, result, R(m[arg1]));
+                f(continued, result, arg(arg1));
                 arity = 0;
                 break;
             }
             case 2: {
                 auto arg2 = nextArg(arg1);
-                f(continued, result, R(m[arg1]), R(m[arg2]));
+                f(continued, result, arg(arg1), arg(arg2));
                 arity = 0;
                 break;
             }
             case 3: {
                 auto arg2 = nextArg(arg1);
                 auto arg3 = nextArg(arg2);
-                f(continued, result, R(m[arg1]), R(m[arg2]), R(m[arg3]));
+                f(continued, result, arg(arg1), arg(arg2), arg(arg3));
                 arity = 0;
                 break;
             }
@@ -79,7 +85,7 @@ namespace detail {
                 auto arg2 = nextArg(arg1);
                 auto arg3 = nextArg(arg2);
                 auto arg4 = nextArg(arg3);
-                f(continued, result, R(m[arg1]), R(m[arg2]), R(m[arg3]), R(m[arg4]));
+                f(continued, result, arg(arg1), arg(arg2), arg(arg3), arg(arg4));
                 arity -= 4;
                 arg1 = nextArg(arg4);
                 break;
@@ -90,14 +96,20 @@ namespace detail {
     }
 
     template<NodeType Type, typename T>
-    inline void DispatchOpUnary(Operon::Vector<Array<T>>& m, Operon::Vector<Node> const& /*unused*/, size_t i, size_t /* row number - not used */)
+    inline void DispatchOpNary(Operon::Vector<Array<T>>& m, Operon::Span<Node const> nodes, size_t parentIndex, size_t /* row number - not used */)
+    {
+        ApplyNary<Type>(Ref<T>(m[parentIndex]), [&](size_t j) { return Ref<T>(m[j]); }, nodes, parentIndex);
+    }
+
+    template<NodeType Type, typename T>
+    inline void DispatchOpUnary(Operon::Vector<Array<T>>& m, Operon::Span<Node const> /*unused*/, size_t i, size_t /* row number - not used */)
     {
         static_assert(Type < NodeType::Dynamic && Type > NodeType::Pow);
         Function<Type>{}(Ref<T>(m[i]), Ref<T>(m[i-1]));
     }
 
     template<NodeType Type, typename T>
-    inline void DispatchOpBinary(Operon::Vector<Array<T>>& m, Operon::Vector<Node> const& nodes, size_t i, size_t /* row number - not used */)
+    inline void DispatchOpBinary(Operon::Vector<Array<T>>& m, Operon::Span<Node const> nodes, size_t i, size_t /* row number - not used */)
     {
         static_assert(Type < NodeType::Abs && Type > NodeType::Fmax);
         auto j = i - 1;
@@ -106,7 +118,7 @@ namespace detail {
     }
 
     template<NodeType Type, typename T>
-    inline void DispatchOpSimpleUnaryOrBinary(Operon::Vector<Array<T>>& m, Operon::Vector<Node> const& nodes, size_t parentIndex, size_t /* row number - not used */)
+    inline void DispatchOpSimpleUnaryOrBinary(Operon::Vector<Array<T>>& m, Operon::Span<Node const> nodes, size_t parentIndex, size_t /* row number - not used */)
     {
         auto r = Ref<T>(m[parentIndex]);
         size_t i = parentIndex - 1;
@@ -123,7 +135,7 @@ namespace detail {
     }
 
     template<NodeType Type, typename T>
-    inline void DispatchOpSimpleNary(Operon::Vector<Array<T>>& m, Operon::Vector<Node> const& nodes, size_t parentIndex, size_t /* row number - not used */)
+    inline void DispatchOpSimpleNary(Operon::Vector<Array<T>>& m, Operon::Span<Node const> nodes, size_t parentIndex, size_t /* row number - not used */)
     {
         auto r = Ref<T>(m[parentIndex]);
         size_t arity = nodes[parentIndex].Arity;
@@ -165,7 +177,7 @@ namespace detail {
     };
 
     template<typename T>
-    using Callable = typename std::function<void(Operon::Vector<Array<T>>&, Operon::Vector<Node> const&, size_t, size_t)>;
+    using Callable = typename std::function<void(Operon::Vector<Array<T>>&, Operon::Span<Node const>, size_t, size_t)>;
 
     template<NodeType Type, typename T>
     static constexpr auto MakeCall() -> Callable<T>
@@ -179,13 +191,167 @@ namespace detail {
         }
     }
 
+    // plain function pointers for the built-in primitives, used by the interpreter to bypass the type-erased callables
+    template<typename T>
+    using FunctionPointer = void(*)(Operon::Vector<Array<T>>&, Operon::Span<Node const>, size_t, size_t);
+
+    template<NodeType Type, typename T>
+    static constexpr auto MakeFunctionPointer() -> FunctionPointer<T>
+    {
+        if constexpr (Type < NodeType::Aq) {
+            return &detail::DispatchOpNary<Type, T>;
+        } else if constexpr (Type < NodeType::Abs) {
+            return &detail::DispatchOpBinary<Type, T>;
+        } else if constexpr (Type < NodeType::Dynamic) {
+            return &detail::DispatchOpUnary<Type, T>;
+        }
+    }
+
+    // the kernel of the programs whose primitives are not all in one of the specialized primitive sets
+    static constexpr PrimitiveSetConfig GenericKernel = static_cast<PrimitiveSetConfig>(0);
+
+    template<NodeType Type, typename T>
+    inline void DispatchOp(Operon::Vector<Array<T>>& m, Operon::Span<Node const> nodes, size_t i, size_t row)
+    {
+        if constexpr (Type < NodeType::Aq) {
+            DispatchOpNary<Type, T>(m, nodes, i, row);
+        } else if constexpr (Type < NodeType::Abs) {
+            DispatchOpBinary<Type, T>(m, nodes, i, row);
+        } else {
+            DispatchOpUnary<Type, T>(m, nodes, i, row);
+        }
+    }
+
+    template<PrimitiveSetConfig Config, typename T, std::size_t... Is>
+    inline auto DispatchKernel(NodeType type, Operon::Vector<Array<T>>& m, Operon::Span<Node const> nodes, size_t i, size_t row, std::index_sequence<Is...> /*unused*/) -> bool
+    {
+        auto call = [&](auto idx) {
+            constexpr auto t = static_cast<NodeType>(1U << decltype(idx)::value);
+            if constexpr ((Config & t) == t) {
+                if (type == t) {
+                    DispatchOp<t, T>(m, nodes, i, row);
+                    return true;
+                }
+            }
+            return false;
+        };
+        return (call(std::integral_constant<std::size_t, Is>{}) || ...);
+    }
+
+    // dense dispatch of the built-in primitives of a specialized primitive set (see GenericInterpreter::SetKernel):
+    // the primitives are called directly and inlined, the ones outside Config are compiled out. returns false for them
+    template<PrimitiveSetConfig Config, typename T>
+    inline auto DispatchKernel(NodeType type, Operon::Vector<Array<T>>& m, Operon::Span<Node const> nodes, size_t i, size_t row) -> bool
+    {
+        return DispatchKernel<Config, T>(type, m, nodes, i, row, std::make_index_sequence<NodeTypes::Count - 3>{});
+    }
+
+    // the built-in primitives of the root node write straight into the output of the interpreter: the result and the
+    // arguments are views of the first rows of the batch columns, so a partial batch is only computed over its rows
+    template<typename T>
+    using OutputPointer = void(*)(Operon::Vector<Array<T>>&, Operon::Span<Node const>, size_t, T*, int);
+
+    template<NodeType Type, typename T, int Rows>
+    inline void DispatchOpOutput(Operon::Vector<Array<T>>& m, Operon::Span<Node const> nodes, size_t i, T* out, int rows)
+    {
+        using V = Eigen::Map<Eigen::Array<T, Rows, 1>>;
+        using A = Eigen::Map<Eigen::Array<T, Rows, 1> const, Eigen::AlignedMax>; // the batch columns are aligned
+        auto arg = [&](size_t j) { return A(m[j].data(), rows); };
+        if constexpr (Type < NodeType::Aq) {
+            ApplyNary<Type>(V(out, rows), arg, nodes, i);
+        } else if constexpr (Type < NodeType::Abs) {
+            auto j = i - 1;
+            auto k = j - nodes[j].Length - 1;
+            Function<Type>{}(V(out, rows), arg(j), arg(k));
+        } else {
+            Function<Type>{}(V(out, rows), arg(i - 1));
+        }
+    }
+
+    template<NodeType Type, typename T>
+    inline void DispatchOpOutput(Operon::Vector<Array<T>>& m, Operon::Span<Node const> nodes, size_t i, T* out, int rows)
+    {
+        static_assert(Type < NodeType::Dynamic);
+        if (rows == static_cast<int>(BatchSize<T>::Value)) {
+            DispatchOpOutput<Type, T, static_cast<int>(BatchSize<T>::Value)>(m, nodes, i, out, rows);
+        } else {
+            DispatchOpOutput<Type, T, Eigen::Dynamic>(m, nodes, i, out, rows);
+        }
+    }
+
+    // fused unary primitive of a weighted variable leaf: the argument w * x is computed straight from the dataset
+    // column into the result (a batch column or the output), which the primitive then overwrites in place (the
+    // primitives are elementwise)
+    template<typename T>
+    using FusedUnaryPointer = void(*)(T*, T const*, T, int);
+
+    template<NodeType Type, typename T, int Rows>
+    inline void DispatchFusedUnary(T* out, T const* values, T weight, int rows)
+    {
+        Eigen::Map<Eigen::Array<T, Rows, 1>> r(out, rows);
+        r = weight * Eigen::Map<Eigen::Array<T, Rows, 1> const>(values, rows);
+        Function<Type>{}(r, r);
+    }
+
+    template<NodeType Type, typename T>
+    inline void DispatchFusedUnary(T* out, T const* values, T weight, int rows)
+    {
+        static_assert(Type < NodeType::Dynamic && Type > NodeType::Pow);
+        if (rows == static_cast<int>(BatchSize<T>::Value)) {
+            DispatchFusedUnary<Type, T, static_cast<int>(BatchSize<T>::Value)>(out, values, weight, rows);
+        } else {
+            DispatchFusedUnary<Type, T, Eigen::Dynamic>(out, values, weight, rows);
+        }
+    }
+
+    template<NodeType Type, typename T>
+    static constexpr auto MakeFusedUnaryPointer() -> FusedUnaryPointer<T>
+    {
+        if constexpr (Type > NodeType::Pow && Type < NodeType::Dynamic) {
+            return &detail::DispatchFusedUnary<Type, T>;
+        } else {
+            return nullptr;
+        }
+    }
+
+    // jump table indexed by NodeTypes::GetIndex (exclude constant, variable, dynamic)
+    template<typename T>
+    struct JumpTable {
+        static constexpr size_t Size = NodeTypes::Count - 3;
+
+        template<std::size_t... Is>
+        static constexpr auto Make(std::index_sequence<Is...> /*unused*/) -> std::array<FunctionPointer<T>, Size>
+        {
+            return {{ MakeFunctionPointer<static_cast<NodeType>(1U << Is), T>()... }};
+        }
+
+        static constexpr std::array<FunctionPointer<T>, Size> Table = Make(std::make_index_sequence<Size>{});
+
+        template<std::size_t... Is>
+        static constexpr auto MakeFused(std::index_sequence<Is...> /*unused*/) -> std::array<FusedUnaryPointer<T>, Size>
+        {
+            return {{ MakeFusedUnaryPointer<static_cast<NodeType>(1U << Is), T>()... }};
+        }
+
+        template<std::size_t... Is>
+        static constexpr auto MakeOutput(std::index_sequence<Is...> /*unused*/) -> std::array<OutputPointer<T>, Size>
+        {
+            return {{ &DispatchOpOutput<static_cast<NodeType>(1U << Is), T>... }};
+        }
+
+        static constexpr std::array<OutputPointer<T>, Size> Output = MakeOutput(std::make_index_sequence<Size>{});
+
+        // the fused unary primitives, nullptr for the other types
+        static constexpr std::array<FusedUnaryPointer<T>, Size> FusedUnary = MakeFused(std::make_index_sequence<Size>{});
+    };
+
     template<NodeType Type, typename... Ts, std::enable_if_t<sizeof...(Ts) != 0, bool> = true>
     static constexpr auto MakeTuple()
     {
         return std::make_tuple(MakeCall<Type, Ts>()...);
     };
 
-    template<typename F, typename... Ts, std::enable_if_t<sizeof...(Ts) != 0 && (std::is_invocable_r_v<void, F, detail::Array<Ts>&, Vector<Node> const&, size_t, size_t> && ...), bool> = true>
+    template<typename F, typename... Ts, std::enable_if_t<sizeof...(Ts) != 0 && (std::is_invocable_r_v<void, F, detail::Array<Ts>&, Operon::Span<Node const>, size_t, size_t> && ...), bool> = true>
     static constexpr auto MakeTuple(F&& f)
     {
         return std::make_tuple(Callable<Ts>(std::forward<F&&>(f))...);
@@ -197,11 +363,15 @@ struct DispatchTable {
     template<typename T>
     using Callable = detail::Callable<T>;
 
+    template<typename T>
+    using FunctionPointer = detail::FunctionPointer<T>;
+
     using Tuple    = std::tuple<Callable<Ts>...>;
     using Map      = robin_hood::unordered_flat_map<Operon::Hash, Tuple>;
 
 private:
     Map map_;
+    uint32_t overridden_{0}; // bitmask of built-in primitives whose callables were replaced by the user
 
     template<std::size_t... Is>
     void InitMap(std::index_sequence<Is...> /*unused*/)
@@ -221,17 +391,19 @@ public:
     auto operator=(DispatchTable const& other) -> DispatchTable& {
         if (this != &other) {
             map_ = other.map_;
+            overridden_ = other.overridden_;
         }
         return *this;
     }
 
     auto operator=(DispatchTable&& other) noexcept -> DispatchTable& {
         map_ = std::move(other.map_);
+        overridden_ = other.overridden_;
         return *this;
     }
 
-    DispatchTable(DispatchTable const& other) : map_(other.map_) { }
-    DispatchTable(DispatchTable &&other) noexcept : map_(std::move(other.map_)) { }
+    DispatchTable(DispatchTable const& other) : map_(other.map_), overridden_(other.overridden_) { }
+    DispatchTable(DispatchTable &&other) noexcept : map_(std::move(other.map_)), overridden_(other.overridden_) { }
 
     template<typename T>
     inline auto Get(Operon::Hash const h) -> Callable<T>&
@@ -250,9 +422,45 @@ public:
         throw std::runtime_error(fmt::format("Hash value {} is not in the map\n", h));
     }
 
+    // returns the statically dispatched function for a built-in primitive, or nullptr if the
+    // type is not a built-in function or if its callable was replaced via RegisterCallable
+    template<typename T>
+    [[nodiscard]] inline auto GetFunctionPointer(NodeType type) const -> FunctionPointer<T>
+    {
+        if (!(type < NodeType::Dynamic)) { return nullptr; }
+        auto const idx = NodeTypes::GetIndex(type);
+        if ((overridden_ & (1U << idx)) != 0U) { return nullptr; }
+        return detail::JumpTable<T>::Table[idx];
+    }
+
+    // the form of a built-in primitive which writes into the output (see detail::DispatchOpOutput), nullptr for the
+    // other types and for overridden primitives
+    template<typename T>
+    [[nodiscard]] inline auto GetOutputPointer(NodeType type) const -> detail::OutputPointer<T>
+    {
+        if (!(type < NodeType::Dynamic)) { return nullptr; }
+        auto const idx = NodeTypes::GetIndex(type);
+        if ((overridden_ & (1U << idx)) != 0U) { return nullptr; }
+        return detail::JumpTable<T>::Output[idx];
+    }
+
+    // the fused form of a built-in unary primitive applied to a weighted variable (see detail::DispatchFusedUnary),
+    // nullptr for the other types and for overridden primitives
+    template<typename T>
+    [[nodiscard]] inline auto GetFusedUnaryPointer(NodeType type) const -> detail::FusedUnaryPointer<T>
+    {
+        if (!(type < NodeType::Dynamic)) { return nullptr; }
+        auto const idx = NodeTypes::GetIndex(type);
+        if ((overridden_ & (1U << idx)) != 0U) { return nullptr; }
+        return detail::JumpTable<T>::FusedUnary[idx];
+    }
+
     template<typename F>
     void RegisterCallable(Operon::Hash hash, F const& f) {
-        map_[hash] = detail::MakeTuple<F, Ts...>(f);
+        for (size_t i = 0; i < detail::JumpTable<Operon::Scalar>::Size; ++i) {
+            if (Node(static_cast<NodeType>(1U << i)).HashValue == hash) { overridden_ |= (1U << i); }
+        }
+        map_[hash] = detail::MakeTuple<F const&, Ts...>(f);
     }
 };
 
@@ -4,11 +4,55 @@
 #ifndef OPERON_INTERPRETER_FUNCTIONS_HPP
 #define OPERON_INTERPRETER_FUNCTIONS_HPP
 
+#include <type_traits>
+
 #include "operon/core/node.hpp"
 #include "operon/ceres/jet.h" // for ceres::cbrt 
 
+#if defined(OPERON_VECTORIZED_MATH)
+#include <vectorclass/vectorclass.h>
+#include <vectorclass/vectormath_exp.h>
+#include <vectorclass/vectormath_hyp.h>
+#include <vectorclass/vectormath_trig.h>
+#endif
+
 namespace Operon
 {
+    namespace detail {
+#if defined(OPERON_VECTORIZED_MATH)
+        template<typename T> struct SimdVector { };
+        template<> struct SimdVector<float> { using Type = Vec8f; };
+        template<> struct SimdVector<double> { using Type = Vec4d; };
+
+        // explicit simd kernels are only used for plain floating point types (not for dual numbers)
+        template<typename T>
+        static constexpr bool IsVectorizable = std::is_same_v<T, float> || std::is_same_v<T, double>;
+
+        // apply a vectorclass function over the contiguous storage of the argument arrays
+        template<typename F, typename R, typename... Args>
+        inline void Vectorized(F&& f, R r, Args... args)
+        {
+            using V = typename SimdVector<typename R::Scalar>::Type;
+            constexpr auto w = static_cast<Eigen::Index>(V::size());
+            auto const n = r.size();
+            Eigen::Index i = 0;
+            for (; i + w <= n; i += w) {
+                f(V().load(args.data() + i)...).store(r.data() + i);
+            }
+            if (i < n) {
+                auto const k = static_cast<int>(n - i);
+                f(V().load_partial(k, args.data() + i)...).store_partial(k, r.data() + i);
+            }
+        }
+#else
+        template<typename T>
+        static constexpr bool IsVectorizable = false;
+
+        template<typename F, typename R, typename... Args>
+        inline void Vectorized(F&& /*unused*/, R /*unused*/, Args... /*unused*/) { }
+#endif
+    } // namespace detail
+
     template<Operon::NodeType N = NodeType::Add>
     struct Function 
     {
@@ -135,154 +179,308 @@ namespace Operon
     struct Function<NodeType::Aq>
     {
         template<typename R, typename T>
-        inline void operator()(R r, T t1, T t2) { r = t1 / (typename T::Scalar{1.0} + t2.square()).sqrt(); }
+        inline void operator()(R r, T t1, T t2)
+        {
+            if constexpr (detail::IsVectorizable<typename T::Scalar>) {
+                detail::Vectorized([](auto a, auto b) { return a / sqrt(decltype(b)(1) + b * b); }, r, t1, t2);
+            } else {
+                r = t1 / (typename T::Scalar{1.0} + t2.square()).sqrt();
+            }
+        }
     };
 
     template<>
     struct Function<NodeType::Pow>
     {
         template<typename R, typename T>
-        inline void operator()(R r, T t1, T t2) { r = t1.pow(t2); }
+        inline void operator()(R r, T t1, T t2)
+        {
+            if constexpr (detail::IsVectorizable<typename T::Scalar>) {
+                detail::Vectorized([](auto a, auto b) { return pow(a, b); }, r, t1, t2);
+            } else {
+                r = t1.pow(t2);
+            }
+        }
     };
 
     template<>
     struct Function<NodeType::Abs>
     {
         template<typename R, typename T>
-        inline void operator()(R r, T t) { r = t.abs(); }
+        inline void operator()(R r, T t)
+        {
+            if constexpr (detail::IsVectorizable<typename T::Scalar>) {
+                detail::Vectorized([](auto v) { return abs(v); }, r, t);
+            } else {
+                r = t.abs();
+            }
+        }
     };
 
     template<>
     struct Function<NodeType::Log>
     {
         template<typename R, typename T>
-        inline void operator()(R r, T t) { r = t.log(); }
+        inline void operator()(R r, T t)
+        {
+            if constexpr (detail::IsVectorizable<typename T::Scalar>) {
+                detail::Vectorized([](auto v) { return log(v); }, r, t);
+            } else {
+                r = t.log();
+            }
+        }
     };
 
     template<>
     struct Function<NodeType::Logabs>
     {
         template<typename R, typename T>
-        inline void operator()(R r, T t) { r = t.abs().log(); }
+        inline void operator()(R r, T t)
+        {
+            if constexpr (detail::IsVectorizable<typename T::Scalar>) {
+                detail::Vectorized([](auto v) { return log(abs(v)); }, r, t);
+            } else {
+                r = t.abs().log();
+            }
+        }
     };
 
     template<>
     struct Function<NodeType::Log1p>
     {
         template<typename R, typename T>
-        inline void operator()(R r, T t) { r = t.log1p(); }
+        inline void operator()(R r, T t)
+        {
+            if constexpr (detail::IsVectorizable<typename T::Scalar>) {
+                detail::Vectorized([](auto v) { return log1p(v); }, r, t);
+            } else {
+                r = t.log1p();
+            }
+        }
     };
 
     template<>
     struct Function<NodeType::Ceil>
     {
         template<typename R, typename T>
-        inline void operator()(R r, T t) { r = t.ceil(); }
+        inline void operator()(R r, T t)
+        {
+            if constexpr (detail::IsVectorizable<typename T::Scalar>) {
+                detail::Vectorized([](auto v) { return ceil(v); }, r, t);
+            } else {
+                r = t.ceil();
+            }
+        }
     };
 
     template<>
     struct Function<NodeType::Floor>
     {
         template<typename R, typename T>
-        inline void operator()(R r, T t) { r = t.floor(); }
+        inline void operator()(R r, T t)
+        {
+            if constexpr (detail::IsVectorizable<typename T::Scalar>) {
+                detail::Vectorized([](auto v) { return floor(v); }, r, t);
+            } else {
+                r = t.floor();
+            }
+        }
     };
 
     template<>
     struct Function<NodeType::Exp>
     {
         template<typename R, typename T>
-        inline void operator()(R r, T t) { r = t.exp(); }
+        inline void operator()(R r, T t)
+        {
+            if constexpr (detail::IsVectorizable<typename T::Scalar>) {
+                detail::Vectorized([](auto v) { return exp(v); }, r, t);
+            } else {
+                r = t.exp();
+            }
+        }
     };
 
     template<>
     struct Function<NodeType::Sin>
     {
         template<typename R, typename T>
-        inline void operator()(R r, T t) { r = t.sin(); }
+        inline void operator()(R r, T t)
+        {
+            if constexpr (detail::IsVectorizable<typename T::Scalar>) {
+                detail::Vectorized([](auto v) { return sin(v); }, r, t);
+            } else {
+                r = t.sin();
+            }
+        }
     };
 
     template<>
     struct Function<NodeType::Cos>
     {
         template<typename R, typename T>
-        inline void operator()(R r, T t) { r = t.cos(); }
+        inline void operator()(R r, T t)
+        {
+            if constexpr (detail::IsVectorizable<typename T::Scalar>) {
+                detail::Vectorized([](auto v) { return cos(v); }, r, t);
+            } else {
+                r = t.cos();
+            }
+        }
     };
 
     template<>
     struct Function<NodeType::Tan>
     {
         template<typename R, typename T>
-        inline void operator()(R r, T t) { r = t.tan(); }
+        inline void operator()(R r, T t)
+        {
+            if constexpr (detail::IsVectorizable<typename T::Scalar>) {
+                detail::Vectorized([](auto v) { return tan(v); }, r, t);
+            } else {
+                r = t.tan();
+            }
+        }
     };
 
     template<>
     struct Function<NodeType::Asin>
     {
         template<typename R, typename T>
-        inline void operator()(R r, T t) { r = t.asin(); }
+        inline void operator()(R r, T t)
+        {
+            if constexpr (detail::IsVectorizable<typename T::Scalar>) {
+                detail::Vectorized([](auto v) { return asin(v); }, r, t);
+            } else {
+                r = t.asin();
+            }
+        }
     };
 
     template<>
     struct Function<NodeType::Acos>
     {
         template<typename R, typename T>
-        inline void operator()(R r, T t) { r = t.acos(); }
+        inline void operator()(R r, T t)
+        {
+            if constexpr (detail::IsVectorizable<typename T::Scalar>) {
+                detail::Vectorized([](auto v) { return acos(v); }, r, t);
+            } else {
+                r = t.acos();
+            }
+        }
     };
 
     template<>
     struct Function<NodeType::Atan>
     {
         template<typename R, typename T>
-        inline void operator()(R r, T t) { r = t.atan(); }
+        inline void operator()(R r, T t)
+        {
+            if constexpr (detail::IsVectorizable<typename T::Scalar>) {
+                detail::Vectorized([](auto v) { return atan(v); }, r, t);
+            } else {
+                r = t.atan();
+            }
+        }
     };
 
     template<>
     struct Function<NodeType::Sinh>
     {
         template<typename R, typename T>
-        inline void operator()(R r, T t) { r = t.sinh(); }
+        inline void operator()(R r, T t)
+        {
+            if constexpr (detail::IsVectorizable<typename T::Scalar>) {
+                detail::Vectorized([](auto v) { return sinh(v); }, r, t);
+            } else {
+                r = t.sinh();
+            }
+        }
     };
 
     template<>
     struct Function<NodeType::Cosh>
     {
         template<typename R, typename T>
-        inline void operator()(R r, T t) { r = t.cosh(); }
+        inline void operator()(R r, T t)
+        {
+            if constexpr (detail::IsVectorizable<typename T::Scalar>) {
+                detail::Vectorized([](auto v) { return cosh(v); }, r, t);
+            } else {
+                r = t.cosh();
+            }
+        }
     };
 
     template<>
     struct Function<NodeType::Tanh>
     {
         template<typename R, typename T>
-        inline void operator()(R r, T t) { r = t.tanh(); }
+        inline void operator()(R r, T t)
+        {
+            if constexpr (detail::IsVectorizable<typename T::Scalar>) {
+                detail::Vectorized([](auto v) { return tanh(v); }, r, t);
+            } else {
+                r = t.tanh();
+            }
+        }
     };
 
     template<>
     struct Function<NodeType::Sqrt>
     {
         template<typename R, typename T>
-        inline void operator()(R r, T t) { r = t.sqrt(); }
+        inline void operator()(R r, T t)
+        {
+            if constexpr (detail::IsVectorizable<typename T::Scalar>) {
+                detail::Vectorized([](auto v) { return sqrt(v); }, r, t);
+            } else {
+                r = t.sqrt();
+            }
+        }
     };
 
     template<>
     struct Function<NodeType::Sqrtabs>
     {
         template<typename R, typename T>
-        inline void operator()(R r, T t) { r = t.abs().sqrt(); }
+        inline void operator()(R r, T t)
+        {
+            if constexpr (detail::IsVectorizable<typename T::Scalar>) {
+                detail::Vectorized([](auto v) { return sqrt(abs(v)); }, r, t);
+            } else {
+                r = t.abs().sqrt();
+            }
+        }
     };
 
     template<>
     struct Function<NodeType::Cbrt>
     {
         template<typename R, typename T>
-        inline void operator()(R r, T t) { r = t.unaryExpr([](typename T::Scalar const& v) { return ceres::cbrt(v); }); }
+        inline void operator()(R r, T t)
+        {
+            if constexpr (detail::IsVectorizable<typename T::Scalar>) {
+                detail::Vectorized([](auto v) { return cbrt(v); }, r, t);
+            } else {
+                r = t.unaryExpr([](typename T::Scalar const& v) { return ceres::cbrt(v); });
+            }
+        }
     };
 
     template<>
     struct Function<NodeType::Square>
     {
         template<typename R, typename T>
-        inline void operator()(R r, T t) { r = t.square(); }
+        inline void operator()(R r, T t)
+        {
+            if constexpr (detail::IsVectorizable<typename T::Scalar>) {
+                detail::Vectorized([](auto v) { return v * v; }, r, t);
+            } else {
+                r = t.square();
+            }
+        }
     };
 
     template<>
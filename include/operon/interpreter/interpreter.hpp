@@ -5,17 +5,61 @@
 #define OPERON_INTERPRETER_HPP
 
 #include <algorithm>
-#include <optional>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <numeric>
 #include <utility>
 
 #include "operon/core/dataset.hpp"
 #include "operon/core/dual.hpp"
+#include "operon/core/instrumentation.hpp"
+#include "operon/core/memory.hpp"
+#include "operon/core/packed_inputs.hpp"
+#include "operon/core/pset.hpp"
+#include "operon/core/simd.hpp"
 #include "operon/core/tree.hpp"
 #include "operon/core/types.hpp"
+#include "operon/operon_export.hpp"
+#include "derivatives.hpp"
 #include "dispatch_table.hpp"
+#include "jit.hpp"
+#include "subtree_cache.hpp"
+
+namespace tf { class Executor; }
 
 namespace Operon {
 
+namespace detail {
+    // per-thread scratch space for the interpreter buffers, so that repeated evaluations (e.g. the residual
+    // and jacobian calls inside the optimizer) do not allocate. buffers only ever grow (unless the memory is over
+    // the soft limit, see Memory::Buffer) and the callables only access the slots corresponding to the nodes of
+    // the current tree, so oversized buffers are harmless
+    template<typename T>
+    struct Workspace {
+        static auto Buffer(size_t size) -> Operon::Vector<Array<T>>&
+        {
+            thread_local Memory::Buffer<Operon::Vector<Array<T>>> buffer(Memory::Subsystem::Interpreter);
+            return buffer.Get(size);
+        }
+
+        // adjoint buffer used by reverse-mode differentiation
+        static auto Adjoints(size_t size) -> Operon::Vector<Array<T>>&
+        {
+            thread_local Memory::Buffer<Operon::Vector<Array<T>>> buffer(Memory::Subsystem::Interpreter);
+            return buffer.Get(size);
+        }
+
+        static auto Buffers(size_t count) -> Operon::Vector<Operon::Vector<Array<T>>>&
+        {
+            thread_local Operon::Vector<Operon::Vector<Array<T>>> buffers;
+            if (buffers.size() < count) { buffers.resize(count); }
+            return buffers;
+        }
+    };
+} // namespace detail
+
 template<typename... Ts>
 struct GenericInterpreter {
     using DTable = DispatchTable<Ts...>;
@@ -27,9 +71,30 @@ struct GenericInterpreter {
 
     GenericInterpreter() : GenericInterpreter(DTable{}) { }
 
+    // the primitive sets with a specialized evaluation loop, in which the primitives are dispatched by a dense switch
+    // over the enabled types instead of through function pointers (see detail::DispatchKernel)
+    static constexpr std::array<PrimitiveSetConfig, 3> Kernels { PrimitiveSet::Arithmetic, PrimitiveSet::TypeCoherent, PrimitiveSet::Full };
+
+    // selects the smallest specialized kernel containing the given primitives (detail::GenericKernel, or primitives
+    // outside all the kernels, select the generic evaluation). the programs compiled afterwards use it if their
+    // primitives are built-in (not overridden) and in the kernel; only the scalar programs are specialized
+    void SetKernel(PrimitiveSetConfig primitives) noexcept
+    {
+        kernel_ = detail::GenericKernel;
+        if (primitives == detail::GenericKernel) { return; }
+        for (auto k : Kernels) {
+            if ((k & primitives) == primitives) {
+                kernel_ = k;
+                return;
+            }
+        }
+    }
+
+    [[nodiscard]] auto Kernel() const noexcept -> PrimitiveSetConfig { return kernel_; }
+
     // evaluate a tree and return a vector of values
     template <typename T>
-    auto Evaluate(Tree const& tree, Dataset const& dataset, Range const range, T const* const parameters = nullptr) const noexcept -> Operon::Vector<T>
+    auto Evaluate(TreeView tree, Dataset const& dataset, Range const range, T const* const parameters = nullptr) const noexcept -> Operon::Vector<T>
     {
         Operon::Vector<T> result(range.Size());
         Evaluate<T>(tree, dataset, range, Operon::Span<T>(result), parameters);
@@ -37,90 +102,841 @@ struct GenericInterpreter {
     }
 
     template <typename T>
-    auto Evaluate(Tree const& tree, Dataset const& dataset, Range const range, size_t const batchSize, T const* const parameters = nullptr) const noexcept -> Operon::Vector<T>
+    auto Evaluate(TreeView tree, Dataset const& dataset, Range const range, size_t const batchSize, T const* const parameters = nullptr) const noexcept -> Operon::Vector<T>
     {
         Operon::Vector<T> result(range.Size());
         Operon::Span<T> view(result);
+        auto const program = Compile<T>(tree, dataset);
 
-        size_t n = range.Size() / batchSize;
-        size_t m = range.Size() % batchSize;
-        std::vector<size_t> indices(n + (m != 0));
-        std::iota(indices.begin(), indices.end(), 0UL);
-        std::for_each(indices.begin(), indices.end(), [&](auto idx) {
-            auto start = range.Start() + idx * batchSize;
+        for (size_t offset = 0; offset < range.Size(); offset += batchSize) {
+            auto start = range.Start() + offset;
             auto end = std::min(start + batchSize, range.End());
-            auto subview = view.subspan(idx * batchSize, end - start);
-            Evaluate(tree, dataset, Range { start, end }, subview, parameters);
-        });
+            Evaluate<T>(program, Range { start, end }, view.subspan(offset, end - start), parameters);
+        }
         return result;
     }
 
+    // a tree lowered to a flat instruction stream which can be evaluated repeatedly (e.g. during coefficient
+    // optimization where the topology does not change). the program references the tree, dataset and
+    // dispatch table it was compiled against, so it must not outlive them (registering new callables
+    // in the dispatch table also invalidates existing programs)
     template <typename T>
-    void Evaluate(Tree const& tree, Dataset const& dataset, Range const range, Operon::Span<T> result, T const* const parameters = nullptr) const noexcept
-    {
+    struct Program {
         using Callable = typename DTable::template Callable<T>;
-        const auto& nodes = tree.Nodes();
+        using FunctionPointer = typename DTable::template FunctionPointer<T>;
+        // programs evaluated in float read the single precision columns (see Dataset::StoreSinglePrecision)
+        using Storage = std::conditional_t<std::is_same_v<T, float>, float, Operon::Scalar>;
+
+        // superinstructions: the node computes its weighted variable children itself, reading their dataset columns
+        // directly instead of their batch columns (see Fuse)
+        enum class Fusion : uint8_t { None, Unary, Add, Mul };
+
+        struct Instruction {
+            FunctionPointer Ptr;          // static dispatch for built-in primitives, nullptr otherwise
+            Callable const* Func;         // type-erased callable for user-defined functions, nullptr otherwise
+            Storage const* Values;        // variable column (full dataset column), nullptr otherwise
+            T Value;                      // the node value (coefficient or variable weight)
+            int64_t Coefficient;          // index into the parameter array, -1 for function nodes
+            int64_t Source;               // index of an identical subtree evaluated earlier, -1 otherwise
+            bool Skip;                    // node belongs to a subtree whose values are copied from elsewhere
+            Fusion Fuse { Fusion::None };  // the fused form of the node, if any
+            bool Fused { false };          // weighted variable leaf computed by its fused parent
+            detail::FusedUnaryPointer<T> Unary { nullptr }; // the primitive of a Fusion::Unary node
+            detail::OutputPointer<T> Output { nullptr };     // the form of the root primitive writing into the output
+            size_t FirstRow { 0 };         // the row of the first value of the variable column (see Dataset::FirstRow)
+        };
+
+        Operon::Span<Node const> Nodes;
+        Operon::Vector<Instruction> Code;
+        size_t NumRows;
+        PrimitiveSetConfig Specialization { detail::GenericKernel }; // the specialized evaluation loop, if any (see SetKernel)
+        size_t TileRows { 0 };   // the variables are read from the tiles of packed inputs, zero otherwise
+        size_t TileStride { 0 }; // the distance between two tiles (see PackedInputs)
+        size_t FirstRow { 0 };   // the evaluated ranges start at or after this row (the largest lag of the variables)
+        std::vector<std::shared_ptr<Operon::Vector<Storage> const>> Casts; // the variable columns cast to the storage type, if any
+#if defined(OPERON_JIT)
+        // the native kernel (see operon/interpreter/jit.hpp), looked up by Accelerate
+        mutable Jit::Kernel Kernel{nullptr};
+        mutable bool Native{false}; // the lookup was done
+#endif
+
+        [[nodiscard]] auto Size() const -> size_t { return Code.size(); }
+    };
+
+    // when deduplicate is true, identical subtrees (as identified by their strict hash value) are only
+    // computed once and their values copied for every other occurrence. since the dedup decision is based
+    // on the coefficient values at compile time, it is ignored when evaluating with explicit parameters
+    template <typename T>
+    [[nodiscard]] auto Compile(TreeView tree, Dataset const& dataset, bool deduplicate = false) const -> Program<T>
+    {
+        auto const nodes = tree.Nodes();
         EXPECT(!nodes.empty());
 
+        Program<T> program { nodes, {}, dataset.Rows() };
+        program.Code.reserve(nodes.size());
+
+        int64_t idx = 0;
+        for (auto const& n : nodes) {
+            typename Program<T>::Instruction op { nullptr, nullptr, nullptr, T{n.Value}, -1, -1, false };
+            if (n.IsLeaf()) {
+                op.Coefficient = idx++;
+                if (n.IsVariable()) {
+                    if constexpr (std::is_same_v<typename Program<T>::Storage, Operon::Scalar>) {
+                        op.Values = dataset.GetValues(n.HashValue).data();
+                    } else if (dataset.HasSinglePrecision()) {
+                        op.Values = dataset.template GetValuesAs<T>(n.HashValue).data();
+                    } else {
+                        // without the single precision copy (see Dataset::StoreSinglePrecision) the program casts the column
+                        auto const values = dataset.GetValues(n.HashValue);
+                        auto const& cast = program.Casts.emplace_back(std::make_shared<Operon::Vector<typename Program<T>::Storage> const>(values.begin(), values.end()));
+                        op.Values = cast->data();
+                    }
+                    op.FirstRow = dataset.FirstRow(n.HashValue);
+                    program.FirstRow = std::max(program.FirstRow, op.FirstRow);
+                }
+                if (n.IsDynamic()) { op.Func = &ftable_.template Get<T>(n.HashValue); }
+            } else if (auto ptr = ftable_.template GetFunctionPointer<T>(n.Type); ptr != nullptr) {
+                op.Ptr = ptr;
+            } else {
+                op.Func = &ftable_.template Get<T>(n.HashValue);
+            }
+            program.Code.push_back(op);
+        }
+        if (auto& root = program.Code.back(); root.Ptr != nullptr) {
+            root.Output = ftable_.template GetOutputPointer<T>(nodes.back().Type);
+        }
+        if constexpr (!IsDual<T>::value) {
+            auto const kernel = kernel_ != detail::GenericKernel && std::all_of(nodes.begin(), nodes.end(), [&](auto const& n) {
+                if (n.IsConstant() || n.IsVariable()) { return true; }
+                return (kernel_ & n.Type) == n.Type && ftable_.template GetFunctionPointer<T>(n.Type) != nullptr;
+            });
+            if (kernel) { program.Specialization = kernel_; }
+        }
+
+        if constexpr (std::is_same_v<T, typename Program<T>::Storage>) {
+            Fuse(program);
+        }
+        if (deduplicate) {
+            Deduplicate(tree, program);
+        }
+        return program;
+    }
+
+    // compile against the packed inputs of the problem (see PackedInputs): the variable leaves read the tiles and the
+    // batches of Evaluate, EvaluateStreaming and the evaluation over a set of rows end at the tile boundaries. the other
+    // evaluations (derivatives, mixed, batched) read the dataset columns and need a program compiled against the
+    // dataset. the trees reading a variable which is not packed, and the programs evaluated in single precision,
+    // are compiled against the dataset
+    template <typename T>
+    [[nodiscard]] auto Compile(TreeView tree, Dataset const& dataset, PackedInputs const& packed, bool deduplicate = false) const -> Program<T>
+    {
+        auto program = Compile<T>(tree, dataset, deduplicate);
+        if constexpr (std::is_same_v<typename Program<T>::Storage, Operon::Scalar>) {
+            EXPECT(packed.Rows() == dataset.Rows());
+            auto const nodes = program.Nodes;
+            auto const packable = std::all_of(nodes.begin(), nodes.end(), [&](auto const& n) {
+                return !n.IsVariable() || packed.Column(n.HashValue) >= 0;
+            });
+            if (!packable) { return program; }
+            for (size_t i = 0; i < nodes.size(); ++i) {
+                if (!nodes[i].IsVariable()) { continue; }
+                program.Code[i].Values = packed.Values(static_cast<size_t>(packed.Column(nodes[i].HashValue)));
+                program.Code[i].FirstRow = 0; // the tiles hold all the rows
+            }
+            program.TileRows = packed.TileRows();
+            program.TileStride = packed.TileStride();
+        }
+        return program;
+    }
+
+    template <typename T>
+    void Evaluate(TreeView tree, Dataset const& dataset, Range const range, Operon::Span<T> result, T const* const parameters = nullptr) const noexcept
+    {
+        Evaluate<T>(Compile<T>(tree, dataset), range, result, parameters);
+    }
+
+    template <typename T>
+    void Evaluate(Program<T> const& program, Range const range, Operon::Span<T> result, T const* const parameters = nullptr) const noexcept
+    {
+        EXPECT(!program.Code.empty());
+        EXPECT(range.End() <= program.NumRows);
+        EXPECT(range.Start() >= program.FirstRow);
+#if defined(OPERON_JIT)
+        if constexpr (std::is_same_v<T, Operon::Scalar>) {
+            if (EvaluateNative(program, range, result, parameters)) { return; }
+        }
+#endif
+
+        constexpr int S = static_cast<Eigen::Index>(detail::BatchSize<T>::Value);
+        // a built-in root primitive writes straight into the result, so it needs no batch column
+        auto const direct = WritesOutput(program);
+        auto& m = detail::Workspace<T>::Buffer(program.Size() - (direct ? 1 : 0));
+        InitConstants(program, m, parameters);
+
+        int numRows = static_cast<int>(range.Size());
+        for (int row = 0, remainingRows = 0; row < numRows; row += remainingRows) {
+            auto const start = range.Start() + row;
+            remainingRows = BatchRows(program, start, std::min(S, numRows - row));
+            if (direct) {
+                EvaluateBlock(program, m, RowOffset(program, start), remainingRows, parameters, /*fuse=*/true, result.data() + row);
+                continue;
+            }
+            EvaluateBlock(program, m, RowOffset(program, start), remainingRows, parameters);
+            // the final result is found in the last section of the buffer corresponding to the root node
+            std::copy_n(m[program.Size() - 1].data(), remainingRows, result.data() + row);
+        }
+    }
+
+    // evaluate the program on a set of rows in any order (possibly repeated, e.g. a bootstrap sample), without copying
+    // the dataset: the values of the variables are gathered batch by batch into the batch columns of their leaves,
+    // prefetching the rows GatherPrefetchDistance ahead. the cost is proportional to the number of rows, so the
+    // subsamples, the folds and the shuffled views of a large dataset are evaluated in place. the superinstructions
+    // and the native kernels read the dataset columns directly, they are not used
+    template <typename T>
+    void Evaluate(Program<T> const& program, Operon::Span<uint32_t const> rows, Operon::Span<T> result, T const* const parameters = nullptr) const noexcept
+    {
+        EXPECT(!program.Code.empty());
+        EXPECT(result.size() >= rows.size());
+
+        constexpr int S = static_cast<Eigen::Index>(detail::BatchSize<T>::Value);
+        auto& m = detail::Workspace<T>::Buffer(program.Size());
+        InitConstants(program, m, parameters);
+
+        int numRows = static_cast<int>(rows.size());
+        for (int row = 0; row < numRows; row += S) {
+            auto remainingRows = std::min(S, numRows - row);
+            GatherVariables(program, m, rows.subspan(static_cast<size_t>(row), static_cast<size_t>(remainingRows)), parameters);
+            EvaluateBlock(program, m, 0, remainingRows, parameters, /*fuse=*/false, /*out=*/static_cast<T*>(nullptr), /*gathered=*/true);
+            std::copy_n(m[program.Size() - 1].data(), remainingRows, result.data() + row);
+        }
+    }
+
+    template <typename T>
+    void Evaluate(TreeView tree, Dataset const& dataset, Operon::Span<uint32_t const> rows, Operon::Span<T> result, T const* const parameters = nullptr) const noexcept
+    {
+        Evaluate<T>(Compile<T>(tree, dataset), rows, result, parameters);
+    }
+
+    // the rows gathered ahead of the current one (see Evaluate over a set of rows)
+    static constexpr size_t GatherPrefetchDistance = 16;
+
+    // evaluate the program without an output buffer: each batch of root node values (at most one batch of
+    // detail::BatchSize<T> rows) is passed to the callback while still in cache, together with its offset
+    // relative to the start of the range. the callback returns false to stop the evaluation early
+    template <typename T, typename Callback>
+    void EvaluateStreaming(Program<T> const& program, Range const range, Callback&& callback, T const* const parameters = nullptr) const noexcept
+    {
+        EXPECT(!program.Code.empty());
+        EXPECT(range.End() <= program.NumRows);
+        EXPECT(range.Start() >= program.FirstRow);
+
         constexpr int S = static_cast<Eigen::Index>(detail::BatchSize<T>::Value);
-        Operon::Vector<detail::Array<T>> m(nodes.size());
+        auto& m = detail::Workspace<T>::Buffer(program.Size());
+        InitConstants(program, m, parameters);
+
+        auto const& lastCol = m[program.Size() - 1];
+
+        int numRows = static_cast<int>(range.Size());
+        for (int row = 0, remainingRows = 0; row < numRows; row += remainingRows) {
+            auto const start = range.Start() + row;
+            remainingRows = BatchRows(program, start, std::min(S, numRows - row));
+            EvaluateBlock(program, m, RowOffset(program, start), remainingRows, parameters);
+            if (!std::invoke(callback, Operon::Span<T const>(lastCol.data(), static_cast<size_t>(remainingRows)), static_cast<size_t>(row))) {
+                break;
+            }
+        }
+    }
+
+    // forward-mode evaluation with dual numbers of which only some parameters carry derivatives (e.g. the parameters of
+    // one jet chunk, see detail::Autodiff): the nodes without such a parameter in their subtree have zero derivative
+    // parts, so they are evaluated in scalar arithmetic (at the scalar batch size) and only promoted to dual numbers
+    // where they feed a node which depends on the parameters. the scalar program must be compiled from the same tree
+    template <typename T>
+    void EvaluateMixed(Program<Operon::Scalar> const& scalar, Program<T> const& dual, Range const range, Operon::Span<T> result, T const* const parameters) const noexcept
+    {
+        static_assert(!std::is_same_v<T, Operon::Scalar>);
+        EXPECT(parameters != nullptr);
+        EXPECT(scalar.Size() == dual.Size());
+        EXPECT(range.End() <= dual.NumRows);
+        EXPECT(range.Start() >= dual.FirstRow);
+        EXPECT(scalar.TileRows == 0 && dual.TileRows == 0);
+
+        enum class Mode : uint8_t { Scalar, Promoted, Dual };
 
-        using P = Eigen::Map<Eigen::Array<Operon::Scalar, -1, 1> const>;
+        auto const nodes = dual.Nodes;
+        auto const& code = dual.Code;
+        auto const size = code.size();
+
+        thread_local Operon::Vector<Mode> mode;
+        thread_local Operon::Vector<size_t> active; // prefix counts of the leaves whose parameter has derivatives
+        thread_local Operon::Vector<Operon::Scalar> values; // the scalar parts of the parameters
+        mode.resize(size);
+        active.resize(size + 1);
+        values.clear();
+        active[0] = 0;
+        for (size_t i = 0; i < size; ++i) {
+            auto const& op = code[i];
+            bool derivative{false};
+            if (op.Coefficient >= 0) {
+                auto const& p = parameters[op.Coefficient];
+                derivative = !(p.v.array() == 0).all();
+                values.push_back(p.a);
+            }
+            active[i + 1] = active[i] + static_cast<size_t>(derivative);
+        }
+
+        // the subtree of node i spans the nodes [i - length, i] of the postfix order
+        size_t duals{0};
+        for (size_t i = 0; i < size; ++i) {
+            auto const first = i - nodes[i].Length;
+            mode[i] = active[i + 1] > active[first] ? Mode::Dual : Mode::Scalar;
+            duals += static_cast<size_t>(mode[i] == Mode::Dual);
+        }
+        if (duals == size) {
+            Evaluate<T>(dual, range, result, parameters);
+            return;
+        }
+        for (size_t i = 0; i + 1 < size; ++i) {
+            if (mode[i] == Mode::Scalar && mode[nodes[i].Parent] == Mode::Dual) { mode[i] = Mode::Promoted; }
+        }
+        if (mode[size - 1] == Mode::Scalar) { mode[size - 1] = Mode::Promoted; } // nothing depends on the parameters
+
+        auto& ms = detail::Workspace<Operon::Scalar>::Buffer(size);
+        auto& md = detail::Workspace<T>::Buffer(size);
+        InitConstants(scalar, ms, values.data());
+        InitConstants(dual, md, parameters);
 
         Eigen::Map<Eigen::Array<T, -1, 1>> res(result.data(), result.size(), 1);
+        constexpr int SS = static_cast<Eigen::Index>(detail::BatchSize<Operon::Scalar>::Value);
+        constexpr int SD = static_cast<Eigen::Index>(detail::BatchSize<T>::Value);
+        static_assert(SS >= SD);
 
-        struct NodeMeta {
-            T Param;
-            P Values;
-            std::optional<Callable const> Func;
-        };
+        int numRows = static_cast<int>(range.Size());
+        for (int row = 0; row < numRows; row += SS) {
+            auto remainingRows = std::min(SS, numRows - row);
+            auto const start = range.Start() + row;
+            for (size_t i = 0; i < size; ++i) {
+                if (mode[i] == Mode::Dual) { continue; }
+                EvaluateInstruction(scalar.Code[i], ms, nodes, i, start, remainingRows, values.data());
+            }
+
+            // the dual nodes are evaluated in smaller batches within the scalar batch
+            for (int sub = 0; sub < remainingRows; sub += SD) {
+                auto subRows = std::min(SD, remainingRows - sub);
+                for (size_t i = 0; i < size; ++i) {
+                    if (mode[i] == Mode::Promoted) {
+                        md[i].segment(0, subRows) = ms[i].segment(sub, subRows).template cast<T>();
+                    } else if (mode[i] == Mode::Dual) {
+                        EvaluateInstruction(code[i], md, nodes, i, start + sub, subRows, parameters);
+                    }
+                }
+                res.segment(row + sub, subRows) = md[size - 1].segment(0, subRows);
+            }
+        }
+    }
 
-        Operon::Vector<NodeMeta> meta; meta.reserve(nodes.size());
+    // evaluate a tree reusing the subtree outputs stored in the cache (e.g. from the parents of this tree)
+    // - subtrees found in the cache are not evaluated, their values are copied from the cache
+    // - the outputs of the remaining function nodes are inserted into the cache for later use
+    template <typename T>
+    void Evaluate(Tree const& tree, Dataset const& dataset, Range const range, Operon::Span<T> result, SubtreeCache<T>& cache) const noexcept
+    {
+        EXPECT(range.Bounds() == cache.GetRange().Bounds());
 
-        size_t idx = 0;
-        for (size_t i = 0; i < nodes.size(); ++i) {
-            auto const& n = nodes[i];
+        Tree copy{tree};
+        auto const& nodes = copy.Hash(Operon::HashMode::Strict).Nodes();
+        auto program = Compile<T>(tree, dataset);
+        EXPECT(range.Start() >= program.FirstRow);
+        auto& code = program.Code;
 
-            if (n.IsLeaf()) {
-                auto v = parameters ? parameters[idx++] : T{n.Value};
-                Operon::Span<Operon::Scalar const> vals{};
-                if (n.IsConstant()) { m[i].setConstant(v); }
-                if (n.IsVariable()) { vals = dataset.GetValues(n.HashValue).subspan(range.Start(), range.Size()); }
-                auto call = n.IsDynamic() ? std::make_optional(ftable_.template Get<T>(n.HashValue)) : std::nullopt;
-                meta.push_back({ v, P(vals.data(), static_cast<Eigen::Index>(vals.size())), call });
-            } else {
-                meta.push_back({ T{}, P(nullptr, 0L), std::make_optional(ftable_.template Get<T>(n.HashValue)) });
+        // look for the largest cached subtrees, starting from the root
+        Operon::Vector<typename SubtreeCache<T>::Column> cached(nodes.size());
+        for (auto i = static_cast<int64_t>(nodes.size()) - 1; i >= 0; --i) {
+            auto const& n = nodes[i];
+            if (n.IsLeaf() || code[i].Skip) { continue; }
+            if (auto column = cache.Find(n.CalculatedHashValue); column != nullptr) {
+                cached[i] = std::move(column);
+                for (auto j = i - n.Length; j < i; ++j) { code[j].Skip = true; }
             }
         }
 
-        auto& lastCol = m[nodes.size() - 1];
+        // decide which node outputs to store
+        Operon::Vector<Operon::Vector<T>> store(nodes.size());
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            if (nodes[i].IsLeaf() || code[i].Skip || cached[i] != nullptr) { continue; }
+            store[i].resize(range.Size());
+        }
+
+        auto& m = detail::Workspace<T>::Buffer(program.Size());
+        InitConstants(program, m, static_cast<T const*>(nullptr));
+
+        Eigen::Map<Eigen::Array<T, -1, 1>> res(result.data(), result.size(), 1);
+        auto const treeNodes = program.Nodes;
 
+        constexpr int S = static_cast<Eigen::Index>(detail::BatchSize<T>::Value);
         int numRows = static_cast<int>(range.Size());
         for (int row = 0; row < numRows; row += S) {
             auto remainingRows = std::min(S, numRows - row);
+            for (size_t i = 0; i < code.size(); ++i) {
+                auto const& op = code[i];
+                if (op.Skip) { continue; }
+                if (cached[i] != nullptr) {
+                    m[i].segment(0, remainingRows) = Eigen::Map<Eigen::Array<T, -1, 1> const>(cached[i]->data() + row, remainingRows);
+                    continue;
+                }
+                if (op.Ptr != nullptr) {
+                    op.Ptr(m, treeNodes, i, range.Start() + row);
+                } else if (op.Func != nullptr) {
+                    (*op.Func)(m, treeNodes, i, range.Start() + row);
+                } else if (op.Values != nullptr) {
+                    Eigen::Map<Eigen::Array<typename Program<T>::Storage, -1, 1> const> values(op.Values + (range.Start() + row - op.FirstRow), remainingRows);
+                    m[i].segment(0, remainingRows) = op.Value * values.template cast<T>();
+                }
+                if (!store[i].empty()) {
+                    Eigen::Map<Eigen::Array<T, -1, 1>>(store[i].data() + row, remainingRows) = m[i].segment(0, remainingRows);
+                }
+            }
+            res.segment(row, remainingRows) = m[code.size() - 1].segment(0, remainingRows);
+        }
 
-            for (size_t i = 0; i < nodes.size(); ++i) {
-                auto const& s = nodes[i];
-                auto const& [ param, values, func ] = meta[i];
-                if (func) {
-                    func.value()(m, nodes, i, range.Start() + row);
-                } else if (s.IsVariable()) {
-                    m[i].segment(0, remainingRows) = meta[i].Param * values.segment(row, remainingRows).template cast<T>();
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            if (!store[i].empty()) { cache.Insert(nodes[i].CalculatedHashValue, std::move(store[i])); }
+        }
+    }
+
+    // look up the native kernel of the program ahead of its evaluations when the expected work (rows times length
+    // times evaluations) justifies a compilation (see operon/interpreter/jit.hpp). afterwards the evaluations do not
+    // modify the program anymore, so it can be shared between threads. returns true if the program has a kernel
+    static auto Accelerate([[maybe_unused]] Program<Operon::Scalar> const& program, [[maybe_unused]] size_t rows, [[maybe_unused]] size_t evaluations = 1) -> bool
+    {
+#if defined(OPERON_JIT)
+        if (!program.Native) {
+            program.Native = true;
+            // the kernel has no dedup (which the interpreter ignores with parameters anyway) and no dynamic nodes
+            if (Jit::Worthwhile(rows * program.Size() * evaluations) && SupportsReverseMode(program)) {
+                program.Kernel = Jit::Get(program.Nodes);
+            }
+        }
+        return program.Kernel != nullptr;
+#else
+        return false;
+#endif
+    }
+
+    // reverse-mode differentiation requires that all functions are built-in primitives with known derivatives
+    template <typename T>
+    [[nodiscard]] static auto SupportsReverseMode(Program<T> const& program) -> bool
+    {
+        return std::none_of(program.Code.begin(), program.Code.end(), [](auto const& op) {
+            return op.Func != nullptr || op.Source >= 0 || op.Skip;
+        });
+    }
+
+    // compute the tree output values and the jacobian with respect to the coefficients in one forward and one
+    // backward pass per batch. the jacobian has range.Size() rows and one column per leaf (in the given storage order).
+    // with leafAdjoints the columns are the derivatives with respect to the leaf values instead (the variable columns
+    // are not multiplied in), e.g. d(out)/dx = w * column for a variable leaf w * x
+    template <typename T, int StorageOrder = Eigen::ColMajor>
+    void EvaluateJacobian(Program<T> const& program, Range const range, T const* const parameters, Operon::Span<T> result, T* jacobian, bool leafAdjoints = false) const noexcept
+    {
+        EXPECT(SupportsReverseMode(program));
+        EXPECT(range.End() <= program.NumRows);
+        EXPECT(range.Start() >= program.FirstRow);
+        EXPECT(program.TileRows == 0);
+#if defined(OPERON_INSTRUMENTATION)
+        auto const profile = Instrumentation::PrimitiveProfiling();
+        auto const start = profile ? Instrumentation::WallTime() : uint64_t{0};
+#endif
+
+        auto const nodes = program.Nodes;
+        auto const& code = program.Code;
+        auto const numCoefficients = static_cast<Eigen::Index>(std::count_if(code.begin(), code.end(), [](auto const& op) { return op.Coefficient >= 0; }));
+        auto const numRows = static_cast<Eigen::Index>(range.Size());
+
+        auto& m = detail::Workspace<T>::Buffer(program.Size());
+        auto& adj = detail::Workspace<T>::Adjoints(program.Size());
+        InitConstants(program, m, parameters);
+
+        Eigen::Map<Eigen::Array<T, -1, 1>> res(result.data(), result.size(), 1);
+        Eigen::Map<Eigen::Matrix<T, -1, -1, StorageOrder>> jac(jacobian, numRows, numCoefficients);
+
+        constexpr int S = static_cast<Eigen::Index>(detail::BatchSize<T>::Value);
+        for (int row = 0; row < numRows; row += S) {
+            auto remainingRows = std::min(S, static_cast<int>(numRows) - row);
+            // the backward pass needs the values of all the nodes, so the superinstructions are not used
+            EvaluateBlock(program, m, range.Start() + row, remainingRows, parameters, /*fuse=*/false);
+            res.segment(row, remainingRows) = m[code.size() - 1].segment(0, remainingRows);
+
+            for (size_t i = 0; i < code.size(); ++i) { adj[i].setZero(); }
+            adj[code.size() - 1].setOnes();
+
+            for (auto i = static_cast<int64_t>(code.size()) - 1; i >= 0; --i) {
+                detail::Backpropagate<T>(nodes, m, adj, static_cast<size_t>(i));
+
+                auto const& op = code[i];
+                if (op.Coefficient < 0) { continue; }
+                auto col = jac.col(op.Coefficient).segment(row, remainingRows);
+                if (op.Values != nullptr && !leafAdjoints) {
+                    // d(w * x) / dw = x
+                    Eigen::Map<Eigen::Array<typename Program<T>::Storage, -1, 1> const> values(op.Values + (range.Start() + row - op.FirstRow), remainingRows);
+                    col = (adj[i].segment(0, remainingRows) * values.template cast<T>()).matrix();
+                } else {
+                    col = adj[i].segment(0, remainingRows).matrix();
                 }
             }
-            // the final result is found in the last section of the buffer corresponding to the root node
-            res.segment(row, remainingRows) = lastCol.segment(0, remainingRows);
         }
+#if defined(OPERON_INSTRUMENTATION)
+        if (profile) { Instrumentation::RecordJacobian(Instrumentation::WallTime() - start, static_cast<uint64_t>(numRows)); }
+#endif
+    }
+
+    // evaluate several trees over the same range, tiling over rows first and trees second
+    // (this way each block of input values stays in cache while all the trees consume it)
+    template <typename T>
+    void EvaluateBatch(Operon::Span<Tree const> trees, Dataset const& dataset, Range const range, Operon::Span<Operon::Span<T>> results) const noexcept
+    {
+        EXPECT(trees.size() == results.size());
+
+        Operon::Vector<Program<T>> programs;
+        programs.reserve(trees.size());
+        std::transform(trees.begin(), trees.end(), std::back_inserter(programs), [&](auto const& t) { return Compile<T>(t, dataset); });
+
+        auto& buffers = detail::Workspace<T>::Buffers(programs.size());
+        for (size_t i = 0; i < programs.size(); ++i) {
+            if (buffers[i].size() < programs[i].Size()) { buffers[i].resize(programs[i].Size()); }
+            InitConstants<T>(programs[i], buffers[i], nullptr);
+        }
+
+        constexpr int S = static_cast<Eigen::Index>(detail::BatchSize<T>::Value);
+        int numRows = static_cast<int>(range.Size());
+        for (int row = 0; row < numRows; row += S) {
+            auto remainingRows = std::min(S, numRows - row);
+            for (size_t i = 0; i < programs.size(); ++i) {
+                auto& m = buffers[i];
+                EvaluateBlock<T>(programs[i], m, range.Start() + row, remainingRows, nullptr);
+                Eigen::Map<Eigen::Array<T, -1, 1>> res(results[i].data() + row, remainingRows);
+                res = m[programs[i].Size() - 1].segment(0, remainingRows);
+            }
+        }
+    }
+
+    template <typename T>
+    auto EvaluateBatch(Operon::Span<Tree const> trees, Dataset const& dataset, Range const range) const noexcept -> Operon::Vector<Operon::Vector<T>>
+    {
+        Operon::Vector<Operon::Vector<T>> results(trees.size(), Operon::Vector<T>(range.Size()));
+        Operon::Vector<Operon::Span<T>> views;
+        views.reserve(results.size());
+        for (auto& r : results) { views.emplace_back(r.data(), r.size()); }
+        EvaluateBatch<T>(trees, dataset, range, Operon::Span<Operon::Span<T>>(views));
+        return results;
     }
 
     auto GetDispatchTable() -> DTable& { return ftable_; }
     [[nodiscard]] auto GetDispatchTable() const -> DTable const& { return ftable_; }
 
 private:
+#if defined(OPERON_JIT)
+    // returns false if the program has no kernel (see Accelerate), the evaluations never compile one
+    static auto EvaluateNative(Program<Operon::Scalar> const& program, Range const range, Operon::Span<Operon::Scalar> result, Operon::Scalar const* const parameters) noexcept -> bool
+    {
+        if (program.Kernel == nullptr) { return false; }
+        if (program.TileRows != 0 || program.FirstRow != 0) { return false; } // the kernels read whole dataset columns
+
+        thread_local Operon::Vector<Operon::Scalar const*> columns;
+        thread_local Operon::Vector<Operon::Scalar> values;
+        columns.clear();
+        values.clear();
+        for (auto const& op : program.Code) {
+            if (op.Values != nullptr) { columns.push_back(op.Values + range.Start()); }
+            if (parameters == nullptr && op.Coefficient >= 0) { values.push_back(op.Value); }
+        }
+        program.Kernel(columns.data(), parameters != nullptr ? parameters : values.data(), range.Size(), result.data());
+        return true;
+    }
+#endif
+
+    // marks the superinstructions of the program: unary primitives of a weighted variable, and n-ary additions and
+    // multiplications with weighted variable arguments. only for programs whose values have the type of the dataset
+    // columns (not for dual numbers)
+    template <typename T>
+    void Fuse(Program<T>& program) const
+    {
+        using Fusion = typename Program<T>::Fusion;
+        auto const nodes = program.Nodes;
+        auto& code = program.Code;
+        auto weighted = [&](size_t j) { return nodes[j].IsVariable() && code[j].Values != nullptr; };
+
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            auto const& n = nodes[i];
+            auto& op = code[i];
+            if (n.IsLeaf() || op.Ptr == nullptr) { continue; }
+
+            if (n.Arity == 1 && weighted(i - 1)) {
+                if (auto f = ftable_.template GetFusedUnaryPointer<T>(n.Type); f != nullptr) {
+                    op.Fuse = Fusion::Unary;
+                    op.Unary = f;
+                    code[i - 1].Fused = true;
+                }
+                continue;
+            }
+
+            if (n.Type != NodeType::Add && n.Type != NodeType::Mul) { continue; }
+            bool any { false };
+            for (auto j = i - 1, k = size_t { 0 }; k < n.Arity; ++k, j -= nodes[j].Length + 1) {
+                any = any || weighted(j);
+            }
+            if (!any) { continue; }
+            op.Fuse = n.Type == NodeType::Add ? Fusion::Add : Fusion::Mul;
+            for (auto j = i - 1, k = size_t { 0 }; k < n.Arity; ++k, j -= nodes[j].Length + 1) {
+                code[j].Fused = weighted(j);
+            }
+        }
+    }
+
+    // true if the root of the program can write into the output of Evaluate (see detail::DispatchOpOutput)
+    template <typename T>
+    static auto WritesOutput(Program<T> const& program) noexcept -> bool
+    {
+        auto const& root = program.Code.back();
+        return root.Output != nullptr || root.Fuse != Program<T>::Fusion::None;
+    }
+
+    template <typename T>
+    static void Deduplicate(TreeView tree, Program<T>& program)
+    {
+        // hash a copy so that we do not change the hash mode of the caller's tree
+        Tree copy{Operon::Vector<Node>(tree.Nodes().begin(), tree.Nodes().end())};
+        auto const& nodes = copy.Hash(Operon::HashMode::Strict).Nodes();
+
+        robin_hood::unordered_flat_map<Operon::Hash, size_t> seen;
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            auto const& n = nodes[i];
+            if (n.IsLeaf() || program.Code[i].Skip) { continue; }
+            auto [it, inserted] = seen.insert({ n.CalculatedHashValue, i });
+            if (inserted || nodes[it->second].Length != n.Length) { continue; }
+            program.Code[i].Source = static_cast<int64_t>(it->second);
+            for (size_t j = i - n.Length; j < i; ++j) {
+                program.Code[j].Skip = true;
+            }
+        }
+    }
+
+    template <typename T>
+    static void InitConstants(Program<T> const& program, Operon::Vector<detail::Array<T>>& m, T const* const parameters) noexcept
+    {
+        // constants do not change between batches
+        for (size_t i = 0; i < program.Size(); ++i) {
+            auto const& op = program.Code[i];
+            if (op.Ptr == nullptr && op.Func == nullptr && op.Values == nullptr) { m[i].setConstant(parameters ? parameters[op.Coefficient] : op.Value); }
+        }
+    }
+
+    // the offset of the row from the values of the variable leaves: the row itself, or its place in the tiles of a
+    // program compiled against packed inputs
+    template <typename T>
+    static auto RowOffset(Program<T> const& program, size_t row) noexcept -> size_t
+    {
+        return program.TileRows == 0 ? row : row / program.TileRows * program.TileStride + row % program.TileRows;
+    }
+
+    // the rows of the batch starting at the row: n, or fewer if the batch would cross a tile of packed inputs
+    template <typename T>
+    static auto BatchRows(Program<T> const& program, size_t row, int n) noexcept -> int
+    {
+        return program.TileRows == 0 ? n : std::min(n, static_cast<int>(program.TileRows - row % program.TileRows));
+    }
+
+    // a leaf reading a dataset column
+    template <typename T>
+    static auto IsVariable(typename Program<T>::Instruction const& op) noexcept -> bool
+    {
+        return op.Ptr == nullptr && op.Func == nullptr && op.Values != nullptr;
+    }
+
+    // the weighted values of the variables on the rows, written into the batch columns of their leaves
+    template <typename T>
+    static void GatherVariables(Program<T> const& program, Operon::Vector<detail::Array<T>>& m, Operon::Span<uint32_t const> rows, T const* const parameters) noexcept
+    {
+        auto const n = rows.size();
+        for (size_t i = 0; i < program.Size(); ++i) {
+            auto const& op = program.Code[i];
+            if (!IsVariable<T>(op)) { continue; }
+            if (parameters == nullptr && op.Skip) { continue; } // part of a subtree copied from elsewhere
+            auto const weight = parameters ? parameters[op.Coefficient] : op.Value;
+            auto const* values = op.Values;
+            auto* out = m[i].data();
+            for (size_t j = 0; j < n; ++j) {
+                if (j + GatherPrefetchDistance < n) { OPERON_PREFETCH(values + (RowOffset(program, rows[j + GatherPrefetchDistance]) - op.FirstRow)); }
+                out[j] = weight * static_cast<T>(values[RowOffset(program, rows[j]) - op.FirstRow]);
+            }
+        }
+    }
+
+    // evaluate a single batch of rows starting at the given row
+    // with fuse, the superinstructions of the program are used (see Fuse). with out, the root writes its rows there
+    // instead of into its batch column (only if WritesOutput). with gathered, the batch columns of the variables
+    // already hold their values (see GatherVariables) and the row is ignored
+    // - on a partial batch only the first remainingRows rows of a batch column are valid: the inner primitives run over
+    //   the whole column (the fixed size expressions), so its other rows hold the values of a previous batch. this is
+    //   safe because every primitive is elementwise, a row of a result only reads the same row of its arguments, and
+    //   the readers of the result (the root writing into out, the copy in Evaluate) only read the first remainingRows
+    template <typename T>
+    static void EvaluateBlock(Program<T> const& program, Operon::Vector<detail::Array<T>>& m, size_t row, int remainingRows, T const* const parameters, bool fuse = true, T* out = nullptr, bool gathered = false) noexcept
+    {
+        using detail::GenericKernel;
+#if defined(OPERON_INSTRUMENTATION)
+        if (Instrumentation::PrimitiveProfiling()) {
+            EvaluateBlock<T, /*Profile=*/true, GenericKernel>(program, m, row, remainingRows, parameters, fuse, out, gathered);
+            return;
+        }
+#endif
+        if constexpr (!IsDual<T>::value) {
+            constexpr auto arithmetic = PrimitiveSet::Arithmetic;
+            constexpr auto typeCoherent = PrimitiveSet::TypeCoherent;
+            constexpr auto full = PrimitiveSet::Full;
+            if (program.Specialization == arithmetic) {
+                EvaluateBlock<T, /*Profile=*/false, arithmetic>(program, m, row, remainingRows, parameters, fuse, out, gathered);
+                return;
+            }
+            if (program.Specialization == typeCoherent) {
+                EvaluateBlock<T, /*Profile=*/false, typeCoherent>(program, m, row, remainingRows, parameters, fuse, out, gathered);
+                return;
+            }
+            if (program.Specialization == full) {
+                EvaluateBlock<T, /*Profile=*/false, full>(program, m, row, remainingRows, parameters, fuse, out, gathered);
+                return;
+            }
+        }
+        EvaluateBlock<T, /*Profile=*/false, GenericKernel>(program, m, row, remainingRows, parameters, fuse, out, gathered);
+    }
+
+    // evaluate a single instruction (a function node or a variable leaf, the constants are set by InitConstants)
+    // a specialized kernel dispatches the built-in primitives directly (see detail::DispatchKernel)
+    template <typename T, PrimitiveSetConfig Kernel = detail::GenericKernel>
+    static void EvaluateInstruction(typename Program<T>::Instruction const& op, Operon::Vector<detail::Array<T>>& m, Operon::Span<Node const> nodes, size_t i, size_t row, int remainingRows, T const* const parameters, T* out = nullptr) noexcept
+    {
+        if (out != nullptr) {
+            op.Output(m, nodes, i, out, remainingRows);
+        } else if (op.Ptr != nullptr) {
+            if constexpr (Kernel != detail::GenericKernel) {
+                if (detail::DispatchKernel<Kernel, T>(nodes[i].Type, m, nodes, i, row)) { return; }
+            }
+            op.Ptr(m, nodes, i, row);
+        } else if (op.Func != nullptr) {
+            (*op.Func)(m, nodes, i, row);
+        } else if (op.Values != nullptr) {
+            auto param = parameters ? parameters[op.Coefficient] : op.Value;
+            Eigen::Map<Eigen::Array<typename Program<T>::Storage, -1, 1> const> values(op.Values + (row - op.FirstRow), remainingRows);
+            m[i].segment(0, remainingRows) = param * values.template cast<T>();
+        }
+    }
+
+    // evaluate a superinstruction: the weighted variable arguments are read from the dataset columns
+    // (full batches use fixed size expressions, like the primitives)
+    template <typename T>
+    static void EvaluateFused(Program<T> const& program, Operon::Vector<detail::Array<T>>& m, size_t i, size_t row, int remainingRows, T const* const parameters, T* out) noexcept
+    {
+        if (remainingRows == detail::BatchSize<T>::Value) {
+            EvaluateFused<T, detail::BatchSize<T>::Value>(program, m, i, row, remainingRows, parameters, out);
+        } else {
+            EvaluateFused<T, Eigen::Dynamic>(program, m, i, row, remainingRows, parameters, out);
+        }
+    }
+
+    template <typename T, int Rows>
+    static void EvaluateFused(Program<T> const& program, Operon::Vector<detail::Array<T>>& m, size_t i, size_t row, int remainingRows, T const* const parameters, T* out) noexcept
+    {
+        using Fusion = typename Program<T>::Fusion;
+        using Map = Eigen::Map<Eigen::Array<T, Rows, 1> const>;
+        auto const nodes = program.Nodes;
+        auto const& code = program.Code;
+        auto const& op = code[i];
+
+        // the values and the weight of an argument (the weight of a function node is one)
+        auto argument = [&](size_t j) -> std::pair<T const*, T> {
+            auto const& arg = code[j];
+            if (!arg.Fused) { return { m[j].data(), T { 1 } }; }
+            return { arg.Values + (row - arg.FirstRow), parameters ? parameters[arg.Coefficient] : arg.Value };
+        };
+
+        if (op.Fuse == Fusion::Unary) {
+            auto [values, weight] = argument(i - 1);
+            op.Unary(out, values, weight, remainingRows);
+            return;
+        }
+
+        // the arguments are combined in groups of four, like the n-ary primitives (see detail::DispatchOpNary)
+        Eigen::Map<Eigen::Array<T, Rows, 1>> r(out, remainingRows);
+        auto j = i - 1;
+        auto const add = op.Fuse == Fusion::Add;
+        for (size_t k = 0, arity = nodes[i].Arity; k < arity; k += 4) { // NOLINT
+            std::array<std::pair<T const*, T>, 4> args; // NOLINT
+            auto const count = std::min(arity - k, size_t { 4 }); // NOLINT
+            for (size_t a = 0; a < count; ++a, j -= nodes[j].Length + 1) { args[a] = argument(j); }
+            auto x = [&](size_t a) { return args[a].second * Map(args[a].first, remainingRows); };
+            auto combine = [&](auto const& e) {
+                if (k == 0) { r = e; } else if (add) { r += e; } else { r *= e; }
+            };
+
+            switch (count) {
+            case 1: { combine(x(0)); break; }
+            case 2: { if (add) { combine(x(0) + x(1)); } else { combine(x(0) * x(1)); } break; }
+            case 3: { if (add) { combine(x(0) + (x(1) + x(2))); } else { combine(x(0) * (x(1) * x(2))); } break; }
+            default: { if (add) { combine(x(0) + (x(1) + (x(2) + x(3)))); } else { combine(x(0) * (x(1) * (x(2) * x(3)))); } break; }
+            }
+        }
+    }
+
+    // when profiling, the time of every instruction is recorded (see Instrumentation::RecordPrimitive)
+    template <typename T, bool Profile, PrimitiveSetConfig Kernel>
+    static void EvaluateBlock(Program<T> const& program, Operon::Vector<detail::Array<T>>& m, size_t row, int remainingRows, T const* const parameters, bool fuse, T* out, bool gathered) noexcept
+    {
+        auto const nodes = program.Nodes;
+        auto const& code = program.Code;
+        for (size_t i = 0; i < code.size(); ++i) {
+            auto const& op = code[i];
+            if (fuse && op.Fused) { continue; } // computed by the parent
+            if (gathered && IsVariable<T>(op)) { continue; }
+            if (parameters == nullptr) {
+                if (op.Skip) { continue; }
+                if (op.Source >= 0) {
+                    m[i].segment(0, remainingRows) = m[op.Source].segment(0, remainingRows);
+                    continue;
+                }
+            }
+            [[maybe_unused]] uint64_t start{0};
+            if constexpr (Profile) {
+                if (op.Ptr == nullptr && op.Func == nullptr && op.Values == nullptr) { continue; } // constant
+                start = Instrumentation::WallTime();
+            }
+            auto* const target = i + 1 == code.size() ? out : nullptr;
+            if (fuse && op.Fuse != Program<T>::Fusion::None) {
+                if constexpr (std::is_same_v<T, typename Program<T>::Storage>) {
+                    EvaluateFused(program, m, i, row, remainingRows, parameters, target != nullptr ? target : m[i].data());
+                }
+            } else {
+                EvaluateInstruction<T, Kernel>(op, m, nodes, i, row, remainingRows, parameters, target);
+            }
+            if constexpr (Profile) {
+                constexpr auto kind = IsDual<T>::value ? Instrumentation::ValueKind::Dual : Instrumentation::ValueKind::Scalar;
+                Instrumentation::RecordPrimitive(kind, nodes[i], Instrumentation::WallTime() - start, static_cast<uint64_t>(remainingRows));
+            }
+        }
+    }
+
     DTable ftable_;
+    PrimitiveSetConfig kernel_ { detail::GenericKernel };
 };
 
-using Interpreter = GenericInterpreter<Operon::Scalar, Operon::Dual>;
+// the forward mode jacobians pick the jet width per tree (see Operon::JetWidth)
+using Interpreter = GenericInterpreter<Operon::Scalar, DualN<4>, DualN<8>, DualN<16>>; // NOLINT
+
+// row-parallel evaluation for very large ranges: the range is split into chunks of batchSize rows which are
+// evaluated concurrently by the executor's workers, each writing into its own disjoint part of the result
+static constexpr size_t DefaultParallelBatchSize = 1UL << 16U;
+
+OPERON_EXPORT auto EvaluateParallel(tf::Executor& executor, Interpreter const& interpreter, Tree const& tree, Dataset const& dataset, Range range, Operon::Span<Operon::Scalar> result, size_t batchSize = DefaultParallelBatchSize) -> void;
+OPERON_EXPORT auto EvaluateParallel(tf::Executor& executor, Interpreter const& interpreter, Tree const& tree, Dataset const& dataset, Range range, size_t batchSize = DefaultParallelBatchSize) -> Operon::Vector<Operon::Scalar>;
 } // namespace Operon
 
 
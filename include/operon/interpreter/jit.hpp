@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_INTERPRETER_JIT_HPP
+#define OPERON_INTERPRETER_JIT_HPP
+
+#include <cstddef>
+#include <string>
+
+#include "operon/core/node.hpp"
+#include "operon/core/types.hpp"
+#include "operon/operon_export.hpp"
+
+// native code for the evaluation of long trees on many rows
+// - the kernel of a tree structure is the c code of CodeFormatter::FormatKernel, compiled into a shared object by the
+//   system c compiler and loaded with dlopen. the coefficients and the columns are arguments of the kernel, so the same
+//   kernel serves every tree with the same structure (e.g. every iteration of the coefficient optimization)
+// - only built with USE_JIT (OPERON_JIT), otherwise Enabled is always false and Get always returns nullptr
+// - Interpreter::Accelerate compiles a program ahead of its evaluations once the expected work (rows times length
+//   times evaluations, e.g. the residual evaluations of the coefficient optimization) is over the threshold, since the
+//   compilation takes tens of milliseconds. the evaluations themselves never compile. the jacobians, and the values of
+//   the programs which were not accelerated, come from the interpreter
+// - the compiler is taken from the OPERON_JIT_CC environment variable (default: cc). if it fails the tree is marked
+//   as not compilable and the interpreter is used instead
+// - the loaded kernels cannot be unloaded (the programs keep pointers to them), so the cache holds at most Capacity
+//   structures, the structures requested afterwards are evaluated by the interpreter
+namespace Operon::Jit {
+    // out[i] = f(p, columns[0][i], columns[1][i], ...) for i in [0, rows)
+    using Kernel = void (*)(Operon::Scalar const* const* columns, Operon::Scalar const* parameters, size_t rows, Operon::Scalar* result);
+
+    [[nodiscard]] auto OPERON_EXPORT Available() -> bool; // built with OPERON_JIT
+    [[nodiscard]] auto OPERON_EXPORT Enabled() -> bool;
+    auto OPERON_EXPORT SetEnabled(bool enabled) -> void;
+
+    // in node rows (see above)
+    static constexpr size_t DefaultThreshold = 100'000'000;
+    [[nodiscard]] auto OPERON_EXPORT Threshold() -> size_t;
+    auto OPERON_EXPORT SetThreshold(size_t threshold) -> void;
+
+    // in tree structures (see above)
+    static constexpr size_t DefaultCapacity = 4096;
+    [[nodiscard]] auto OPERON_EXPORT Capacity() -> size_t;
+    auto OPERON_EXPORT SetCapacity(size_t capacity) -> void;
+
+    // whether the work justifies a compilation
+    [[nodiscard]] auto OPERON_EXPORT Worthwhile(size_t work) -> bool;
+
+    // the kernel of the tree structure, compiled on the first request (blocking the calling thread, one compilation at
+    // a time so that the concurrent requests for the same structure wait for its kernel). returns nullptr if the tree
+    // cannot be compiled (e.g. dynamic nodes, no compiler, a full cache), never throws
+    [[nodiscard]] auto OPERON_EXPORT Get(Operon::Span<Node const> nodes) noexcept -> Kernel;
+
+    struct Statistics {
+        size_t Kernels{0};      // in the cache
+        size_t Compilations{0}; // including the failed ones
+        size_t Failures{0};
+        double Seconds{0};      // spent compiling
+    };
+
+    [[nodiscard]] auto OPERON_EXPORT GetStatistics() -> Statistics;
+} // namespace Operon::Jit
+
+#endif
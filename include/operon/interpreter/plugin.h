@@ -0,0 +1,56 @@
+/* SPDX-License-Identifier: MIT */
+/* SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research */
+
+#ifndef OPERON_INTERPRETER_PLUGIN_H
+#define OPERON_INTERPRETER_PLUGIN_H
+
+/* the c abi of the primitive plugins: shared libraries which provide batch kernels for user-defined primitives
+ * (NodeType::Dynamic), called by the interpreter on the batch columns. a plugin only needs this header.
+ * - the kernels read and write contiguous columns of double precision values, aligned to 16 bytes, of rows values
+ *   each; the first argument of a primitive is its last child in the postfix order (as for the built-in primitives)
+ * - the dual kernel computes the forward mode derivatives used by the coefficient optimization. the derivatives are
+ *   planar: the partials of an argument are width columns of rows values (dargs[k][j * rows + r] is the derivative of
+ *   the row r of the argument k with respect to the lane j), and so are the partials of the output (dout). without a
+ *   dual kernel the derivatives of the primitive are approximated by central differences of the scalar kernel
+ * - the kernels are called concurrently by the evaluating threads and must not keep state between the calls
+ * - the plugin exports the entry point operon_plugin_descriptor (OPERON_PLUGIN_ENTRY), which returns a descriptor
+ *   valid for the lifetime of the library */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OPERON_PLUGIN_ABI_VERSION 1U
+#define OPERON_PLUGIN_ENTRY "operon_plugin_descriptor"
+
+/* out[r] = f(args[0][r], ..., args[arity - 1][r]) for r in [0, rows) */
+typedef void (*operon_scalar_kernel)(double* out, double const* const* args, int arity, int rows);
+
+/* the values as the scalar kernel, and the partials of the output, out' = sum of df/dargs[k] * args[k]' */
+typedef void (*operon_dual_kernel)(double* out, double* dout, double const* const* args, double const* const* dargs, int arity, int rows, int width);
+
+typedef struct operon_primitive {
+    char const* name;            /* unique, the hash of the dynamic node is derived from it */
+    uint32_t min_arity;          /* zero for a leaf (e.g. a named constant) */
+    uint32_t max_arity;          /* at most 32 */
+    operon_scalar_kernel scalar; /* required */
+    operon_dual_kernel dual;     /* optional */
+} operon_primitive;
+
+typedef struct operon_plugin {
+    uint32_t abi_version; /* OPERON_PLUGIN_ABI_VERSION */
+    uint32_t count;
+    operon_primitive const* primitives;
+} operon_plugin;
+
+/* operon_plugin const* operon_plugin_descriptor(void) */
+typedef operon_plugin const* (*operon_plugin_entry)(void);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif
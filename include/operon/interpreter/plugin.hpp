@@ -0,0 +1,196 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_INTERPRETER_PLUGIN_HPP
+#define OPERON_INTERPRETER_PLUGIN_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "operon/core/dual.hpp"
+#include "operon/core/node.hpp"
+#include "operon/core/pset.hpp"
+#include "operon/core/types.hpp"
+#include "operon/operon_export.hpp"
+#include "dispatch_table.hpp"
+#include "plugin.h"
+
+// user-defined primitives (NodeType::Dynamic) evaluated by the batch kernels of a plugin (see plugin.h)
+// - the kernels are called once per batch and node with the batch columns of the children, instead of a type-erased
+//   callable per node working on the interpreter buffers, so they can be vectorized like the built-in primitives
+// - a primitive is registered in the dispatch table of an interpreter (Register) and added to the primitive set
+//   (Add) under the hash of its name, so the models using it can be read back with the same plugin loaded
+// - the kernels compute in double precision: the single precision and the dual values are converted through a
+//   per-thread scratch buffer
+namespace Operon::Plugin {
+    static constexpr size_t MaxArity = 32;
+
+    struct Primitive {
+        std::string Name;
+        Operon::Hash Hash{0};
+        size_t MinArity{0};
+        size_t MaxArity{0};
+        operon_scalar_kernel Scalar{nullptr};
+        operon_dual_kernel Dual{nullptr}; // nullptr: central differences of the scalar kernel
+
+        [[nodiscard]] auto MakeNode() const -> Node { return Node(NodeType::Dynamic, Hash); }
+    };
+
+    // the hash of the dynamic nodes of a primitive
+    [[nodiscard]] auto OPERON_EXPORT HashName(std::string const& name) -> Operon::Hash;
+
+    // the primitives of a descriptor, throws std::runtime_error if its abi version differs from the one of this build
+    // or if a primitive is malformed (no name or scalar kernel, arity limits out of order or over MaxArity)
+    [[nodiscard]] auto OPERON_EXPORT Read(operon_plugin const& plugin) -> std::vector<Primitive>;
+
+    // opens a plugin (the library stays loaded for the lifetime of the process) and reads its descriptor, throws
+    // std::runtime_error if the library or its entry point cannot be found (or on other platforms than posix)
+    [[nodiscard]] auto OPERON_EXPORT Load(std::string const& path) -> std::vector<Primitive>;
+
+    // the callable of a primitive for every value type of the dispatch table (see DispatchTable::RegisterCallable)
+    class Callable {
+        operon_scalar_kernel scalar_;
+        operon_dual_kernel dual_;
+
+        // the columns of the arguments, the first one being the last child (see detail::DispatchOpBinary)
+        static auto Children(Operon::Span<Node const> nodes, size_t i) -> std::array<size_t, MaxArity>
+        {
+            std::array<size_t, MaxArity> children{};
+            auto const arity = std::min(size_t{nodes[i].Arity}, MaxArity);
+            auto j = i - 1;
+            for (size_t k = 0; k < arity; ++k) {
+                children[k] = j;
+                j -= nodes[j].Length + 1;
+            }
+            return children;
+        }
+
+        // computes the values and the partials of the output from the planar values and partials of the arguments
+        void Differentiate(double* out, double* dout, double* values, double const* partials, int arity, int rows, int width) const
+        {
+            std::array<double const*, MaxArity + 1> args{};
+            std::array<double const*, MaxArity + 1> dargs{};
+            for (int k = 0; k < arity; ++k) {
+                args[k] = values + static_cast<ptrdiff_t>(k) * rows;
+                dargs[k] = partials + static_cast<ptrdiff_t>(k) * width * rows;
+            }
+            if (dual_ != nullptr) {
+                dual_(out, dout, args.data(), dargs.data(), arity, rows, width);
+                return;
+            }
+
+            scalar_(out, args.data(), arity, rows);
+            std::fill_n(dout, static_cast<ptrdiff_t>(width) * rows, 0.0);
+            if (arity == 0) { return; }
+
+            // df/dx = (f(x + h) - f(x - h)) / 2h with the step of best accuracy for a second order difference
+            thread_local std::vector<double> step;
+            thread_local std::vector<double> plus;
+            thread_local std::vector<double> minus;
+            step.resize(rows);
+            plus.resize(rows);
+            minus.resize(rows);
+            auto const eps = std::cbrt(std::numeric_limits<double>::epsilon());
+            for (int k = 0; k < arity; ++k) {
+                auto* x = values + static_cast<ptrdiff_t>(k) * rows;
+                for (int r = 0; r < rows; ++r) {
+                    step[r] = eps * std::max(1.0, std::abs(x[r]));
+                    x[r] += step[r];
+                }
+                scalar_(plus.data(), args.data(), arity, rows);
+                for (int r = 0; r < rows; ++r) { x[r] -= 2 * step[r]; }
+                scalar_(minus.data(), args.data(), arity, rows);
+                for (int r = 0; r < rows; ++r) { x[r] += step[r]; }
+
+                for (int j = 0; j < width; ++j) {
+                    auto const* dx = dargs[k] + static_cast<ptrdiff_t>(j) * rows;
+                    auto* dy = dout + static_cast<ptrdiff_t>(j) * rows;
+                    for (int r = 0; r < rows; ++r) { dy[r] += (plus[r] - minus[r]) / (2 * step[r]) * dx[r]; }
+                }
+            }
+        }
+
+    public:
+        explicit Callable(Primitive const& primitive)
+            : scalar_(primitive.Scalar)
+            , dual_(primitive.Dual)
+        {
+        }
+
+        template<typename M>
+        void operator()(M& m, Operon::Span<Node const> nodes, size_t i, size_t /*row*/) const
+        {
+            using T = typename M::value_type::Scalar;
+            constexpr auto rows = static_cast<int>(detail::BatchSize<T>::Value);
+            auto const arity = static_cast<int>(std::min(size_t{nodes[i].Arity}, MaxArity));
+            auto const children = Children(nodes, i);
+
+            if constexpr (std::is_same_v<T, double>) {
+                std::array<double const*, MaxArity + 1> args{};
+                for (int k = 0; k < arity; ++k) { args[k] = m[children[k]].data(); }
+                scalar_(m[i].data(), args.data(), arity, rows);
+            } else {
+                // the values of the arguments and of the output, followed by their partials
+                constexpr auto width = [] {
+                    if constexpr (IsDual<T>::value) { return static_cast<int>(T::DIMENSION); } else { return 0; }
+                }();
+                thread_local std::vector<double> values;
+                thread_local std::vector<double> partials;
+                values.resize(static_cast<size_t>(arity + 1) * rows);
+                partials.resize(static_cast<size_t>(arity + 1) * width * rows);
+
+                for (int k = 0; k < arity; ++k) {
+                    auto const& column = m[children[k]];
+                    auto* v = values.data() + static_cast<ptrdiff_t>(k) * rows;
+                    for (int r = 0; r < rows; ++r) {
+                        if constexpr (IsDual<T>::value) {
+                            v[r] = static_cast<double>(column[r].a);
+                            for (int j = 0; j < width; ++j) { partials[(static_cast<size_t>(k) * width + j) * rows + r] = static_cast<double>(column[r].v[j]); }
+                        } else {
+                            v[r] = static_cast<double>(column[r]);
+                        }
+                    }
+                }
+
+                auto* out = values.data() + static_cast<ptrdiff_t>(arity) * rows;
+                auto* dout = partials.data() + static_cast<ptrdiff_t>(arity) * width * rows;
+                if constexpr (IsDual<T>::value) {
+                    Differentiate(out, dout, values.data(), partials.data(), arity, rows, width);
+                } else {
+                    std::array<double const*, MaxArity + 1> args{};
+                    for (int k = 0; k < arity; ++k) { args[k] = values.data() + static_cast<ptrdiff_t>(k) * rows; }
+                    scalar_(out, args.data(), arity, rows);
+                }
+
+                auto& result = m[i];
+                for (int r = 0; r < rows; ++r) {
+                    if constexpr (IsDual<T>::value) {
+                        result[r].a = static_cast<typename T::Scalar>(out[r]);
+                        for (int j = 0; j < width; ++j) { result[r].v[j] = static_cast<typename T::Scalar>(dout[static_cast<ptrdiff_t>(j) * rows + r]); }
+                    } else {
+                        result[r] = static_cast<T>(out[r]);
+                    }
+                }
+            }
+        }
+    };
+
+    template<typename... Ts>
+    void Register(DispatchTable<Ts...>& table, Primitive const& primitive)
+    {
+        table.RegisterCallable(primitive.Hash, Callable(primitive));
+    }
+
+    inline auto Add(PrimitiveSet& pset, Primitive const& primitive, size_t frequency = 1) -> bool
+    {
+        return pset.AddPrimitive(primitive.MakeNode(), frequency, primitive.MinArity, primitive.MaxArity);
+    }
+} // namespace Operon::Plugin
+
+#endif
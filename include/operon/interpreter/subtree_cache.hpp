@@ -0,0 +1,135 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_INTERPRETER_SUBTREE_CACHE_HPP
+#define OPERON_INTERPRETER_SUBTREE_CACHE_HPP
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <robin_hood.h>
+
+#include "operon/core/contracts.hpp"
+#include "operon/core/memory.hpp"
+#include "operon/core/range.hpp"
+#include "operon/core/types.hpp"
+
+namespace Operon {
+
+// stores the output columns of evaluated subtrees (over a fixed range), keyed by their strict hash value
+// - the cache is bounded by a memory budget (in bytes), the oldest entries are evicted first
+// - its size is accounted to Memory::Subsystem::Cache: over the soft memory limit it stops inserting and evicts
+//   when asked by Memory::Enforce
+// - entries are reference counted so that evicting an entry does not invalidate ongoing evaluations
+// - all methods are thread-safe
+template<typename T>
+class SubtreeCache {
+public:
+    using Column = std::shared_ptr<Operon::Vector<T> const>;
+
+    static constexpr size_t DefaultBudget = 1UL << 30U; // 1 GiB
+
+    explicit SubtreeCache(Range range, size_t budget = DefaultBudget)
+        : range_(range)
+        , budget_(budget)
+        , reclaimer_(Memory::Register([this](size_t bytes) { return Evict(bytes); }))
+    {
+    }
+
+    SubtreeCache(SubtreeCache const&) = delete;
+    SubtreeCache(SubtreeCache&&) = delete;
+    auto operator=(SubtreeCache const&) -> SubtreeCache& = delete;
+    auto operator=(SubtreeCache&&) -> SubtreeCache& = delete;
+
+    ~SubtreeCache()
+    {
+        Memory::Unregister(reclaimer_);
+    }
+
+    [[nodiscard]] auto Find(Operon::Hash hash) const -> Column
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (auto it = map_.find(hash); it != map_.end()) {
+            ++hits_;
+            return it->second;
+        }
+        ++misses_;
+        return nullptr;
+    }
+
+    void Insert(Operon::Hash hash, Operon::Vector<T>&& values)
+    {
+        EXPECT(values.size() == range_.Size());
+        auto const bytes = ColumnBytes();
+        if (bytes > budget_ || Memory::OverLimit()) { return; }
+
+        auto column = std::make_shared<Operon::Vector<T> const>(std::move(values));
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!map_.insert({ hash, std::move(column) }).second) { return; }
+        order_.push_back(hash);
+        size_ += bytes;
+        while (size_ > budget_) {
+            map_.erase(order_.front());
+            order_.pop_front();
+            size_ -= bytes;
+        }
+        memory_.Update(size_);
+    }
+
+    void Clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        map_.clear();
+        order_.clear();
+        size_ = 0;
+        memory_.Update(size_);
+    }
+
+    // evicts the oldest entries until at least the given number of bytes was released (or the cache is empty),
+    // returns the number of bytes released
+    auto Evict(size_t bytes) -> size_t
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto const before = size_;
+        while (!order_.empty() && before - size_ < bytes) {
+            map_.erase(order_.front());
+            order_.pop_front();
+            size_ -= ColumnBytes();
+        }
+        memory_.Update(size_);
+        return before - size_;
+    }
+
+    [[nodiscard]] auto GetRange() const -> Range { return range_; }
+    [[nodiscard]] auto Budget() const -> size_t { return budget_; }
+    [[nodiscard]] auto ColumnBytes() const -> size_t { return range_.Size() * sizeof(T); }
+
+    [[nodiscard]] auto Size() const -> size_t
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return map_.size();
+    }
+
+    [[nodiscard]] auto Hits() const -> size_t { return hits_; }
+    [[nodiscard]] auto Misses() const -> size_t { return misses_; }
+
+private:
+    Range range_;
+    size_t budget_;
+    size_t size_{0};
+    Memory::Account memory_{Memory::Subsystem::Cache};
+
+    robin_hood::unordered_flat_map<Operon::Hash, Column> map_;
+    std::deque<Operon::Hash> order_;
+
+    mutable std::mutex mutex_;
+    mutable std::atomic_ulong hits_{0};
+    mutable std::atomic_ulong misses_{0};
+
+    size_t reclaimer_; // registered last, once the members used by Evict exist
+};
+
+} // namespace Operon
+
+#endif
@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_NNLS_BATCH_OPTIMIZER_HPP
+#define OPERON_NNLS_BATCH_OPTIMIZER_HPP
+
+#include <vector>
+
+#include "operon/core/dataset.hpp"
+#include "operon/core/range.hpp"
+#include "operon/core/tree.hpp"
+#include "operon/core/types.hpp"
+#include "operon/interpreter/interpreter.hpp"
+#include "operon/operon_export.hpp"
+#include "nnls.hpp"
+
+namespace tf {
+class Executor;
+class Subflow;
+} // namespace tf
+
+namespace Operon {
+
+struct BatchOptimizerOptions {
+    static constexpr Operon::Scalar DefaultDamping = 1e-3;
+    static constexpr Operon::Scalar DefaultTolerance = 1e-8;
+    static constexpr size_t SolveWidth = 8; // the damped systems solved together
+
+    size_t Iterations{10};
+    Operon::Scalar InitialDamping{DefaultDamping};
+    Operon::Scalar StepTolerance{DefaultTolerance};
+    bool WriteCoefficients{true};
+};
+
+// Levenberg-Marquardt advancing the coefficients of many trees in lock-step
+// - every iteration runs in three parallel stages over the trees that have not converged: (1) assemble the
+//   normal equations J^T J and J^T r, (2) solve the damped systems, (3) evaluate the steps and accept or reject them
+// - the normal equations of all the trees are stored in one contiguous buffer, they are accumulated one block of
+//   rows at a time (see ResidualEvaluator::NormalEquations), so no jacobian of the whole range is formed
+// - the systems of the trees with the same number of coefficients are factorized together, SolveWidth at a time and
+//   interleaved so that the cholesky factorization and the substitutions vectorize over the trees (a system which is
+//   not positive definite is solved on its own with an LDLT)
+OPERON_EXPORT auto OptimizeBatch(tf::Executor& executor, Interpreter const& interpreter, Operon::Span<Tree> trees, Dataset const& dataset, Operon::Span<Operon::Scalar const> target, Range range, BatchOptimizerOptions const& options = {}) -> std::vector<OptimizerSummary>;
+
+// the same, as tasks of the subflow (which is joined before returning)
+OPERON_EXPORT auto OptimizeBatch(tf::Subflow& subflow, Interpreter const& interpreter, Operon::Span<Tree> trees, Dataset const& dataset, Operon::Span<Operon::Scalar const> target, Range range, BatchOptimizerOptions const& options = {}) -> std::vector<OptimizerSummary>;
+
+} // namespace Operon
+
+#endif
@@ -4,12 +4,17 @@
 #ifndef OPERON_NNLS_HPP
 #define OPERON_NNLS_HPP
 
+#include <cmath>
+#include <Eigen/Cholesky>
 #include <unsupported/Eigen/LevenbergMarquardt>
 
 #include "operon/core/dual.hpp"
 #include "residual_evaluator.hpp"
 #include "tiny_cost_function.hpp"
+#include "variable_projection.hpp"
+#include "workspace.hpp"
 #include "operon/ceres/tiny_solver.h"
+#include "operon/random/random.hpp"
 
 #if defined(HAVE_CERES)
 #include "dynamic_cost_function.hpp"
@@ -18,7 +23,7 @@
 namespace Operon {
 
 enum class OptimizerType : int { TINY, EIGEN,
-    CERES };
+    CERES, VARPRO, NORMAL, MINIBATCH };
 enum class DerivativeMethod : int { NUMERIC,
     AUTODIFF };
 
@@ -61,14 +66,19 @@ struct NonlinearLeastSquaresOptimizer : public OptimizerBase {
     {
         static_assert(D == DerivativeMethod::AUTODIFF, "The tiny optimizer only supports autodiff.");
         ResidualEvaluator re(GetInterpreter(), GetTree(), GetDataset(), target, range);
+        re.Accelerate(iterations + 1);
         Operon::TinyCostFunction<ResidualEvaluator, Operon::Dual, Operon::Scalar, Eigen::ColMajor> cf(re);
-        ceres::TinySolver<decltype(cf)> solver;
+        // the solver keeps its storage between the solves of the thread, it only reallocates when the problem size changes
+        thread_local ceres::TinySolver<decltype(cf)> solver;
+        solver.options = {};
+        solver.summary = {};
         solver.options.max_num_iterations = static_cast<int>(iterations);
 
         auto& tree = GetTree();
-        auto x0 = tree.GetCoefficients();
+        auto const& x0 = OptimizerWorkspace::Local().Coefficients(tree);
         if (!x0.empty()) {
-            decltype(solver)::Parameters params = Eigen::Map<Eigen::Matrix<Operon::Scalar, Eigen::Dynamic, 1>>(x0.data(), x0.size()).cast<typename decltype(cf)::Scalar>();
+            thread_local typename decltype(solver)::Parameters params;
+            params = Eigen::Map<Eigen::Matrix<Operon::Scalar, Eigen::Dynamic, 1> const>(x0.data(), static_cast<Eigen::Index>(x0.size())).cast<typename decltype(cf)::Scalar>();
             solver.Solve(cf, &params);
             if (writeCoefficients) {
                 tree.SetCoefficients({ params.data(), x0.size() });
@@ -96,17 +106,18 @@ struct NonlinearLeastSquaresOptimizer<OptimizerType::EIGEN> : public OptimizerBa
     {
         static_assert(D == DerivativeMethod::AUTODIFF, "Eigen::LevenbergMarquardt only supports autodiff.");
         ResidualEvaluator re(GetInterpreter(), GetTree(), GetDataset(), target, range);
+        re.Accelerate(iterations + 1);
         Operon::TinyCostFunction<ResidualEvaluator, Operon::Dual, Operon::Scalar, Eigen::ColMajor> cf(re);
         Eigen::LevenbergMarquardt<decltype(cf)> lm(cf);
         lm.setMaxfev(static_cast<int>(iterations+1));
 
         auto& tree = GetTree();
-        auto coeff = tree.GetCoefficients();
+        auto const& coeff = OptimizerWorkspace::Local().Coefficients(tree);
 
         Eigen::ComputationInfo info{};
         if (!coeff.empty()) {
-            Eigen::Matrix<Operon::Scalar, -1, 1> x0;
-            x0 = Eigen::Map<decltype(x0)>(coeff.data(), static_cast<int>(coeff.size()));
+            thread_local Eigen::Matrix<Operon::Scalar, -1, 1> x0;
+            x0 = Eigen::Map<Eigen::Matrix<Operon::Scalar, -1, 1> const>(coeff.data(), static_cast<int>(coeff.size()));
             lm.minimize(x0);
             info = lm.info();
             if (writeCoefficients) {
@@ -124,6 +135,246 @@ struct NonlinearLeastSquaresOptimizer<OptimizerType::EIGEN> : public OptimizerBa
     }
 };
 
+// variable projection: the coefficients which enter the model linearly (see FindLinearCoefficients) are eliminated
+// by solving a linear least squares problem, so that Levenberg-Marquardt only runs over the remaining coefficients
+template <>
+struct NonlinearLeastSquaresOptimizer<OptimizerType::VARPRO> : public OptimizerBase {
+    NonlinearLeastSquaresOptimizer(Interpreter const& interpreter, Tree& tree, Dataset const& dataset)
+        : OptimizerBase(interpreter, tree, dataset)
+    {
+    }
+
+    template <DerivativeMethod D = DerivativeMethod::AUTODIFF>
+    auto Optimize(Operon::Span<const Operon::Scalar> const target, Range range, size_t iterations, bool writeCoefficients = true, bool /*unused*/ = false) -> OptimizerSummary
+    {
+        static_assert(D == DerivativeMethod::AUTODIFF, "Variable projection only supports autodiff.");
+        auto& tree = GetTree();
+        auto linear = FindLinearCoefficients(tree);
+        if (linear.empty()) {
+            NonlinearLeastSquaresOptimizer<OptimizerType::EIGEN> optimizer(GetInterpreter(), tree, GetDataset());
+            return optimizer.Optimize<D>(target, range, iterations, writeCoefficients);
+        }
+
+        ResidualEvaluator re(GetInterpreter(), tree, GetDataset(), target, range);
+        re.Accelerate(iterations + 1);
+        ProjectedResidualEvaluator pre(re, tree, GetDataset(), range, linear);
+
+        auto const& coeff = OptimizerWorkspace::Local().Coefficients(tree);
+        auto const& indices = pre.NonlinearIndices();
+        Eigen::Matrix<Operon::Scalar, -1, 1> x0(indices.size());
+        for (size_t i = 0; i < indices.size(); ++i) {
+            x0(static_cast<Eigen::Index>(i)) = coeff[indices[i]];
+        }
+
+        OptimizerSummary sum {};
+        sum.InitialCost = -1;
+        sum.FinalCost = -1;
+        sum.Success = true;
+        if (x0.size() > 0) {
+            Operon::TinyCostFunction<ProjectedResidualEvaluator, Operon::Dual, Operon::Scalar, Eigen::ColMajor> cf(pre);
+            Eigen::LevenbergMarquardt<decltype(cf)> lm(cf);
+            lm.setMaxfev(static_cast<int>(iterations+1));
+            lm.minimize(x0);
+            sum.Iterations = static_cast<int>(lm.iterations());
+            sum.FunctionEvaluations = static_cast<int>(lm.nfev());
+            sum.JacobianEvaluations = static_cast<int>(lm.njev());
+            sum.Success = lm.info() == Eigen::ComputationInfo::Success;
+        }
+        // one more evaluation to recover the linear coefficients
+        auto lin = pre.SolveLinear(x0.data());
+        sum.FunctionEvaluations += 1;
+        if (writeCoefficients) {
+            tree.SetCoefficients(pre.Merge(x0.data(), lin));
+        }
+        return sum;
+    }
+};
+
+// levenberg-marquardt on the normal equations, which are accumulated block by block of rows while the interpreter
+// evaluates the jacobian (see ResidualEvaluator::NormalEquations): the memory is O(k^2) plus one block of the jacobian
+// instead of O(rows * k), for tall and skinny problems (many rows, few coefficients). the damped k x k systems are
+// positive definite and solved by an in place cholesky decomposition, at the cost of squaring the condition number
+// compared to the QR based solvers. all the vectors and matrices live in the workspace of the thread (see
+// OptimizerWorkspace)
+template <>
+struct NonlinearLeastSquaresOptimizer<OptimizerType::NORMAL> : public OptimizerBase {
+    static constexpr Operon::Scalar InitialDamping { 1e-3 };
+    static constexpr Operon::Scalar StepTolerance { 1e-8 };
+
+    NonlinearLeastSquaresOptimizer(Interpreter const& interpreter, Tree& tree, Dataset const& dataset)
+        : OptimizerBase(interpreter, tree, dataset)
+    {
+    }
+
+    template <DerivativeMethod D = DerivativeMethod::AUTODIFF>
+    auto Optimize(Operon::Span<const Operon::Scalar> const target, Range range, size_t iterations, bool writeCoefficients = true, bool /*unused*/ = false) -> OptimizerSummary
+    {
+        static_assert(D == DerivativeMethod::AUTODIFF, "The normal equations solver only supports autodiff.");
+        using Vector = OptimizerWorkspace::VectorType;
+        using Matrix = OptimizerWorkspace::MatrixType;
+
+        auto& tree = GetTree();
+        auto& workspace = OptimizerWorkspace::Local();
+        auto const& coeff = workspace.Coefficients(tree);
+        OptimizerSummary sum {};
+        if (coeff.empty()) { return sum; }
+
+        ResidualEvaluator re(GetInterpreter(), tree, GetDataset(), target, range);
+        re.Accelerate(iterations + 1);
+
+        auto const k = static_cast<Eigen::Index>(coeff.size());
+        auto x = workspace.Vector(0, k);
+        x = Eigen::Map<Vector const>(coeff.data(), k);
+        auto a = workspace.Matrix(1, k, k);
+        auto g = workspace.Vector(2, k);
+        auto damped = workspace.Matrix(3, k, k);
+        auto step = workspace.Vector(4, k);
+        auto trial = workspace.Vector(5, k);
+        auto product = workspace.Vector(6, k);
+        auto damping { InitialDamping };
+        Operon::Scalar nu { 2 };
+
+        auto cost = re.NormalEquations(x.data(), a.data(), g.data());
+        sum.InitialCost = cost;
+        sum.FunctionEvaluations = 1;
+        sum.JacobianEvaluations = 1;
+
+        for (size_t i = 0; i < iterations; ++i) {
+            // damped normal equations (marquardt scaling of the diagonal)
+            damped = a;
+            damped.diagonal() += damping * a.diagonal().cwiseMax(Operon::Scalar { 1e-6 }); // NOLINT
+            Eigen::LLT<Eigen::Ref<Matrix>> llt(damped);
+            step = -g;
+            llt.solveInPlace(step);
+            ++sum.Iterations;
+            if (llt.info() != Eigen::Success || !step.allFinite() || step.norm() <= StepTolerance * (x.norm() + StepTolerance)) { break; }
+
+            trial = x + step;
+            auto trialCost = re.Cost(trial.data());
+            ++sum.FunctionEvaluations;
+
+            // gain ratio between the actual and the predicted reduction
+            product.noalias() = a * step;
+            auto predicted = -static_cast<double>(step.dot(g)) - 0.5 * static_cast<double>(step.dot(product)); // NOLINT
+            auto rho = predicted > 0 ? (cost - trialCost) / predicted : -1.0;
+            if (std::isfinite(trialCost) && rho > 0) {
+                x = trial;
+                damping *= static_cast<Operon::Scalar>(std::max(1.0 / 3, 1 - std::pow(2 * rho - 1, 3))); // NOLINT
+                nu = 2;
+                cost = re.NormalEquations(x.data(), a.data(), g.data());
+                ++sum.FunctionEvaluations;
+                ++sum.JacobianEvaluations;
+            } else {
+                damping *= nu;
+                nu *= 2;
+            }
+        }
+
+        sum.FinalCost = cost;
+        sum.Success = sum.FinalCost < sum.InitialCost;
+        if (writeCoefficients && sum.Success) {
+            tree.SetCoefficients({ x.data(), static_cast<size_t>(k) });
+        }
+        return sum;
+    }
+};
+
+struct MiniBatchOptions {
+    static constexpr size_t DefaultBatchSize = 1024;
+    static constexpr Operon::Scalar DefaultLearningRate = 1e-2;
+    static constexpr Operon::Scalar DefaultBeta1 = 0.9;
+    static constexpr Operon::Scalar DefaultBeta2 = 0.999;
+    static constexpr Operon::Scalar DefaultEpsilon = 1e-8;
+
+    size_t BatchSize { DefaultBatchSize }; // rows per step
+    Operon::Scalar LearningRate { DefaultLearningRate };
+    Operon::Scalar Beta1 { DefaultBeta1 }; // decay of the first moment estimate
+    Operon::Scalar Beta2 { DefaultBeta2 }; // decay of the second moment estimate
+    Operon::Scalar Epsilon { DefaultEpsilon };
+    uint64_t Seed { 0 }; // the sequence of mini-batches (the evaluators draw it from their random generator)
+};
+
+// adam over mini-batches of rows, for datasets too large for a full pass per iteration: every iteration evaluates the
+// gradient over one block of BatchSize consecutive rows at a random offset of the range (consecutive rows keep the
+// interpreter vectorized) and counts as one jacobian evaluation
+// - the initial and final costs are measured on a fixed sample block (one residual evaluation each), so the
+//   optimizer never passes over the whole range and the success of a fit is only an estimate
+// - the same seed gives every tree the same sequence of blocks
+template <>
+struct NonlinearLeastSquaresOptimizer<OptimizerType::MINIBATCH> : public OptimizerBase {
+    NonlinearLeastSquaresOptimizer(Interpreter const& interpreter, Tree& tree, Dataset const& dataset, MiniBatchOptions options = {})
+        : OptimizerBase(interpreter, tree, dataset)
+        , options_(options)
+    {
+        EXPECT(options_.BatchSize > 0);
+    }
+
+    template <DerivativeMethod D = DerivativeMethod::AUTODIFF>
+    auto Optimize(Operon::Span<const Operon::Scalar> const target, Range range, size_t iterations, bool writeCoefficients = true, bool /*unused*/ = false) -> OptimizerSummary
+    {
+        static_assert(D == DerivativeMethod::AUTODIFF, "The mini-batch optimizer only supports autodiff.");
+        using Vector = OptimizerWorkspace::VectorType;
+
+        auto& tree = GetTree();
+        auto& workspace = OptimizerWorkspace::Local();
+        auto const& coeff = workspace.Coefficients(tree);
+        OptimizerSummary sum {};
+        if (coeff.empty()) { return sum; }
+
+        ResidualEvaluator re(GetInterpreter(), tree, GetDataset(), target, range);
+        auto const batch = std::min(options_.BatchSize, range.Size());
+        Operon::RandomGenerator random(options_.Seed);
+        auto sample = [&]() {
+            auto const start = range.Start() + Random::Uniform(random, size_t { 0 }, range.Size() - batch);
+            return Range { start, start + batch };
+        };
+
+        auto const k = static_cast<Eigen::Index>(coeff.size());
+        auto x = workspace.Vector(0, k);
+        x = Eigen::Map<Vector const>(coeff.data(), k);
+        auto g = workspace.Vector(1, k);
+        auto m = workspace.Vector(2, k); // first moment estimate
+        auto v = workspace.Vector(3, k); // second moment estimate
+        m.setZero();
+        v.setZero();
+
+        // the block on which the initial and final costs are compared
+        auto const probe = sample();
+        sum.InitialCost = re.Cost(x.data(), probe);
+        sum.FunctionEvaluations = 1;
+
+        auto beta1 { Operon::Scalar { 1 } };
+        auto beta2 { Operon::Scalar { 1 } };
+        for (size_t i = 0; i < iterations; ++i) {
+            re.Gradient(x.data(), sample(), g.data());
+            ++sum.JacobianEvaluations;
+            ++sum.Iterations;
+            if (!g.allFinite()) { break; }
+            g /= static_cast<Operon::Scalar>(batch);
+
+            beta1 *= options_.Beta1;
+            beta2 *= options_.Beta2;
+            m = options_.Beta1 * m + (1 - options_.Beta1) * g;
+            v = options_.Beta2 * v + (1 - options_.Beta2) * g.cwiseAbs2();
+            // bias corrected moments
+            x.array() -= options_.LearningRate * (m.array() / (1 - beta1)) / ((v.array() / (1 - beta2)).sqrt() + options_.Epsilon);
+        }
+
+        sum.FinalCost = re.Cost(x.data(), probe);
+        ++sum.FunctionEvaluations;
+        sum.Success = x.allFinite() && sum.FinalCost < sum.InitialCost;
+        if (writeCoefficients && sum.Success) {
+            tree.SetCoefficients({ x.data(), static_cast<size_t>(k) });
+        }
+        return sum;
+    }
+
+    [[nodiscard]] auto Options() const -> MiniBatchOptions const& { return options_; }
+
+private:
+    MiniBatchOptions options_;
+};
+
 #if HAVE_CERES
 template <>
 struct NonlinearLeastSquaresOptimizer<OptimizerType::CERES> : public OptimizerBase {
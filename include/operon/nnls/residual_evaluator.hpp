@@ -5,6 +5,10 @@
 #define OPERON_NNLS_RESIDUAL_EVALUATOR_HPP
 
 #include <Eigen/Core>
+#include <algorithm>
+#include <optional>
+#include <tuple>
+#include <type_traits>
 #include "operon/interpreter/interpreter.hpp"
 
 namespace Operon {
@@ -16,7 +20,9 @@ struct ResidualEvaluator {
         , dataset_(dataset)
         , range_(range)
         , target_(targetValues)
-        , numParameters_(tree_.get().GetCoefficients().size())
+        , numParameters_(static_cast<size_t>(tree_.get().CoefficientsCount()))
+        , scalarProgram_(interpreter.Compile<Operon::Scalar>(tree, dataset))
+        , reverseMode_(Interpreter::SupportsReverseMode(scalarProgram_))
     {
     }
 
@@ -30,25 +36,188 @@ struct ResidualEvaluator {
     auto operator()(T const* parameters, T* residuals) const -> bool
     {
         Operon::Span<T> result(residuals, target_.size());
-        GetInterpreter().Evaluate<T>(tree_.get(), dataset_.get(), range_, result, parameters);
+        // the tree topology does not change during optimization, so we reuse the compiled programs
+        if constexpr (std::is_same_v<T, Operon::Scalar>) {
+            GetInterpreter().Evaluate<T>(scalarProgram_, range_, result, parameters);
+        } else if constexpr (IsDual<T>::value) {
+            // the subtrees without parameters of the current jet chunk are evaluated in scalar arithmetic
+            GetInterpreter().EvaluateMixed<T>(scalarProgram_, DualProgram<T>(), range_, result, parameters);
+        } else {
+            GetInterpreter().Evaluate<T>(tree_.get(), dataset_.get(), range_, result, parameters);
+        }
         Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1, Eigen::ColMajor>> resMap(residuals, target_.size());
         Eigen::Map<const Eigen::Array<Operon::Scalar, Eigen::Dynamic, 1, Eigen::ColMajor>> targetMap(target_.data(), static_cast<Eigen::Index>(target_.size()));
         resMap -= targetMap.cast<T>();
         return true;
     }
 
+    // computes the residuals (if not null) and the jacobian using reverse-mode differentiation
+    template <int StorageOrder = Eigen::ColMajor>
+    auto Jacobian(Operon::Scalar const* parameters, Operon::Scalar* residuals, Operon::Scalar* jacobian) const -> bool
+    {
+        EXPECT(reverseMode_);
+        thread_local Operon::Vector<Operon::Scalar> buffer;
+        auto* values = residuals;
+        if (values == nullptr) {
+            buffer.resize(target_.size());
+            values = buffer.data();
+        }
+        Operon::Span<Operon::Scalar> result(values, target_.size());
+        GetInterpreter().EvaluateJacobian<Operon::Scalar, StorageOrder>(scalarProgram_, range_, parameters, result, jacobian);
+        if (residuals != nullptr) {
+            Eigen::Map<Eigen::Array<Operon::Scalar, Eigen::Dynamic, 1>> resMap(residuals, target_.size());
+            Eigen::Map<const Eigen::Array<Operon::Scalar, Eigen::Dynamic, 1>> targetMap(target_.data(), static_cast<Eigen::Index>(target_.size()));
+            resMap -= targetMap;
+        }
+        return true;
+    }
+
+    // the cost 0.5 * |r|^2 over the range or a block of its rows, streamed without a residual buffer
+    [[nodiscard]] auto Cost(Operon::Scalar const* parameters) const -> double { return Cost(parameters, range_); }
+
+    [[nodiscard]] auto Cost(Operon::Scalar const* parameters, Range block) const -> double
+    {
+        EXPECT(block.Start() >= range_.Start() && block.End() <= range_.End());
+        auto const* target = target_.data() + (block.Start() - range_.Start());
+        double cost { 0 };
+        GetInterpreter().EvaluateStreaming<Operon::Scalar>(scalarProgram_, block, [&](auto values, auto offset) {
+            for (size_t i = 0; i < values.size(); ++i) {
+                auto const r = static_cast<double>(values[i] - target[offset + i]);
+                cost += r * r;
+            }
+            return true;
+        }, parameters);
+        return 0.5 * cost; // NOLINT
+    }
+
+    // accumulates the normal equations a = J^T J (k x k, column major) and g = J^T r one block of NormalBlockRows rows
+    // at a time, so that the jacobian of the whole range is never formed. returns the cost 0.5 * |r|^2
+    auto NormalEquations(Operon::Scalar const* parameters, Operon::Scalar* a, Operon::Scalar* g) const -> double
+    {
+        using Vector = Eigen::Matrix<Operon::Scalar, -1, 1>;
+        using Matrix = Eigen::Matrix<Operon::Scalar, -1, -1>;
+
+        auto const k = static_cast<Eigen::Index>(numParameters_);
+        Eigen::Map<Matrix> ata(a, k, k);
+        Eigen::Map<Vector> atr(g, k);
+        ata.setZero();
+        atr.setZero();
+
+        thread_local Operon::Vector<Operon::Scalar> residuals;
+        thread_local Operon::Vector<Operon::Scalar> jacobian;
+        double cost { 0 };
+        for (size_t offset = 0; offset < range_.Size(); offset += NormalBlockRows) {
+            auto const rows = std::min(NormalBlockRows, range_.Size() - offset);
+            Range const block { range_.Start() + offset, range_.Start() + offset + rows };
+            residuals.resize(rows);
+            jacobian.resize(rows * numParameters_);
+            BlockJacobian(parameters, block, residuals.data(), jacobian.data());
+
+            auto const n = static_cast<Eigen::Index>(rows);
+            Eigen::Map<Vector> r(residuals.data(), n);
+            Eigen::Map<Matrix const> jac(jacobian.data(), n, k);
+            r -= Eigen::Map<Vector const>(target_.data() + offset, n);
+            ata.selfadjointView<Eigen::Lower>().rankUpdate(jac.transpose());
+            atr.noalias() += jac.transpose() * r;
+            cost += 0.5 * r.template cast<double>().squaredNorm(); // NOLINT
+        }
+        ata = ata.selfadjointView<Eigen::Lower>();
+        return cost;
+    }
+
+    // the gradient J^T r of the cost over a block of rows of the range (e.g. a mini-batch), returns the cost
+    // 0.5 * |r|^2 of the block
+    auto Gradient(Operon::Scalar const* parameters, Range block, Operon::Scalar* g) const -> double
+    {
+        using Vector = Eigen::Matrix<Operon::Scalar, -1, 1>;
+        using Matrix = Eigen::Matrix<Operon::Scalar, -1, -1>;
+        EXPECT(block.Start() >= range_.Start() && block.End() <= range_.End());
+
+        thread_local Operon::Vector<Operon::Scalar> residuals;
+        thread_local Operon::Vector<Operon::Scalar> jacobian;
+        auto const rows = block.Size();
+        residuals.resize(rows);
+        jacobian.resize(rows * numParameters_);
+        BlockJacobian(parameters, block, residuals.data(), jacobian.data());
+
+        auto const n = static_cast<Eigen::Index>(rows);
+        auto const k = static_cast<Eigen::Index>(numParameters_);
+        Eigen::Map<Vector> r(residuals.data(), n);
+        r -= Eigen::Map<Vector const>(target_.data() + (block.Start() - range_.Start()), n);
+        Eigen::Map<Vector>(g, k).noalias() = Eigen::Map<Matrix const>(jacobian.data(), n, k).transpose() * r;
+        return 0.5 * r.template cast<double>().squaredNorm(); // NOLINT
+    }
+
+    // compile the scalar program to native code if the expected number of residual evaluations justifies it
+    auto Accelerate(size_t evaluations) const -> bool { return Interpreter::Accelerate(scalarProgram_, range_.Size(), evaluations); }
+
+    // the jet width of the forward mode jacobian (see Operon::JetWidth)
+    [[nodiscard]] auto JetWidth() const -> int { return Operon::JetWidth(numParameters_); }
+
+    [[nodiscard]] auto HasReverseMode() const -> bool { return reverseMode_; }
     [[nodiscard]] auto NumParameters() const -> size_t { return numParameters_; }
     [[nodiscard]] auto NumResiduals() const -> size_t { return target_.size(); }
 
     [[nodiscard]] auto GetInterpreter() const -> Interpreter const& { return interpreter_.get(); }
 
+    // the rows of one block of the normal equations, the memory of NormalEquations is O(NormalBlockRows * k + k^2)
+    static constexpr size_t NormalBlockRows = 4096;
+
 private:
+    // the model response and its column major jacobian over a block of rows of the range (reverse mode if
+    // supported, else forward mode with the jet width of the tree)
+    auto BlockJacobian(Operon::Scalar const* parameters, Range block, Operon::Scalar* values, Operon::Scalar* jacobian) const -> void
+    {
+        auto const rows = block.Size();
+        if (reverseMode_) {
+            GetInterpreter().EvaluateJacobian<Operon::Scalar, Eigen::ColMajor>(scalarProgram_, block, parameters, { values, rows }, jacobian);
+            return;
+        }
+        DispatchJetWidth(JetWidth(), [&](auto jet) {
+            using Dual = decltype(jet);
+            constexpr auto D { Dual::DIMENSION };
+            thread_local Operon::Vector<Dual> inputs;
+            thread_local Operon::Vector<Dual> outputs;
+            inputs.resize(numParameters_);
+            outputs.resize(rows);
+            for (size_t i = 0; i < numParameters_; ++i) {
+                inputs[i].a = parameters[i];
+                inputs[i].v.setZero();
+            }
+            for (size_t s = 0; s < numParameters_; s += D) {
+                auto const e = std::min(numParameters_, s + D);
+                for (auto i = s; i < e; ++i) { inputs[i].v[static_cast<Eigen::Index>(i - s)] = 1; }
+                GetInterpreter().EvaluateMixed<Dual>(scalarProgram_, DualProgram<Dual>(), block, { outputs.data(), rows }, inputs.data());
+                for (auto i = s; i < e; ++i) {
+                    inputs[i].v[static_cast<Eigen::Index>(i - s)] = 0;
+                    std::transform(outputs.begin(), outputs.end(), jacobian + i * rows, [&](auto const& x) { return x.v[static_cast<Eigen::Index>(i - s)]; });
+                }
+            }
+            std::transform(outputs.begin(), outputs.end(), values, [](auto const& x) { return x.a; });
+            return true;
+        });
+    }
+
+    // the dual program of the requested jet width, compiled on first use (usually only one width is used)
+    template <typename T>
+    auto DualProgram() const -> Interpreter::Program<T> const&
+    {
+        auto& program = std::get<std::optional<Interpreter::Program<T>>>(dualPrograms_);
+        if (!program) { program = GetInterpreter().Compile<T>(tree_.get(), dataset_.get()); }
+        return *program;
+    }
+
     std::reference_wrapper<Interpreter const> interpreter_;
     std::reference_wrapper<Tree const> tree_;
     std::reference_wrapper<Dataset const> dataset_;
     Range range_;
     Operon::Span<const Operon::Scalar> target_;
     size_t numParameters_; // cache the number of parameters in the tree
+    Interpreter::Program<Operon::Scalar> scalarProgram_;
+    mutable std::tuple<std::optional<Interpreter::Program<DualN<4>>>,  // NOLINT
+                       std::optional<Interpreter::Program<DualN<8>>>,  // NOLINT
+                       std::optional<Interpreter::Program<DualN<16>>>> dualPrograms_; // NOLINT
+    bool reverseMode_; // all primitives in the tree support reverse-mode differentiation
 };
 } // namespace Operon
 
@@ -5,6 +5,7 @@
 #define OPERON_NNLS_TINY_OPTIMIZER
 
 #include <Eigen/Core>
+#include <type_traits>
 #include "operon/interpreter/interpreter.hpp"
 
 namespace Operon {
@@ -12,10 +13,18 @@ namespace Operon {
 // this cost function is adapted to work with both solvers from Ceres: the normal one and the tiny solver
 // for this, a number of template parameters are necessary:
 // - the CostFunctor is the actual functor for computing the residuals
-// - the Dual type represents a dual number, the user can specify the type for the Scalar part (float, double) and the Stride (Ceres-specific)
+// - the Dual type represents a dual number, the user can specify the type for the Scalar part (float, double) and the Stride (Ceres-specific).
+//   with Operon::Dual, the stride is chosen at runtime from the number of parameters instead (see Operon::JetWidth)
 // - the StorageOrder specifies the format of the jacobian (row-major for the big Ceres solver, column-major for the tiny solver)
 
 namespace detail {
+    // detects cost functors which are able to compute the jacobian in reverse mode
+    template<typename CostFunctor, typename = void>
+    struct HasReverseMode : std::false_type { };
+
+    template<typename CostFunctor>
+    struct HasReverseMode<CostFunctor, std::void_t<decltype(std::declval<CostFunctor const&>().HasReverseMode())>> : std::true_type { };
+
     template<typename CostFunctor, typename Dual, typename Scalar, int JacobianLayout = Eigen::ColMajor>
     inline auto Autodiff(CostFunctor const& function, Scalar const* parameters, Scalar* residuals, Scalar* jacobian) -> bool
     {
@@ -29,12 +38,15 @@ namespace detail {
             return function(parameters, residuals);
         }
 
-        std::vector<Dual> inputs(function.NumParameters());
+        // reuse the dual buffers between jacobian evaluations (one set per thread)
+        thread_local std::vector<Dual> inputs;
+        thread_local std::vector<Dual> outputs;
+        inputs.resize(function.NumParameters());
+        outputs.resize(function.NumResiduals());
         for (size_t i = 0; i < inputs.size(); ++i) {
             inputs[i].a = parameters[i];
             inputs[i].v.setZero();
         }
-        std::vector<Dual> outputs(function.NumResiduals());
 
         static auto constexpr D{Dual::DIMENSION};
         Eigen::Map<Eigen::Matrix<Scalar, -1, -1, JacobianLayout>> jmap(jacobian, outputs.size(), inputs.size());
@@ -70,6 +82,15 @@ namespace detail {
         }
         return true;
     }
+
+    // forward mode jacobian with the jet width which minimizes the dual work for the number of parameters
+    template<typename CostFunctor, typename Scalar, int JacobianLayout = Eigen::ColMajor>
+    inline auto AutodiffAdaptive(CostFunctor const& function, Scalar const* parameters, Scalar* residuals, Scalar* jacobian) -> bool
+    {
+        return DispatchJetWidth(JetWidth(function.NumParameters()), [&](auto jet) {
+            return Autodiff<CostFunctor, decltype(jet), Scalar, JacobianLayout>(function, parameters, residuals, jacobian);
+        });
+    }
 } // namespace detail
 
 template <typename CostFunctor, typename DualType, typename ScalarType, int StorageOrder = Eigen::RowMajor>
@@ -90,7 +111,17 @@ struct TinyCostFunction {
 
     auto Evaluate(Scalar const* parameters, Scalar* residuals, Scalar* jacobian) const -> bool
     {
-        return detail::Autodiff<CostFunctor, DualType, ScalarType, StorageOrder>(functor_, parameters, residuals, jacobian);
+        // a single reverse pass is much cheaper than ceil(k / Stride) forward passes with dual numbers
+        if constexpr (detail::HasReverseMode<CostFunctor>::value && std::is_same_v<Scalar, Operon::Scalar>) {
+            if (jacobian != nullptr && functor_.HasReverseMode()) {
+                return functor_.template Jacobian<StorageOrder>(parameters, residuals, jacobian);
+            }
+        }
+        if constexpr (std::is_same_v<DualType, Operon::Dual>) {
+            return detail::AutodiffAdaptive<CostFunctor, ScalarType, StorageOrder>(functor_, parameters, residuals, jacobian);
+        } else {
+            return detail::Autodiff<CostFunctor, DualType, ScalarType, StorageOrder>(functor_, parameters, residuals, jacobian);
+        }
     }
 
     // ceres solver - jacobian must be in row-major format
@@ -0,0 +1,191 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_NNLS_VARIABLE_PROJECTION_HPP
+#define OPERON_NNLS_VARIABLE_PROJECTION_HPP
+
+#include <Eigen/Core>
+#include <Eigen/QR>
+#include <vector>
+
+#include "residual_evaluator.hpp"
+
+namespace Operon {
+
+// a coefficient which enters the model output linearly: the path from its leaf to the root consists only of
+// additions and subtractions, so the output has the form f = g(other coefficients) + Sign * Value * (x or 1)
+struct LinearCoefficient {
+    size_t Index; // position in the coefficient vector (see Tree::GetCoefficients)
+    size_t Node;  // position of the leaf in the tree
+    Operon::Scalar Sign;
+};
+
+inline auto FindLinearCoefficients(Tree const& tree) -> std::vector<LinearCoefficient>
+{
+    auto const& nodes = tree.Nodes();
+    std::vector<Operon::Scalar> sign(nodes.size(), 0); // zero means the node is not part of the additive chain
+    sign.back() = 1;
+
+    // the tree is stored in postfix order, so parents are visited before their children
+    for (auto i = nodes.size(); i-- > 0;) {
+        auto const& n = nodes[i];
+        if (sign[i] == 0 || n.IsLeaf() || !(n.Is<NodeType::Add>() || n.Is<NodeType::Sub>())) {
+            continue;
+        }
+        auto j = i - 1;
+        for (size_t k = 0; k < n.Arity; ++k) {
+            // unary subtraction is a negation, otherwise all but the first argument are subtracted
+            auto negate = n.Is<NodeType::Sub>() && (n.Arity == 1 || k > 0);
+            sign[j] = negate ? -sign[i] : sign[i];
+            j -= nodes[j].Length + 1;
+        }
+    }
+
+    std::vector<LinearCoefficient> linear;
+    size_t index{0};
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        auto const& n = nodes[i];
+        if (!n.IsLeaf()) { continue; }
+        if (sign[i] != 0 && (n.IsVariable() || n.IsConstant())) {
+            linear.push_back({ index, i, sign[i] });
+        }
+        ++index;
+    }
+    return linear;
+}
+
+// residuals of the variable projection functional: for fixed nonlinear coefficients, the linear coefficients
+// are the solution of a linear least squares problem with the basis Phi (one column per linear coefficient).
+// the residual is the projection of g - y onto the orthogonal complement of span(Phi), where g is the model
+// output with all the linear coefficients set to zero. since Phi does not depend on the nonlinear coefficients,
+// the jacobian is simply the projected jacobian of g.
+struct ProjectedResidualEvaluator {
+    using Matrix = Eigen::Matrix<Operon::Scalar, -1, -1>;
+
+    ProjectedResidualEvaluator(ResidualEvaluator const& evaluator, Tree const& tree, Dataset const& dataset, Range const range, std::vector<LinearCoefficient> const& linear)
+        : evaluator_(evaluator)
+        , linear_(linear)
+    {
+        auto const numParameters = evaluator_.NumParameters();
+        std::vector<bool> isLinear(numParameters, false);
+        for (auto const& c : linear_) { isLinear[c.Index] = true; }
+        for (size_t i = 0; i < numParameters; ++i) {
+            if (!isLinear[i]) { nonlinear_.push_back(i); }
+        }
+
+        auto const rows = static_cast<Eigen::Index>(range.Size());
+        Matrix phi(rows, static_cast<Eigen::Index>(linear_.size()));
+        auto const& nodes = tree.Nodes();
+        for (size_t k = 0; k < linear_.size(); ++k) {
+            auto const& c = linear_[k];
+            auto col = phi.col(static_cast<Eigen::Index>(k));
+            if (nodes[c.Node].IsVariable()) {
+                auto const hash = nodes[c.Node].HashValue;
+                auto values = dataset.GetValues(hash).subspan(range.Start() - dataset.FirstRow(hash), range.Size());
+                col = c.Sign * Eigen::Map<Eigen::Matrix<Operon::Scalar, -1, 1> const>(values.data(), rows);
+            } else {
+                col.setConstant(c.Sign);
+            }
+        }
+        qr_.compute(phi);
+        q_ = qr_.householderQ() * Matrix::Identity(rows, qr_.rank());
+    }
+
+    template <typename T>
+    auto operator()(T const* parameters, T* residuals) const -> bool
+    {
+        auto full = Expand(parameters);
+        if (!evaluator_(full.data(), residuals)) {
+            return false;
+        }
+        Project(residuals);
+        return true;
+    }
+
+    // computes the residuals (if not null) and the jacobian using reverse-mode differentiation
+    template <int StorageOrder = Eigen::ColMajor>
+    auto Jacobian(Operon::Scalar const* parameters, Operon::Scalar* residuals, Operon::Scalar* jacobian) const -> bool
+    {
+        auto const rows = static_cast<Eigen::Index>(NumResiduals());
+        auto const cols = static_cast<Eigen::Index>(evaluator_.NumParameters());
+
+        thread_local Matrix full;
+        full.resize(rows, cols);
+        auto params = Expand(parameters);
+        evaluator_.Jacobian<Eigen::ColMajor>(params.data(), residuals, full.data());
+        if (residuals != nullptr) {
+            Project(residuals);
+        }
+
+        Eigen::Map<Eigen::Matrix<Operon::Scalar, -1, -1, StorageOrder>> jmap(jacobian, rows, static_cast<Eigen::Index>(nonlinear_.size()));
+        for (size_t k = 0; k < nonlinear_.size(); ++k) {
+            Eigen::Matrix<Operon::Scalar, -1, 1> col = full.col(static_cast<Eigen::Index>(nonlinear_[k]));
+            Project(col.data());
+            jmap.col(static_cast<Eigen::Index>(k)) = col;
+        }
+        return true;
+    }
+
+    // the optimal linear coefficients for the given nonlinear coefficients
+    [[nodiscard]] auto SolveLinear(Operon::Scalar const* parameters) const -> Eigen::Matrix<Operon::Scalar, -1, 1>
+    {
+        auto full = Expand(parameters);
+        Eigen::Matrix<Operon::Scalar, -1, 1> r(NumResiduals());
+        evaluator_(full.data(), r.data()); // g - y
+        return qr_.solve(-r);
+    }
+
+    // merges the nonlinear and linear coefficients into a full coefficient vector
+    [[nodiscard]] auto Merge(Operon::Scalar const* parameters, Eigen::Matrix<Operon::Scalar, -1, 1> const& linear) const -> std::vector<Operon::Scalar>
+    {
+        auto full = Expand(parameters);
+        for (size_t k = 0; k < linear_.size(); ++k) {
+            full[linear_[k].Index] = linear(static_cast<Eigen::Index>(k));
+        }
+        return full;
+    }
+
+    [[nodiscard]] auto HasReverseMode() const -> bool { return evaluator_.HasReverseMode(); }
+    [[nodiscard]] auto NumParameters() const -> size_t { return nonlinear_.size(); }
+    [[nodiscard]] auto NumResiduals() const -> size_t { return evaluator_.NumResiduals(); }
+    [[nodiscard]] auto NonlinearIndices() const -> std::vector<size_t> const& { return nonlinear_; }
+
+private:
+    // full parameter vector with the linear coefficients set to zero
+    template <typename T>
+    auto Expand(T const* parameters) const -> std::vector<T>
+    {
+        std::vector<T> full(evaluator_.NumParameters(), T{0});
+        for (size_t k = 0; k < nonlinear_.size(); ++k) {
+            full[nonlinear_[k]] = parameters[k];
+        }
+        return full;
+    }
+
+    // r <- r - Q (Q^T r)
+    template <typename T>
+    auto Project(T* residuals) const -> void
+    {
+        auto const rows = q_.rows();
+        if constexpr (std::is_same_v<T, Operon::Scalar>) {
+            Eigen::Map<Eigen::Matrix<Operon::Scalar, -1, 1>> r(residuals, rows);
+            r -= q_ * (q_.transpose() * r);
+        } else {
+            for (Eigen::Index c = 0; c < q_.cols(); ++c) {
+                T dot{0};
+                for (Eigen::Index i = 0; i < rows; ++i) { dot += q_(i, c) * residuals[i]; }
+                for (Eigen::Index i = 0; i < rows; ++i) { residuals[i] -= q_(i, c) * dot; }
+            }
+        }
+    }
+
+    ResidualEvaluator evaluator_;
+    std::vector<LinearCoefficient> linear_;
+    std::vector<size_t> nonlinear_;
+    Eigen::ColPivHouseholderQR<Matrix> qr_;
+    Matrix q_; // orthonormal basis of span(Phi)
+};
+
+} // namespace Operon
+
+#endif
@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_NNLS_WORKSPACE_HPP
+#define OPERON_NNLS_WORKSPACE_HPP
+
+#include <Eigen/Core>
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "operon/core/allocation.hpp"
+#include "operon/core/contracts.hpp"
+#include "operon/core/tree.hpp"
+#include "operon/core/types.hpp"
+
+namespace Operon {
+
+// the scratch space of the local optimization, one per thread (see Local) so it survives across the evaluations and
+// the generations of the worker: the coefficients of the tree and the vectors and matrices of the optimizers, in
+// storage which only grows. once a worker has seen the largest problem (rows x coefficients) the optimizers keeping
+// their state here (NORMAL, MINIBATCH) do not allocate. the solvers of TINY and EIGEN manage their own matrices
+// - the vectors and matrices of one optimization need distinct slots. a slot is reused by the next optimization on the
+//   same thread, the views are only valid until then
+// - the optimizers do not nest, a fallback optimizer (see VARPRO) only runs once the caller is done with its slots
+// - the slots follow the allocation policy (see Memory::AllocationPolicy), the jacobians of large problems can be
+//   backed by huge pages
+class OptimizerWorkspace {
+public:
+    static constexpr size_t Slots = 8;
+
+    using VectorType = Eigen::Matrix<Operon::Scalar, -1, 1>;
+    using MatrixType = Eigen::Matrix<Operon::Scalar, -1, -1>;
+
+    // a vector of n scalars in the given slot (the values are unspecified)
+    auto Vector(size_t slot, Eigen::Index n) -> Eigen::Map<VectorType>
+    {
+        return { Reserve(slot, static_cast<size_t>(n)), n };
+    }
+
+    // a column major rows x cols matrix in the given slot (the values are unspecified)
+    auto Matrix(size_t slot, Eigen::Index rows, Eigen::Index cols) -> Eigen::Map<MatrixType>
+    {
+        return { Reserve(slot, static_cast<size_t>(rows * cols)), rows, cols };
+    }
+
+    // the coefficients of the tree (see Tree::GetCoefficients)
+    auto Coefficients(Tree const& tree) -> std::vector<Operon::Scalar>&
+    {
+        tree.GetCoefficients(coefficients_);
+        return coefficients_;
+    }
+
+    // the number of scalars held by the slot
+    [[nodiscard]] auto Capacity(size_t slot) const -> size_t { return storage_[slot].capacity(); }
+
+    static auto Local() -> OptimizerWorkspace&
+    {
+        thread_local OptimizerWorkspace workspace;
+        return workspace;
+    }
+
+private:
+    auto Reserve(size_t slot, size_t n) -> Operon::Scalar*
+    {
+        EXPECT(slot < Slots);
+        auto& storage = storage_[slot];
+        if (storage.size() < n) { storage.resize(n); }
+        return storage.data();
+    }
+
+    std::array<Memory::AlignedVector<Operon::Scalar>, Slots> storage_;
+    std::vector<Operon::Scalar> coefficients_;
+};
+
+} // namespace Operon
+
+#endif
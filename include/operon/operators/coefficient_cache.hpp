@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_COEFFICIENT_CACHE_HPP
+#define OPERON_COEFFICIENT_CACHE_HPP
+
+#include "operon/core/tree.hpp"
+#include "operon/core/types.hpp"
+#include "operon/operators/fitness_cache.hpp"
+#include "operon/operon_export.hpp"
+
+namespace Operon {
+
+// concurrent bounded cache of optimized coefficients, keyed by subtree hash values computed in HashMode::Relaxed
+// (which ignores the coefficient values). offspring inherit whole subtrees from their parents, so the tuned
+// coefficients of these subtrees provide a warm start for the local optimization of the offspring.
+// the storage and eviction policy are those of FitnessCache. an entry keeps the coefficients of the subtree from the
+// best fitting tree it was inserted with (the fitness part of the entries holds the error of that tree)
+class OPERON_EXPORT CoefficientCache {
+public:
+    static constexpr size_t DefaultCapacity = 1UL << 18U;
+
+    struct WarmStartResult {
+        size_t Coefficients{0}; // number of coefficients taken from the cache
+        bool Exact{false};      // the whole tree was found, so its coefficients were optimized together
+    };
+
+    explicit CoefficientCache(size_t capacity = DefaultCapacity)
+        : cache_(capacity)
+    {
+    }
+
+    // stores the coefficients of every subtree of the (optimized) tree, unless the subtree is already cached from a
+    // tree with a smaller error (e.g. the sum of squared errors on the training range)
+    void Insert(Tree const& tree, Operon::Scalar error);
+
+    // overwrites the coefficients of the tree with the cached values of its largest cached subtrees
+    auto WarmStart(Tree& tree) const -> WarmStartResult;
+
+    void Clear() { cache_.Clear(); }
+
+    [[nodiscard]] auto Capacity() const -> size_t { return cache_.Capacity(); }
+    [[nodiscard]] auto Size() const -> size_t { return cache_.Size(); }
+    [[nodiscard]] auto Hits() const -> size_t { return cache_.Hits(); }
+    [[nodiscard]] auto Misses() const -> size_t { return cache_.Misses(); }
+
+private:
+    FitnessCache cache_;
+};
+
+} // namespace Operon
+
+#endif
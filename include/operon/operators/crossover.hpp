@@ -7,6 +7,7 @@
 #include <vector>
 
 #include "operon/core/operator.hpp"
+#include "operon/core/node_pool.hpp"
 #include "operon/core/tree.hpp"
 
 namespace Operon {
@@ -26,17 +27,22 @@ public:
     auto FindCompatibleSwapLocations(Operon::RandomGenerator& random, const Tree& lhs, const Tree& rhs) const -> std::pair<size_t, size_t>;
 
     static inline auto Cross(const Tree& lhs, const Tree& rhs, /* index of subtree 1 */ size_t i, /* index of subtree 2 */ size_t j) -> Tree
+    {
+        return Cross(lhs, i, rhs.View(j));
+    }
+
+    // replaces the subtree rooted at i with the given branch, the child is assembled with a single splice
+    static inline auto Cross(const Tree& lhs, size_t i, TreeView branch) -> Tree
     {
         auto const& left = lhs.Nodes();
-        auto const& right = rhs.Nodes();
-        Operon::Vector<Node> nodes;
+        auto const right = branch.Nodes();
         using signed_t = std::make_signed<size_t>::type; // NOLINT
-        nodes.reserve(right[j].Length - left[i].Length + left.size());
+        auto nodes = NodePool::Acquire(right.size() + left.size() - (left[i].Length + 1UL));
         std::copy_n(left.begin(), i - left[i].Length, back_inserter(nodes));
-        std::copy_n(right.begin() + static_cast<signed_t>(j) - right[j].Length, right[j].Length + 1, back_inserter(nodes));
+        std::copy(right.begin(), right.end(), back_inserter(nodes));
         std::copy_n(left.begin() + static_cast<signed_t>(i) + 1, left.size() - (i + 1), back_inserter(nodes));
 
-        auto child = Tree(nodes).UpdateNodes();
+        auto child = Tree(std::move(nodes)).UpdateNodes(i - left[i].Length, left[i].Length + 1UL, right.size());
         return child;
     }
 
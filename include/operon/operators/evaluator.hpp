@@ -8,15 +8,37 @@
 #include <utility>
 
 #include "operon/collections/projection.hpp"
+#include "operon/core/chunked_dataset.hpp"
 #include "operon/core/individual.hpp"
 #include "operon/core/operator.hpp"
 #include "operon/core/problem.hpp"
+#include "operon/core/replicated_dataset.hpp"
+#include "operon/core/sharded_counter.hpp"
 #include "operon/core/types.hpp"
 #include "operon/interpreter/interpreter.hpp"
+#include "operon/operators/coefficient_cache.hpp"
+#include "operon/operators/fingerprint_cache.hpp"
+#include "operon/operators/fitness_cache.hpp"
+#include "operon/operators/semantic_sketch.hpp"
 #include "operon/operon_export.hpp"
 
+namespace tf {
+class Subflow;
+} // namespace tf
+
 namespace Operon {
 
+// first and second order moments of the (estimated, target) pairs, sufficient to compute the error
+// of the linearly scaled estimated values without materializing them
+struct ScalingMoments {
+    double Count{0};
+    double MeanX{0};
+    double MeanY{0};
+    double VarianceX{0};
+    double VarianceY{0};
+    double Covariance{0};
+};
+
 struct OPERON_EXPORT ErrorMetric {
     using Iterator = Operon::Span<Operon::Scalar const>::const_iterator;
     using ProjIterator = ProjectionIterator<Iterator>;
@@ -30,49 +52,115 @@ struct OPERON_EXPORT ErrorMetric {
     virtual auto operator()(Operon::Span<Operon::Scalar const> estimated, Operon::Span<Operon::Scalar const> target) const noexcept -> double = 0;
     virtual auto operator()(Iterator beg1, Iterator end1, Iterator beg2) const noexcept -> double = 0;
     virtual ~ErrorMetric() = default;
+
+    // metrics which are a monotonically increasing function of a sum of non-negative per-row terms can be
+    // computed incrementally, which allows evaluation to stop as soon as the error is known to exceed a cutoff
+    [[nodiscard]] virtual auto IsMonotone() const noexcept -> bool { return false; }
+
+    // sum of the per-row terms
+    [[nodiscard]] virtual auto Accumulate(Operon::Span<Operon::Scalar const> /*estimated*/, Operon::Span<Operon::Scalar const> /*target*/) const noexcept -> double { return 0; }
+
+    // a constant depending only on the target values (e.g., the target variance for the NMSE)
+    [[nodiscard]] virtual auto Normalization(Operon::Span<Operon::Scalar const> /*target*/) const noexcept -> double { return 1; }
+
+    // the same constant computed from the (cached) target statistics, see Dataset::Statistics
+    [[nodiscard]] virtual auto Normalization(ColumnStatistics const& /*target*/) const noexcept -> double { return 1; }
+
+    // maps a (partial) sum of terms over n rows to the metric value
+    [[nodiscard]] virtual auto Finalize(double sum, size_t n, double /*normalization*/) const noexcept -> double { return sum / static_cast<double>(n); }
+
+    // metrics which can be computed in closed form from the moments of the unscaled values (see ScalingMoments)
+    [[nodiscard]] virtual auto HasScaledForm() const noexcept -> bool { return false; }
+
+    // the metric value after optimal linear scaling of the estimated values (see FitLeastSquares)
+    [[nodiscard]] virtual auto ScaledError(ScalingMoments const& /*moments*/) const noexcept -> double { return 0; }
 };
 
 struct OPERON_EXPORT MSE : public ErrorMetric {
     auto operator()(Operon::Span<Operon::Scalar const> estimated, Operon::Span<Operon::Scalar const> target) const noexcept -> double override;
     auto operator()(Iterator beg1, Iterator end1, Iterator beg2) const noexcept -> double override;
+    [[nodiscard]] auto IsMonotone() const noexcept -> bool override { return true; }
+    [[nodiscard]] auto Accumulate(Operon::Span<Operon::Scalar const> estimated, Operon::Span<Operon::Scalar const> target) const noexcept -> double override;
+    [[nodiscard]] auto HasScaledForm() const noexcept -> bool override { return true; }
+    [[nodiscard]] auto ScaledError(ScalingMoments const& moments) const noexcept -> double override;
 };
 
 struct OPERON_EXPORT NMSE : public ErrorMetric {
     auto operator()(Operon::Span<Operon::Scalar const> estimated, Operon::Span<Operon::Scalar const> target) const noexcept -> double override;
     auto operator()(Iterator beg1, Iterator end1, Iterator beg2) const noexcept -> double override;
+    [[nodiscard]] auto IsMonotone() const noexcept -> bool override { return true; }
+    [[nodiscard]] auto Accumulate(Operon::Span<Operon::Scalar const> estimated, Operon::Span<Operon::Scalar const> target) const noexcept -> double override;
+    [[nodiscard]] auto Normalization(Operon::Span<Operon::Scalar const> target) const noexcept -> double override;
+    [[nodiscard]] auto Normalization(ColumnStatistics const& target) const noexcept -> double override { return target.Variance; }
+    [[nodiscard]] auto Finalize(double sum, size_t n, double normalization) const noexcept -> double override;
+    [[nodiscard]] auto HasScaledForm() const noexcept -> bool override { return true; }
+    [[nodiscard]] auto ScaledError(ScalingMoments const& moments) const noexcept -> double override;
 };
 
 struct OPERON_EXPORT RMSE : public ErrorMetric {
     auto operator()(Operon::Span<Operon::Scalar const> estimated, Operon::Span<Operon::Scalar const> target) const noexcept -> double override;
     auto operator()(Iterator beg1, Iterator end1, Iterator beg2) const noexcept -> double override;
+    [[nodiscard]] auto IsMonotone() const noexcept -> bool override { return true; }
+    [[nodiscard]] auto Accumulate(Operon::Span<Operon::Scalar const> estimated, Operon::Span<Operon::Scalar const> target) const noexcept -> double override;
+    [[nodiscard]] auto Finalize(double sum, size_t n, double normalization) const noexcept -> double override;
+    [[nodiscard]] auto HasScaledForm() const noexcept -> bool override { return true; }
+    [[nodiscard]] auto ScaledError(ScalingMoments const& moments) const noexcept -> double override;
 };
 
 struct OPERON_EXPORT MAE : public ErrorMetric {
     auto operator()(Operon::Span<Operon::Scalar const> estimated, Operon::Span<Operon::Scalar const> target) const noexcept -> double override;
     auto operator()(Iterator beg1, Iterator end1, Iterator beg2) const noexcept -> double override;
+    [[nodiscard]] auto IsMonotone() const noexcept -> bool override { return true; }
+    [[nodiscard]] auto Accumulate(Operon::Span<Operon::Scalar const> estimated, Operon::Span<Operon::Scalar const> target) const noexcept -> double override;
 };
 
 struct OPERON_EXPORT R2 : public ErrorMetric {
     auto operator()(Operon::Span<Operon::Scalar const> estimated, Operon::Span<Operon::Scalar const> target) const noexcept -> double override;
     auto operator()(Iterator beg1, Iterator end1, Iterator beg2) const noexcept -> double override;
+    // -R2 = SSE / (n * var(y)) - 1 is an increasing function of the sum of squared errors
+    [[nodiscard]] auto IsMonotone() const noexcept -> bool override { return true; }
+    [[nodiscard]] auto Accumulate(Operon::Span<Operon::Scalar const> estimated, Operon::Span<Operon::Scalar const> target) const noexcept -> double override;
+    [[nodiscard]] auto Normalization(Operon::Span<Operon::Scalar const> target) const noexcept -> double override;
+    [[nodiscard]] auto Normalization(ColumnStatistics const& target) const noexcept -> double override { return target.Variance; }
+    [[nodiscard]] auto Finalize(double sum, size_t n, double normalization) const noexcept -> double override;
+    [[nodiscard]] auto HasScaledForm() const noexcept -> bool override { return true; }
+    [[nodiscard]] auto ScaledError(ScalingMoments const& moments) const noexcept -> double override;
 };
 
 struct OPERON_EXPORT C2 : public ErrorMetric {
     auto operator()(Operon::Span<Operon::Scalar const> estimated, Operon::Span<Operon::Scalar const> target) const noexcept -> double override;
     auto operator()(Iterator beg1, Iterator end1, Iterator beg2) const noexcept -> double override;
+    [[nodiscard]] auto HasScaledForm() const noexcept -> bool override { return true; }
+    [[nodiscard]] auto ScaledError(ScalingMoments const& moments) const noexcept -> double override;
 };
 
 auto OPERON_EXPORT FitLeastSquares(Operon::Span<float const> estimated, Operon::Span<float const> target) noexcept -> std::pair<double, double>;
 auto OPERON_EXPORT FitLeastSquares(Operon::Span<double const> estimated, Operon::Span<double const> target) noexcept -> std::pair<double, double>;
 
-class EvaluatorBase : public OperatorBase<Operon::Vector<Operon::Scalar>, Individual&, Operon::Span<Operon::Scalar>> {
+auto OPERON_EXPORT ComputeScalingMoments(Operon::Span<float const> estimated, Operon::Span<float const> target) noexcept -> ScalingMoments;
+auto OPERON_EXPORT ComputeScalingMoments(Operon::Span<double const> estimated, Operon::Span<double const> target) noexcept -> ScalingMoments;
+
+class OPERON_EXPORT EvaluatorBase : public OperatorBase<Operon::FitnessVector, Individual&, Operon::Span<Operon::Scalar>> {
     Operon::Span<Operon::Individual const> population_;
     std::reference_wrapper<Problem const> problem_;
-    mutable std::atomic_ulong residualEvaluations_ = 0;
-    mutable std::atomic_ulong jacobianEvaluations_ = 0;
-    mutable std::atomic_ulong evaluationCounter_ = 0;
+    // incremented by every worker on every evaluation, sharded to keep the workers from contending for a cache line
+    mutable ShardedCounter<> residualEvaluations_;
+    mutable ShardedCounter<> jacobianEvaluations_;
+    mutable ShardedCounter<> evaluationCounter_;
+    mutable ShardedCounter<> surrogateEvaluations_; // the predictions of a surrogate model, not part of the budget
+    mutable std::atomic_ulong cacheHits_ = 0;
+    mutable std::atomic_ulong cacheMisses_ = 0;
+    FitnessCache* fitnessCache_ = nullptr;
+    FingerprintCache* fingerprintCache_ = nullptr;
+    CoefficientCache* coefficientCache_ = nullptr;
+    SemanticSketch* semanticSketch_ = nullptr;
+    ReplicatedDataset const* replicas_ = nullptr;
     size_t iterations_ = DefaultLocalOptimizationIterations;
     size_t budget_ = DefaultEvaluationBudget;
+    bool variableProjection_ = false;
+    bool normalEquations_ = false;
+    size_t miniBatchSize_ = 0;
+    bool simplification_ = false;
 
 public:
     static constexpr size_t DefaultLocalOptimizationIterations = 50;
@@ -89,10 +177,37 @@ public:
     {
     }
 
-    auto TotalEvaluations() const -> size_t { return residualEvaluations_ + jacobianEvaluations_; }
-    auto ResidualEvaluations() const -> size_t { return residualEvaluations_; }
-    auto JacobianEvaluations() const -> size_t { return jacobianEvaluations_; }
-    auto EvaluationCount() const -> size_t { return evaluationCounter_; }
+    // schedules the preparation as tasks of the given subflow (see SelectorBase::Prepare), by default a single task
+    // calling Prepare(pop). the state is ready once the subflow joins
+    virtual void Prepare(tf::Subflow& subflow, Operon::Span<Individual const> pop) const;
+
+    // evaluate with an error cutoff: evaluators supporting it may stop early and return the maximum
+    // fitness value once the error is guaranteed to exceed the cutoff (the default ignores the cutoff)
+    virtual auto Evaluate(Operon::RandomGenerator& rng, Individual& ind, Operon::Span<Operon::Scalar> buf, Operon::Scalar /*cutoff*/) const -> ReturnType
+    {
+        return (*this)(rng, ind, buf);
+    }
+
+    // number of scalars required in the buffer passed to operator() (e.g. to store the model response)
+    virtual auto BufferSize() const -> size_t { return GetProblem().TrainingRange().Size(); }
+
+    // a rough estimate of the relative cost of evaluating the individual, used to schedule the expensive evaluations
+    // first: proportional to the length of the tree, times the number of local optimization steps when the tree has
+    // coefficients to optimize (each step evaluates the jacobian, whose cost grows with the number of coefficients)
+    virtual auto Cost(Individual const& ind) const -> double
+    {
+        auto const length = static_cast<double>(ind.Genotype.Length());
+        auto const coefficients = iterations_ > 0 ? static_cast<size_t>(ind.Genotype.CoefficientsCount()) : size_t{0};
+        return length * (1.0 + static_cast<double>(iterations_ * coefficients));
+    }
+
+    auto TotalEvaluations() const -> size_t { return residualEvaluations_.Load() + jacobianEvaluations_.Load(); }
+    auto ResidualEvaluations() const -> size_t { return residualEvaluations_.Load(); }
+    auto JacobianEvaluations() const -> size_t { return jacobianEvaluations_.Load(); }
+    auto EvaluationCount() const -> size_t { return evaluationCounter_.Load(); }
+    auto SurrogateEvaluations() const -> size_t { return surrogateEvaluations_.Load(); }
+    auto CacheHits() const -> size_t { return cacheHits_; }
+    auto CacheMisses() const -> size_t { return cacheMisses_; }
 
     void SetResidualEvaluations(size_t value) const { residualEvaluations_ = value; }
     void SetJacobianEvaluations(size_t value) const { jacobianEvaluations_ = value; }
@@ -101,6 +216,9 @@ public:
     void IncrementResidualEvaluations() const { ++residualEvaluations_; }
     void IncrementLocalEvaluations() const { ++residualEvaluations_; }
     void IncrementEvaluationCounter() const { ++evaluationCounter_; }
+    void IncrementSurrogateEvaluations() const { ++surrogateEvaluations_; }
+    void IncrementCacheHits() const { ++cacheHits_; }
+    void IncrementCacheMisses() const { ++cacheMisses_; }
 
     void IncrementResidualEvaluations(size_t inc) const { residualEvaluations_ += inc; }
     void IncrementJacobianEvaluations(size_t inc) const { jacobianEvaluations_ += inc; }
@@ -109,18 +227,72 @@ public:
     void SetLocalOptimizationIterations(size_t value) { iterations_ = value; }
     auto LocalOptimizationIterations() const -> size_t { return iterations_; }
 
+    // eliminate the linearly entering coefficients during local optimization (see OptimizerType::VARPRO)
+    void SetVariableProjection(bool value) { variableProjection_ = value; }
+    auto VariableProjection() const -> bool { return variableProjection_; }
+
+    // accumulate the normal equations block by block instead of forming the jacobian of the training range (see
+    // OptimizerType::NORMAL), for large datasets
+    void SetNormalEquations(bool value) { normalEquations_ = value; }
+    auto NormalEquations() const -> bool { return normalEquations_; }
+
+    // optimize the coefficients by adam over mini-batches of this many rows (see OptimizerType::MINIBATCH), every
+    // local optimization iteration then evaluates the jacobian over one mini-batch. zero disables it
+    void SetMiniBatchSize(size_t value) { miniBatchSize_ = value; }
+    auto MiniBatchSize() const -> size_t { return miniBatchSize_; }
+
+    // simplify the trees (see Tree::Simplify) before they are evaluated and optimized
+    void SetSimplification(bool value) { simplification_ = value; }
+    auto Simplification() const -> bool { return simplification_; }
+
+    // optional fitness cache shared between evaluations (not owned by the evaluator)
+    void SetFitnessCache(FitnessCache* cache) { fitnessCache_ = cache; }
+    auto GetFitnessCache() const -> FitnessCache* { return fitnessCache_; }
+
+    // optional cache of the fitness by semantic fingerprint (not owned): the offspring equivalent on the sample rows
+    // to an evaluated model get its fitness without an evaluation or a local optimization (see FingerprintCache)
+    void SetFingerprintCache(FingerprintCache* cache) { fingerprintCache_ = cache; }
+    auto GetFingerprintCache() const -> FingerprintCache* { return fingerprintCache_; }
+
+    // optional cache of optimized subtree coefficients used to warm start the local optimization (not owned)
+    void SetCoefficientCache(CoefficientCache* cache) { coefficientCache_ = cache; }
+    auto GetCoefficientCache() const -> CoefficientCache* { return coefficientCache_; }
+
+    // optional sketches of the outputs of the evaluated models for the semantic diversity (not owned, see SemanticSketch)
+    void SetSemanticSketch(SemanticSketch* sketch) { semanticSketch_ = sketch; }
+    auto GetSemanticSketch() const -> SemanticSketch* { return semanticSketch_; }
+
     void SetBudget(size_t value) { budget_ = value; }
     auto Budget() const -> size_t { return budget_; }
-    auto BudgetExhausted() const -> bool { return TotalEvaluations() > Budget(); }
+    // checked by the generators before every offspring: a single load per counter while the budget is far away,
+    // the shards are only summed once the count is within the slack of the budget
+    auto BudgetExhausted() const -> bool
+    {
+        auto const approximate = residualEvaluations_.Approximate() + jacobianEvaluations_.Approximate();
+        if (approximate > budget_) { return true; }
+        if (approximate + residualEvaluations_.Slack() + jacobianEvaluations_.Slack() <= budget_) { return false; }
+        return TotalEvaluations() > budget_;
+    }
 
     auto Population() const -> Operon::Span<Individual const> { return population_; }
     auto GetProblem() const -> Problem const& { return problem_; }
 
+    // optional per numa node copies of the problem dataset (not owned), the evaluations of a worker then read the
+    // replica of its node (see ReplicatedDataset::Local)
+    void SetReplicatedDataset(ReplicatedDataset const* replicas) { replicas_ = replicas; }
+    auto GetReplicatedDataset() const -> ReplicatedDataset const* { return replicas_; }
+
+    // the dataset the calling thread evaluates on: its local replica if there is one, else the problem dataset
+    auto GetDataset() const -> Dataset const& { return replicas_ != nullptr ? replicas_->Local() : GetProblem().GetDataset(); }
+
     void Reset()
     {
         residualEvaluations_ = 0;
         jacobianEvaluations_ = 0;
         evaluationCounter_ = 0;
+        surrogateEvaluations_ = 0;
+        cacheHits_ = 0;
+        cacheMisses_ = 0;
     }
 };
 
@@ -165,13 +337,177 @@ public:
     auto GetInterpreter() -> Interpreter& { return interpreter_; }
     auto GetInterpreter() const -> Interpreter const& { return interpreter_; }
 
+    // optional cache of subtree outputs over the training range, used to avoid re-evaluating the
+    // parts of an offspring which are unchanged from its parents (the cache is not owned by the evaluator)
+    void SetSubtreeCache(SubtreeCache<Operon::Scalar>* cache) { cache_ = cache; }
+    auto GetSubtreeCache() const -> SubtreeCache<Operon::Scalar>* { return cache_; }
+
+    // evaluate block by block over a dataset larger than memory (the problem must be created from data->GetDataset(),
+    // copies of the mapped dataset share the mapping). only the streaming path (see BufferSize) benefits,
+    // local optimization still needs the whole range
+    void SetChunkedDataset(ChunkedDataset const* data)
+    {
+        EXPECT(data == nullptr || data->GetDataset().Values().data() == GetProblem().GetDataset().Values().data());
+        chunked_ = data;
+    }
+    auto GetChunkedDataset() const -> ChunkedDataset const* { return chunked_; }
+
+    auto
+    operator()(Operon::RandomGenerator& /*random*/, Individual& ind, Operon::Span<Operon::Scalar> buf) const -> typename EvaluatorBase::ReturnType override;
+
+    auto Evaluate(Operon::RandomGenerator& /*random*/, Individual& ind, Operon::Span<Operon::Scalar> buf, Operon::Scalar cutoff) const -> typename EvaluatorBase::ReturnType override;
+
+    // evaluate over a subrange of the training range (e.g. for subsampling)
+    auto Evaluate(Operon::RandomGenerator& /*random*/, Individual& ind, Operon::Span<Operon::Scalar> buf, Operon::Scalar cutoff, Range range) const -> typename EvaluatorBase::ReturnType;
+
+    // no buffer is needed when the metric is accumulated while streaming the model response
+    auto BufferSize() const -> size_t override;
+
+    // the absolute errors of the individuals on the given rows of the dataset (e.g. the cases of lexicase selection),
+    // after linear scaling fitted on these rows if enabled. the errors are stored case by case (rows x individuals),
+    // non-finite errors are replaced by infinity
+    auto CaseErrors(Operon::Span<Individual const> individuals, Operon::Span<size_t const> rows, Operon::Span<Operon::Scalar> errors) const -> void;
+
+    // number of rows evaluated between two checks of the error cutoff
+    static constexpr size_t CutoffBatchSize = 4096;
+
+private:
+    [[nodiscard]] auto UsesStreaming() const -> bool;
+
+
+    std::reference_wrapper<Interpreter> interpreter_;
+    std::reference_wrapper<ErrorMetric const> error_;
+    bool scaling_{false};
+    SubtreeCache<Operon::Scalar>* cache_{nullptr};
+    ChunkedDataset const* chunked_{nullptr};
+};
+
+// evaluates whole batches of individuals in one pass over the data: the rows are split into tiles and every tree of a
+// group is evaluated on the tile while its input values are in cache, the error (and the moments needed for the linear
+// scaling) are accumulated per tree, so no model response is ever materialized over the whole range
+// - EvaluateBatch distributes the groups over the workers of the executor, operator() evaluates a batch of one (so the
+//   algorithms can use the evaluator like any other)
+// - the local optimization of every tree runs before its tiles are evaluated, with SetBatchedOptimization the
+//   coefficients of the whole batch are optimized together first (see OptimizeBatch)
+// - metrics without a streaming form (see Evaluator::BufferSize) are computed on the whole range, tree by tree
+class OPERON_EXPORT BatchEvaluator : public EvaluatorBase {
+public:
+    static constexpr size_t DefaultTileSize = 4096;  // rows
+    static constexpr size_t DefaultGroupSize = 64;   // trees per task
+
+    BatchEvaluator(Problem& problem, Interpreter& interp, ErrorMetric const& error = MSE{}, bool linearScaling = true)
+        : EvaluatorBase(problem)
+        , interpreter_(interp)
+        , error_(error)
+        , scaling_(linearScaling)
+    {
+    }
+
+    auto GetInterpreter() -> Interpreter& { return interpreter_; }
+    auto GetInterpreter() const -> Interpreter const& { return interpreter_; }
+
+    void SetTileSize(size_t value) { EXPECT(value > 0); tileSize_ = value; }
+    auto TileSize() const -> size_t { return tileSize_; }
+
+    void SetGroupSize(size_t value) { EXPECT(value > 0); groupSize_ = value; }
+    auto GroupSize() const -> size_t { return groupSize_; }
+
+    // optimize the coefficients of a batch with the lock-step levenberg-marquardt of OptimizeBatch instead of tree by
+    // tree (the other local optimization settings of the evaluator do not apply to it)
+    void SetBatchedOptimization(bool value) { batchedOptimization_ = value; }
+    auto BatchedOptimization() const -> bool { return batchedOptimization_; }
+
     auto
     operator()(Operon::RandomGenerator& /*random*/, Individual& ind, Operon::Span<Operon::Scalar> buf) const -> typename EvaluatorBase::ReturnType override;
 
+    // the fitness of every individual, in the order of the individuals (the coefficients are updated by the local
+    // optimization, the fitness values are not assigned)
+    auto EvaluateBatch(Operon::RandomGenerator& random, tf::Executor& executor, Operon::Span<Individual> individuals) const -> Operon::Vector<Operon::Scalar>;
+
+    auto BufferSize() const -> size_t override { return 0; }
+
 private:
+    auto EvaluateBatch(tf::Subflow& subflow, Operon::RandomGenerator& random, Operon::Span<Individual> individuals, Operon::Span<Operon::Scalar> fitness) const -> void;
+    auto EvaluateGroup(Operon::RandomGenerator& random, Operon::Span<Individual> group, Operon::Span<Operon::Scalar> fitness, bool optimize) const -> void;
+
     std::reference_wrapper<Interpreter> interpreter_;
     std::reference_wrapper<ErrorMetric const> error_;
     bool scaling_{false};
+    bool batchedOptimization_{false};
+    size_t tileSize_{DefaultTileSize};
+    size_t groupSize_{DefaultGroupSize};
+};
+
+// evaluates several error metrics on the same model response, so that the tree is optimized and interpreted only once
+class OPERON_EXPORT MultiMetricEvaluator : public EvaluatorBase {
+public:
+    MultiMetricEvaluator(Problem& problem, Interpreter& interp, std::vector<std::reference_wrapper<ErrorMetric const>> metrics, bool linearScaling = true)
+        : EvaluatorBase(problem)
+        , interpreter_(interp)
+        , metrics_(std::move(metrics))
+        , scaling_(linearScaling)
+    {
+        EXPECT(!metrics_.empty());
+    }
+
+    auto GetInterpreter() -> Interpreter& { return interpreter_; }
+    auto GetInterpreter() const -> Interpreter const& { return interpreter_; }
+
+    [[nodiscard]] auto Metrics() const -> std::vector<std::reference_wrapper<ErrorMetric const>> const& { return metrics_; }
+
+    auto
+    operator()(Operon::RandomGenerator& /*random*/, Individual& ind, Operon::Span<Operon::Scalar> buf) const -> typename EvaluatorBase::ReturnType override;
+
+private:
+    std::reference_wrapper<Interpreter> interpreter_;
+    std::vector<std::reference_wrapper<ErrorMetric const>> metrics_;
+    bool scaling_{false};
+};
+
+// k-fold cross-validation of the fitness: the training range is split into Folds contiguous folds (of almost equal
+// sizes, the training data should be shuffled beforehand) and the objectives are the mean and the variance of the
+// error over the folds, e.g. to penalize the models fitting only a part of the data
+// - the tree is interpreted once over the whole training range, the error of every fold (or its scaling moments, see
+//   ScalingMoments) is accumulated in the same pass as the batches of the model response are streamed
+// - with linear scaling every fold is scaled on its own, so the objectives measure how consistently the shape of the
+//   model fits the folds. the coefficients are tuned once, on the whole training range
+// - metrics without a streaming form (see Evaluator::BufferSize) are computed fold by fold on the model response
+class OPERON_EXPORT CrossValidationEvaluator : public EvaluatorBase {
+public:
+    static constexpr size_t DefaultFolds = 5;
+
+    CrossValidationEvaluator(Problem& problem, Interpreter& interp, size_t folds = DefaultFolds, ErrorMetric const& error = MSE{}, bool linearScaling = true)
+        : EvaluatorBase(problem)
+        , interpreter_(interp)
+        , error_(error)
+        , scaling_(linearScaling)
+        , folds_(folds)
+    {
+        EXPECT(folds > 1);
+    }
+
+    auto GetInterpreter() -> Interpreter& { return interpreter_; }
+    auto GetInterpreter() const -> Interpreter const& { return interpreter_; }
+
+    [[nodiscard]] auto Folds() const -> size_t { return folds_; }
+    // the rows of the fold, a subrange of the training range
+    [[nodiscard]] auto Fold(size_t fold) const -> Range;
+
+    auto
+    operator()(Operon::RandomGenerator& /*random*/, Individual& ind, Operon::Span<Operon::Scalar> buf) const -> typename EvaluatorBase::ReturnType override;
+
+    // the error of every fold, without tuning the coefficients
+    auto FoldErrors(Tree const& tree, Operon::Span<Operon::Scalar> buf) const -> Operon::Vector<double>;
+
+    auto BufferSize() const -> size_t override;
+
+private:
+    [[nodiscard]] auto UsesStreaming() const -> bool;
+
+    std::reference_wrapper<Interpreter> interpreter_;
+    std::reference_wrapper<ErrorMetric const> error_;
+    bool scaling_{false};
+    size_t folds_;
 };
 
 class MultiEvaluator : public EvaluatorBase {
@@ -193,16 +529,34 @@ public:
         }
     }
 
+    // the evaluators are prepared concurrently
+    auto Prepare(tf::Subflow& subflow, Operon::Span<Operon::Individual const> pop) const -> void override
+    {
+        for (auto const& e : evaluators_) {
+            e.get().Prepare(subflow, pop);
+        }
+    }
+
+    auto BufferSize() const -> size_t override
+    {
+        size_t size{0};
+        for (auto const& e : evaluators_) {
+            size = std::max(size, e.get().BufferSize());
+        }
+        return size;
+    }
+
     auto
     operator()(Operon::RandomGenerator& rng, Individual& ind, Operon::Span<Operon::Scalar> buf) const -> typename EvaluatorBase::ReturnType override
     {
-        Operon::Vector<Operon::Scalar> fit;
+        // the objectives of the evaluators are appended in place (inline up to InlineObjectives)
+        Operon::FitnessVector fit;
+        fit.reserve(evaluators_.size());
         auto totalResidualEvaluations{0UL};
         auto totalJacobianEvaluations{0UL};
         auto totalEvaluationCount{0UL};
         for (auto const& ev : evaluators_) {
-            auto fitI = ev(rng, ind, buf);
-            std::copy(fitI.begin(), fitI.end(), std::back_inserter(fit));
+            for (auto v : ev(rng, ind, buf)) { fit.push_back(v); }
 
             totalResidualEvaluations += ev.get().ResidualEvaluations();
             totalJacobianEvaluations += ev.get().JacobianEvaluations();
@@ -218,6 +572,128 @@ private:
     std::vector<std::reference_wrapper<EvaluatorBase const>> evaluators_;
 };
 
+// evaluates individuals on a random window of the training range, which is resampled every generation (in Prepare)
+// - individuals whose subsampled fitness ranks among the best (quantile of the current population) are
+//   re-evaluated on the whole training range (racing), so that the elite is always scored on all the data. the
+//   quantile is taken over the fitness on the new window of a random sample of the population (their fitness values
+//   were computed on other rows), the sample evaluations count towards the budget
+// - the window is contiguous, so the training data should be shuffled beforehand
+// - racing is based on the first objective
+class OPERON_EXPORT SubsampledEvaluator : public EvaluatorBase {
+public:
+    static constexpr double DefaultFraction = 0.1;
+    static constexpr double DefaultRacingQuantile = 0.1;
+    static constexpr size_t DefaultRacingSample = 64;
+
+    SubsampledEvaluator(Problem& problem, Evaluator const& evaluator, double fraction = DefaultFraction, double quantile = DefaultRacingQuantile, Operon::RandomGenerator::result_type seed = 0)
+        : EvaluatorBase(problem)
+        , evaluator_(evaluator)
+        , fraction_(fraction)
+        , quantile_(quantile)
+        , random_(seed)
+        , window_(problem.TrainingRange())
+    {
+        EXPECT(fraction > 0 && fraction <= 1);
+        EXPECT(quantile >= 0 && quantile <= 1);
+    }
+
+    using EvaluatorBase::Prepare;
+    auto Prepare(Operon::Span<Operon::Individual const> pop) const -> void override;
+
+    auto
+    operator()(Operon::RandomGenerator& rng, Individual& ind, Operon::Span<Operon::Scalar> buf) const -> typename EvaluatorBase::ReturnType override
+    {
+        return Evaluate(rng, ind, buf, std::numeric_limits<Operon::Scalar>::max());
+    }
+
+    auto Evaluate(Operon::RandomGenerator& rng, Individual& ind, Operon::Span<Operon::Scalar> buf, Operon::Scalar cutoff) const -> typename EvaluatorBase::ReturnType override;
+
+    auto BufferSize() const -> size_t override { return evaluator_.get().BufferSize(); }
+
+    [[nodiscard]] auto Window() const -> Range { return window_; }
+    [[nodiscard]] auto Threshold() const -> Operon::Scalar { return threshold_; }
+    [[nodiscard]] auto FullEvaluations() const -> size_t { return fullEvaluations_; }
+
+    // the individuals evaluated on the window to set the racing threshold
+    void SetRacingSample(size_t value) { EXPECT(value > 0); sample_ = value; }
+    [[nodiscard]] auto RacingSample() const -> size_t { return sample_; }
+
+private:
+    std::reference_wrapper<Evaluator const> evaluator_;
+    double fraction_;
+    double quantile_;
+    size_t sample_{DefaultRacingSample};
+
+    // updated in Prepare, which is never called concurrently with the evaluation
+    mutable Operon::RandomGenerator random_;
+    mutable Range window_;
+    mutable Operon::Scalar threshold_{std::numeric_limits<Operon::Scalar>::max()};
+    mutable std::atomic_ulong fullEvaluations_{0};
+};
+
+// a low precision tier screening the offspring before their exact evaluation (see
+// OffspringGeneratorBase::SetScreening): the candidates are evaluated in single precision with their inherited
+// coefficients (no local optimization) on a sample of the training rows, copied in float at construction (see
+// Dataset::Sample)
+// - the float columns hold twice the values of a simd register and half the bytes of the double columns, and the
+//   sample is a fraction of the training range, so screening a candidate costs a small fraction of its evaluation
+// - Prepare screens the population, a candidate is promoted to the exact evaluation if its screening error is not
+//   worse than the Quantile of the screening errors of the population (so a quantile of one promotes the candidates
+//   not worse than the worst parent)
+// - the trees with a user-defined primitive (NodeType::Dynamic) are not screened, they are always promoted
+class OPERON_EXPORT ScreeningEvaluator {
+public:
+    static constexpr double DefaultFraction = 0.1;
+    static constexpr double DefaultQuantile = 0.75;
+    static constexpr size_t MinRows = 256; // the smallest sample, unless the training range is smaller
+
+    ScreeningEvaluator(Problem const& problem, ErrorMetric const& error = MSE{}, bool linearScaling = true, double fraction = DefaultFraction, double quantile = DefaultQuantile);
+
+    // screens the population and updates the threshold, never called concurrently with the screening
+    auto Prepare(Operon::Span<Individual const> pop) const -> void;
+    auto Prepare(tf::Subflow& subflow, Operon::Span<Individual const> pop) const -> void;
+
+    // the screening error of the individual (non-finite errors are replaced by the largest value), the lowest value
+    // if the individual cannot be screened
+    auto operator()(Individual const& ind) const -> Operon::Scalar;
+
+    // screens the individual, true if it is promoted to the exact evaluation
+    auto Promote(Individual const& ind) const -> bool { return Promote((*this)(ind)); }
+    // promotes an individual from its screening error, regardless of the threshold if forced (e.g. the best of a brood)
+    auto Promote(Operon::Scalar error, bool force = false) const -> bool
+    {
+        auto const promoted = force || error <= threshold_;
+        if (promoted) { ++promoted_; }
+        return promoted;
+    }
+
+    [[nodiscard]] auto Screenable(Tree const& tree) const -> bool;
+
+    [[nodiscard]] auto Rows() const -> size_t { return sample_.Rows(); }
+    [[nodiscard]] auto Quantile() const -> double { return quantile_; }
+    [[nodiscard]] auto Threshold() const -> Operon::Scalar { return threshold_; }
+    // the candidates screened (including the ones which cannot be screened) and promoted since the construction
+    [[nodiscard]] auto Screened() const -> size_t { return screened_; }
+    [[nodiscard]] auto Promoted() const -> size_t { return promoted_; }
+
+private:
+    auto Error(Tree const& tree) const -> Operon::Scalar;
+    auto UpdateThreshold() const -> void;
+
+    Dataset sample_; // the sampled rows, stored in single precision
+    Operon::Hash target_;
+    GenericInterpreter<float> interpreter_;
+    std::reference_wrapper<ErrorMetric const> error_;
+    bool scaling_;
+    double quantile_;
+
+    // updated in Prepare
+    mutable std::vector<Operon::Scalar> errors_;
+    mutable Operon::Scalar threshold_{std::numeric_limits<Operon::Scalar>::max()};
+    mutable std::atomic_ulong screened_{0};
+    mutable std::atomic_ulong promoted_{0};
+};
+
 // a couple of useful user-defined evaluators (mostly to avoid calling lambdas from python)
 // TODO: think about a better design
 class LengthEvaluator : public UserDefinedEvaluator {
@@ -240,10 +716,21 @@ public:
     }
 };
 
-class DiversityEvaluator : public EvaluatorBase {
+class OPERON_EXPORT DiversityEvaluator : public EvaluatorBase {
 public:
-    explicit DiversityEvaluator(Operon::Problem& problem)
+    // signatureSize > 0 estimates the mean distances from MinHash signatures (see Distance::MeanJaccardMinHash)
+    // instead of computing all the pairwise distances, which scales to large populations
+    explicit DiversityEvaluator(Operon::Problem& problem, size_t signatureSize = 0)
         : EvaluatorBase(problem)
+        , signatureSize_(signatureSize)
+    {
+    }
+
+    // the behavioural diversity instead: the distances of the outputs estimated from their sketches (not owned, the
+    // evaluator of the error should record them, see SemanticSketch)
+    DiversityEvaluator(Operon::Problem& problem, SemanticSketch const& sketch)
+        : EvaluatorBase(problem)
+        , semantic_(&sketch)
     {
     }
 
@@ -251,10 +738,17 @@ public:
     operator()(Operon::RandomGenerator& /*random*/, Individual& ind, Operon::Span<Operon::Scalar> buf) const -> typename EvaluatorBase::ReturnType override;
 
     auto Prepare(Operon::Span<Operon::Individual const> pop) const -> void override;
+    // the trees are hashed in parallel, before the distances are computed
+    auto Prepare(tf::Subflow& subflow, Operon::Span<Operon::Individual const> pop) const -> void override;
 
 private:
+    auto HashTree(Operon::Individual const& ind, std::vector<Operon::Hash>& hashes) const -> void;
+    auto UpdateDistances(Operon::Span<Operon::Individual const> pop) const -> void;
+
     mutable robin_hood::unordered_flat_map<size_t, Operon::Scalar> divmap_;
     mutable std::vector<std::vector<Operon::Hash>> hashes_;
+    size_t signatureSize_{0};
+    SemanticSketch const* semantic_{nullptr};
 };
 
 } // namespace Operon
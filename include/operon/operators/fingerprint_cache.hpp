@@ -0,0 +1,58 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_FINGERPRINT_CACHE_HPP
+#define OPERON_FINGERPRINT_CACHE_HPP
+
+#include <optional>
+
+#include "operon/core/dataset.hpp"
+#include "operon/core/problem.hpp"
+#include "operon/core/tree.hpp"
+#include "operon/core/types.hpp"
+#include "operon/interpreter/interpreter.hpp"
+#include "operon/operators/fitness_cache.hpp"
+#include "operon/operon_export.hpp"
+
+namespace Operon {
+
+// concurrent cache mapping semantic fingerprints to fitness values, used to skip the evaluation of offspring which
+// are semantically equivalent to an evaluated model while being structurally different (e.g. x + 0 and x)
+// - the fingerprint of a tree is the hash of its outputs on a small fixed sample of the training rows (evenly spaced),
+//   quantized to the leading mantissa bits so the rounding differences of equivalent expressions do not matter
+// - with linear scaling the outputs are standardized first, since trees differing by a scale and an offset have the
+//   same fitness after scaling
+// - the fitted coefficients are stored with the fitness: with local optimization a hit is only taken if the tree has
+//   as many coefficients as the cached one, which are then restored in their order (see Evaluator::Evaluate)
+// - it is a heuristic: two trees agreeing on the sample may differ elsewhere, and with local optimization the cached
+//   fitness is the one reached from the coefficients of the first tree. a larger sample lowers the false positives
+class OPERON_EXPORT FingerprintCache {
+public:
+    static constexpr size_t DefaultRows = 32;
+    static constexpr int MantissaBits = 16;
+
+    explicit FingerprintCache(Problem const& problem, size_t rows = DefaultRows, size_t capacity = FitnessCache::DefaultCapacity);
+
+    // the fingerprint of the tree, or nothing if an output on the sample is not finite
+    [[nodiscard]] auto Fingerprint(Interpreter const& interpreter, Tree const& tree, bool standardize) const -> std::optional<Operon::Hash>;
+
+    // returns true and fills in the fitness and the coefficients if the fingerprint is found
+    auto Find(Operon::Hash fingerprint, Operon::FitnessVector& fitness, Operon::Vector<Operon::Scalar>& coefficients) const -> bool;
+    void Insert(Operon::Hash fingerprint, Operon::Span<Operon::Scalar const> fitness, Operon::Span<Operon::Scalar const> coefficients);
+
+    void Clear() { table_.Clear(); }
+
+    [[nodiscard]] auto Rows() const -> size_t { return static_cast<size_t>(sample_.Rows()); }
+    [[nodiscard]] auto Capacity() const -> size_t { return table_.Capacity(); }
+    [[nodiscard]] auto Size() const -> size_t { return table_.Size(); }
+    [[nodiscard]] auto Hits() const -> size_t { return table_.Hits(); }
+    [[nodiscard]] auto Misses() const -> size_t { return table_.Misses(); }
+
+private:
+    Dataset sample_; // the sampled training rows, with the variables of the problem
+    FitnessCache table_;
+};
+
+} // namespace Operon
+
+#endif
@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_FITNESS_CACHE_HPP
+#define OPERON_FITNESS_CACHE_HPP
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <robin_hood.h>
+
+#include "operon/core/types.hpp"
+#include "operon/operon_export.hpp"
+
+namespace Operon {
+
+// concurrent bounded cache mapping tree hash values (computed in HashMode::Strict) to fitness values and
+// (optimized) coefficients. the cache is split into shards, each with its own lock, and uses CLOCK eviction
+class OPERON_EXPORT FitnessCache {
+public:
+    static constexpr size_t DefaultCapacity = 1UL << 16U;
+    static constexpr size_t ShardCount = 64;
+
+    explicit FitnessCache(size_t capacity = DefaultCapacity);
+
+    // returns true and fills in the fitness and coefficients if the hash is found
+    auto Find(Operon::Hash hash, Operon::FitnessVector& fitness, Operon::Vector<Operon::Scalar>& coefficients) const -> bool;
+
+    void Insert(Operon::Hash hash, Operon::Span<Operon::Scalar const> fitness, Operon::Span<Operon::Scalar const> coefficients);
+    // like Insert, except that an existing entry is only replaced by a smaller (better) first fitness value
+    void InsertBest(Operon::Hash hash, Operon::Span<Operon::Scalar const> fitness, Operon::Span<Operon::Scalar const> coefficients);
+
+    void Clear();
+
+    [[nodiscard]] auto Capacity() const -> size_t { return ShardCount * shardCapacity_; }
+    [[nodiscard]] auto Size() const -> size_t;
+    [[nodiscard]] auto Hits() const -> size_t { return hits_; }
+    [[nodiscard]] auto Misses() const -> size_t { return misses_; }
+
+private:
+    struct Entry {
+        Operon::Hash Key{0};
+        Operon::FitnessVector Fitness;
+        Operon::Vector<Operon::Scalar> Coefficients;
+        bool Occupied{false};
+        mutable bool Referenced{false}; // only accessed while holding the shard lock
+    };
+
+    struct Shard {
+        mutable std::mutex Mutex;
+        Operon::Vector<Entry> Entries;
+        robin_hood::unordered_flat_map<Operon::Hash, size_t> Index;
+        size_t Hand{0};
+    };
+
+    [[nodiscard]] auto GetShard(Operon::Hash hash) const -> Shard& { return shards_[hash % ShardCount]; }
+    void Store(Operon::Hash hash, Operon::Span<Operon::Scalar const> fitness, Operon::Span<Operon::Scalar const> coefficients, bool best);
+
+    size_t shardCapacity_;
+    mutable std::array<Shard, ShardCount> shards_;
+    mutable std::atomic_ulong hits_{0};
+    mutable std::atomic_ulong misses_{0};
+};
+
+} // namespace Operon
+
+#endif
@@ -4,15 +4,116 @@
 #ifndef OPERON_GENERATOR_HPP
 #define OPERON_GENERATOR_HPP
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <vector>
+
 #include "operon/core/operator.hpp"
 #include "operon/operators/crossover.hpp"
 #include "operon/operators/evaluator.hpp"
 #include "operon/operators/mutation.hpp"
 #include "operon/operators/selector.hpp"
+#include "operon/operators/surrogate.hpp"
 
 namespace Operon {
 
-class OffspringGeneratorBase : public OperatorBase<std::optional<Individual>, /* crossover prob. */ double, /* mutation prob. */ double, /* memory buffer */ Operon::Span<Operon::Scalar>> {
+// the outcome of the offspring filter in a generation (between two calls to Prepare)
+struct OffspringFilterStatistics {
+    size_t Checked{0};   // children checked before their evaluation
+    size_t Oversized{0}; // longer or deeper than the quota
+    size_t Tarpeian{0};  // longer than the average parent and discarded by chance
+    size_t Clones{0};    // identical to a parent (same strict hash)
+    size_t Forced{0};    // accepted despite a verdict, after MaxRetries rejections in a row
+
+    // the evaluations saved
+    [[nodiscard]] auto Rejected() const -> size_t { return Oversized + Tarpeian + Clones; }
+
+    auto operator+=(OffspringFilterStatistics const& rhs) -> OffspringFilterStatistics&
+    {
+        Checked += rhs.Checked;
+        Oversized += rhs.Oversized;
+        Tarpeian += rhs.Tarpeian;
+        Clones += rhs.Clones;
+        Forced += rhs.Forced;
+        return *this;
+    }
+};
+
+// cheap checks of the varied children before their evaluation, which discard the children the reinserter or the
+// offspring selection would discard anyway after evaluating them (all the checks are disabled by default)
+// - a length and depth quota
+// - tarpeian bloat control (Poli, 2003): the children longer than the average parent are discarded with the tarpeian
+//   probability
+// - clones: the children with the same strict hash as one of the parents
+// a worker whose children were rejected MaxRetries times in a row accepts the next one regardless (e.g. when the
+// population converged and mutation is disabled every child is a clone), so a generation always completes
+class OPERON_EXPORT OffspringFilter {
+public:
+    enum class Verdict : uint8_t { Accepted, Oversized, Tarpeian, Clone };
+
+    void MaxLength(size_t value) { maxLength_ = value; }
+    [[nodiscard]] auto MaxLength() const -> size_t { return maxLength_; }
+
+    void MaxDepth(size_t value) { maxDepth_ = value; }
+    [[nodiscard]] auto MaxDepth() const -> size_t { return maxDepth_; }
+
+    void TarpeianProbability(double value) { EXPECT(value >= 0 && value <= 1); tarpeianProbability_ = value; }
+    [[nodiscard]] auto TarpeianProbability() const -> double { return tarpeianProbability_; }
+
+    void RejectClones(bool value) { rejectClones_ = value; }
+    [[nodiscard]] auto RejectClones() const -> bool { return rejectClones_; }
+
+    void MaxRetries(size_t value) { maxRetries_ = value; }
+    [[nodiscard]] auto MaxRetries() const -> size_t { return maxRetries_; }
+
+    [[nodiscard]] auto Enabled() const -> bool
+    {
+        return maxLength_ != std::numeric_limits<size_t>::max() || maxDepth_ != std::numeric_limits<size_t>::max() || tarpeianProbability_ > 0 || rejectClones_;
+    }
+
+    // starts a generation: averages the lengths of the parents and, to detect the clones, hashes them. the statistics
+    // of the previous generation are kept (see LastStatistics) and the counters reset
+    void Prepare(Operon::Span<Individual const> pop) const;
+
+    // safe to call concurrently, hashes the child if the clones are rejected
+    auto operator()(Operon::RandomGenerator& random, Tree const& child) const -> Verdict;
+
+    // the statistics of the current and of the previous generation, and of all the generations so far
+    [[nodiscard]] auto Statistics() const -> OffspringFilterStatistics;
+    [[nodiscard]] auto LastStatistics() const -> OffspringFilterStatistics const& { return last_; }
+    [[nodiscard]] auto TotalStatistics() const -> OffspringFilterStatistics
+    {
+        auto stats = total_;
+        stats += Statistics();
+        return stats;
+    }
+
+    static constexpr size_t DefaultMaxRetries { 100 };
+
+private:
+    size_t maxLength_{std::numeric_limits<size_t>::max()};
+    size_t maxDepth_{std::numeric_limits<size_t>::max()};
+    double tarpeianProbability_{0};
+    bool rejectClones_{false};
+    size_t maxRetries_{DefaultMaxRetries};
+
+    // set by Prepare
+    mutable double averageLength_{0};
+    mutable std::vector<Operon::Hash> hashes_; // sorted
+    mutable OffspringFilterStatistics last_;
+    mutable OffspringFilterStatistics total_;
+
+    mutable std::atomic_size_t checked_{0};
+    mutable std::atomic_size_t oversized_{0};
+    mutable std::atomic_size_t tarpeian_{0};
+    mutable std::atomic_size_t clones_{0};
+    mutable std::atomic_size_t forced_{0};
+};
+
+class OPERON_EXPORT OffspringGeneratorBase : public OperatorBase<std::optional<Individual>, /* crossover prob. */ double, /* mutation prob. */ double, /* memory buffer */ Operon::Span<Operon::Scalar>> {
 public:
     OffspringGeneratorBase(EvaluatorBase& eval, CrossoverBase& cx, MutatorBase& mut, SelectorBase& femSel, SelectorBase& maleSel)
         : evaluator_(eval)
@@ -28,6 +129,20 @@ public:
     [[nodiscard]] auto Crossover() const -> CrossoverBase& { return crossover_.get(); }
     [[nodiscard]] auto Mutator() const -> MutatorBase& { return mutator_.get(); }
     [[nodiscard]] auto Evaluator() const -> EvaluatorBase& { return evaluator_.get(); }
+    [[nodiscard]] auto Filter() -> OffspringFilter& { return filter_; }
+    [[nodiscard]] auto Filter() const -> OffspringFilter const& { return filter_; }
+
+    // optional screening tier (not owned): the generators comparing several candidates (see BroodOffspringGenerator
+    // and OffspringSelectionGenerator) only evaluate the candidates promoted by the screening, the other generators
+    // ignore it. the screening is prepared with the other operators
+    void SetScreening(ScreeningEvaluator const* screening) { screening_ = screening; }
+    [[nodiscard]] auto Screening() const -> ScreeningEvaluator const* { return screening_; }
+
+    // optional surrogate model of the fitness (not owned), used like the screening to discard the clearly poor
+    // candidates and updated by their exact evaluations. its predictions are counted by the evaluator
+    // (see EvaluatorBase::SurrogateEvaluations)
+    void SetSurrogate(SurrogateModel* surrogate) { surrogate_ = surrogate; }
+    [[nodiscard]] auto Surrogate() const -> SurrogateModel* { return surrogate_; }
 
     // this method is necessary in order to avoid a code smell (default function arguments of virtual method)
     auto operator()(Operon::RandomGenerator& random, double pCrossover, double pMutation) const -> std::optional<Individual>
@@ -42,20 +157,87 @@ public:
         return (*base)(random, pCrossover, pMutation, buf);
     };
 
+    // generates an offspring into the given slot (e.g. an element of the offspring array of the algorithm), returns
+    // false if no offspring was produced. the parents are only referenced and the accepted child is moved into (or
+    // built in) the slot, whose genotype is overwritten: the callers release it first, to reuse its nodes
+    virtual auto Generate(Operon::RandomGenerator& random, double pCrossover, double pMutation, Operon::Span<Operon::Scalar> buf, Individual& slot) const -> bool
+    {
+        auto result = (*this)(random, pCrossover, pMutation, buf);
+        if (!result.has_value()) { return false; }
+        slot = std::move(result.value());
+        return true;
+    }
+
     virtual auto Prepare(Operon::Span<Individual const> pop) const -> void
     {
+        filter_.Prepare(pop);
         this->FemaleSelector().Prepare(pop);
         this->MaleSelector().Prepare(pop);
         this->Evaluator().Prepare(pop);
+        if (screening_ != nullptr) { screening_->Prepare(pop); }
+        if (surrogate_ != nullptr) { surrogate_->Prepare(pop); }
     }
+
+    // prepares the selectors and the evaluator concurrently as tasks of the given subflow, each operator possibly
+    // splitting its own preparation (see SelectorBase::Prepare). the generator is ready once the subflow joins
+    // - the preparations of the operators have to be independent (e.g. an evaluator used by a lexicase selector
+    //   does not change in Prepare), a selector used for both parents is prepared once
+    // - the offspring filter hashes the parents before the operators are prepared, as some of them hash the parents too
+    virtual auto Prepare(tf::Subflow& subflow, Operon::Span<Individual const> pop) const -> void;
     [[nodiscard]] virtual auto Terminate() const -> bool { return evaluator_.get().BudgetExhausted(); }
 
+    // generators whose offspring do not depend on their evaluation can split the two steps, which lets the algorithms
+    // schedule the evaluations by their estimated cost (see EvaluatorBase::Cost)
+    [[nodiscard]] virtual auto Separable() const -> bool { return false; }
+    // variation without evaluation (only meaningful if the generator is separable)
+    virtual auto Vary(Operon::RandomGenerator& /*random*/, double /*pCrossover*/, double /*pMutation*/) const -> std::optional<Individual> { return std::nullopt; }
+
+    // evaluates the individual, non-finite fitness values are replaced by the largest representable value
+    auto Evaluate(Operon::RandomGenerator& random, Individual& ind, Operon::Span<Operon::Scalar> buf) const -> void
+    {
+        ind.Fitness = Evaluator()(random, ind, buf);
+        for (auto& v : ind.Fitness) {
+            if (!std::isfinite(v)) { v = std::numeric_limits<Operon::Scalar>::max(); }
+        }
+    }
+
+    // passes the varied child through the offspring filter before its evaluation, the nodes of a rejected child go
+    // back to the pool
+    auto Admit(Operon::RandomGenerator& random, Individual& child) const -> bool
+    {
+        if (!filter_.Enabled() || filter_(random, child.Genotype) == OffspringFilter::Verdict::Accepted) { return true; }
+        NodePool::Release(std::move(child.Genotype));
+        return false;
+    }
+
+    // asks the surrogate model (if any) about the child before its evaluation, the nodes of a clearly poor child go
+    // back to the pool. the features are kept to update the model with the exact fitness (see Learn)
+    auto Predict(Individual& child, Operon::Scalar parentFitness, std::optional<SurrogateModel::FeatureVector>& features) const -> bool
+    {
+        if (surrogate_ == nullptr) { return true; }
+        features = surrogate_->Features(child.Genotype, parentFitness);
+        Evaluator().IncrementSurrogateEvaluations();
+        if (!surrogate_->Discard(features)) { return true; }
+        NodePool::Release(std::move(child.Genotype));
+        return false;
+    }
+
+    auto Learn(std::optional<SurrogateModel::FeatureVector> const& features, Individual const& child) const -> void
+    {
+        if (surrogate_ != nullptr && features && !child.Fitness.empty()) { surrogate_->Update(*features, child[0]); }
+    }
+
 private:
+    auto PrepareOperators(tf::Subflow& subflow, Operon::Span<Individual const> pop) const -> void;
+
     std::reference_wrapper<EvaluatorBase> evaluator_;
     std::reference_wrapper<CrossoverBase> crossover_;
     std::reference_wrapper<MutatorBase> mutator_;
     std::reference_wrapper<SelectorBase> femaleSelector_;
     std::reference_wrapper<SelectorBase> maleSelector_;
+    OffspringFilter filter_;
+    ScreeningEvaluator const* screening_{nullptr};
+    SurrogateModel* surrogate_{nullptr};
 };
 
 class OPERON_EXPORT BasicOffspringGenerator final : public OffspringGeneratorBase {
@@ -66,8 +248,14 @@ public:
     }
 
     auto operator()(Operon::RandomGenerator& random, double pCrossover, double pMutation, Operon::Span<Operon::Scalar> buf) const -> std::optional<Individual> override;
+
+    [[nodiscard]] auto Separable() const -> bool override { return true; }
+    auto Vary(Operon::RandomGenerator& random, double pCrossover, double pMutation) const -> std::optional<Individual> override;
 };
 
+// generates a brood of children from the same parents and keeps the best one. with a screening tier (see
+// SetScreening) only the children promoted by the screening are evaluated, the best screened child always is. the
+// children discarded by the surrogate model (see SetSurrogate) are neither screened nor evaluated
 class OPERON_EXPORT BroodOffspringGenerator : public OffspringGeneratorBase {
 public:
     explicit BroodOffspringGenerator(EvaluatorBase& eval, CrossoverBase& cx, MutatorBase& mut, SelectorBase& femSel, SelectorBase& maleSel)
@@ -77,14 +265,24 @@ public:
     }
 
     auto operator()(Operon::RandomGenerator& random, double pCrossover, double pMutation, Operon::Span<Operon::Scalar> buf) const -> std::optional<Individual> override;
+    auto Generate(Operon::RandomGenerator& random, double pCrossover, double pMutation, Operon::Span<Operon::Scalar> buf, Individual& slot) const -> bool override;
 
     void BroodSize(size_t value) { broodSize_ = value; }
     [[nodiscard]] auto BroodSize() const -> size_t { return broodSize_; }
 
+    // generate and evaluate the brood in parallel on an executor owned by the generator (shared between copies), so
+    // that large or expensive broods use the cores left idle by the algorithm. zero or one thread (the default)
+    // generates the brood sequentially on the calling thread. every child draws from its own random stream, the
+    // brood does not depend on the number of threads
+    void BroodThreads(size_t value);
+    [[nodiscard]] auto BroodThreads() const -> size_t { return broodThreads_; }
+
     static constexpr size_t DefaultBroodSize { 10 };
 
 private:
     size_t broodSize_;
+    size_t broodThreads_{0};
+    std::shared_ptr<tf::Executor> executor_;
 };
 
 class OPERON_EXPORT PolygenicOffspringGenerator : public OffspringGeneratorBase {
@@ -96,6 +294,7 @@ public:
     }
 
     auto operator()(Operon::RandomGenerator& random, double pCrossover, double pMutation, Operon::Span<Operon::Scalar> buf) const -> std::optional<Individual> override;
+    auto Generate(Operon::RandomGenerator& random, double pCrossover, double pMutation, Operon::Span<Operon::Scalar> buf, Individual& slot) const -> bool override;
 
     void PolygenicSize(size_t value) { broodSize_ = value; }
     [[nodiscard]] auto PolygenicSize() const -> size_t { return broodSize_; }
@@ -106,17 +305,38 @@ private:
     size_t broodSize_;
 };
 
+// the outcome of the attempts of the offspring selection generator in a generation (between two calls to Prepare)
+struct OffspringSelectionStatistics {
+    size_t Attempts{0};  // attempts which claimed a ticket (see OffspringSelectionGenerator)
+    size_t Accepted{0};  // children which passed the comparison with their parents
+    size_t Lucky{0};     // children accepted without comparison, after the success quota was met
+    size_t Rejected{0};  // evaluated and rejected children: the wasted evaluations
+    size_t Cancelled{0}; // children discarded before their evaluation, after the attempts were exhausted
+    size_t Screened{0};  // children rejected by the screening tier, before their evaluation (see SetScreening)
+    size_t Predicted{0}; // children discarded by the surrogate model, before their evaluation (see SetSurrogate)
+};
+
+// generates children until one is better than its parents (see ComparisonFactor)
+// - the workers generating the offspring of a generation share a budget of MaxSelectionPressure times the population
+//   size attempts: every attempt claims a ticket (a single atomic increment) before it evaluates its child, so the
+//   budget is never overshot, and the first attempt without a ticket stops the generation (see Terminate). the
+//   children varied meanwhile are discarded without being evaluated
+// - once SuccessRatio times the population size children were accepted, the remaining children are accepted without
+//   comparison (the default ratio of one compares every child)
+// - with a screening tier (see SetScreening) the children compared with their parents are evaluated only if the
+//   screening promotes them, a child rejected by the screening uses its attempt without an evaluation (and so does a
+//   child discarded by the surrogate model, see SetSurrogate)
 class OPERON_EXPORT OffspringSelectionGenerator : public OffspringGeneratorBase {
 public:
     explicit OffspringSelectionGenerator(EvaluatorBase& eval, CrossoverBase& cx, MutatorBase& mut, SelectorBase& femSel, SelectorBase& maleSel)
         : OffspringGeneratorBase(eval, cx, mut, femSel, maleSel)
-        , lastEvaluations_(0)
         , maxSelectionPressure_(DefaultMaxSelectionPressure)
         , comparisonFactor_(1.0)
     {
     }
 
     auto operator()(Operon::RandomGenerator& random, double pCrossover, double pMutation, Operon::Span<Operon::Scalar> buf) const -> std::optional<Individual> override;
+    auto Generate(Operon::RandomGenerator& random, double pCrossover, double pMutation, Operon::Span<Operon::Scalar> buf, Individual& slot) const -> bool override;
 
     void MaxSelectionPressure(size_t value) { maxSelectionPressure_ = value; }
     auto MaxSelectionPressure() const -> size_t { return maxSelectionPressure_; }
@@ -124,34 +344,59 @@ public:
     void ComparisonFactor(double value) { comparisonFactor_ = value; }
     auto ComparisonFactor() const -> double { return comparisonFactor_; }
 
-    void Prepare(const Operon::Span<const Individual> pop) const override
-    {
-        OffspringGeneratorBase::Prepare(pop);
-        lastEvaluations_ = this->Evaluator().EvaluationCount();
-    }
+    void SuccessRatio(double value) { EXPECT(value >= 0 && value <= 1); successRatio_ = value; }
+    auto SuccessRatio() const -> double { return successRatio_; }
+
+    // starts a generation: the statistics of the previous one are kept (see LastStatistics) and the counters reset
+    void Prepare(const Operon::Span<const Individual> pop) const override;
+    void Prepare(tf::Subflow& subflow, Operon::Span<Individual const> pop) const override;
 
+    // attempts per individual of the population in the current generation
     auto SelectionPressure() const -> double
     {
-        auto n = this->FemaleSelector().Population().size();
-        if (n == 0U) {
+        if (size_ == 0U) {
             return 0;
         }
-        auto e = this->Evaluator().EvaluationCount() - lastEvaluations_;
-        return static_cast<double>(e) / static_cast<double>(n);
+        auto const attempts = std::min(attempts_.load(std::memory_order_relaxed), maxAttempts_);
+        return static_cast<double>(attempts) / static_cast<double>(size_);
     }
 
     auto Terminate() const -> bool override
     {
-        return OffspringGeneratorBase::Terminate() || SelectionPressure() > static_cast<double>(maxSelectionPressure_);
+        return OffspringGeneratorBase::Terminate() || exhausted_.load(std::memory_order_relaxed);
     };
 
+    // the statistics of the current and of the previous generation
+    [[nodiscard]] auto Statistics() const -> OffspringSelectionStatistics;
+    [[nodiscard]] auto LastStatistics() const -> OffspringSelectionStatistics const& { return last_; }
+
     static constexpr size_t DefaultMaxSelectionPressure { 100 };
     static constexpr double DefaultComparisonFactor { 1.0 };
 
 private:
-    mutable size_t lastEvaluations_;
+    static constexpr size_t CacheLine = 64;
+
+    void Reset(size_t size) const;
+
     size_t maxSelectionPressure_;
     double comparisonFactor_;
+    double successRatio_{1.0};
+
+    // set by Prepare
+    mutable size_t size_{0};
+    mutable size_t maxAttempts_{std::numeric_limits<size_t>::max()};
+    mutable size_t quota_{std::numeric_limits<size_t>::max()};
+    mutable OffspringSelectionStatistics last_;
+
+    // claimed by every attempt, on its own cache line
+    alignas(CacheLine) mutable std::atomic_size_t attempts_{0};
+    alignas(CacheLine) mutable std::atomic_size_t accepted_{0};
+    mutable std::atomic_size_t lucky_{0};
+    mutable std::atomic_size_t rejected_{0};
+    mutable std::atomic_size_t cancelled_{0};
+    mutable std::atomic_size_t screened_{0};
+    mutable std::atomic_size_t predicted_{0};
+    mutable std::atomic_bool exhausted_{false};
 };
 
 } // namespace Operon
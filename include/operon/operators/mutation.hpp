@@ -9,6 +9,7 @@
 #include "operon/core/operator.hpp"
 #include "operon/core/pset.hpp"
 #include "operon/core/tree.hpp"
+#include "operon/random/alias_table.hpp"
 
 namespace Operon {
 
@@ -85,6 +86,7 @@ struct OPERON_EXPORT MultiMutation : public MutatorBase {
     {
         operators_.push_back(std::ref(op));
         probabilities_.push_back(prob);
+        table_ = Random::AliasTable(Operon::Span<double const>(probabilities_));
     }
 
     [[nodiscard]] auto Count() const -> size_t { return operators_.size(); }
@@ -92,6 +94,7 @@ struct OPERON_EXPORT MultiMutation : public MutatorBase {
 private:
     std::vector<std::reference_wrapper<const MutatorBase>> operators_;
     std::vector<double> probabilities_;
+    Random::AliasTable table_; // the operator is sampled in constant time
 };
 
 struct OPERON_EXPORT ChangeVariableMutation : public MutatorBase {
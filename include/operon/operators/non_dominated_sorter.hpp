@@ -4,15 +4,21 @@
 #ifndef OPERON_OPERATORS_NONDOMINATED_SORTER_HPP
 #define OPERON_OPERATORS_NONDOMINATED_SORTER_HPP
 
+#include <memory>
+
 #include "operon/core/types.hpp"
 #include "operon/operon_export.hpp"
 
+namespace tf {
+class Executor;
+} // namespace tf
+
 namespace Operon {
 struct Individual;
 
 enum EfficientSortStrategy : int { Binary, Sequential };
 
-class NondominatedSorterBase {
+class OPERON_EXPORT NondominatedSorterBase {
 public:
     using Result = std::vector<std::vector<size_t>>;
 
@@ -30,46 +36,135 @@ public:
 
     virtual auto Sort(Operon::Span<Operon::Individual const>, Operon::Scalar) const -> Result = 0;
 
+    // sorts a row-major (n x m) fitness matrix, the rows are expected in the same (lexicographic) order as the
+    // individuals passed to the overload above. the sorters of the library read the rows in place, the default
+    // implementation (for the other sorters) copies them into individuals
+    virtual auto Sort(Operon::Span<Operon::Scalar const> fitness, size_t m, Operon::Scalar eps) const -> Result;
+
+    // incremental interface: the fronts of a row-major (n x m) fitness matrix are updated in place, rows are given by index
+    // - Insert adds row i and returns false (leaving the fronts unchanged) if an equal row is already part of the fronts
+    // - Remove takes row i out and moves the members of the subsequent fronts up as needed
+    // the default implementations throw, sorters supporting incremental updates also return true from IsIncremental
+    [[nodiscard]] virtual auto IsIncremental() const -> bool { return false; }
+    virtual auto Insert(Result& fronts, Operon::Span<Operon::Scalar const> fitness, size_t m, size_t i, Operon::Scalar eps) const -> bool;
+    virtual auto Remove(Result& fronts, Operon::Span<Operon::Scalar const> fitness, size_t m, size_t i, Operon::Scalar eps) const -> void;
+
     auto operator()(Operon::Span<Operon::Individual const> pop, Operon::Scalar eps = 0) const -> Result
     {
         return Sort(pop, eps);
     }
+
+    auto operator()(Operon::Span<Operon::Scalar const> fitness, size_t m, Operon::Scalar eps = 0) const -> Result
+    {
+        return Sort(fitness, m, eps);
+    }
+
+    NondominatedSorterBase() = default;
+    NondominatedSorterBase(NondominatedSorterBase const&) = default;
+    NondominatedSorterBase(NondominatedSorterBase&&) noexcept = default;
+    auto operator=(NondominatedSorterBase const&) -> NondominatedSorterBase& = default;
+    auto operator=(NondominatedSorterBase&&) noexcept -> NondominatedSorterBase& = default;
+    virtual ~NondominatedSorterBase() = default;
 };
 
 struct OPERON_EXPORT BestOrderSorter : public NondominatedSorterBase {
+    using NondominatedSorterBase::Sort;
     auto Sort(Operon::Span<Operon::Individual const> pop, Operon::Scalar eps) const -> NondominatedSorterBase::Result override;
 };
 
 struct OPERON_EXPORT DeductiveSorter : public NondominatedSorterBase {
     auto Sort(Operon::Span<Operon::Individual const> pop, Operon::Scalar eps) const -> NondominatedSorterBase::Result override;
+    auto Sort(Operon::Span<Operon::Scalar const> fitness, size_t m, Operon::Scalar eps) const -> NondominatedSorterBase::Result override;
 };
 
 struct OPERON_EXPORT DominanceDegreeSorter : public NondominatedSorterBase {
     auto Sort(Operon::Span<Operon::Individual const> pop, Operon::Scalar eps) const -> NondominatedSorterBase::Result override;
+    auto Sort(Operon::Span<Operon::Scalar const> fitness, size_t m, Operon::Scalar eps) const -> NondominatedSorterBase::Result override;
 };
 
 struct OPERON_EXPORT HierarchicalSorter : public NondominatedSorterBase {
     auto Sort(Operon::Span<Operon::Individual const> pop, Operon::Scalar eps) const -> NondominatedSorterBase::Result override;
+    auto Sort(Operon::Span<Operon::Scalar const> fitness, size_t m, Operon::Scalar eps) const -> NondominatedSorterBase::Result override;
 };
 
 struct OPERON_EXPORT EfficientBinarySorter : public NondominatedSorterBase {
     auto Sort(Operon::Span<Operon::Individual const> pop, Operon::Scalar eps) const -> NondominatedSorterBase::Result override;
+    auto Sort(Operon::Span<Operon::Scalar const> fitness, size_t m, Operon::Scalar eps) const -> NondominatedSorterBase::Result override;
 };
 
 struct OPERON_EXPORT EfficientSequentialSorter : public NondominatedSorterBase {
     auto Sort(Operon::Span<Operon::Individual const> pop, Operon::Scalar eps) const -> NondominatedSorterBase::Result override;
+    auto Sort(Operon::Span<Operon::Scalar const> fitness, size_t m, Operon::Scalar eps) const -> NondominatedSorterBase::Result override;
 };
 
 struct OPERON_EXPORT MergeSorter : public NondominatedSorterBase {
     auto Sort(Operon::Span<Operon::Individual const> pop, Operon::Scalar eps) const -> NondominatedSorterBase::Result override;
+    auto Sort(Operon::Span<Operon::Scalar const> fitness, size_t m, Operon::Scalar eps) const -> NondominatedSorterBase::Result override;
+};
+
+// efficient non-domination level update (Li et al., 2015): the fronts are maintained under insertion and removal,
+// when a row is inserted the members it dominates are pushed down a front (cascading), when a row is removed the members
+// no longer dominated by the previous front move up. sorting inserts the (lexicographically sorted) rows one by one,
+// which amounts to ENS with sequential search since later rows can never dominate earlier ones.
+struct OPERON_EXPORT IncrementalSorter : public NondominatedSorterBase {
+    auto Sort(Operon::Span<Operon::Individual const> pop, Operon::Scalar eps) const -> NondominatedSorterBase::Result override;
+    auto Sort(Operon::Span<Operon::Scalar const> fitness, size_t m, Operon::Scalar eps) const -> NondominatedSorterBase::Result override;
+
+    [[nodiscard]] auto IsIncremental() const -> bool override { return true; }
+    auto Insert(Result& fronts, Operon::Span<Operon::Scalar const> fitness, size_t m, size_t i, Operon::Scalar eps) const -> bool override;
+    auto Remove(Result& fronts, Operon::Span<Operon::Scalar const> fitness, size_t m, size_t i, Operon::Scalar eps) const -> void override;
+};
+
+// efficient non-dominated sort with the dominance checks against the already ranked individuals done in parallel:
+// - the (lexicographically sorted) individuals are processed in blocks, since only earlier individuals can dominate later ones
+// - the individuals of a block are compared in parallel against the fronts of the previous blocks, then among each other
+// the executor is owned by the sorter (and shared between copies), so sorting can be called from within another taskflow
+class OPERON_EXPORT ParallelSorter : public NondominatedSorterBase {
+public:
+    explicit ParallelSorter(size_t threads = 0, size_t minBlockSize = DefaultMinBlockSize);
+
+    auto Sort(Operon::Span<Operon::Individual const> pop, Operon::Scalar eps) const -> NondominatedSorterBase::Result override;
+    auto Sort(Operon::Span<Operon::Scalar const> fitness, size_t m, Operon::Scalar eps) const -> NondominatedSorterBase::Result override;
+
+    static constexpr size_t DefaultMinBlockSize = 256;
+
+private:
+    std::shared_ptr<tf::Executor> executor_;
+    size_t minBlockSize_;
 };
 
 struct OPERON_EXPORT RankOrdinalSorter : public NondominatedSorterBase {
     auto Sort(Operon::Span<Operon::Individual const> pop, Operon::Scalar eps) const -> NondominatedSorterBase::Result override;
+    auto Sort(Operon::Span<Operon::Scalar const> fitness, size_t m, Operon::Scalar eps) const -> NondominatedSorterBase::Result override;
 };
 
 struct OPERON_EXPORT RankIntersectSorter : public NondominatedSorterBase {
     auto Sort(Operon::Span<Operon::Individual const> pop, Operon::Scalar eps) const -> NondominatedSorterBase::Result override;
+    auto Sort(Operon::Span<Operon::Scalar const> fitness, size_t m, Operon::Scalar eps) const -> NondominatedSorterBase::Result override;
+};
+
+// rank intersect with the dominance sets of the individuals as the rows of one contiguous bit matrix (see BitMatrix)
+// instead of a separately allocated bitset per individual, which gives the same fronts
+// - the rows are processed in tiles of at most tileBytes (but at least one block of rows), so the memory stays bounded
+//   for large populations; every tile sweeps the sorted objectives once more
+// - a tile starts at a block boundary and stores only the columns from there on, since the individuals before a row
+//   cannot be dominated by it
+class OPERON_EXPORT RankIntersectMatrixSorter : public NondominatedSorterBase {
+public:
+    explicit RankIntersectMatrixSorter(size_t tileBytes = DefaultTileBytes)
+        : tileBytes_(tileBytes)
+    {
+    }
+
+    auto Sort(Operon::Span<Operon::Individual const> pop, Operon::Scalar eps) const -> NondominatedSorterBase::Result override;
+    auto Sort(Operon::Span<Operon::Scalar const> fitness, size_t m, Operon::Scalar eps) const -> NondominatedSorterBase::Result override;
+
+    static constexpr size_t DefaultTileBytes = 256UL << 20U; // NOLINT
+
+    [[nodiscard]] auto TileBytes() const -> size_t { return tileBytes_; }
+
+private:
+    size_t tileBytes_;
 };
 
 } // namespace Operon
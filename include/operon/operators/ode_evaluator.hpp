@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_ODE_EVALUATOR_HPP
+#define OPERON_ODE_EVALUATOR_HPP
+
+#include <vector>
+
+#include "operon/operators/evaluator.hpp"
+
+namespace Operon {
+
+enum class OdeMethod : int { RK4, RK45 };
+
+struct OdeOptions {
+    static constexpr Operon::Scalar DefaultTolerance = 1e-6;
+    static constexpr size_t DefaultMaxSteps = 1000;
+
+    OdeMethod Method { OdeMethod::RK4 };
+    size_t Substeps { 1 };                               // rk4 steps between two rows
+    Operon::Scalar Tolerance { DefaultTolerance };       // rk45 local error tolerance (relative and absolute)
+    size_t MaxSteps { DefaultMaxSteps };                 // rk45 steps per trajectory before giving up
+};
+
+// integrates a system of ordinary differential equations dx/dt = f(x, u), one tree per state, over a set of
+// trajectories (ranges of consecutive dataset rows, sampled every step time units)
+// - every trajectory starts from the state observed in its first row, the inputs u (the variables which are not states)
+//   are interpolated linearly between the rows
+// - the trajectories are integrated together: their current states are the rows of a scratch dataset, so every stage of
+//   the solver is a single interpreter call per tree over all the trajectories (which the interpreter vectorizes)
+// - rk4 takes a fixed number of steps between two rows. rk45 (dormand-prince) adapts a step shared by all the
+//   trajectories to the largest local error among them, and never steps over a row
+// - the forward sensitivities of the first state with respect to the coefficients of the first tree are integrated
+//   alongside the states, the jacobians of the right-hand sides come from the reverse mode of the interpreter
+class OPERON_EXPORT OdeIntegrator {
+public:
+    OdeIntegrator(Interpreter const& interpreter, Dataset const& dataset, std::vector<Range> trajectories, Operon::Scalar step, OdeOptions options = {});
+
+    // the predicted values of states[0] at every row of the trajectories (concatenated), and optionally their
+    // sensitivities (Rows() times the coefficients of rhs[0], column major). non-empty parameters replace the
+    // coefficients of rhs[0]. returns false if the integration failed (non-finite states, step limit, or sensitivities
+    // requested for trees without reverse mode support)
+    auto Integrate(Operon::Span<Operon::Hash const> states, Operon::Span<TreeView const> rhs, Operon::Span<Operon::Scalar const> parameters, Operon::Span<Operon::Scalar> result, Operon::Scalar* sensitivities = nullptr) const -> bool;
+
+    // the concatenated values of a variable over the trajectories, in the order of Integrate
+    [[nodiscard]] auto Observed(Operon::Hash variable) const -> Operon::Vector<Operon::Scalar>;
+
+    [[nodiscard]] auto Rows() const -> size_t { return rows_; }
+    [[nodiscard]] auto Trajectories() const -> std::vector<Range> const& { return trajectories_; }
+    [[nodiscard]] auto Step() const -> Operon::Scalar { return step_; }
+    [[nodiscard]] auto Options() const -> OdeOptions const& { return options_; }
+
+private:
+    std::reference_wrapper<Interpreter const> interpreter_;
+    std::reference_wrapper<Dataset const> dataset_;
+    std::vector<Range> trajectories_;
+    Operon::Scalar step_;
+    OdeOptions options_;
+    size_t rows_ { 0 };
+};
+
+// evaluates the individuals as the right-hand side of the target variable, dx/dt = f(x, u): the fitness is the error
+// of the integrated trajectories (see OdeIntegrator) against the observed target values, without linear scaling
+// - the other states are given by SetSystem and integrated together with the target, the variables which are not
+//   states are inputs
+// - the trajectories default to the training range as a single trajectory
+// - the local optimization fits the coefficients to the trajectories (ceres::TinySolver on the forward sensitivities)
+class OPERON_EXPORT OdeEvaluator : public EvaluatorBase {
+public:
+    OdeEvaluator(Problem& problem, Interpreter& interp, Operon::Scalar step, ErrorMetric const& error = MSE{})
+        : EvaluatorBase(problem)
+        , interpreter_(interp)
+        , error_(error)
+        , step_(step)
+    {
+        EXPECT(step > 0);
+    }
+
+    auto GetInterpreter() -> Interpreter& { return interpreter_; }
+    auto GetInterpreter() const -> Interpreter const& { return interpreter_; }
+
+    void SetTrajectories(std::vector<Range> trajectories) { trajectories_ = std::move(trajectories); }
+    [[nodiscard]] auto Trajectories() const -> std::vector<Range>;
+
+    // the right-hand sides of the other states of the system
+    void SetSystem(std::vector<Operon::Hash> states, std::vector<Tree> rhs)
+    {
+        EXPECT(states.size() == rhs.size());
+        states_ = std::move(states);
+        system_ = std::move(rhs);
+    }
+
+    void SetOptions(OdeOptions options) { options_ = options; }
+    [[nodiscard]] auto Options() const -> OdeOptions const& { return options_; }
+    [[nodiscard]] auto Step() const -> Operon::Scalar { return step_; }
+
+    auto
+    operator()(Operon::RandomGenerator& /*random*/, Individual& ind, Operon::Span<Operon::Scalar> buf) const -> typename EvaluatorBase::ReturnType override;
+
+    auto BufferSize() const -> size_t override;
+
+private:
+    std::reference_wrapper<Interpreter> interpreter_;
+    std::reference_wrapper<ErrorMetric const> error_;
+    Operon::Scalar step_;
+    OdeOptions options_;
+    std::vector<Range> trajectories_;
+    std::vector<Operon::Hash> states_;
+    std::vector<Tree> system_;
+};
+
+} // namespace Operon
+
+#endif
@@ -5,11 +5,17 @@
 #define OPERON_REINSERTER_HPP
 
 #include <algorithm>
+#include <functional>
+#include <vector>
+
+#include "operon/core/hypervolume.hpp"
 #include "operon/core/operator.hpp"
 #include "operon/core/individual.hpp"
 
 namespace Operon {
-class ReinserterBase : public OperatorBase<void, Operon::Span<Individual>, Operon::Span<Individual>> {
+class NondominatedSorterBase;
+
+class OPERON_EXPORT ReinserterBase : public OperatorBase<void, Operon::Span<Individual>, Operon::Span<Individual>> {
 public:
     explicit ReinserterBase(ComparisonCallback cb)
         : comp_(std::move(cb))
@@ -23,8 +29,26 @@ public:
         return comp_(lhs, rhs);
     }
 
+    // when a key is set, the reinserters compare precomputed keys instead of calling the comparison callback
+    void SetKey(KeyCallback key) { key_ = std::move(key); }
+    [[nodiscard]] auto HasKeys() const -> bool { return static_cast<bool>(key_); }
+
+protected:
+    // partitions the individuals of the concatenation a + b: afterwards the first n positions of Indices()
+    // refer to the n best individuals (indices >= a.size() refer to b). only the index array is permuted.
+    void Partition(Operon::Span<Individual const> a, Operon::Span<Individual const> b, size_t n) const;
+
+    // keeps the individuals of pop + pool at the first |pop| positions of Indices() (a permutation of pop + pool):
+    // the pool individuals among them are swapped with the population individuals which are not
+    void Exchange(Operon::Span<Individual> pop, Operon::Span<Individual> pool) const;
+
+    [[nodiscard]] auto Indices() const -> std::vector<size_t>& { return indices_; }
+
 private:
     ComparisonCallback comp_;
+    KeyCallback key_;
+    mutable std::vector<size_t> indices_;
+    mutable std::vector<ComparisonKey> keys_;
 };
 
 class OPERON_EXPORT KeepBestReinserter : public ReinserterBase {
@@ -34,23 +58,9 @@ public:
     {
     }
     // keep the best |pop| individuals from pop+pool
-    void operator()(Operon::RandomGenerator& /*random*/, Operon::Span<Individual> pop, Operon::Span<Individual> pool) const override
-    {
-        // sort the population and the recombination pool
-        Sort(pop);
-        Sort(pool);
-
-        // merge the best individuals from pop+pool into pop
-        size_t i = 0;
-        size_t j = 0;
-        while (i < pool.size() && j < pop.size()) {
-            if (Compare(pool[i], pop[j])) {
-                std::swap(pool[i], pop[j]);
-                ++i;
-            }
-            ++j;
-        }
-    }
+    // the best |pop| are found by partial selection over indices, then only the pool individuals which make
+    // the cut are swapped with the population individuals which do not
+    void operator()(Operon::RandomGenerator& /*random*/, Operon::Span<Individual> pop, Operon::Span<Individual> pool) const override;
 };
 
 class OPERON_EXPORT ReplaceWorstReinserter : public ReinserterBase {
@@ -60,17 +70,24 @@ public:
     {
     }
     // replace the worst individuals in pop with the best individuals from pool
-    void operator()(Operon::RandomGenerator& /*random*/, Operon::Span<Individual> pop, Operon::Span<Individual> pool) const override
+    void operator()(Operon::RandomGenerator& /*random*/, Operon::Span<Individual> pop, Operon::Span<Individual> pool) const override;
+};
+
+// indicator based reinsertion (as in SMS-EMOA): the fronts of pop+pool are kept in order of their rank, the individuals
+// of the front which does not fit completely are dropped one at a time by their smallest hypervolume contribution
+class OPERON_EXPORT HypervolumeReinserter : public ReinserterBase {
+public:
+    explicit HypervolumeReinserter(ComparisonCallback const& cb, NondominatedSorterBase const& sorter, size_t samples = Hypervolume::DefaultSamples)
+        : ReinserterBase(cb)
+        , sorter_(sorter)
+        , samples_(samples)
     {
-        // typically the pool and the population are the same size
-        if (pop.size() > pool.size()) {
-            Sort(pop);
-        } else if (pop.size() < pool.size()) {
-            Sort(pool);
-        }
-        auto offset = static_cast<std::ptrdiff_t>(std::min(pop.size(), pool.size()));
-        std::swap_ranges(pool.begin(), pool.begin() + offset, pop.end() - offset);
     }
+    void operator()(Operon::RandomGenerator& random, Operon::Span<Individual> pop, Operon::Span<Individual> pool) const override;
+
+private:
+    std::reference_wrapper<NondominatedSorterBase const> sorter_;
+    size_t samples_;
 };
 
 } // namespace Operon
@@ -4,15 +4,28 @@
 #ifndef OPERON_SELECTOR_HPP
 #define OPERON_SELECTOR_HPP
 
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
 #include "operon/core/individual.hpp"
 #include "operon/core/operator.hpp"
+#include "operon/operon_export.hpp"
+
+namespace tf {
+class Subflow;
+} // namespace tf
 
 namespace Operon {
+class Evaluator;
+
 // the selector a vector of individuals and returns the index of a selected individual per each call of operator()
 // this operator is meant to be a lightweight object that is initialized with a population and some other parameters on-the-fly
-class SelectorBase : public OperatorBase<size_t> {
+class OPERON_EXPORT SelectorBase : public OperatorBase<size_t> {
 public:
     using SelectableType = Individual;
+    using Key = ComparisonKey;
 
     SelectorBase()
         : comp_(nullptr)
@@ -32,18 +45,47 @@ public:
     virtual void Prepare(Operon::Span<Individual const> pop) const
     {
         this->population_ = Operon::Span<const Individual>(pop);
+        if (key_) {
+            keys_.resize(pop.size());
+            std::transform(pop.begin(), pop.end(), keys_.begin(), key_);
+        }
     };
 
+    // schedules the preparation as tasks of the given subflow, so that it runs concurrently with the preparation of
+    // the other operators (see OffspringGeneratorBase::Prepare). the default is a single task calling Prepare(pop),
+    // the selectors with expensive bookkeeping split it into parallel tasks. the state is ready once the subflow joins
+    virtual void Prepare(tf::Subflow& subflow, Operon::Span<Individual const> pop) const;
+
+    // draws a batch of selections (as many as the size of the output span)
+    virtual void Select(Operon::RandomGenerator& random, Operon::Span<size_t> selected) const
+    {
+        for (auto& s : selected) { s = (*this)(random); }
+    }
+
     auto Population() const -> Operon::Span<Individual const> { return population_; }
 
+    // when a key is set, Prepare extracts the keys of the population once per generation and the
+    // comparisons use the keys instead of the comparison callback
+    void SetKey(KeyCallback key) { key_ = std::move(key); }
+    [[nodiscard]] auto HasKeys() const -> bool { return static_cast<bool>(key_); }
+    [[nodiscard]] auto Keys() const -> Operon::Span<Key const> { return { keys_.data(), keys_.size() }; }
+
     [[nodiscard]] inline auto Compare(Individual const& lhs, Individual const& rhs) const -> bool
     {
         return comp_(lhs, rhs);
     }
 
+    // compares the individuals at the given population indices, using the keys if available
+    [[nodiscard]] inline auto Compare(size_t lhs, size_t rhs) const -> bool
+    {
+        return key_ ? keys_[lhs] < keys_[rhs] : comp_(population_[lhs], population_[rhs]);
+    }
+
 private:
     mutable Operon::Span<const Individual> population_;
     ComparisonCallback comp_;
+    KeyCallback key_;
+    mutable std::vector<Key> keys_;
 };
 
 
@@ -59,6 +101,8 @@ public:
     { } 
 
     auto operator()(Operon::RandomGenerator& random) const -> size_t override;
+    void Select(Operon::RandomGenerator& random, Operon::Span<size_t> selected) const override;
+
     void SetTournamentSize(size_t size) { tournamentSize_ = size; }
     auto GetTournamentSize() const -> size_t { return tournamentSize_; }
 
@@ -75,7 +119,10 @@ public:
 
     auto operator()(Operon::RandomGenerator& random) const -> size_t override;
 
+    using SelectorBase::Prepare;
     void Prepare(Operon::Span<Individual const> pop) const override;
+    // sorts the population with a parallel sort
+    void Prepare(tf::Subflow& subflow, Operon::Span<Individual const> pop) const override;
 
     void SetTournamentSize(size_t size) { tournamentSize_ = size; }
     auto GetTournamentSize() const -> size_t { return tournamentSize_; }
@@ -94,6 +141,7 @@ public:
 
     auto operator()(Operon::RandomGenerator& random) const -> size_t override;
     
+    using SelectorBase::Prepare;
     void Prepare(Operon::Span<Individual const> pop) const override;
 
     void SetObjIndex(size_t objIndex) { idx_ = objIndex; }
@@ -107,11 +155,62 @@ private:
     size_t idx_ = 0;
 };
 
+// (epsilon-)lexicase selection on a random subset of the training rows (the cases), drawn anew by every Prepare
+// (downsampled lexicase, Hernandez et al. 2019)
+// - Prepare computes the absolute error of every individual on every case (see Evaluator::CaseErrors) into a matrix
+//   stored case by case, so a filtering step reads one contiguous row
+// - a selection filters the pool of candidates case by case in a random order, keeping those within epsilon of the
+//   best candidate on the case (semi-dynamic epsilon-lexicase, La Cava et al. 2019). epsilon is the median absolute
+//   deviation of the errors of the population on the case, or zero for plain lexicase
+// - while the pool is large it is a bitset and every step is a branchless pass over the row of the case, once it is
+//   small it becomes an array of indices and the steps only gather the errors of the candidates
+class OPERON_EXPORT LexicaseSelector : public SelectorBase {
+public:
+    static constexpr size_t DefaultCases = 64;
+
+    explicit LexicaseSelector(Evaluator const& evaluator, size_t cases = DefaultCases, Operon::RandomGenerator::result_type seed = 0)
+        : evaluator_(evaluator)
+        , cases_(cases)
+        , random_(seed)
+    {
+    }
+
+    auto operator()(Operon::RandomGenerator& random) const -> size_t override;
+
+    using SelectorBase::Prepare;
+    void Prepare(Operon::Span<Individual const> pop) const override;
+    // the errors are computed for blocks of individuals in parallel, then the epsilons for the cases in parallel (the
+    // result is the same as the one of the sequential Prepare)
+    void Prepare(tf::Subflow& subflow, Operon::Span<Individual const> pop) const override;
+
+    void SetCases(size_t cases) { cases_ = cases; }
+    auto GetCases() const -> size_t { return cases_; }
+
+    // use the median absolute deviation of the errors as epsilon (default), or select on exact equality
+    void SetEpsilon(bool value) { epsilon_ = value; }
+    auto GetEpsilon() const -> bool { return epsilon_; }
+
+    // the rows of the current cases and the errors of the population on case c
+    auto Rows() const -> Operon::Span<size_t const> { return { rows_.data(), rows_.size() }; }
+    auto Errors(size_t c) const -> Operon::Span<Operon::Scalar const> { return { errors_.data() + c * Population().size(), Population().size() }; }
+
+private:
+    void DrawCases() const;
+
+    std::reference_wrapper<Evaluator const> evaluator_;
+    size_t cases_;
+    bool epsilon_{true};
+    mutable Operon::RandomGenerator random_; // draws the cases
+    mutable std::vector<size_t> rows_;
+    mutable std::vector<Operon::Scalar> errors_;  // cases x individuals
+    mutable std::vector<Operon::Scalar> epsilons_; // per case
+};
+
 class OPERON_EXPORT RandomSelector : public SelectorBase {
 public:
     auto operator()(Operon::RandomGenerator& random) const -> size_t override
     {
-        return std::uniform_int_distribution<size_t>(0, Population().size() - 1)(random);
+        return Random::Bounded(random, Population().size());
     }
 };
 
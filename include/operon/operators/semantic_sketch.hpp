@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_SEMANTIC_SKETCH_HPP
+#define OPERON_SEMANTIC_SKETCH_HPP
+
+#include <atomic>
+#include <functional>
+#include <vector>
+
+#include "operon/core/dataset.hpp"
+#include "operon/core/individual.hpp"
+#include "operon/core/problem.hpp"
+#include "operon/core/tree.hpp"
+#include "operon/core/types.hpp"
+#include "operon/interpreter/interpreter.hpp"
+#include "operon/operators/fitness_cache.hpp"
+#include "operon/operon_export.hpp"
+
+namespace tf {
+class Subflow;
+} // namespace tf
+
+namespace Operon {
+
+// behavioural (output space) diversity of a population from random projections of the outputs of its models
+// - the sketch of a model is the projection of its outputs on a fixed sample of the training rows (evenly spaced) onto
+//   a few gaussian random directions, scaled so that the euclidean distance of two sketches estimates the root mean
+//   squared difference of the outputs on the sample (Johnson-Lindenstrauss, the relative error shrinks like
+//   1/sqrt(Dimensions))
+// - with linear scaling the outputs are scaled by least squares on the sample first, the distances are then those of
+//   the scaled predictions, in the units of the target (it should match the scaling of the evaluators recording them)
+// - the evaluators record the sketches of the models they evaluate from the outputs they computed anyway (see
+//   EvaluatorBase::SetSemanticSketch), keyed by the strict hash of the tree. Prepare looks up the sketches of the
+//   population, evaluates the sample for the missing ones, and reduces them in O(n * Dimensions): the mean squared
+//   distance of an individual to all the others and of all the pairs follow from the centered squared norms
+class OPERON_EXPORT SemanticSketch {
+public:
+    static constexpr size_t DefaultDimensions = 16;
+    static constexpr size_t DefaultRows = 256;
+
+    SemanticSketch(Problem const& problem, Interpreter const& interpreter, bool linearScaling = true, size_t dimensions = DefaultDimensions,
+        size_t rows = DefaultRows, uint64_t seed = 0, size_t capacity = FitnessCache::DefaultCapacity);
+
+    // the sketch of the outputs on the sampled rows, false if one of them is not finite
+    auto Project(Operon::Span<Operon::Scalar const> sample, Operon::Span<Operon::Scalar> sketch) const -> bool;
+
+    // the sketch of a tree, evaluated on the sampled rows
+    auto Sketch(Tree const& tree, Operon::Span<Operon::Scalar> sketch) const -> bool;
+
+    // records the sketch of a model from its outputs over the whole training range, thread-safe
+    void Record(Operon::Hash key, Operon::Span<Operon::Scalar const> estimated);
+    // records the sketch of a model by evaluating it on the sampled rows, thread-safe
+    void Record(Operon::Hash key, Tree const& tree);
+
+    // collects the sketches of the population and computes the diversity and the mean distances
+    void Prepare(Operon::Span<Individual const> pop) const;
+    // the sketches are collected in parallel, before the reduction
+    void Prepare(tf::Subflow& subflow, Operon::Span<Individual const> pop) const;
+
+    // the root mean squared distance over all the pairs of the population, zero for less than two valid sketches
+    [[nodiscard]] auto Diversity() const -> double { return diversity_; }
+    // the root mean squared distance of every individual to the others, the maximum value if its sketch is not valid
+    [[nodiscard]] auto MeanDistances() const -> Operon::Span<double const> { return { distances_.data(), distances_.size() }; }
+    // the approximate distance of the outputs of the individuals i and j of the prepared population
+    [[nodiscard]] auto Distance(size_t i, size_t j) const -> double;
+
+    [[nodiscard]] auto Dimensions() const -> size_t { return dimensions_; }
+    [[nodiscard]] auto Rows() const -> size_t { return sample_.Rows(); }
+
+    // since the construction: the sketches recorded by the evaluators, and the ones Prepare had to compute
+    [[nodiscard]] auto Recorded() const -> size_t { return recorded_; }
+    [[nodiscard]] auto Computed() const -> size_t { return computed_; }
+
+private:
+    auto Collect(Individual const& ind, size_t i) const -> void;
+    auto Reduce() const -> void;
+
+    Dataset sample_; // the sampled training rows
+    std::vector<size_t> rows_; // the offsets of the sampled rows in the training range
+    Operon::Vector<Operon::Scalar> target_; // the target values of the sampled rows
+    Operon::Vector<Operon::Scalar> directions_; // rows x dimensions, row-major
+    std::reference_wrapper<Interpreter const> interpreter_;
+    bool scaling_;
+    size_t dimensions_;
+    FitnessCache table_; // the sketches by tree hash
+
+    // updated in Prepare
+    mutable std::vector<Operon::Scalar> sketches_; // population size x dimensions
+    mutable std::vector<char> valid_;
+    mutable std::vector<double> distances_;
+    mutable double diversity_{0};
+
+    std::atomic_ulong recorded_{0};
+    mutable std::atomic_ulong computed_{0};
+};
+
+} // namespace Operon
+
+#endif
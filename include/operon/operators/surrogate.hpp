@@ -0,0 +1,124 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_SURROGATE_HPP
+#define OPERON_SURROGATE_HPP
+
+#include <Eigen/Core>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <optional>
+
+#include "operon/core/dataset.hpp"
+#include "operon/core/individual.hpp"
+#include "operon/core/node.hpp"
+#include "operon/core/problem.hpp"
+#include "operon/core/tree.hpp"
+#include "operon/core/types.hpp"
+#include "operon/interpreter/interpreter.hpp"
+#include "operon/operators/evaluator.hpp"
+#include "operon/operon_export.hpp"
+
+namespace Operon {
+
+// an online surrogate of the fitness (the first objective), used by the generators to discard the clearly poor
+// children before their exact evaluation (see OffspringGeneratorBase::SetSurrogate)
+// - the features of a child are cheap: its length and depth, the histogram of its primitives, its error on a small
+//   sample of the training rows (its semantic fingerprint, with the coefficients it inherited) and the fitness of its
+//   parents. their relation with the fitness is fitted by recursive least squares with exponential forgetting,
+//   updated by every exact evaluation of a child whose features were computed
+// - the updates are accumulated concurrently and published in Prepare, the predictions of a generation all use the
+//   same weights
+// - once MinSamples evaluations were observed, a child is discarded if its predicted fitness exceeds the Quantile of
+//   the fitness of the population by more than Margin times the root mean squared error of the predictions, or if its
+//   outputs on the sample are not finite
+// - the model only learns from the children it lets through, the margin keeps it from discarding the children it is
+//   least certain about
+class OPERON_EXPORT SurrogateModel {
+public:
+    // bias, length, depth, the node types, the sample error and the parent fitness
+    static constexpr size_t Dimension = 3 + NodeTypes::Count + 2;
+    using FeatureVector = Eigen::Matrix<double, Dimension, 1, Eigen::DontAlign>;
+
+    static constexpr size_t DefaultRows = 64;
+    static constexpr size_t DefaultMinSamples = 4 * Dimension;
+    static constexpr double DefaultQuantile = 0.9;
+    static constexpr double DefaultMargin = 2.0;
+    static constexpr double DefaultForgetting = 0.999;
+
+    SurrogateModel(Problem const& problem, Interpreter const& interpreter, ErrorMetric const& error, bool linearScaling = true, size_t rows = DefaultRows);
+
+    // the features of a child, nothing if its outputs on the sample are not finite. the fitness of the parents is
+    // capped to the worst (finite) fitness of the population
+    [[nodiscard]] auto Features(Tree const& tree, Operon::Scalar parentFitness) const -> std::optional<FeatureVector>;
+
+    [[nodiscard]] auto Predict(FeatureVector const& features) const -> Operon::Scalar { return static_cast<Operon::Scalar>(weights_.dot(features)); }
+
+    // true if the child is clearly poor (counted as discarded), always false until the model is active
+    [[nodiscard]] auto Discard(std::optional<FeatureVector> const& features) const -> bool;
+
+    // learns from the exact fitness of a child, thread-safe (the fitness values which are not finite are ignored)
+    void Update(FeatureVector const& features, Operon::Scalar fitness);
+
+    // publishes the updated weights and the fitness threshold of the population, never called concurrently with the
+    // predictions and the updates
+    void Prepare(Operon::Span<Individual const> pop);
+
+    void SetMinSamples(size_t value) { minSamples_ = value; }
+    [[nodiscard]] auto MinSamples() const -> size_t { return minSamples_; }
+
+    void SetQuantile(double value) { EXPECT(value >= 0 && value <= 1); quantile_ = value; }
+    [[nodiscard]] auto Quantile() const -> double { return quantile_; }
+
+    void SetMargin(double value) { EXPECT(value >= 0); margin_ = value; }
+    [[nodiscard]] auto Margin() const -> double { return margin_; }
+
+    void SetForgetting(double value) { EXPECT(value > 0 && value <= 1); forgetting_ = value; }
+    [[nodiscard]] auto Forgetting() const -> double { return forgetting_; }
+
+    [[nodiscard]] auto Rows() const -> size_t { return sample_.Rows(); }
+    [[nodiscard]] auto Active() const -> bool { return active_; }
+    [[nodiscard]] auto Threshold() const -> Operon::Scalar { return threshold_; }
+    // the root mean squared error of the predictions (exponentially weighted)
+    [[nodiscard]] auto Rmse() const -> double { return rmse_; }
+    [[nodiscard]] auto Weights() const -> FeatureVector const& { return weights_; }
+
+    // since the construction
+    [[nodiscard]] auto Samples() const -> size_t { return samples_; }
+    [[nodiscard]] auto Discarded() const -> size_t { return discarded_; }
+
+private:
+    Dataset sample_;
+    Operon::Hash target_;
+    std::reference_wrapper<Interpreter const> interpreter_;
+    std::reference_wrapper<ErrorMetric const> error_;
+    bool scaling_;
+
+    size_t minSamples_{DefaultMinSamples};
+    double quantile_{DefaultQuantile};
+    double margin_{DefaultMargin};
+    double forgetting_{DefaultForgetting};
+
+    // the recursive least squares state, updated under the mutex
+    std::mutex mutex_;
+    FeatureVector w_;
+    Eigen::Matrix<double, Dimension, Dimension, Eigen::DontAlign> p_;
+    double squaredError_{0}; // the a priori errors of the online weights, once they are determined
+    double weight_{0};       // of the squared errors
+    std::atomic_ulong samples_{0};
+
+    // published in Prepare
+    FeatureVector weights_;
+    double rmse_{std::numeric_limits<double>::max()};
+    Operon::Scalar threshold_{std::numeric_limits<Operon::Scalar>::max()};
+    Operon::Scalar worst_{0}; // the worst finite fitness of the population
+    bool active_{false};
+
+    mutable std::atomic_ulong discarded_{0};
+};
+
+} // namespace Operon
+
+#endif
@@ -4,14 +4,21 @@
 #ifndef OPERON_PARSER_HPP
 #define OPERON_PARSER_HPP
 
+#include <optional>
 #include <stdexcept>
 #include <unordered_map>
 
 #include "operon/core/tree.hpp"
 #include "operon/core/types.hpp"
+#include "operon/core/variable.hpp"
+#include "operon/operon_export.hpp"
 #include <pratt-parser/parser.hpp>
 #include <robin_hood.h>
 
+namespace tf {
+class Executor;
+} // namespace tf
+
 namespace Operon {
 
 namespace ParserBlocks {
@@ -213,6 +220,7 @@ struct InfixParser {
     using Conv = ParserBlocks::Conv;
     using Token = ParserBlocks::Token;
     using TokenKind = ParserBlocks::TokenKind;
+    using TokenMap = robin_hood::unordered_flat_map<std::string_view, Token>;
 
     template <typename T, typename U>
     static auto Parse(std::string const& infix, T const& toks, U const& vars) -> Tree
@@ -221,9 +229,10 @@ struct InfixParser {
         return Tree(nodes).UpdateNodes();
     }
 
-    static auto DefaultTokens()
+    // built on the first call
+    static auto DefaultTokens() -> TokenMap const&
     {
-        return robin_hood::unordered_flat_map<std::string_view, Token> {
+        static TokenMap const tokens {
             { "+", Token(TokenKind::dynamic, "add", static_cast<size_t>(NodeType::Add), 10, pratt::associativity::left) },
             { "-", Token(TokenKind::dynamic, "sub", static_cast<size_t>(NodeType::Sub), 10, pratt::associativity::left) },
             { "*", Token(TokenKind::dynamic, "mul", static_cast<size_t>(NodeType::Mul), 20, pratt::associativity::left) },
@@ -254,8 +263,52 @@ struct InfixParser {
             { ")", Token(pratt::token_kind::rparen, ")", 0UL /* don't care */, 0, pratt::associativity::none) },
             { "eof", Token(pratt::token_kind::eof, "eof", 0UL /* don't care */, 0, pratt::associativity::none) }
         };
+        return tokens;
     }
 };
+
+// a parser with its token and variable tables built once, for parsing many models (e.g. to seed a population or to
+// load stored models)
+// - the tables are only read, so Parse can be called concurrently
+// - ParseMany parses the models in parallel, optionally hashing every tree on ingest (see Tree::Hash), in which case
+//   Duplicates identifies the models which are equal to an earlier one without another pass over the trees
+class OPERON_EXPORT ModelParser {
+public:
+    using VariableMap = robin_hood::unordered_flat_map<std::string, Operon::Hash>;
+
+    explicit ModelParser(VariableMap variables, InfixParser::TokenMap tokens = InfixParser::DefaultTokens())
+        : variables_(std::move(variables))
+        , tokens_(std::move(tokens))
+    {
+    }
+
+    explicit ModelParser(Operon::Span<Variable const> variables)
+        : tokens_(InfixParser::DefaultTokens())
+    {
+        for (auto const& v : variables) {
+            variables_.insert({ v.Name, v.Hash });
+        }
+    }
+
+    [[nodiscard]] auto Parse(std::string const& infix) const -> Tree
+    {
+        return InfixParser::Parse(infix, tokens_, variables_);
+    }
+
+    // the trees in the order of the models. if a model cannot be parsed, the exception names its index
+    [[nodiscard]] auto ParseMany(tf::Executor& executor, Operon::Span<std::string const> models, std::optional<Operon::HashMode> hash = std::nullopt) const -> std::vector<Tree>;
+
+    // for every tree the index of the first tree with the same hash value (its own index if it is the first one), the
+    // trees must be hashed e.g. by ParseMany
+    [[nodiscard]] static auto Duplicates(Operon::Span<Tree const> trees) -> std::vector<size_t>;
+
+    [[nodiscard]] auto Variables() const -> VariableMap const& { return variables_; }
+    [[nodiscard]] auto Tokens() const -> InfixParser::TokenMap const& { return tokens_; }
+
+private:
+    VariableMap variables_;
+    InfixParser::TokenMap tokens_;
+};
 } // namespace Operon
 
 #endif
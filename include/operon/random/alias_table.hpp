@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#ifndef OPERON_RANDOM_ALIAS_TABLE_HPP
+#define OPERON_RANDOM_ALIAS_TABLE_HPP
+
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "operon/core/contracts.hpp"
+#include "operon/core/types.hpp"
+
+namespace Operon::Random {
+
+// Walker's alias method (Vose's construction): O(n) setup, each sample takes one uniform index and one coin flip
+class AliasTable {
+public:
+    AliasTable() = default;
+
+    template <typename T>
+    explicit AliasTable(Operon::Span<T const> weights)
+        : threshold_(weights.size())
+        , alias_(weights.size())
+    {
+        auto const n = weights.size();
+        auto const sum = std::accumulate(weights.begin(), weights.end(), 0.0);
+        EXPECT(n == 0 || sum > 0);
+
+        std::vector<size_t> small;
+        std::vector<size_t> large;
+        for (size_t i = 0; i < n; ++i) {
+            threshold_[i] = static_cast<double>(weights[i]) * static_cast<double>(n) / sum;
+            alias_[i] = i;
+            (threshold_[i] < 1 ? small : large).push_back(i);
+        }
+        while (!small.empty() && !large.empty()) {
+            auto s = small.back();
+            small.pop_back();
+            auto l = large.back();
+            alias_[s] = l;
+            threshold_[l] -= 1 - threshold_[s];
+            if (threshold_[l] < 1) {
+                large.pop_back();
+                small.push_back(l);
+            }
+        }
+        // whatever is left over is (up to rounding) exactly one
+        for (auto i : small) { threshold_[i] = 1; }
+        for (auto i : large) { threshold_[i] = 1; }
+    }
+
+    template <typename R>
+    [[nodiscard]] auto operator()(R& random) const -> size_t
+    {
+        EXPECT(!Empty());
+        auto k = Random::Bounded(random, threshold_.size());
+        auto u = Random::Real<double>(random);
+        return u < threshold_[k] ? k : alias_[k];
+    }
+
+    [[nodiscard]] auto Size() const noexcept -> size_t { return threshold_.size(); }
+    [[nodiscard]] auto Empty() const noexcept -> bool { return threshold_.empty(); }
+
+private:
+    std::vector<double> threshold_; // probability of keeping the sampled index
+    std::vector<size_t> alias_;     // index used otherwise
+};
+
+} // namespace Operon::Random
+
+#endif
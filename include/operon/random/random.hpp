@@ -5,6 +5,8 @@
 #define OPERON_RANDOM_HPP
 
 #include <algorithm>
+#include <cstdint> // NOLINT
+#include <limits> // NOLINT
 #include <random>
 #include <type_traits> // NOLINT
 #include "operon/core/contracts.hpp" // NOLINT
@@ -15,12 +17,78 @@
 //#include "wyrand.hpp" // NOLINT
 
 namespace Operon::Random { // NOLINT
+// whether the generator outputs 64 uniform bits (like the generators of the library), the precondition of the fast // NOLINT
+// conversions below. the other generators go through the standard distributions // NOLINT
+template<typename R> // NOLINT
+inline constexpr bool Outputs64Bits = (R::min)() == 0 && (R::max)() == std::numeric_limits<uint64_t>::max(); // NOLINT
+ // NOLINT
+// a uniform integer in [0, n) for n > 0, with lemire's nearly divisionless method: one 128 bit product per value, the // NOLINT
+// division is only needed in the (rare) case of a possible rejection // NOLINT
+template<typename R> // NOLINT
+auto Bounded(R& random, uint64_t n) -> uint64_t // NOLINT
+{ // NOLINT
+#if defined(__SIZEOF_INT128__) // NOLINT
+    if constexpr (Outputs64Bits<R>) { // NOLINT
+        using U128 = unsigned __int128; // NOLINT
+        auto m = static_cast<U128>(random()) * n; // NOLINT
+        auto l = static_cast<uint64_t>(m); // NOLINT
+        if (l < n) { // NOLINT
+            auto const t = (uint64_t{0} - n) % n; // 2^64 mod n // NOLINT
+            while (l < t) { // NOLINT
+                m = static_cast<U128>(random()) * n; // NOLINT
+                l = static_cast<uint64_t>(m); // NOLINT
+            } // NOLINT
+        } // NOLINT
+        return static_cast<uint64_t>(m >> 64U); // NOLINT
+    } // NOLINT
+#endif // NOLINT
+    return std::uniform_int_distribution<uint64_t>(0, n - 1)(random); // NOLINT
+} // NOLINT
+ // NOLINT
+// a uniform real in [0, 1) from the high bits of one value (53 bits for double, 24 bits for float) // NOLINT
+template<typename T, typename R> // NOLINT
+auto Real(R& random) -> T // NOLINT
+{ // NOLINT
+    static_assert(std::is_floating_point_v<T>, "T must be a floating point type."); // NOLINT
+    if constexpr (Outputs64Bits<R> && std::numeric_limits<T>::digits < 64) { // NOLINT
+        constexpr auto digits = std::numeric_limits<T>::digits; // NOLINT
+        constexpr auto scale = T{1} / static_cast<T>(uint64_t{1} << static_cast<unsigned>(digits)); // NOLINT
+        return static_cast<T>(random() >> static_cast<unsigned>(64 - digits)) * scale; // NOLINT
+    } else { // NOLINT
+        return std::uniform_real_distribution<T>(0, 1)(random); // NOLINT
+    } // NOLINT
+} // NOLINT
+ // NOLINT
+// counter-based streams: the generator of a task is derived from (seed, generation, index, substream) instead of // NOLINT
+// being kept in a per task array, so a parallel run is reproducible from its seed alone, independently of the number // NOLINT
+// of threads and of the order of the tasks. the key is hashed with splitmix64 rounds into the seed of a new generator // NOLINT
+// (which runs its own seeding), the distinct keys give independent streams up to 64 bit hash collisions // NOLINT
+inline auto Stream(uint64_t seed, uint64_t generation, uint64_t index, uint64_t substream = 0) noexcept -> RomuTrio // NOLINT
+{ // NOLINT
+    auto key = seed; // NOLINT
+    for (auto v : { generation, index, substream }) { // NOLINT
+        auto s = key ^ v; // NOLINT
+        key = detail::splitMix64(s); // NOLINT
+    } // NOLINT
+    return RomuTrio(key); // NOLINT
+} // NOLINT
+ // NOLINT
 template<typename R, typename T> // NOLINT
 auto Uniform(R& random, T a, T b) -> T // NOLINT
 { // NOLINT
     static_assert(std::is_arithmetic_v<T>, "T must be an arithmetic type."); // NOLINT
-    using Dist = std::conditional_t<std::is_integral_v<T>, std::uniform_int_distribution<T>, std::uniform_real_distribution<T>>; // NOLINT
-    return Dist(a,b)(random); // NOLINT
+    if constexpr (std::is_integral_v<T> && !std::is_same_v<T, bool> && Outputs64Bits<R>) { // NOLINT
+        EXPECT(a <= b); // NOLINT
+        using U = std::make_unsigned_t<T>; // NOLINT
+        auto const range = static_cast<uint64_t>(static_cast<U>(static_cast<U>(b) - static_cast<U>(a))); // NOLINT
+        auto const offset = range == std::numeric_limits<uint64_t>::max() ? random() : Bounded(random, range + 1); // NOLINT
+        return static_cast<T>(static_cast<U>(static_cast<U>(a) + static_cast<U>(offset))); // NOLINT
+    } else if constexpr (std::is_floating_point_v<T>) { // NOLINT
+        return a + (b - a) * Real<T>(random); // NOLINT
+    } else { // NOLINT
+        using Dist = std::conditional_t<std::is_integral_v<T>, std::uniform_int_distribution<T>, std::uniform_real_distribution<T>>; // NOLINT
+        return Dist(a,b)(random); // NOLINT
+    } // NOLINT
 } // NOLINT
  // NOLINT
 template <typename R, typename InputIterator> // NOLINT
@@ -0,0 +1,178 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <algorithm>                         // for max
+#include <atomic>                            // for atomic_bool
+#include <chrono>                            // for steady_clock
+#include <cmath>                             // for isfinite
+#include <limits>                            // for numeric_limits
+#include <random>                            // for bernoulli_distribution
+#include <taskflow/taskflow.hpp>             // for taskflow
+#include <thread>                            // for thread
+#include <vector>                            // for vector
+
+#include "operon/algorithms/async_gp.hpp"
+#include "operon/core/contracts.hpp"         // for ENSURE
+#include "operon/core/node_pool.hpp"         // for NodePool
+#include "operon/core/problem.hpp"           // for Problem
+#include "operon/core/tree.hpp"              // for Tree
+#include "operon/operators/initializer.hpp"  // for CoefficientInitializerBase
+
+namespace Operon {
+auto AsyncGeneticProgrammingAlgorithm::Run(tf::Executor& executor, Operon::RandomGenerator& random, std::function<void()> report) -> void
+{
+    const auto& config = GetConfig();
+    const auto& treeInit = GetTreeInitializer();
+    const auto& coeffInit = GetCoefficientInitializer();
+    const auto& generator = GetGenerator();
+    const auto& evaluator = generator.Evaluator();
+    const auto& crossover = generator.Crossover();
+    const auto& mutator = generator.Mutator();
+
+    auto t0 = std::chrono::steady_clock::now();
+    auto elapsed = [t0]() {
+        auto t1 = std::chrono::steady_clock::now();
+        constexpr double ms{1e3};
+        return static_cast<double>(std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count()) / ms;
+    };
+
+    constexpr size_t idx{0};
+    auto const n = individuals_.size();
+    auto const workers = executor.num_workers();
+    ENSURE(n > 0 && workers > 0);
+
+    // random seeds for each individual (initialization) and for each worker
+    std::vector<Operon::RandomGenerator> rngs;
+    for (size_t i = 0; i < std::max(n, workers); ++i) {
+        rngs.emplace_back(random());
+    }
+
+    auto trainSize = evaluator.BufferSize();
+    std::vector<Operon::Vector<Operon::Scalar>> slots(workers);
+
+    tf::Taskflow init;
+    auto initializePopulation = init.for_each_index(size_t{0}, n, size_t{1}, [&](size_t i) {
+        individuals_[i].Genotype = treeInit(rngs[i]);
+        coeffInit(rngs[i], individuals_[i].Genotype);
+    });
+    auto prepareEval = init.emplace([&](tf::Subflow& sf) { evaluator.Prepare(sf, individuals_); });
+    auto eval = init.for_each_index(size_t{0}, n, size_t{1}, [&](size_t i) {
+        auto id = executor.this_worker_id();
+        if (slots[id].size() < trainSize) {
+            slots[id].resize(trainSize);
+        }
+        individuals_[i].Fitness = evaluator(rngs[i], individuals_[i], slots[id]);
+    });
+    initializePopulation.precede(prepareEval);
+    prepareEval.precede(eval);
+    executor.run(init).wait();
+    if (report) { std::invoke(report); }
+
+    auto const poolSize = std::max(size_t{1}, config.PoolSize);
+    auto const maxAttempts = config.Generations * poolSize;
+    std::atomic_bool terminate{ generator.Terminate() || maxAttempts == 0 };
+
+    auto work = [&](size_t w) {
+        auto& rng = rngs[w];
+        auto& buf = slots[w];
+        if (buf.size() < trainSize) { buf.resize(trainSize); }
+        std::uniform_int_distribution<size_t> uniform(0, n - 1);
+
+        auto quality = [&](size_t i) {
+            std::lock_guard lock(locks_[i]);
+            return individuals_[i][idx];
+        };
+        auto copy = [&](size_t i) {
+            std::lock_guard lock(locks_[i]);
+            return NodePool::Copy(individuals_[i].Genotype);
+        };
+        // the candidates are read one at a time, so a candidate may change before it is used (which is harmless)
+        auto tournament = [&](size_t size, auto better) {
+            auto best = uniform(rng);
+            auto q = quality(best);
+            for (size_t k = 1; k < size; ++k) {
+                auto c = uniform(rng);
+                if (auto qc = quality(c); better(qc, q)) {
+                    best = c;
+                    q = qc;
+                }
+            }
+            return best;
+        };
+
+        // an attempt without variation counts too, so the workers stop even if both probabilities are zero
+        auto attempted = [&]() {
+            auto const attempts = ++attempts_;
+            if (attempts % poolSize == 0) {
+                std::unique_lock guard(populationLock_);
+                generation_ = attempts / poolSize;
+                if (report) { std::invoke(report); }
+            }
+            if (generator.Terminate() || attempts >= maxAttempts || elapsed() > static_cast<double>(config.TimeLimit)) {
+                terminate = true;
+            }
+        };
+
+        while (!terminate) {
+            bool doCrossover = std::bernoulli_distribution(config.CrossoverProbability)(rng);
+            bool doMutation = std::bernoulli_distribution(config.MutationProbability)(rng);
+            if (!(doCrossover || doMutation)) {
+                attempted();
+                continue;
+            }
+
+            // selection: the parents are copied, so variation and evaluation happen without holding any lock
+            Individual child;
+            Tree first;
+            Tree second;
+            {
+                std::shared_lock guard(populationLock_);
+                first = copy(tournament(selectionSize_, std::less{}));
+                if (doCrossover) { second = copy(tournament(selectionSize_, std::less{})); }
+            }
+            if (doCrossover) {
+                child.Genotype = crossover(rng, first, second);
+                NodePool::Release(std::move(first));
+                NodePool::Release(std::move(second));
+            }
+            if (doMutation) {
+                child.Genotype = doCrossover
+                    ? mutator(rng, std::move(child.Genotype))
+                    : mutator(rng, std::move(first));
+            }
+            child.Fitness = evaluator(rng, child, buf);
+            for (auto& v : child.Fitness) {
+                if (!std::isfinite(v)) { v = std::numeric_limits<Operon::Scalar>::max(); }
+            }
+
+            // replacement: the child takes the place of the worst individual of the tournament if it is better
+            {
+                std::shared_lock guard(populationLock_);
+                auto worst = tournament(replacementSize_, std::greater{});
+                std::lock_guard lock(locks_[worst]);
+                if (child[idx] < individuals_[worst][idx]) {
+                    std::swap(child, individuals_[worst]);
+                }
+            }
+            NodePool::Release(std::move(child.Genotype)); // whichever individual lost
+            attempted();
+        }
+    };
+
+    // one long running task per worker (a parallel for could run several of them one after the other on the same worker)
+    tf::Taskflow taskflow;
+    for (size_t w = 0; w < workers; ++w) {
+        taskflow.emplace([&, w]() { work(w); }).name("steady state worker");
+    }
+    taskflow.name("AsyncGP");
+    executor.run(taskflow).wait();
+}
+
+auto AsyncGeneticProgrammingAlgorithm::Run(Operon::RandomGenerator& random, std::function<void()> report, size_t threads) -> void {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    tf::Executor executor(threads);
+    Run(executor, random, std::move(report));
+}
+} // namespace Operon
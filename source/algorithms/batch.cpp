@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <taskflow/taskflow.hpp>
+#include <thread>
+
+#include "operon/algorithms/batch.hpp"
+#include "operon/core/contracts.hpp"
+
+namespace Operon {
+
+auto BatchRunner::Run(tf::Executor& executor, std::function<void(Result const&)> done) const -> std::vector<Result>
+{
+    ENSURE(executor.num_workers() > 0);
+    auto const n = jobs_.size();
+    auto const concurrency = std::min(concurrency_ == 0 ? executor.num_workers() : concurrency_, n);
+
+    std::vector<Result> results(n);
+    std::atomic_size_t next{0};
+
+    // every driving thread takes the next job in the order of the jobs (first come, first served)
+    auto drive = [&]() {
+        for (auto i = next++; i < n; i = next++) {
+            auto& result = results[i];
+            result.Index = i;
+            auto const t0 = std::chrono::steady_clock::now();
+            try {
+                result.Values = jobs_[i](executor);
+            } catch (std::exception const& e) {
+                result.Error = e.what();
+            } catch (...) {
+                result.Error = "unknown error";
+            }
+            result.Elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            if (done) { std::invoke(done, result); }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(concurrency);
+    for (size_t k = 0; k < concurrency; ++k) { threads.emplace_back(drive); }
+    for (auto& t : threads) { t.join(); }
+    return results;
+}
+
+auto BatchRunner::Mean(std::vector<Result> const& results) -> Summary
+{
+    Summary mean;
+    std::vector<size_t> count;
+    for (auto const& result : results) {
+        if (!result.Succeeded()) { continue; }
+        for (auto const& value : result.Values) {
+            auto it = std::find_if(mean.begin(), mean.end(), [&](auto const& p) { return p.first == value.first; });
+            if (it == mean.end()) {
+                mean.emplace_back(value.first, 0);
+                count.push_back(0);
+                it = mean.end() - 1;
+            }
+            auto const k = static_cast<size_t>(it - mean.begin());
+            it->second += value.second;
+            ++count[k];
+        }
+    }
+    for (size_t k = 0; k < mean.size(); ++k) { mean[k].second /= static_cast<double>(count[k]); }
+    return mean;
+}
+
+} // namespace Operon
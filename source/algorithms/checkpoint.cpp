@@ -0,0 +1,194 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <cstdint>                          // for uint32_t, uint64_t
+#include <cstring>                          // for memcpy
+#include <filesystem>                       // for rename
+#include <fmt/format.h>                     // for format
+#include <fstream>                          // for ifstream, ofstream
+#include <stdexcept>                        // for runtime_error
+#include <type_traits>                      // for is_trivially_copyable_v
+
+#include "operon/algorithms/checkpoint.hpp"
+#include "operon/core/contracts.hpp"        // for EXPECT
+#include "operon/core/shared_forest.hpp"    // for SharedForest
+
+namespace Operon::Checkpoint {
+    namespace {
+        static_assert(std::is_trivially_copyable_v<Node>, "the nodes are stored as they are in memory");
+
+        constexpr uint32_t Magic{0x4b43504fU}; // "OPCK"
+        constexpr uint32_t Version{3};
+
+        // the layout of the build, a checkpoint of a different layout cannot be restored
+        constexpr uint32_t Layout = static_cast<uint32_t>(sizeof(Node)) << 16U | static_cast<uint32_t>(sizeof(Operon::Scalar));
+
+        class Writer {
+            std::vector<std::byte>& buffer_;
+
+        public:
+            explicit Writer(std::vector<std::byte>& buffer)
+                : buffer_(buffer)
+            {
+            }
+
+            auto Put(void const* data, size_t size) -> void
+            {
+                auto offset = buffer_.size();
+                buffer_.resize(offset + size);
+                if (size > 0) { std::memcpy(buffer_.data() + offset, data, size); }
+            }
+
+            template<typename T>
+            auto Put(T value) -> void { Put(&value, sizeof(T)); }
+        };
+
+        class Reader {
+            Operon::Span<std::byte const> buffer_;
+            size_t offset_{0};
+
+        public:
+            explicit Reader(Operon::Span<std::byte const> buffer)
+                : buffer_(buffer)
+            {
+            }
+
+            auto Get(void* data, size_t size) -> void
+            {
+                if (offset_ + size > buffer_.size()) { throw std::runtime_error("checkpoint: unexpected end of data"); }
+                if (size > 0) { std::memcpy(data, buffer_.data() + offset_, size); }
+                offset_ += size;
+            }
+
+            [[nodiscard]] auto Buffer() const -> Operon::Span<std::byte const> { return buffer_; }
+            auto Offset() -> size_t& { return offset_; }
+
+            template<typename T>
+            auto Get() -> T
+            {
+                T value{};
+                Get(&value, sizeof(T));
+                return value;
+            }
+        };
+    } // namespace
+
+    auto Encode(CheckpointState const& state, Operon::Span<Individual const> individuals) -> std::vector<std::byte>
+    {
+        // the genotypes share most of their subtrees, which are written once
+        SharedForest forest;
+        std::vector<SharedForest::Handle> roots;
+        roots.reserve(individuals.size());
+        size_t size{0};
+        for (auto const& ind : individuals) {
+            roots.push_back(forest.Insert(ind.Genotype));
+            size += ind.Fitness.size() * sizeof(Operon::Scalar);
+        }
+        std::vector<std::byte> buffer;
+        buffer.reserve(size + forest.MemoryUsage() + individuals.size() * (2 * sizeof(uint32_t) + sizeof(uint64_t) + sizeof(Operon::Scalar)) + 1024); // NOLINT
+
+        Writer out(buffer);
+        out.Put(Magic);
+        out.Put(Version);
+        out.Put(Layout);
+        out.Put(static_cast<uint64_t>(state.Generation));
+        out.Put(static_cast<uint64_t>(state.ResidualEvaluations));
+        out.Put(static_cast<uint64_t>(state.JacobianEvaluations));
+        out.Put(static_cast<uint64_t>(state.EvaluationCount));
+        out.Put(static_cast<uint64_t>(state.Fronts));
+        out.Put(state.StreamSeed);
+        out.Put(static_cast<uint64_t>(state.RandomStates.size()));
+        out.Put(state.RandomStates.data(), state.RandomStates.size() * sizeof(Operon::RandomGenerator::state_type));
+
+        out.Put(static_cast<uint64_t>(individuals.size()));
+        forest.Write({ roots.data(), roots.size() }, buffer);
+        for (auto const& ind : individuals) {
+            out.Put(static_cast<uint32_t>(ind.Fitness.size()));
+            out.Put(static_cast<uint64_t>(ind.Rank));
+            out.Put(ind.Distance);
+            out.Put(ind.Fitness.data(), ind.Fitness.size() * sizeof(Operon::Scalar));
+        }
+        return buffer;
+    }
+
+    auto Decode(Operon::Span<std::byte const> buffer, CheckpointState& state) -> std::vector<Individual>
+    {
+        Reader in(buffer);
+        if (in.Get<uint32_t>() != Magic) { throw std::runtime_error("checkpoint: not a checkpoint"); }
+        if (auto version = in.Get<uint32_t>(); version != Version) {
+            throw std::runtime_error(fmt::format("checkpoint: unsupported version {}", version));
+        }
+        if (in.Get<uint32_t>() != Layout) { throw std::runtime_error("checkpoint: written by a build with a different node or scalar type"); }
+
+        state.Generation = in.Get<uint64_t>();
+        state.ResidualEvaluations = in.Get<uint64_t>();
+        state.JacobianEvaluations = in.Get<uint64_t>();
+        state.EvaluationCount = in.Get<uint64_t>();
+        state.Fronts = in.Get<uint64_t>();
+        state.StreamSeed = in.Get<uint64_t>();
+        state.RandomStates.resize(in.Get<uint64_t>());
+        in.Get(state.RandomStates.data(), state.RandomStates.size() * sizeof(Operon::RandomGenerator::state_type));
+
+        std::vector<Individual> individuals(in.Get<uint64_t>());
+        auto trees = SharedForest::Read(in.Buffer(), in.Offset());
+        if (trees.size() != individuals.size()) { throw std::runtime_error("checkpoint: the number of genotypes does not match"); }
+        for (size_t i = 0; i < individuals.size(); ++i) {
+            auto& ind = individuals[i];
+            auto const objectives = in.Get<uint32_t>();
+            ind.Rank = in.Get<uint64_t>();
+            ind.Distance = in.Get<Operon::Scalar>();
+            ind.Genotype = std::move(trees[i]);
+            ind.Fitness.resize(objectives);
+            in.Get(ind.Fitness.data(), objectives * sizeof(Operon::Scalar));
+        }
+        return individuals;
+    }
+
+    auto Save(Operon::Span<std::byte const> buffer, std::string const& path) -> void
+    {
+        auto tmp = path + ".tmp";
+        {
+            std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+            if (!f) { throw std::runtime_error(fmt::format("{}: cannot open file", tmp)); }
+            f.write(reinterpret_cast<char const*>(buffer.data()), static_cast<std::streamsize>(buffer.size())); // NOLINT
+            f.flush();
+            if (!f) { throw std::runtime_error(fmt::format("{}: cannot write file", tmp)); }
+        }
+        std::filesystem::rename(tmp, path);
+    }
+
+    auto Load(std::string const& path) -> std::vector<std::byte>
+    {
+        std::ifstream f(path, std::ios::binary | std::ios::ate);
+        if (!f) { throw std::runtime_error(fmt::format("{}: cannot open file", path)); }
+        std::vector<std::byte> buffer(static_cast<size_t>(f.tellg()));
+        f.seekg(0);
+        f.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size())); // NOLINT
+        if (!f) { throw std::runtime_error(fmt::format("{}: cannot read file", path)); }
+        return buffer;
+    }
+} // namespace Operon::Checkpoint
+
+namespace Operon {
+CheckpointWriter::~CheckpointWriter()
+{
+    try {
+        Wait();
+    } catch (...) { // NOLINT(bugprone-empty-catch)
+        // the error of the last write cannot be reported anymore
+    }
+}
+
+auto CheckpointWriter::Write(std::vector<std::byte> buffer, std::string path) -> void
+{
+    Wait();
+    pending_ = std::async(std::launch::async, [buffer = std::move(buffer), path = std::move(path)]() {
+        Checkpoint::Save({ buffer.data(), buffer.size() }, path);
+    });
+}
+
+auto CheckpointWriter::Wait() -> void
+{
+    if (pending_.valid()) { pending_.get(); }
+}
+} // namespace Operon
@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <algorithm>
+#include <numeric>
+#include <taskflow/taskflow.hpp>
+
+#include "operon/algorithms/cost_schedule.hpp"
+#include "operon/core/instrumentation.hpp"
+#include "operon/core/node_pool.hpp"
+#include "operon/operators/generator.hpp"
+#include "operon/random/random.hpp"
+
+namespace Operon {
+
+auto CostSchedule::Generate(tf::Executor& executor, tf::Subflow& subflow, OffspringGeneratorBase const& generator, Context const& context,
+    Operon::Span<Individual> target, size_t first, std::atomic_bool& terminate, Callback evaluated) -> void
+{
+    using Instrumentation::CpuTimer;
+    using Stage = Instrumentation::Stage;
+
+    auto vary = subflow.for_each_index(first, target.size(), size_t{1}, [&, context, target](size_t i) {
+        CpuTimer timer(Stage::GenerateOffspring);
+        NodePool::Release(std::move(target[i].Genotype));
+        auto rng = Random::Stream(context.Seed, context.Generation + 1, i);
+        while (!(terminate = generator.Terminate())) {
+            if (auto result = generator.Vary(rng, context.CrossoverProbability, context.MutationProbability); result.has_value()) {
+                target[i] = std::move(result.value());
+                return;
+            }
+        }
+    }).name("vary");
+    auto schedule = subflow.emplace([&, target, first]() {
+        CpuTimer timer(Stage::GenerateOffspring);
+        auto const& evaluator = generator.Evaluator();
+        order_.resize(target.size() - first);
+        std::iota(order_.begin(), order_.end(), first);
+        cost_.resize(target.size());
+        for (auto i : order_) { cost_[i] = evaluator.Cost(target[i]); }
+        std::stable_sort(order_.begin(), order_.end(), [&](auto a, auto b) { return cost_[a] > cost_[b]; });
+        next_ = 0;
+    }).name("schedule evaluations");
+    auto evaluate = subflow.emplace([&, context, target, evaluated = std::move(evaluated)](tf::Subflow& ef) {
+        for (size_t w = 0; w < executor.num_workers(); ++w) {
+            ef.emplace([&, context, target]() {
+                CpuTimer timer(Stage::GenerateOffspring);
+                auto buf = Operon::Span<Operon::Scalar>((*context.Slots)[executor.this_worker_id()]);
+                for (auto k = next_++; k < order_.size(); k = next_++) {
+                    auto i = order_[k];
+                    if (target[i].Genotype.Length() == 0) { continue; } // not generated (termination)
+                    auto rng = Random::Stream(context.Seed, context.Generation + 1, i, 1);
+                    generator.Evaluate(rng, target[i], buf);
+                    evaluated(target[i]);
+                }
+            });
+        }
+    }).name("evaluate offspring");
+    vary.precede(schedule);
+    schedule.precede(evaluate);
+}
+
+} // namespace Operon
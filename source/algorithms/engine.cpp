@@ -0,0 +1,19 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <taskflow/taskflow.hpp>
+#include <thread>
+
+#include "operon/algorithms/engine.hpp"
+
+namespace Operon {
+
+Engine::Engine(size_t threads)
+    : executor_(std::make_unique<tf::Executor>(threads == 0 ? std::thread::hardware_concurrency() : threads))
+    , buffers_(executor_->num_workers())
+{
+}
+
+Engine::~Engine() = default;
+
+} // namespace Operon
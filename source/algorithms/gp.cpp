@@ -1,16 +1,26 @@
 // SPDX-License-Identifier: MIT
 // SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
 
-#include <algorithm>                         // for max, min_element
+#include <algorithm>                         // for max, min_element, swap_ranges
 #include <atomic>                            // for atomic_bool
 #include <chrono>                            // for steady_clock
 #include <memory>                            // for allocator, allocator_tra...
+#include <numeric>                           // for iota
 #include <optional>                          // for optional
+#include <stdexcept>                         // for runtime_error
 #include <taskflow/taskflow.hpp>             // for taskflow, subflow
 #include <vector>                            // for vector, vector::size_type
 
 #include "operon/algorithms/gp.hpp"
+#include "operon/algorithms/checkpoint.hpp"
+#include "operon/algorithms/cost_schedule.hpp"
+#include "operon/algorithms/engine.hpp"
+#include "operon/algorithms/termination.hpp"
 #include "operon/core/contracts.hpp"         // for ENSURE
+#include "operon/core/instrumentation.hpp"  // for ScopedTimer, CpuTimer, Interval
+#include "operon/core/memory.hpp"           // for Account, Footprint, Enforce
+#include "operon/core/model_archive.hpp"    // for ModelArchive
+#include "operon/core/node_pool.hpp"         // for NodePool
 #include "operon/core/operator.hpp"          // for OperatorBase
 #include "operon/core/problem.hpp"           // for Problem
 #include "operon/core/range.hpp"             // for Range
@@ -20,13 +30,23 @@
 
 namespace Operon {
 auto GeneticProgrammingAlgorithm::Run(tf::Executor& executor, Operon::RandomGenerator& random, std::function<void()> report) -> void
+{
+    std::vector<Operon::Vector<Operon::Scalar>> slots(executor.num_workers());
+    Run(executor, slots, random, std::move(report));
+}
+
+auto GeneticProgrammingAlgorithm::Run(Engine& engine, Operon::RandomGenerator& random, std::function<void()> report) -> void
+{
+    Run(engine.Executor(), engine.Buffers(), random, std::move(report));
+}
+
+auto GeneticProgrammingAlgorithm::Run(tf::Executor& executor, std::vector<Operon::Vector<Operon::Scalar>>& slots, Operon::RandomGenerator& random, std::function<void()> report) -> void
 {
     const auto& config = GetConfig();
     const auto& treeInit = GetTreeInitializer();
     const auto& coeffInit = GetCoefficientInitializer();
     const auto& generator = GetGenerator();
     const auto& reinserter = GetReinserter();
-    const auto& problem = GetProblem();
 
     auto t0 = std::chrono::steady_clock::now();
     auto elapsed = [t0]() {
@@ -35,11 +55,19 @@ auto GeneticProgrammingAlgorithm::Run(tf::Executor& executor, Operon::RandomGene
         return static_cast<double>(std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count()) / ms;
     };
 
-    // random seeds for each thread
-    size_t s = std::max(config.PopulationSize, config.PoolSize);
-    std::vector<Operon::RandomGenerator> rngs;
-    for (size_t i = 0; i < s; ++i) {
-        rngs.emplace_back(random());
+    // the pipelined loop needs a second offspring buffer
+    if (pipelined_ && spare_.size() != config.PoolSize) {
+        individuals_.resize(config.PopulationSize + 2 * config.PoolSize);
+        parents_ = { individuals_.data(), config.PopulationSize };
+        offspring_ = { individuals_.data() + config.PopulationSize, config.PoolSize };
+        spare_ = { individuals_.data() + config.PopulationSize + config.PoolSize, config.PoolSize };
+    }
+
+    // every task derives its generator from the seed of the run, the generation and its index (see Random::Stream),
+    // generation 0 is the initialization and the offspring of generation g come from the streams of generation g + 1
+    // (a restored run continues with the seed of the checkpoint)
+    if (!restored_) {
+        seed_ = random();
     }
 
     auto idx = 0;
@@ -47,68 +75,160 @@ auto GeneticProgrammingAlgorithm::Run(tf::Executor& executor, Operon::RandomGene
 
     // we want to allocate all the memory that will be necessary for evaluation (e.g. for storing model responses)
     // in one go and use it throughout the generations in order to minimize the memory pressure
-    auto trainSize = problem.TrainingRange().Size();
+    // (evaluators which stream the model response into the error metric do not need a buffer)
+    auto trainSize = evaluator.BufferSize();
 
-    ENSURE(executor.num_workers() > 0);
-    std::vector<Operon::Vector<Operon::Scalar>> slots(executor.num_workers());
+    ENSURE(executor.num_workers() > 0 && slots.size() >= executor.num_workers());
 
-    tf::Taskflow taskflow;
+    // memory accounting (see Memory): the evaluation buffers (at most one per worker) and, measured by the report
+    // step, the population
+    Memory::Account slotMemory(Memory::Subsystem::Evaluator, slots.size() * trainSize * sizeof(Operon::Scalar));
+    Memory::Account populationMemory(Memory::Subsystem::Population);
 
     std::atomic_bool terminate{ false }; // flag to signal algorithm termination
 
+    // the optional termination criterion sees the best individual so far, which the evaluating tasks keep per worker
+    BestSoFar best(executor.num_workers());
+    auto offer = [&](Individual const& individual) {
+        if (termination_ != nullptr) { best.Offer(executor.this_worker_id(), individual); }
+    };
+    if (termination_ != nullptr) { termination_->Reset(); }
+
+    // cost-aware generation (for separable generators), see CostSchedule
+    CostSchedule costSchedule;
+
+    // timings (see Instrumentation): the parallel stages are timed by their tasks (cpu) and by an interval between
+    // the tasks before and after them (elapsed)
+    using Instrumentation::CpuTimer;
+    using Instrumentation::ScopedTimer;
+    using Stage = Instrumentation::Stage;
+    Instrumentation::Interval initializeTime;
+    Instrumentation::Interval evaluateTime;
+    Instrumentation::Interval offspringTime;
+    auto reportProgress = [&]() {
+        ScopedTimer timer(Stage::Report);
+        // in the pipelined loop the next offspring are generated meanwhile, only the parents can be measured
+        auto const measured = pipelined_ ? parents_ : Operon::Span<Individual>(individuals_);
+        populationMemory.Update(Memory::Footprint(Operon::Span<Individual const>(measured.data(), measured.size())));
+        Memory::Enforce();
+        if (report) { std::invoke(report); }
+    };
+
+    auto generateByCost = [&](tf::Subflow& sf, Operon::Span<Individual> target, size_t first) {
+        CostSchedule::Context context { seed_, generation_, config.CrossoverProbability, config.MutationProbability, &slots };
+        costSchedule.Generate(executor, sf, generator, context, target, first, terminate, offer);
+    };
+
+    tf::Taskflow taskflow;
+
     // while loop control flow
     auto [init, cond, body, back, done] = taskflow.emplace(
         [&](tf::Subflow& subflow) {
+            if (restored_) { // the population of the checkpoint is already evaluated (and reported)
+                restored_ = false;
+                for (auto const& ind : parents_) { offer(ind); }
+                return;
+            }
+            initializeTime.Start();
+            // the population is evaluated once, after the evaluator has been prepared
             auto initializePopulation = subflow.for_each_index(size_t{0}, parents_.size(), size_t{1}, [&](size_t i) {
-                auto id = executor.this_worker_id();
-                // make sure the worker has a large enough buffer
-                if (slots[id].size() < trainSize) { slots[id].resize(trainSize); }
-                parents_[i].Genotype = treeInit(rngs[i]);
-                coeffInit(rngs[i], parents_[i].Genotype);
-                parents_[i].Fitness = evaluator(rngs[i], parents_[i], slots[id]);
+                CpuTimer timer(Stage::InitializePopulation);
+                if (seeds_ != nullptr && i < seeds_->Size()) { // stored models, as they were optimized
+                    parents_[i].Genotype = seeds_->GetTree(i);
+                    return;
+                }
+                auto rng = Random::Stream(seed_, 0, i);
+                parents_[i].Genotype = treeInit(rng);
+                coeffInit(rng, parents_[i].Genotype);
             }).name("initialize population");
-            auto prepareEval = subflow.emplace([&]() { evaluator.Prepare(parents_); }).name("prepare evaluator");
+            auto prepareEval = subflow.emplace([&](tf::Subflow& sf) {
+                initializeTime.Stop(Stage::InitializePopulation);
+                {
+                    ScopedTimer timer(Stage::PrepareEvaluator);
+                    evaluator.Prepare(sf, parents_);
+                    sf.join();
+                }
+                evaluateTime.Start();
+            }).name("prepare evaluator");
             auto eval = subflow.for_each_index(size_t{0}, parents_.size(), size_t{1}, [&](size_t i) {
+                CpuTimer timer(Stage::EvaluatePopulation);
                 auto id = executor.this_worker_id();
                 // make sure the worker has a large enough buffer
                 if (slots[id].size() < trainSize) {
                     slots[id].resize(trainSize);
                 }
-                parents_[i].Fitness = evaluator(rngs[i], parents_[i], slots[id]);
+                auto rng = Random::Stream(seed_, 0, i, 1);
+                parents_[i].Fitness = evaluator(rng, parents_[i], slots[id]);
+                offer(parents_[i]);
             }).name("evaluate population");
-            auto reportProgress = subflow.emplace([&](){ if (report) { std::invoke(report); } }).name("report progress");
             initializePopulation.precede(prepareEval);
             prepareEval.precede(eval);
-            eval.precede(reportProgress);
+            if (!pipelined_) { // otherwise the report overlaps with the first generation
+                auto reportInit = subflow.emplace([&]() {
+                    evaluateTime.Stop(Stage::EvaluatePopulation);
+                    reportProgress();
+                }).name("report progress");
+                eval.precede(reportInit);
+            }
         }, // init
-        [&]() { return terminate || generation_ == config.Generations || elapsed() > static_cast<double>(config.TimeLimit); }, // loop condition
+        [&]() {
+            evaluateTime.Stop(Stage::EvaluatePopulation); // if it was not stopped by the report
+            return terminate || generation_ == config.Generations || elapsed() > static_cast<double>(config.TimeLimit)
+                || (termination_ != nullptr && (*termination_)({ generation_, best.Best() }));
+        }, // loop condition
         [&](tf::Subflow& subflow) {
-            auto keepElite = subflow.emplace([&]() {
-                offspring_[0] = *std::min_element(parents_.begin(), parents_.end(), [&](const auto& lhs, const auto& rhs) { return lhs[idx] < rhs[idx]; });
+            // in pipelined mode the offspring are generated into the spare buffer, the report on the previous
+            // generation reads the parents and the offspring in the meantime (neither is written before reinsertion)
+            auto target = pipelined_ ? spare_ : offspring_;
+            auto keepElite = subflow.emplace([&, target]() {
+                ScopedTimer timer(Stage::KeepElite);
+                target[0] = *std::min_element(parents_.begin(), parents_.end(), [&](const auto& lhs, const auto& rhs) { return lhs[idx] < rhs[idx]; });
             }).name("keep elite");
-            auto prepareGenerator = subflow.emplace([&]() { generator.Prepare(parents_); }).name("prepare generator");
-            auto generateOffspring = subflow.for_each_index(size_t{1}, offspring_.size(), size_t{1}, [&](size_t i) {
-                auto buf = Operon::Span<Operon::Scalar>(slots[executor.this_worker_id()]);
-                while (!(terminate = generator.Terminate())) {
-                    if (auto result = generator(rngs[i], config.CrossoverProbability, config.MutationProbability, buf); result.has_value()) {
-                        offspring_[i] = std::move(result.value());
-                        return;
-                    }
+            auto prepareGenerator = subflow.emplace([&](tf::Subflow& sf) {
+                {
+                    ScopedTimer timer(Stage::PrepareGenerator);
+                    generator.Prepare(sf, parents_);
+                    sf.join();
                 }
-            }).name("generate offspring");
-            auto reinsert = subflow.emplace([&]() { reinserter(random, parents_, offspring_); }).name("reinsert");
+                offspringTime.Start();
+            }).name("prepare generator");
+            auto generateOffspring = costAware_ && generator.Separable()
+                ? subflow.emplace([&, target](tf::Subflow& sf) { generateByCost(sf, target, size_t{1}); }).name("generate offspring")
+                : subflow.for_each_index(size_t{1}, target.size(), size_t{1}, [&, target](size_t i) {
+                    CpuTimer timer(Stage::GenerateOffspring);
+                    auto buf = Operon::Span<Operon::Scalar>(slots[executor.this_worker_id()]);
+                    // the previous occupant of the slot is discarded, its nodes are reused by the variation operators
+                    NodePool::Release(std::move(target[i].Genotype));
+                    auto rng = Random::Stream(seed_, generation_ + 1, i);
+                    while (!(terminate = generator.Terminate())) {
+                        if (generator.Generate(rng, config.CrossoverProbability, config.MutationProbability, buf, target[i])) {
+                            offer(target[i]);
+                            return;
+                        }
+                    }
+                }).name("generate offspring");
+            auto reinsert = subflow.emplace([&]() {
+                offspringTime.Stop(Stage::GenerateOffspring);
+                ScopedTimer timer(Stage::Reinsert);
+                if (pipelined_) { std::swap_ranges(spare_.begin(), spare_.end(), offspring_.begin()); }
+                reinserter(random, parents_, offspring_);
+            }).name("reinsert");
             auto incrementGeneration = subflow.emplace([&]() { ++generation_; }).name("increment generation");
-            auto reportProgress = subflow.emplace([&](){ if (report) { std::invoke(report); } }).name("report progress");
+            auto reportGeneration = subflow.emplace(reportProgress).name("report progress");
 
             // set-up subflow graph
             keepElite.precede(prepareGenerator);
             prepareGenerator.precede(generateOffspring);
             generateOffspring.precede(reinsert);
             reinsert.precede(incrementGeneration);
-            incrementGeneration.precede(reportProgress);
+            if (pipelined_) {
+                reportGeneration.precede(reinsert); // reports the previous generation
+            } else {
+                incrementGeneration.precede(reportGeneration);
+            }
         }, // loop body (evolutionary main loop)
         [&]() { return 0; }, // jump back to the next iteration
-        [&]() { /* all done */ }  // work done, report last gen and stop
+        [&]() { if (pipelined_) { reportProgress(); } } // work done, report last gen and stop
     ); // evolutionary loop
 
     init.name("init");
@@ -123,8 +243,41 @@ auto GeneticProgrammingAlgorithm::Run(tf::Executor& executor, Operon::RandomGene
     body.precede(back);
     back.precede(cond);
 
-    executor.run(taskflow);
-    executor.wait_for_all();
+    // wait only for this taskflow, several algorithms can share the executor
+    executor.run(taskflow).wait();
+}
+
+auto GeneticProgrammingAlgorithm::SaveState(Operon::RandomGenerator const& random) const -> std::vector<std::byte>
+{
+    auto const& evaluator = GetGenerator().Evaluator();
+    CheckpointState state;
+    state.Generation = generation_;
+    state.ResidualEvaluations = evaluator.ResidualEvaluations();
+    state.JacobianEvaluations = evaluator.JacobianEvaluations();
+    state.EvaluationCount = evaluator.EvaluationCount();
+    state.StreamSeed = seed_;
+    state.RandomStates.push_back(random.State());
+    return Checkpoint::Encode(state, { individuals_.data(), parents_.size() + offspring_.size() });
+}
+
+auto GeneticProgrammingAlgorithm::RestoreState(Operon::Span<std::byte const> buffer, Operon::RandomGenerator& random) -> void
+{
+    CheckpointState state;
+    auto individuals = Checkpoint::Decode(buffer, state);
+    if (individuals.size() != parents_.size() + offspring_.size() || state.RandomStates.size() != 1) {
+        throw std::runtime_error("GeneticProgrammingAlgorithm::RestoreState: the checkpoint does not match the configuration");
+    }
+    std::move(individuals.begin(), individuals.end(), individuals_.begin());
+
+    generation_ = state.Generation;
+    auto const& evaluator = GetGenerator().Evaluator();
+    evaluator.SetResidualEvaluations(state.ResidualEvaluations);
+    evaluator.SetJacobianEvaluations(state.JacobianEvaluations);
+    evaluator.SetEvaluationCounter(state.EvaluationCount);
+
+    random.SetState(state.RandomStates.front());
+    seed_ = state.StreamSeed;
+    restored_ = true;
 }
 
 auto GeneticProgrammingAlgorithm::Run(Operon::RandomGenerator& random, std::function<void()> report, size_t threads) -> void {
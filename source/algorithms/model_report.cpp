@@ -0,0 +1,126 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <tuple>
+#include <utility>
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "operon/algorithms/model_report.hpp"
+#include "operon/error_metrics/kernels.hpp"
+
+namespace Operon {
+    namespace {
+        constexpr double Eps{1e-12}; // the same threshold for (almost) constant targets as the error metrics
+
+        // the statistics of the scaled values a * x + b from the moments of the unscaled values x:
+        // e = a * x + b - y has mean a * mx + b - my and variance a^2 * vx - 2 * a * cov + vy
+        auto ScaledStatistics(Kernels::BivariateMoments const& m, double a, double b) -> std::pair<double, double>
+        {
+            auto const mean = a * m.MeanX + b - m.MeanY;
+            auto const mse = std::max(0.0, a * a * m.VarianceX - 2 * a * m.Covariance + m.VarianceY) + mean * mean;
+            auto const r2 = m.VarianceY < Eps ? std::numeric_limits<double>::min() : 1.0 - mse / m.VarianceY;
+            auto const nmse = m.VarianceY < Eps ? m.VarianceY : mse / m.VarianceY;
+            return { r2, nmse };
+        }
+
+        auto Report(Problem const& problem, Interpreter const& interpreter, Tree const& tree, Operon::Vector<Operon::Scalar>& buffer) -> ModelStatistics
+        {
+            auto const& dataset = problem.GetDataset();
+            auto const train = problem.TrainingRange();
+            auto const test = problem.TestRange();
+            auto const target = dataset.GetValues(problem.TargetVariable().Hash);
+            auto const targetTrain = target.subspan(train.Start(), train.Size());
+            auto const targetTest = target.subspan(test.Start(), test.Size());
+
+            buffer.resize(train.Size() + test.Size());
+            Operon::Span<Operon::Scalar> estimated{buffer.data(), buffer.size()};
+            auto estimatedTrain = estimated.subspan(0, train.Size());
+            auto estimatedTest = estimated.subspan(train.Size(), test.Size());
+
+            auto const program = interpreter.Compile<Operon::Scalar>(tree, dataset);
+            interpreter.Evaluate<Operon::Scalar>(program, train, estimatedTrain);
+            if (test.Size() > 0) { interpreter.Evaluate<Operon::Scalar>(program, test, estimatedTest); }
+
+            ModelStatistics stats;
+            auto const mtrain = Kernels::Moments(Operon::Span<Operon::Scalar const>{estimatedTrain}, targetTrain);
+            auto a = mtrain.Covariance / mtrain.VarianceX;
+            if (!std::isfinite(a)) { a = 1; }
+            // rounded like the constants of the scaling nodes, so the statistics are those of the scaled tree
+            auto const sa = static_cast<Operon::Scalar>(a);
+            auto const sb = static_cast<Operon::Scalar>(mtrain.MeanY - sa * mtrain.MeanX);
+            stats.Scale = sa;
+            stats.Offset = sb;
+            std::tie(stats.R2Train, stats.NmseTrain) = ScaledStatistics(mtrain, sa, sb);
+            if (test.Size() > 0) {
+                auto const mtest = Kernels::Moments(Operon::Span<Operon::Scalar const>{estimatedTest}, targetTest);
+                std::tie(stats.R2Test, stats.NmseTest) = ScaledStatistics(mtest, sa, sb);
+            }
+
+            // the absolute errors need the scaled values
+            std::transform(estimated.begin(), estimated.end(), estimated.begin(), [&](auto x) { return sa * x + sb; });
+            stats.MaeTrain = Kernels::SumOfAbsoluteErrors(Operon::Span<Operon::Scalar const>{estimatedTrain}, targetTrain) / static_cast<double>(train.Size());
+            if (test.Size() > 0) {
+                stats.MaeTest = Kernels::SumOfAbsoluteErrors(Operon::Span<Operon::Scalar const>{estimatedTest}, targetTest) / static_cast<double>(test.Size());
+            }
+            return stats;
+        }
+    } // namespace
+
+    ModelReport::~ModelReport()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            stop_ = true;
+        }
+        wake_.notify_one();
+        if (worker_.joinable()) { worker_.join(); }
+    }
+
+    auto ModelReport::operator()(Tree const& tree) -> ModelStatistics
+    {
+        return Report(problem_, interpreter_, tree, buffer_);
+    }
+
+    auto ModelReport::Submit(Tree tree) -> std::future<ModelStatistics>
+    {
+        std::packaged_task<ModelStatistics(Operon::Vector<Operon::Scalar>&)> task([this, tree = std::move(tree)](auto& buffer) {
+            return Report(problem_, interpreter_, tree, buffer);
+        });
+        auto result = task.get_future();
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            tasks_.push_back(std::move(task));
+            if (!worker_.joinable()) { worker_ = std::thread([this]() { Run(); }); }
+        }
+        wake_.notify_one();
+        return result;
+    }
+
+    auto ModelReport::Run() -> void
+    {
+#if defined(__linux__)
+        // the highest nice value, i.e. the lowest priority (it applies to the calling thread only on linux)
+        constexpr int highestNice{19};
+        setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), highestNice); // NOLINT
+#endif
+        Operon::Vector<Operon::Scalar> buffer;
+        std::unique_lock<std::mutex> lock(lock_);
+        for (;;) {
+            wake_.wait(lock, [&]() { return stop_ || !tasks_.empty(); });
+            if (tasks_.empty()) { break; } // stopped, after the remaining reports
+            auto task = std::move(tasks_.front());
+            tasks_.pop_front();
+            lock.unlock();
+            task(buffer);
+            lock.lock();
+        }
+    }
+} // namespace Operon
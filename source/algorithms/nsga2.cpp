@@ -1,19 +1,32 @@
 // SPDX-License-Identifier: MIT
 // SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
 
-#include <algorithm>                                 // for stable_sort, copy_n, max
+#include <algorithm>                                 // for stable_sort, copy_n, max, swap_ranges
 #include <atomic>                                    // for atomic_bool
 #include <chrono>                                    // for steady_clock
 #include <cmath>                                     // for isfinite
 #include <iterator>                                  // for move_iterator, back_inse...
 #include <limits>                                    // for numeric_limits
 #include <memory>                                    // for allocator, allocator_tra...
+#include <numeric>                                   // for iota
+#include <tuple>                                     // for tie
 #include <optional>                                  // for optional
+#include <stdexcept>                                 // for runtime_error
 #include <taskflow/taskflow.hpp>                     // for taskflow, subflow
 #include <vector>                                    // for vector, vector::size_type
 
 #include "operon/algorithms/nsga2.hpp"
+#include "operon/algorithms/checkpoint.hpp"
+#include "operon/algorithms/cost_schedule.hpp"
+#include "operon/algorithms/engine.hpp"
+#include "operon/algorithms/termination.hpp"
 #include "operon/core/contracts.hpp"                 // for ENSURE
+#include "operon/core/hypervolume.hpp"               // for Contributions
+#include "operon/core/instrumentation.hpp"           // for ScopedTimer, CpuTimer, Interval
+#include "operon/core/memory.hpp"                    // for Account, Footprint, Enforce
+#include "operon/core/model_archive.hpp"             // for ModelArchive
+#include "operon/core/node_pool.hpp"                 // for NodePool
+#include "operon/core/pareto_archive.hpp"            // for ParetoArchive
 #include "operon/core/operator.hpp"                  // for OperatorBase
 #include "operon/core/problem.hpp"                   // for Problem
 #include "operon/core/range.hpp"                     // for Range
@@ -24,83 +37,226 @@
 
 namespace Operon {
 
-auto NSGA2::UpdateDistance(Operon::Span<Individual> pop) -> void
+auto NSGA2::UpdateDistance(tf::Subflow& subflow, Operon::Span<Individual> pop) -> void
 {
-    // assign distance. each front is sorted for each objective
-    size_t m = pop.front().Fitness.size();
-    auto inf = std::numeric_limits<Operon::Scalar>::max();
-    for (size_t i = 0; i < fronts_.size(); ++i) {
-        auto& front = fronts_[i];
-        for (size_t obj = 0; obj < m; ++obj) {
-            SingleObjectiveComparison comp(obj);
-            std::stable_sort(front.begin(), front.end(), [&](auto a, auto b) { return comp(pop[a], pop[b]); });
-            auto min = pop.front()[obj];
-            auto max = pop.back()[obj];
+    // crowding distance on a column-major copy of the fitness matrix built by Sort:
+    // - each objective column is argsorted once by (rank, value), which gives every front as a contiguous segment
+    // - the distances of the different fronts are then accumulated in parallel
+    auto const n = pop.size();
+    auto const m = pop.front().Fitness.size();
+    auto const nf = fronts_.size();
+
+    if (hypervolume_) {
+        // the members of each front are ranked by their exclusive hypervolume contribution, measured against a common
+        // reference point just beyond the nadir of the population (the ranking does not depend on the objective scales)
+        reference_ = Hypervolume::Reference({ fitness_.data(), n * m }, m);
+        subflow.for_each_index(size_t{0}, nf, size_t{1}, [this, pop, m, nf](size_t f) {
+            Instrumentation::CpuTimer timer(Instrumentation::Stage::UpdateDistance);
+            auto const& front = fronts_[f];
+            if (front.empty()) { return; }
+            std::vector<Operon::Scalar> points;
+            points.reserve(front.size() * m);
+            for (auto i : front) {
+                points.insert(points.end(), fitness_.begin() + static_cast<std::ptrdiff_t>(i * m), fitness_.begin() + static_cast<std::ptrdiff_t>((i + 1) * m));
+            }
+            Operon::RandomGenerator random(generation_ * nf + f); // monte carlo estimates are reproducible
+            auto contributions = Hypervolume::Contributions(random, points, m, reference_);
             for (size_t j = 0; j < front.size(); ++j) {
-                auto idx = front[j];
+                pop[front[j]].Rank = f;
+                pop[front[j]].Distance = static_cast<Operon::Scalar>(contributions[j]);
+            }
+        }).name("hypervolume contribution");
+        return;
+    }
 
-                pop[idx].Rank = i;
-                if (obj == 0) {
-                    pop[idx].Distance = 0;
-                }
+    rank_.resize(n);
+    offsets_.assign(nf + 1, 0);
+    for (size_t i = 0; i < nf; ++i) {
+        for (auto j : fronts_[i]) { rank_[j] = i; }
+        offsets_[i + 1] = offsets_[i] + fronts_[i].size();
+    }
+    columns_.resize(n * m);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t k = 0; k < m; ++k) { columns_[k * n + i] = fitness_[i * m + k]; }
+    }
+    columnOrder_.resize(n * m);
 
-                auto mPrev = j > 0 ? pop[j - 1][obj] : inf;
-                auto mNext = j < front.size() - 1 ? pop[j + 1][obj] : inf;
-                auto distance = (mNext - mPrev) / (max - min);
-                if (!std::isfinite(distance)) {
-                    distance = 0;
-                }
-                pop[idx].Distance += distance;
+    auto argsort = subflow.for_each_index(size_t{0}, m, size_t{1}, [this, n](size_t k) {
+        Instrumentation::CpuTimer timer(Instrumentation::Stage::UpdateDistance);
+        auto const* col = columns_.data() + k * n;
+        auto first = columnOrder_.begin() + static_cast<std::ptrdiff_t>(k * n);
+        auto last = first + static_cast<std::ptrdiff_t>(n);
+        std::iota(first, last, size_t{0});
+        std::sort(first, last, [&](auto a, auto b) {
+            return std::tie(rank_[a], col[a], a) < std::tie(rank_[b], col[b], b);
+        });
+    }).name("argsort objectives");
+
+    auto crowding = subflow.for_each_index(size_t{0}, nf, size_t{1}, [this, pop, n, m](size_t f) {
+        Instrumentation::CpuTimer timer(Instrumentation::Stage::UpdateDistance);
+        auto const lo = offsets_[f];
+        auto const sz = offsets_[f + 1] - lo;
+        if (sz == 0) { return; } // no duplicates
+
+        auto inf = std::numeric_limits<Operon::Scalar>::infinity();
+        for (auto const* seg = columnOrder_.data() + lo; seg < columnOrder_.data() + lo + sz; ++seg) {
+            pop[*seg].Rank = f;
+            pop[*seg].Distance = 0;
+        }
+        for (size_t k = 0; k < m; ++k) {
+            auto const* col = columns_.data() + k * n;
+            auto const* seg = columnOrder_.data() + k * n + lo;
+            auto const min = col[seg[0]];
+            auto const max = col[seg[sz - 1]];
+            // the boundary individuals of each objective are always preferred
+            pop[seg[0]].Distance = inf;
+            pop[seg[sz - 1]].Distance = inf;
+            for (size_t j = 1; j + 1 < sz; ++j) {
+                auto distance = (col[seg[j + 1]] - col[seg[j - 1]]) / (max - min);
+                if (std::isfinite(distance)) { pop[seg[j]].Distance += distance; }
             }
         }
-    }
+    }).name("crowding distance");
+
+    argsort.precede(crowding);
 }
 
 auto NSGA2::Sort(Operon::Span<Individual> pop) -> void
 {
     auto eps = GetConfig().Epsilon;
+    auto const n = pop.size();
+    auto const m = pop.front().Fitness.size();
+
+    // the fitness values in one contiguous block, the individuals are only moved once at the end
+    fitness_.resize(n * m);
+    for (size_t i = 0; i < n; ++i) {
+        std::copy_n(pop[i].Fitness.begin(), m, fitness_.begin() + static_cast<std::ptrdiff_t>(i * m));
+    }
+    auto row = [&](size_t i) { return fitness_.cbegin() + static_cast<std::ptrdiff_t>(i * m); };
 
     // sort the population lexicographically
-    std::stable_sort(pop.begin(), pop.end(), [&](auto const& lhs, auto const& rhs) {
-        auto const& fit1 = lhs.Fitness;
-        auto const& fit2 = rhs.Fitness;
-        return Less{}(fit1.cbegin(), fit1.cend(), fit2.cbegin(), fit2.cend(), eps);
+    auto& order = order_;
+    order.resize(n);
+    std::iota(order.begin(), order.end(), size_t{0});
+    std::stable_sort(order.begin(), order.end(), [&](auto i, auto j) {
+        return Less{}(row(i), row(i) + m, row(j), row(j) + m, eps);
     });
-    std::vector<Individual> dup;
-    dup.reserve(pop.size());
-    auto* r = std::unique(pop.begin(), pop.end(), [&](auto const& lhs, auto const& rhs) {
-        auto const& fit1 = lhs.Fitness;
-        auto const& fit2 = rhs.Fitness;
-        if (Operon::Equal{}(fit1, fit2, eps)) {
-            dup.push_back(rhs);
-            return true;
+
+    // the unique individuals first (in lexicographic order), followed by the duplicates
+    auto& duplicates = duplicates_;
+    duplicates.clear();
+    size_t u = 0;
+    for (size_t k = 0; k < n; ++k) {
+        auto i = order[k];
+        if (u > 0 && Operon::Equal{}(row(order[u - 1]), row(order[u - 1]) + m, row(i), row(i) + m, eps)) {
+            duplicates.push_back(i);
+        } else {
+            order[u++] = i;
         }
-        return false;
-    });
-    ENSURE(std::distance(pop.begin(), r) + dup.size() == pop.size());
-    std::copy_n(std::make_move_iterator(dup.begin()), dup.size(), r); // r points to the end of the unique section
-    Operon::Span<Individual const> s(pop.begin(), r); // create a span looking into the unique section
-    fronts_ = sorter_(s); // non-dominated sorting of the unique
+    }
+    std::copy(duplicates.begin(), duplicates.end(), order.begin() + static_cast<std::ptrdiff_t>(u));
+
+    // the rows of the fitness matrix in the new order
+    sorted_.resize(n * m);
+    for (size_t k = 0; k < n; ++k) {
+        std::copy_n(row(order[k]), m, sorted_.begin() + static_cast<std::ptrdiff_t>(k * m));
+    }
+    fitness_.swap(sorted_);
+
+    // apply the permutation (position k receives the individual at order[k]) by following its cycles
+    auto& done = visited_;
+    done.assign(n, false);
+    for (size_t k = 0; k < n; ++k) {
+        if (done[k] || order[k] == k) { continue; }
+        auto tmp = std::move(pop[k]);
+        auto j = k;
+        while (order[j] != k) {
+            pop[j] = std::move(pop[order[j]]);
+            done[j] = true;
+            j = order[j];
+        }
+        pop[j] = std::move(tmp);
+        done[j] = true;
+    }
+
+    Operon::Span<Operon::Scalar const> s(fitness_.data(), u * m); // the unique section of the fitness matrix
+    fronts_ = sorter_(s, m); // non-dominated sorting of the unique
     for (auto& f : fronts_) {
         std::stable_sort(f.begin(), f.end());
     } // sort the fronts for consistency between sorting algos
     fronts_.emplace_back(); // put the duplicates in the last front
-    for (; r < pop.end(); ++r) {
-        fronts_.back().push_back(std::distance(pop.begin(), r)); // copy duplicates in the last front
+    for (auto i = u; i < n; ++i) {
+        fronts_.back().push_back(i); // copy duplicates in the last front
+    }
+}
+
+auto NSGA2::Update() -> void
+{
+    auto const& sorter = sorter_.get();
+    auto eps = GetConfig().Epsilon;
+    auto pop = Population();
+    auto const n = pop.size();
+    auto const m = pop.front().Fitness.size();
+
+    fitness_.resize(n * m);
+    for (size_t i = 0; i < n; ++i) {
+        std::copy_n(pop[i].Fitness.begin(), m, fitness_.begin() + static_cast<std::ptrdiff_t>(i * m));
     }
-    UpdateDistance(pop); // calculate crowding distance
-    best_.clear();
-    std::transform(fronts_.front().begin(), fronts_.front().end(), std::back_inserter(best_), [&](auto i) { return pop[i]; }); // update best front
+    Operon::Span<Operon::Scalar const> fitness(fitness_.data(), fitness_.size());
+
+    // the parents survived reinsertion with their ranks intact (the crowded comparison keeps whole fronts, only the
+    // last one is truncated), so their fronts are given by the ranks. the duplicates were assigned the last rank.
+    ENSURE(!fronts_.empty());
+    auto const duplicateRank = fronts_.size() - 1;
+    NondominatedSorterBase::Result fronts;
+    auto& pending = order_;
+    pending.clear();
+    for (size_t i = 0; i < parents_.size(); ++i) {
+        auto r = pop[i].Rank;
+        if (r >= duplicateRank) { pending.push_back(i); continue; }
+        if (r >= fronts.size()) { fronts.resize(r + 1); }
+        fronts[r].push_back(i);
+    }
+    fronts.erase(std::remove_if(fronts.begin(), fronts.end(), [](auto const& f) { return f.empty(); }), fronts.end());
+    for (auto i = parents_.size(); i < n; ++i) { pending.push_back(i); }
+
+    auto& duplicates = duplicates_;
+    duplicates.clear();
+    for (auto i : pending) {
+        if (!sorter.Insert(fronts, fitness, m, i, eps)) { duplicates.push_back(i); }
+    }
+    for (auto& f : fronts) {
+        std::stable_sort(f.begin(), f.end());
+    }
+    fronts.push_back(duplicates);
+    fronts_.swap(fronts);
+}
+
+auto NSGA2::Best() const -> std::vector<Individual>
+{
+    std::vector<Individual> best;
+    std::copy_if(parents_.begin(), parents_.end(), std::back_inserter(best), [](auto const& ind) { return ind.Rank == 0; });
+    return best;
 }
 
 auto NSGA2::Run(tf::Executor& executor, Operon::RandomGenerator& random, std::function<void()> report) -> void
+{
+    std::vector<Operon::Vector<Operon::Scalar>> slots(executor.num_workers());
+    Run(executor, slots, random, std::move(report));
+}
+
+auto NSGA2::Run(Engine& engine, Operon::RandomGenerator& random, std::function<void()> report) -> void
+{
+    Run(engine.Executor(), engine.Buffers(), random, std::move(report));
+}
+
+auto NSGA2::Run(tf::Executor& executor, std::vector<Operon::Vector<Operon::Scalar>>& slots, Operon::RandomGenerator& random, std::function<void()> report) -> void
 {
     const auto& config = GetConfig();
     const auto& treeInit = GetTreeInitializer();
     const auto& coeffInit = GetCoefficientInitializer();
     const auto& generator = GetGenerator();
     const auto& reinserter = GetReinserter();
-    const auto& problem = GetProblem();
 
     auto t0 = std::chrono::steady_clock::now();
     auto elapsed = [t0]() {
@@ -109,78 +265,217 @@ auto NSGA2::Run(tf::Executor& executor, Operon::RandomGenerator& random, std::fu
         return static_cast<double>(std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count()) / ms;
     };
 
-    // random seeds for each thread
-    size_t s = std::max(config.PopulationSize, config.PoolSize);
-    std::vector<Operon::RandomGenerator> rngs;
-    for (size_t i = 0; i < s; ++i) {
-        rngs.emplace_back(random());
+    // the pipelined loop needs a second offspring buffer
+    if (pipelined_ && spare_.size() != config.PoolSize) {
+        individuals_.resize(config.PopulationSize + 2 * config.PoolSize);
+        parents_ = { individuals_.data(), config.PopulationSize };
+        offspring_ = { individuals_.data() + config.PopulationSize, config.PoolSize };
+        spare_ = { individuals_.data() + config.PopulationSize + config.PoolSize, config.PoolSize };
+    }
+
+    // every task derives its generator from the seed of the run, the generation and its index (see Random::Stream),
+    // generation 0 is the initialization and the offspring of generation g come from the streams of generation g + 1
+    // (a restored run continues with the seed of the checkpoint)
+    if (!restored_) {
+        seed_ = random();
     }
 
     auto const& evaluator = generator.Evaluator();
 
     // we want to allocate all the memory that will be necessary for evaluation (e.g. for storing model responses)
     // in one go and use it throughout the generations in order to minimize the memory pressure
-    auto trainSize = problem.TrainingRange().Size();
+    // (evaluators which stream the model response into the error metric do not need a buffer)
+    auto trainSize = evaluator.BufferSize();
 
-    ENSURE(executor.num_workers() > 0);
-    std::vector<Operon::Vector<Operon::Scalar>> slots(executor.num_workers());
+    ENSURE(executor.num_workers() > 0 && slots.size() >= executor.num_workers());
+
+    // memory accounting (see Memory): the evaluation buffers (at most one per worker) and, measured by the report
+    // step, the population
+    Memory::Account slotMemory(Memory::Subsystem::Evaluator, slots.size() * trainSize * sizeof(Operon::Scalar));
+    Memory::Account populationMemory(Memory::Subsystem::Population);
 
-    tf::Taskflow taskflow;
     std::atomic_bool terminate { false }; // flag to signal algorithm termination
 
+    // the optional termination criterion sees the best individual so far on the first objective, which the evaluating
+    // tasks keep per worker, and the first front of the last non-dominated sort
+    BestSoFar best(executor.num_workers());
+    auto offer = [&](Individual const& individual) {
+        if (termination_ != nullptr) { best.Offer(executor.this_worker_id(), individual); }
+    };
+    auto checkTermination = [&]() {
+        if (termination_ == nullptr) { return false; }
+        auto const m = parents_.front().Fitness.size();
+        front_.clear();
+        if (!fronts_.empty()) { // the rows of fitness_ are in the order of the sort
+            for (auto i : fronts_.front()) {
+                auto const row = fitness_.begin() + static_cast<std::ptrdiff_t>(i * m);
+                front_.insert(front_.end(), row, row + static_cast<std::ptrdiff_t>(m));
+            }
+        }
+        return (*termination_)({ generation_, best.Best(), { front_.data(), front_.size() }, m });
+    };
+    if (termination_ != nullptr) { termination_->Reset(); }
+
+    // cost-aware generation (for separable generators), see CostSchedule
+    CostSchedule costSchedule;
+
+    // timings (see Instrumentation): the parallel stages are timed by their tasks (cpu) and by an interval between
+    // the tasks before and after them (elapsed)
+    using Instrumentation::CpuTimer;
+    using Instrumentation::ScopedTimer;
+    using Stage = Instrumentation::Stage;
+    Instrumentation::Interval initializeTime;
+    Instrumentation::Interval evaluateTime;
+    Instrumentation::Interval offspringTime;
+    Instrumentation::Interval distanceTime;
+    auto reportProgress = [&]() {
+        ScopedTimer timer(Stage::Report);
+        // in the pipelined loop the next offspring are generated meanwhile, only the parents can be measured
+        auto const measured = pipelined_ ? parents_ : Operon::Span<Individual>(individuals_);
+        populationMemory.Update(Memory::Footprint(Operon::Span<Individual const>(measured.data(), measured.size())));
+        Memory::Enforce();
+        if (report) { std::invoke(report); }
+    };
+
+    auto generateByCost = [&](tf::Subflow& sf, Operon::Span<Individual> target, size_t first) {
+        CostSchedule::Context context { seed_, generation_, config.CrossoverProbability, config.MutationProbability, &slots };
+        costSchedule.Generate(executor, sf, generator, context, target, first, terminate, [&](Individual const& ind) {
+            if (archive_ != nullptr) { archive_->Insert(ind); }
+            offer(ind);
+        });
+    };
+
+    tf::Taskflow taskflow;
+
     // while loop control flow
     auto [init, cond, body, back, done] = taskflow.emplace(
         [&](tf::Subflow& subflow) {
+            if (restored_) { // the population of the checkpoint is already evaluated (and reported)
+                restored_ = false;
+                for (auto const& ind : parents_) { offer(ind); }
+                return;
+            }
+            initializeTime.Start();
             auto init = subflow.for_each_index(size_t{0}, parents_.size(), size_t{1}, [&](size_t i) {
+                CpuTimer timer(Stage::InitializePopulation);
+                if (seeds_ != nullptr && i < seeds_->Size()) { // stored models, as they were optimized
+                    parents_[i].Genotype = seeds_->GetTree(i);
+                    return;
+                }
+                auto rng = Random::Stream(seed_, 0, i);
                 // initialize tree
-                parents_[i].Genotype = treeInit(rngs[i]);
+                parents_[i].Genotype = treeInit(rng);
                 ENSURE(parents_[i].Genotype.Length() > 0);
                 // initialize tree coefficients
-                coeffInit(rngs[i], parents_[i].Genotype);
+                coeffInit(rng, parents_[i].Genotype);
             }).name("initialize population");
-            auto prepareEval = subflow.emplace([&]() { evaluator.Prepare(parents_); }).name("prepare evaluator");
+            auto prepareEval = subflow.emplace([&](tf::Subflow& sf) {
+                initializeTime.Stop(Stage::InitializePopulation);
+                {
+                    ScopedTimer timer(Stage::PrepareEvaluator);
+                    evaluator.Prepare(sf, parents_);
+                    sf.join();
+                }
+                evaluateTime.Start();
+            }).name("prepare evaluator");
             auto eval = subflow.for_each_index(size_t{0}, parents_.size(), size_t{1}, [&](size_t i) {
+                CpuTimer timer(Stage::EvaluatePopulation);
                 auto id = executor.this_worker_id();
                 // make sure the worker has a large enough buffer
                 if (slots[id].size() < trainSize) {
                     slots[id].resize(trainSize);
                 }
-                parents_[i].Fitness = evaluator(rngs[i], parents_[i], slots[id]);
+                auto rng = Random::Stream(seed_, 0, i, 1);
+                parents_[i].Fitness = evaluator(rng, parents_[i], slots[id]);
+                if (archive_ != nullptr) { archive_->Insert(parents_[i]); }
+                offer(parents_[i]);
             }).name("evaluate population");
-            auto updateRanks = subflow.emplace([&]() { Sort(parents_); }).name("update ranks");
-            auto reportProgress = subflow.emplace([&]() { if (report) { std::invoke(report); } }).name("report progress");
+            auto updateRanks = subflow.emplace([&]() {
+                evaluateTime.Stop(Stage::EvaluatePopulation);
+                ScopedTimer timer(Stage::NonDominatedSort);
+                Sort(parents_);
+            }).name("update ranks");
+            auto updateDistance = subflow.emplace([&](tf::Subflow& sf) {
+                distanceTime.Start();
+                UpdateDistance(sf, parents_);
+            }).name("update distance");
             init.precede(prepareEval);
             prepareEval.precede(eval);
             eval.precede(updateRanks);
-            updateRanks.precede(reportProgress);
+            updateRanks.precede(updateDistance);
+            if (!pipelined_) { // otherwise the report overlaps with the first generation
+                auto reportInit = subflow.emplace([&]() {
+                    distanceTime.Stop(Stage::UpdateDistance);
+                    reportProgress();
+                }).name("report progress");
+                updateDistance.precede(reportInit);
+            }
         }, // init
-        [&]() { return terminate || generation_ == config.Generations || elapsed() > static_cast<double>(config.TimeLimit); }, // loop condition
+        [&]() {
+            distanceTime.Stop(Stage::UpdateDistance); // if it was not stopped by the report
+            return terminate || generation_ == config.Generations || elapsed() > static_cast<double>(config.TimeLimit) || checkTermination();
+        }, // loop condition
         [&](tf::Subflow& subflow) {
-            auto prepareGenerator = subflow.emplace([&]() { generator.Prepare(parents_); }).name("prepare generator");
-            auto generateOffspring = subflow.for_each_index(size_t{0}, offspring_.size(), size_t{1}, [&](size_t i) {
-                auto buf = Operon::Span<Operon::Scalar>(slots[executor.this_worker_id()]);
-                while (!(terminate = generator.Terminate())) {
-                    if (auto result = generator(rngs[i], config.CrossoverProbability, config.MutationProbability, buf); result.has_value()) {
-                        offspring_[i] = std::move(result.value());
-                        ENSURE(offspring_[i].Genotype.Length() > 0);
-                        return;
-                    }
+            // in pipelined mode the offspring are generated into the spare buffer, the report on the previous
+            // generation reads the population in the meantime (it is not written before the non-dominated sort)
+            auto target = pipelined_ ? spare_ : offspring_;
+            auto prepareGenerator = subflow.emplace([&](tf::Subflow& sf) {
+                {
+                    ScopedTimer timer(Stage::PrepareGenerator);
+                    generator.Prepare(sf, parents_);
+                    sf.join();
                 }
-            }).name("generate offspring");
-            auto nonDominatedSort = subflow.emplace([&]() { Sort(individuals_); }).name("non-dominated sort");
-            auto reinsert = subflow.emplace([&]() { reinserter.Sort(individuals_); }).name("reinsert");
+                offspringTime.Start();
+            }).name("prepare generator");
+            auto generateOffspring = costAware_ && generator.Separable()
+                ? subflow.emplace([&, target](tf::Subflow& sf) { generateByCost(sf, target, size_t{0}); }).name("generate offspring")
+                : subflow.for_each_index(size_t{0}, target.size(), size_t{1}, [&, target](size_t i) {
+                    CpuTimer timer(Stage::GenerateOffspring);
+                    auto buf = Operon::Span<Operon::Scalar>(slots[executor.this_worker_id()]);
+                    // the previous occupant of the slot is discarded, its nodes are reused by the variation operators
+                    NodePool::Release(std::move(target[i].Genotype));
+                    auto rng = Random::Stream(seed_, generation_ + 1, i);
+                    while (!(terminate = generator.Terminate())) {
+                        if (generator.Generate(rng, config.CrossoverProbability, config.MutationProbability, buf, target[i])) {
+                            ENSURE(target[i].Genotype.Length() > 0);
+                            if (archive_ != nullptr) { archive_->Insert(target[i]); }
+                            offer(target[i]);
+                            return;
+                        }
+                    }
+                }).name("generate offspring");
+            auto nonDominatedSort = subflow.emplace([&]() {
+                offspringTime.Stop(Stage::GenerateOffspring);
+                ScopedTimer timer(Stage::NonDominatedSort);
+                if (pipelined_) { std::swap_ranges(spare_.begin(), spare_.end(), offspring_.begin()); }
+                if (sorter_.get().IsIncremental()) { Update(); } else { Sort(Population()); }
+            }).name("non-dominated sort");
+            auto updateDistance = subflow.emplace([&](tf::Subflow& sf) {
+                distanceTime.Start();
+                UpdateDistance(sf, Population());
+            }).name("update distance");
+            auto reinsert = subflow.emplace([&]() {
+                distanceTime.Stop(Stage::UpdateDistance);
+                ScopedTimer timer(Stage::Reinsert);
+                reinserter.Sort(Population());
+            }).name("reinsert");
             auto incrementGeneration = subflow.emplace([&]() { ++generation_; }).name("increment generation");
-            auto reportProgress = subflow.emplace([&]() { if (report) { std::invoke(report); } }).name("report progress");
+            auto reportGeneration = subflow.emplace(reportProgress).name("report progress");
 
             // set-up subflow graph
             prepareGenerator.precede(generateOffspring);
             generateOffspring.precede(nonDominatedSort);
-            nonDominatedSort.precede(reinsert);
+            nonDominatedSort.precede(updateDistance);
+            updateDistance.precede(reinsert);
             reinsert.precede(incrementGeneration);
-            incrementGeneration.precede(reportProgress);
+            if (pipelined_) {
+                reportGeneration.precede(nonDominatedSort); // reports the previous generation
+            } else {
+                incrementGeneration.precede(reportGeneration);
+            }
         }, // loop body (evolutionary main loop)
         [&]() { return 0; }, // jump back to the next iteration
-        [&]() { /* done nothing to do */ } // work done, report last gen and stop
+        [&]() { if (pipelined_) { reportProgress(); } } // work done, report last gen and stop
     ); // evolutionary loop
 
     init.name("init");
@@ -195,8 +490,43 @@ auto NSGA2::Run(tf::Executor& executor, Operon::RandomGenerator& random, std::fu
     body.precede(back);
     back.precede(cond);
 
-    executor.run(taskflow);
-    executor.wait_for_all();
+    // wait only for this taskflow, several algorithms can share the executor
+    executor.run(taskflow).wait();
+}
+
+auto NSGA2::SaveState(Operon::RandomGenerator const& random) const -> std::vector<std::byte>
+{
+    auto const& evaluator = GetGenerator().Evaluator();
+    CheckpointState state;
+    state.Generation = generation_;
+    state.ResidualEvaluations = evaluator.ResidualEvaluations();
+    state.JacobianEvaluations = evaluator.JacobianEvaluations();
+    state.EvaluationCount = evaluator.EvaluationCount();
+    state.Fronts = fronts_.size();
+    state.StreamSeed = seed_;
+    state.RandomStates.push_back(random.State());
+    return Checkpoint::Encode(state, { individuals_.data(), parents_.size() + offspring_.size() });
+}
+
+auto NSGA2::RestoreState(Operon::Span<std::byte const> buffer, Operon::RandomGenerator& random) -> void
+{
+    CheckpointState state;
+    auto individuals = Checkpoint::Decode(buffer, state);
+    if (individuals.size() != parents_.size() + offspring_.size() || state.RandomStates.size() != 1) {
+        throw std::runtime_error("NSGA2::RestoreState: the checkpoint does not match the configuration");
+    }
+    std::move(individuals.begin(), individuals.end(), individuals_.begin());
+
+    generation_ = state.Generation;
+    fronts_.assign(state.Fronts, {}); // the incremental update only needs the number of fronts
+    auto const& evaluator = GetGenerator().Evaluator();
+    evaluator.SetResidualEvaluations(state.ResidualEvaluations);
+    evaluator.SetJacobianEvaluations(state.JacobianEvaluations);
+    evaluator.SetEvaluationCounter(state.EvaluationCount);
+
+    random.SetState(state.RandomStates.front());
+    seed_ = state.StreamSeed;
+    restored_ = true;
 }
 
 auto NSGA2::Run(Operon::RandomGenerator& random, std::function<void()> report, size_t threads) -> void
@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <algorithm>
+#include <cmath>
+
+#include "operon/algorithms/termination.hpp"
+#include "operon/core/contracts.hpp"
+#include "operon/core/hypervolume.hpp"
+
+namespace Operon {
+
+auto StagnationWindow::Push(double value) -> bool
+{
+    values_[head_] = value;
+    head_ = (head_ + 1) % values_.size();
+    count_ = std::min(count_ + 1, values_.size());
+    return count_ == values_.size() && !(Improvement() > threshold_);
+}
+
+auto StagnationWindow::Improvement() const -> double
+{
+    if (count_ == 0) { return 0; }
+    auto const n = values_.size();
+    auto const newest = values_[(head_ + n - 1) % n];
+    auto const oldest = values_[(head_ + n - count_) % n];
+    return oldest - newest;
+}
+
+auto FitnessStagnation::operator()(TerminationState const& state) -> bool
+{
+    if (state.Best == nullptr) { return false; }
+    return window_.Push((*state.Best)[0]);
+}
+
+auto HypervolumeStagnation::operator()(TerminationState const& state) -> bool
+{
+    auto const m = state.Objectives;
+    if (state.Front.empty()) { return false; }
+    EXPECT(state.Front.size() % m == 0);
+    if (reference_.empty()) {
+        reference_ = Hypervolume::Reference(state.Front, m);
+    }
+    EXPECT(reference_.size() == m);
+    // the hypervolume is maximized
+    return window_.Push(-Hypervolume::Compute(state.Front, m, { reference_.data(), reference_.size() }));
+}
+
+auto ValidationPlateau::operator()(TerminationState const& state) -> bool
+{
+    if (state.Best == nullptr) { return false; }
+    auto const fitness = (*state.Best)[0];
+    if (!(fitness == fitness_)) { // a new best individual
+        fitness_ = fitness;
+        auto const score = score_(*state.Best);
+        if (std::isfinite(score)) { best_ = std::min(best_, score); }
+    }
+    return window_.Push(best_);
+}
+
+auto BestSoFar::Best() const -> Individual const*
+{
+    Slot const* best{nullptr};
+    for (auto const& slot : slots_) {
+        if (!slot.Best.Fitness.empty() && (best == nullptr || slot.Value < best->Value)) { best = &slot; }
+    }
+    return best == nullptr ? nullptr : &best->Best;
+}
+
+auto BestSoFar::Reset() -> void
+{
+    for (auto& slot : slots_) { slot = Slot{}; }
+}
+
+} // namespace Operon
@@ -0,0 +1,145 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <taskflow/taskflow.hpp>
+#include <thread>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "operon/core/affinity.hpp"
+
+namespace Operon::Affinity {
+    namespace {
+        thread_local size_t currentNode{0};
+
+        // the cores the process is allowed to run on
+        auto Allowed() -> std::vector<int>
+        {
+            std::vector<int> cores;
+#if defined(__linux__)
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+                for (int i = 0; i < CPU_SETSIZE; ++i) {
+                    if (CPU_ISSET(i, &set)) { cores.push_back(i); } // NOLINT
+                }
+            }
+#endif
+            if (cores.empty()) {
+                for (int i = 0; i < static_cast<int>(std::thread::hardware_concurrency()); ++i) { cores.push_back(i); }
+            }
+            return cores;
+        }
+
+        // parses a sysfs cpu list, eg. 0-3,8-11
+        auto ParseList(std::string const& str) -> std::vector<int>
+        {
+            std::vector<int> cores;
+            std::stringstream ss(str);
+            std::string range;
+            while (std::getline(ss, range, ',')) {
+                if (range.empty() || range == "\n") { continue; }
+                auto dash = range.find('-');
+                auto lo = std::stoi(range.substr(0, dash));
+                auto hi = dash == std::string::npos ? lo : std::stoi(range.substr(dash + 1));
+                for (auto i = lo; i <= hi; ++i) { cores.push_back(i); }
+            }
+            return cores;
+        }
+    } // namespace
+
+    auto ParsePolicy(std::string const& str) -> Policy
+    {
+        if (str == "none") { return Policy::None; }
+        if (str == "cores") { return Policy::Cores; }
+        if (str == "numa") { return Policy::NumaNodes; }
+        throw std::invalid_argument("unknown affinity policy " + str);
+    }
+
+    auto Nodes() -> std::vector<std::vector<int>>
+    {
+        auto allowed = Allowed();
+        std::vector<std::vector<int>> nodes;
+#if defined(__linux__)
+        for (size_t k = 0;; ++k) {
+            std::ifstream in("/sys/devices/system/node/node" + std::to_string(k) + "/cpulist");
+            if (!in) { break; }
+            std::string list;
+            std::getline(in, list);
+            std::vector<int> node;
+            for (auto c : ParseList(list)) {
+                if (std::find(allowed.begin(), allowed.end(), c) != allowed.end()) { node.push_back(c); }
+            }
+            if (!node.empty()) { nodes.push_back(std::move(node)); }
+        }
+#endif
+        if (nodes.empty()) { nodes.push_back(std::move(allowed)); }
+        return nodes;
+    }
+
+    auto BindToNode([[maybe_unused]] size_t node) -> bool
+    {
+#if defined(__linux__)
+        auto const nodes = Nodes();
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (auto c : nodes[node % nodes.size()]) { CPU_SET(c, &set); } // NOLINT
+        if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) { return false; }
+        currentNode = node % nodes.size();
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    auto CurrentNode() -> size_t { return currentNode; }
+
+    auto Pin([[maybe_unused]] tf::Executor& executor, Policy policy) -> bool
+    {
+        if (policy == Policy::None) { return true; }
+#if defined(__linux__)
+        auto const nodes = Nodes();
+        std::vector<int> cores;
+        for (auto const& node : nodes) { cores.insert(cores.end(), node.begin(), node.end()); }
+
+        auto const workers = executor.num_workers();
+        std::atomic_size_t arrived{0};
+        std::atomic_bool success{true};
+
+        tf::Taskflow taskflow;
+        for (size_t i = 0; i < workers; ++i) {
+            taskflow.emplace([&]() {
+                // every task waits until all of them have started, so each worker runs exactly one of them
+                ++arrived;
+                while (arrived < workers) { std::this_thread::yield(); }
+
+                auto const w = static_cast<size_t>(executor.this_worker_id());
+                if (policy == Policy::NumaNodes) {
+                    if (!BindToNode(w % nodes.size())) { success = false; }
+                    return;
+                }
+                auto const core = cores[w % cores.size()];
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                CPU_SET(core, &set); // NOLINT
+                if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) { success = false; }
+                for (size_t k = 0; k < nodes.size(); ++k) {
+                    if (std::find(nodes[k].begin(), nodes[k].end(), core) != nodes[k].end()) { currentNode = k; }
+                }
+            });
+        }
+        executor.run(taskflow).wait();
+        return success;
+#else
+        return false;
+#endif
+    }
+} // namespace Operon::Affinity
@@ -0,0 +1,128 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <algorithm>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#include "operon/core/allocation.hpp"
+
+namespace Operon::Memory {
+    namespace {
+        struct Policy {
+            std::mutex Lock;
+            AllocationPolicy Value;
+        };
+
+        auto GetPolicy() -> Policy&
+        {
+            static Policy policy;
+            return policy;
+        }
+
+        auto RoundUp(uintptr_t value, size_t size) -> uintptr_t { return (value + size - 1) / size * size; }
+        auto RoundDown(uintptr_t value, size_t size) -> uintptr_t { return value / size * size; }
+
+        auto Alignment(AllocationPolicy const& policy) -> std::align_val_t
+        {
+            return std::align_val_t{ std::max(policy.Alignment, alignof(std::max_align_t)) };
+        }
+
+        auto UsesHugePages(AllocationPolicy const& policy, size_t bytes) -> bool
+        {
+#if defined(__linux__)
+            return policy.Pages != PagePolicy::Default && bytes >= policy.Threshold;
+#else
+            return false;
+#endif
+        }
+
+#if defined(__linux__)
+        // a mapping of whole huge pages, aligned to a huge page (so that the kernel can back all of it with them)
+        auto MapHugePages(PagePolicy pages, size_t bytes) -> void*
+        {
+            auto const size = static_cast<size_t>(RoundUp(bytes, HugePageSize));
+            if (pages == PagePolicy::Explicit) {
+                auto* data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0); // NOLINT
+                if (data != MAP_FAILED) { return data; } // NOLINT
+            }
+            // one more huge page is reserved for the alignment, the unused head and tail are unmapped
+            auto const reserved = size + HugePageSize;
+            auto* data = ::mmap(nullptr, reserved, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0); // NOLINT
+            if (data == MAP_FAILED) { throw std::bad_alloc(); } // NOLINT
+            auto const first = reinterpret_cast<uintptr_t>(data); // NOLINT
+            auto const aligned = RoundUp(first, HugePageSize);
+            auto const head = aligned - first;
+            if (head > 0) { ::munmap(data, head); }
+            if (reserved - head > size) { ::munmap(reinterpret_cast<void*>(aligned + size), reserved - head - size); } // NOLINT
+            auto* result = reinterpret_cast<void*>(aligned); // NOLINT
+            ::madvise(result, size, MADV_HUGEPAGE);
+            return result;
+        }
+#endif
+    } // namespace
+
+    auto ParsePagePolicy(std::string const& str) -> PagePolicy
+    {
+        if (str == "none") { return PagePolicy::Default; }
+        if (str == "transparent") { return PagePolicy::Transparent; }
+        if (str == "explicit") { return PagePolicy::Explicit; }
+        throw std::invalid_argument("unknown huge page policy " + str);
+    }
+
+    auto SetAllocationPolicy(AllocationPolicy const& policy) -> void
+    {
+        if (policy.Alignment == 0 || (policy.Alignment & (policy.Alignment - 1)) != 0) {
+            throw std::invalid_argument("the alignment must be a power of two");
+        }
+        auto& p = GetPolicy();
+        std::lock_guard lock(p.Lock);
+        p.Value = policy;
+    }
+
+    auto GetAllocationPolicy() -> AllocationPolicy
+    {
+        auto& p = GetPolicy();
+        std::lock_guard lock(p.Lock);
+        return p.Value;
+    }
+
+    auto Allocate(AllocationPolicy const& policy, size_t bytes) -> void*
+    {
+#if defined(__linux__)
+        if (UsesHugePages(policy, bytes)) { return MapHugePages(policy.Pages, bytes); }
+#endif
+        return ::operator new(std::max(bytes, size_t{1}), Alignment(policy));
+    }
+
+    auto Deallocate(AllocationPolicy const& policy, void* data, size_t bytes) noexcept -> void
+    {
+        if (data == nullptr) { return; }
+#if defined(__linux__)
+        if (UsesHugePages(policy, bytes)) {
+            ::munmap(data, static_cast<size_t>(RoundUp(bytes, HugePageSize)));
+            return;
+        }
+#endif
+        ::operator delete(data, Alignment(policy));
+    }
+
+    auto Advise(void const* data, size_t bytes) -> void
+    {
+#if defined(__linux__)
+        if (data == nullptr || !UsesHugePages(GetAllocationPolicy(), bytes)) { return; }
+        auto const address = reinterpret_cast<uintptr_t>(data); // NOLINT
+        auto const first = RoundUp(address, HugePageSize);
+        auto const last = RoundDown(address + bytes, HugePageSize);
+        if (last > first) { ::madvise(reinterpret_cast<void*>(first), last - first, MADV_HUGEPAGE); } // NOLINT
+#else
+        static_cast<void>(data);
+        static_cast<void>(bytes);
+#endif
+    }
+} // namespace Operon::Memory
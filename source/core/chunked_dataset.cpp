@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include "operon/core/chunked_dataset.hpp"
+
+#include <fmt/core.h>
+#include <stdexcept>
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace Operon {
+
+namespace {
+    auto LoadBinary(std::string const& path) -> Dataset
+    {
+        if (!Dataset::IsBinary(path)) {
+            throw std::runtime_error(fmt::format("{}: not a binary dataset (see operon_convert_dataset)\n", path));
+        }
+        return Dataset(path);
+    }
+
+#if !defined(_WIN32)
+    // applies the advice to the pages holding rows [range.Start(), range.End()) of every column
+    // - outward rounding covers all the pages touching the range
+    // - inward rounding only covers the pages entirely inside the range (so neighbouring rows are not affected)
+    void Advise(Dataset const& dataset, Range range, int advice, bool outward)
+    {
+        if (range.Size() == 0) { return; }
+        static auto const page = static_cast<uintptr_t>(::sysconf(_SC_PAGESIZE));
+        for (size_t i = 0; i < dataset.Cols(); ++i) {
+            auto values = dataset.GetValues(static_cast<int>(i));
+            auto first = reinterpret_cast<uintptr_t>(values.data() + range.Start()); // NOLINT
+            auto last = reinterpret_cast<uintptr_t>(values.data() + range.End()); // NOLINT
+            first = outward ? first / page * page : (first + page - 1) / page * page;
+            last = outward ? (last + page - 1) / page * page : last / page * page;
+            if (last > first) {
+                ::madvise(reinterpret_cast<void*>(first), last - first, advice); // NOLINT
+            }
+        }
+    }
+#endif
+} // namespace
+
+ChunkedDataset::ChunkedDataset(std::string const& path, size_t blockRows, bool releaseBlocks)
+    : dataset_(LoadBinary(path))
+    , blockRows_(std::max(size_t{1}, blockRows))
+    , releaseBlocks_(releaseBlocks)
+{
+}
+
+void ChunkedDataset::Prefetch(Range range) const
+{
+#if !defined(_WIN32)
+    if (dataset_.IsView()) { Advise(dataset_, range, MADV_WILLNEED, /*outward=*/true); }
+#else
+    (void) range;
+#endif
+}
+
+void ChunkedDataset::Release(Range range) const
+{
+#if !defined(_WIN32)
+    if (dataset_.IsView()) { Advise(dataset_, range, MADV_DONTNEED, /*outward=*/false); }
+#else
+    (void) range;
+#endif
+}
+
+} // namespace Operon
@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include "operon/core/compact_tree.hpp"
+#include "operon/core/contracts.hpp"
+
+namespace Operon {
+
+CompactTree::CompactTree(Tree const& tree)
+    : hash_(tree.HashValue())
+{
+    auto const& nodes = tree.Nodes();
+    nodes_.reserve(nodes.size());
+    values_.reserve(nodes.size());
+    for (auto const& n : nodes) {
+        nodes_.push_back({ n.HashValue, n.Arity, n.Length, static_cast<uint8_t>(NodeTypes::GetIndex(n.Type)), n.IsEnabled });
+        values_.push_back(n.Value);
+    }
+}
+
+auto CompactTree::ToTree() const -> Tree
+{
+    Operon::Vector<Node> nodes;
+    nodes.reserve(nodes_.size());
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+        auto const& c = nodes_[i];
+        Node n(c.GetType(), c.HashValue);
+        n.Arity = c.Arity;
+        n.Length = c.Length;
+        n.IsEnabled = c.IsEnabled;
+        n.Value = values_[i];
+        nodes.push_back(n);
+    }
+    Tree tree(std::move(nodes));
+    if (!tree.Empty()) {
+        tree.UpdateNodes();
+    }
+    return tree;
+}
+
+auto CompactTree::GetCoefficients() const -> std::vector<Operon::Scalar>
+{
+    std::vector<Operon::Scalar> coefficients;
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+        if (nodes_[i].IsLeaf()) {
+            coefficients.push_back(values_[i]);
+        }
+    }
+    return coefficients;
+}
+
+void CompactTree::SetCoefficients(Operon::Span<Operon::Scalar const> coefficients)
+{
+    size_t idx = 0;
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+        if (nodes_[i].IsLeaf()) {
+            values_[i] = coefficients[idx++];
+        }
+    }
+    EXPECT(idx == coefficients.size());
+}
+
+} // namespace Operon
@@ -4,9 +4,26 @@
 #include <vstat/vstat.hpp>
 #include <aria-csv/parser.hpp>
 #include <fast_float/fast_float.h>
+#include <taskflow/taskflow.hpp>
+#include <cctype>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <numeric>
+#include <sstream>
+#include <thread>
 
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "operon/core/allocation.hpp"
 #include "operon/core/constants.hpp"
 #include "operon/core/dataset.hpp"
+#include "operon/core/executor.hpp"
 #include "operon/core/types.hpp"
 #include "operon/hash/hash.hpp"
 
@@ -26,25 +43,94 @@ namespace {
         std::sort(vars.begin(), vars.end(), [](auto &a, auto &b) { return a.Hash < b.Hash; });
         return vars;
     };
+
+    // central differences over the interior rows, one-sided differences on the first and the last row
+    auto Differentiate(Operon::Span<Operon::Scalar const> x, Operon::Scalar step) -> Operon::Vector<Operon::Scalar>
+    {
+        auto const n = x.size();
+        Operon::Vector<Operon::Scalar> d(n, Operon::Scalar{0});
+        if (n < 2) { return d; }
+        d.front() = (x[1] - x[0]) / step;
+        for (size_t i = 1; i + 1 < n; ++i) {
+            d[i] = (x[i + 1] - x[i - 1]) / (2 * step);
+        }
+        d.back() = (x[n - 1] - x[n - 2]) / step;
+        return d;
+    }
+
+    // fixed part of the binary header, followed by the variable records (hash, index, name length, name)
+    struct BinaryHeader {
+        std::array<char, 8> Magic;
+        uint32_t Version;
+        uint32_t ScalarSize;
+        uint64_t Rows;
+        uint64_t Cols;
+        uint64_t DataOffset; // multiple of Dataset::BinaryAlignment
+    };
+
+    struct BinaryContents {
+        std::vector<Variable> Variables;
+        Eigen::Index Rows;
+        Eigen::Index Cols;
+        Operon::Scalar const* Data;
+    };
+
+    auto ParseBinary(char const* bytes, size_t size, std::string const& path) -> BinaryContents
+    {
+        auto fail = [&](auto const& reason) { throw std::runtime_error(fmt::format("{}: {}\n", path, reason)); };
+        size_t pos{0};
+        auto read = [&](void* dst, size_t n) {
+            if (pos + n > size) { fail("unexpected end of file"); }
+            std::memcpy(dst, bytes + pos, n);
+            pos += n;
+        };
+
+        BinaryHeader header{};
+        read(&header, sizeof(header));
+        if (header.Magic != Dataset::BinaryMagic) { fail("not a binary dataset"); }
+        if (header.Version != Dataset::BinaryVersion) { fail(fmt::format("unsupported version {}", header.Version)); }
+        if (header.ScalarSize != sizeof(Operon::Scalar)) { fail(fmt::format("the values are stored with {} bytes per scalar, expected {}", header.ScalarSize, sizeof(Operon::Scalar))); }
+
+        std::vector<Variable> variables(header.Cols);
+        for (auto& v : variables) {
+            uint64_t index{0};
+            uint64_t length{0};
+            read(&v.Hash, sizeof(v.Hash));
+            read(&index, sizeof(index));
+            read(&length, sizeof(length));
+            if (index >= header.Cols) { fail("invalid variable index"); }
+            v.Index = index;
+            v.Name.resize(length);
+            read(v.Name.data(), length);
+        }
+        if (header.DataOffset < pos || header.DataOffset % Dataset::BinaryAlignment != 0 || header.DataOffset + header.Rows * header.Cols * sizeof(Operon::Scalar) > size) {
+            fail("invalid data offset");
+        }
+        std::sort(variables.begin(), variables.end(), [](auto& a, auto& b) { return a.Hash < b.Hash; });
+        return { std::move(variables), static_cast<Eigen::Index>(header.Rows), static_cast<Eigen::Index>(header.Cols), reinterpret_cast<Operon::Scalar const*>(bytes + header.DataOffset) }; // NOLINT
+    }
 } // namespace
 
 auto Dataset::ReadCsv(std::string const& path, bool hasHeader) -> Dataset::Matrix
 {
-    std::ifstream f(path);
-    aria::csv::CsvParser parser(f);
-
-    auto nrow = std::count(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>(), '\n');
-    // rewind the ifstream
-    f.clear();
-    f.seekg(0);
+    std::ifstream f(path, std::ios::binary);
+    if (!f) { throw std::runtime_error(fmt::format("{}: cannot open file\n", path)); }
+    std::string const buf((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    Operon::Span<char const> text(buf.data(), buf.size());
 
-    auto ncol{0UL};
-
-    Hasher hash;
-    Matrix m;
+    auto lineEnd = [&](size_t pos) {
+        auto p = std::find(text.begin() + pos, text.end(), '\n');
+        return static_cast<size_t>(p - text.begin());
+    };
 
+    size_t body{0}; // start of the data rows
+    size_t ncol{0};
     if (hasHeader) {
-        --nrow; // for matrix allocation, don't care about column names
+        auto end = lineEnd(0);
+        auto len = end > 0 && text[end - 1] == '\r' ? end - 1 : end;
+        std::istringstream header(std::string(text.data(), len));
+        aria::csv::CsvParser parser(header);
+        Hasher hash;
         for (auto const& row : parser) {
             for (auto const& field : row) {
                 auto h = hash(reinterpret_cast<uint8_t const*>(field.c_str()), field.size()); // NOLINT
@@ -54,33 +140,103 @@ auto Dataset::ReadCsv(std::string const& path, bool hasHeader) -> Dataset::Matri
             break; // read only the first row
         }
         std::sort(variables_.begin(), variables_.end(), [](auto& a, auto& b) { return a.Hash < b.Hash; });
-        m.resize(nrow, static_cast<Eigen::Index>(ncol));
+        body = std::min(end + 1, text.size());
     }
 
-    std::vector<Operon::Scalar> vec;
-    Eigen::Index rowIdx = 0;
+    // split the rows into chunks at line boundaries
+    auto const threads = std::max(size_t{1}, static_cast<size_t>(std::thread::hardware_concurrency()));
+    auto const chunkSize = std::max(size_t{1} << 20U, (text.size() - body) / (threads * 4) + 1);
+    std::vector<std::pair<size_t, size_t>> chunks;
+    for (auto pos = body; pos < text.size();) {
+        auto end = std::min(text.size(), lineEnd(std::min(text.size() - 1, pos + chunkSize)) + 1);
+        chunks.emplace_back(pos, end);
+        pos = end;
+    }
 
-    for (auto const& row : parser) {
-        size_t fieldIdx = 0;
-        for (auto const& field : row) {
-            Operon::Scalar v{0};
-            auto status = fast_float::from_chars(field.data(), field.data() + field.size(), v);
-            if(status.ec != std::errc()) {
-                throw std::runtime_error(fmt::format("failed to parse field {} at line {}\n", fieldIdx, rowIdx));
+    // the number of columns is given by the header or by the first row
+    if (ncol == 0 && !chunks.empty()) {
+        auto end = lineEnd(body);
+        ncol = 1 + static_cast<size_t>(std::count(text.begin() + body, text.begin() + end, ','));
+        variables_ = DefaultVariables(ncol);
+    }
+
+    // the end of the line starting at pos without the trailing whitespace, equal to pos for a blank line
+    auto trimmed = [&](size_t pos, size_t eol) {
+        while (eol > pos && std::isspace(static_cast<unsigned char>(text[eol - 1]))) { --eol; }
+        return eol;
+    };
+
+    // the chunks run on the shared executor, a single chunk is processed in place
+    auto forEachChunk = [&](auto&& f) {
+        std::vector<std::exception_ptr> errors(chunks.size());
+        auto run = [&](size_t c) {
+            try {
+                f(c);
+            } catch (...) {
+                errors[c] = std::current_exception();
             }
-            vec.push_back(v);
-            ++fieldIdx;
+        };
+        if (chunks.size() == 1) {
+            run(0);
+        } else {
+            tf::Taskflow taskflow;
+            taskflow.for_each_index(size_t{0}, chunks.size(), size_t{1}, run);
+            SharedExecutor().run(taskflow).wait();
         }
-        if (ncol == 0) {
-            ENSURE(!hasHeader);
-            ncol = vec.size();
-            m.resize(nrow, static_cast<Eigen::Index>(ncol));
-            variables_ = DefaultVariables(ncol);
+        for (auto const& e : errors) {
+            if (e) { std::rethrow_exception(e); }
         }
-        m.row(rowIdx) = Eigen::Map<Eigen::Array<Operon::Scalar, Eigen::Dynamic, 1>>(vec.data(), static_cast<Eigen::Index>(vec.size()));
-        vec.clear();
-        ++rowIdx;
-    }
+    };
+
+    // the first pass counts the data rows and the lines of every chunk, so that the second pass parses the fields
+    // directly into their place in the matrix and reports the line numbers of the file
+    std::vector<Eigen::Index> rows(chunks.size() + 1, 0);
+    std::vector<size_t> lines(chunks.size() + 1, 0);
+    lines.front() = hasHeader ? 1 : 0;
+    forEachChunk([&](size_t c) {
+        auto [pos, end] = chunks[c];
+        while (pos < end) {
+            auto eol = std::min(end, lineEnd(pos));
+            rows[c + 1] += static_cast<Eigen::Index>(trimmed(pos, eol) > pos);
+            lines[c + 1] += 1;
+            pos = eol + 1;
+        }
+    });
+    std::partial_sum(rows.begin(), rows.end(), rows.begin());
+    std::partial_sum(lines.begin(), lines.end(), lines.begin());
+
+    Matrix m(rows.back(), static_cast<Eigen::Index>(ncol));
+    forEachChunk([&](size_t c) {
+        auto [pos, end] = chunks[c];
+        auto row = rows[c];
+        auto line = lines[c] + 1; // one-based
+        for (; pos < end; ++line) {
+            auto eol = std::min(end, lineEnd(pos));
+            auto last = trimmed(pos, eol);
+            if (last > pos) {
+                size_t fieldIdx{0};
+                for (auto p = pos; p <= last; ++fieldIdx) {
+                    auto q = static_cast<size_t>(std::find(text.begin() + p, text.begin() + last, ',') - text.begin());
+                    auto a = p;
+                    auto b = q;
+                    while (a < b && (std::isspace(static_cast<unsigned char>(text[a])) || text[a] == '"')) { ++a; }
+                    while (b > a && (std::isspace(static_cast<unsigned char>(text[b - 1])) || text[b - 1] == '"')) { --b; }
+                    Operon::Scalar v{0};
+                    auto status = fast_float::from_chars(text.data() + a, text.data() + b, v);
+                    if (status.ec != std::errc() || fieldIdx >= ncol) {
+                        throw std::runtime_error(fmt::format("{}: failed to parse field {} at line {}\n", path, fieldIdx, line));
+                    }
+                    m(row, static_cast<Eigen::Index>(fieldIdx)) = v;
+                    p = q + 1;
+                }
+                if (fieldIdx != ncol) {
+                    throw std::runtime_error(fmt::format("{}: expected {} fields at line {}, got {}\n", path, ncol, line, fieldIdx));
+                }
+                ++row;
+            }
+            pos = eol + 1;
+        }
+    });
     return m;
 }
 
@@ -90,9 +246,141 @@ Dataset::Dataset(std::vector<std::vector<Operon::Scalar>> const& vals)
 }
 
 Dataset::Dataset(std::string const& path, bool hasHeader)
-    : values_(ReadCsv(path, hasHeader))
-    , map_(values_.data(), values_.rows(), values_.cols())
+    : map_(nullptr, 0, 0)
+{
+    if (IsBinary(path)) {
+        ReadBinary(path);
+        return;
+    }
+    if (IsParquet(path)) {
+        auto ds = ReadParquet(path);
+        Swap(ds);
+        return;
+    }
+    values_ = ReadCsv(path, hasHeader);
+    new (&map_) Map(values_.data(), values_.rows(), values_.cols()); // we use placement new (no allocation)
+    AdvisePages();
+    IndexColumns();
+}
+
+void Dataset::AdvisePages() const
+{
+    if (!IsView()) { Memory::Advise(values_.data(), static_cast<size_t>(values_.size()) * sizeof(Operon::Scalar)); }
+    Memory::Advise(single_.data(), static_cast<size_t>(single_.size()) * sizeof(float));
+}
+
+void Dataset::IndexColumns()
+{
+    columns_.clear();
+    columns_.reserve(variables_.size());
+    for (auto const& v : variables_) {
+        columns_.insert({ v.Hash, static_cast<Eigen::Index>(v.Index) });
+    }
+}
+
+auto Dataset::IsBinary(std::string const& path) -> bool
 {
+    std::ifstream f(path, std::ios::binary);
+    std::array<char, BinaryMagic.size()> magic{};
+    f.read(magic.data(), magic.size());
+    return f.gcount() == static_cast<std::streamsize>(magic.size()) && magic == BinaryMagic;
+}
+
+auto Dataset::ReadBinary(std::string const& path) -> void
+{
+#if defined(_WIN32)
+    // no memory mapping, the values are copied into an owned matrix
+    std::ifstream f(path, std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    auto contents = ParseBinary(bytes.data(), bytes.size(), path);
+    variables_ = std::move(contents.Variables);
+    values_ = Map(contents.Data, contents.Rows, contents.Cols);
+    new (&map_) Map(values_.data(), values_.rows(), values_.cols()); // we use placement new (no allocation)
+#else
+    auto fd = ::open(path.c_str(), O_RDONLY); // NOLINT
+    if (fd < 0) { throw std::runtime_error(fmt::format("{}: cannot open file\n", path)); }
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error(fmt::format("{}: cannot stat file\n", path));
+    }
+    auto size = static_cast<size_t>(st.st_size);
+    auto* addr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // the mapping stays valid
+    if (addr == MAP_FAILED) { throw std::runtime_error(fmt::format("{}: cannot map file\n", path)); } // NOLINT
+    storage_ = std::shared_ptr<void const>(addr, [size](void const* p) { ::munmap(const_cast<void*>(p), size); }); // NOLINT
+
+    auto contents = ParseBinary(static_cast<char const*>(addr), size, path);
+    variables_ = std::move(contents.Variables);
+    new (&map_) Map(contents.Data, contents.Rows, contents.Cols); // we use placement new (no allocation)
+#endif
+    IndexColumns();
+}
+
+auto Dataset::FromColumns(std::vector<std::string> const& names, std::vector<Operon::Span<Operon::Scalar const>> const& columns, std::shared_ptr<void const> owner) -> Dataset
+{
+    EXPECT(names.size() == columns.size());
+    EXPECT(!columns.empty());
+    auto const rows = columns.front().size();
+    EXPECT(std::all_of(columns.begin(), columns.end(), [&](auto const& c) { return c.size() == rows; }));
+
+    auto contiguous = true;
+    for (size_t i = 1; i < columns.size() && contiguous; ++i) {
+        contiguous = columns[i].data() == columns[i - 1].data() + rows;
+    }
+
+    auto const r = static_cast<Eigen::Index>(rows);
+    auto const c = static_cast<Eigen::Index>(columns.size());
+    if (contiguous) {
+        Dataset ds(columns.front().data(), r, c);
+        ds.storage_ = std::move(owner);
+        ds.SetVariableNames(names);
+        return ds;
+    }
+
+    Matrix m(r, c);
+    for (Eigen::Index j = 0; j < c; ++j) {
+        m.col(j) = Map(columns[static_cast<size_t>(j)].data(), r, 1);
+    }
+    Dataset ds(std::move(m));
+    ds.SetVariableNames(names);
+    return ds;
+}
+
+auto Dataset::IsParquet(std::string const& path) -> bool
+{
+    std::ifstream f(path, std::ios::binary);
+    std::array<char, 4> magic{};
+    f.read(magic.data(), magic.size());
+    return f.gcount() == static_cast<std::streamsize>(magic.size()) && magic == std::array<char, 4>{ 'P', 'A', 'R', '1' };
+}
+
+void Dataset::WriteBinary(std::string const& path) const
+{
+    std::ofstream f(path, std::ios::binary);
+    if (!f) { throw std::runtime_error(fmt::format("{}: cannot open file for writing\n", path)); }
+    auto write = [&](void const* src, size_t n) { f.write(static_cast<char const*>(src), static_cast<std::streamsize>(n)); };
+
+    size_t offset = sizeof(BinaryHeader);
+    for (auto const& v : variables_) { offset += sizeof(uint64_t) * 3 + v.Name.size(); }
+    auto const padding = (BinaryAlignment - offset % BinaryAlignment) % BinaryAlignment;
+
+    BinaryHeader header{ BinaryMagic, BinaryVersion, sizeof(Operon::Scalar), Rows(), Cols(), offset + padding };
+    write(&header, sizeof(header));
+    for (auto const& v : variables_) {
+        uint64_t index = v.Index;
+        uint64_t length = v.Name.size();
+        write(&v.Hash, sizeof(v.Hash));
+        write(&index, sizeof(index));
+        write(&length, sizeof(length));
+        write(v.Name.data(), length);
+    }
+    std::vector<char> zeros(padding, 0);
+    write(zeros.data(), zeros.size());
+    for (size_t i = 0; i < Cols(); ++i) {
+        write(map_.col(static_cast<Eigen::Index>(i)).data(), Rows() * sizeof(Operon::Scalar));
+    }
+    if (!f) { throw std::runtime_error(fmt::format("{}: failed to write the dataset\n", path)); }
 }
 
 Dataset::Dataset(Matrix vals)
@@ -100,12 +388,15 @@ Dataset::Dataset(Matrix vals)
     , values_(std::move(vals))
     , map_(values_.data(), values_.rows(), values_.cols())
 {
+    AdvisePages();
+    IndexColumns();
 }
 
 Dataset::Dataset(Matrix::Scalar const* data, Eigen::Index rows, Eigen::Index cols) // NOLINT
     : variables_(DefaultVariables(static_cast<size_t>(cols)))
     , map_(data, rows, cols)
 {
+    IndexColumns();
 }
 
 void Dataset::SetVariableNames(std::vector<std::string> const& names)
@@ -124,6 +415,7 @@ void Dataset::SetVariableNames(std::vector<std::string> const& names)
     }
 
     std::sort(variables_.begin(), variables_.end(), [&](auto& a, auto& b) { return a.Hash < b.Hash; });
+    IndexColumns();
 }
 
 auto Dataset::VariableNames() -> std::vector<std::string>
@@ -141,11 +433,110 @@ auto Dataset::GetValues(const std::string& name) const noexcept -> Operon::Span<
 
 auto Dataset::GetValues(Operon::Hash hashValue) const noexcept -> Operon::Span<const Operon::Scalar>
 {
-    auto it = std::partition_point(variables_.begin(), variables_.end(), [&](const auto& v) { return v.Hash < hashValue; });
-    bool variableExists = it != variables_.end() && it->Hash == hashValue;
-    ENSURE(variableExists);
-    auto idx = static_cast<Eigen::Index>(it->Index);
-    return {map_.col(idx).data(), static_cast<size_t>(map_.rows())};
+    if (auto it = columns_.find(hashValue); it != columns_.end()) {
+        return {map_.col(it->second).data(), static_cast<size_t>(map_.rows())};
+    }
+    auto const* column = FindVirtual(hashValue);
+    ENSURE(column != nullptr);
+    if (column->Type == VirtualColumn::Kind::Derivative) {
+        return { column->Values->data(), column->Values->size() };
+    }
+    // the source rows up to lag rows before the last one
+    auto const source = GetValues(column->Source);
+    return source.first(source.size() - std::min(column->Lag, source.size()));
+}
+
+auto Dataset::GetSingleValues(Operon::Hash hashValue) const noexcept -> Operon::Span<float const>
+{
+    if (auto it = columns_.find(hashValue); it != columns_.end()) {
+        auto const offset = static_cast<Eigen::Index>(map_.col(it->second).data() - map_.data());
+        return { single_.data() + offset, static_cast<size_t>(map_.rows()) };
+    }
+    auto const* column = FindVirtual(hashValue);
+    ENSURE(column != nullptr);
+    if (column->Type == VirtualColumn::Kind::Derivative) {
+        ENSURE(column->Single != nullptr);
+        return { column->Single->data(), column->Single->size() };
+    }
+    auto const source = GetSingleValues(column->Source);
+    return source.first(source.size() - std::min(column->Lag, source.size()));
+}
+
+auto Dataset::FindVirtual(Operon::Hash hashValue) const noexcept -> VirtualColumn const*
+{
+    auto it = std::find_if(virtualVariables_.begin(), virtualVariables_.end(), [&](auto const& v) { return v.Hash == hashValue; });
+    return it == virtualVariables_.end() ? nullptr : &virtualColumns_[static_cast<size_t>(it - virtualVariables_.begin())];
+}
+
+auto Dataset::FirstRow(Operon::Hash hashValue) const noexcept -> size_t
+{
+    return Rows() - GetValues(hashValue).size();
+}
+
+auto Dataset::AddVirtual(std::string name, VirtualColumn column) -> Variable
+{
+    if (!GetVariable(column.Source).has_value()) {
+        throw std::runtime_error("The source of the virtual column does not exist in the dataset.");
+    }
+    if (GetVariable(name).has_value()) {
+        throw std::runtime_error(fmt::format("The variable {} already exists in the dataset.", name));
+    }
+    auto h = Hasher{}(reinterpret_cast<uint8_t const*>(name.c_str()), name.size()); // NOLINT
+    Variable v { std::move(name), h, Cols() + virtualVariables_.size() };
+    virtualVariables_.push_back(v);
+    virtualColumns_.push_back(std::move(column));
+    return v;
+}
+
+auto Dataset::AddLag(Variable const& source, size_t lag, std::string name) -> Variable
+{
+    if (lag == 0 || lag >= Rows()) {
+        throw std::runtime_error(fmt::format("The lag {} is not between 1 and the number of rows ({}).", lag, Rows()));
+    }
+    // a lag of a lagged variable adds up with the lag of its source
+    if (auto const first = GetVariable(source.Hash).has_value() ? FirstRow(source.Hash) : 0; first + lag >= Rows()) {
+        throw std::runtime_error(fmt::format("The lag {} of {} leaves no rows (its values start at row {}).", lag, source.Name, first));
+    }
+    if (name.empty()) { name = fmt::format("{}_lag{}", source.Name, lag); }
+    return AddVirtual(std::move(name), { VirtualColumn::Kind::Lag, source.Hash, lag, Operon::Scalar{1}, nullptr, nullptr });
+}
+
+auto Dataset::AddDerivative(Variable const& source, Operon::Scalar step, std::string name) -> Variable
+{
+    if (!(step > 0)) {
+        throw std::runtime_error(fmt::format("The step {} of the derivative is not positive.", step));
+    }
+    if (name.empty()) { name = fmt::format("d{}", source.Name); }
+    auto v = AddVirtual(std::move(name), { VirtualColumn::Kind::Derivative, source.Hash, 0, step, nullptr, nullptr });
+    ComputeDerivative(virtualColumns_.back()); // the existing columns are up to date
+    return v;
+}
+
+void Dataset::ComputeDerivative(VirtualColumn& column)
+{
+    auto values = std::make_shared<Operon::Vector<Operon::Scalar>>(Differentiate(GetValues(column.Source), column.Step));
+    if constexpr (!std::is_same_v<Operon::Scalar, float>) {
+        column.Single = single_.size() > 0 ? std::make_shared<std::vector<float> const>(values->begin(), values->end()) : nullptr;
+    }
+    column.Values = std::move(values);
+}
+
+void Dataset::ComputeDerivatives()
+{
+    // in the order they were added, so a derivative of a derivative sees the new values of its source
+    for (auto& column : virtualColumns_) {
+        if (column.Type == VirtualColumn::Kind::Derivative) { ComputeDerivative(column); }
+    }
+}
+
+auto Dataset::VirtualSizeInBytes() const noexcept -> size_t
+{
+    size_t bytes{0};
+    for (auto const& column : virtualColumns_) {
+        if (column.Values != nullptr) { bytes += column.Values->size() * sizeof(Operon::Scalar); }
+        if (column.Single != nullptr) { bytes += column.Single->size() * sizeof(float); }
+    }
+    return bytes;
 }
 
 // this method needs to take an int argument to differentiate it from GetValues(Operon::Hash)
@@ -163,44 +554,187 @@ auto Dataset::GetVariable(const std::string& name) const noexcept -> std::option
 auto Dataset::GetVariable(Operon::Hash hashValue) const noexcept -> std::optional<Variable>
 {
     auto it = std::partition_point(variables_.begin(), variables_.end(), [&](const auto& v) { return v.Hash < hashValue; });
-    return it != variables_.end() && it->Hash == hashValue ? std::make_optional(*it) : std::nullopt;
+    if (it != variables_.end() && it->Hash == hashValue) { return std::make_optional(*it); }
+    auto jt = std::find_if(virtualVariables_.begin(), virtualVariables_.end(), [&](auto const& v) { return v.Hash == hashValue; });
+    return jt != virtualVariables_.end() ? std::make_optional(*jt) : std::nullopt;
+}
+
+auto Dataset::View() const -> Dataset
+{
+    Dataset view(map_.data(), map_.rows(), map_.cols());
+    view.variables_ = variables_;
+    view.columns_ = columns_;
+    view.storage_ = storage_;
+    view.virtualVariables_ = virtualVariables_;
+    view.virtualColumns_ = virtualColumns_;
+    // the single precision copy is not shared, a view has to store its own
+    return view;
+}
+
+void Dataset::StoreSinglePrecision()
+{
+    if constexpr (!std::is_same_v<Operon::Scalar, float>) {
+        single_ = map_.template cast<float>();
+        AdvisePages();
+        ComputeDerivatives(); // with their single precision copies
+    }
 }
 
 void Dataset::Shuffle(Operon::RandomGenerator& random)
 {
     if (IsView()) { throw std::runtime_error("Cannot shuffle. Dataset does not own the data.\n"); }
+    if (!virtualColumns_.empty()) { throw std::runtime_error("Cannot shuffle. The virtual columns depend on the order of the rows."); }
     Eigen::PermutationMatrix<Eigen::Dynamic, Eigen::Dynamic> perm(values_.rows());
     perm.setIdentity();
     // generate a random permutation
     Operon::Span<decltype(perm)::IndicesType::Scalar> idx(perm.indices().data(), perm.indices().size());
     std::shuffle(idx.begin(), idx.end(), random);
     values_ = perm * values_.matrix(); // permute rows
+    AdvisePages();
+    statistics_.Clear();
+    if (single_.size() > 0) { StoreSinglePrecision(); } // keep the single precision copy in sync
+}
+
+auto Dataset::Statistics(Operon::Hash hashValue, Range range) const -> ColumnStatistics
+{
+    EXPECT(range.End() <= Rows());
+    auto key = std::make_tuple(hashValue, range.Start(), range.End());
+    {
+        std::lock_guard<std::mutex> lock(statistics_.Mutex);
+        if (auto it = statistics_.Map.find(key); it != statistics_.Map.end()) {
+            return it->second;
+        }
+    }
+    auto const first = FirstRow(hashValue);
+    if (range.Start() < first) { throw std::runtime_error(fmt::format("The range starts at row {}, before the first value of the lagged variable (row {}).", range.Start(), first)); }
+    auto values = GetValues(hashValue).subspan(range.Start() - first, range.Size());
+    ColumnStatistics stats;
+    if (!values.empty()) {
+        auto acc = vstat::univariate::accumulate<Operon::Scalar>(values.data(), values.size());
+        auto [min, max] = std::minmax_element(values.begin(), values.end());
+        stats = { static_cast<double>(values.size()), acc.mean, acc.variance, static_cast<double>(*min), static_cast<double>(*max) };
+    }
+    std::lock_guard<std::mutex> lock(statistics_.Mutex);
+    statistics_.Map.insert({ key, stats });
+    return stats;
+}
+
+auto Dataset::Gather(Operon::Span<size_t const> rows) const -> Dataset
+{
+    Matrix m(static_cast<Eigen::Index>(rows.size()), map_.cols());
+    for (Eigen::Index j = 0; j < map_.cols(); ++j) {
+        auto const* src = map_.col(j).data();
+        auto* dst = m.col(j).data();
+        for (size_t i = 0; i < rows.size(); ++i) {
+            EXPECT(rows[i] < Rows());
+            dst[i] = src[rows[i]]; // NOLINT
+        }
+    }
+    Dataset ds(std::move(m));
+    ds.variables_ = variables_;
+    ds.IndexColumns();
+    ds.virtualVariables_ = virtualVariables_;
+    ds.virtualColumns_ = virtualColumns_;
+    if (single_.size() > 0) { ds.StoreSinglePrecision(); } else { ds.ComputeDerivatives(); }
+    return ds;
+}
+
+auto Dataset::Sample(Range range, size_t rows) const -> Dataset
+{
+    auto const n = std::min(rows, range.Size());
+    EXPECT(n > 0);
+
+    // the virtual columns follow the columns (see AddLag)
+    std::vector<Variable> variables(variables_.begin(), variables_.end());
+    variables.insert(variables.end(), virtualVariables_.begin(), virtualVariables_.end());
+    std::vector<std::vector<Operon::Scalar>> values(variables.size(), std::vector<Operon::Scalar>(n));
+    for (auto const& v : variables) {
+        auto const column = GetValues(v.Hash);
+        auto const first = FirstRow(v.Hash);
+        if (range.Start() < first) { throw std::runtime_error(fmt::format("The range starts at row {}, before the first value of {} (row {}).", range.Start(), v.Name, first)); }
+        auto& sample = values[v.Index];
+        for (size_t i = 0; i < n; ++i) {
+            sample[i] = column[range.Start() - first + i * range.Size() / n];
+        }
+    }
+    std::sort(variables.begin(), variables.end(), [](auto const& a, auto const& b) { return a.Hash < b.Hash; });
+    return { variables, values };
 }
 
 void Dataset::Normalize(size_t i, Range range)
 {
-    if (IsView()) { throw std::runtime_error("Cannot normalize. Dataset does not own the data.\n"); }
-    EXPECT(range.Start() + range.Size() <= static_cast<size_t>(values_.rows()));
-    auto j     = static_cast<Eigen::Index>(i);
-    auto start = static_cast<Eigen::Index>(range.Start());
-    auto size  = static_cast<Eigen::Index>(range.Size());
-    auto seg   = values_.col(j).segment(start, size);
-    auto min   = seg.minCoeff();
-    auto max   = seg.maxCoeff();
-    values_.col(j) = (values_.col(j).array() - min) / (max - min);
+    if (IsView() && i < Cols()) { throw std::runtime_error("Cannot normalize. Dataset does not own the data.\n"); }
+    Preprocess({ &i, 1 }, range, ColumnScaling::Normalize, 1);
 }
 
 // standardize column i using mean and stddev calculated over the specified range
 void Dataset::Standardize(size_t i, Range range)
 {
-    if (IsView()) { throw std::runtime_error("Cannot standardize. Dataset does not own the data.\n"); }
-    EXPECT(range.Start() + range.Size() <= static_cast<size_t>(values_.rows()));
-    auto j = static_cast<Eigen::Index>(i);
-    auto start = static_cast<Eigen::Index>(range.Start());
-    auto n = static_cast<Eigen::Index>(range.Size());
-    auto seg = values_.col(j).segment(start, n);
-    auto stats = vstat::univariate::accumulate<Matrix::Scalar>(seg.data(), seg.size());
-    auto stddev = std::sqrt(stats.variance);
-    values_.col(j) = (values_.col(j).array() - stats.mean) / stddev;
+    if (IsView() && i < Cols()) { throw std::runtime_error("Cannot standardize. Dataset does not own the data.\n"); }
+    Preprocess({ &i, 1 }, range, ColumnScaling::Standardize, 1);
+}
+
+void Dataset::Preprocess(Operon::Span<size_t const> columns, Range range, ColumnScaling scaling, size_t threads)
+{
+    // the virtual columns follow their sources
+    std::vector<Variable> variables;
+    for (auto i : columns) {
+        if (i >= Cols()) { continue; }
+        auto it = std::find_if(variables_.begin(), variables_.end(), [&](auto const& v) { return v.Index == i; });
+        ENSURE(it != variables_.end());
+        variables.push_back(*it);
+    }
+    if (variables.empty()) { return; }
+    if (IsView()) { throw std::runtime_error("Cannot preprocess. Dataset does not own the data.\n"); }
+    EXPECT(range.End() <= static_cast<size_t>(values_.rows()));
+
+    std::vector<ColumnTransform> transforms(variables.size());
+    auto transform = [&](size_t c) {
+        auto const& v = variables[c];
+        auto const stats = Statistics(v.Hash, range); // cached, the map is still valid
+        auto& t = transforms[c];
+        t = scaling == ColumnScaling::Standardize
+            ? ColumnTransform { stats.Mean, std::sqrt(stats.Variance) }
+            : ColumnTransform { stats.Min, stats.Max - stats.Min };
+        auto col = values_.col(static_cast<Eigen::Index>(v.Index));
+        col = (col - static_cast<Operon::Scalar>(t.Shift)) / static_cast<Operon::Scalar>(t.Scale);
+    };
+
+    if (threads == 0) { threads = std::max(size_t{1}, static_cast<size_t>(std::thread::hardware_concurrency())); }
+    if (threads == 1 || variables.size() == 1) {
+        for (size_t c = 0; c < variables.size(); ++c) { transform(c); }
+    } else {
+        tf::Taskflow taskflow;
+        taskflow.for_each_index(size_t{0}, variables.size(), size_t{1}, transform);
+        SharedExecutor(threads).run(taskflow).wait();
+    }
+
+    // the statistics of the transformed values follow from those of the original values
+    std::vector<std::pair<Operon::Hash, ColumnStatistics>> transformed;
+    for (size_t c = 0; c < variables.size(); ++c) {
+        auto const h = variables[c].Hash;
+        auto const& t = transforms[c];
+        auto const stats = Statistics(h, range);
+        transformed.emplace_back(h, ColumnStatistics { stats.Count, t.Apply(stats.Mean), stats.Variance / (t.Scale * t.Scale), t.Apply(stats.Min), t.Apply(stats.Max) });
+
+        // (x - s1) / k1 followed by (x - s2) / k2 is (x - s1 - s2 * k1) / (k1 * k2)
+        auto& composed = transforms_[h];
+        composed = { composed.Shift + t.Shift * composed.Scale, composed.Scale * t.Scale };
+    }
+    statistics_.Clear();
+    {
+        std::lock_guard<std::mutex> lock(statistics_.Mutex);
+        for (auto const& [h, stats] : transformed) {
+            statistics_.Map.insert({ std::make_tuple(h, range.Start(), range.End()), stats });
+        }
+    }
+    // keep the derivatives and the single precision copy in sync
+    if (single_.size() > 0) { StoreSinglePrecision(); } else { ComputeDerivatives(); }
+}
+
+auto Dataset::Transform(Operon::Hash hashValue) const -> ColumnTransform
+{
+    if (auto it = transforms_.find(hashValue); it != transforms_.end()) { return it->second; }
+    return {};
 }
 } // namespace Operon
@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <fmt/core.h>
+#include <limits>
+#include <stdexcept>
+
+#include "operon/core/dataset.hpp"
+
+#if defined(HAVE_ARROW)
+#include <arrow/api.h>
+#include <arrow/compute/cast.h>
+#include <arrow/io/file.h>
+#include <parquet/arrow/reader.h>
+#include <parquet/exception.h>
+#endif
+
+namespace Operon {
+
+auto Dataset::ReadParquet(std::string const& path, std::vector<std::string> const& columns) -> Dataset
+{
+#if defined(HAVE_ARROW)
+    using ArrowType = std::conditional_t<std::is_same_v<Operon::Scalar, float>, arrow::FloatType, arrow::DoubleType>;
+
+    std::shared_ptr<arrow::io::ReadableFile> file;
+    PARQUET_ASSIGN_OR_THROW(file, arrow::io::ReadableFile::Open(path));
+    std::unique_ptr<parquet::arrow::FileReader> reader;
+    PARQUET_THROW_NOT_OK(parquet::arrow::OpenFile(file, arrow::default_memory_pool(), &reader));
+
+    std::shared_ptr<arrow::Schema> schema;
+    PARQUET_THROW_NOT_OK(reader->GetSchema(&schema));
+
+    // column projection: only the requested columns are decoded
+    std::vector<int> indices;
+    std::vector<std::string> names;
+    if (columns.empty()) {
+        for (int i = 0; i < schema->num_fields(); ++i) {
+            indices.push_back(i);
+            names.push_back(schema->field(i)->name());
+        }
+    } else {
+        for (auto const& name : columns) {
+            auto i = schema->GetFieldIndex(name);
+            if (i < 0) { throw std::runtime_error(fmt::format("{}: column {} not found\n", path, name)); }
+            indices.push_back(i);
+            names.push_back(name);
+        }
+    }
+
+    std::shared_ptr<arrow::Table> table;
+    PARQUET_THROW_NOT_OK(reader->ReadTable(indices, &table));
+
+    // the columns are separate arrow buffers (possibly in several chunks), so they are copied into one matrix
+    auto const rows = static_cast<Eigen::Index>(table->num_rows());
+    Matrix m(rows, static_cast<Eigen::Index>(names.size()));
+    for (int j = 0; j < table->num_columns(); ++j) {
+        arrow::Datum cast;
+        PARQUET_ASSIGN_OR_THROW(cast, arrow::compute::Cast(arrow::Datum(table->column(j)), arrow::TypeTraits<ArrowType>::type_singleton()));
+        Eigen::Index row{0};
+        for (auto const& chunk : cast.chunked_array()->chunks()) {
+            auto const& values = static_cast<arrow::NumericArray<ArrowType> const&>(*chunk);
+            for (int64_t i = 0; i < values.length(); ++i, ++row) {
+                m(row, j) = values.IsNull(i) ? std::numeric_limits<Operon::Scalar>::quiet_NaN() : values.Value(i);
+            }
+        }
+    }
+    Dataset ds(std::move(m));
+    ds.SetVariableNames(names);
+    return ds;
+#else
+    (void) columns;
+    throw std::runtime_error(fmt::format("{}: operon was built without parquet support (USE_ARROW)\n", path));
+#endif
+}
+
+} // namespace Operon
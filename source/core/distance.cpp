@@ -2,25 +2,33 @@
 // SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
 
 #include "operon/core/distance.hpp"
-#include <vectorclass/vectorclass.h>
+#include "operon/core/contracts.hpp"
+#include "operon/core/executor.hpp"
+#include "operon/core/simd.hpp"
+#include <algorithm>
+#include <robin_hood.h>
+#include <taskflow/taskflow.hpp>
 
 namespace Operon::Distance {
     namespace detail {
-        template<typename T, size_t I = 0>
-        auto Check(T const* lhs, T const* rhs) {
-            using Vec = std::conditional_t<sizeof(T) == sizeof(uint32_t), Vec8ui, Vec4uq>;
-            static_assert(I >= 0 && I < Vec::size());
-            if constexpr(I == Vec::size() - 1) {
-                return Vec().load(lhs) == rhs[I];
+        // the lanes of a with a match in the first V::Size values of rhs
+        template<typename V, size_t I = 0>
+        inline auto Check(V a, typename V::Scalar const* rhs) noexcept
+        {
+            static_assert(I < V::Size);
+            if constexpr (I == V::Size - 1) {
+                return a == V(rhs[I]);
             } else {
-                return (Vec().load(lhs) == rhs[I]) | Check<T, I+1>(lhs, rhs);
+                return (a == V(rhs[I])) | Check<V, I+1>(a, rhs);
             }
         }
 
-        template<typename T, std::enable_if_t<std::is_integral_v<T> && (sizeof(T) == sizeof(uint32_t) || sizeof(T) == sizeof(uint64_t)), bool> = true>
-        constexpr inline auto Intersect(T const* lhs, T const* rhs) noexcept -> bool
+        // true if the blocks of S values starting at lhs and rhs have a value in common
+        template<typename T, size_t S, std::enable_if_t<std::is_integral_v<T> && (sizeof(T) == sizeof(uint32_t) || sizeof(T) == sizeof(uint64_t)), bool> = true>
+        inline auto Intersect(T const* lhs, T const* rhs) noexcept -> bool
         {
-            return horizontal_add(Check(lhs, rhs));
+            using V = Simd::Vec<std::remove_const_t<T>, S>;
+            return Simd::Any(Check(V::Load(lhs), rhs));
         }
 
         // this method only works when the hash vectors are sorted
@@ -39,7 +47,7 @@ namespace Operon::Distance {
             T const *q = q0;
 
             while(p < pS && q < qS) {
-                if (Intersect(p, q)) {
+                if (Intersect<T, S>(p, q)) {
                     break;
                 }
                 auto const a = *(p + S - 1);
@@ -89,4 +97,164 @@ namespace Operon::Distance {
         return 1 - 2 * static_cast<double>(c) / static_cast<double>(n);
     }
 
+    namespace {
+        // enumerates the tiles (bi, bj), bi <= bj, covering the upper triangle of the n x n distance matrix
+        auto Tiles(size_t n, size_t blockSize) -> std::vector<std::pair<size_t, size_t>>
+        {
+            auto const nb = (n + blockSize - 1) / blockSize;
+            std::vector<std::pair<size_t, size_t>> tiles;
+            tiles.reserve(nb * (nb + 1) / 2);
+            for (size_t bi = 0; bi < nb; ++bi) {
+                for (size_t bj = bi; bj < nb; ++bj) {
+                    tiles.emplace_back(bi, bj);
+                }
+            }
+            return tiles;
+        }
+
+        // calls f(i, j) for every pair i < j inside the tile
+        template<typename F>
+        inline auto VisitTile(size_t n, size_t blockSize, std::pair<size_t, size_t> tile, F&& f) -> void
+        {
+            auto [bi, bj] = tile;
+            auto const i1 = std::min(n, (bi + 1) * blockSize);
+            auto const j1 = std::min(n, (bj + 1) * blockSize);
+            for (auto i = bi * blockSize; i < i1; ++i) {
+                for (auto j = std::max(i + 1, bj * blockSize); j < j1; ++j) {
+                    f(i, j);
+                }
+            }
+        }
+    } // namespace
+
+    auto PairwiseMatrix(tf::Executor& executor, Operon::Span<Operon::Vector<Operon::Hash> const> sets, Operon::Span<double> result, DistanceFunction distance, size_t blockSize) -> void
+    {
+        auto const n = sets.size();
+        EXPECT(result.size() == n * n);
+        EXPECT(blockSize > 0);
+        std::fill(result.begin(), result.end(), 0.0);
+
+        auto tiles = Tiles(n, blockSize);
+        tf::Taskflow taskflow;
+        taskflow.for_each(tiles.begin(), tiles.end(), [&](auto const& tile) {
+            VisitTile(n, blockSize, tile, [&](size_t i, size_t j) {
+                result[i * n + j] = result[j * n + i] = distance(sets[i], sets[j]);
+            });
+        });
+        executor.run(taskflow).wait();
+    }
+
+    auto PairwiseMeans(tf::Executor& executor, Operon::Span<Operon::Vector<Operon::Hash> const> sets, DistanceFunction distance, size_t blockSize) -> Operon::Vector<double>
+    {
+        auto const n = sets.size();
+        EXPECT(blockSize > 0);
+        Operon::Vector<double> means(n, 0.0);
+        if (n < 2) {
+            return means;
+        }
+
+        // each worker accumulates into its own row of partial sums
+        auto const workers = executor.num_workers();
+        Operon::Vector<double> partial(workers * n, 0.0);
+
+        auto tiles = Tiles(n, blockSize);
+        tf::Taskflow taskflow;
+        taskflow.for_each(tiles.begin(), tiles.end(), [&](auto const& tile) {
+            auto const id = static_cast<size_t>(executor.this_worker_id());
+            auto* sums = partial.data() + id * n;
+            VisitTile(n, blockSize, tile, [&](size_t i, size_t j) {
+                auto d = distance(sets[i], sets[j]);
+                sums[i] += d;
+                sums[j] += d;
+            });
+        });
+        executor.run(taskflow).wait();
+
+        for (size_t w = 0; w < workers; ++w) {
+            for (size_t i = 0; i < n; ++i) {
+                means[i] += partial[w * n + i];
+            }
+        }
+        for (auto& m : means) {
+            m /= static_cast<double>(n - 1);
+        }
+        return means;
+    }
+
+    auto PairwiseMeans(Operon::Span<Operon::Vector<Operon::Hash> const> sets, size_t threads, DistanceFunction distance, size_t blockSize) -> Operon::Vector<double>
+    {
+        return PairwiseMeans(SharedExecutor(threads), sets, distance, blockSize);
+    }
+
+    namespace {
+        // splitmix64 finalizer, seeded differently for every signature slot (T is a hash or a vector of hashes)
+        template<typename T>
+        inline auto Mix(T x, T seed) noexcept -> T
+        {
+            T z = x + seed * T(0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * T(0xbf58476d1ce4e5b9ULL);
+            z = (z ^ (z >> 27)) * T(0x94d049bb133111ebULL);
+            return z ^ (z >> 31);
+        }
+    } // namespace
+
+    auto MinHash(Operon::Vector<Operon::Hash> const& hashes, Operon::Span<Operon::Hash> signature) noexcept -> void
+    {
+        // the slots are vectorized, every block of slots stays in a register over all the hashes
+        using V = Simd::Vec<Operon::Hash, std::max(size_t{2}, Simd::NativeLanes<Operon::Hash>)>;
+        size_t k = 0;
+        for (; k + V::Size <= signature.size(); k += V::Size) {
+            V const seed = V::Iota() + V(k + 1);
+            V m(std::numeric_limits<Operon::Hash>::max());
+            for (auto h : hashes) {
+                m = Simd::Min(m, Mix(V(h), seed));
+            }
+            m.Store(signature.data() + k);
+        }
+        for (; k < signature.size(); ++k) {
+            auto m = std::numeric_limits<Operon::Hash>::max();
+            for (auto h : hashes) {
+                m = std::min(m, Mix<Operon::Hash>(h, k + 1));
+            }
+            signature[k] = m;
+        }
+    }
+
+    auto MeanJaccardMinHash(Operon::Span<Operon::Vector<Operon::Hash> const> sets, size_t signatureSize, size_t threads) -> Operon::Vector<double>
+    {
+        auto const n = sets.size();
+        auto const k = signatureSize;
+        Operon::Vector<double> distances(n, 0.0);
+        if (n < 2 || k == 0) {
+            return distances;
+        }
+
+        auto& executor = SharedExecutor(threads);
+
+        // signatures are stored row-wise (one row per set), matches are counted column-wise (one column per slot)
+        Operon::Vector<Operon::Hash> signatures(n * k);
+        Operon::Vector<uint32_t> matches(n * k);
+
+        tf::Taskflow taskflow;
+        auto sign = taskflow.for_each_index(size_t{0}, n, size_t{1}, [&](size_t i) {
+            MinHash(sets[i], Operon::Span<Operon::Hash>(signatures.data() + i * k, k));
+        });
+        auto count = taskflow.for_each_index(size_t{0}, k, size_t{1}, [&](size_t j) {
+            robin_hood::unordered_flat_map<Operon::Hash, uint32_t> counts;
+            counts.reserve(n);
+            for (size_t i = 0; i < n; ++i) { ++counts[signatures[i * k + j]]; }
+            for (size_t i = 0; i < n; ++i) { matches[j * n + i] = counts[signatures[i * k + j]] - 1; } // exclude the set itself
+        });
+        auto reduce = taskflow.for_each_index(size_t{0}, n, size_t{1}, [&](size_t i) {
+            size_t sum{0};
+            for (size_t j = 0; j < k; ++j) { sum += matches[j * n + i]; }
+            distances[i] = 1.0 - static_cast<double>(sum) / static_cast<double>(k * (n - 1));
+        });
+        sign.precede(count);
+        count.precede(reduce);
+        executor.run(taskflow).wait();
+
+        return distances;
+    }
+
 } // namespace Operon::Distance
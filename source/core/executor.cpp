@@ -0,0 +1,26 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include "operon/core/executor.hpp"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <taskflow/taskflow.hpp>
+#include <thread>
+
+namespace Operon {
+    auto SharedExecutor(size_t threads) -> tf::Executor&
+    {
+        if (threads == 0) { threads = std::thread::hardware_concurrency(); }
+        threads = std::max(size_t{1}, threads);
+
+        static std::mutex lock;
+        static std::map<size_t, std::unique_ptr<tf::Executor>> executors;
+        std::scoped_lock guard(lock);
+        auto& executor = executors[threads];
+        if (!executor) { executor = std::make_unique<tf::Executor>(threads); }
+        return *executor;
+    }
+} // namespace Operon
@@ -1,170 +1,440 @@
 // SPDX-License-Identifier: MIT
 // SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
 
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <mutex>
+#include <string_view>
+#include <taskflow/taskflow.hpp>
+#include <type_traits>
+#include <unordered_set>
+
 #include "operon/core/format.hpp"
 #include "operon/core/dataset.hpp"
 
 namespace Operon {
 
-void TreeFormatter::FormatNode(Tree const& tree, std::unordered_map<Operon::Hash, std::string> variableNames, size_t i, std::string& current, std::string indent, bool isLast, bool initialMarker, int decimalPrecision)
-{
-    std::string const last{"└── "};
-    std::string const notLast{"├── "};
+namespace {
+    constexpr bool SinglePrecision = std::is_same_v<Operon::Scalar, float>;
 
-    current += indent;
+    // a literal which reads back to the same value
+    auto Literal(Operon::Scalar value) -> std::string
+    {
+        if (std::isnan(value)) { return "NAN"; }
+        if (std::isinf(value)) { return value > 0 ? "INFINITY" : "(-INFINITY)"; }
+        auto str = SinglePrecision ? fmt::format("{:#.9g}f", value) : fmt::format("{:#.17g}", value);
+        return value < 0 ? fmt::format("({})", str) : str;
+    }
 
-    if (initialMarker) {
-        current += isLast ? last : notLast;
+    // the math function in the precision of the scalar
+    auto MathFunction(std::string const& name) -> std::string
+    {
+        return SinglePrecision ? name + "f" : name;
     }
+} // namespace
 
-    const auto& s = tree[i];
-    if (s.IsConstant()) {
-        auto formatString = fmt::format("{{:.{}f}}", decimalPrecision);
-        fmt::format_to(std::back_inserter(current), formatString, s.Value);
-    } else if (s.IsVariable()) {
-        auto formatString = fmt::format(s.Value < 0 ? "({{:.{}f}}) * {{}}" : "{{:.{}f}} * {{}}", decimalPrecision);
+namespace {
+    // the pending work of the infix formatter: the nodes and the text between them, popped in output order
+    struct InfixStep {
+        enum class Kind : uint8_t { Visit, Text, Separator } Type;
+        size_t Index;          // visit, separator
+        std::string_view Text; // text
+    };
 
+    // the pending nodes of the tree formatter, with the length of their indentation
+    struct TreeStep {
+        size_t Index;
+        size_t Indent;
+        bool IsLast;
+        bool Marker;
+    };
+
+    auto Name(std::unordered_map<Operon::Hash, std::string> const& variableNames, Node const& s) -> std::string const&
+    {
         if (auto it = variableNames.find(s.HashValue); it != variableNames.end()) {
-            fmt::format_to(std::back_inserter(current), formatString, s.Value, it->second);
-        } else {
-            throw std::runtime_error(fmt::format("A variable with hash value {} could not be found in the dataset.\n", s.HashValue));
+            return it->second;
         }
-    } else {
-        fmt::format_to(std::back_inserter(current), "{}", s.Name());
+        throw std::runtime_error(fmt::format("A variable with hash value {} could not be found in the dataset.\n", s.HashValue));
     }
-    fmt::format_to(std::back_inserter(current), " D:{} L:{} N:{}\n", s.Depth, s.Level, s.Length + 1);
 
-    if (s.IsLeaf()) {
-        return;
+    auto VariableNames(Dataset const& dataset) -> std::unordered_map<Operon::Hash, std::string>
+    {
+        std::unordered_map<Operon::Hash, std::string> variableNames;
+        for (auto const& var : dataset.Variables()) {
+            variableNames.insert({ var.Hash, var.Name });
+        }
+        return variableNames;
     }
+} // namespace
 
-    if (i != tree.Length() - 1) {
-        indent += isLast ? "    " : "│   ";
-    }
+// a stack of the pending nodes over the preorder, the children are visited from the last one in postfix order (the
+// first child of the node) like the tree iterator
+void TreeFormatter::Format(TreeView tree, std::unordered_map<Operon::Hash, std::string> const& variableNames, fmt::memory_buffer& out, int decimalPrecision)
+{
+    if (tree.Length() == 0) { return; }
+    auto append = [&](std::string_view text) { out.append(text.data(), text.data() + text.size()); };
+    std::string_view const last{"└── "};
+    std::string_view const notLast{"├── "};
+
+    std::string indent;
+    std::vector<TreeStep> stack{ { tree.Length() - 1, 0, /*isLast=*/true, /*marker=*/false } };
+    while (!stack.empty()) {
+        auto [i, length, isLast, marker] = stack.back();
+        stack.pop_back();
+
+        // the indentation of a node is a prefix of the current one (the siblings before it share it)
+        indent.resize(length);
+        append(indent);
+        if (marker) {
+            append(isLast ? last : notLast);
+        }
 
-    size_t count = 0;
-    for (auto it = tree.Children(i); it.HasNext(); ++it) {
-        FormatNode(tree, variableNames, it.Index(), current, indent, ++count == s.Arity, /*initialMarker=*/true, decimalPrecision);
+        auto const& s = tree[i];
+        if (s.IsConstant()) {
+            fmt::format_to(std::back_inserter(out), "{:.{}f}", s.Value, decimalPrecision);
+        } else if (s.IsVariable()) {
+            auto const& name = Name(variableNames, s);
+            if (s.Value < 0) {
+                fmt::format_to(std::back_inserter(out), "({:.{}f}) * {}", s.Value, decimalPrecision, name);
+            } else {
+                fmt::format_to(std::back_inserter(out), "{:.{}f} * {}", s.Value, decimalPrecision, name);
+            }
+        } else {
+            append(s.Name());
+        }
+        fmt::format_to(std::back_inserter(out), " D:{} L:{} N:{}\n", s.Depth, s.Level, s.Length + 1);
+
+        if (s.IsLeaf()) {
+            continue;
+        }
+
+        if (i != tree.Length() - 1) {
+            indent += isLast ? "    " : "│   ";
+        }
+
+        auto const mark = stack.size();
+        size_t count = 0;
+        for (auto it = tree.Children(i); it.HasNext(); ++it) {
+            stack.push_back({ it.Index(), indent.size(), ++count == s.Arity, /*marker=*/true });
+        }
+        std::reverse(stack.begin() + static_cast<std::ptrdiff_t>(mark), stack.end());
     }
 }
 
-auto TreeFormatter::Format(Tree const& tree, Dataset const& dataset, int decimalPrecision) -> std::string
+auto TreeFormatter::Format(TreeView tree, Dataset const& dataset, int decimalPrecision) -> std::string
 {
-    std::unordered_map<Operon::Hash, std::string> variableNames;
-    for (auto const& var : dataset.Variables()) {
-        variableNames.insert({ var.Hash, var.Name });
-    }
-
-    std::string result;
-    FormatNode(tree, variableNames, tree.Length() - 1, result, "", /*isLast=*/true, /*initialMarker=*/false, decimalPrecision);
-    return result;
+    return Format(tree, VariableNames(dataset), decimalPrecision);
 }
 
-auto TreeFormatter::Format(Tree const& tree, std::unordered_map<Operon::Hash, std::string> const& variableNames, int decimalPrecision) -> std::string
+auto TreeFormatter::Format(TreeView tree, std::unordered_map<Operon::Hash, std::string> const& variableNames, int decimalPrecision) -> std::string
 {
-    std::string result;
-    FormatNode(tree, variableNames, tree.Length() - 1, result, "", /*isLast=*/true, /*initialMarker=*/false, decimalPrecision);
-    return result;
+    fmt::memory_buffer result;
+    Format(tree, variableNames, result, decimalPrecision);
+    return { result.begin(), result.end() };
 }
 
-void InfixFormatter::FormatNode(Tree const& tree, std::unordered_map<Operon::Hash, std::string> const& variableNames, size_t i, fmt::memory_buffer& current, int decimalPrecision)
+// a stack of the pending steps: a node writes its prefix and pushes its children and the text between them
+void InfixFormatter::Format(TreeView tree, std::unordered_map<Operon::Hash, std::string> const& variableNames, fmt::memory_buffer& out, int decimalPrecision)
 {
-    const auto& s = tree[i];
-    if (s.IsConstant()) {
-        auto formatString = fmt::format(s.Value < 0 ? "({{:.{}f}})" : "{{:.{}f}}", decimalPrecision);
-        fmt::format_to(std::back_inserter(current), formatString, s.Value);
-    } else if (s.IsVariable()) {
-        auto formatString = fmt::format(s.Value < 0 ? "(({{:.{}f}}) * {{}})" : "({{:.{}f}} * {{}})", decimalPrecision);
-        if (auto it = variableNames.find(s.HashValue); it != variableNames.end()) {
-            fmt::format_to(std::back_inserter(current), formatString, s.Value, it->second);
-        } else {
-            throw std::runtime_error(fmt::format("A variable with hash value {} could not be found in the dataset.\n", s.HashValue));
+    if (tree.Length() == 0) { return; }
+    auto append = [&](std::string_view text) { out.append(text.data(), text.data() + text.size()); };
+
+    std::vector<InfixStep> stack{ { InfixStep::Kind::Visit, tree.Length() - 1, {} } };
+    std::vector<InfixStep> steps; // the steps of the current node, in output order
+    auto visit = [&](size_t i) { steps.push_back({ InfixStep::Kind::Visit, i, {} }); };
+    auto text = [&](std::string_view t) { steps.push_back({ InfixStep::Kind::Text, 0, t }); };
+
+    while (!stack.empty()) {
+        auto step = stack.back();
+        stack.pop_back();
+        if (step.Type == InfixStep::Kind::Text) {
+            append(step.Text);
+            continue;
         }
-    } else {
-        if (s.Type < NodeType::Abs) // add, sub, mul, div, aq, fmax, fmin, pow
-        {
-            fmt::format_to(std::back_inserter(current), "(");
+        if (step.Type == InfixStep::Kind::Separator) {
+            fmt::format_to(std::back_inserter(out), " {} ", tree[step.Index].Name());
+            continue;
+        }
+
+        auto const i = step.Index;
+        auto const& s = tree[i];
+        steps.clear();
+        if (s.IsConstant()) {
+            if (s.Value < 0) {
+                fmt::format_to(std::back_inserter(out), "({:.{}f})", s.Value, decimalPrecision);
+            } else {
+                fmt::format_to(std::back_inserter(out), "{:.{}f}", s.Value, decimalPrecision);
+            }
+        } else if (s.IsVariable()) {
+            auto const& name = Name(variableNames, s);
+            if (s.Value < 0) {
+                fmt::format_to(std::back_inserter(out), "(({:.{}f}) * {})", s.Value, decimalPrecision, name);
+            } else {
+                fmt::format_to(std::back_inserter(out), "({:.{}f} * {})", s.Value, decimalPrecision, name);
+            }
+        } else if (s.Type < NodeType::Abs) { // add, sub, mul, div, aq, fmax, fmin, pow
+            append("(");
             if (s.Arity == 1) {
                 if (s.Type == NodeType::Sub) {
                     // subtraction with a single argument is a negation -x
-                    fmt::format_to(std::back_inserter(current), "-");
+                    append("-");
                 } else if (s.Type == NodeType::Div) {
                     // division with a single argument is an inversion 1/x
-                    fmt::format_to(std::back_inserter(current), "1 / ");
+                    append("1 / ");
                 }
             } else if (s.Type == NodeType::Pow) {
                 // format pow(a,b) as a^b
                 auto j = i - 1;
                 auto k = j - tree[j].Length - 1;
-                FormatNode(tree, variableNames, j, current, decimalPrecision);
-                fmt::format_to(std::back_inserter(current), " ^ ");
-                FormatNode(tree, variableNames, k, current, decimalPrecision);
+                visit(j);
+                text(" ^ ");
+                visit(k);
             } else if (s.Type == NodeType::Aq) {
                 // format aq(a,b) as a / (1 + b^2)
                 auto j = i - 1;
                 auto k = j - tree[j].Length - 1;
-                FormatNode(tree, variableNames, j, current, decimalPrecision);
-                fmt::format_to(std::back_inserter(current), " / (sqrt(1 + ");
-                FormatNode(tree, variableNames, k, current, decimalPrecision);
-                fmt::format_to(std::back_inserter(current), " ^ 2))");
+                visit(j);
+                text(" / (sqrt(1 + ");
+                visit(k);
+                text(" ^ 2))");
             } else {
                 size_t count = 0;
                 for (auto it = tree.Children(i); it.HasNext(); ++it) {
-                    FormatNode(tree, variableNames, it.Index(), current, decimalPrecision);
+                    visit(it.Index());
                     if (++count < s.Arity) {
-                        fmt::format_to(std::back_inserter(current), " {} ", s.Name());
+                        steps.push_back({ InfixStep::Kind::Separator, i, {} });
                     }
                 }
             }
-            fmt::format_to(std::back_inserter(current), ")");
+            text(")");
         } else { // unary operators abs, asin, ... log, exp, sin, etc.
             if (s.Type == NodeType::Square) {
                 // format square(a) as a ^ 2
-                fmt::format_to(std::back_inserter(current), "(");
-                FormatNode(tree, variableNames, i - 1, current, decimalPrecision);
-                fmt::format_to(std::back_inserter(current), " ^ 2)");
+                append("(");
+                visit(i - 1);
+                text(" ^ 2)");
             } else if (s.Type == NodeType::Logabs) {
                 // format logabs(a) as log(abs(a))
-                fmt::format_to(std::back_inserter(current), "log(abs(");
-                FormatNode(tree, variableNames, i - 1, current, decimalPrecision);
-                fmt::format_to(std::back_inserter(current), "))");
+                append("log(abs(");
+                visit(i - 1);
+                text("))");
             } else if (s.Type == NodeType::Log1p) {
                 // format log1p(a) as log(a+1)
-                fmt::format_to(std::back_inserter(current), "log(");
-                FormatNode(tree, variableNames, i - 1, current, decimalPrecision);
-                fmt::format_to(std::back_inserter(current), "+1)");
+                append("log(");
+                visit(i - 1);
+                text("+1)");
             } else if (s.Type == NodeType::Sqrtabs) {
                 // format sqrtabs(a) as sqrt(abs(a))
-                fmt::format_to(std::back_inserter(current), "sqrt(abs(");
-                FormatNode(tree, variableNames, i - 1, current, decimalPrecision);
-                fmt::format_to(std::back_inserter(current), "))");
+                append("sqrt(abs(");
+                visit(i - 1);
+                text("))");
             } else {
-                fmt::format_to(std::back_inserter(current), "{}", s.Name());
-                fmt::format_to(std::back_inserter(current), "(");
-                FormatNode(tree, variableNames, i - 1, current, decimalPrecision);
-                fmt::format_to(std::back_inserter(current), ")");
+                append(s.Name());
+                append("(");
+                visit(i - 1);
+                text(")");
             }
         }
+        stack.insert(stack.end(), steps.rbegin(), steps.rend());
     }
 }
 
-auto InfixFormatter::Format(Tree const& tree, Dataset const& dataset, int decimalPrecision) -> std::string
+auto InfixFormatter::Format(TreeView tree, Dataset const& dataset, int decimalPrecision) -> std::string
 {
-    std::unordered_map<Operon::Hash, std::string> variableNames;
-    for (auto const& var : dataset.Variables()) {
-        variableNames.insert({ var.Hash, var.Name });
-    }
-    fmt::memory_buffer result;
-    FormatNode(tree, variableNames, tree.Length() - 1, result, decimalPrecision);
-    return { result.begin(), result.end() };
+    return Format(tree, VariableNames(dataset), decimalPrecision);
 }
 
-auto InfixFormatter::Format(Tree const& tree, std::unordered_map<Operon::Hash, std::string> const& variableNames, int decimalPrecision) -> std::string
+auto InfixFormatter::Format(TreeView tree, std::unordered_map<Operon::Hash, std::string> const& variableNames, int decimalPrecision) -> std::string
 {
     fmt::memory_buffer result;
-    FormatNode(tree, variableNames, tree.Length() - 1, result, decimalPrecision);
+    Format(tree, variableNames, result, decimalPrecision);
     return { result.begin(), result.end() };
 }
 
-} // namespace Operon
+namespace {
+    // formats the trees get(0), ..., get(n-1) on the executor
+    template<typename Get>
+    auto FormatParallel(tf::Executor& executor, size_t n, Get&& get, std::unordered_map<Operon::Hash, std::string> const& variableNames, int decimalPrecision) -> std::vector<std::string>
+    {
+        std::vector<std::string> result(n);
+        if (n == 0) { return result; }
+
+        // a few chunks per worker, every chunk reuses one buffer
+        auto const chunks = std::min(n, executor.num_workers() * 4UL);
+        auto const chunkSize = (n + chunks - 1) / chunks;
 
+        std::mutex lock;
+        std::exception_ptr error;
+
+        tf::Taskflow taskflow;
+        taskflow.for_each_index(size_t { 0 }, n, chunkSize, [&](size_t first) {
+            auto const last = std::min(first + chunkSize, n);
+            fmt::memory_buffer buffer;
+            try {
+                for (auto i = first; i < last; ++i) {
+                    buffer.clear();
+                    InfixFormatter::Format(get(i), variableNames, buffer, decimalPrecision);
+                    result[i].assign(buffer.begin(), buffer.end());
+                }
+            } catch (...) {
+                std::scoped_lock guard(lock);
+                if (!error) { error = std::current_exception(); }
+            }
+        });
+        executor.run(taskflow).wait();
+
+        if (error) { std::rethrow_exception(error); }
+        return result;
+    }
+} // namespace
+
+auto InfixFormatter::FormatMany(tf::Executor& executor, Operon::Span<Tree const> trees, std::unordered_map<Operon::Hash, std::string> const& variableNames, int decimalPrecision) -> std::vector<std::string>
+{
+    return FormatParallel(executor, trees.size(), [&](size_t i) -> TreeView { return trees[i]; }, variableNames, decimalPrecision);
+}
+
+auto InfixFormatter::FormatMany(tf::Executor& executor, Operon::Span<Individual const> individuals, Dataset const& dataset, int decimalPrecision) -> std::vector<std::string>
+{
+    return FormatParallel(executor, individuals.size(), [&](size_t i) -> TreeView { return individuals[i].Genotype; }, VariableNames(dataset), decimalPrecision);
+}
+
+auto CodeFormatter::Format(TreeView tree, std::vector<std::pair<Operon::Hash, std::string>> const& inputs, std::string const& name, bool parameterized) -> std::string
+{
+    std::string const scalar { SinglePrecision ? "float" : "double" };
+    std::unordered_map<Operon::Hash, size_t> columns;
+    for (size_t k = 0; k < inputs.size(); ++k) {
+        columns.insert({ inputs[k].first, k });
+    }
+
+    fmt::memory_buffer out;
+    auto sink = std::back_inserter(out);
+    fmt::format_to(sink, "/* generated by operon */\n#include <math.h>\n#include <stddef.h>\n\n");
+    if (!parameterized) {
+        fmt::format_to(sink, "static size_t const {}_input_count = {};\n", name, inputs.size());
+    }
+    if (!parameterized && !inputs.empty()) {
+        fmt::format_to(sink, "static char const* const {}_inputs[] = {{", name);
+        for (size_t k = 0; k < inputs.size(); ++k) {
+            fmt::format_to(sink, "{} \"{}\"", k == 0 ? "" : ",", inputs[k].second);
+        }
+        fmt::format_to(sink, " }};\n");
+    }
+    fmt::format_to(sink, "\n#ifdef __cplusplus\nextern \"C\"\n#endif\n");
+    if (parameterized) {
+        fmt::format_to(sink, "void {0}({1} const* const* columns, {1} const* p, size_t rows, {1}* result)\n{{\n", name, scalar);
+        fmt::format_to(sink, "    (void)columns;\n    (void)p;\n    for (size_t i = 0; i < rows; ++i) {{\n");
+    } else {
+        fmt::format_to(sink, "void {0}({1} const* const* columns, size_t rows, {1}* result)\n{{\n", name, scalar);
+        fmt::format_to(sink, "    (void)columns;\n    for (size_t i = 0; i < rows; ++i) {{\n");
+    }
+
+    auto temp = [](size_t i) { return fmt::format("t{}", i); };
+    size_t leaf { 0 };
+    size_t variable { 0 };
+    for (size_t i = 0; i < tree.Length(); ++i) {
+        auto const& s = tree[i];
+        std::string expr;
+        if (parameterized && s.IsLeaf() && s.Type != NodeType::Dynamic) {
+            expr = s.IsVariable() ? fmt::format("p[{}] * columns[{}][i]", leaf, variable++) : fmt::format("p[{}]", leaf);
+            ++leaf;
+        } else if (s.IsConstant()) {
+            expr = Literal(s.Value);
+        } else if (s.IsVariable()) {
+            auto it = columns.find(s.HashValue);
+            if (it == columns.end()) {
+                throw std::runtime_error(fmt::format("A variable with hash value {} could not be found in the dataset.\n", s.HashValue));
+            }
+            expr = fmt::format("{} * columns[{}][i]", Literal(s.Value), it->second);
+        } else {
+            // dynamic nodes are defined by the user at runtime
+            if (s.Type == NodeType::Dynamic) { throw std::runtime_error("Dynamic nodes cannot be exported.\n"); }
+            std::vector<std::string> args;
+            for (auto it = tree.Children(i); it.HasNext(); ++it) {
+                args.push_back(temp(it.Index()));
+            }
+            auto join = [&](size_t from, char const* sep) {
+                std::string str = args[from];
+                for (size_t j = from + 1; j < args.size(); ++j) { str += fmt::format(" {} {}", sep, args[j]); }
+                return str;
+            };
+            auto unary = [&](std::string const& f) { return fmt::format("{}({})", MathFunction(f), args.front()); };
+
+            switch (s.Type) {
+            case NodeType::Add: expr = join(0, "+"); break;
+            case NodeType::Mul: expr = join(0, "*"); break;
+            case NodeType::Sub: expr = args.size() == 1 ? fmt::format("-{}", args.front()) : fmt::format("{} - ({})", args.front(), join(1, "+")); break;
+            case NodeType::Div: expr = args.size() == 1 ? fmt::format("{} / {}", Literal(1), args.front()) : fmt::format("{} / ({})", args.front(), join(1, "*")); break;
+            case NodeType::Fmin:
+            case NodeType::Fmax: {
+                auto f = MathFunction(s.Type == NodeType::Fmin ? "fmin" : "fmax");
+                expr = args.front();
+                for (size_t j = 1; j < args.size(); ++j) { expr = fmt::format("{}({}, {})", f, expr, args[j]); }
+                break;
+            }
+            case NodeType::Aq: expr = fmt::format("{} / {}({} + {} * {})", args[0], MathFunction("sqrt"), Literal(1), args[1], args[1]); break;
+            case NodeType::Pow: expr = fmt::format("{}({}, {})", MathFunction("pow"), args[0], args[1]); break;
+            case NodeType::Abs: expr = unary("fabs"); break;
+            case NodeType::Acos: expr = unary("acos"); break;
+            case NodeType::Asin: expr = unary("asin"); break;
+            case NodeType::Atan: expr = unary("atan"); break;
+            case NodeType::Cbrt: expr = unary("cbrt"); break;
+            case NodeType::Ceil: expr = unary("ceil"); break;
+            case NodeType::Cos: expr = unary("cos"); break;
+            case NodeType::Cosh: expr = unary("cosh"); break;
+            case NodeType::Exp: expr = unary("exp"); break;
+            case NodeType::Floor: expr = unary("floor"); break;
+            case NodeType::Log: expr = unary("log"); break;
+            case NodeType::Logabs: expr = fmt::format("{}({}({}))", MathFunction("log"), MathFunction("fabs"), args.front()); break;
+            case NodeType::Log1p: expr = unary("log1p"); break;
+            case NodeType::Sin: expr = unary("sin"); break;
+            case NodeType::Sinh: expr = unary("sinh"); break;
+            case NodeType::Sqrt: expr = unary("sqrt"); break;
+            case NodeType::Sqrtabs: expr = fmt::format("{}({}({}))", MathFunction("sqrt"), MathFunction("fabs"), args.front()); break;
+            case NodeType::Tan: expr = unary("tan"); break;
+            case NodeType::Tanh: expr = unary("tanh"); break;
+            case NodeType::Square: expr = fmt::format("{0} * {0}", args.front()); break;
+            default:
+                throw std::runtime_error(fmt::format("The node type {} cannot be exported.\n", s.Name()));
+            }
+        }
+        fmt::format_to(sink, "        {} const {} = {};\n", scalar, temp(i), expr);
+    }
+    fmt::format_to(sink, "        result[i] = {};\n    }}\n}}\n", temp(tree.Length() - 1));
+    return { out.begin(), out.end() };
+}
+
+auto CodeFormatter::Format(TreeView tree, Dataset const& dataset, std::string const& name) -> std::string
+{
+    std::unordered_set<Operon::Hash> used;
+    for (auto const& node : tree.Nodes()) {
+        if (node.IsVariable()) { used.insert(node.HashValue); }
+    }
+    std::vector<std::pair<Operon::Hash, std::string>> inputs;
+    for (auto const& var : dataset.Variables()) {
+        if (used.count(var.Hash) > 0) { inputs.emplace_back(var.Hash, var.Name); }
+    }
+    return Format(tree, inputs, name, /*parameterized=*/false);
+}
+
+auto CodeFormatter::Format(TreeView tree, std::unordered_map<Operon::Hash, std::string> const& variableNames, std::string const& name) -> std::string
+{
+    std::vector<std::pair<Operon::Hash, std::string>> inputs;
+    for (auto const& node : tree.Nodes()) {
+        if (!node.IsVariable()) { continue; }
+        if (std::any_of(inputs.begin(), inputs.end(), [&](auto const& p) { return p.first == node.HashValue; })) { continue; }
+        if (auto it = variableNames.find(node.HashValue); it != variableNames.end()) {
+            inputs.emplace_back(node.HashValue, it->second);
+        } else {
+            throw std::runtime_error(fmt::format("A variable with hash value {} could not be found in the dataset.\n", node.HashValue));
+        }
+    }
+    return Format(tree, inputs, name, /*parameterized=*/false);
+}
+
+auto CodeFormatter::FormatKernel(TreeView tree, std::string const& name) -> std::string
+{
+    return Format(tree, {}, name, /*parameterized=*/true);
+}
+
+} // namespace Operon
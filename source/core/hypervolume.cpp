@@ -0,0 +1,203 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <random>
+
+#include "operon/core/contracts.hpp"
+#include "operon/core/hypervolume.hpp"
+
+namespace Operon::Hypervolume {
+    namespace {
+        // row-major point set, computations are carried out in double precision
+        struct Points {
+            std::vector<double> Data;
+            size_t M{};
+
+            [[nodiscard]] auto Size() const { return Data.size() / M; }
+            [[nodiscard]] auto Row(size_t i) const { return Data.data() + i * M; }
+            void Push(double const* p) { Data.insert(Data.end(), p, p + M); }
+        };
+
+        // p is no worse than q in every objective
+        auto WeaklyDominates(double const* p, double const* q, size_t m) -> bool
+        {
+            for (size_t k = 0; k < m; ++k) {
+                if (p[k] > q[k]) { return false; }
+            }
+            return true;
+        }
+
+        auto Inclusive(double const* p, std::vector<double> const& ref) -> double
+        {
+            auto v = 1.0;
+            for (size_t k = 0; k < ref.size(); ++k) { v *= ref[k] - p[k]; }
+            return v;
+        }
+
+        // removes the points which are weakly dominated by another point (keeping one of several equal points)
+        auto Nondominated(Points const& in) -> Points
+        {
+            Points out{ {}, in.M };
+            auto const n = in.Size();
+            for (size_t i = 0; i < n; ++i) {
+                auto const* p = in.Row(i);
+                bool dominated{false};
+                for (size_t j = 0; j < n && !dominated; ++j) {
+                    if (i == j) { continue; }
+                    auto const* q = in.Row(j);
+                    // among equal points only the first one is kept
+                    dominated = WeaklyDominates(q, p, in.M) && (j < i || !WeaklyDominates(p, q, in.M));
+                }
+                if (!dominated) { out.Push(p); }
+            }
+            return out;
+        }
+
+        // the points j > k worsened to the region weakly dominated by point k
+        auto Limit(Points const& points, size_t k, double const* p) -> Points
+        {
+            Points out{ {}, points.M };
+            out.Data.reserve((points.Size() - k) * points.M);
+            for (auto j = k; j < points.Size(); ++j) {
+                auto const* q = points.Row(j);
+                for (size_t i = 0; i < points.M; ++i) { out.Data.push_back(std::max(p[i], q[i])); }
+            }
+            return Nondominated(out);
+        }
+
+        auto Sweep(Points const& points, std::vector<double> const& ref) -> double
+        {
+            std::vector<size_t> idx(points.Size());
+            std::iota(idx.begin(), idx.end(), size_t{0});
+            std::sort(idx.begin(), idx.end(), [&](auto a, auto b) { return points.Row(a)[0] < points.Row(b)[0]; });
+            auto prev = ref[1];
+            auto area = 0.0;
+            for (auto i : idx) {
+                auto const* p = points.Row(i);
+                if (p[1] < prev) {
+                    area += (ref[0] - p[0]) * (prev - p[1]);
+                    prev = p[1];
+                }
+            }
+            return area;
+        }
+
+        auto Wfg(Points points, std::vector<double> const& ref) -> double // NOLINT(misc-no-recursion)
+        {
+            auto const n = points.Size();
+            if (n == 0) { return 0; }
+            if (n == 1) { return Inclusive(points.Row(0), ref); }
+            if (points.M == 2) { return Sweep(points, ref); }
+
+            // sorting on the first objective keeps the limit sets small
+            auto const m = points.M;
+            std::vector<size_t> idx(n);
+            std::iota(idx.begin(), idx.end(), size_t{0});
+            std::sort(idx.begin(), idx.end(), [&](auto a, auto b) { return points.Row(a)[0] < points.Row(b)[0]; });
+            Points sorted{ {}, m };
+            sorted.Data.reserve(points.Data.size());
+            for (auto i : idx) { sorted.Push(points.Row(i)); }
+
+            auto volume = 0.0;
+            for (size_t k = 0; k < n; ++k) {
+                auto const* p = sorted.Row(k);
+                volume += Inclusive(p, ref) - Wfg(Limit(sorted, k + 1, p), ref);
+            }
+            return volume;
+        }
+
+        // the points strictly better than the reference point in every objective
+        auto Clip(Operon::Span<Operon::Scalar const> points, size_t m, std::vector<double> const& ref, std::vector<size_t>* rows = nullptr) -> Points
+        {
+            Points out{ {}, m };
+            for (size_t i = 0; i < points.size() / m; ++i) {
+                auto const* p = points.data() + i * m;
+                bool inside{true};
+                for (size_t k = 0; k < m && inside; ++k) { inside = p[k] < ref[k]; }
+                if (!inside) { continue; }
+                for (size_t k = 0; k < m; ++k) { out.Data.push_back(p[k]); }
+                if (rows != nullptr) { rows->push_back(i); }
+            }
+            return out;
+        }
+    } // namespace
+
+    auto Compute(Operon::Span<Operon::Scalar const> points, size_t m, Operon::Span<Operon::Scalar const> reference) -> double
+    {
+        EXPECT(m > 0 && reference.size() == m && points.size() % m == 0);
+        std::vector<double> ref(reference.begin(), reference.end());
+        return Wfg(Nondominated(Clip(points, m, ref)), ref);
+    }
+
+    auto Contributions(Operon::RandomGenerator& random, Operon::Span<Operon::Scalar const> points, size_t m, Operon::Span<Operon::Scalar const> reference, size_t samples) -> std::vector<double>
+    {
+        EXPECT(m > 0 && reference.size() == m && points.size() % m == 0);
+        std::vector<double> ref(reference.begin(), reference.end());
+        std::vector<double> contributions(points.size() / m, 0.0);
+        std::vector<size_t> rows;
+        auto clipped = Clip(points, m, ref, &rows);
+        auto const n = clipped.Size();
+        if (n == 0) { return contributions; }
+
+        if (m <= MaxExactObjectives) {
+            for (size_t i = 0; i < n; ++i) {
+                auto const* p = clipped.Row(i);
+                Points others{ {}, m };
+                others.Data.reserve((n - 1) * m);
+                for (size_t j = 0; j < n; ++j) {
+                    if (j == i) { continue; }
+                    auto const* q = clipped.Row(j);
+                    for (size_t k = 0; k < m; ++k) { others.Data.push_back(std::max(p[k], q[k])); }
+                }
+                contributions[rows[i]] = Inclusive(p, ref) - Wfg(Nondominated(others), ref);
+            }
+            return contributions;
+        }
+
+        // monte carlo estimate over the box between the ideal point and the reference point
+        std::vector<double> ideal(m, std::numeric_limits<double>::max());
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t k = 0; k < m; ++k) { ideal[k] = std::min(ideal[k], clipped.Row(i)[k]); }
+        }
+        auto const volume = Inclusive(ideal.data(), ref);
+
+        std::vector<size_t> hits(n, 0);
+        std::vector<double> s(m);
+        for (size_t r = 0; r < samples; ++r) {
+            for (size_t k = 0; k < m; ++k) { s[k] = Random::Uniform(random, ideal[k], ref[k]); }
+            size_t count{0};
+            size_t owner{0};
+            for (size_t i = 0; i < n && count < 2; ++i) {
+                if (WeaklyDominates(clipped.Row(i), s.data(), m)) {
+                    owner = i;
+                    ++count;
+                }
+            }
+            if (count == 1) { ++hits[owner]; }
+        }
+        for (size_t i = 0; i < n; ++i) {
+            contributions[rows[i]] = volume * static_cast<double>(hits[i]) / static_cast<double>(samples);
+        }
+        return contributions;
+    }
+
+    auto Reference(Operon::Span<Operon::Scalar const> points, size_t m, double margin) -> std::vector<Operon::Scalar>
+    {
+        EXPECT(m > 0 && !points.empty() && points.size() % m == 0);
+        std::vector<Operon::Scalar> ref(m);
+        for (size_t k = 0; k < m; ++k) {
+            auto lo = std::numeric_limits<Operon::Scalar>::max();
+            auto hi = std::numeric_limits<Operon::Scalar>::lowest();
+            for (size_t i = 0; i < points.size() / m; ++i) {
+                lo = std::min(lo, points[i * m + k]);
+                hi = std::max(hi, points[i * m + k]);
+            }
+            auto range = hi > lo ? hi - lo : Operon::Scalar{1};
+            ref[k] = hi + static_cast<Operon::Scalar>(margin) * range;
+        }
+        return ref;
+    }
+} // namespace Operon::Hypervolume
@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include "operon/core/indexed_dataset.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+namespace Operon {
+
+IndexedDataset::IndexedDataset(Dataset const& dataset, std::vector<size_t> indices, size_t blockRows)
+    : dataset_(dataset)
+    , indices_(std::move(indices))
+    , blockRows_(std::max(size_t{1}, blockRows))
+{
+    EXPECT(std::all_of(indices_.begin(), indices_.end(), [&](auto i) { return i < dataset.Rows(); }));
+    blocks_.resize(BlockCount());
+    once_ = std::make_unique<std::once_flag[]>(BlockCount()); // NOLINT
+}
+
+auto IndexedDataset::Shuffled(Dataset const& dataset, Operon::RandomGenerator& random, size_t blockRows) -> IndexedDataset
+{
+    std::vector<size_t> indices(dataset.Rows());
+    std::iota(indices.begin(), indices.end(), size_t{0});
+    std::shuffle(indices.begin(), indices.end(), random);
+    return { dataset, std::move(indices), blockRows };
+}
+
+auto IndexedDataset::Folds(size_t rows, size_t k, Operon::RandomGenerator& random) -> std::vector<std::vector<size_t>>
+{
+    EXPECT(k > 0 && k <= rows);
+    std::vector<size_t> indices(rows);
+    std::iota(indices.begin(), indices.end(), size_t{0});
+    std::shuffle(indices.begin(), indices.end(), random);
+
+    std::vector<std::vector<size_t>> folds(k);
+    auto start = indices.begin();
+    for (size_t i = 0; i < k; ++i) {
+        auto size = static_cast<std::ptrdiff_t>(rows / k + (i < rows % k ? 1 : 0));
+        folds[i].assign(start, start + size);
+        // sorted indices keep the gathering cache-friendly
+        std::sort(folds[i].begin(), folds[i].end());
+        start += size;
+    }
+    return folds;
+}
+
+auto IndexedDataset::Block(size_t b) const -> Dataset const&
+{
+    EXPECT(b < BlockCount());
+    std::call_once(once_[b], [&]() {
+        auto start = b * blockRows_;
+        auto end = std::min(Rows(), start + blockRows_);
+        blocks_[b] = std::make_unique<Dataset>(dataset_.get().Gather({ indices_.data() + start, end - start }));
+    });
+    return *blocks_[b];
+}
+
+auto IndexedDataset::Materialize(Range range) const -> Dataset
+{
+    EXPECT(range.End() <= Rows());
+    return dataset_.get().Gather({ indices_.data() + range.Start(), range.Size() });
+}
+
+} // namespace Operon
@@ -0,0 +1,419 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <time.h> // NOLINT(modernize-deprecated-headers)
+#endif
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "operon/core/instrumentation.hpp"
+
+namespace Operon::Instrumentation {
+    namespace {
+        constexpr size_t CacheLine = 64;
+        constexpr size_t Slots = StageCount + OperatorCount;
+        constexpr double Nanoseconds = 1e9;
+
+        std::atomic_bool enabled{false};
+        std::atomic_bool primitives{false};
+        std::atomic_bool hardware{false};
+
+        struct PrimitiveCounter {
+            std::atomic_uint64_t Time{0};
+            std::atomic_uint64_t Calls{0};
+            std::atomic_uint64_t Rows{0};
+        };
+
+        struct DynamicCounter {
+            Operon::Hash HashValue;
+            ValueKind Kind;
+            PrimitiveCounter Counter;
+        };
+
+        // the counters of one thread, only written by their thread (so an increment is a plain load and store)
+        struct alignas(CacheLine) Counters {
+            std::array<std::atomic_uint64_t, Slots> Wall{};
+            std::array<std::atomic_uint64_t, Slots> Cpu{};
+            std::array<std::atomic_uint64_t, Slots> Calls{};
+
+            // the built-in primitives by value kind and node type index
+            std::array<std::array<PrimitiveCounter, NodeTypes::Count>, ValueKindCount> Primitives{};
+            // the dynamic primitives are few, they are looked up linearly. the list grows while it is read by
+            // PrimitiveSnapshot, hence the (uncontended) lock
+            std::mutex DynamicLock;
+            std::vector<std::unique_ptr<DynamicCounter>> Dynamic;
+
+            PrimitiveCounter Jacobian;
+
+            std::array<std::array<std::atomic_uint64_t, EventCount>, Slots> Events{};
+        };
+
+        // the perf events of the calling thread, opened as one group (so they are read with one system call) by the
+        // first timer of the thread which counts them. the events the kernel refuses are left out of the group
+        class PerfEvents {
+        public:
+            PerfEvents()
+            {
+                fds_.fill(-1);
+#if defined(__linux__)
+                constexpr std::array<uint64_t, EventCount> configs {
+                    PERF_COUNT_HW_CPU_CYCLES,
+                    PERF_COUNT_HW_INSTRUCTIONS,
+                    PERF_COUNT_HW_CACHE_MISSES,
+                    PERF_COUNT_HW_BRANCH_MISSES
+                };
+                int leader{-1};
+                for (size_t i = 0; i < EventCount; ++i) {
+                    perf_event_attr attr{};
+                    attr.size = sizeof(attr);
+                    attr.type = PERF_TYPE_HARDWARE;
+                    attr.config = configs[i];
+                    attr.read_format = PERF_FORMAT_GROUP;
+                    attr.exclude_kernel = 1;
+                    attr.exclude_hv = 1;
+                    // the calling thread on any cpu
+                    auto const fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, leader, PERF_FLAG_FD_CLOEXEC));
+                    if (fd < 0) { continue; }
+                    if (leader < 0) { leader = fd; }
+                    fds_[i] = fd;
+                    order_[size_++] = i;
+                }
+#endif
+            }
+
+            PerfEvents(PerfEvents const&) = delete;
+            PerfEvents(PerfEvents&&) = delete;
+            auto operator=(PerfEvents const&) -> PerfEvents& = delete;
+            auto operator=(PerfEvents&&) -> PerfEvents& = delete;
+
+            ~PerfEvents()
+            {
+#if defined(__linux__)
+                for (auto fd : fds_) {
+                    if (fd >= 0) { close(fd); }
+                }
+#endif
+            }
+
+            [[nodiscard]] auto Open() const -> bool { return size_ > 0; }
+
+            auto Read(EventCounts& counts) const -> void
+            {
+                counts.fill(0);
+#if defined(__linux__)
+                if (size_ == 0) { return; }
+                // the number of events followed by their values, in the order in which they joined the group
+                std::array<uint64_t, EventCount + 1> buffer{};
+                auto const bytes = static_cast<int64_t>((size_ + 1) * sizeof(uint64_t));
+                if (read(fds_[order_[0]], buffer.data(), static_cast<size_t>(bytes)) != bytes) { return; }
+                for (size_t i = 0; i < size_; ++i) { counts[order_[i]] = buffer[i + 1]; }
+#endif
+            }
+
+        private:
+            std::array<int, EventCount> fds_{};
+            std::array<size_t, EventCount> order_{};
+            size_t size_{0};
+        };
+
+        auto LocalEvents() -> PerfEvents const&
+        {
+            thread_local PerfEvents const events;
+            return events;
+        }
+
+        // the counters of all the threads which recorded something, kept alive after their thread exited
+        struct Registry {
+            std::mutex Lock;
+            std::vector<std::shared_ptr<Counters>> Threads;
+        };
+
+        auto GetRegistry() -> Registry&
+        {
+            static Registry registry;
+            return registry;
+        }
+
+        auto Local() -> Counters&
+        {
+            thread_local std::shared_ptr<Counters> const counters = []() {
+                auto c = std::make_shared<Counters>();
+                auto& registry = GetRegistry();
+                std::lock_guard lock(registry.Lock);
+                registry.Threads.push_back(c);
+                return c;
+            }();
+            return *counters;
+        }
+
+        auto Add(std::atomic_uint64_t& counter, uint64_t value) -> void
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+
+        auto Add(PrimitiveCounter& counter, uint64_t time, uint64_t calls, uint64_t rows) -> void
+        {
+            Add(counter.Time, time);
+            Add(counter.Calls, calls);
+            Add(counter.Rows, rows);
+        }
+
+        auto Clear(PrimitiveCounter& counter) -> void
+        {
+            counter.Time.store(0, std::memory_order_relaxed);
+            counter.Calls.store(0, std::memory_order_relaxed);
+            counter.Rows.store(0, std::memory_order_relaxed);
+        }
+
+        auto Record(size_t slot, uint64_t wall, uint64_t cpu, uint64_t calls) -> void
+        {
+            auto& c = Local();
+            if (wall > 0) { Add(c.Wall[slot], wall); }
+            if (cpu > 0) { Add(c.Cpu[slot], cpu); }
+            if (calls > 0) { Add(c.Calls[slot], calls); }
+        }
+
+        auto RecordEvents(size_t slot, EventCounts const& counts) -> void
+        {
+            auto& c = Local();
+            for (size_t i = 0; i < EventCount; ++i) { Add(c.Events[slot][i], counts[i]); }
+        }
+
+        auto Accumulate(Profile& profile, Counters const& c) -> void
+        {
+            for (size_t i = 0; i < Slots; ++i) {
+                auto& t = i < StageCount ? profile.Stages[i] : profile.Operators[i - StageCount];
+                t.Wall += static_cast<double>(c.Wall[i].load(std::memory_order_relaxed)) / Nanoseconds;
+                t.Cpu += static_cast<double>(c.Cpu[i].load(std::memory_order_relaxed)) / Nanoseconds;
+                t.Calls += c.Calls[i].load(std::memory_order_relaxed);
+                for (size_t e = 0; e < EventCount; ++e) {
+                    t.Events[e] += c.Events[i][e].load(std::memory_order_relaxed);
+                }
+            }
+        }
+    } // namespace
+
+    auto Name(Stage stage) -> char const*
+    {
+        constexpr std::array<char const*, StageCount> names {
+            "initialize population",
+            "prepare evaluator",
+            "evaluate population",
+            "keep elite",
+            "prepare generator",
+            "generate offspring",
+            "non-dominated sort",
+            "update distance",
+            "reinsert",
+            "report progress"
+        };
+        return names[static_cast<size_t>(stage)];
+    }
+
+    auto Name(Operator op) -> char const*
+    {
+        constexpr std::array<char const*, OperatorCount> names {
+            "crossover",
+            "mutation",
+            "evaluation",
+            "local optimization"
+        };
+        return names[static_cast<size_t>(op)];
+    }
+
+    auto Name(Event event) -> char const*
+    {
+        constexpr std::array<char const*, EventCount> names {
+            "cycles",
+            "instructions",
+            "cache misses",
+            "branch misses"
+        };
+        return names[static_cast<size_t>(event)];
+    }
+
+    auto Name(ValueKind kind) -> char const*
+    {
+        constexpr std::array<char const*, ValueKindCount> names { "scalar", "dual" };
+        return names[static_cast<size_t>(kind)];
+    }
+
+    auto Available() -> bool
+    {
+#if defined(OPERON_INSTRUMENTATION)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    auto SetEnabled(bool value) -> void { enabled.store(value, std::memory_order_relaxed); }
+    auto Enabled() -> bool { return enabled.load(std::memory_order_relaxed); }
+
+    auto SetPrimitiveProfiling(bool value) -> void { primitives.store(value, std::memory_order_relaxed); }
+    auto PrimitiveProfiling() -> bool { return primitives.load(std::memory_order_relaxed); }
+
+    auto SetHardwareCounting(bool value) -> bool
+    {
+        auto const ok = !value || LocalEvents().Open();
+        hardware.store(value && ok, std::memory_order_relaxed);
+        return ok;
+    }
+
+    auto HardwareCounting() -> bool { return hardware.load(std::memory_order_relaxed); }
+
+    auto Snapshot() -> Profile
+    {
+        Profile profile;
+        auto& registry = GetRegistry();
+        std::lock_guard lock(registry.Lock);
+        for (auto const& c : registry.Threads) { Accumulate(profile, *c); }
+        return profile;
+    }
+
+    auto ThreadSnapshot() -> std::vector<Profile>
+    {
+        auto& registry = GetRegistry();
+        std::lock_guard lock(registry.Lock);
+        std::vector<Profile> profiles(registry.Threads.size());
+        for (size_t i = 0; i < profiles.size(); ++i) { Accumulate(profiles[i], *registry.Threads[i]); }
+        return profiles;
+    }
+
+    auto PrimitiveSnapshot() -> PrimitiveProfile
+    {
+        PrimitiveProfile profile;
+        auto add = [](PrimitiveTiming& t, PrimitiveCounter const& c) {
+            t.Time += static_cast<double>(c.Time.load(std::memory_order_relaxed)) / Nanoseconds;
+            t.Calls += c.Calls.load(std::memory_order_relaxed);
+            t.Rows += c.Rows.load(std::memory_order_relaxed);
+        };
+        auto find = [&](NodeType type, Operon::Hash hash, ValueKind kind) -> PrimitiveTiming& {
+            auto& v = profile.Primitives;
+            auto it = std::find_if(v.begin(), v.end(), [&](auto const& t) { return t.Type == type && t.HashValue == hash && t.Kind == kind; });
+            return it == v.end() ? v.emplace_back(PrimitiveTiming{type, hash, kind}) : *it;
+        };
+
+        auto& registry = GetRegistry();
+        std::lock_guard lock(registry.Lock);
+        for (auto const& c : registry.Threads) {
+            for (size_t k = 0; k < ValueKindCount; ++k) {
+                for (size_t i = 0; i < NodeTypes::Count; ++i) {
+                    auto const& counter = c->Primitives[k][i];
+                    if (counter.Calls.load(std::memory_order_relaxed) == 0) { continue; }
+                    add(find(static_cast<NodeType>(1U << i), 0, static_cast<ValueKind>(k)), counter);
+                }
+            }
+            {
+                std::lock_guard dynamicLock(c->DynamicLock);
+                for (auto const& d : c->Dynamic) {
+                    if (d->Counter.Calls.load(std::memory_order_relaxed) == 0) { continue; }
+                    add(find(NodeType::Dynamic, d->HashValue, d->Kind), d->Counter);
+                }
+            }
+            profile.JacobianTime += static_cast<double>(c->Jacobian.Time.load(std::memory_order_relaxed)) / Nanoseconds;
+            profile.JacobianCalls += c->Jacobian.Calls.load(std::memory_order_relaxed);
+            profile.JacobianRows += c->Jacobian.Rows.load(std::memory_order_relaxed);
+        }
+        std::stable_sort(profile.Primitives.begin(), profile.Primitives.end(), [](auto const& a, auto const& b) { return a.Time > b.Time; });
+        return profile;
+    }
+
+    auto Reset() -> void
+    {
+        auto& registry = GetRegistry();
+        std::lock_guard lock(registry.Lock);
+        for (auto const& c : registry.Threads) {
+            for (size_t i = 0; i < Slots; ++i) {
+                c->Wall[i].store(0, std::memory_order_relaxed);
+                c->Cpu[i].store(0, std::memory_order_relaxed);
+                c->Calls[i].store(0, std::memory_order_relaxed);
+                for (auto& e : c->Events[i]) { e.store(0, std::memory_order_relaxed); }
+            }
+            for (auto& kind : c->Primitives) {
+                for (auto& counter : kind) { Clear(counter); }
+            }
+            {
+                std::lock_guard dynamicLock(c->DynamicLock);
+                for (auto& d : c->Dynamic) { Clear(d->Counter); }
+            }
+            Clear(c->Jacobian);
+        }
+    }
+
+    auto WallTime() -> uint64_t
+    {
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+    }
+
+    auto ThreadCpuTime() -> uint64_t
+    {
+#if defined(__unix__) || defined(__APPLE__)
+        timespec ts{};
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * static_cast<uint64_t>(Nanoseconds) + static_cast<uint64_t>(ts.tv_nsec);
+#else
+        return 0; // not available, only the wall times are recorded
+#endif
+    }
+
+    auto ReadEvents(EventCounts& counts) -> void
+    {
+        LocalEvents().Read(counts);
+    }
+
+    auto Record(Stage stage, uint64_t wall, uint64_t cpu, uint64_t calls) -> void
+    {
+        Record(static_cast<size_t>(stage), wall, cpu, calls);
+    }
+
+    auto Record(Operator op, uint64_t wall, uint64_t cpu, uint64_t calls) -> void
+    {
+        Record(StageCount + static_cast<size_t>(op), wall, cpu, calls);
+    }
+
+    auto RecordPrimitive(ValueKind kind, Node const& node, uint64_t time, uint64_t rows) -> void
+    {
+        auto& c = Local();
+        if (!node.IsDynamic()) {
+            Add(c.Primitives[static_cast<size_t>(kind)][NodeTypes::GetIndex(node.Type)], time, 1, rows);
+            return;
+        }
+        std::lock_guard lock(c.DynamicLock);
+        auto it = std::find_if(c.Dynamic.begin(), c.Dynamic.end(), [&](auto const& d) { return d->HashValue == node.HashValue && d->Kind == kind; });
+        if (it == c.Dynamic.end()) {
+            it = c.Dynamic.insert(c.Dynamic.end(), std::make_unique<DynamicCounter>());
+            (*it)->HashValue = node.HashValue;
+            (*it)->Kind = kind;
+        }
+        Add((*it)->Counter, time, 1, rows);
+    }
+
+    auto RecordJacobian(uint64_t time, uint64_t rows) -> void
+    {
+        Add(Local().Jacobian, time, 1, rows);
+    }
+
+    auto RecordEvents(Stage stage, EventCounts const& counts) -> void
+    {
+        RecordEvents(static_cast<size_t>(stage), counts);
+    }
+
+    auto RecordEvents(Operator op, EventCounts const& counts) -> void
+    {
+        RecordEvents(StageCount + static_cast<size_t>(op), counts);
+    }
+} // namespace Operon::Instrumentation
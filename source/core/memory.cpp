@@ -0,0 +1,167 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+#include "operon/core/dataset.hpp"
+#include "operon/core/individual.hpp"
+#include "operon/core/memory.hpp"
+
+namespace Operon::Memory {
+    namespace {
+        constexpr size_t CacheLine = 64;
+
+        struct alignas(CacheLine) Counter {
+            std::atomic<int64_t> Bytes{0};
+        };
+
+        std::array<Counter, SubsystemCount> counters;
+        std::atomic_size_t limit{0};
+        std::atomic<uint64_t> epoch{0};
+
+        struct Reclaimers {
+            std::mutex Lock;
+            std::vector<std::pair<size_t, Reclaimer>> Callbacks;
+            size_t Next{0};
+        };
+
+        auto GetReclaimers() -> Reclaimers&
+        {
+            static Reclaimers reclaimers;
+            return reclaimers;
+        }
+    } // namespace
+
+    auto Name(Subsystem subsystem) -> char const*
+    {
+        constexpr std::array<char const*, SubsystemCount> names {
+            "population",
+            "evaluator",
+            "interpreter",
+            "cache",
+            "dataset"
+        };
+        return names[static_cast<size_t>(subsystem)];
+    }
+
+    auto Add(Subsystem subsystem, int64_t bytes) -> void
+    {
+        counters[static_cast<size_t>(subsystem)].Bytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    auto Usage(Subsystem subsystem) -> size_t
+    {
+        // the updates of different owners are not ordered, the sum can be transiently negative
+        return static_cast<size_t>(std::max(int64_t{0}, counters[static_cast<size_t>(subsystem)].Bytes.load(std::memory_order_relaxed)));
+    }
+
+    auto Total() -> size_t
+    {
+        size_t total{0};
+        for (size_t i = 0; i < SubsystemCount; ++i) { total += Usage(static_cast<Subsystem>(i)); }
+        return total;
+    }
+
+    auto Snapshot() -> Report
+    {
+        Report report;
+        for (size_t i = 0; i < SubsystemCount; ++i) {
+            report.Subsystems[i] = Usage(static_cast<Subsystem>(i));
+            report.Total += report.Subsystems[i];
+        }
+        report.Resident = ResidentBytes();
+        report.Limit = SoftLimit();
+        return report;
+    }
+
+    auto ResidentBytes() -> size_t
+    {
+#if defined(__linux__)
+        std::ifstream statm("/proc/self/statm");
+        size_t size{0};
+        size_t resident{0};
+        if (statm >> size >> resident) {
+            return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        }
+#endif
+        return 0;
+    }
+
+    auto Footprint(Individual const& individual) -> size_t
+    {
+        return sizeof(Individual)
+            + individual.Genotype.Nodes().capacity() * sizeof(Node)
+            + (individual.Fitness.IsInline() ? 0 : individual.Fitness.capacity()) * sizeof(Operon::Scalar);
+    }
+
+    auto Footprint(Operon::Span<Individual const> individuals) -> size_t
+    {
+        size_t bytes{0};
+        for (auto const& ind : individuals) { bytes += Footprint(ind); }
+        return bytes;
+    }
+
+    auto Footprint(Dataset const& dataset) -> size_t
+    {
+        auto const values = dataset.Rows() * dataset.Cols();
+        auto bytes = values * sizeof(Operon::Scalar);
+        if (!std::is_same_v<Operon::Scalar, float> && dataset.HasSinglePrecision()) { bytes += values * sizeof(float); }
+        return bytes + dataset.VirtualSizeInBytes();
+    }
+
+    auto SetSoftLimit(size_t bytes) -> void { limit.store(bytes, std::memory_order_relaxed); }
+    auto SoftLimit() -> size_t { return limit.load(std::memory_order_relaxed); }
+
+    auto OverLimit() -> bool
+    {
+        auto const l = SoftLimit();
+        return l > 0 && Total() > l;
+    }
+
+    auto Register(Reclaimer reclaimer) -> size_t
+    {
+        auto& r = GetReclaimers();
+        std::lock_guard lock(r.Lock);
+        auto id = r.Next++;
+        r.Callbacks.emplace_back(id, std::move(reclaimer));
+        return id;
+    }
+
+    auto Unregister(size_t id) -> void
+    {
+        auto& r = GetReclaimers();
+        std::lock_guard lock(r.Lock);
+        auto& c = r.Callbacks;
+        c.erase(std::remove_if(c.begin(), c.end(), [&](auto const& p) { return p.first == id; }), c.end());
+    }
+
+    auto Enforce() -> size_t
+    {
+        auto const l = SoftLimit();
+        if (l == 0 || Total() <= l) { return 0; }
+        epoch.fetch_add(1, std::memory_order_relaxed);
+
+        // the reclaimers are called under the lock, so they cannot be unregistered (destroyed) meanwhile
+        size_t released{0};
+        auto& r = GetReclaimers();
+        std::lock_guard lock(r.Lock);
+        for (auto& [id, reclaim] : r.Callbacks) {
+            auto const total = Total();
+            if (total <= l) { break; }
+            released += reclaim(total - l);
+        }
+        return released;
+    }
+
+    auto Epoch() -> uint64_t { return epoch.load(std::memory_order_relaxed); }
+} // namespace Operon::Memory
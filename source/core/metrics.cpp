@@ -0,0 +1,195 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <cctype>
+#include <cmath>
+#include <filesystem>
+#include <fmt/format.h>
+#include <fstream>
+#include <optional>
+#include <string_view>
+#include <system_error>
+
+#include "operon/core/instrumentation.hpp"
+#include "operon/core/memory.hpp"
+#include "operon/core/metrics.hpp"
+
+namespace Operon {
+namespace {
+    // json has no representation for nan and infinity
+    auto Json(double value) -> std::string
+    {
+        return std::isfinite(value) ? fmt::format("{}", value) : std::string{"null"};
+    }
+
+    auto Prometheus(double value) -> std::string
+    {
+        if (std::isnan(value)) { return "NaN"; }
+        if (std::isinf(value)) { return value > 0 ? "+Inf" : "-Inf"; }
+        return fmt::format("{}", value);
+    }
+
+    // metric names may only contain letters, digits and underscores
+    auto Sanitize(std::string name) -> std::string
+    {
+        for (auto& c : name) {
+            if (std::isalnum(static_cast<unsigned char>(c)) == 0) { c = '_'; }
+        }
+        return name;
+    }
+
+    // the values of a sample together with the derived and the instrumentation ones
+    struct Entry {
+        MetricsSample Sample;
+        double EvaluationsPerSecond{0};
+        double GenerationSeconds{0};
+        std::optional<Instrumentation::Profile> Profile;
+        Memory::Report Memory;
+    };
+
+    auto WriteJson(std::ostream& os, Entry const& r) -> void
+    {
+        auto const& s = r.Sample;
+        os << fmt::format(R"({{"generation":{},"elapsed":{},"evaluations":{},"evaluations_per_second":{},"generation_seconds":{})",
+            s.Generation, Json(s.Elapsed), s.Evaluations, Json(r.EvaluationsPerSecond), Json(r.GenerationSeconds));
+        for (auto const& [name, value] : s.Values) {
+            os << fmt::format(R"(,"{}":{})", Sanitize(name), Json(value));
+        }
+        if (r.Profile) {
+            auto timings = [&](char const* key, auto const& values, auto count, auto kind) {
+                os << fmt::format(R"(,"{}":{{)", key);
+                for (size_t i = 0; i < count; ++i) {
+                    auto const& t = values[i];
+                    os << fmt::format(R"({}"{}":{{"wall":{},"cpu":{},"calls":{}}})", i == 0 ? "" : ",",
+                        Instrumentation::Name(static_cast<decltype(kind)>(i)), Json(t.Wall), Json(t.Cpu), t.Calls);
+                }
+                os << "}";
+            };
+            timings("stages", r.Profile->Stages, Instrumentation::StageCount, Instrumentation::Stage{});
+            timings("operators", r.Profile->Operators, Instrumentation::OperatorCount, Instrumentation::Operator{});
+        }
+        os << R"(,"memory":{)";
+        for (size_t i = 0; i < Memory::SubsystemCount; ++i) {
+            os << fmt::format(R"("{}":{},)", Memory::Name(static_cast<Memory::Subsystem>(i)), r.Memory.Subsystems[i]);
+        }
+        os << fmt::format(R"("total":{},"resident":{},"limit":{}}})", r.Memory.Total, r.Memory.Resident, r.Memory.Limit);
+        os << "}\n";
+    }
+
+    auto WritePrometheus(std::string const& path, std::string const& prefix, Entry const& r) -> void
+    {
+        auto const& s = r.Sample;
+        std::string text;
+        auto metric = [&](std::string const& name, char const* type, double value) {
+            auto full = fmt::format("{}_{}", prefix, Sanitize(name));
+            text += fmt::format("# TYPE {0} {1}\n{0} {2}\n", full, type, Prometheus(value));
+        };
+        metric("generation", "gauge", static_cast<double>(s.Generation));
+        metric("elapsed_seconds", "gauge", s.Elapsed);
+        metric("evaluations_total", "counter", static_cast<double>(s.Evaluations));
+        metric("evaluations_per_second", "gauge", r.EvaluationsPerSecond);
+        metric("generation_seconds", "gauge", r.GenerationSeconds);
+        for (auto const& [name, value] : s.Values) { metric(name, "gauge", value); }
+
+        auto const memory = fmt::format("{}_memory_bytes", prefix);
+        text += fmt::format("# TYPE {} gauge\n", memory);
+        for (size_t i = 0; i < Memory::SubsystemCount; ++i) {
+            text += fmt::format("{}{{subsystem=\"{}\"}} {}\n", memory, Memory::Name(static_cast<Memory::Subsystem>(i)), r.Memory.Subsystems[i]);
+        }
+        metric("memory_total_bytes", "gauge", static_cast<double>(r.Memory.Total));
+        metric("memory_resident_bytes", "gauge", static_cast<double>(r.Memory.Resident));
+        metric("memory_limit_bytes", "gauge", static_cast<double>(r.Memory.Limit));
+
+        if (r.Profile) {
+            auto timings = [&](char const* name, char const* label, auto const& values, auto count, auto kind) {
+                for (auto const* field : { "wall", "cpu" }) {
+                    auto full = fmt::format("{}_{}_{}_seconds_total", prefix, name, field);
+                    text += fmt::format("# TYPE {} counter\n", full);
+                    for (size_t i = 0; i < count; ++i) {
+                        auto const& t = values[i];
+                        text += fmt::format("{}{{{}=\"{}\"}} {}\n", full, label, Instrumentation::Name(static_cast<decltype(kind)>(i)),
+                            Prometheus(std::string_view(field) == "wall" ? t.Wall : t.Cpu));
+                    }
+                }
+            };
+            timings("stage", "stage", r.Profile->Stages, Instrumentation::StageCount, Instrumentation::Stage{});
+            timings("operator", "operator", r.Profile->Operators, Instrumentation::OperatorCount, Instrumentation::Operator{});
+        }
+
+        // the scraper must never see a partial file
+        auto tmp = path + ".tmp";
+        {
+            std::ofstream f(tmp, std::ios::trunc);
+            f << text;
+        }
+        std::error_code ec; // a failed write is retried with the next sample
+        std::filesystem::rename(tmp, path, ec);
+    }
+} // namespace
+
+MetricsSink::MetricsSink(MetricsConfig config)
+    : config_(std::move(config))
+    , queue_(config_.Capacity)
+{
+    writer_ = std::thread([this]() { Run(); });
+}
+
+MetricsSink::~MetricsSink()
+{
+    {
+        std::lock_guard lock(lock_);
+        stop_ = true;
+    }
+    wake_.notify_one();
+    writer_.join();
+}
+
+auto MetricsSink::Push(MetricsSample sample) -> bool
+{
+    if (!queue_.TryPush(sample)) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+auto MetricsSink::Run() -> void
+{
+    std::ofstream json;
+    if (!config_.JsonLines.empty()) { json.open(config_.JsonLines, std::ios::app); }
+
+    std::optional<MetricsSample> previous;
+    auto drain = [&]() {
+        std::optional<Entry> last;
+        while (auto sample = queue_.TryPop()) {
+            Entry r{std::move(*sample)};
+            if (previous) {
+                auto const dt = r.Sample.Elapsed - previous->Elapsed;
+                auto const dg = static_cast<double>(r.Sample.Generation) - static_cast<double>(previous->Generation);
+                if (dt > 0) { r.EvaluationsPerSecond = (static_cast<double>(r.Sample.Evaluations) - static_cast<double>(previous->Evaluations)) / dt; }
+                if (dg > 0) { r.GenerationSeconds = dt / dg; }
+            }
+            if (Instrumentation::Enabled()) { r.Profile = Instrumentation::Snapshot(); }
+            r.Memory = Memory::Snapshot();
+            if (json.is_open()) { WriteJson(json, r); }
+            previous = r.Sample;
+            last = std::move(r);
+            written_.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (json.is_open()) { json.flush(); }
+        // the text file only holds the latest values
+        if (last && !config_.Prometheus.empty()) { WritePrometheus(config_.Prometheus, config_.Prefix, *last); }
+    };
+
+    std::unique_lock lock(lock_);
+    while (!stop_) {
+        lock.unlock();
+        drain();
+        lock.lock();
+        wake_.wait_for(lock, config_.Interval, [&]() { return stop_; });
+    }
+    lock.unlock();
+    drain();
+}
+
+} // namespace Operon
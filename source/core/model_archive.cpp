@@ -0,0 +1,224 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <algorithm>
+#include <cstring>
+#include <fmt/format.h>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "operon/core/contracts.hpp"
+#include "operon/core/model_archive.hpp"
+#include "operon/core/node_pool.hpp"
+
+namespace Operon {
+
+namespace {
+    static_assert(std::is_trivially_copyable_v<Node>, "the nodes are stored as they are in memory");
+
+    // the layout of the build, an archive of a different layout cannot be read
+    constexpr uint32_t Layout = static_cast<uint32_t>(sizeof(Node)) << 16U | static_cast<uint32_t>(sizeof(Operon::Scalar));
+
+    struct Header {
+        std::array<char, 8> Magic;
+        uint32_t Version;
+        uint32_t Layout;
+        uint64_t Models;
+        uint64_t Objectives;
+        uint64_t Variables;
+        uint64_t Metadata; // length in bytes
+    };
+} // namespace
+
+auto ModelArchive::Write(std::string const& path, Operon::Span<Individual const> individuals, Operon::Span<Variable const> variables, std::string const& metadata) -> void
+{
+    size_t const objectives = individuals.empty() ? 0 : individuals.front().Size();
+    EXPECT(std::all_of(individuals.begin(), individuals.end(), [&](auto const& ind) { return ind.Size() == objectives; }));
+
+    // only the variables used by the models
+    std::vector<Variable> used;
+    for (auto const& ind : individuals) {
+        for (auto const& n : ind.Genotype.Nodes()) {
+            if (!n.IsVariable()) { continue; }
+            if (std::any_of(used.begin(), used.end(), [&](auto const& v) { return v.Hash == n.HashValue; })) { continue; }
+            auto it = std::find_if(variables.begin(), variables.end(), [&](auto const& v) { return v.Hash == n.HashValue; });
+            if (it == variables.end()) { throw std::runtime_error(fmt::format("model archive: unknown variable hash {}\n", n.HashValue)); }
+            used.push_back(*it);
+        }
+    }
+
+    std::ofstream f(path, std::ios::binary);
+    if (!f) { throw std::runtime_error(fmt::format("{}: cannot open file for writing\n", path)); }
+    auto write = [&](void const* src, size_t n) { f.write(static_cast<char const*>(src), static_cast<std::streamsize>(n)); };
+
+    Header header { Magic, Version, Layout, individuals.size(), objectives, used.size(), metadata.size() };
+    write(&header, sizeof(header));
+    write(metadata.data(), metadata.size());
+    size_t offset = sizeof(header) + metadata.size();
+
+    for (auto const& v : used) {
+        uint64_t length = v.Name.size();
+        write(&v.Hash, sizeof(v.Hash));
+        write(&length, sizeof(length));
+        write(v.Name.data(), length);
+        offset += sizeof(v.Hash) + sizeof(length) + length;
+    }
+
+    uint64_t first { 0 };
+    for (auto const& ind : individuals) {
+        Entry e { first, ind.Genotype.Length() };
+        write(&e, sizeof(e));
+        first += e.Length;
+    }
+    offset += individuals.size() * sizeof(Entry);
+
+    for (auto const& ind : individuals) {
+        write(ind.Fitness.data(), objectives * sizeof(Operon::Scalar));
+    }
+    offset += individuals.size() * objectives * sizeof(Operon::Scalar);
+
+    std::vector<char> zeros((Alignment - offset % Alignment) % Alignment, 0);
+    write(zeros.data(), zeros.size());
+    for (auto const& ind : individuals) {
+        auto const& nodes = ind.Genotype.Nodes();
+        write(nodes.data(), nodes.size() * sizeof(Node));
+    }
+    if (!f) { throw std::runtime_error(fmt::format("{}: failed to write the model archive\n", path)); }
+}
+
+ModelArchive::ModelArchive(std::string const& path)
+{
+#if defined(_WIN32)
+    // no memory mapping, the archive is copied into an owned buffer
+    std::ifstream f(path, std::ios::binary);
+    if (!f) { throw std::runtime_error(fmt::format("{}: cannot open file\n", path)); }
+    auto buffer = std::make_shared<std::string>((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    auto const* bytes = buffer->data();
+    auto const size = buffer->size();
+    storage_ = std::shared_ptr<void const>(buffer, buffer->data());
+#else
+    auto fd = ::open(path.c_str(), O_RDONLY); // NOLINT
+    if (fd < 0) { throw std::runtime_error(fmt::format("{}: cannot open file\n", path)); }
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error(fmt::format("{}: cannot stat file\n", path));
+    }
+    auto const size = static_cast<size_t>(st.st_size);
+    if (size == 0) {
+        ::close(fd);
+        throw std::runtime_error(fmt::format("{}: not a model archive\n", path));
+    }
+    auto* addr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // the mapping stays valid
+    if (addr == MAP_FAILED) { throw std::runtime_error(fmt::format("{}: cannot map file\n", path)); } // NOLINT
+    storage_ = std::shared_ptr<void const>(addr, [size](void const* p) { ::munmap(const_cast<void*>(p), size); }); // NOLINT
+    auto const* bytes = static_cast<char const*>(addr);
+#endif
+
+    auto fail = [&](auto const& reason) { throw std::runtime_error(fmt::format("{}: {}\n", path, reason)); };
+    size_t pos { 0 };
+    auto read = [&](void* dst, size_t n) {
+        if (pos + n > size) { fail("unexpected end of file"); }
+        if (n > 0) { std::memcpy(dst, bytes + pos, n); }
+        pos += n;
+    };
+
+    Header header {};
+    read(&header, sizeof(header));
+    if (header.Magic != Magic) { fail("not a model archive"); }
+    if (header.Version != Version) { fail(fmt::format("unsupported version {}", header.Version)); }
+    if (header.Layout != Layout) { fail("the archive was written by a build with a different node layout"); }
+    if (header.Metadata > size) { fail("unexpected end of file"); }
+
+    metadata_.resize(header.Metadata);
+    read(metadata_.data(), metadata_.size());
+
+    if (header.Variables > size) { fail("unexpected end of file"); }
+    variables_.resize(header.Variables);
+    for (size_t i = 0; i < variables_.size(); ++i) {
+        auto& v = variables_[i];
+        uint64_t length { 0 };
+        read(&v.Hash, sizeof(v.Hash));
+        read(&length, sizeof(length));
+        if (length > size) { fail("unexpected end of file"); }
+        v.Index = i;
+        v.Name.resize(length);
+        read(v.Name.data(), length);
+    }
+
+    if (header.Models > size / sizeof(Entry)) { fail("unexpected end of file"); }
+    index_.resize(header.Models);
+    read(index_.data(), index_.size() * sizeof(Entry));
+
+    objectives_ = header.Objectives;
+    if (objectives_ > 0 && header.Models > size / (objectives_ * sizeof(Operon::Scalar))) { fail("unexpected end of file"); }
+    fitness_.resize(header.Models * objectives_);
+    read(fitness_.data(), fitness_.size() * sizeof(Operon::Scalar));
+
+    pos += (Alignment - pos % Alignment) % Alignment;
+    uint64_t count { 0 };
+    for (auto const& e : index_) {
+        if (e.First != count) { fail("invalid model index"); }
+        count += e.Length;
+    }
+    if (pos > size || count > (size - pos) / sizeof(Node)) { fail("unexpected end of file"); }
+    nodes_ = { reinterpret_cast<Node const*>(bytes + pos), count }; // NOLINT
+}
+
+auto ModelArchive::Remap(Operon::Span<Variable const> variables) -> void
+{
+    remap_.clear();
+    for (auto const& v : variables_) {
+        auto it = std::find_if(variables.begin(), variables.end(), [&](auto const& w) { return w.Name == v.Name; });
+        if (it == variables.end()) { throw std::runtime_error(fmt::format("model archive: variable {} not found\n", v.Name)); }
+        if (it->Hash != v.Hash) { remap_[v.Hash] = it->Hash; }
+    }
+}
+
+auto ModelArchive::Nodes(size_t i) const -> Operon::Span<Node const>
+{
+    EXPECT(i < Size());
+    return nodes_.subspan(index_[i].First, index_[i].Length);
+}
+
+auto ModelArchive::Fitness(size_t i) const -> Operon::Span<Operon::Scalar const>
+{
+    EXPECT(i < Size());
+    return { fitness_.data() + i * objectives_, objectives_ };
+}
+
+auto ModelArchive::GetTree(size_t i) const -> Tree
+{
+    auto source = Nodes(i);
+    auto nodes = NodePool::Acquire(source.size());
+    nodes.assign(source.begin(), source.end()); // the derived fields are stored, no need to update the nodes
+    if (!remap_.empty()) {
+        for (auto& n : nodes) {
+            if (!n.IsVariable()) { continue; }
+            if (auto it = remap_.find(n.HashValue); it != remap_.end()) {
+                n.HashValue = n.CalculatedHashValue = it->second;
+            }
+        }
+    }
+    return Tree(std::move(nodes));
+}
+
+auto ModelArchive::GetIndividual(size_t i) const -> Individual
+{
+    Individual ind(objectives_);
+    ind.Genotype = GetTree(i);
+    auto fitness = Fitness(i);
+    std::copy(fitness.begin(), fitness.end(), ind.Fitness.begin());
+    return ind;
+}
+
+} // namespace Operon
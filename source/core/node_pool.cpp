@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include "operon/core/node_pool.hpp"
+
+namespace Operon {
+
+namespace {
+    auto FreeList() -> std::vector<Operon::Vector<Node>>&
+    {
+        thread_local std::vector<Operon::Vector<Node>> buffers;
+        return buffers;
+    }
+} // namespace
+
+auto NodePool::Acquire(size_t capacity) -> Operon::Vector<Node>
+{
+    auto& buffers = FreeList();
+    Operon::Vector<Node> nodes;
+    if (!buffers.empty()) {
+        nodes = std::move(buffers.back());
+        buffers.pop_back();
+    }
+    nodes.reserve(capacity);
+    return nodes;
+}
+
+void NodePool::Release(Operon::Vector<Node>&& nodes)
+{
+    auto& buffers = FreeList();
+    if (nodes.capacity() == 0 || buffers.size() >= MaxBuffers) {
+        Operon::Vector<Node> discard{std::move(nodes)};
+        return;
+    }
+    nodes.clear();
+    buffers.push_back(std::move(nodes));
+}
+
+auto NodePool::Copy(Tree const& tree) -> Tree
+{
+    auto const& nodes = tree.Nodes();
+    auto copy = Acquire(nodes.size());
+    copy.insert(copy.end(), nodes.begin(), nodes.end());
+    return Tree(std::move(copy));
+}
+
+auto NodePool::Size() -> size_t
+{
+    return FreeList().size();
+}
+
+void NodePool::Clear()
+{
+    FreeList().clear();
+}
+
+} // namespace Operon
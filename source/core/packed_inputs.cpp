@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include "operon/core/packed_inputs.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace Operon {
+
+PackedInputs::PackedInputs(Dataset const& dataset, Operon::Span<Variable const> inputs, size_t tileRows)
+    : rows_(dataset.Rows())
+    , tileRows_(std::max(size_t{1}, tileRows))
+{
+    hashes_.reserve(inputs.size());
+    for (auto const& v : inputs) { hashes_.push_back(v.Hash); }
+    values_.resize(Tiles() * TileStride(), Operon::Scalar{0});
+
+    for (size_t c = 0; c < hashes_.size(); ++c) {
+        // the rows before the first one of a lag view have no value (see Dataset::FirstRow)
+        auto const column = dataset.GetValues(hashes_[c]);
+        auto const first = rows_ - column.size();
+        auto* out = values_.data() + c * tileRows_;
+        for (size_t r = 0; r < first; ++r) { out[TileOffset(r)] = std::numeric_limits<Operon::Scalar>::quiet_NaN(); }
+        for (size_t r = first; r < rows_;) {
+            auto const n = std::min(tileRows_ - r % tileRows_, rows_ - r);
+            std::copy_n(column.data() + (r - first), n, out + TileOffset(r));
+            r += n;
+        }
+    }
+}
+
+auto PackedInputs::Column(Operon::Hash hash) const -> int64_t
+{
+    auto it = std::find(hashes_.begin(), hashes_.end(), hash);
+    return it == hashes_.end() ? -1 : static_cast<int64_t>(it - hashes_.begin());
+}
+
+} // namespace Operon
@@ -0,0 +1,311 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <numeric>
+
+#include "operon/core/contracts.hpp"
+#include "operon/core/pareto_archive.hpp"
+
+namespace Operon {
+
+namespace {
+    // the box coordinates are clamped to keep the huge objective values (e.g. of failed evaluations) representable
+    constexpr double MaxBox{4e18};
+
+    // box a is smaller or equal to box b in every objective
+    inline auto Leq(int64_t const* a, int64_t const* b, size_t m) -> bool
+    {
+        for (size_t k = 0; k < m; ++k) {
+            if (a[k] > b[k]) { return false; }
+        }
+        return true;
+    }
+} // namespace
+
+ParetoArchive::ParetoArchive(std::vector<Operon::Scalar> epsilon)
+    : epsilon_(std::move(epsilon))
+{
+    EXPECT(!epsilon_.empty());
+    EXPECT(std::all_of(epsilon_.begin(), epsilon_.end(), [](auto e) { return e > 0; }));
+}
+
+auto ParetoArchive::BoxOf(Operon::Span<Operon::Scalar const> fitness, Box& box) const -> bool
+{
+    EXPECT(fitness.size() == Objectives());
+    box.resize(fitness.size());
+    for (size_t k = 0; k < fitness.size(); ++k) {
+        if (!std::isfinite(fitness[k])) { return false; }
+        auto const v = std::floor(static_cast<double>(fitness[k]) / static_cast<double>(epsilon_[k]));
+        box[k] = static_cast<int64_t>(std::clamp(v, -MaxBox, MaxBox));
+    }
+    return true;
+}
+
+auto ParetoArchive::Query(Box const& box) const -> Relation
+{
+    Relation relation;
+    if (root_ < 0) { return relation; }
+    auto const m = Objectives();
+    std::vector<int64_t> stack{root_};
+    while (!stack.empty()) {
+        auto const i = stack.back();
+        stack.pop_back();
+        // no box of the subtree is smaller or equal to the candidate box
+        if (!Leq(lower_.data() + i * m, box.data(), m)) { continue; }
+        auto const& node = nodes_[i];
+        if (alive_[node.Entry]) {
+            auto const* b = BoxOf(node.Entry);
+            if (Leq(b, box.data(), m)) {
+                if (!std::equal(b, b + m, box.begin())) {
+                    relation.Dominated = true;
+                    return relation;
+                }
+                relation.Same = static_cast<int64_t>(node.Entry);
+            }
+        }
+        if (node.Left >= 0) { stack.push_back(node.Left); }
+        if (node.Right >= 0) { stack.push_back(node.Right); }
+    }
+    return relation;
+}
+
+auto ParetoArchive::Loses(Operon::Span<Operon::Scalar const> fitness, Box const& box, size_t member) const -> bool
+{
+    auto const& other = members_[member].Fitness;
+    auto const m = Objectives();
+    bool better{false}; // the candidate is better in some objective
+    bool worse{false};  // the candidate is worse in some objective
+    for (size_t k = 0; k < m; ++k) {
+        better |= fitness[k] < other[k];
+        worse |= fitness[k] > other[k];
+    }
+    if (better != worse) { return worse; } // one dominates the other
+
+    // the distances to the corner of the box, in units of epsilon
+    auto distance = [&](auto const& f) {
+        double d{0};
+        for (size_t k = 0; k < m; ++k) {
+            auto const e = static_cast<double>(epsilon_[k]);
+            auto const u = (static_cast<double>(f[k]) - static_cast<double>(box[k]) * e) / e;
+            d += u * u;
+        }
+        return d;
+    };
+    return distance(fitness) >= distance(other);
+}
+
+auto ParetoArchive::Rejects(Operon::Span<Operon::Scalar const> fitness, Box const& box) const -> bool
+{
+    auto const relation = Query(box);
+    return relation.Dominated || (relation.Same >= 0 && Loses(fitness, box, static_cast<size_t>(relation.Same)));
+}
+
+auto ParetoArchive::Dominates(Operon::Span<Operon::Scalar const> fitness) const -> bool
+{
+    Box box;
+    if (!BoxOf(fitness, box)) { return true; }
+    std::shared_lock lock(lock_);
+    return Rejects(fitness, box);
+}
+
+auto ParetoArchive::Insert(Individual const& individual) -> bool
+{
+    Operon::Span<Operon::Scalar const> fitness(individual.Fitness.data(), individual.Fitness.size());
+    Box box;
+    if (!BoxOf(fitness, box)) { return false; }
+    {
+        std::shared_lock lock(lock_);
+        if (Rejects(fitness, box)) { return false; }
+    }
+
+    // the archive may have changed in the meantime
+    std::unique_lock lock(lock_);
+    auto const relation = Query(box);
+    if (relation.Dominated) { return false; }
+    if (relation.Same >= 0) {
+        // the members are mutually non-dominated, so the box of the candidate dominates no other member
+        if (Loses(fitness, box, static_cast<size_t>(relation.Same))) { return false; }
+        Remove(static_cast<size_t>(relation.Same));
+    } else {
+        RemoveDominated(box);
+    }
+    Add(individual, box);
+    return true;
+}
+
+auto ParetoArchive::Insert(Operon::Span<Individual const> individuals) -> size_t
+{
+    return std::transform_reduce(individuals.begin(), individuals.end(), size_t{0}, std::plus{}, [&](auto const& ind) { return static_cast<size_t>(Insert(ind)); });
+}
+
+auto ParetoArchive::Remove(size_t entry) -> void
+{
+    alive_[entry] = false;
+    members_[entry] = Member{}; // the box stays in the tree until the next rebuild
+    --size_;
+}
+
+auto ParetoArchive::RemoveDominated(Box const& box) -> void
+{
+    if (root_ < 0) { return; }
+    auto const m = Objectives();
+    std::vector<int64_t> stack{root_};
+    while (!stack.empty()) {
+        auto const i = stack.back();
+        stack.pop_back();
+        // no box of the subtree is larger or equal to the candidate box
+        if (!Leq(box.data(), upper_.data() + i * m, m)) { continue; }
+        auto const& node = nodes_[i];
+        if (alive_[node.Entry]) {
+            auto const* b = BoxOf(node.Entry);
+            if (Leq(box.data(), b, m) && !std::equal(b, b + m, box.begin())) { Remove(node.Entry); }
+        }
+        if (node.Left >= 0) { stack.push_back(node.Left); }
+        if (node.Right >= 0) { stack.push_back(node.Right); }
+    }
+}
+
+auto ParetoArchive::Add(Individual const& individual, Box const& box) -> void
+{
+    auto const m = Objectives();
+    auto const entry = members_.size();
+    members_.push_back({ CompactTree(individual.Genotype), individual.Fitness });
+    boxes_.insert(boxes_.end(), box.begin(), box.end());
+    alive_.push_back(true);
+    ++size_;
+
+    auto const node = static_cast<int64_t>(nodes_.size());
+    nodes_.push_back({ entry });
+    lower_.insert(lower_.end(), box.begin(), box.end());
+    upper_.insert(upper_.end(), box.begin(), box.end());
+
+    if (root_ < 0) {
+        root_ = node;
+        depth_ = 1;
+    } else {
+        // descend to a leaf, widening the bounds of the subtrees on the way
+        auto i = root_;
+        size_t depth{1};
+        for (;;) {
+            for (size_t k = 0; k < m; ++k) {
+                lower_[i * m + k] = std::min(lower_[i * m + k], box[k]);
+                upper_[i * m + k] = std::max(upper_[i * m + k], box[k]);
+            }
+            auto& parent = nodes_[i];
+            auto& child = box[parent.Axis] < BoxOf(parent.Entry)[parent.Axis] ? parent.Left : parent.Right;
+            ++depth;
+            if (child < 0) {
+                child = node;
+                nodes_[node].Axis = (parent.Axis + 1) % m;
+                break;
+            }
+            i = child;
+        }
+        depth_ = std::max(depth_, depth);
+    }
+
+    // rebuild when the entries (including the removed ones) doubled since the last rebuild or the tree degenerated
+    constexpr size_t minEntries{16};
+    auto const entries = members_.size();
+    if (entries >= 2 * rebuilt_ + minEntries || static_cast<double>(depth_) > 4 * std::log2(static_cast<double>(entries) + 1) + 8) {
+        Rebuild();
+    }
+}
+
+auto ParetoArchive::Rebuild() -> void
+{
+    auto const m = Objectives();
+
+    // keep the live members only
+    size_t n{0};
+    for (size_t i = 0; i < members_.size(); ++i) {
+        if (!alive_[i]) { continue; }
+        if (i != n) {
+            members_[n] = std::move(members_[i]);
+            std::copy_n(boxes_.begin() + static_cast<int64_t>(i * m), m, boxes_.begin() + static_cast<int64_t>(n * m));
+        }
+        ++n;
+    }
+    members_.resize(n);
+    boxes_.resize(n * m);
+    alive_.assign(n, true);
+
+    // balanced by median splits on the coordinates in turn
+    nodes_.clear();
+    nodes_.reserve(n);
+    lower_.resize(n * m);
+    upper_.resize(n * m);
+    std::vector<size_t> index(n);
+    std::iota(index.begin(), index.end(), size_t{0});
+    depth_ = 0;
+    auto build = [&](auto&& self, size_t first, size_t last, size_t axis, size_t depth) -> int64_t {
+        if (first == last) { return -1; }
+        depth_ = std::max(depth_, depth);
+        auto const mid = first + (last - first) / 2;
+        std::nth_element(index.begin() + static_cast<int64_t>(first), index.begin() + static_cast<int64_t>(mid), index.begin() + static_cast<int64_t>(last),
+            [&](auto a, auto b) { return BoxOf(a)[axis] < BoxOf(b)[axis]; });
+        auto const node = static_cast<int64_t>(nodes_.size());
+        nodes_.push_back({ index[mid], -1, -1, axis });
+        auto const next = (axis + 1) % m;
+        auto const left = self(self, first, mid, next, depth + 1);
+        auto const right = self(self, mid + 1, last, next, depth + 1);
+        nodes_[node].Left = left;
+        nodes_[node].Right = right;
+
+        auto const* b = BoxOf(index[mid]);
+        for (size_t k = 0; k < m; ++k) {
+            auto lo = b[k];
+            auto hi = b[k];
+            for (auto c : { left, right }) {
+                if (c < 0) { continue; }
+                lo = std::min(lo, lower_[c * m + k]);
+                hi = std::max(hi, upper_[c * m + k]);
+            }
+            lower_[node * m + k] = lo;
+            upper_[node * m + k] = hi;
+        }
+        return node;
+    };
+    root_ = build(build, 0, n, 0, 1);
+    rebuilt_ = n;
+}
+
+auto ParetoArchive::Members() const -> std::vector<Individual>
+{
+    std::shared_lock lock(lock_);
+    std::vector<Individual> members;
+    members.reserve(size_);
+    for (size_t i = 0; i < members_.size(); ++i) {
+        if (!alive_[i]) { continue; }
+        auto& ind = members.emplace_back(members_[i].Fitness.size());
+        ind.Genotype = members_[i].Genotype.ToTree();
+        ind.Fitness = members_[i].Fitness;
+    }
+    return members;
+}
+
+auto ParetoArchive::Size() const -> size_t
+{
+    std::shared_lock lock(lock_);
+    return size_;
+}
+
+auto ParetoArchive::Clear() -> void
+{
+    std::unique_lock lock(lock_);
+    members_.clear();
+    boxes_.clear();
+    alive_.clear();
+    nodes_.clear();
+    lower_.clear();
+    upper_.clear();
+    size_ = 0;
+    root_ = -1;
+    depth_ = 0;
+    rebuilt_ = 0;
+}
+
+} // namespace Operon
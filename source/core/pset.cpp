@@ -6,46 +6,96 @@
 #include "operon/core/pset.hpp"
 
 namespace Operon {
-    auto PrimitiveSet::SampleRandomSymbol(Operon::RandomGenerator& random, size_t minArity, size_t maxArity) const -> Node
+    void PrimitiveSet::UpdateSamplingTables()
     {
-        EXPECT(minArity <= maxArity);
-        EXPECT(!pset_.empty());
+        candidates_.clear();
+        enabled_.clear();
+        tables_.clear();
+        members_.clear();
+        tabulatedArity_ = 0;
 
-        std::vector<Node> candidates; candidates.reserve(pset_.size());
         for (auto const& [k, v] : pset_) {
-            auto [node, freq, min_arity, max_arity] = v;
+            auto const& [node, freq, min_arity, max_arity] = v;
             if (!(node.IsEnabled && freq > 0)) { continue; }
-            if (minArity > max_arity || maxArity < min_arity) { continue; }
-            candidates.push_back(node);
+            candidates_.push_back(v);
+            enabled_.push_back(node);
+            tabulatedArity_ = std::max(tabulatedArity_, max_arity);
         }
 
-        // throw an error if arity requirements are unreasonable (TODO: maybe here return optional)
-        if (candidates.empty()) {
-            // arity requirements unreasonable
-            throw std::runtime_error(fmt::format("PrimitiveSet::SampleRandomSymbol: unable to find suitable symbol with arity between {} and {}\n", minArity, maxArity));
+        if (candidates_.empty() || tabulatedArity_ > MaxTabulatedArity) {
+            return;
         }
 
-        auto sum = std::transform_reduce(candidates.begin(), candidates.end(), 0.0, std::plus{}, [&](auto& n) { return Frequency(n.HashValue); });
+        auto const n = tabulatedArity_ + 1;
+        tables_.resize(n * n);
+        members_.resize(n * n);
+        std::vector<double> weights;
+        for (size_t lo = 0; lo < n; ++lo) {
+            for (size_t hi = lo; hi < n; ++hi) {
+                auto& members = members_[lo * n + hi];
+                weights.clear();
+                for (size_t i = 0; i < candidates_.size(); ++i) {
+                    auto const& [node, freq, min_arity, max_arity] = candidates_[i];
+                    if (lo > max_arity || hi < min_arity) { continue; }
+                    members.push_back(i);
+                    weights.push_back(static_cast<double>(freq));
+                }
+                if (!members.empty()) {
+                    tables_[lo * n + hi] = Random::AliasTable(Operon::Span<double const>(weights));
+                }
+            }
+        }
+    }
 
-        auto r = std::uniform_real_distribution<double>(0., sum)(random);
-        auto c = 0.0;
+    auto PrimitiveSet::SampleRandomSymbol(Operon::RandomGenerator& random, size_t minArity, size_t maxArity) const -> Node
+    {
+        EXPECT(minArity <= maxArity);
+        EXPECT(!pset_.empty());
 
-        Node node(NodeType::Constant);
-        for (auto const& candidate : candidates) {
-            node = candidate;
-            c += static_cast<double>(Frequency(node.HashValue));
+        auto matches = [&](Primitive const& p) {
+            return !(minArity > std::get<MAXARITY>(p) || maxArity < std::get<MINARITY>(p));
+        };
 
-            if (c > r) {
-                auto amin = std::max(minArity, MinimumArity(node.HashValue));
-                auto amax = std::min(maxArity, MaximumArity(node.HashValue));
-                auto arity = std::uniform_int_distribution<size_t>(amin, amax)(random);
-                node.Arity = static_cast<uint16_t>(arity);
-                break;
+        Primitive const* primitive = nullptr;
+        if (!tables_.empty()) {
+            // the candidates never have an arity above tabulatedArity_, so the range can be clamped
+            if (minArity <= tabulatedArity_) {
+                auto const slot = minArity * (tabulatedArity_ + 1) + std::min(maxArity, tabulatedArity_);
+                if (auto const& table = tables_[slot]; !table.Empty()) {
+                    primitive = &candidates_[members_[slot][table(random)]];
+                }
             }
+        } else {
+            // very large arities: cumulative frequency selection over the candidates
+            auto sum = std::transform_reduce(candidates_.begin(), candidates_.end(), 0.0, std::plus{}, [&](auto const& p) {
+                return matches(p) ? static_cast<double>(std::get<FREQUENCY>(p)) : 0.0;
+            });
+            if (sum > 0) {
+                auto r = Random::Uniform(random, 0., sum);
+                auto c = 0.0;
+                for (auto const& p : candidates_) {
+                    if (!matches(p)) { continue; }
+                    primitive = &p;
+                    c += static_cast<double>(std::get<FREQUENCY>(p));
+                    if (c > r) { break; }
+                }
+            }
+        }
+
+        // throw an error if arity requirements are unreasonable (TODO: maybe here return optional)
+        if (primitive == nullptr) {
+            // arity requirements unreasonable
+            throw std::runtime_error(fmt::format("PrimitiveSet::SampleRandomSymbol: unable to find suitable symbol with arity between {} and {}\n", minArity, maxArity));
         }
 
-        ENSURE(IsEnabled(node.HashValue));
-        ENSURE(Frequency(node.HashValue) > 0);
+        auto node = std::get<NODE>(*primitive);
+        auto amin = std::max(minArity, std::get<MINARITY>(*primitive));
+        auto amax = std::min(maxArity, std::get<MAXARITY>(*primitive));
+        auto arity = Random::Uniform(random, amin, amax);
+        node.Arity = static_cast<uint16_t>(arity);
+
+        ENSURE(node.IsEnabled);
+        ENSURE(std::get<FREQUENCY>(*primitive) > 0);
 
         return node;
     }
@@ -0,0 +1,48 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <numeric>
+#include <thread>
+
+#include "operon/core/affinity.hpp"
+#include "operon/core/contracts.hpp"
+#include "operon/core/replicated_dataset.hpp"
+
+namespace Operon {
+
+ReplicatedDataset::ReplicatedDataset(Dataset const& dataset)
+    : ReplicatedDataset(dataset, Affinity::Nodes().size())
+{
+}
+
+ReplicatedDataset::ReplicatedDataset(Dataset const& dataset, size_t nodes)
+    : replicas_(nodes)
+{
+    EXPECT(nodes > 0);
+    std::vector<size_t> rows;
+    if (dataset.IsView()) {
+        rows.resize(dataset.Rows());
+        std::iota(rows.begin(), rows.end(), size_t{0});
+    }
+
+    std::vector<std::thread> threads;
+    threads.reserve(nodes);
+    for (size_t k = 0; k < nodes; ++k) {
+        threads.emplace_back([&, k]() {
+            // if the thread cannot be bound the copy is still valid, it is just not placed
+            static_cast<void>(Affinity::BindToNode(k));
+            replicas_[k] = dataset.IsView()
+                ? std::make_unique<Dataset const>(dataset.Gather(rows))
+                : std::make_unique<Dataset const>(dataset);
+        });
+    }
+    for (auto& t : threads) { t.join(); }
+    memory_.Update(nodes * Memory::Footprint(*replicas_.front()));
+}
+
+auto ReplicatedDataset::Local() const -> Dataset const&
+{
+    return Replica(Affinity::CurrentNode());
+}
+
+} // namespace Operon
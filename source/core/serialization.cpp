@@ -0,0 +1,504 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+#include "operon/collections/bitset.hpp"
+#include "operon/core/contracts.hpp"
+#include "operon/core/dataset.hpp"
+#include "operon/core/node_pool.hpp"
+#include "operon/core/serialization.hpp"
+
+namespace Operon::Serialization {
+    namespace {
+        template<typename T>
+        auto Put(std::byte* out, T value) -> std::byte*
+        {
+            std::memcpy(out, &value, sizeof(T));
+            return out + sizeof(T);
+        }
+
+        template<typename To, typename From>
+        auto BitCast(From value) -> To
+        {
+            static_assert(sizeof(To) == sizeof(From));
+            To result{};
+            std::memcpy(&result, &value, sizeof(To));
+            return result;
+        }
+
+        template<typename T>
+        auto Get(std::byte const* in, T& value) -> std::byte const*
+        {
+            std::memcpy(&value, in, sizeof(T));
+            return in + sizeof(T);
+        }
+
+        // the compact encoding (see CompactCodec)
+        constexpr uint8_t TypeMask { 0x1F };
+        constexpr uint8_t ArityFlag { 1U << 5U };
+        constexpr uint8_t ValueFlag { 1U << 6U };
+        constexpr uint8_t DisabledFlag { 1U << 7U };
+
+        // the arity given to every type by the node constructor
+        auto const DefaultArity = []() {
+            std::array<uint16_t, NodeTypes::Count> arity {};
+            for (size_t i = 0; i < NodeTypes::Count; ++i) {
+                arity[i] = Node(static_cast<NodeType>(1U << i)).Arity;
+            }
+            return arity;
+        }();
+
+        auto PutVarint(std::vector<std::byte>& buffer, uint64_t value) -> void
+        {
+            while (value >= 0x80U) {
+                buffer.push_back(static_cast<std::byte>((value & 0x7FU) | 0x80U));
+                value >>= 7U;
+            }
+            buffer.push_back(static_cast<std::byte>(value));
+        }
+
+        auto GetVarint(Operon::Span<std::byte const> buffer, size_t& offset) -> uint64_t
+        {
+            EXPECT(offset < buffer.size());
+            auto const first = static_cast<uint8_t>(buffer[offset++]);
+            if (first < 0x80U) { return first; } // mostly
+            uint64_t value = first & 0x7FU;
+            for (uint32_t shift = 7;; shift += 7) {
+                EXPECT(offset < buffer.size() && shift < 64);
+                auto const b = static_cast<uint8_t>(buffer[offset++]);
+                value |= static_cast<uint64_t>(b & 0x7FU) << shift;
+                if (b < 0x80U) { return value; }
+            }
+        }
+
+        template<typename T>
+        auto PutRaw(std::vector<std::byte>& buffer, T value) -> void
+        {
+            auto const offset = buffer.size();
+            buffer.resize(offset + sizeof(T));
+            std::memcpy(buffer.data() + offset, &value, sizeof(T));
+        }
+
+        template<typename T>
+        auto GetRaw(Operon::Span<std::byte const> buffer, size_t& offset) -> T
+        {
+            EXPECT(offset + sizeof(T) <= buffer.size());
+            T value{};
+            std::memcpy(&value, buffer.data() + offset, sizeof(T));
+            offset += sizeof(T);
+            return value;
+        }
+
+        // round to nearest even on the upper half of the float
+        auto ToBFloat16(float value) -> uint16_t
+        {
+            auto const bits = BitCast<uint32_t>(value);
+            if ((bits & 0x7FFFFFFFU) > 0x7F800000U) { return static_cast<uint16_t>((bits >> 16U) | 0x40U); } // nan
+            return static_cast<uint16_t>((bits + 0x7FFFU + ((bits >> 16U) & 1U)) >> 16U);
+        }
+
+        auto FromBFloat16(uint16_t value) -> float
+        {
+            return BitCast<float>(static_cast<uint32_t>(value) << 16U);
+        }
+
+        // the node as the decoder restores it, before Tree::UpdateNodes
+        auto Restored(Node const& node, CompactCodec const& codec) -> Node
+        {
+            Node n(node.Type, node.HashValue);
+            n.Arity = node.Arity;
+            n.Value = codec.Quantize(node.Value);
+            n.IsEnabled = node.IsEnabled;
+            return n;
+        }
+
+        auto Same(Node const& a, Node const& b) -> bool
+        {
+            return a.Type == b.Type && a.HashValue == b.HashValue && a.Arity == b.Arity && a.IsEnabled == b.IsEnabled && a.Value == b.Value;
+        }
+
+        // the key of a sequence of (restored) nodes, to look up the references
+        auto Key(Node const* first, Node const* last) -> uint64_t
+        {
+            uint64_t key { 0xcbf29ce484222325ULL };
+            for (auto const* n = first; n < last; ++n) {
+                auto k = n->HashValue ^ (BitCast<uint64_t>(static_cast<double>(n->Value)) * 0x9e3779b97f4a7c15ULL);
+                k ^= (static_cast<uint64_t>(n->Arity) << 48U) ^ (static_cast<uint64_t>(n->IsEnabled) << 63U);
+                key = (key ^ k) * 0x100000001b3ULL;
+                key ^= key >> 29U;
+            }
+            return key;
+        }
+
+        // the number of nodes compared at the start and at the end of the trees to find a reference
+        constexpr size_t AnchorLength { 4 };
+    } // namespace
+
+    auto Size(Individual const& ind) -> size_t
+    {
+        return HeaderSize + ind.Genotype.Length() * NodeSize + ind.Fitness.size() * sizeof(Operon::Scalar);
+    }
+
+    auto Write(Individual const& ind, std::vector<std::byte>& buffer) -> void
+    {
+        auto const& nodes = ind.Genotype.Nodes();
+        auto offset = buffer.size();
+        buffer.resize(offset + Size(ind));
+        auto* out = buffer.data() + offset;
+        out = Put(out, static_cast<uint32_t>(nodes.size()));
+        out = Put(out, static_cast<uint32_t>(ind.Fitness.size()));
+        for (auto const& node : nodes) {
+            out = Put(out, node.HashValue);
+            out = Put(out, node.Value);
+            out = Put(out, node.Arity);
+            out = Put(out, static_cast<uint32_t>(node.Type));
+            out = Put(out, static_cast<uint8_t>(node.IsEnabled));
+        }
+        for (auto v : ind.Fitness) {
+            out = Put(out, v);
+        }
+    }
+
+    auto Read(Operon::Span<std::byte const> buffer, size_t& offset) -> Individual
+    {
+        EXPECT(offset + HeaderSize <= buffer.size());
+        auto const* in = buffer.data() + offset;
+        uint32_t length{};
+        uint32_t objectives{};
+        in = Get(in, length);
+        in = Get(in, objectives);
+        EXPECT(offset + HeaderSize + length * NodeSize + objectives * sizeof(Operon::Scalar) <= buffer.size());
+
+        Individual ind(objectives);
+        auto nodes = NodePool::Acquire(length);
+        for (uint32_t i = 0; i < length; ++i) {
+            Operon::Hash hash{};
+            Operon::Scalar value{};
+            uint16_t arity{};
+            uint32_t type{};
+            uint8_t enabled{};
+            in = Get(in, hash);
+            in = Get(in, value);
+            in = Get(in, arity);
+            in = Get(in, type);
+            in = Get(in, enabled);
+            Node node(static_cast<NodeType>(type), hash);
+            node.Value = value;
+            node.Arity = arity;
+            node.IsEnabled = enabled != 0;
+            nodes.push_back(node);
+        }
+        for (auto& v : ind.Fitness) {
+            in = Get(in, v);
+        }
+        ind.Genotype = Tree(std::move(nodes));
+        if (length > 0) { ind.Genotype.UpdateNodes(); }
+        offset = static_cast<size_t>(in - buffer.data());
+        return ind;
+    }
+
+    auto Write(Operon::Span<Individual const> individuals) -> std::vector<std::byte>
+    {
+        std::vector<std::byte> buffer(sizeof(uint32_t));
+        Put(buffer.data(), static_cast<uint32_t>(individuals.size()));
+        for (auto const& ind : individuals) {
+            Write(ind, buffer);
+        }
+        return buffer;
+    }
+
+    auto Read(Operon::Span<std::byte const> buffer) -> std::vector<Individual>
+    {
+        EXPECT(buffer.size() >= sizeof(uint32_t));
+        uint32_t count{};
+        Get(buffer.data(), count);
+        std::vector<Individual> individuals;
+        individuals.reserve(count);
+        size_t offset{sizeof(uint32_t)};
+        for (uint32_t i = 0; i < count; ++i) {
+            individuals.push_back(Read(buffer, offset));
+        }
+        return individuals;
+    }
+
+    CompactCodec::CompactCodec(Operon::Span<Variable const> variables, Precision precision)
+        : precision_(precision)
+    {
+        hashes_.reserve(variables.size());
+        for (auto const& v : variables) {
+            if (indices_.insert({ v.Hash, hashes_.size() }).second) { hashes_.push_back(v.Hash); }
+        }
+    }
+
+    CompactCodec::CompactCodec(Dataset const& dataset, Precision precision)
+        : CompactCodec(dataset.Variables(), precision)
+    {
+        for (auto const& v : dataset.VirtualVariables()) {
+            if (indices_.insert({ v.Hash, hashes_.size() }).second) { hashes_.push_back(v.Hash); }
+        }
+    }
+
+    auto CompactCodec::Quantize(Operon::Scalar value) const -> Operon::Scalar
+    {
+        switch (precision_) {
+        case Precision::Single:
+            return static_cast<Operon::Scalar>(static_cast<float>(value));
+        case Precision::BFloat16:
+            return static_cast<Operon::Scalar>(FromBFloat16(ToBFloat16(static_cast<float>(value))));
+        default:
+            return value;
+        }
+    }
+
+    auto CompactCodec::EncodeNodes(Operon::Span<Node const> nodes, std::vector<std::byte>& buffer) const -> void
+    {
+        for (auto const& node : nodes) {
+            auto const index = Bitset<>::CountTrailingZeros(static_cast<UnderlyingNodeType>(node.Type));
+            EXPECT(index < NodeTypes::Count);
+            auto tag = static_cast<uint8_t>(index);
+            if (node.Arity != DefaultArity[index]) { tag |= ArityFlag; }
+            if (node.Value != Operon::Scalar{1}) { tag |= ValueFlag; }
+            if (!node.IsEnabled) { tag |= DisabledFlag; }
+            buffer.push_back(static_cast<std::byte>(tag));
+
+            if ((tag & ArityFlag) != 0) { PutVarint(buffer, node.Arity); }
+            if (node.IsVariable()) {
+                auto it = indices_.find(node.HashValue);
+                if (it == indices_.end()) {
+                    throw std::runtime_error(fmt::format("CompactCodec: the variable {} is not in the variable table", node.HashValue));
+                }
+                PutVarint(buffer, it->second);
+            } else if (node.Type == NodeType::Dynamic) {
+                PutRaw(buffer, node.HashValue);
+            } else {
+                EXPECT(node.HashValue == static_cast<Operon::Hash>(node.Type));
+            }
+            if ((tag & ValueFlag) != 0) {
+                switch (precision_) {
+                case Precision::Single:
+                    PutRaw(buffer, static_cast<float>(node.Value));
+                    break;
+                case Precision::BFloat16:
+                    PutRaw(buffer, ToBFloat16(static_cast<float>(node.Value)));
+                    break;
+                default:
+                    PutRaw(buffer, node.Value);
+                }
+            }
+        }
+    }
+
+    auto CompactCodec::DecodeNodes(Operon::Span<std::byte const> buffer, size_t& offset, size_t count, Operon::Vector<Node>& nodes) const -> void
+    {
+        for (size_t i = 0; i < count; ++i) {
+            EXPECT(offset < buffer.size());
+            auto const tag = static_cast<uint8_t>(buffer[offset++]);
+            auto const index = static_cast<size_t>(tag & TypeMask);
+            EXPECT(index < NodeTypes::Count);
+            auto const type = static_cast<NodeType>(1U << index);
+
+            auto arity = DefaultArity[index];
+            if ((tag & ArityFlag) != 0) { arity = static_cast<uint16_t>(GetVarint(buffer, offset)); }
+            auto hash = static_cast<Operon::Hash>(type);
+            if (type == NodeType::Variable) {
+                auto const v = GetVarint(buffer, offset);
+                EXPECT(v < hashes_.size());
+                hash = hashes_[v];
+            } else if (type == NodeType::Dynamic) {
+                hash = GetRaw<Operon::Hash>(buffer, offset);
+            }
+
+            auto& node = nodes.emplace_back(type, hash);
+            node.Arity = arity;
+            node.IsEnabled = (tag & DisabledFlag) == 0;
+            if ((tag & ValueFlag) != 0) {
+                switch (precision_) {
+                case Precision::Single:
+                    node.Value = static_cast<Operon::Scalar>(GetRaw<float>(buffer, offset));
+                    break;
+                case Precision::BFloat16:
+                    node.Value = static_cast<Operon::Scalar>(FromBFloat16(GetRaw<uint16_t>(buffer, offset)));
+                    break;
+                default:
+                    node.Value = GetRaw<Operon::Scalar>(buffer, offset);
+                }
+            }
+        }
+    }
+
+    auto CompactCodec::Encode(Individual const& ind, std::vector<std::byte>& buffer) const -> void
+    {
+        auto const& nodes = ind.Genotype.Nodes();
+        PutVarint(buffer, nodes.size());
+        PutVarint(buffer, ind.Fitness.size());
+        EncodeNodes({ nodes.data(), nodes.size() }, buffer);
+        for (auto v : ind.Fitness) { PutRaw(buffer, v); }
+    }
+
+    auto CompactCodec::Decode(Operon::Span<std::byte const> buffer, size_t& offset) const -> Individual
+    {
+        auto const length = GetVarint(buffer, offset);
+        auto const objectives = GetVarint(buffer, offset);
+        EXPECT(offset + length + objectives * sizeof(Operon::Scalar) <= buffer.size()); // at least a byte per node
+
+        Individual ind(objectives);
+        auto nodes = NodePool::Acquire(length);
+        DecodeNodes(buffer, offset, length, nodes);
+        for (auto& v : ind.Fitness) { v = GetRaw<Operon::Scalar>(buffer, offset); }
+        ind.Genotype = Tree(std::move(nodes));
+        if (length > 0) { ind.Genotype.UpdateNodes(); }
+        return ind;
+    }
+
+    auto CompactCodec::Encode(Operon::Span<Individual const> individuals) const -> std::vector<std::byte>
+    {
+        std::vector<std::byte> buffer;
+        PutVarint(buffer, individuals.size());
+        for (auto const& ind : individuals) { Encode(ind, buffer); }
+        return buffer;
+    }
+
+    auto CompactCodec::Decode(Operon::Span<std::byte const> buffer) const -> std::vector<Individual>
+    {
+        size_t offset{0};
+        auto const count = GetVarint(buffer, offset);
+        EXPECT(count <= buffer.size());
+        std::vector<Individual> individuals;
+        individuals.reserve(count);
+        for (uint64_t i = 0; i < count; ++i) {
+            individuals.push_back(Decode(buffer, offset));
+        }
+        return individuals;
+    }
+
+    auto DeltaEncoder::Encode(Operon::Span<Individual const> individuals) -> std::vector<std::byte>
+    {
+        // the lookup of the references by the key of their nodes (the first reference wins)
+        robin_hood::unordered_flat_map<uint64_t, uint32_t> whole;
+        robin_hood::unordered_flat_map<uint64_t, uint32_t> head;
+        robin_hood::unordered_flat_map<uint64_t, uint32_t> tail;
+        for (uint32_t r = 0; r < reference_.size(); ++r) {
+            auto const& ref = reference_[r];
+            auto const* first = ref.data();
+            auto const* last = ref.data() + ref.size();
+            auto const n = std::min(ref.size(), AnchorLength);
+            whole.insert({ Key(first, last), r });
+            head.insert({ Key(first, first + n), r });
+            tail.insert({ Key(last - n, last), r });
+        }
+
+        std::vector<Operon::Vector<Node>> restored(individuals.size());
+        std::vector<std::byte> payload;
+        PutVarint(payload, individuals.size());
+        for (size_t i = 0; i < individuals.size(); ++i) {
+            auto const& ind = individuals[i];
+            auto& nodes = restored[i];
+            nodes.reserve(ind.Genotype.Length());
+            for (auto const& node : ind.Genotype.Nodes()) { nodes.push_back(Restored(node, codec_)); }
+
+            PutVarint(payload, ind.Fitness.size());
+            for (auto v : ind.Fitness) { PutRaw(payload, v); }
+
+            // the candidate with the longest shared prefix and suffix
+            auto const* first = nodes.data();
+            auto const* last = nodes.data() + nodes.size();
+            auto const n = std::min(nodes.size(), AnchorLength);
+            std::array<uint64_t, 3> keys { Key(first, last), Key(first, first + n), Key(last - n, last) };
+            std::array<decltype(whole) const*, 3> maps { &whole, &head, &tail };
+            size_t best{0};
+            size_t reference{0};
+            size_t prefix{0};
+            size_t suffix{0};
+            for (size_t k = 0; k < keys.size(); ++k) {
+                auto it = maps[k]->find(keys[k]);
+                if (it == maps[k]->end()) { continue; }
+                auto const& ref = reference_[it->second];
+                auto const m = std::min(ref.size(), nodes.size());
+                size_t p{0};
+                while (p < m && Same(nodes[p], ref[p])) { ++p; }
+                size_t s{0};
+                while (s < m - p && Same(nodes[nodes.size() - 1 - s], ref[ref.size() - 1 - s])) { ++s; }
+                if (p + s > best) {
+                    best = p + s;
+                    reference = it->second;
+                    prefix = p;
+                    suffix = s;
+                }
+            }
+
+            if (best == 0) {
+                PutVarint(payload, 0);
+                PutVarint(payload, nodes.size());
+                codec_.EncodeNodes({ nodes.data(), nodes.size() }, payload);
+                continue;
+            }
+            PutVarint(payload, reference + 1);
+            PutVarint(payload, prefix);
+            PutVarint(payload, suffix);
+            auto const middle = nodes.size() - prefix - suffix;
+            PutVarint(payload, middle);
+            codec_.EncodeNodes({ nodes.data() + prefix, middle }, payload);
+        }
+        reference_ = std::move(restored);
+
+        std::vector<std::byte> frame;
+        frame.reserve(payload.size() + sizeof(uint64_t));
+        PutVarint(frame, payload.size());
+        frame.insert(frame.end(), payload.begin(), payload.end());
+        return frame;
+    }
+
+    auto DeltaDecoder::Decode(Operon::Span<std::byte const> buffer, size_t& offset) -> std::vector<Individual>
+    {
+        auto const size = GetVarint(buffer, offset);
+        EXPECT(offset + size <= buffer.size());
+        auto const frame = buffer.subspan(0, offset + size);
+        auto const count = GetVarint(frame, offset);
+        EXPECT(count <= size);
+
+        std::vector<Individual> individuals;
+        individuals.reserve(count);
+        std::vector<Operon::Vector<Node>> restored(count);
+        for (uint64_t i = 0; i < count; ++i) {
+            auto const objectives = GetVarint(frame, offset);
+            EXPECT(offset + objectives * sizeof(Operon::Scalar) <= frame.size());
+            Individual ind(objectives);
+            for (auto& v : ind.Fitness) { v = GetRaw<Operon::Scalar>(frame, offset); }
+
+            auto& nodes = restored[i];
+            auto const r = GetVarint(frame, offset);
+            if (r == 0) {
+                auto const length = GetVarint(frame, offset);
+                EXPECT(offset + length <= frame.size());
+                nodes.reserve(length);
+                codec_.DecodeNodes(frame, offset, length, nodes);
+            } else {
+                EXPECT(r - 1 < reference_.size());
+                auto const& ref = reference_[r - 1];
+                auto const prefix = GetVarint(frame, offset);
+                auto const suffix = GetVarint(frame, offset);
+                auto const middle = GetVarint(frame, offset);
+                EXPECT(prefix + suffix <= ref.size() && offset + middle <= frame.size());
+                nodes.reserve(prefix + middle + suffix);
+                nodes.insert(nodes.end(), ref.begin(), ref.begin() + static_cast<std::ptrdiff_t>(prefix));
+                codec_.DecodeNodes(frame, offset, middle, nodes);
+                nodes.insert(nodes.end(), ref.end() - static_cast<std::ptrdiff_t>(suffix), ref.end());
+            }
+
+            auto genotype = NodePool::Acquire(nodes.size());
+            genotype.insert(genotype.end(), nodes.begin(), nodes.end());
+            ind.Genotype = Tree(std::move(genotype));
+            if (!nodes.empty()) { ind.Genotype.UpdateNodes(); }
+            individuals.push_back(std::move(ind));
+        }
+        EXPECT(offset == frame.size());
+        reference_ = std::move(restored);
+        return individuals;
+    }
+} // namespace Operon::Serialization
@@ -0,0 +1,264 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "operon/core/contracts.hpp"
+#include "operon/core/node_pool.hpp"
+#include "operon/core/shared_forest.hpp"
+#include "operon/hash/hash.hpp"
+
+namespace Operon {
+
+namespace {
+    static_assert(std::is_trivially_copyable_v<Node>, "the nodes are stored as they are in memory");
+
+    // the children of the freed entries are dropped from the child array once they take more than half of it
+    constexpr size_t MinGarbage{1024};
+
+    // the hash of the node fields combined with the hash of the handles of the children, without building a buffer
+    // (the colliding keys are told apart by the comparison of the entries, see Intern)
+    auto Key(Node const& node, Operon::Span<SharedForest::Handle const> children) -> uint64_t
+    {
+        uint64_t value{0};
+        std::memcpy(&value, &node.Value, sizeof(node.Value));
+        std::array<uint64_t, 4> const fields{ node.HashValue, node.CalculatedHashValue, value,
+            static_cast<uint64_t>(node.Arity) | static_cast<uint64_t>(node.Type) << 16U | static_cast<uint64_t>(node.IsEnabled) << 48U };
+        auto const h = Operon::Hasher{}(reinterpret_cast<uint8_t const*>(fields.data()), sizeof(fields)); // NOLINT
+        if (children.empty()) { return h; }
+        auto const c = Operon::Hasher{}(reinterpret_cast<uint8_t const*>(children.data()), children.size_bytes()); // NOLINT
+        return h ^ (c + 0x9e3779b97f4a7c15ULL + (h << 6U) + (h >> 2U)); // NOLINT
+    }
+
+    auto Same(Node const& a, Node const& b) -> bool
+    {
+        return a.HashValue == b.HashValue && a.CalculatedHashValue == b.CalculatedHashValue && a.Arity == b.Arity
+            && a.Type == b.Type && a.IsEnabled == b.IsEnabled && std::memcmp(&a.Value, &b.Value, sizeof(a.Value)) == 0;
+    }
+
+    template<typename T>
+    auto Put(std::vector<std::byte>& buffer, T const* data, size_t count) -> void
+    {
+        auto const offset = buffer.size();
+        buffer.resize(offset + count * sizeof(T));
+        if (count > 0) { std::memcpy(buffer.data() + offset, data, count * sizeof(T)); }
+    }
+
+    template<typename T>
+    auto Get(Operon::Span<std::byte const> buffer, size_t& offset, T* data, size_t count) -> void
+    {
+        if (offset + count * sizeof(T) > buffer.size()) { throw std::runtime_error("shared forest: unexpected end of data"); }
+        if (count > 0) { std::memcpy(data, buffer.data() + offset, count * sizeof(T)); }
+        offset += count * sizeof(T);
+    }
+} // namespace
+
+auto SharedForest::Intern(Node const& node, Operon::Span<Handle const> children) -> Handle
+{
+    auto const key = Key(node, children);
+    auto it = index_.find(key);
+    auto const head = it == index_.end() ? None : it->second;
+    for (auto h = head; h != None; h = entries_[h].Next) {
+        auto const& e = entries_[h];
+        auto const c = ChildrenOf(e);
+        if (Same(e.Node, node) && std::equal(c.begin(), c.end(), children.begin())) { return h; }
+    }
+
+    Entry entry{ node, static_cast<uint32_t>(children_.size()), 0, head, key };
+    entry.Node.Level = 0;
+    entry.Node.Parent = 0;
+    children_.insert(children_.end(), children.begin(), children.end());
+    for (auto c : children) { ++entries_[c].References; }
+
+    Handle handle{0};
+    if (free_.empty()) {
+        handle = static_cast<Handle>(entries_.size());
+        EXPECT(handle != None);
+        entries_.push_back(entry);
+    } else {
+        handle = free_.back();
+        free_.pop_back();
+        entries_[handle] = entry;
+    }
+    index_[key] = handle;
+    return handle;
+}
+
+auto SharedForest::Insert(Tree const& tree) -> Handle
+{
+    if (tree.Empty()) { return None; }
+    std::vector<Handle> stack;
+    for (auto const& node : tree.Nodes()) {
+        EXPECT(stack.size() >= node.Arity);
+        auto const first = stack.size() - node.Arity;
+        auto const handle = Intern(node, { stack.data() + first, node.Arity });
+        stack.resize(first);
+        stack.push_back(handle);
+    }
+    EXPECT(stack.size() == 1);
+    Retain(stack.front());
+    return stack.front();
+}
+
+auto SharedForest::Retain(Handle handle) -> void
+{
+    if (handle == None) { return; }
+    EXPECT(handle < entries_.size());
+    ++entries_[handle].References;
+}
+
+auto SharedForest::Release(Handle handle) -> void
+{
+    if (handle == None) { return; }
+    EXPECT(handle < entries_.size() && entries_[handle].References > 0);
+    if (--entries_[handle].References == 0) { Free(handle); }
+    if (garbage_ > MinGarbage && 2 * garbage_ > children_.size()) { Compact(); }
+}
+
+auto SharedForest::Free(Handle handle) -> void
+{
+    std::vector<Handle> stack{handle};
+    while (!stack.empty()) {
+        auto const h = stack.back();
+        stack.pop_back();
+        auto const& entry = entries_[h];
+
+        // unlink the entry from the chain of its key
+        auto& head = index_[entry.Key];
+        if (head == h) {
+            if (entry.Next == None) { index_.erase(entry.Key); } else { head = entry.Next; }
+        } else {
+            auto prev = head;
+            while (entries_[prev].Next != h) { prev = entries_[prev].Next; }
+            entries_[prev].Next = entry.Next;
+        }
+
+        for (auto c : ChildrenOf(entry)) {
+            if (--entries_[c].References == 0) { stack.push_back(c); }
+        }
+        garbage_ += entry.Node.Arity;
+        free_.push_back(h);
+    }
+}
+
+auto SharedForest::Compact() -> void
+{
+    // the freed entries have no references (new entries only have none while being interned)
+    std::vector<Handle> children;
+    children.reserve(children_.size() - garbage_);
+    for (auto& entry : entries_) {
+        if (entry.References == 0) { continue; }
+        auto const c = ChildrenOf(entry);
+        entry.Children = static_cast<uint32_t>(children.size());
+        children.insert(children.end(), c.begin(), c.end());
+    }
+    children_ = std::move(children);
+    garbage_ = 0;
+}
+
+auto SharedForest::GetTree(Handle handle) const -> Tree
+{
+    if (handle == None) { return {}; }
+    EXPECT(handle < entries_.size() && entries_[handle].References > 0);
+    auto nodes = NodePool::Acquire(Length(handle));
+    auto expand = [&](auto&& self, Handle h) -> void {
+        auto const& entry = entries_[h];
+        for (auto c : ChildrenOf(entry)) { self(self, c); }
+        nodes.push_back(entry.Node);
+    };
+    expand(expand, handle);
+    Tree tree(std::move(nodes));
+    tree.UpdateNodes();
+    return tree;
+}
+
+auto SharedForest::Write(Operon::Span<Handle const> roots, std::vector<std::byte>& buffer) const -> void
+{
+    // the subtrees reachable from the roots, numbered in postfix order so the children precede their parents
+    std::vector<uint32_t> number(entries_.size(), None);
+    std::vector<Handle> order;
+    auto visit = [&](auto&& self, Handle h) -> void {
+        if (number[h] != None) { return; }
+        for (auto c : ChildrenOf(entries_[h])) { self(self, c); }
+        number[h] = static_cast<uint32_t>(order.size());
+        order.push_back(h);
+    };
+    for (auto r : roots) {
+        if (r == None) { continue; }
+        EXPECT(r < entries_.size() && entries_[r].References > 0);
+        visit(visit, r);
+    }
+
+    std::array<uint32_t, 2> const header{ static_cast<uint32_t>(order.size()), static_cast<uint32_t>(roots.size()) };
+    Put(buffer, header.data(), header.size());
+    std::vector<uint32_t> children;
+    for (auto h : order) {
+        auto const& entry = entries_[h];
+        Put(buffer, &entry.Node, 1);
+        children.clear();
+        for (auto c : ChildrenOf(entry)) { children.push_back(number[c]); }
+        Put(buffer, children.data(), children.size());
+    }
+    for (auto r : roots) { Put(buffer, r == None ? &None : &number[r], 1); }
+}
+
+auto SharedForest::Read(Operon::Span<std::byte const> buffer, size_t& offset) -> std::vector<Tree>
+{
+    std::array<uint32_t, 2> header{};
+    Get(buffer, offset, header.data(), header.size());
+    auto const [count, rootCount] = header;
+    if (offset + size_t{count} * sizeof(Node) > buffer.size()) { throw std::runtime_error("shared forest: unexpected end of data"); }
+
+    std::vector<Node> nodes(count);
+    std::vector<uint32_t> first(count + 1, 0);
+    std::vector<uint32_t> children;
+    for (uint32_t i = 0; i < count; ++i) {
+        Get(buffer, offset, &nodes[i], 1);
+        first[i] = static_cast<uint32_t>(children.size());
+        children.resize(children.size() + nodes[i].Arity);
+        Get(buffer, offset, children.data() + first[i], nodes[i].Arity);
+        if (!std::all_of(children.begin() + first[i], children.end(), [&](auto c) { return c < i; })) {
+            throw std::runtime_error("shared forest: invalid child index");
+        }
+    }
+    first[count] = static_cast<uint32_t>(children.size());
+
+    std::vector<uint32_t> roots(rootCount);
+    Get(buffer, offset, roots.data(), roots.size());
+
+    std::vector<Tree> trees;
+    trees.reserve(rootCount);
+    for (auto r : roots) {
+        if (r == None) {
+            trees.emplace_back();
+            continue;
+        }
+        if (r >= count) { throw std::runtime_error("shared forest: invalid root index"); }
+        auto flat = NodePool::Acquire(nodes[r].Length + size_t{1});
+        auto expand = [&](auto&& self, uint32_t i) -> void {
+            for (auto j = first[i]; j < first[i + 1]; ++j) { self(self, children[j]); }
+            flat.push_back(nodes[i]);
+        };
+        expand(expand, r);
+        Tree tree(std::move(flat));
+        tree.UpdateNodes();
+        trees.push_back(std::move(tree));
+    }
+    return trees;
+}
+
+auto SharedForest::Clear() -> void
+{
+    entries_.clear();
+    children_.clear();
+    free_.clear();
+    index_.clear();
+    garbage_ = 0;
+}
+
+} // namespace Operon
@@ -0,0 +1,181 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <numeric>
+#include <optional>
+
+#include "operon/core/tree.hpp"
+
+namespace Operon {
+
+namespace {
+    using Nodes = Operon::Vector<Node>;
+
+    // the value of a built-in function applied to constant arguments (given in argument order)
+    auto Fold(NodeType type, std::vector<double> const& args) -> std::optional<double>
+    {
+        auto const a = args.front();
+        auto rest = [&](double init, auto op) { return std::accumulate(args.begin() + 1, args.end(), init, op); };
+
+        switch (type) {
+        case NodeType::Add: return rest(a, std::plus<>{});
+        case NodeType::Mul: return rest(a, std::multiplies<>{});
+        case NodeType::Sub: return args.size() == 1 ? -a : a - rest(0.0, std::plus<>{});
+        case NodeType::Div: return args.size() == 1 ? 1 / a : a / rest(1.0, std::multiplies<>{});
+        case NodeType::Fmin: return *std::min_element(args.begin(), args.end());
+        case NodeType::Fmax: return *std::max_element(args.begin(), args.end());
+        case NodeType::Aq: return a / std::sqrt(1 + args[1] * args[1]);
+        case NodeType::Pow: return std::pow(a, args[1]);
+        case NodeType::Abs: return std::abs(a);
+        case NodeType::Acos: return std::acos(a);
+        case NodeType::Asin: return std::asin(a);
+        case NodeType::Atan: return std::atan(a);
+        case NodeType::Cbrt: return std::cbrt(a);
+        case NodeType::Ceil: return std::ceil(a);
+        case NodeType::Cos: return std::cos(a);
+        case NodeType::Cosh: return std::cosh(a);
+        case NodeType::Exp: return std::exp(a);
+        case NodeType::Floor: return std::floor(a);
+        case NodeType::Log: return std::log(a);
+        case NodeType::Logabs: return std::log(std::abs(a));
+        case NodeType::Log1p: return std::log1p(a);
+        case NodeType::Sin: return std::sin(a);
+        case NodeType::Sinh: return std::sinh(a);
+        case NodeType::Sqrt: return std::sqrt(a);
+        case NodeType::Sqrtabs: return std::sqrt(std::abs(a));
+        case NodeType::Tan: return std::tan(a);
+        case NodeType::Tanh: return std::tanh(a);
+        case NodeType::Square: return a * a;
+        default: return std::nullopt; // dynamic nodes
+        }
+    }
+
+    auto IsConstant(Nodes const& branch, double value) -> bool
+    {
+        return branch.size() == 1 && branch.front().IsConstant() && branch.front().Value == value;
+    }
+
+    auto StrictHash(Nodes const& branch) -> Operon::Hash
+    {
+        return TreeView(Operon::Span<Node const>(branch)).Hash(Operon::HashMode::Strict).HashValue();
+    }
+
+    // appends the node with the given arguments (in argument order) in postfix order
+    auto Assemble(Node node, std::vector<Nodes> const& args) -> Nodes
+    {
+        Nodes result;
+        node.Arity = static_cast<uint16_t>(args.size());
+        node.Length = 0;
+        for (auto it = args.rbegin(); it != args.rend(); ++it) {
+            result.insert(result.end(), it->begin(), it->end());
+            node.Length = static_cast<uint16_t>(node.Length + it->size());
+        }
+        result.push_back(node);
+        return result;
+    }
+
+    auto SimplifyBranch(Nodes const& nodes, size_t i) -> Nodes // NOLINT(misc-no-recursion)
+    {
+        auto const& n = nodes[i];
+        if (n.IsLeaf()) { return { n }; }
+
+        // simplified arguments, in argument order (the first argument is found at i - 1)
+        std::vector<Nodes> args;
+        args.reserve(n.Arity);
+        for (size_t k = 0, j = i - 1; k < n.Arity; ++k, j -= nodes[j].Length + 1) {
+            args.push_back(SimplifyBranch(nodes, j));
+        }
+
+        // constant folding
+        if (!n.IsDynamic() && std::all_of(args.begin(), args.end(), [](auto const& a) { return a.size() == 1 && a.front().IsConstant(); })) {
+            std::vector<double> values;
+            std::transform(args.begin(), args.end(), std::back_inserter(values), [](auto const& a) { return static_cast<double>(a.front().Value); });
+            if (auto v = Fold(n.Type, values); v.has_value() && std::isfinite(*v)) {
+                return { Node::Constant(*v) };
+            }
+        }
+
+        if (n.Is<NodeType::Add, NodeType::Mul>()) {
+            // flatten nested chains of the same operation, e.g. (a + b) + c = a + b + c
+            std::vector<Nodes> flat;
+            for (auto& a : args) {
+                auto const& root = a.back();
+                if (root.Type != n.Type) { flat.push_back(std::move(a)); continue; }
+                for (size_t k = 0, j = a.size() - 2; k < root.Arity; ++k, j -= a[j].Length + 1) {
+                    auto first = a.begin() + static_cast<std::ptrdiff_t>(j - a[j].Length);
+                    flat.emplace_back(first, a.begin() + static_cast<std::ptrdiff_t>(j + 1));
+                }
+            }
+
+            // merge the constant arguments and drop the neutral element
+            auto const neutral = n.IsAddition() ? 0.0 : 1.0;
+            std::vector<Nodes> rest;
+            std::vector<double> constants;
+            for (auto& a : flat) {
+                if (a.size() == 1 && a.front().IsConstant()) {
+                    constants.push_back(static_cast<double>(a.front().Value));
+                } else {
+                    rest.push_back(std::move(a));
+                }
+            }
+            if (!constants.empty()) {
+                auto c = n.IsAddition()
+                    ? std::accumulate(constants.begin(), constants.end(), 0.0)
+                    : std::accumulate(constants.begin(), constants.end(), 1.0, std::multiplies<>{});
+                if (!std::isfinite(c)) {
+                    // keep the constants as they are
+                    std::transform(constants.begin(), constants.end(), std::back_inserter(rest), [](auto v) { return Nodes{ Node::Constant(v) }; });
+                } else if (c != neutral || rest.empty()) {
+                    rest.push_back({ Node::Constant(c) });
+                }
+            }
+            if (rest.size() == 1) { return std::move(rest.front()); }
+            return Assemble(n, rest);
+        }
+
+        if (n.Is<NodeType::Sub, NodeType::Div>() && n.Arity > 1) {
+            auto const neutral = n.IsSubtraction() ? 0.0 : 1.0;
+            // a - a = 0, a / a = 1
+            if (n.Arity == 2 && StrictHash(args[0]) == StrictHash(args[1])) {
+                return { Node::Constant(neutral) };
+            }
+            // drop the neutral element from all but the first argument
+            std::vector<Nodes> rest;
+            rest.push_back(std::move(args.front()));
+            std::copy_if(std::make_move_iterator(args.begin() + 1), std::make_move_iterator(args.end()), std::back_inserter(rest), [&](auto const& a) {
+                return !IsConstant(a, neutral);
+            });
+            if (rest.size() == 1) { return std::move(rest.front()); }
+            return Assemble(n, rest);
+        }
+
+        // square(sqrt(x)) = x (for the domain of sqrt)
+        if (n.IsSquare() && args.front().back().IsSquareRoot()) {
+            auto& a = args.front();
+            a.pop_back();
+            return std::move(a);
+        }
+
+        return Assemble(n, args);
+    }
+} // namespace
+
+// algebraic simplification:
+// - constant subtrees are folded into a single constant (when the result is finite)
+// - nested additions and multiplications are flattened, their constant arguments are merged and the neutral
+//   elements (x + 0, x * 1) are dropped
+// - subtractions and divisions of identical subtrees (as identified by their strict hash) become constants
+// - square(sqrt(x)) is replaced by x
+// coefficients are only folded when all the arguments of a function are constants, so the optimizable
+// parameters of the tree are preserved up to merging (e.g. the weights of variables are never folded)
+auto Tree::Simplify() -> Tree&
+{
+    if (nodes_.size() < 2) { return *this; }
+    nodes_ = SimplifyBranch(nodes_, nodes_.size() - 1);
+    return UpdateNodes();
+}
+
+} // namespace Operon
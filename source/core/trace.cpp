@@ -0,0 +1,121 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <algorithm>
+#include <fmt/format.h>
+#include <fstream>
+#include <ostream>
+#include <stdexcept>
+
+#include "operon/core/contracts.hpp"
+#include "operon/core/trace.hpp"
+
+namespace Operon {
+namespace {
+    // the task names are chosen by the library, but the user can name tasks too
+    auto Escape(std::string const& str) -> std::string
+    {
+        std::string out;
+        out.reserve(str.size());
+        for (auto c : str) {
+            if (c == '"' || c == '\\') {
+                out.push_back('\\');
+                out.push_back(c);
+            } else if (static_cast<unsigned char>(c) < 0x20) { // NOLINT
+                out += fmt::format("\\u{:04x}", static_cast<int>(c));
+            } else {
+                out.push_back(c);
+            }
+        }
+        return out;
+    }
+
+    constexpr double Microseconds = 1e3; // the trace format uses microseconds
+} // namespace
+
+auto TraceObserver::set_up(size_t workers) -> void
+{
+    origin_ = clock::now();
+    lanes_ = std::vector<Lane>(workers);
+    names_ = { "task" };
+    label_ = 0;
+}
+
+auto TraceObserver::Now() const -> uint64_t
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - origin_).count());
+}
+
+auto TraceObserver::Intern(std::string const& name) -> uint32_t
+{
+    std::lock_guard lock(lock_);
+    auto it = std::find(names_.begin(), names_.end(), name);
+    if (it == names_.end()) {
+        names_.push_back(name);
+        it = names_.end() - 1;
+    }
+    return static_cast<uint32_t>(std::distance(names_.begin(), it));
+}
+
+auto TraceObserver::on_entry(tf::WorkerView wv, tf::TaskView tv) -> void
+{
+    auto const& name = tv.name();
+    uint32_t index{0};
+    if (name.empty()) {
+        index = label_.load(std::memory_order_relaxed);
+    } else {
+        index = Intern(name);
+        label_.store(index, std::memory_order_relaxed);
+    }
+    auto& lane = lanes_[wv.id()];
+    lane.Open.push_back(lane.Events.size());
+    lane.Events.push_back({ index, Now(), 0, static_cast<uint32_t>(lane.Open.size() - 1) });
+}
+
+auto TraceObserver::on_exit(tf::WorkerView wv, tf::TaskView /*unused*/) -> void
+{
+    auto& lane = lanes_[wv.id()];
+    ENSURE(!lane.Open.empty());
+    lane.Events[lane.Open.back()].End = Now();
+    lane.Open.pop_back();
+}
+
+auto TraceObserver::Events(size_t worker) const -> std::vector<Event> const&
+{
+    EXPECT(worker < lanes_.size());
+    return lanes_[worker].Events;
+}
+
+auto TraceObserver::Clear() -> void
+{
+    for (auto& lane : lanes_) {
+        lane.Events.clear();
+        lane.Open.clear();
+    }
+}
+
+auto TraceObserver::Dump(std::ostream& os) const -> void
+{
+    std::vector<std::string> names(names_.size());
+    std::transform(names_.begin(), names_.end(), names.begin(), Escape);
+
+    os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    os << R"({"name":"process_name","ph":"M","pid":0,"tid":0,"args":{"name":"operon"}})";
+    for (size_t w = 0; w < lanes_.size(); ++w) {
+        os << fmt::format(",\n{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":{0},\"args\":{{\"name\":\"worker {0}\"}}}}", w);
+        for (auto const& e : lanes_[w].Events) {
+            if (e.End < e.Begin) { continue; } // still running
+            os << fmt::format(",\n{{\"name\":\"{}\",\"cat\":\"task\",\"ph\":\"X\",\"pid\":0,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}",
+                names[e.Name], w, static_cast<double>(e.Begin) / Microseconds, static_cast<double>(e.End - e.Begin) / Microseconds);
+        }
+    }
+    os << "\n]}\n";
+}
+
+auto TraceObserver::Dump(std::string const& path) const -> void
+{
+    std::ofstream f(path);
+    if (!f) { throw std::runtime_error(fmt::format("{}: cannot open file\n", path)); }
+    Dump(f);
+}
+} // namespace Operon
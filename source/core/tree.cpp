@@ -2,12 +2,82 @@
 // SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
 
 #include <algorithm>
+#include <array>
+#include <cstring>
 #include <numeric>
 
 #include "operon/core/tree.hpp"
 #include "operon/hash/hash.hpp"
 
 namespace Operon {
+
+namespace {
+    // children of nodes up to this arity are hashed using stack buffers
+    constexpr size_t SmallArity = 16;
+
+    // computes the hash value of node i from the hash values of its children (which must be up to date)
+    void HashNode(Operon::Span<Node const> nodes, size_t i, Operon::HashMode mode)
+    {
+        auto const& n = nodes[i];
+        Operon::Hasher hasher;
+
+        if (n.IsLeaf()) {
+            n.CalculatedHashValue = n.HashValue;
+            if (mode == Operon::HashMode::Strict) {
+                const size_t s1 = sizeof(Operon::Hash);
+                const size_t s2 = sizeof(Operon::Scalar);
+                std::array<uint8_t, s1 + s2> key {};
+                auto* ptr = key.data();
+                std::memcpy(ptr, &n.HashValue, s1);
+                std::memcpy(ptr + s1, &n.Value, s2);
+                n.CalculatedHashValue = hasher(key.data(), key.size());
+            }
+            return;
+        }
+
+        std::array<size_t, SmallArity> smallIndices; // NOLINT
+        std::array<Operon::Hash, SmallArity + 1> smallHashes; // NOLINT
+        auto* indices = smallIndices.data();
+        auto* hashes = smallHashes.data();
+
+        thread_local std::vector<size_t> largeIndices;
+        thread_local std::vector<Operon::Hash> largeHashes;
+        if (n.Arity > SmallArity) {
+            largeIndices.resize(n.Arity);
+            largeHashes.resize(n.Arity + 1UL);
+            indices = largeIndices.data();
+            hashes = largeHashes.data();
+        }
+
+        for (size_t k = 0, j = i - 1; k < n.Arity; ++k, j -= nodes[j].Length + 1) {
+            indices[k] = j;
+        }
+
+        if (n.IsCommutative()) {
+            auto less = [&](auto a, auto b) { return nodes[a] < nodes[b]; };
+            if (n.Arity > SmallArity) {
+                std::stable_sort(indices, indices + n.Arity, less);
+            } else {
+                // insertion sort (stable, no allocation)
+                for (size_t k = 1; k < n.Arity; ++k) {
+                    auto v = indices[k];
+                    auto l = k;
+                    for (; l > 0 && less(v, indices[l - 1]); --l) {
+                        indices[l] = indices[l - 1];
+                    }
+                    indices[l] = v;
+                }
+            }
+        }
+
+        for (size_t k = 0; k < n.Arity; ++k) {
+            hashes[k] = nodes[indices[k]].CalculatedHashValue;
+        }
+        hashes[n.Arity] = n.HashValue;
+        n.CalculatedHashValue = hasher(reinterpret_cast<uint8_t const*>(hashes), sizeof(Operon::Hash) * (n.Arity + 1UL)); // NOLINT
+    }
+} // namespace
+
 auto Tree::UpdateNodes() -> Tree&
 {
     for (size_t i = 0; i < nodes_.size(); ++i) {
@@ -37,6 +107,58 @@ auto Tree::UpdateNodes() -> Tree&
     return *this;
 }
 
+auto Tree::UpdateNodes(size_t start, size_t oldLength, size_t newLength) -> Tree&
+{
+    EXPECT(oldLength > 0);
+    EXPECT(start + newLength <= nodes_.size());
+    if (start + newLength == nodes_.size()) {
+        return UpdateNodes(); // the root was replaced
+    }
+
+    using Signed = std::make_signed_t<size_t>;
+    auto const delta = static_cast<Signed>(newLength) - static_cast<Signed>(oldLength);
+    auto const end = start + newLength; // first node after the inserted block
+    auto const root = nodes_.size() - 1;
+    auto shift = [delta](uint16_t& index) { index = static_cast<uint16_t>(static_cast<Signed>(index) + delta); };
+
+    // nodes before the block: the parents which come after the block have moved
+    for (size_t i = 0; i < start; ++i) {
+        if (nodes_[i].Parent >= start) { shift(nodes_[i].Parent); }
+    }
+
+    // nodes after the block: all the parents have moved, the ancestors of the block have changed length and depth
+    auto parent = root; // parent of the inserted block
+    bool found{false};
+    for (auto i = end; i < nodes_.size(); ++i) {
+        auto& s = nodes_[i];
+        if (i != root) { shift(s.Parent); }
+        // the (not yet updated) subtree of this node spanned the replaced block
+        if (static_cast<Signed>(i) - delta - s.Length > static_cast<Signed>(start)) { continue; }
+        if (!found) { parent = i; found = true; }
+        s.Length = static_cast<uint16_t>(static_cast<Signed>(s.Length) + delta);
+        s.Depth = 1;
+        for (size_t k = 0, j = i - 1; k < s.Arity; ++k, j -= nodes_[j].Length + 1) {
+            s.Depth = std::max(s.Depth, nodes_[j].Depth);
+        }
+        ++s.Depth;
+    }
+
+    // the inserted block: parent indices and levels
+    if (newLength > 0) {
+        nodes_[end - 1].Parent = static_cast<uint16_t>(parent);
+        for (auto i = start; i < end; ++i) {
+            auto const& s = nodes_[i];
+            for (size_t k = 0, j = i - 1; k < s.Arity; ++k, j -= nodes_[j].Length + 1) {
+                nodes_[j].Parent = static_cast<uint16_t>(i);
+            }
+        }
+        for (auto i = end; i-- > start;) {
+            nodes_[i].Level = static_cast<uint16_t>(nodes_[nodes_[i].Parent].Level + 1);
+        }
+    }
+    return *this;
+}
+
 auto Tree::Reduce() -> Tree&
 {
     bool reduced = false;
@@ -126,12 +248,18 @@ auto Tree::ChildIndices(size_t i) const -> std::vector<size_t>
 auto Tree::GetCoefficients() const -> std::vector<Operon::Scalar>
 {
     std::vector<Operon::Scalar> coefficients;
+    GetCoefficients(coefficients);
+    return coefficients;
+}
+
+void Tree::GetCoefficients(std::vector<Operon::Scalar>& coefficients) const
+{
+    coefficients.clear();
     for (auto const& s : nodes_) {
         if (s.IsLeaf()) {
             coefficients.push_back(s.Value);
         }
     }
-    return coefficients;
 }
 
 void Tree::SetCoefficients(Operon::Span<Operon::Scalar const> coefficients)
@@ -156,50 +284,40 @@ auto Tree::VisitationLength() const noexcept -> size_t
 
 auto Tree::Hash(Operon::HashMode mode) const -> Tree const&
 {
-    std::vector<size_t> childIndices;
-    childIndices.reserve(nodes_.size());
-
-    std::vector<Operon::Hash> hashes;
-    hashes.reserve(nodes_.size());
-
-    Operon::Hasher hasher;
-
     for (size_t i = 0; i < nodes_.size(); ++i) {
-        auto const& n = nodes_[i];
-
-        if (n.IsLeaf()) {
-            n.CalculatedHashValue = n.HashValue;
-            if (mode == Operon::HashMode::Strict) {
-                const size_t s1 = sizeof(Operon::Hash);
-                const size_t s2 = sizeof(Operon::Scalar);
-                std::array<uint8_t, s1 + s2> key {};
-                auto* ptr = key.data();
-                std::memcpy(ptr, &n.HashValue, s1);
-                std::memcpy(ptr + s1, &n.Value, s2);
-                n.CalculatedHashValue = hasher(key.data(), key.size());
-            }
-            continue;
-        }
+        HashNode(nodes_, i, mode);
+    }
+    return *this;
+}
 
-        for (auto it = Children(i); it.HasNext(); ++it) {
-            childIndices.push_back(it.Index());
-        }
+auto Tree::ComputeHash(Operon::HashMode mode) const -> Operon::Hash
+{
+    if (nodes_.empty()) { return 0; }
+    thread_local std::vector<Operon::Hash> saved;
+    saved.resize(nodes_.size());
+    std::transform(nodes_.begin(), nodes_.end(), saved.begin(), [](auto const& n) { return n.CalculatedHashValue; });
+    auto const hash = Hash(mode).HashValue();
+    for (size_t i = 0; i < nodes_.size(); ++i) { nodes_[i].CalculatedHashValue = saved[i]; }
+    return hash;
+}
 
-        auto begin = childIndices.begin();
-        auto end = begin + n.Arity;
+auto TreeView::Hash(Operon::HashMode mode) const -> TreeView const&
+{
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+        HashNode(nodes_, i, mode);
+    }
+    return *this;
+}
 
-        if (n.IsCommutative()) {
-            std::stable_sort(begin, end, [&](auto a, auto b) { return nodes_[a] < nodes_[b]; });
+auto TreeView::GetCoefficients() const -> std::vector<Operon::Scalar>
+{
+    std::vector<Operon::Scalar> coefficients;
+    for (auto const& s : nodes_) {
+        if (s.IsLeaf()) {
+            coefficients.push_back(s.Value);
         }
-        std::transform(begin, end, std::back_inserter(hashes), [&](auto j) { return nodes_[j].CalculatedHashValue; });
-        hashes.push_back(n.HashValue);
-
-        n.CalculatedHashValue = hasher(reinterpret_cast<uint8_t*>(hashes.data()), sizeof(Operon::Hash) * hashes.size()); // NOLINT
-        childIndices.clear();
-        hashes.clear();
     }
-
-    return *this;
+    return coefficients;
 }
 
 } // namespace Operon
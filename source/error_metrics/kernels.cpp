@@ -0,0 +1,196 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include "operon/error_metrics/kernels.hpp"
+#include "operon/core/contracts.hpp"
+#include "operon/core/simd.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <type_traits>
+
+namespace Operon::Kernels {
+    namespace {
+        constexpr int Lanes = 4;
+        using Vec4d = Simd::Vec<double, Lanes>;
+
+        // Kahan summation in every lane: c holds the low order bits lost by the previous additions
+        struct Accumulator {
+            Vec4d Sum{};
+            Vec4d C{};
+
+            auto Add(Vec4d const& v) -> void
+            {
+                auto const y = v - C;
+                auto const t = Sum + y;
+                C = (t - Sum) - y;
+                Sum = t;
+            }
+
+            [[nodiscard]] auto Total() const -> double { return Simd::ReduceAdd(Sum) - Simd::ReduceAdd(C); }
+        };
+
+        // loads count <= Lanes values widened to double, the lanes past count are zero
+        template<typename T>
+        inline auto Load(T const* p, int count) -> Vec4d
+        {
+            using V = Simd::Vec<T, Lanes>;
+            auto const v = count == Lanes ? V::Load(p) : V::LoadPartial(p, static_cast<size_t>(count));
+            if constexpr (std::is_same_v<T, float>) {
+                return Simd::Convert<double>(v);
+            } else {
+                return v;
+            }
+        }
+
+        // the compensated sums of the N terms returned by f(offset, count) over n rows: two independent sets of
+        // accumulators keep the (serial) dependency chains of the compensation from limiting the throughput
+        template<size_t N, typename F>
+        inline auto Reduce(size_t n, F&& f) -> std::array<double, N>
+        {
+            std::array<Accumulator, N> a{};
+            std::array<Accumulator, N> b{};
+            size_t i = 0;
+            for (; i + 2 * Lanes <= n; i += 2 * Lanes) {
+                auto const u = f(i, Lanes);
+                auto const v = f(i + Lanes, Lanes);
+                for (size_t k = 0; k < N; ++k) {
+                    a[k].Add(u[k]);
+                    b[k].Add(v[k]);
+                }
+            }
+            for (; i < n; i += Lanes) {
+                auto const count = static_cast<int>(std::min(n - i, size_t{Lanes}));
+                auto u = f(i, count);
+                for (size_t k = 0; k < N; ++k) { a[k].Add(Simd::Cutoff(u[k], static_cast<size_t>(count))); }
+            }
+            std::array<double, N> sums{};
+            for (size_t k = 0; k < N; ++k) { sums[k] = a[k].Total() + b[k].Total(); }
+            return sums;
+        }
+
+        // the rows gathered ahead of the current ones
+        constexpr size_t PrefetchDistance = 16;
+
+        // the second operand of the reductions: contiguous values or values gathered from a column by row index
+        template<typename T>
+        struct Contiguous {
+            Operon::Span<T const> Values;
+
+            [[nodiscard]] auto Size() const -> size_t { return Values.size(); }
+            [[nodiscard]] auto operator()(size_t i, int count) const -> Vec4d { return Load(Values.data() + i, count); }
+        };
+
+        template<typename T>
+        struct Gathered {
+            T const* Column;
+            Operon::Span<uint32_t const> Rows;
+
+            [[nodiscard]] auto Size() const -> size_t { return Rows.size(); }
+            [[nodiscard]] auto operator()(size_t i, int count) const -> Vec4d
+            {
+                std::array<double, Lanes> values{};
+                for (size_t k = 0; k < static_cast<size_t>(count); ++k) {
+                    if (i + k + PrefetchDistance < Rows.size()) { OPERON_PREFETCH(Column + Rows[i + k + PrefetchDistance]); }
+                    values[k] = static_cast<double>(Column[Rows[i + k]]);
+                }
+                return Vec4d::Load(values.data());
+            }
+        };
+
+        template<typename T, typename Y>
+        auto SumOfSquaredErrorsImpl(Operon::Span<T const> x, Y const& y) noexcept -> double
+        {
+            EXPECT(x.size() == y.Size());
+            return Reduce<1>(x.size(), [&](size_t i, int count) {
+                auto const e = Load(x.data() + i, count) - y(i, count);
+                return std::array<Vec4d, 1>{ e * e };
+            })[0];
+        }
+
+        template<typename T, typename Y>
+        auto SumOfAbsoluteErrorsImpl(Operon::Span<T const> x, Y const& y) noexcept -> double
+        {
+            EXPECT(x.size() == y.Size());
+            return Reduce<1>(x.size(), [&](size_t i, int count) {
+                return std::array<Vec4d, 1>{ Simd::Abs(Load(x.data() + i, count) - y(i, count)) };
+            })[0];
+        }
+
+        template<typename T>
+        auto MeanImpl(Operon::Span<T const> x) noexcept -> double
+        {
+            EXPECT(!x.empty());
+            auto const sum = Reduce<1>(x.size(), [&](size_t i, int count) { return std::array<Vec4d, 1>{ Load(x.data() + i, count) }; })[0];
+            return sum / static_cast<double>(x.size());
+        }
+
+        template<typename T>
+        auto VarianceImpl(Operon::Span<T const> x) noexcept -> double
+        {
+            auto const mean = MeanImpl(x);
+            auto const sum = Reduce<1>(x.size(), [&](size_t i, int count) {
+                auto const d = Load(x.data() + i, count) - mean;
+                return std::array<Vec4d, 1>{ d * d };
+            })[0];
+            return sum / static_cast<double>(x.size());
+        }
+
+        template<typename T, typename Y>
+        auto MomentsImpl(Operon::Span<T const> x, Y const& y) noexcept -> BivariateMoments
+        {
+            EXPECT(x.size() == y.Size());
+            EXPECT(!x.empty());
+            auto const n = static_cast<double>(x.size());
+            auto const [sx, sy] = Reduce<2>(x.size(), [&](size_t i, int count) {
+                return std::array<Vec4d, 2>{ Load(x.data() + i, count), y(i, count) };
+            });
+            auto const mx = sx / n;
+            auto const my = sy / n;
+            auto const [sxx, syy, sxy] = Reduce<3>(x.size(), [&](size_t i, int count) {
+                auto const dx = Load(x.data() + i, count) - mx;
+                auto const dy = y(i, count) - my;
+                return std::array<Vec4d, 3>{ dx * dx, dy * dy, dx * dy };
+            });
+            return { mx, my, sxx / n, syy / n, sxy / n };
+        }
+
+        template<typename T>
+        auto GatherImpl(Operon::Span<T const> column, Operon::Span<uint32_t const> rows, Operon::Span<T> out) noexcept -> void
+        {
+            EXPECT(out.size() >= rows.size());
+            for (size_t i = 0; i < rows.size(); ++i) {
+                if (i + PrefetchDistance < rows.size()) { OPERON_PREFETCH(column.data() + rows[i + PrefetchDistance]); }
+                out[i] = column[rows[i]];
+            }
+        }
+    } // namespace
+
+    auto SumOfSquaredErrors(Operon::Span<float const> x, Operon::Span<float const> y) noexcept -> double { return SumOfSquaredErrorsImpl(x, Contiguous<float>{y}); }
+    auto SumOfSquaredErrors(Operon::Span<double const> x, Operon::Span<double const> y) noexcept -> double { return SumOfSquaredErrorsImpl(x, Contiguous<double>{y}); }
+
+    auto SumOfAbsoluteErrors(Operon::Span<float const> x, Operon::Span<float const> y) noexcept -> double { return SumOfAbsoluteErrorsImpl(x, Contiguous<float>{y}); }
+    auto SumOfAbsoluteErrors(Operon::Span<double const> x, Operon::Span<double const> y) noexcept -> double { return SumOfAbsoluteErrorsImpl(x, Contiguous<double>{y}); }
+
+    auto Mean(Operon::Span<float const> x) noexcept -> double { return MeanImpl(x); }
+    auto Mean(Operon::Span<double const> x) noexcept -> double { return MeanImpl(x); }
+
+    auto Variance(Operon::Span<float const> x) noexcept -> double { return VarianceImpl(x); }
+    auto Variance(Operon::Span<double const> x) noexcept -> double { return VarianceImpl(x); }
+
+    auto Moments(Operon::Span<float const> x, Operon::Span<float const> y) noexcept -> BivariateMoments { return MomentsImpl(x, Contiguous<float>{y}); }
+    auto Moments(Operon::Span<double const> x, Operon::Span<double const> y) noexcept -> BivariateMoments { return MomentsImpl(x, Contiguous<double>{y}); }
+
+    auto SumOfSquaredErrors(Operon::Span<float const> x, Operon::Span<float const> column, Operon::Span<uint32_t const> rows) noexcept -> double { return SumOfSquaredErrorsImpl(x, Gathered<float>{column.data(), rows}); }
+    auto SumOfSquaredErrors(Operon::Span<double const> x, Operon::Span<double const> column, Operon::Span<uint32_t const> rows) noexcept -> double { return SumOfSquaredErrorsImpl(x, Gathered<double>{column.data(), rows}); }
+
+    auto SumOfAbsoluteErrors(Operon::Span<float const> x, Operon::Span<float const> column, Operon::Span<uint32_t const> rows) noexcept -> double { return SumOfAbsoluteErrorsImpl(x, Gathered<float>{column.data(), rows}); }
+    auto SumOfAbsoluteErrors(Operon::Span<double const> x, Operon::Span<double const> column, Operon::Span<uint32_t const> rows) noexcept -> double { return SumOfAbsoluteErrorsImpl(x, Gathered<double>{column.data(), rows}); }
+
+    auto Moments(Operon::Span<float const> x, Operon::Span<float const> column, Operon::Span<uint32_t const> rows) noexcept -> BivariateMoments { return MomentsImpl(x, Gathered<float>{column.data(), rows}); }
+    auto Moments(Operon::Span<double const> x, Operon::Span<double const> column, Operon::Span<uint32_t const> rows) noexcept -> BivariateMoments { return MomentsImpl(x, Gathered<double>{column.data(), rows}); }
+
+    auto Gather(Operon::Span<float const> column, Operon::Span<uint32_t const> rows, Operon::Span<float> out) noexcept -> void { GatherImpl(column, rows, out); }
+    auto Gather(Operon::Span<double const> column, Operon::Span<uint32_t const> rows, Operon::Span<double> out) noexcept -> void { GatherImpl(column, rows, out); }
+} // namespace Operon::Kernels
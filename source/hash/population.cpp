@@ -0,0 +1,44 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include "operon/hash/population.hpp"
+#include "operon/core/executor.hpp"
+#include <algorithm>
+#include <numeric>
+#include <taskflow/taskflow.hpp>
+
+namespace Operon {
+    auto HashPopulation(tf::Executor& executor, Operon::Span<Tree const> trees, Operon::HashMode mode) -> void
+    {
+        if (trees.empty()) { return; }
+
+        // chunk boundaries such that every chunk holds about the same number of nodes
+        auto const total = std::transform_reduce(trees.begin(), trees.end(), size_t{0}, std::plus<>{}, [](auto const& t) { return t.Length(); });
+        auto const chunks = std::min(trees.size(), executor.num_workers() * 4UL);
+        auto const target = std::max(size_t{1}, total / chunks);
+
+        std::vector<size_t> bounds{0};
+        size_t length{0};
+        for (size_t i = 0; i < trees.size(); ++i) {
+            length += trees[i].Length();
+            if (length >= target) {
+                bounds.push_back(i + 1);
+                length = 0;
+            }
+        }
+        if (bounds.back() != trees.size()) { bounds.push_back(trees.size()); }
+
+        tf::Taskflow taskflow;
+        taskflow.for_each_index(size_t{0}, bounds.size() - 1, size_t{1}, [&](size_t c) {
+            for (auto i = bounds[c]; i < bounds[c + 1]; ++i) {
+                [[maybe_unused]] auto const& t = trees[i].Hash(mode);
+            }
+        });
+        executor.run(taskflow).wait();
+    }
+
+    auto HashPopulation(Operon::Span<Tree const> trees, Operon::HashMode mode, size_t threads) -> void
+    {
+        HashPopulation(SharedExecutor(threads), trees, mode);
+    }
+} // namespace Operon
@@ -0,0 +1,34 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <taskflow/taskflow.hpp>
+
+#include "operon/interpreter/interpreter.hpp"
+
+namespace Operon {
+auto EvaluateParallel(tf::Executor& executor, Interpreter const& interpreter, Tree const& tree, Dataset const& dataset, Range const range, Operon::Span<Operon::Scalar> result, size_t batchSize) -> void
+{
+    EXPECT(result.size() >= range.Size());
+    EXPECT(batchSize > 0);
+
+    // compile once and share the program between workers (each worker uses its own thread-local buffers)
+    auto const program = interpreter.Compile<Operon::Scalar>(tree, dataset);
+    Interpreter::Accelerate(program, range.Size());
+    auto const n = (range.Size() + batchSize - 1) / batchSize;
+
+    tf::Taskflow taskflow;
+    taskflow.for_each_index(size_t{0}, n, size_t{1}, [&](size_t i) {
+        auto start = range.Start() + i * batchSize;
+        auto end = std::min(start + batchSize, range.End());
+        interpreter.Evaluate<Operon::Scalar>(program, Range { start, end }, result.subspan(i * batchSize, end - start));
+    });
+    executor.run(taskflow).wait();
+}
+
+auto EvaluateParallel(tf::Executor& executor, Interpreter const& interpreter, Tree const& tree, Dataset const& dataset, Range const range, size_t batchSize) -> Operon::Vector<Operon::Scalar>
+{
+    Operon::Vector<Operon::Scalar> result(range.Size());
+    EvaluateParallel(executor, interpreter, tree, dataset, range, Operon::Span<Operon::Scalar>(result), batchSize);
+    return result;
+}
+} // namespace Operon
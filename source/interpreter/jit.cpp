@@ -0,0 +1,204 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <atomic>
+
+#include "operon/interpreter/jit.hpp"
+
+#if defined(OPERON_JIT)
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fmt/format.h>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <robin_hood.h>
+#include <stdexcept>
+#include <vector>
+
+#include <dlfcn.h>
+#include <unistd.h>
+
+#include "operon/core/format.hpp"
+#include "operon/core/tree.hpp"
+#include "operon/hash/hash.hpp"
+#endif
+
+namespace Operon::Jit {
+    namespace {
+        std::atomic_bool enabled{true};
+        std::atomic_size_t threshold{DefaultThreshold};
+        std::atomic_size_t capacity{DefaultCapacity};
+
+#if defined(OPERON_JIT)
+        constexpr char const* Symbol = "operon_kernel";
+
+        // the structure of a tree: the values, variables and hashes are arguments of the kernel
+        auto Signature(Operon::Span<Node const> nodes) -> std::vector<uint32_t>
+        {
+            std::vector<uint32_t> signature;
+            signature.reserve(nodes.size());
+            for (auto const& n : nodes) {
+                signature.push_back(static_cast<uint32_t>(n.Type) << 16U | n.Arity); // NOLINT
+            }
+            return signature;
+        }
+
+        struct Entry {
+            std::vector<uint32_t> Signature;
+            Kernel Function; // nullptr if the compilation failed
+        };
+
+        std::mutex lock;        // the cache
+        std::mutex compileLock; // one compilation at a time, so that a structure is only compiled once
+        robin_hood::unordered_flat_map<uint64_t, std::vector<Entry>> kernels; // NOLINT
+        size_t entries{0};
+        std::atomic_size_t compilations{0};
+        std::atomic_size_t failures{0};
+        std::atomic_uint64_t nanoseconds{0};
+
+        auto Find(uint64_t key, std::vector<uint32_t> const& signature) -> Entry const*
+        {
+            auto it = kernels.find(key);
+            if (it == kernels.end()) { return nullptr; }
+            for (auto const& e : it->second) {
+                if (e.Signature == signature) { return &e; }
+            }
+            return nullptr;
+        }
+
+        // a private directory for the sources and libraries of the process (created by mkdtemp, so that concurrent
+        // processes never share a file name), removed at exit
+        struct Directory {
+            std::filesystem::path Path;
+
+            Directory()
+            {
+                std::error_code ec;
+                auto pattern = (std::filesystem::temp_directory_path(ec) / "operon-jit-XXXXXX").string();
+                if (!ec && ::mkdtemp(pattern.data()) != nullptr) { Path = pattern; }
+            }
+            Directory(Directory const&) = delete;
+            Directory(Directory&&) = delete;
+            auto operator=(Directory const&) -> Directory& = delete;
+            auto operator=(Directory&&) -> Directory& = delete;
+
+            ~Directory()
+            {
+                std::error_code ec;
+                if (!Path.empty()) { std::filesystem::remove_all(Path, ec); }
+            }
+        };
+
+        // called with the compile lock held
+        auto Compile(Operon::Span<Node const> nodes) -> Kernel
+        {
+            static Directory const directory;
+            static size_t counter{0};
+            if (directory.Path.empty()) { return nullptr; }
+
+            auto const code = CodeFormatter::FormatKernel(TreeView(nodes), Symbol);
+            namespace fs = std::filesystem;
+            std::error_code ec;
+            auto const id = counter++;
+            auto const source = directory.Path / fmt::format("kernel{}.c", id);
+            auto const library = directory.Path / fmt::format("kernel{}.so", id);
+            if (!(std::ofstream(source) << code)) { fs::remove(source, ec); return nullptr; }
+
+            // no -ffast-math: the kernels must agree with the interpreter on nan and inf
+            auto const* cc = std::getenv("OPERON_JIT_CC"); // NOLINT
+            auto const command = fmt::format("{} -O3 -march=native -fno-math-errno -fPIC -shared -o \"{}\" \"{}\" -lm > /dev/null 2>&1", cc != nullptr ? cc : "cc", library.string(), source.string());
+            auto const status = std::system(command.c_str()); // NOLINT
+            fs::remove(source, ec);
+            if (status != 0) { return nullptr; }
+
+            // the library stays loaded for the lifetime of the process, the file is not needed anymore
+            void* handle = ::dlopen(library.c_str(), RTLD_NOW | RTLD_LOCAL);
+            fs::remove(library, ec);
+            if (handle == nullptr) { return nullptr; }
+            return reinterpret_cast<Kernel>(::dlsym(handle, Symbol)); // NOLINT
+        }
+#endif
+    } // namespace
+
+    auto Available() -> bool
+    {
+#if defined(OPERON_JIT)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    auto Enabled() -> bool { return Available() && enabled.load(std::memory_order_relaxed); }
+    auto SetEnabled(bool value) -> void { enabled.store(value, std::memory_order_relaxed); }
+
+    auto Threshold() -> size_t { return threshold.load(std::memory_order_relaxed); }
+    auto SetThreshold(size_t value) -> void { threshold.store(value, std::memory_order_relaxed); }
+
+    auto Capacity() -> size_t { return capacity.load(std::memory_order_relaxed); }
+    auto SetCapacity(size_t value) -> void { capacity.store(value, std::memory_order_relaxed); }
+
+    auto Worthwhile(size_t work) -> bool { return Enabled() && work >= Threshold(); }
+
+    auto Get([[maybe_unused]] Operon::Span<Node const> nodes) noexcept -> Kernel
+    {
+#if defined(OPERON_JIT)
+        if (!Enabled() || nodes.empty()) { return nullptr; }
+        try {
+            auto signature = Signature(nodes);
+            auto const key = Operon::Hasher{}(reinterpret_cast<uint8_t const*>(signature.data()), signature.size() * sizeof(uint32_t)); // NOLINT
+            auto lookup = [&]() -> std::optional<Kernel> {
+                std::scoped_lock guard(lock);
+                if (auto const* e = Find(key, signature); e != nullptr) { return e->Function; }
+                if (entries >= Capacity()) { return Kernel{nullptr}; } // full, the loaded kernels cannot be evicted
+                return std::nullopt;
+            };
+            if (auto kernel = lookup(); kernel) { return *kernel; }
+
+            // the threads requesting the structure meanwhile wait here and find its kernel
+            std::scoped_lock build(compileLock);
+            if (auto kernel = lookup(); kernel) { return *kernel; }
+
+            auto const start = std::chrono::steady_clock::now();
+            Kernel function{nullptr};
+            try {
+                function = Compile(nodes);
+            } catch (std::exception const&) {
+                function = nullptr; // e.g. a node the formatter does not support
+            }
+            auto const elapsed = std::chrono::steady_clock::now() - start;
+            compilations.fetch_add(1, std::memory_order_relaxed);
+            nanoseconds.fetch_add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()), std::memory_order_relaxed);
+            if (function == nullptr) { failures.fetch_add(1, std::memory_order_relaxed); }
+
+            std::scoped_lock guard(lock);
+            kernels[key].push_back({ std::move(signature), function });
+            ++entries;
+            return function;
+        } catch (std::exception const&) {
+            return nullptr; // out of memory, the interpreter takes over
+        }
+#else
+        return nullptr;
+#endif
+    }
+
+    auto GetStatistics() -> Statistics
+    {
+        Statistics stats;
+#if defined(OPERON_JIT)
+        {
+            std::scoped_lock guard(lock);
+            for (auto const& [key, entries] : kernels) {
+                for (auto const& e : entries) { stats.Kernels += static_cast<size_t>(e.Function != nullptr); }
+            }
+        }
+        stats.Compilations = compilations.load(std::memory_order_relaxed);
+        stats.Failures = failures.load(std::memory_order_relaxed);
+        stats.Seconds = static_cast<double>(nanoseconds.load(std::memory_order_relaxed)) / 1e9; // NOLINT
+#endif
+        return stats;
+    }
+} // namespace Operon::Jit
@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <fmt/format.h>
+#include <stdexcept>
+
+#include "operon/interpreter/plugin.hpp"
+#include "operon/hash/hash.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <dlfcn.h>
+#define OPERON_PLUGIN_DLOPEN
+#endif
+
+namespace Operon::Plugin {
+    auto HashName(std::string const& name) -> Operon::Hash
+    {
+        return Operon::Hasher{}(reinterpret_cast<uint8_t const*>(name.data()), name.size()); // NOLINT
+    }
+
+    auto Read(operon_plugin const& plugin) -> std::vector<Primitive>
+    {
+        if (plugin.abi_version != OPERON_PLUGIN_ABI_VERSION) {
+            throw std::runtime_error(fmt::format("plugin abi version {} (expected {})", plugin.abi_version, OPERON_PLUGIN_ABI_VERSION));
+        }
+        std::vector<Primitive> primitives;
+        primitives.reserve(plugin.count);
+        for (uint32_t i = 0; i < plugin.count; ++i) {
+            auto const& p = plugin.primitives[i]; // NOLINT
+            if (p.name == nullptr || p.scalar == nullptr) {
+                throw std::runtime_error(fmt::format("plugin primitive {} has no name or no scalar kernel", i));
+            }
+            if (p.min_arity > p.max_arity || p.max_arity > MaxArity) {
+                throw std::runtime_error(fmt::format("plugin primitive {} has an arity of {} to {} (at most {})", p.name, p.min_arity, p.max_arity, MaxArity));
+            }
+            std::string name{p.name};
+            auto const hash = HashName(name);
+            primitives.push_back({ std::move(name), hash, p.min_arity, p.max_arity, p.scalar, p.dual });
+        }
+        return primitives;
+    }
+
+    auto Load(std::string const& path) -> std::vector<Primitive>
+    {
+#if defined(OPERON_PLUGIN_DLOPEN)
+        void* handle = ::dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (handle == nullptr) {
+            throw std::runtime_error(fmt::format("cannot load the plugin {}: {}", path, ::dlerror()));
+        }
+        auto entry = reinterpret_cast<operon_plugin_entry>(::dlsym(handle, OPERON_PLUGIN_ENTRY)); // NOLINT
+        if (entry == nullptr) {
+            throw std::runtime_error(fmt::format("the plugin {} does not export {}", path, OPERON_PLUGIN_ENTRY));
+        }
+        auto const* plugin = entry();
+        if (plugin == nullptr) {
+            throw std::runtime_error(fmt::format("the plugin {} returned no descriptor", path));
+        }
+        return Read(*plugin);
+#else
+        throw std::runtime_error(fmt::format("cannot load the plugin {}: plugins are not supported on this platform", path));
+#endif
+    }
+} // namespace Operon::Plugin
@@ -0,0 +1,284 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include "operon/nnls/batch_optimizer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
+#include <Eigen/Cholesky>
+#include <taskflow/taskflow.hpp>
+
+namespace Operon {
+
+namespace {
+    using EigenVector = Eigen::Matrix<Operon::Scalar, -1, 1>;
+    using EigenMatrix = Eigen::Matrix<Operon::Scalar, -1, -1>;
+
+    struct State {
+        EigenVector X;    // current coefficients
+        EigenVector Step; // proposed step
+        double Cost{0}; // 0.5 * |r|^2 at X
+        Operon::Scalar Damping{0};
+        Operon::Scalar Nu{2};
+        size_t Offset{0}; // offset of the normal equations in the shared buffers
+        bool Active{false};
+        bool Stale{true}; // the normal equations must be (re)assembled at X
+        OptimizerSummary Summary{};
+    };
+
+    // up to BatchOptimizerOptions::SolveWidth trees with the same number of coefficients, solved together
+    struct Chunk {
+        size_t K;
+        size_t First; // in the order of the trees by their number of coefficients
+        size_t Count;
+    };
+
+    struct Batch {
+        std::vector<ResidualEvaluator> Evaluators;
+        std::vector<State> States;
+        std::vector<size_t> MatrixOffsets;
+        Operon::Vector<Operon::Scalar> Normal;   // the k x k matrices J^T J
+        Operon::Vector<Operon::Scalar> Gradient; // the k-vectors J^T r
+        std::vector<size_t> Order; // the trees with coefficients, by their number of coefficients
+        std::vector<Chunk> Chunks;
+    };
+
+    auto Residuals(ResidualEvaluator const& re, Operon::Scalar const* x, size_t rows) -> double
+    {
+        thread_local Operon::Vector<Operon::Scalar> residuals;
+        residuals.resize(rows);
+        re(x, residuals.data());
+        Eigen::Map<EigenVector const> map(residuals.data(), static_cast<Eigen::Index>(rows));
+        return 0.5 * map.template cast<double>().squaredNorm(); // NOLINT
+    }
+
+    auto Damped(State const& s, Operon::Scalar const* normal) -> EigenMatrix
+    {
+        auto const k = static_cast<Eigen::Index>(s.X.size());
+        EigenMatrix damped = Eigen::Map<EigenMatrix const>(normal, k, k);
+        damped.diagonal() += s.Damping * damped.diagonal().cwiseMax(Operon::Scalar{1e-6}); // Marquardt scaling
+        return damped;
+    }
+
+    // the damped systems of a chunk, interleaved: element (r, c) of lane t is at (r * k + c) * W + t, so the inner
+    // loops of the factorization and of the substitutions run over the trees and vectorize. the unused lanes hold the
+    // identity, a lane which is not positive definite falls back to the LDLT of its own system
+    auto SolveChunk(Batch& batch, Chunk const& chunk) -> void
+    {
+        constexpr size_t W = BatchOptimizerOptions::SolveWidth;
+        auto const k = chunk.K;
+        thread_local Operon::Vector<Operon::Scalar> l;
+        thread_local Operon::Vector<Operon::Scalar> y;
+        l.assign(k * k * W, Operon::Scalar{0});
+        y.assign(k * W, Operon::Scalar{0});
+        auto at = [&](size_t r, size_t c) { return l.data() + (r * k + c) * W; };
+
+        std::array<bool, W> used{};
+        std::array<bool, W> ok{};
+        ok.fill(true);
+        for (size_t t = 0; t < W; ++t) {
+            used[t] = t < chunk.Count && batch.States[batch.Order[chunk.First + t]].Active;
+            if (!used[t]) {
+                for (size_t r = 0; r < k; ++r) { at(r, r)[t] = 1; }
+                continue;
+            }
+            auto const i = batch.Order[chunk.First + t];
+            auto const& s = batch.States[i];
+            auto const* a = batch.Normal.data() + batch.MatrixOffsets[i];
+            auto const* g = batch.Gradient.data() + s.Offset;
+            for (size_t c = 0; c < k; ++c) {
+                for (size_t r = 0; r < k; ++r) { at(r, c)[t] = a[c * k + r]; } // column-major
+                at(c, c)[t] += s.Damping * std::max(a[c * k + c], Operon::Scalar{1e-6});
+                y[c * W + t] = -g[c];
+            }
+        }
+
+        // cholesky factorization, the lower triangle in place
+        for (size_t j = 0; j < k; ++j) {
+            auto* ljj = at(j, j);
+            for (size_t p = 0; p < j; ++p) {
+                auto const* ljp = at(j, p);
+                for (size_t t = 0; t < W; ++t) { ljj[t] -= ljp[t] * ljp[t]; }
+            }
+            for (size_t t = 0; t < W; ++t) {
+                ok[t] = ok[t] && ljj[t] > 0 && std::isfinite(ljj[t]);
+                ljj[t] = ok[t] ? std::sqrt(ljj[t]) : Operon::Scalar{1};
+            }
+            for (size_t r = j + 1; r < k; ++r) {
+                auto* lrj = at(r, j);
+                for (size_t p = 0; p < j; ++p) {
+                    auto const* lrp = at(r, p);
+                    auto const* ljp = at(j, p);
+                    for (size_t t = 0; t < W; ++t) { lrj[t] -= lrp[t] * ljp[t]; }
+                }
+                for (size_t t = 0; t < W; ++t) { lrj[t] /= ljj[t]; }
+            }
+        }
+
+        // L z = -g, then L^T x = z
+        for (size_t r = 0; r < k; ++r) {
+            auto* yr = y.data() + r * W;
+            for (size_t p = 0; p < r; ++p) {
+                auto const* lrp = at(r, p);
+                auto const* yp = y.data() + p * W;
+                for (size_t t = 0; t < W; ++t) { yr[t] -= lrp[t] * yp[t]; }
+            }
+            auto const* lrr = at(r, r);
+            for (size_t t = 0; t < W; ++t) { yr[t] /= lrr[t]; }
+        }
+        for (size_t r = k; r-- > 0;) {
+            auto* yr = y.data() + r * W;
+            for (size_t p = r + 1; p < k; ++p) {
+                auto const* lpr = at(p, r);
+                auto const* yp = y.data() + p * W;
+                for (size_t t = 0; t < W; ++t) { yr[t] -= lpr[t] * yp[t]; }
+            }
+            auto const* lrr = at(r, r);
+            for (size_t t = 0; t < W; ++t) { yr[t] /= lrr[t]; }
+        }
+
+        for (size_t t = 0; t < chunk.Count; ++t) {
+            if (!used[t]) { continue; }
+            auto const i = batch.Order[chunk.First + t];
+            auto& s = batch.States[i];
+            s.Step.resize(static_cast<Eigen::Index>(k));
+            if (ok[t]) {
+                for (size_t r = 0; r < k; ++r) { s.Step(static_cast<Eigen::Index>(r)) = y[r * W + t]; }
+            } else {
+                Eigen::Map<EigenVector const> g(batch.Gradient.data() + s.Offset, static_cast<Eigen::Index>(k));
+                s.Step = Damped(s, batch.Normal.data() + batch.MatrixOffsets[i]).ldlt().solve(-g);
+            }
+        }
+    }
+} // namespace
+
+auto OptimizeBatch(tf::Subflow& subflow, Interpreter const& interpreter, Operon::Span<Tree> trees, Dataset const& dataset, Operon::Span<Operon::Scalar const> target, Range range, BatchOptimizerOptions const& options) -> std::vector<OptimizerSummary>
+{
+    EXPECT(target.size() == range.Size());
+    auto const n = trees.size();
+    auto const rows = range.Size();
+
+    Batch batch;
+    batch.Evaluators.reserve(n);
+    batch.States.resize(n);
+    batch.MatrixOffsets.resize(n);
+
+    // contiguous storage for the normal equations (k x k matrix and k-vector per tree)
+    size_t matrixSize{0};
+    size_t vectorSize{0};
+    for (size_t i = 0; i < n; ++i) {
+        batch.Evaluators.emplace_back(interpreter, trees[i], dataset, target, range);
+        auto coeff = trees[i].GetCoefficients();
+        auto& s = batch.States[i];
+        s.X = Eigen::Map<EigenVector const>(coeff.data(), static_cast<Eigen::Index>(coeff.size()));
+        s.Damping = options.InitialDamping;
+        s.Active = !coeff.empty() && options.Iterations > 0;
+        s.Offset = vectorSize;
+        batch.MatrixOffsets[i] = matrixSize;
+        matrixSize += coeff.size() * coeff.size();
+        vectorSize += coeff.size();
+        if (s.Active) { batch.Order.push_back(i); }
+    }
+    batch.Normal.resize(matrixSize);
+    batch.Gradient.resize(vectorSize);
+
+    auto size = [&](size_t i) { return static_cast<size_t>(batch.States[i].X.size()); };
+    std::stable_sort(batch.Order.begin(), batch.Order.end(), [&](auto a, auto b) { return size(a) < size(b); });
+    for (size_t first = 0; first < batch.Order.size();) {
+        auto const k = size(batch.Order[first]);
+        size_t count{1};
+        while (first + count < batch.Order.size() && count < BatchOptimizerOptions::SolveWidth && size(batch.Order[first + count]) == k) { ++count; }
+        batch.Chunks.push_back({ k, first, count });
+        first += count;
+    }
+
+    auto& states = batch.States;
+    auto initial = subflow.for_each_index(size_t{0}, n, size_t{1}, [&](size_t i) {
+        auto& s = states[i];
+        s.Cost = Residuals(batch.Evaluators[i], s.X.data(), rows);
+        s.Summary.InitialCost = s.Cost;
+        s.Summary.FunctionEvaluations = 1;
+    }).name("initial costs");
+
+    auto assemble = [&](size_t i) {
+        auto& s = states[i];
+        if (!s.Active || !s.Stale) { return; }
+        batch.Evaluators[i].NormalEquations(s.X.data(), batch.Normal.data() + batch.MatrixOffsets[i], batch.Gradient.data() + s.Offset);
+        ++s.Summary.JacobianEvaluations;
+        s.Stale = false;
+    };
+
+    auto trial = [&](size_t i) {
+        auto& s = states[i];
+        if (!s.Active) { return; }
+        ++s.Summary.Iterations;
+        if (!s.Step.allFinite() || s.Step.norm() <= options.StepTolerance * (s.X.norm() + options.StepTolerance)) {
+            s.Active = false;
+            return;
+        }
+
+        EigenVector candidate = s.X + s.Step;
+        auto cost = Residuals(batch.Evaluators[i], candidate.data(), rows);
+        ++s.Summary.FunctionEvaluations;
+
+        // gain ratio between the actual and the predicted reduction
+        auto const k = static_cast<Eigen::Index>(s.X.size());
+        Eigen::Map<EigenMatrix const> a(batch.Normal.data() + batch.MatrixOffsets[i], k, k);
+        Eigen::Map<EigenVector const> g(batch.Gradient.data() + s.Offset, k);
+        auto predicted = -static_cast<double>(s.Step.dot(g)) - 0.5 * static_cast<double>(s.Step.dot(a * s.Step)); // NOLINT
+        auto rho = predicted > 0 ? (s.Cost - cost) / predicted : -1.0;
+        if (std::isfinite(cost) && rho > 0) {
+            s.X = candidate;
+            s.Cost = cost;
+            s.Damping *= static_cast<Operon::Scalar>(std::max(1.0 / 3, 1 - std::pow(2 * rho - 1, 3))); // NOLINT
+            s.Nu = 2;
+            s.Stale = true;
+        } else {
+            s.Damping *= s.Nu;
+            s.Nu *= 2;
+        }
+    };
+
+    // one task per iteration, each one a subflow of the three stages (it runs once the previous one has joined)
+    auto previous = initial;
+    for (size_t iteration = 0; iteration < options.Iterations; ++iteration) {
+        auto step = subflow.emplace([&](tf::Subflow& sf) {
+            if (std::none_of(states.begin(), states.end(), [](auto const& s) { return s.Active; })) { return; }
+            auto assembleTask = sf.for_each_index(size_t{0}, n, size_t{1}, assemble).name("assemble normal equations");
+            auto solveTask = sf.for_each_index(size_t{0}, batch.Chunks.size(), size_t{1}, [&](size_t c) { SolveChunk(batch, batch.Chunks[c]); }).name("solve damped systems");
+            auto trialTask = sf.for_each_index(size_t{0}, n, size_t{1}, trial).name("evaluate steps");
+            assembleTask.precede(solveTask);
+            solveTask.precede(trialTask);
+        }).name("levenberg-marquardt iteration");
+        previous.precede(step);
+        previous = step;
+    }
+    subflow.join();
+
+    std::vector<OptimizerSummary> summaries(n);
+    for (size_t i = 0; i < n; ++i) {
+        auto& s = states[i];
+        s.Summary.FinalCost = s.Cost;
+        s.Summary.Success = s.Summary.FinalCost < s.Summary.InitialCost;
+        if (options.WriteCoefficients && s.Summary.Success) {
+            trees[i].SetCoefficients({ s.X.data(), static_cast<size_t>(s.X.size()) });
+        }
+        summaries[i] = s.Summary;
+    }
+    return summaries;
+}
+
+auto OptimizeBatch(tf::Executor& executor, Interpreter const& interpreter, Operon::Span<Tree> trees, Dataset const& dataset, Operon::Span<Operon::Scalar const> target, Range range, BatchOptimizerOptions const& options) -> std::vector<OptimizerSummary>
+{
+    std::vector<OptimizerSummary> summaries;
+    tf::Taskflow taskflow;
+    taskflow.emplace([&](tf::Subflow& subflow) {
+        summaries = OptimizeBatch(subflow, interpreter, trees, dataset, target, range, options);
+    }).name("optimize batch");
+    executor.run(taskflow).wait();
+    return summaries;
+}
+
+} // namespace Operon
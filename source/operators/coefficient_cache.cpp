@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include "operon/operators/coefficient_cache.hpp"
+
+namespace Operon {
+
+void CoefficientCache::Insert(Tree const& tree, Operon::Scalar error)
+{
+    auto const& nodes = tree.Hash(Operon::HashMode::Relaxed).Nodes();
+
+    // leaf values in postfix order, the leaves of the subtree rooted at i are a contiguous slice of it
+    Operon::Vector<Operon::Scalar> leaves;
+    std::vector<size_t> offset(nodes.size() + 1, 0); // offset[i] = number of leaves before node i
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        offset[i + 1] = offset[i] + static_cast<size_t>(nodes[i].IsLeaf());
+        if (nodes[i].IsLeaf()) { leaves.push_back(nodes[i].Value); }
+    }
+
+    // single leaves carry no information about how their coefficient was tuned in context
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        auto const& n = nodes[i];
+        if (n.IsLeaf()) { continue; }
+        auto const first = offset[i - n.Length];
+        auto const last = offset[i + 1];
+        cache_.InsertBest(n.CalculatedHashValue, { &error, 1 }, { leaves.data() + first, last - first });
+    }
+}
+
+auto CoefficientCache::WarmStart(Tree& tree) const -> WarmStartResult
+{
+    auto const& nodes = tree.Hash(Operon::HashMode::Relaxed).Nodes();
+    std::vector<size_t> leafIndex;
+    leafIndex.reserve(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (nodes[i].IsLeaf()) { leafIndex.push_back(i); }
+    }
+
+    WarmStartResult result;
+    Operon::FitnessVector fitness;
+    Operon::Vector<Operon::Scalar> coefficients;
+    auto& mutableNodes = tree.Nodes();
+
+    // parents come after their children in postfix order, so scanning backwards finds the largest subtrees first
+    size_t leaf = leafIndex.size(); // leaves at positions >= leaf belong to already visited subtrees
+    for (size_t i = nodes.size(); i-- > 0;) {
+        auto const& n = nodes[i];
+        if (n.IsLeaf()) { --leaf; continue; }
+        if (!cache_.Find(n.CalculatedHashValue, fitness, coefficients)) { continue; }
+
+        // the leaves of the subtree are the last coefficients.size() leaves before and including position i
+        auto const count = coefficients.size();
+        if (count > leaf) { continue; } // hash collision
+        auto const first = leaf - count;
+        for (size_t k = 0; k < count; ++k) {
+            mutableNodes[leafIndex[first + k]].Value = coefficients[k];
+        }
+        result.Coefficients += count;
+        result.Exact = result.Exact || i == nodes.size() - 1;
+        leaf = first;
+        i -= n.Length; // skip the rest of the subtree
+    }
+    return result;
+}
+
+} // namespace Operon
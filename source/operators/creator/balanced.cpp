@@ -2,6 +2,7 @@
 // SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
 
 #include "operon/operators/creator.hpp"
+#include "operon/core/node_pool.hpp"
 #include "operon/core/pset.hpp"
 #include "operon/core/tree.hpp"
 #include "operon/core/variable.hpp"
@@ -32,7 +33,9 @@ auto BalancedTreeCreator::operator()(Operon::RandomGenerator& random, size_t tar
 
     using U = std::tuple<Node, size_t, size_t>;
 
-    std::vector<U> tuples;
+    // per-thread scratch space (population initialization creates many trees back to back)
+    thread_local std::vector<U> tuples;
+    tuples.clear();
     tuples.reserve(targetLen);
 
     auto maxArity = std::min(maxFunctionArity, targetLen - 1);
@@ -72,7 +75,8 @@ auto BalancedTreeCreator::operator()(Operon::RandomGenerator& random, size_t tar
         }
     }
 
-    Operon::Vector<Node> postfix(tuples.size());
+    auto postfix = NodePool::Acquire(tuples.size());
+    postfix.resize(tuples.size());
     auto idx = tuples.size();
 
     auto add = [&](const U& t, auto&& ref) {
@@ -86,7 +90,7 @@ auto BalancedTreeCreator::operator()(Operon::RandomGenerator& random, size_t tar
         }
     };
     add(tuples.front(), add);
-    auto tree = Tree(postfix).UpdateNodes();
+    auto tree = Tree(std::move(postfix)).UpdateNodes();
     return tree;
 }
 } // namespace Operon
@@ -2,6 +2,7 @@
 // SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
 
 #include "operon/operators/creator.hpp"
+#include "operon/core/node_pool.hpp"
 #include "operon/core/pset.hpp"
 #include "operon/core/tree.hpp"
 #include "operon/core/variable.hpp"
@@ -30,7 +31,7 @@ auto GrowTreeCreator::operator()(Operon::RandomGenerator& random, size_t /*args*
         }
     };
 
-    Operon::Vector<Node> nodes;
+    auto nodes = NodePool::Acquire(0);
     size_t minArity = minFunctionArity;
     size_t maxArity = maxFunctionArity;
 
@@ -65,6 +66,6 @@ auto GrowTreeCreator::operator()(Operon::RandomGenerator& random, size_t /*args*
     grow(1, grow);
 
     std::reverse(nodes.begin(), nodes.end());
-    return Tree(nodes).UpdateNodes();
+    return Tree(std::move(nodes)).UpdateNodes();
 }
 } // namespace Operon
@@ -2,9 +2,9 @@
 // SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
 
 #include <vector>
-#include <deque>
 
 #include "operon/operators/creator.hpp"
+#include "operon/core/node_pool.hpp"
 #include "operon/core/pset.hpp"
 #include "operon/core/tree.hpp"
 #include "operon/core/variable.hpp"
@@ -34,8 +34,13 @@ auto ProbabilisticTreeCreator::operator()(Operon::RandomGenerator& random, size_
         targetLen = minFunctionArity + 1;
     }
 
-    Operon::Vector<Node> nodes;
+    // per-thread scratch space (population initialization creates many trees back to back)
+    thread_local Operon::Vector<Node> nodes;
+    thread_local std::vector<size_t> q;
+    thread_local std::vector<size_t> childIndices;
+    nodes.clear();
     nodes.reserve(targetLen);
+    q.clear();
 
     auto maxArity = std::min(maxFunctionArity, targetLen - 1);
     auto minArity = std::min(minFunctionArity, maxArity);
@@ -50,7 +55,6 @@ auto ProbabilisticTreeCreator::operator()(Operon::RandomGenerator& random, size_
     root.Depth = 1;
     nodes.push_back(root);
 
-    std::deque<size_t> q;
     for (size_t i = 0; i < root.Arity; ++i) {
         auto d = root.Depth + 1U;
         q.push_back(d);
@@ -59,10 +63,10 @@ auto ProbabilisticTreeCreator::operator()(Operon::RandomGenerator& random, size_
     // emulate a random dequeue operation
     auto randomDequeue = [&]() {
         EXPECT(!q.empty());
-        auto j = std::uniform_int_distribution<size_t>(0, q.size() - 1)(random);
-        std::swap(q[j], q.front());
-        auto t = q.front();
-        q.pop_front();
+        auto j = Random::Bounded(random, q.size());
+        std::swap(q[j], q.back());
+        auto t = q.back();
+        q.pop_back();
         return t;
     };
 
@@ -100,7 +104,7 @@ auto ProbabilisticTreeCreator::operator()(Operon::RandomGenerator& random, size_
     }
 
     std::sort(nodes.begin(), nodes.end(), [](const auto& lhs, const auto& rhs) { return lhs.Depth < rhs.Depth; });
-    std::vector<size_t> childIndices(nodes.size());
+    childIndices.assign(nodes.size(), 0);
 
     size_t c = 1;
     for (size_t i = 0; i < nodes.size(); ++i) {
@@ -114,7 +118,8 @@ auto ProbabilisticTreeCreator::operator()(Operon::RandomGenerator& random, size_
         c += nodes[i].Arity;
     }
 
-    Operon::Vector<Node> postfix(nodes.size());
+    auto postfix = NodePool::Acquire(nodes.size());
+    postfix.resize(nodes.size());
     size_t idx = nodes.size();
 
     const auto add = [&](size_t i, auto&& ref) {
@@ -133,7 +138,7 @@ auto ProbabilisticTreeCreator::operator()(Operon::RandomGenerator& random, size_
 
     add(0, add);
 
-    auto tree = Tree(postfix).UpdateNodes();
+    auto tree = Tree(std::move(postfix)).UpdateNodes();
     return tree;
 }
 } // namespace Operon
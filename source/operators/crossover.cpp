@@ -14,6 +14,8 @@ namespace {
     }
 } // namespace
 
+// two passes over the nodes without a candidate buffer: the first counts the leaf and function node candidates,
+// the second finds the k-th candidate of the chosen kind (the same distribution as sampling from a candidate list)
 static auto SelectRandomBranch(Operon::RandomGenerator& random, Tree const& tree, double internalProb, Limits length, Limits level, Limits depth) -> size_t
 {
     if (tree.Length() == 1) {
@@ -21,35 +23,31 @@ static auto SelectRandomBranch(Operon::RandomGenerator& random, Tree const& tree
     }
 
     auto const& nodes = tree.Nodes();
+    auto isCandidate = [&](Node const& node) {
+        return !(NotIn(length, node.Length + 1U) || NotIn(level, node.Level) || NotIn(depth, node.Depth));
+    };
+
+    size_t leafCount{0};
+    size_t funcCount{0};
+    for (auto const& node : nodes) {
+        if (!isCandidate(node)) { continue; }
+        if (node.IsLeaf()) { ++leafCount; } else { ++funcCount; }
+    }
 
-    std::vector<size_t> candidates(nodes.size());
-    auto head = candidates.begin();
-    auto tail = candidates.rbegin();
+    // check if we have any function node candidates at all and if the bernoulli trial succeeds
+    bool const internal = (funcCount > 0 && std::bernoulli_distribution(internalProb)(random)) || leafCount == 0;
+    auto const count = internal ? funcCount : leafCount;
+    if (count == 0) {
+        return 0;
+    }
+    auto k = count > 1 ? Operon::Random::Uniform(random, size_t{0}, count - 1) : size_t{0};
 
     for (size_t i = 0; i < nodes.size(); ++i) {
         auto const& node = nodes[i];
-
-        auto l = node.Length + 1U;
-        auto d = node.Depth;
-        auto v = node.Level;
-
-        if (NotIn(length, l) || NotIn(level, v) || NotIn(depth, d)) {
-            continue;
-        }
-
-        if (node.IsLeaf()) {
-            *head++ = i;
-        } else {
-            *tail++ = i;
-        }
-    }
-
-    // check if we have any function node candidates at all and if the bernoulli trial succeeds
-    if (tail > candidates.rbegin() && std::bernoulli_distribution(internalProb)(random)) {
-        return *Operon::Random::Sample(random, candidates.rbegin(), tail);
+        if (node.IsLeaf() == internal || !isCandidate(node)) { continue; }
+        if (k-- == 0) { return i; }
     }
-    return *Operon::Random::Sample(random, candidates.begin(), head);
-   
+    return 0; // unreachable, k < count
 }
 
 auto SubtreeCrossover::FindCompatibleSwapLocations(Operon::RandomGenerator& random, Tree const& lhs, Tree const& rhs) const -> std::pair<size_t, size_t>
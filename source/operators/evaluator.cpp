@@ -1,76 +1,168 @@
 // SPDX-License-Identifier: MIT
 // SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
 
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+#include <taskflow/taskflow.hpp>
+
 #include "operon/core/distance.hpp"
+#include "operon/core/instrumentation.hpp"
 #include "operon/operators/evaluator.hpp"
 #include "operon/error_metrics/mean_squared_error.hpp"
 #include "operon/error_metrics/normalized_mean_squared_error.hpp"
 #include "operon/error_metrics/r2_score.hpp"
 #include "operon/error_metrics/correlation_coefficient.hpp"
 #include "operon/error_metrics/mean_absolute_error.hpp"
+#include "operon/error_metrics/kernels.hpp"
+#include "operon/nnls/batch_optimizer.hpp"
 #include "operon/nnls/nnls.hpp"
 
 namespace Operon {
+    namespace {
+        // the iterators of the error metrics are span iterators, so the inputs are contiguous and the span kernels
+        // apply (see operon/error_metrics/kernels.hpp)
+        auto AsSpan(ErrorMetric::Iterator beg, ErrorMetric::Iterator end) noexcept -> Operon::Span<Operon::Scalar const>
+        {
+            auto const n = static_cast<size_t>(std::distance(beg, end));
+            return n == 0 ? Operon::Span<Operon::Scalar const>{} : Operon::Span<Operon::Scalar const>(&*beg, n);
+        }
+
+        auto AsSpan(ErrorMetric::Iterator beg, size_t n) noexcept -> Operon::Span<Operon::Scalar const>
+        {
+            return n == 0 ? Operon::Span<Operon::Scalar const>{} : Operon::Span<Operon::Scalar const>(&*beg, n);
+        }
+    } // namespace
+
     auto MSE::operator()(Operon::Span<Operon::Scalar const> estimated, Operon::Span<Operon::Scalar const> target) const noexcept -> double
     {
-        return MeanSquaredError(estimated.begin(), estimated.end(), target.begin());
+        return MeanSquaredError(estimated, target);
     }
 
     auto MSE::operator()(Iterator beg1, Iterator end1, Iterator beg2) const noexcept -> double
     {
-        return MeanSquaredError(beg1, end1, beg2);
+        auto estimated = AsSpan(beg1, end1);
+        return (*this)(estimated, AsSpan(beg2, estimated.size()));
     }
 
     auto RMSE::operator()(Operon::Span<Operon::Scalar const> estimated, Operon::Span<Operon::Scalar const> target) const noexcept -> double
     {
-        return RootMeanSquaredError(estimated.begin(), estimated.end(), target.begin());
+        return RootMeanSquaredError(estimated, target);
     }
 
     auto RMSE::operator()(Iterator beg1, Iterator end1, Iterator beg2) const noexcept -> double
     {
-        return RootMeanSquaredError(beg1, end1, beg2);
+        auto estimated = AsSpan(beg1, end1);
+        return (*this)(estimated, AsSpan(beg2, estimated.size()));
     }
 
     auto NMSE::operator()(Operon::Span<Operon::Scalar const> estimated, Operon::Span<Operon::Scalar const> target) const noexcept -> double
     {
-        return NormalizedMeanSquaredError(estimated.begin(), estimated.end(), target.begin());
+        return NormalizedMeanSquaredError(estimated, target);
     }
 
     auto NMSE::operator()(Iterator beg1, Iterator end1, Iterator beg2) const noexcept -> double
     {
-        return NormalizedMeanSquaredError(beg1, end1, beg2);
+        auto estimated = AsSpan(beg1, end1);
+        return (*this)(estimated, AsSpan(beg2, estimated.size()));
     }
 
     auto MAE::operator()(Operon::Span<Operon::Scalar const> estimated, Operon::Span<Operon::Scalar const> target) const noexcept -> double
     {
-        return MeanAbsoluteError(estimated.begin(), estimated.end(), target.begin());
+        return MeanAbsoluteError(estimated, target);
     }
 
     auto MAE::operator()(Iterator beg1, Iterator end1, Iterator beg2) const noexcept -> double
     {
-        return MeanAbsoluteError(beg1, end1, beg2);
+        auto estimated = AsSpan(beg1, end1);
+        return (*this)(estimated, AsSpan(beg2, estimated.size()));
     }
 
     auto R2::operator()(Operon::Span<Operon::Scalar const> estimated, Operon::Span<Operon::Scalar const> target) const noexcept -> double
     {
-        return -R2Score(estimated.begin(), estimated.end(), target.begin());
+        return -R2Score(estimated, target);
     }
 
     auto R2::operator()(Iterator beg1, Iterator end1, Iterator beg2) const noexcept -> double
     {
-        return -R2Score(beg1, end1, beg2);
+        auto estimated = AsSpan(beg1, end1);
+        return (*this)(estimated, AsSpan(beg2, estimated.size()));
     }
 
     auto C2::operator()(Operon::Span<Operon::Scalar const> estimated, Operon::Span<Operon::Scalar const> target) const noexcept -> double
     {
-        auto r = CorrelationCoefficient(estimated.begin(), estimated.end(), target.begin());
+        auto r = CorrelationCoefficient(estimated, target);
         return -(r * r);
     }
 
     auto C2::operator()(Iterator beg1, Iterator end1, Iterator beg2) const noexcept -> double
     {
-        auto r = CorrelationCoefficient(beg1, end1, beg2);
-        return -(r * r);
+        auto estimated = AsSpan(beg1, end1);
+        return (*this)(estimated, AsSpan(beg2, estimated.size()));
+    }
+
+    using Kernels::SumOfSquaredErrors;
+    using Kernels::SumOfAbsoluteErrors;
+
+    auto MSE::Accumulate(Operon::Span<Operon::Scalar const> estimated, Operon::Span<Operon::Scalar const> target) const noexcept -> double
+    {
+        return SumOfSquaredErrors(estimated, target);
+    }
+
+    auto RMSE::Accumulate(Operon::Span<Operon::Scalar const> estimated, Operon::Span<Operon::Scalar const> target) const noexcept -> double
+    {
+        return SumOfSquaredErrors(estimated, target);
+    }
+
+    auto RMSE::Finalize(double sum, size_t n, double /*normalization*/) const noexcept -> double
+    {
+        return std::sqrt(sum / static_cast<double>(n));
+    }
+
+    auto NMSE::Accumulate(Operon::Span<Operon::Scalar const> estimated, Operon::Span<Operon::Scalar const> target) const noexcept -> double
+    {
+        return SumOfSquaredErrors(estimated, target);
+    }
+
+    auto NMSE::Normalization(Operon::Span<Operon::Scalar const> target) const noexcept -> double
+    {
+        return Kernels::Variance(target);
+    }
+
+    auto NMSE::Finalize(double sum, size_t n, double normalization) const noexcept -> double
+    {
+        // same convention as NormalizedMeanSquaredError for (almost) constant targets
+        constexpr double eps{1e-12};
+        if (std::abs(normalization) < eps) {
+            return normalization;
+        }
+        return sum / static_cast<double>(n) / normalization;
+    }
+
+    auto R2::Accumulate(Operon::Span<Operon::Scalar const> estimated, Operon::Span<Operon::Scalar const> target) const noexcept -> double
+    {
+        return SumOfSquaredErrors(estimated, target);
+    }
+
+    auto R2::Normalization(Operon::Span<Operon::Scalar const> target) const noexcept -> double
+    {
+        return Kernels::Variance(target);
+    }
+
+    auto R2::Finalize(double sum, size_t n, double normalization) const noexcept -> double
+    {
+        // same convention as R2Score for (almost) constant targets
+        constexpr double eps{1e-12};
+        auto sst = normalization * static_cast<double>(n);
+        if (sst < eps) {
+            return -std::numeric_limits<double>::min();
+        }
+        return -(1.0 - sum / sst);
+    }
+
+    auto MAE::Accumulate(Operon::Span<Operon::Scalar const> estimated, Operon::Span<Operon::Scalar const> target) const noexcept -> double
+    {
+        return SumOfAbsoluteErrors(estimated, target);
     }
 
     template<typename T, std::enable_if_t<std::is_arithmetic_v<T>, bool> = true>
@@ -92,52 +184,533 @@ namespace Operon {
         return FitLeastSquaresImpl<double>(estimated, target);
     }
 
+    template<typename T, std::enable_if_t<std::is_arithmetic_v<T>, bool> = true>
+    auto ComputeScalingMomentsImpl(Operon::Span<T const> estimated, Operon::Span<T const> target) -> ScalingMoments {
+        auto stats = vstat::bivariate::accumulate<T>(estimated.data(), target.data(), estimated.size());
+        return { static_cast<double>(estimated.size()), stats.mean_x, stats.mean_y, stats.variance_x, stats.variance_y, stats.covariance };
+    }
+
+    auto ComputeScalingMoments(Operon::Span<float const> estimated, Operon::Span<float const> target) noexcept -> ScalingMoments {
+        return ComputeScalingMomentsImpl<float>(estimated, target);
+    }
+
+    auto ComputeScalingMoments(Operon::Span<double const> estimated, Operon::Span<double const> target) noexcept -> ScalingMoments {
+        return ComputeScalingMomentsImpl<double>(estimated, target);
+    }
+
+    namespace {
+        // combines the moments of two disjoint sets of rows (Chan et al.)
+        auto MergeScalingMoments(ScalingMoments const& a, ScalingMoments const& b) noexcept -> ScalingMoments
+        {
+            if (a.Count == 0) { return b; }
+            if (b.Count == 0) { return a; }
+            auto const n = a.Count + b.Count;
+            auto const dx = b.MeanX - a.MeanX;
+            auto const dy = b.MeanY - a.MeanY;
+            auto const f = a.Count * b.Count / n;
+            return {
+                n,
+                a.MeanX + dx * b.Count / n,
+                a.MeanY + dy * b.Count / n,
+                (a.VarianceX * a.Count + b.VarianceX * b.Count + dx * dx * f) / n,
+                (a.VarianceY * a.Count + b.VarianceY * b.Count + dy * dy * f) / n,
+                (a.Covariance * a.Count + b.Covariance * b.Count + dx * dy * f) / n
+            };
+        }
+
+        // mean squared error of a * x + b with respect to y, where a and b are chosen as in FitLeastSquaresImpl:
+        // E[(a(x - mx) - (y - my))^2] = a^2 var(x) - 2 a cov(x, y) + var(y)
+        auto ScaledMeanSquaredError(ScalingMoments const& m) noexcept -> double
+        {
+            auto a = m.Covariance / m.VarianceX;
+            if (!std::isfinite(a)) {
+                a = 1;
+            }
+            return std::max(0.0, a * a * m.VarianceX - 2 * a * m.Covariance + m.VarianceY);
+        }
+    } // namespace
+
+    auto MSE::ScaledError(ScalingMoments const& moments) const noexcept -> double
+    {
+        return ScaledMeanSquaredError(moments);
+    }
+
+    auto RMSE::ScaledError(ScalingMoments const& moments) const noexcept -> double
+    {
+        return std::sqrt(ScaledMeanSquaredError(moments));
+    }
+
+    auto NMSE::ScaledError(ScalingMoments const& moments) const noexcept -> double
+    {
+        return Finalize(ScaledMeanSquaredError(moments), 1, moments.VarianceY);
+    }
+
+    auto R2::ScaledError(ScalingMoments const& moments) const noexcept -> double
+    {
+        // same convention as R2Score for (almost) constant targets
+        constexpr double eps{1e-12};
+        if (moments.VarianceY * moments.Count < eps) {
+            return -std::numeric_limits<double>::min();
+        }
+        return -(1.0 - ScaledMeanSquaredError(moments) / moments.VarianceY);
+    }
+
+    auto C2::ScaledError(ScalingMoments const& moments) const noexcept -> double
+    {
+        // the correlation is invariant to linear scaling
+        auto r = moments.Covariance / std::sqrt(moments.VarianceX * moments.VarianceY);
+        return -(r * r);
+    }
+
+    namespace {
+        // tune the tree coefficients with the nonlinear least squares optimizer, keeping the evaluation counters up to date
+        // (the mini-batches are drawn from the random generator, so every call samples its own blocks of rows)
+        auto OptimizeCoefficients(EvaluatorBase const& evaluator, Operon::RandomGenerator& random, Interpreter const& interpreter, Tree& tree, Dataset const& dataset, Operon::Span<Operon::Scalar const> target, Range range, size_t iter) -> void
+        {
+            if (iter == 0) { return; }
+
+            auto sse = [&](Tree const& t) {
+                auto estimated = interpreter.Evaluate<Operon::Scalar>(t, dataset, range);
+                auto value = SumOfSquaredErrors({ estimated.data(), estimated.size() }, target);
+                return std::isfinite(value) ? value : std::numeric_limits<double>::max();
+            };
+
+            // try the cached coefficients of the inherited subtrees and keep them if they fit better
+            if (auto* cache = evaluator.GetCoefficientCache(); cache != nullptr) {
+                auto candidate = tree;
+                auto [count, exact] = cache->WarmStart(candidate);
+                if (count > 0) {
+                    evaluator.IncrementResidualEvaluations(2);
+                    if (sse(candidate) < sse(tree)) {
+                        tree.SetCoefficients(candidate.GetCoefficients());
+                        // the whole tree was optimized before, there is nothing left to gain
+                        if (exact) { return; }
+                    }
+                }
+            }
+
+            auto optimize = [&]() {
+                if (evaluator.VariableProjection()) {
+                    NonlinearLeastSquaresOptimizer<OptimizerType::VARPRO> opt(interpreter, tree, dataset);
+                    return opt.Optimize(target, range, iter);
+                }
+                if (evaluator.NormalEquations()) {
+                    NonlinearLeastSquaresOptimizer<OptimizerType::NORMAL> opt(interpreter, tree, dataset);
+                    return opt.Optimize(target, range, iter);
+                }
+                if (evaluator.MiniBatchSize() > 0) {
+                    MiniBatchOptions options;
+                    options.BatchSize = evaluator.MiniBatchSize();
+                    options.Seed = random();
+                    NonlinearLeastSquaresOptimizer<OptimizerType::MINIBATCH> opt(interpreter, tree, dataset, options);
+                    return opt.Optimize(target, range, iter);
+                }
+#if defined(HAVE_CERES)
+                NonlinearLeastSquaresOptimizer<OptimizerType::CERES> opt(interpreter, tree, dataset);
+#else
+                NonlinearLeastSquaresOptimizer<OptimizerType::EIGEN> opt(interpreter, tree, dataset);
+#endif
+                return opt.Optimize(target, range, iter);
+            };
+            // the optimizers use the coefficients of the workspace (see OptimizerWorkspace), hence a buffer of its own
+            thread_local std::vector<Operon::Scalar> coeff;
+            tree.GetCoefficients(coeff);
+            auto summary = [&]() {
+                Instrumentation::ScopedTimer timer(Instrumentation::Operator::LocalOptimization);
+                return optimize();
+            }();
+            evaluator.IncrementResidualEvaluations(summary.FunctionEvaluations);
+            evaluator.IncrementJacobianEvaluations(summary.JacobianEvaluations);
+
+            // the cached subtree coefficients are those of the best fitting tree they were tuned in
+            if (auto* cache = evaluator.GetCoefficientCache(); cache != nullptr && summary.Success) {
+                evaluator.IncrementResidualEvaluations();
+                cache->Insert(tree, static_cast<Operon::Scalar>(sse(tree)));
+            }
+
+            if (summary.Success) {
+                tree.SetCoefficients(coeff);
+            }
+        }
+    } // namespace
+
+    auto Evaluator::UsesStreaming() const -> bool
+    {
+        auto const& metric = error_.get();
+        return cache_ == nullptr && (scaling_ ? metric.HasScaledForm() : metric.IsMonotone());
+    }
+
+    auto Evaluator::BufferSize() const -> size_t
+    {
+        return UsesStreaming() ? 0 : GetProblem().TrainingRange().Size();
+    }
+
+    auto Evaluator::CaseErrors(Operon::Span<Individual const> individuals, Operon::Span<size_t const> rows, Operon::Span<Operon::Scalar> errors) const -> void
+    {
+        auto const m = rows.size();
+        auto const n = individuals.size();
+        EXPECT(errors.size() == m * n);
+        if (m == 0) { return; }
+
+        // the rows are evaluated in place (see Interpreter::Evaluate over a set of rows), only the target is gathered
+        auto const& dataset = GetDataset();
+        std::vector<uint32_t> indices(rows.begin(), rows.end());
+        Operon::Span<uint32_t const> sample(indices.data(), indices.size());
+        Operon::Vector<Operon::Scalar> target(m);
+        Kernels::Gather(dataset.GetValues(GetProblem().TargetVariable()), sample, Operon::Span<Operon::Scalar>(target));
+        Operon::Vector<Operon::Scalar> estimated(m);
+        for (size_t i = 0; i < n; ++i) {
+            GetInterpreter().template Evaluate<Operon::Scalar>(individuals[i].Genotype, dataset, sample, Operon::Span<Operon::Scalar>(estimated));
+            double a{1};
+            double b{0};
+            if (scaling_) { std::tie(a, b) = FitLeastSquaresImpl<Operon::Scalar>(estimated, target); }
+            for (size_t c = 0; c < m; ++c) {
+                auto const e = std::abs(a * estimated[c] + b - target[c]);
+                errors[c * n + i] = std::isfinite(e) ? static_cast<Operon::Scalar>(e) : std::numeric_limits<Operon::Scalar>::infinity();
+            }
+        }
+    }
+
     auto
-    Evaluator::operator()(Operon::RandomGenerator& /*random*/, Individual& ind, Operon::Span<Operon::Scalar> buf) const -> typename EvaluatorBase::ReturnType
+    Evaluator::operator()(Operon::RandomGenerator& random, Individual& ind, Operon::Span<Operon::Scalar> buf) const -> typename EvaluatorBase::ReturnType
     {
-        IncrementEvaluationCounter();
+        return Evaluate(random, ind, buf, std::numeric_limits<Operon::Scalar>::max());
+    }
+
+    auto
+    Evaluator::Evaluate(Operon::RandomGenerator& random, Individual& ind, Operon::Span<Operon::Scalar> buf, Operon::Scalar cutoff) const -> typename EvaluatorBase::ReturnType
+    {
+        return Evaluate(random, ind, buf, cutoff, GetProblem().TrainingRange());
+    }
+
+    auto
+    Evaluator::Evaluate(Operon::RandomGenerator& random, Individual& ind, Operon::Span<Operon::Scalar> buf, Operon::Scalar cutoff, Range range) const -> typename EvaluatorBase::ReturnType
+    {
+        Instrumentation::ScopedTimer timer(Instrumentation::Operator::Evaluation);
         auto const& problem = GetProblem();
-        auto const& dataset = problem.GetDataset();
+        auto const& dataset = GetDataset();
         auto& genotype = ind.Genotype;
+        if (Simplification()) { genotype.Simplify(); }
+
+        // structurally identical trees with the same coefficients have the same fitness
+        // (only fitness values computed over the whole training range are cached, the hits are not evaluations)
+        auto* fitnessCache = range.Bounds() == problem.TrainingRange().Bounds() ? GetFitnessCache() : nullptr;
+        Operon::Hash key{0};
+        if (fitnessCache != nullptr) {
+            key = genotype.ComputeHash(Operon::HashMode::Strict);
+            Operon::FitnessVector fitness;
+            Operon::Vector<Operon::Scalar> coefficients;
+            if (fitnessCache->Find(key, fitness, coefficients)) {
+                IncrementCacheHits();
+                genotype.SetCoefficients(coefficients);
+                return fitness;
+            }
+            IncrementCacheMisses();
+        }
 
-        auto trainingRange = problem.TrainingRange();
+        // semantically equivalent trees are assumed to have the same fitness (see FingerprintCache)
+        auto* fingerprintCache = range.Bounds() == problem.TrainingRange().Bounds() ? GetFingerprintCache() : nullptr;
+        std::optional<Operon::Hash> fingerprint;
+        if (fingerprintCache != nullptr) {
+            fingerprint = fingerprintCache->Fingerprint(GetInterpreter(), genotype, scaling_);
+            Operon::FitnessVector fitness;
+            Operon::Vector<Operon::Scalar> coefficients;
+            if (fingerprint && fingerprintCache->Find(*fingerprint, fitness, coefficients)) {
+                // the cached fitness belongs to the fitted coefficients, restored if the tree has a place for each
+                auto const optimized = LocalOptimizationIterations() > 0;
+                if (!optimized || static_cast<size_t>(genotype.CoefficientsCount()) == coefficients.size()) {
+                    IncrementCacheHits();
+                    if (optimized) { genotype.SetCoefficients(coefficients); }
+                    return fitness;
+                }
+            }
+        }
+        IncrementEvaluationCounter();
+
+        auto trainingRange = range;
         auto targetValues = dataset.GetValues(problem.TargetVariable()).subspan(trainingRange.Start(), trainingRange.Size());
 
+        // the packed inputs are read instead of the columns of the dataset (not with a chunked dataset, see PackedInputs)
+        auto const* packed = chunked_ == nullptr ? problem.GetPackedInputs() : nullptr;
+
+        // the outputs over the training range, if they are materialized
+        Operon::Span<Operon::Scalar const> outputs;
+
         auto computeFitness = [&]() {
             IncrementResidualEvaluations();
+            // stream the estimated values into the metric batch by batch instead of materializing them
+            auto const& metric = error_.get();
+            if (UsesStreaming()) {
+                auto const program = packed != nullptr
+                    ? GetInterpreter().template Compile<Operon::Scalar>(genotype, dataset, *packed)
+                    : GetInterpreter().template Compile<Operon::Scalar>(genotype, dataset);
+                auto const n = trainingRange.Size();
+
+                // with a chunked dataset the rows are streamed block by block, prefetching the next block
+                auto stream = [&](auto&& callback) {
+                    if (chunked_ == nullptr) {
+                        GetInterpreter().template EvaluateStreaming<Operon::Scalar>(program, trainingRange, callback);
+                        return;
+                    }
+                    chunked_->ForEachBlock(trainingRange, [&](Range block) {
+                        auto const base = block.Start() - trainingRange.Start();
+                        bool proceed{true};
+                        GetInterpreter().template EvaluateStreaming<Operon::Scalar>(program, block, [&](auto estimated, auto offset) {
+                            return proceed = callback(estimated, base + offset);
+                        });
+                        return proceed;
+                    });
+                };
+
+                if (scaling_) {
+                    ScalingMoments moments;
+                    stream([&](auto estimated, auto offset) {
+                        moments = MergeScalingMoments(moments, ComputeScalingMomentsImpl<Operon::Scalar>(estimated, targetValues.subspan(offset, estimated.size())));
+                        return true;
+                    });
+                    return metric.ScaledError(moments);
+                }
+
+                // check the cutoff every CutoffBatchSize rows and stop as soon as the partial error exceeds it
+                auto const norm = metric.Normalization(dataset.Statistics(problem.TargetVariable(), trainingRange));
+                auto const check = cutoff < std::numeric_limits<Operon::Scalar>::max();
+                double sum{0};
+                size_t next{CutoffBatchSize};
+                bool aborted{false};
+                stream([&](auto estimated, auto offset) {
+                    sum += metric.Accumulate(estimated, targetValues.subspan(offset, estimated.size()));
+                    if (check && offset + estimated.size() >= next) {
+                        next += CutoffBatchSize;
+                        aborted = metric.Finalize(sum, n, norm) > cutoff;
+                    }
+                    return !aborted;
+                });
+                return aborted ? static_cast<double>(std::numeric_limits<Operon::Scalar>::max()) : metric.Finalize(sum, n, norm);
+            }
+
             Operon::Vector<Operon::Scalar> estimatedValues;
             if (buf.size() < trainingRange.Size()) {
                 estimatedValues.resize(trainingRange.Size());
                 buf = Operon::Span<Operon::Scalar>(estimatedValues.data(), estimatedValues.size());
             }
-            GetInterpreter().template Evaluate<Operon::Scalar>(genotype, dataset, trainingRange, buf);
+            auto result = buf.subspan(0, trainingRange.Size());
+
+            if (cache_ != nullptr && cache_->GetRange().Bounds() == trainingRange.Bounds()) {
+                GetInterpreter().template Evaluate<Operon::Scalar>(genotype, dataset, trainingRange, result, *cache_);
+            } else if (packed != nullptr) {
+                GetInterpreter().template Evaluate<Operon::Scalar>(GetInterpreter().template Compile<Operon::Scalar>(genotype, dataset, *packed), trainingRange, result);
+            } else {
+                GetInterpreter().template Evaluate<Operon::Scalar>(genotype, dataset, trainingRange, result);
+            }
+            outputs = result;
 
+            if (scaling_ && metric.HasScaledForm()) {
+                // single pass over the estimated values, the scaled values are never written
+                return metric.ScaledError(ComputeScalingMomentsImpl<Operon::Scalar>(result, targetValues));
+            }
             if (scaling_) {
-                auto [a, b] = FitLeastSquaresImpl<Operon::Scalar>(buf, targetValues);
-                std::transform(buf.begin(), buf.end(), buf.begin(), [a=a,b=b](auto x) { return a * x + b; });
+                auto [a, b] = FitLeastSquaresImpl<Operon::Scalar>(result, targetValues);
+                std::transform(result.begin(), result.end(), result.begin(), [a=a,b=b](auto x) { return a * x + b; });
             }
-            return error_(buf.begin(), buf.end(), targetValues.begin());
+            return error_(result.begin(), result.end(), targetValues.begin());
         };
 
-        auto const iter = LocalOptimizationIterations();
+        OptimizeCoefficients(*this, random, GetInterpreter(), genotype, dataset, targetValues, trainingRange, LocalOptimizationIterations());
 
-        if (iter > 0) {
-#if defined(HAVE_CERES)
-            NonlinearLeastSquaresOptimizer<OptimizerType::CERES> opt(interpreter_.get(), genotype, dataset);
-#else
-            NonlinearLeastSquaresOptimizer<OptimizerType::EIGEN> opt(interpreter_.get(), genotype, dataset);
-#endif
-            auto coeff = genotype.GetCoefficients();
-            auto summary = opt.Optimize(targetValues, trainingRange, iter);
-            IncrementResidualEvaluations(summary.FunctionEvaluations);
-            IncrementJacobianEvaluations(summary.JacobianEvaluations);
+        auto fit = Operon::FitnessVector { static_cast<Operon::Scalar>(computeFitness()) };
+        for (auto& v : fit) {
+            if (!std::isfinite(v)) {
+                v = std::numeric_limits<Operon::Scalar>::max();
+            }
+        }
+        // do not cache the results of evaluations stopped early by the cutoff
+        if (fitnessCache != nullptr && fit.front() < std::numeric_limits<Operon::Scalar>::max()) {
+            auto coefficients = genotype.GetCoefficients();
+            fitnessCache->Insert(key, fit, coefficients);
+        }
+        if (fingerprint && fit.front() < std::numeric_limits<Operon::Scalar>::max()) {
+            auto coefficients = genotype.GetCoefficients();
+            fingerprintCache->Insert(*fingerprint, fit, coefficients);
+        }
+        // the sketch is projected from the outputs computed above, or from an evaluation of the sample rows
+        if (auto* sketch = GetSemanticSketch(); sketch != nullptr && range.Bounds() == problem.TrainingRange().Bounds() && fit.front() < std::numeric_limits<Operon::Scalar>::max()) {
+            auto const hash = genotype.ComputeHash(Operon::HashMode::Strict);
+            if (outputs.size() == trainingRange.Size()) {
+                sketch->Record(hash, outputs);
+            } else {
+                sketch->Record(hash, genotype);
+            }
+        }
+        return fit;
+    }
 
-            if (summary.Success) {
-                genotype.SetCoefficients(coeff);
+    auto BatchEvaluator::EvaluateGroup(Operon::RandomGenerator& random, Operon::Span<Individual> group, Operon::Span<Operon::Scalar> fitness, bool optimize) const -> void
+    {
+        Instrumentation::ScopedTimer timer(Instrumentation::Operator::Evaluation);
+        IncrementEvaluationCounter(group.size());
+        auto const& problem = GetProblem();
+        auto const& dataset = GetDataset();
+        auto const& interpreter = GetInterpreter();
+        auto const& metric = error_.get();
+        auto const range = problem.TrainingRange();
+        auto const targetValues = dataset.GetValues(problem.TargetVariable()).subspan(range.Start(), range.Size());
+
+        using Program = Interpreter::Program<Operon::Scalar>;
+        Operon::Vector<Program> programs;
+        programs.reserve(group.size());
+        for (auto& ind : group) {
+            auto& genotype = ind.Genotype;
+            if (optimize) {
+                if (Simplification()) { genotype.Simplify(); }
+                OptimizeCoefficients(*this, random, interpreter, genotype, dataset, targetValues, range, LocalOptimizationIterations());
+            }
+            programs.push_back(interpreter.Compile<Operon::Scalar>(genotype, dataset));
+        }
+        IncrementResidualEvaluations(group.size());
+
+        // without a streaming form the whole range is one tile
+        auto const streaming = scaling_ ? metric.HasScaledForm() : metric.IsMonotone();
+        auto const tile = streaming ? std::min(tileSize_, range.Size()) : range.Size();
+        auto const norm = streaming && !scaling_ ? metric.Normalization(dataset.Statistics(problem.TargetVariable(), range)) : 1.0;
+
+        thread_local Operon::Vector<Operon::Scalar> buffer;
+        buffer.resize(std::max(buffer.size(), tile));
+        Operon::Vector<ScalingMoments> moments(group.size());
+        Operon::Vector<double> sums(group.size(), 0.0);
+
+        for (size_t offset = 0; offset < range.Size(); offset += tile) {
+            Range const block { range.Start() + offset, std::min(range.Start() + offset + tile, range.End()) };
+            Operon::Span<Operon::Scalar> estimated(buffer.data(), block.Size());
+            auto const target = targetValues.subspan(offset, block.Size());
+            for (size_t i = 0; i < programs.size(); ++i) {
+                interpreter.Evaluate<Operon::Scalar>(programs[i], block, estimated);
+                if (!streaming) {
+                    if (scaling_) {
+                        auto [a, b] = FitLeastSquaresImpl<Operon::Scalar>(estimated, target);
+                        std::transform(estimated.begin(), estimated.end(), estimated.begin(), [a=a,b=b](auto x) { return a * x + b; });
+                    }
+                    sums[i] = metric(estimated, target);
+                } else if (scaling_) {
+                    moments[i] = MergeScalingMoments(moments[i], ComputeScalingMomentsImpl<Operon::Scalar>(estimated, target));
+                } else {
+                    sums[i] += metric.Accumulate(estimated, target);
+                }
+            }
+        }
+
+        for (size_t i = 0; i < group.size(); ++i) {
+            auto value = !streaming ? sums[i] : scaling_ ? metric.ScaledError(moments[i]) : metric.Finalize(sums[i], range.Size(), norm);
+            fitness[i] = std::isfinite(value) ? static_cast<Operon::Scalar>(value) : std::numeric_limits<Operon::Scalar>::max();
+        }
+    }
+
+    auto
+    BatchEvaluator::operator()(Operon::RandomGenerator& random, Individual& ind, Operon::Span<Operon::Scalar> /*buf*/) const -> typename EvaluatorBase::ReturnType
+    {
+        Operon::FitnessVector fit(1);
+        EvaluateGroup(random, { &ind, 1 }, { fit.data(), fit.size() }, /*optimize=*/true);
+        return fit;
+    }
+
+    auto BatchEvaluator::EvaluateBatch(Operon::RandomGenerator& random, tf::Executor& executor, Operon::Span<Individual> individuals) const -> Operon::Vector<Operon::Scalar>
+    {
+        Operon::Vector<Operon::Scalar> fitness(individuals.size());
+        tf::Taskflow taskflow;
+        taskflow.emplace([&](tf::Subflow& subflow) { EvaluateBatch(subflow, random, individuals, { fitness.data(), fitness.size() }); });
+        executor.run(taskflow).wait();
+        return fitness;
+    }
+
+    auto BatchEvaluator::EvaluateBatch(tf::Subflow& subflow, Operon::RandomGenerator& random, Operon::Span<Individual> individuals, Operon::Span<Operon::Scalar> fitness) const -> void
+    {
+        auto const batched = batchedOptimization_ && LocalOptimizationIterations() > 0;
+        auto const groups = (individuals.size() + groupSize_ - 1) / groupSize_;
+        // one generator per group, seeded in order so the result does not depend on the scheduling
+        std::vector<Operon::RandomGenerator::result_type> seeds(groups);
+        std::generate(seeds.begin(), seeds.end(), [&]() { return random(); });
+
+        // the trees are moved into a contiguous buffer for the batch optimizer, and back
+        std::vector<Tree> trees;
+        std::vector<OptimizerSummary> summaries;
+        auto optimize = subflow.emplace([&](tf::Subflow& sf) {
+            if (!batched) { return; }
+            auto const& problem = GetProblem();
+            auto const range = problem.TrainingRange();
+            auto const target = GetDataset().GetValues(problem.TargetVariable()).subspan(range.Start(), range.Size());
+            trees.reserve(individuals.size());
+            for (auto& ind : individuals) {
+                if (Simplification()) { ind.Genotype.Simplify(); }
+                trees.push_back(std::move(ind.Genotype));
             }
+            BatchOptimizerOptions options;
+            options.Iterations = LocalOptimizationIterations();
+            summaries = OptimizeBatch(sf, GetInterpreter(), { trees.data(), trees.size() }, GetDataset(), target, range, options);
+            for (size_t i = 0; i < individuals.size(); ++i) { individuals[i].Genotype = std::move(trees[i]); }
+        }).name("batch optimization");
+
+        auto evaluate = subflow.for_each_index(size_t{0}, groups, size_t{1}, [&](size_t g) {
+            auto const first = g * groupSize_;
+            auto const count = std::min(groupSize_, individuals.size() - first);
+            Operon::RandomGenerator rng(seeds[g]);
+            EvaluateGroup(rng, individuals.subspan(first, count), fitness.subspan(first, count), /*optimize=*/!batched);
+        }).name("evaluate groups");
+        optimize.precede(evaluate);
+        subflow.join();
+
+        for (auto const& summary : summaries) {
+            IncrementResidualEvaluations(static_cast<size_t>(summary.FunctionEvaluations));
+            IncrementJacobianEvaluations(static_cast<size_t>(summary.JacobianEvaluations));
         }
+    }
+
+    auto
+    MultiMetricEvaluator::operator()(Operon::RandomGenerator& random, Individual& ind, Operon::Span<Operon::Scalar> buf) const -> typename EvaluatorBase::ReturnType
+    {
+        Instrumentation::ScopedTimer timer(Instrumentation::Operator::Evaluation);
+        IncrementEvaluationCounter();
+        auto const& problem = GetProblem();
+        auto const& dataset = GetDataset();
+        auto& genotype = ind.Genotype;
+        if (Simplification()) { genotype.Simplify(); }
+
+        auto trainingRange = problem.TrainingRange();
+        auto targetValues = dataset.GetValues(problem.TargetVariable()).subspan(trainingRange.Start(), trainingRange.Size());
 
-        auto fit = Operon::Vector<Operon::Scalar> { static_cast<Operon::Scalar>(computeFitness()) };
+        // the coefficients are tuned and the tree is interpreted only once for all the metrics
+        OptimizeCoefficients(*this, random, GetInterpreter(), genotype, dataset, targetValues, trainingRange, LocalOptimizationIterations());
+
+        IncrementResidualEvaluations();
+        Operon::Vector<Operon::Scalar> estimatedValues;
+        if (buf.size() < trainingRange.Size()) {
+            estimatedValues.resize(trainingRange.Size());
+            buf = Operon::Span<Operon::Scalar>(estimatedValues.data(), estimatedValues.size());
+        }
+        auto result = buf.subspan(0, trainingRange.Size());
+        GetInterpreter().template Evaluate<Operon::Scalar>(genotype, dataset, trainingRange, result);
+
+        Operon::FitnessVector fit;
+        fit.reserve(metrics_.size());
+        if (!scaling_) {
+            for (auto const& metric : metrics_) {
+                fit.push_back(static_cast<Operon::Scalar>(metric.get()(result, targetValues)));
+            }
+        } else {
+            auto moments = ComputeScalingMomentsImpl<Operon::Scalar>(result, targetValues);
+            // the scaled values are only materialized if some metric lacks a closed form
+            Operon::Vector<Operon::Scalar> scaled;
+            for (auto const& metric : metrics_) {
+                if (metric.get().HasScaledForm()) {
+                    fit.push_back(static_cast<Operon::Scalar>(metric.get().ScaledError(moments)));
+                    continue;
+                }
+                if (scaled.empty()) {
+                    auto [a, b] = FitLeastSquaresImpl<Operon::Scalar>(result, targetValues);
+                    scaled.resize(result.size());
+                    std::transform(result.begin(), result.end(), scaled.begin(), [a=a,b=b](auto x) { return a * x + b; });
+                }
+                fit.push_back(static_cast<Operon::Scalar>(metric.get()(Operon::Span<Operon::Scalar const>(scaled.data(), scaled.size()), targetValues)));
+            }
+        }
         for (auto& v : fit) {
             if (!std::isfinite(v)) {
                 v = std::numeric_limits<Operon::Scalar>::max();
@@ -146,42 +719,248 @@ namespace Operon {
         return fit;
     }
 
-    auto DiversityEvaluator::Prepare(Operon::Span<Operon::Individual const> pop) const -> void {
-        if (hashes_.size() < pop.size()) {
-            hashes_.resize(pop.size());
+    auto CrossValidationEvaluator::UsesStreaming() const -> bool
+    {
+        auto const& metric = error_.get();
+        return scaling_ ? metric.HasScaledForm() : metric.IsMonotone();
+    }
+
+    auto CrossValidationEvaluator::BufferSize() const -> size_t
+    {
+        return UsesStreaming() ? 0 : GetProblem().TrainingRange().Size();
+    }
+
+    auto CrossValidationEvaluator::Fold(size_t fold) const -> Range
+    {
+        EXPECT(fold < folds_);
+        auto const range = GetProblem().TrainingRange();
+        auto const n = range.Size();
+        return Range { range.Start() + fold * n / folds_, range.Start() + (fold + 1) * n / folds_ };
+    }
+
+    auto CrossValidationEvaluator::FoldErrors(Tree const& tree, Operon::Span<Operon::Scalar> buf) const -> Operon::Vector<double>
+    {
+        auto const& problem = GetProblem();
+        auto const& dataset = GetDataset();
+        auto const& interpreter = GetInterpreter();
+        auto const& metric = error_.get();
+        auto const range = problem.TrainingRange();
+        EXPECT(range.Size() >= folds_);
+        auto const targetValues = dataset.GetValues(problem.TargetVariable()).subspan(range.Start(), range.Size());
+
+        Operon::Vector<double> errors(folds_);
+        if (UsesStreaming()) {
+            auto const program = interpreter.Compile<Operon::Scalar>(tree, dataset);
+            Operon::Vector<ScalingMoments> moments(folds_);
+            Operon::Vector<double> sums(folds_, 0.0);
+
+            // the offsets are relative to the start of the training range
+            size_t fold{0};
+            auto end = Fold(0).End() - range.Start();
+            interpreter.EvaluateStreaming<Operon::Scalar>(program, range, [&](auto estimated, auto offset) {
+                // a batch may straddle the boundary of two (or more, for tiny folds) folds
+                for (size_t i = 0; i < estimated.size();) {
+                    while (offset + i >= end) { end = Fold(++fold).End() - range.Start(); }
+                    auto const count = std::min(estimated.size() - i, end - offset - i);
+                    auto const x = estimated.subspan(i, count);
+                    auto const y = targetValues.subspan(offset + i, count);
+                    if (scaling_) {
+                        moments[fold] = MergeScalingMoments(moments[fold], ComputeScalingMomentsImpl<Operon::Scalar>(x, y));
+                    } else {
+                        sums[fold] += metric.Accumulate(x, y);
+                    }
+                    i += count;
+                }
+                return true;
+            });
+
+            for (size_t f = 0; f < folds_; ++f) {
+                auto const rows = Fold(f);
+                errors[f] = scaling_
+                    ? metric.ScaledError(moments[f])
+                    : metric.Finalize(sums[f], rows.Size(), metric.Normalization(dataset.Statistics(problem.TargetVariable(), rows)));
+            }
+            return errors;
         }
 
-        // hash the trees
-        for (size_t i = 0; i < pop.size(); ++i) {
-            auto const& nodes = pop[i].Genotype.Hash(Operon::HashMode::Strict).Nodes();
-            hashes_[i].reserve(nodes.size());
-            std::transform(std::begin(nodes), std::end(nodes), std::back_inserter(hashes_[i]), [](auto const& n) { return n.CalculatedHashValue; });
-            std::stable_sort(std::begin(hashes_[i]), std::end(hashes_[i]));
+        Operon::Vector<Operon::Scalar> estimatedValues;
+        if (buf.size() < range.Size()) {
+            estimatedValues.resize(range.Size());
+            buf = Operon::Span<Operon::Scalar>(estimatedValues.data(), estimatedValues.size());
         }
+        auto result = buf.subspan(0, range.Size());
+        interpreter.Evaluate<Operon::Scalar>(tree, dataset, range, result);
 
-        std::vector<vstat::univariate_accumulator<Operon::Scalar>> stats;
-        stats.reserve(pop.size());
-        for (auto i = 0UL; i < pop.size(); ++i) {
-            stats.emplace_back(Operon::Scalar{0});
+        for (size_t f = 0; f < folds_; ++f) {
+            auto const rows = Fold(f);
+            auto estimated = result.subspan(rows.Start() - range.Start(), rows.Size());
+            auto const target = targetValues.subspan(rows.Start() - range.Start(), rows.Size());
+            if (scaling_) {
+                auto [a, b] = FitLeastSquaresImpl<Operon::Scalar>(estimated, target);
+                std::transform(estimated.begin(), estimated.end(), estimated.begin(), [a=a,b=b](auto x) { return a * x + b; });
+            }
+            errors[f] = metric(estimated, target);
         }
+        return errors;
+    }
 
-        auto const n = pop.size() * (pop.size() - 1) / 2;
+    auto
+    CrossValidationEvaluator::operator()(Operon::RandomGenerator& random, Individual& ind, Operon::Span<Operon::Scalar> buf) const -> typename EvaluatorBase::ReturnType
+    {
+        Instrumentation::ScopedTimer timer(Instrumentation::Operator::Evaluation);
+        IncrementEvaluationCounter();
+        auto const& problem = GetProblem();
+        auto const& dataset = GetDataset();
+        auto& genotype = ind.Genotype;
+        if (Simplification()) { genotype.Simplify(); }
+
+        auto const trainingRange = problem.TrainingRange();
+        auto const targetValues = dataset.GetValues(problem.TargetVariable()).subspan(trainingRange.Start(), trainingRange.Size());
+        OptimizeCoefficients(*this, random, GetInterpreter(), genotype, dataset, targetValues, trainingRange, LocalOptimizationIterations());
+
+        IncrementResidualEvaluations();
+        auto const errors = FoldErrors(genotype, buf);
+
+        // the mean and the (sample) variance of the fold errors
+        auto const k = static_cast<double>(errors.size());
+        auto const mean = std::accumulate(errors.begin(), errors.end(), 0.0) / k;
+        auto const variance = std::accumulate(errors.begin(), errors.end(), 0.0, [&](auto s, auto e) { return s + (e - mean) * (e - mean); }) / (k - 1);
 
-        for (auto i = 0UL; i < pop.size() - 1; ++i) {
-            for (auto j = i+1; j < pop.size(); ++j) {
-                auto d = Operon::Distance::Jaccard(hashes_[i], hashes_[j]);
-                stats[i](static_cast<Operon::Scalar>(d));
-                stats[j](static_cast<Operon::Scalar>(d));
+        auto fit = Operon::FitnessVector { static_cast<Operon::Scalar>(mean), static_cast<Operon::Scalar>(variance) };
+        for (auto& v : fit) {
+            if (!std::isfinite(v)) {
+                v = std::numeric_limits<Operon::Scalar>::max();
             }
         }
+        return fit;
+    }
+
+    void EvaluatorBase::Prepare(tf::Subflow& subflow, Operon::Span<Individual const> pop) const
+    {
+        subflow.emplace([this, pop]() { Prepare(pop); }).name("prepare evaluator");
+    }
+
+    auto SubsampledEvaluator::Prepare(Operon::Span<Operon::Individual const> pop) const -> void
+    {
+        evaluator_.get().Prepare(pop);
+
+        // draw a new window
+        auto const range = GetProblem().TrainingRange();
+        auto const size = std::max(size_t{1}, static_cast<size_t>(fraction_ * static_cast<double>(range.Size())));
+        auto const start = range.Start() + std::uniform_int_distribution<size_t>(0, range.Size() - size)(random_);
+        window_ = Range { start, start + size };
+        if (size == range.Size()) { // nothing to race
+            threshold_ = std::numeric_limits<Operon::Scalar>::max();
+            return;
+        }
 
+        // individuals better than the quantile of the current population on the window are raced on the whole range
+        std::vector<size_t> indices;
+        for (size_t i = 0; i < pop.size(); ++i) {
+            if (pop[i].Genotype.Length() > 0 && !pop[i].Fitness.empty() && pop[i][0] < std::numeric_limits<Operon::Scalar>::max()) {
+                indices.push_back(i);
+            }
+        }
+        if (indices.size() > sample_) {
+            std::vector<size_t> sample;
+            sample.reserve(sample_);
+            std::sample(indices.begin(), indices.end(), std::back_inserter(sample), sample_, random_);
+            indices.swap(sample);
+        }
+        auto const& evaluator = evaluator_.get();
+        Operon::Vector<Operon::Scalar> buf(evaluator.BufferSize());
+        std::vector<Operon::Scalar> fitness;
+        fitness.reserve(indices.size());
+        for (auto i : indices) {
+            auto ind = pop[i];
+            auto const fit = evaluator.Evaluate(random_, ind, buf, std::numeric_limits<Operon::Scalar>::max(), window_);
+            if (fit.front() < std::numeric_limits<Operon::Scalar>::max()) { fitness.push_back(fit.front()); }
+        }
+        SetResidualEvaluations(evaluator.ResidualEvaluations());
+        SetJacobianEvaluations(evaluator.JacobianEvaluations());
+        SetEvaluationCounter(evaluator.EvaluationCount());
+        if (fitness.empty()) {
+            threshold_ = std::numeric_limits<Operon::Scalar>::max();
+            return;
+        }
+        auto nth = fitness.begin() + static_cast<int64_t>(quantile_ * static_cast<double>(fitness.size() - 1));
+        std::nth_element(fitness.begin(), nth, fitness.end());
+        threshold_ = *nth;
+    }
+
+    auto
+    SubsampledEvaluator::Evaluate(Operon::RandomGenerator& rng, Individual& ind, Operon::Span<Operon::Scalar> buf, Operon::Scalar cutoff) const -> typename EvaluatorBase::ReturnType
+    {
+        auto const& evaluator = evaluator_.get();
+        auto const range = GetProblem().TrainingRange();
+
+        auto fit = evaluator.Evaluate(rng, ind, buf, cutoff, window_);
+        if (window_.Size() < range.Size() && fit.front() <= threshold_) {
+            ++fullEvaluations_;
+            fit = evaluator.Evaluate(rng, ind, buf, cutoff, range);
+        }
+
+        SetResidualEvaluations(evaluator.ResidualEvaluations());
+        SetJacobianEvaluations(evaluator.JacobianEvaluations());
+        SetEvaluationCounter(evaluator.EvaluationCount());
+        return fit;
+    }
+
+    auto DiversityEvaluator::HashTree(Operon::Individual const& ind, std::vector<Operon::Hash>& hashes) const -> void
+    {
+        auto const& nodes = ind.Genotype.Hash(Operon::HashMode::Strict).Nodes();
+        hashes.clear();
+        hashes.reserve(nodes.size());
+        std::transform(std::begin(nodes), std::end(nodes), std::back_inserter(hashes), [](auto const& n) { return n.CalculatedHashValue; });
+        std::stable_sort(std::begin(hashes), std::end(hashes));
+    }
+
+    auto DiversityEvaluator::UpdateDistances(Operon::Span<Operon::Individual const> pop) const -> void
+    {
         divmap_.clear();
-        for (auto i = 0UL; i < pop.size(); ++i) {
-            [[maybe_unused]] auto [it, ok] = divmap_.insert({
-                pop[i].Genotype.HashValue(),
-                static_cast<Operon::Scalar>(vstat::univariate_statistics(stats[i]).mean)
-            });
+        auto insert = [&](auto const& distances) {
+            for (auto i = 0UL; i < pop.size(); ++i) {
+                auto const d = std::min(distances[i], static_cast<double>(std::numeric_limits<Operon::Scalar>::max()));
+                [[maybe_unused]] auto [it, ok] = divmap_.insert({ pop[i].Genotype.HashValue(), static_cast<Operon::Scalar>(d) });
+            }
+        };
+        if (semantic_ != nullptr) {
+            insert(semantic_->MeanDistances());
+            return;
+        }
+        Operon::Span<Operon::Vector<Operon::Hash> const> sets(hashes_.data(), pop.size());
+        auto distances = signatureSize_ > 0
+            ? Operon::Distance::MeanJaccardMinHash(sets, signatureSize_)
+            : Operon::Distance::PairwiseMeans(sets);
+        insert(distances);
+    }
+
+    auto DiversityEvaluator::Prepare(Operon::Span<Operon::Individual const> pop) const -> void {
+        if (semantic_ != nullptr) {
+            semantic_->Prepare(pop);
+            UpdateDistances(pop);
+            return;
+        }
+        if (hashes_.size() < pop.size()) {
+            hashes_.resize(pop.size());
+        }
+        for (size_t i = 0; i < pop.size(); ++i) { HashTree(pop[i], hashes_[i]); }
+        UpdateDistances(pop);
+    }
+
+    auto DiversityEvaluator::Prepare(tf::Subflow& subflow, Operon::Span<Operon::Individual const> pop) const -> void {
+        if (semantic_ != nullptr) {
+            auto sketch = subflow.emplace([this, pop](tf::Subflow& sf) { semantic_->Prepare(sf, pop); }).name("prepare sketches");
+            auto distances = subflow.emplace([this, pop]() { UpdateDistances(pop); }).name("update distances");
+            sketch.precede(distances);
+            return;
+        }
+        if (hashes_.size() < pop.size()) {
+            hashes_.resize(pop.size());
         }
+        auto hash = subflow.for_each_index(size_t{0}, pop.size(), size_t{1}, [this, pop](size_t i) { HashTree(pop[i], hashes_[i]); }).name("hash trees");
+        auto distances = subflow.emplace([this, pop]() { UpdateDistances(pop); }).name("update distances");
+        hash.precede(distances);
     }
 
     auto
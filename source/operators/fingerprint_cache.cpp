@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include "operon/operators/fingerprint_cache.hpp"
+#include "operon/hash/hash.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace Operon {
+
+FingerprintCache::FingerprintCache(Problem const& problem, size_t rows, size_t capacity)
+    : sample_(problem.GetDataset().Sample(problem.TrainingRange(), rows))
+    , table_(capacity)
+{
+}
+
+auto FingerprintCache::Fingerprint(Interpreter const& interpreter, Tree const& tree, bool standardize) const -> std::optional<Operon::Hash>
+{
+    auto const n = Rows();
+    auto const values = interpreter.Evaluate<Operon::Scalar>(tree, sample_, Range { 0, n });
+    if (!std::all_of(values.begin(), values.end(), [](auto v) { return std::isfinite(v); })) {
+        return std::nullopt;
+    }
+
+    double shift{0};
+    double scale{1};
+    if (standardize) {
+        // the scaled fitness is invariant to the scale (including its sign) and the offset of the outputs
+        double mean{0};
+        for (auto v : values) { mean += v; }
+        mean /= static_cast<double>(n);
+        double var{0};
+        for (auto v : values) { var += (v - mean) * (v - mean); }
+        auto const sd = std::sqrt(var / static_cast<double>(n));
+        shift = mean;
+        // constant outputs all scale to the mean of the target
+        scale = sd > 1e-12 * (std::abs(mean) + 1) ? 1 / sd : 0;
+        auto const first = std::find_if(values.begin(), values.end(), [&](auto v) { return (v - shift) * scale != 0; });
+        if (first != values.end() && (*first - shift) < 0) { scale = -scale; }
+    }
+
+    // the mantissa rounded to its leading bits and the exponent of every output
+    std::vector<int64_t> quantized(2 * n, 0);
+    for (size_t i = 0; i < n; ++i) {
+        auto const v = (static_cast<double>(values[i]) - shift) * scale;
+        if (v == 0) { continue; } // also -0
+        int exponent{0};
+        auto const mantissa = std::frexp(v, &exponent);
+        quantized[2 * i] = static_cast<int64_t>(std::llround(std::ldexp(mantissa, MantissaBits)));
+        quantized[2 * i + 1] = exponent;
+    }
+    return Operon::Hasher{}(reinterpret_cast<uint8_t const*>(quantized.data()), quantized.size() * sizeof(int64_t)); // NOLINT
+}
+
+auto FingerprintCache::Find(Operon::Hash fingerprint, Operon::FitnessVector& fitness, Operon::Vector<Operon::Scalar>& coefficients) const -> bool
+{
+    return table_.Find(fingerprint, fitness, coefficients);
+}
+
+void FingerprintCache::Insert(Operon::Hash fingerprint, Operon::Span<Operon::Scalar const> fitness, Operon::Span<Operon::Scalar const> coefficients)
+{
+    table_.Insert(fingerprint, fitness, coefficients);
+}
+
+} // namespace Operon
@@ -0,0 +1,103 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include "operon/operators/fitness_cache.hpp"
+#include "operon/core/contracts.hpp"
+
+#include <algorithm>
+
+namespace Operon {
+
+FitnessCache::FitnessCache(size_t capacity)
+    : shardCapacity_(std::max(size_t{1}, capacity / ShardCount))
+{
+    for (auto& shard : shards_) {
+        shard.Entries.resize(shardCapacity_);
+        shard.Index.reserve(shardCapacity_);
+    }
+}
+
+auto FitnessCache::Find(Operon::Hash hash, Operon::FitnessVector& fitness, Operon::Vector<Operon::Scalar>& coefficients) const -> bool
+{
+    auto& shard = GetShard(hash);
+    std::lock_guard<std::mutex> lock(shard.Mutex);
+    if (auto it = shard.Index.find(hash); it != shard.Index.end()) {
+        auto const& entry = shard.Entries[it->second];
+        entry.Referenced = true;
+        fitness = entry.Fitness;
+        coefficients = entry.Coefficients;
+        ++hits_;
+        return true;
+    }
+    ++misses_;
+    return false;
+}
+
+void FitnessCache::Insert(Operon::Hash hash, Operon::Span<Operon::Scalar const> fitness, Operon::Span<Operon::Scalar const> coefficients)
+{
+    Store(hash, fitness, coefficients, /*best=*/false);
+}
+
+void FitnessCache::InsertBest(Operon::Hash hash, Operon::Span<Operon::Scalar const> fitness, Operon::Span<Operon::Scalar const> coefficients)
+{
+    EXPECT(!fitness.empty());
+    Store(hash, fitness, coefficients, /*best=*/true);
+}
+
+void FitnessCache::Store(Operon::Hash hash, Operon::Span<Operon::Scalar const> fitness, Operon::Span<Operon::Scalar const> coefficients, bool best)
+{
+    auto& shard = GetShard(hash);
+    std::lock_guard<std::mutex> lock(shard.Mutex);
+
+    size_t slot{0};
+    if (auto it = shard.Index.find(hash); it != shard.Index.end()) {
+        slot = it->second;
+        auto const& entry = shard.Entries[slot];
+        if (best && !entry.Fitness.empty() && !(fitness.front() < entry.Fitness.front())) { return; }
+    } else {
+        // CLOCK: advance the hand, giving referenced entries a second chance
+        auto& entries = shard.Entries;
+        while (entries[shard.Hand].Occupied && entries[shard.Hand].Referenced) {
+            entries[shard.Hand].Referenced = false;
+            shard.Hand = (shard.Hand + 1) % entries.size();
+        }
+        slot = shard.Hand;
+        shard.Hand = (shard.Hand + 1) % entries.size();
+        if (entries[slot].Occupied) {
+            shard.Index.erase(entries[slot].Key);
+        }
+        shard.Index.insert({ hash, slot });
+    }
+
+    auto& entry = shard.Entries[slot];
+    entry.Key = hash;
+    entry.Fitness.assign(fitness.begin(), fitness.end());
+    entry.Coefficients.assign(coefficients.begin(), coefficients.end());
+    entry.Occupied = true;
+    entry.Referenced = false;
+}
+
+void FitnessCache::Clear()
+{
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.Mutex);
+        for (auto& entry : shard.Entries) {
+            entry.Occupied = false;
+            entry.Referenced = false;
+        }
+        shard.Index.clear();
+        shard.Hand = 0;
+    }
+}
+
+auto FitnessCache::Size() const -> size_t
+{
+    size_t size{0};
+    for (auto const& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.Mutex);
+        size += shard.Index.size();
+    }
+    return size;
+}
+
+} // namespace Operon
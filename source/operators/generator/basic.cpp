@@ -1,14 +1,43 @@
 // SPDX-License-Identifier: MIT
 // SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
 
+#include <taskflow/taskflow.hpp>
+
 #include "operon/operators/generator.hpp"
+#include "operon/core/instrumentation.hpp"
 
 namespace Operon {
-    auto BasicOffspringGenerator::operator()(Operon::RandomGenerator& random, double pCrossover, double pMutation, Operon::Span<Operon::Scalar> buf) const -> std::optional<Individual>
+    auto OffspringGeneratorBase::Prepare(tf::Subflow& subflow, Operon::Span<Individual const> pop) const -> void
     {
-        std::uniform_real_distribution<double> uniformReal;
-        bool doCrossover = std::bernoulli_distribution(pCrossover)(random);
-        bool doMutation = std::bernoulli_distribution(pMutation)(random);
+        if (!filter_.RejectClones()) {
+            filter_.Prepare(pop); // only averages the lengths
+            PrepareOperators(subflow, pop);
+            return;
+        }
+        auto filter = subflow.emplace([this, pop]() { filter_.Prepare(pop); }).name("prepare filter");
+        auto operators = subflow.emplace([this, pop](tf::Subflow& sf) { PrepareOperators(sf, pop); }).name("prepare operators");
+        filter.precede(operators);
+    }
+
+    auto OffspringGeneratorBase::PrepareOperators(tf::Subflow& subflow, Operon::Span<Individual const> pop) const -> void
+    {
+        this->FemaleSelector().Prepare(subflow, pop);
+        if (&this->MaleSelector() != &this->FemaleSelector()) {
+            this->MaleSelector().Prepare(subflow, pop);
+        }
+        this->Evaluator().Prepare(subflow, pop);
+        if (screening_ != nullptr) {
+            screening_->Prepare(subflow, pop);
+        }
+        if (surrogate_ != nullptr) {
+            subflow.emplace([this, pop]() { surrogate_->Prepare(pop); }).name("prepare surrogate");
+        }
+    }
+
+    auto BasicOffspringGenerator::Vary(Operon::RandomGenerator& random, double pCrossover, double pMutation) const -> std::optional<Individual>
+    {
+        bool doCrossover = Random::Real<double>(random) < pCrossover;
+        bool doMutation = Random::Real<double>(random) < pMutation;
 
         if (!(doCrossover || doMutation)) {
             return std::nullopt;
@@ -21,19 +50,25 @@ namespace Operon {
 
         if (doCrossover) {
             auto second = this->MaleSelector()(random);
+            Instrumentation::ScopedTimer timer(Instrumentation::Operator::Crossover);
             child.Genotype = this->Crossover()(random, population[first].Genotype, population[second].Genotype);
         }
 
         if (doMutation) {
+            Instrumentation::ScopedTimer timer(Instrumentation::Operator::Mutation);
             child.Genotype = doCrossover
                 ? this->Mutator()(random, std::move(child.Genotype))
-                : this->Mutator()(random, population[first].Genotype);
+                : this->Mutator()(random, NodePool::Copy(population[first].Genotype));
         }
 
-        child.Fitness = this->Evaluator()(random, child, buf);
-        for (auto& v : child.Fitness) {
-            if (!std::isfinite(v)) { v = std::numeric_limits<Operon::Scalar>::max(); }
-        }
-        return std::make_optional(child);
+        if (!Admit(random, child)) { return std::nullopt; }
+        return std::make_optional(std::move(child));
+    }
+
+    auto BasicOffspringGenerator::operator()(Operon::RandomGenerator& random, double pCrossover, double pMutation, Operon::Span<Operon::Scalar> buf) const -> std::optional<Individual>
+    {
+        auto child = Vary(random, pCrossover, pMutation);
+        if (child) { Evaluate(random, *child, buf); }
+        return child;
     }
 } // namespace Operon
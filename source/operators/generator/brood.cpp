@@ -1,57 +1,158 @@
 // SPDX-License-Identifier: MIT
 // SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
 
+#include <algorithm>
+#include <taskflow/taskflow.hpp>
+
 #include "operon/operators/generator.hpp"
+#include "operon/core/instrumentation.hpp"
 #include "operon/operators/non_dominated_sorter.hpp"
 
 namespace Operon {
-    auto BroodOffspringGenerator::operator()(Operon::RandomGenerator& random, double pCrossover, double pMutation, Operon::Span<Operon::Scalar> buf) const -> std::optional<Individual>
+    namespace {
+        // the scratch space of a brood, per calling thread since the broods of the algorithm workers run concurrently.
+        // the buffers are those of the workers of the brood executor, used by one brood at a time (its caller waits)
+        struct Scratch {
+            std::vector<Individual> Offspring;
+            std::vector<Operon::Scalar> Errors;
+            std::vector<std::optional<SurrogateModel::FeatureVector>> Features;
+            Operon::Vector<Operon::Scalar> Buffers;
+        };
+
+        auto GetScratch() -> Scratch&
+        {
+            thread_local Scratch scratch;
+            return scratch;
+        }
+    } // namespace
+
+    void BroodOffspringGenerator::BroodThreads(size_t value)
+    {
+        broodThreads_ = value;
+        executor_ = value > 1 ? std::make_shared<tf::Executor>(value) : nullptr;
+    }
+
+    auto BroodOffspringGenerator::Generate(Operon::RandomGenerator& random, double pCrossover, double pMutation, Operon::Span<Operon::Scalar> buf, Individual& slot) const -> bool
     {
-        std::uniform_real_distribution<double> uniformReal;
 
         auto population = this->FemaleSelector().Population();
 
         auto first = FemaleSelector()(random);
         auto second = MaleSelector()(random);
+        auto const seed = random();
+
+        // with a screening tier the children are screened first (their errors stored), then only the promoted ones
+        // are evaluated
+        auto const* screening = Screening();
+        auto& scratch = GetScratch();
+        auto& offspring = scratch.Offspring;
+        offspring.resize(broodSize_);
+        auto& errors = scratch.Errors;
+        errors.assign(broodSize_, std::numeric_limits<Operon::Scalar>::max());
+        // the features of the children for the surrogate model, if any
+        auto& features = scratch.Features;
+        features.assign(broodSize_, std::nullopt);
+        auto const parentFitness = (population[first][0] + population[second][0]) / 2;
 
-        // assuming the basic generator never fails
-        auto makeOffspring = [&]() {
+        // assuming the variation never fails (the filter may reject the child)
+        auto makeOffspring = [&](size_t i, Operon::Span<Operon::Scalar> buffer) {
+            auto rng = Random::Stream(seed, 0, i);
             Individual child(population[first].Fitness.size());
-            bool doCrossover = std::bernoulli_distribution(pCrossover)(random);
-            bool doMutation = std::bernoulli_distribution(pMutation)(random);
+            bool doCrossover = Random::Real<double>(rng) < pCrossover;
+            bool doMutation = Random::Real<double>(rng) < pMutation;
 
             if (doCrossover) {
-                child.Genotype = Crossover()(random, population[first].Genotype, population[second].Genotype);
+                Instrumentation::ScopedTimer timer(Instrumentation::Operator::Crossover);
+                child.Genotype = Crossover()(rng, population[first].Genotype, population[second].Genotype);
             }
 
             if (doMutation) {
+                Instrumentation::ScopedTimer timer(Instrumentation::Operator::Mutation);
                 child.Genotype = doCrossover
-                    ? Mutator()(random, std::move(child.Genotype))
-                    : Mutator()(random, population[first].Genotype);
+                    ? Mutator()(rng, std::move(child.Genotype))
+                    : Mutator()(rng, NodePool::Copy(population[first].Genotype));
             }
 
-            auto f = Evaluator()(random, child, buf);
-            for (size_t i = 0; i < f.size(); ++i) {
-                child[i] = std::isfinite(f[i]) ? f[i] : std::numeric_limits<Operon::Scalar>::max();
+            if (child.Genotype.Length() == 0 || !Admit(rng, child)) { return child; } // left empty, not evaluated
+            if (!Predict(child, parentFitness, features[i])) { return child; }
+            if (screening != nullptr) {
+                errors[i] = (*screening)(child);
+                return child;
             }
+            Evaluate(rng, child, buffer);
+            Learn(features[i], child);
             return child;
         };
 
-        std::vector<Individual> offspring;
-        offspring.reserve(broodSize_);
-        for (size_t i = 0; i < broodSize_; ++i) {
-            offspring.push_back(makeOffspring());
+        auto evaluate = [&](size_t i, Operon::Span<Operon::Scalar> buffer) {
+            if (offspring[i].Genotype.Length() == 0) { return; }
+            auto rng = Random::Stream(seed, 1, i);
+            Evaluate(rng, offspring[i], buffer);
+            Learn(features[i], offspring[i]);
+        };
+
+        auto forEachChild = [&](auto&& work) {
+            if (executor_ == nullptr || broodSize_ < 2) {
+                for (size_t i = 0; i < broodSize_; ++i) { work(i, buf); }
+                return;
+            }
+            // one evaluation buffer per worker of the brood executor
+            auto const size = Evaluator().BufferSize();
+            auto& buffers = scratch.Buffers;
+            if (buffers.size() < executor_->num_workers() * size) { buffers.resize(executor_->num_workers() * size); }
+            tf::Taskflow taskflow;
+            taskflow.for_each_index(size_t{0}, broodSize_, size_t{1}, [&](size_t i) {
+                auto const w = static_cast<size_t>(executor_->this_worker_id());
+                work(i, Operon::Span<Operon::Scalar>(buffers.data() + w * size, size));
+            });
+            executor_->run(taskflow).wait();
+        };
+        forEachChild([&](size_t i, Operon::Span<Operon::Scalar> buffer) { offspring[i] = makeOffspring(i, buffer); });
+
+        if (screening != nullptr) {
+            // the best screened child is promoted regardless of the threshold, so that the brood is never empty
+            std::optional<size_t> best;
+            for (size_t i = 0; i < broodSize_; ++i) {
+                if (offspring[i].Genotype.Length() == 0) { continue; }
+                if (!best || errors[i] < errors[*best]) { best = i; }
+            }
+            for (size_t i = 0; i < broodSize_; ++i) {
+                if (offspring[i].Genotype.Length() == 0 || screening->Promote(errors[i], i == best)) { continue; }
+                NodePool::Release(std::move(offspring[i].Genotype));
+            }
+            forEachChild(evaluate);
         }
+
+        // the children without variation, rejected by the filter, the surrogate or the screening are dropped
+        offspring.erase(std::remove_if(offspring.begin(), offspring.end(), [](auto const& child) { return child.Genotype.Length() == 0; }), offspring.end());
+        if (offspring.empty()) { return false; }
+
         SingleObjectiveComparison comp{0};
         RankIntersectSorter sorter;
 
+        size_t best{0};
         if (population[first].Size() > 1) {
             std::stable_sort(offspring.begin(), offspring.end(), LexicographicalComparison{});
             auto fronts = sorter(offspring);
-            auto best = *std::min_element(fronts[0].begin(), fronts[0].end(), [&](auto i, auto j) { return comp(offspring[i], offspring[j]); });
-            return std::make_optional(offspring[best]);
+            best = *std::min_element(fronts[0].begin(), fronts[0].end(), [&](auto i, auto j) { return comp(offspring[i], offspring[j]); });
+        } else {
+            best = static_cast<size_t>(std::distance(offspring.begin(), std::min_element(offspring.begin(), offspring.end(), comp)));
+        }
+
+        // the best child is moved into the slot, the nodes of the others go back to the pool
+        for (size_t i = 0; i < offspring.size(); ++i) {
+            if (i != best) { NodePool::Release(std::move(offspring[i].Genotype)); }
+        }
+        slot = std::move(offspring[best]);
+        return true;
+    }
+
+    auto BroodOffspringGenerator::operator()(Operon::RandomGenerator& random, double pCrossover, double pMutation, Operon::Span<Operon::Scalar> buf) const -> std::optional<Individual>
+    {
+        Individual child;
+        if (!Generate(random, pCrossover, pMutation, buf, child)) {
+            return std::nullopt;
         }
-        auto best = *std::min_element(offspring.begin(), offspring.end(), comp);
-        return std::make_optional(best);
+        return std::make_optional(std::move(child));
     }
 } // namespace Operon
@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <algorithm>
+#include <numeric>
+
+#include "operon/operators/generator.hpp"
+
+namespace Operon {
+
+namespace {
+    // the rejections in a row of the children varied by this thread
+    thread_local size_t streak{0}; // NOLINT
+} // namespace
+
+    void OffspringFilter::Prepare(Operon::Span<Individual const> pop) const
+    {
+        last_ = Statistics();
+        total_ += last_;
+
+        auto const total = std::transform_reduce(pop.begin(), pop.end(), size_t{0}, std::plus{}, [](auto const& ind) { return ind.Genotype.Length(); });
+        averageLength_ = pop.empty() ? 0.0 : static_cast<double>(total) / static_cast<double>(pop.size());
+
+        hashes_.clear();
+        if (rejectClones_) {
+            hashes_.reserve(pop.size());
+            for (auto const& ind : pop) { hashes_.push_back(ind.Genotype.Hash(Operon::HashMode::Strict).HashValue()); }
+            std::sort(hashes_.begin(), hashes_.end());
+            hashes_.erase(std::unique(hashes_.begin(), hashes_.end()), hashes_.end());
+        }
+
+        checked_.store(0, std::memory_order_relaxed);
+        oversized_.store(0, std::memory_order_relaxed);
+        tarpeian_.store(0, std::memory_order_relaxed);
+        clones_.store(0, std::memory_order_relaxed);
+        forced_.store(0, std::memory_order_relaxed);
+    }
+
+    auto OffspringFilter::operator()(Operon::RandomGenerator& random, Tree const& child) const -> Verdict
+    {
+        checked_.fetch_add(1, std::memory_order_relaxed);
+
+        auto verdict = Verdict::Accepted;
+        if (child.Length() > maxLength_ || child.Depth() > maxDepth_) {
+            verdict = Verdict::Oversized;
+        } else if (tarpeianProbability_ > 0 && static_cast<double>(child.Length()) > averageLength_ && Random::Real<double>(random) < tarpeianProbability_) {
+            verdict = Verdict::Tarpeian;
+        } else if (rejectClones_ && std::binary_search(hashes_.begin(), hashes_.end(), child.Hash(Operon::HashMode::Strict).HashValue())) {
+            verdict = Verdict::Clone;
+        }
+
+        if (verdict == Verdict::Accepted) {
+            streak = 0;
+            return verdict;
+        }
+        if (++streak > maxRetries_) {
+            streak = 0;
+            forced_.fetch_add(1, std::memory_order_relaxed);
+            return Verdict::Accepted;
+        }
+        switch (verdict) {
+        case Verdict::Oversized: { oversized_.fetch_add(1, std::memory_order_relaxed); break; }
+        case Verdict::Tarpeian: { tarpeian_.fetch_add(1, std::memory_order_relaxed); break; }
+        case Verdict::Clone: { clones_.fetch_add(1, std::memory_order_relaxed); break; }
+        default: break;
+        }
+        return verdict;
+    }
+
+    auto OffspringFilter::Statistics() const -> OffspringFilterStatistics
+    {
+        OffspringFilterStatistics stats;
+        stats.Checked = checked_.load(std::memory_order_relaxed);
+        stats.Oversized = oversized_.load(std::memory_order_relaxed);
+        stats.Tarpeian = tarpeian_.load(std::memory_order_relaxed);
+        stats.Clones = clones_.load(std::memory_order_relaxed);
+        stats.Forced = forced_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+} // namespace Operon
@@ -2,57 +2,177 @@
 // SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
 
 #include "operon/operators/generator.hpp"
+#include "operon/core/instrumentation.hpp"
 #include "operon/core/comparison.hpp"
 
 namespace Operon {
 
-    auto OffspringSelectionGenerator::operator()(Operon::RandomGenerator& random, double pCrossover, double pMutation, Operon::Span<Operon::Scalar> buf) const -> std::optional<Individual>
+    auto OffspringSelectionGenerator::Generate(Operon::RandomGenerator& random, double pCrossover, double pMutation, Operon::Span<Operon::Scalar> buf, Individual& slot) const -> bool
     {
-        std::uniform_real_distribution<double> uniformReal;
-        bool doCrossover = uniformReal(random) < pCrossover;
-        bool doMutation = uniformReal(random) < pMutation;
+        if (exhausted_.load(std::memory_order_relaxed)) {
+            return false;
+        }
+
+        bool doCrossover = Random::Real<double>(random) < pCrossover;
+        bool doMutation = Random::Real<double>(random) < pMutation;
 
         if (!(doCrossover || doMutation)) {
-            return std::nullopt;
+            return false;
+        }
+
+        // claim an attempt, the generation stops once they are exhausted
+        if (attempts_.fetch_add(1, std::memory_order_relaxed) >= maxAttempts_) {
+            exhausted_.store(true, std::memory_order_relaxed);
+            return false;
         }
 
         auto population = FemaleSelector().Population();
 
         size_t first = FemaleSelector()(random);
 
+        // the parents are referenced by index, only their fitness is needed for the acceptance threshold
+        auto const& p1 = population[first].Fitness;
+        Operon::FitnessVector const* p2 { nullptr };
 
-        std::optional<Individual> p1{ population[first] };
-        std::optional<Individual> p2;
-
-        Individual child(p1.value().Fitness.size());
+        // the child is built in the slot
+        auto& child = slot;
+        child.Rank = 0;
+        child.Distance = 0;
 
         if (doCrossover) {
             auto second = MaleSelector()(random);
+            Instrumentation::ScopedTimer timer(Instrumentation::Operator::Crossover);
             child.Genotype = Crossover()(random, population[first].Genotype, population[second].Genotype);
-            p2 = population[second];
+            p2 = &population[second].Fitness;
         }
 
         if (doMutation) {
+            Instrumentation::ScopedTimer timer(Instrumentation::Operator::Mutation);
             child.Genotype = doCrossover
                 ? Mutator()(random, std::move(child.Genotype))
-                : Mutator()(random, population[first].Genotype);
+                : Mutator()(random, NodePool::Copy(population[first].Genotype));
         }
 
-        child.Fitness = Evaluator()(random, child, buf);
-        bool accept{false};
+        // the attempts ran out while the child was varied, the generation is over
+        if (exhausted_.load(std::memory_order_relaxed)) {
+            cancelled_.fetch_add(1, std::memory_order_relaxed);
+            NodePool::Release(std::move(child.Genotype));
+            return false;
+        }
 
-        if (p2.has_value()) {
-            Individual q(child.Size());
-            for (size_t i = 0; i < child.Size(); ++i) {
-                auto f1 = p1.value()[i];
-                auto f2 = p2.value()[i];
-                q[i] = std::max(f1, f2) - static_cast<Operon::Scalar>(comparisonFactor_) * std::abs(f1 - f2);
-                accept = Operon::ParetoDominance{}(child.Fitness, q.Fitness) != Dominance::Right;
+        // the filtered child used its attempt without an evaluation
+        if (!Admit(random, child)) {
+            return false;
+        }
+
+        // the quota of successful children is met, the remaining slots take the children as they come
+        if (accepted_.load(std::memory_order_relaxed) >= quota_) {
+            Evaluate(random, child, buf);
+            lucky_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        // the child clearly worse than the population (as predicted by the surrogate) is not evaluated
+        auto const parentFitness = p2 != nullptr ? (p1[0] + (*p2)[0]) / 2 : p1[0];
+        std::optional<SurrogateModel::FeatureVector> features;
+        if (!Predict(child, parentFitness, features)) {
+            predicted_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        // the child is compared with its parents only if the screening promotes it
+        if (auto const* screening = Screening(); screening != nullptr && !screening->Promote(child)) {
+            screened_.fetch_add(1, std::memory_order_relaxed);
+            NodePool::Release(std::move(child.Genotype));
+            return false;
+        }
+
+        // for a single objective we know the acceptance threshold in advance and the evaluator can stop early
+        if (p1.size() == 1) {
+            auto f1 = p1[0];
+            auto cutoff = f1;
+            if (p2 != nullptr) {
+                auto f2 = (*p2)[0];
+                cutoff = std::max(f1, f2) - static_cast<Operon::Scalar>(comparisonFactor_) * std::abs(f1 - f2);
             }
+            child.Fitness = Evaluator().Evaluate(random, child, buf, cutoff);
         } else {
-            accept = Operon::ParetoDominance{}(child.Fitness, p1.value().Fitness) != Dominance::Right;
+            child.Fitness = Evaluator()(random, child, buf);
+        }
+        Learn(features, child);
+        auto const m = child.Size();
+        Operon::FitnessVector q;
+        if (p2 != nullptr) {
+            q.resize(m);
+            for (size_t i = 0; i < m; ++i) {
+                auto f1 = p1[i];
+                auto f2 = (*p2)[i];
+                q[i] = std::max(f1, f2) - static_cast<Operon::Scalar>(comparisonFactor_) * std::abs(f1 - f2);
+            }
+        }
+        auto const* threshold = p2 != nullptr ? q.data() : p1.data();
+        bool accept = Operon::DispatchObjectives(m, [&](auto k) {
+            return Operon::ParetoDominance{}.Compare<decltype(k)::value>(child.Fitness.data(), threshold, m, Operon::Scalar{0});
+        }) != Dominance::Right;
+        if (!accept) {
+            rejected_.fetch_add(1, std::memory_order_relaxed);
+            NodePool::Release(std::move(child.Genotype));
+            return false;
+        }
+        accepted_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void OffspringSelectionGenerator::Prepare(const Operon::Span<const Individual> pop) const
+    {
+        OffspringGeneratorBase::Prepare(pop);
+        Reset(pop.size());
+    }
+
+    void OffspringSelectionGenerator::Prepare(tf::Subflow& subflow, Operon::Span<Individual const> pop) const
+    {
+        // the counters are not used by the preparation of the operators
+        OffspringGeneratorBase::Prepare(subflow, pop);
+        Reset(pop.size());
+    }
+
+    void OffspringSelectionGenerator::Reset(size_t size) const
+    {
+        last_ = Statistics();
+
+        size_ = size;
+        maxAttempts_ = maxSelectionPressure_ * size_;
+        quota_ = static_cast<size_t>(std::ceil(successRatio_ * static_cast<double>(size_)));
+        attempts_.store(0, std::memory_order_relaxed);
+        accepted_.store(0, std::memory_order_relaxed);
+        lucky_.store(0, std::memory_order_relaxed);
+        rejected_.store(0, std::memory_order_relaxed);
+        cancelled_.store(0, std::memory_order_relaxed);
+        screened_.store(0, std::memory_order_relaxed);
+        predicted_.store(0, std::memory_order_relaxed);
+        exhausted_.store(false, std::memory_order_relaxed);
+    }
+
+    auto OffspringSelectionGenerator::Statistics() const -> OffspringSelectionStatistics
+    {
+        OffspringSelectionStatistics stats;
+        stats.Attempts = std::min(attempts_.load(std::memory_order_relaxed), maxAttempts_);
+        stats.Accepted = accepted_.load(std::memory_order_relaxed);
+        stats.Lucky = lucky_.load(std::memory_order_relaxed);
+        stats.Rejected = rejected_.load(std::memory_order_relaxed);
+        stats.Cancelled = cancelled_.load(std::memory_order_relaxed);
+        stats.Screened = screened_.load(std::memory_order_relaxed);
+        stats.Predicted = predicted_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    auto OffspringSelectionGenerator::operator()(Operon::RandomGenerator& random, double pCrossover, double pMutation, Operon::Span<Operon::Scalar> buf) const -> std::optional<Individual>
+    {
+        Individual child;
+        if (!Generate(random, pCrossover, pMutation, buf, child)) {
+            return std::nullopt;
         }
-        return accept ? std::make_optional(child) : std::nullopt;
+        return std::make_optional(std::move(child));
     }
 
 } // namespace Operon
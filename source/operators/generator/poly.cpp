@@ -1,55 +1,85 @@
 // SPDX-License-Identifier: MIT
 // SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
 
+#include <algorithm>
+#include <vector>
+
 #include "operon/operators/generator.hpp"
+#include "operon/core/instrumentation.hpp"
 #include "operon/operators/non_dominated_sorter.hpp"
 
 namespace Operon {
-    auto PolygenicOffspringGenerator::operator()(Operon::RandomGenerator& random, double pCrossover, double pMutation, Operon::Span<Operon::Scalar> buf) const -> std::optional<Individual>
+    auto PolygenicOffspringGenerator::Generate(Operon::RandomGenerator& random, double pCrossover, double pMutation, Operon::Span<Operon::Scalar> buf, Individual& slot) const -> bool
     {
-        std::uniform_real_distribution<double> uniformReal;
         auto population = FemaleSelector().Population();
 
-        // assuming the basic generator never fails
-        auto makeOffspring = [&]() {
-            auto first = FemaleSelector()(random);
-            auto second = MaleSelector()(random);
+        // the parents of the whole brood are drawn in two batches, so that the selectors run their tournaments back to back
+        std::vector<size_t> parents(2 * broodSize_);
+        Operon::Span<size_t> females{parents.data(), broodSize_};
+        Operon::Span<size_t> males{parents.data() + broodSize_, broodSize_};
+        FemaleSelector().Select(random, females);
+        MaleSelector().Select(random, males);
+
+        // assuming the variation never fails (the filter may reject the child)
+        auto makeOffspring = [&](size_t i) {
+            auto first = females[i];
+            auto second = males[i];
             Individual child(population[first].Fitness.size());
-            bool doCrossover = std::bernoulli_distribution(pCrossover)(random);
-            bool doMutation = std::bernoulli_distribution(pMutation)(random);
+            bool doCrossover = Random::Real<double>(random) < pCrossover;
+            bool doMutation = Random::Real<double>(random) < pMutation;
 
             if (doCrossover) {
+                Instrumentation::ScopedTimer timer(Instrumentation::Operator::Crossover);
                 child.Genotype = Crossover()(random, population[first].Genotype, population[second].Genotype);
             }
 
             if (doMutation) {
+                Instrumentation::ScopedTimer timer(Instrumentation::Operator::Mutation);
                 child.Genotype = doCrossover
                     ? Mutator()(random, std::move(child.Genotype))
-                    : Mutator()(random, population[first].Genotype);
+                    : Mutator()(random, NodePool::Copy(population[first].Genotype));
             }
 
-            auto f = Evaluator()(random, child, buf);
-            for (size_t i = 0; i < f.size(); ++i) {
-                child[i] = std::isfinite(f[i]) ? f[i] : std::numeric_limits<Operon::Scalar>::max();
-            }
+            if (child.Genotype.Length() == 0 || !Admit(random, child)) { return child; } // left empty, not evaluated
+            Evaluate(random, child, buf);
             return child;
         };
 
         std::vector<Individual> offspring;
         offspring.reserve(broodSize_);
         for (size_t i = 0; i < broodSize_; ++i) {
-            offspring.push_back(makeOffspring());
+            offspring.push_back(makeOffspring(i));
         }
+        // the children without variation or rejected by the filter are dropped
+        offspring.erase(std::remove_if(offspring.begin(), offspring.end(), [](auto const& child) { return child.Genotype.Length() == 0; }), offspring.end());
+        if (offspring.empty()) { return false; }
+
         SingleObjectiveComparison comp{0};
 
+        size_t best{0};
         if (population.front().Size() > 1) {
             std::stable_sort(offspring.begin(), offspring.end(), LexicographicalComparison{});
             auto fronts = RankIntersectSorter{}(offspring);
-            auto best = *std::min_element(fronts[0].begin(), fronts[0].end(), [&](auto i, auto j) { return comp(offspring[i], offspring[j]); });
-            return std::make_optional(offspring[best]);
+            best = *std::min_element(fronts[0].begin(), fronts[0].end(), [&](auto i, auto j) { return comp(offspring[i], offspring[j]); });
+        } else {
+            best = static_cast<size_t>(std::distance(offspring.begin(), std::min_element(offspring.begin(), offspring.end(), comp)));
+        }
+
+        // the best child is moved into the slot, the nodes of the others go back to the pool
+        for (size_t i = 0; i < offspring.size(); ++i) {
+            if (i != best) { NodePool::Release(std::move(offspring[i].Genotype)); }
+        }
+        slot = std::move(offspring[best]);
+        return true;
+    }
+
+    auto PolygenicOffspringGenerator::operator()(Operon::RandomGenerator& random, double pCrossover, double pMutation, Operon::Span<Operon::Scalar> buf) const -> std::optional<Individual>
+    {
+        Individual child;
+        if (!Generate(random, pCrossover, pMutation, buf, child)) {
+            return std::nullopt;
         }
-        auto best = *std::min_element(offspring.begin(), offspring.end(), comp);
-        return std::make_optional(best);
+        return std::make_optional(std::move(child));
     }
 
 } // namespace Operon
@@ -2,6 +2,7 @@
 // SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
 
 #include "operon/operators/mutation.hpp"
+#include "operon/core/node_pool.hpp"
 #include "operon/core/variable.hpp"
 #include "operon/operators/creator.hpp"
 #include "operon/operators/initializer.hpp"
@@ -9,6 +10,22 @@
 
 namespace Operon {
 
+namespace {
+    // replaces nodes[start, start + length) with the branch, moving the nodes after the block only once
+    void Splice(Operon::Vector<Node>& nodes, size_t start, size_t length, Operon::Span<Node const> branch)
+    {
+        using Signed = std::make_signed_t<size_t>;
+        auto const common = std::min(length, branch.size());
+        auto pos = nodes.begin() + static_cast<Signed>(start);
+        std::copy_n(branch.begin(), common, pos);
+        if (branch.size() > length) {
+            nodes.insert(pos + static_cast<Signed>(common), branch.begin() + static_cast<Signed>(common), branch.end());
+        } else {
+            nodes.erase(pos + static_cast<Signed>(common), pos + static_cast<Signed>(length));
+        }
+    }
+} // namespace
+
 auto DiscretePointMutation::operator()(Operon::RandomGenerator& random, Tree tree) const -> Tree
 {
     auto& nodes = tree.Nodes();
@@ -16,7 +33,7 @@ auto DiscretePointMutation::operator()(Operon::RandomGenerator& random, Tree tre
     ENSURE(it < nodes.end());
 
     auto s = std::reduce(weights_.cbegin(), weights_.cend(), Operon::Scalar { 0 }, std::plus {});
-    auto r = std::uniform_real_distribution<Operon::Scalar>(0., s)(random);
+    auto r = Random::Uniform(random, Operon::Scalar { 0 }, s);
 
     Operon::Scalar c { 0 };
     for (auto i = 0UL; i < weights_.size(); ++i) {
@@ -32,17 +49,7 @@ auto DiscretePointMutation::operator()(Operon::RandomGenerator& random, Tree tre
 
 auto MultiMutation::operator()(Operon::RandomGenerator& random, Tree tree) const -> Tree
 {
-    auto sum = std::reduce(probabilities_.begin(), probabilities_.end());
-    auto r = std::uniform_real_distribution<double>(0, sum)(random);
-    auto c = 0.0;
-    auto i = 0U;
-    for (; i < probabilities_.size(); ++i) {
-        c += probabilities_[i];
-        if (c > r) {
-            break;
-        }
-    }
-    auto op = operators_[i];
+    auto op = operators_[table_(random)];
     return op(random, std::move(tree));
 }
 
@@ -80,7 +87,7 @@ auto ReplaceSubtreeMutation::operator()(Operon::RandomGenerator& random, Tree tr
 {
     auto& nodes = tree.Nodes();
 
-    auto i = std::uniform_int_distribution<size_t>(0, nodes.size() - 1)(random);
+    auto i = Random::Bounded(random, nodes.size());
 
     auto oldLen = nodes[i].Length + 1U;
     auto oldLevel = nodes[i].Level;
@@ -96,19 +103,16 @@ auto ReplaceSubtreeMutation::operator()(Operon::RandomGenerator& random, Tree tr
 
     auto maxDepth = std::max(tree.Depth(), maxDepth_) - oldLevel + 1;
 
-    auto newLen = std::uniform_int_distribution<Signed>(Signed { 1 }, maxLength)(random);
+    auto newLen = Random::Uniform(random, Signed { 1 }, maxLength);
     auto subtree = creator_(random, static_cast<size_t>(newLen), 1, maxDepth);
     coefficientInitializer_(random, subtree);
 
-    Operon::Vector<Node> mutated;
-    mutated.reserve(nodes.size() - oldLen + static_cast<size_t>(newLen));
-
-    using Signed = std::make_signed_t<size_t>;
-    std::copy(nodes.begin(), nodes.begin() + static_cast<Signed>(i - nodes[i].Length), std::back_inserter(mutated));
-    std::copy(subtree.Nodes().begin(), subtree.Nodes().end(), std::back_inserter(mutated));
-    std::copy(nodes.begin() + static_cast<Signed>(i + 1), nodes.end(), std::back_inserter(mutated));
+    auto const start = i - nodes[i].Length;
+    auto const subtreeLength = subtree.Length();
+    Splice(nodes, start, oldLen, subtree.Nodes());
+    NodePool::Release(std::move(subtree));
 
-    return Tree(mutated).UpdateNodes();
+    return tree.UpdateNodes(start, oldLen, subtreeLength);
 }
 
 auto RemoveSubtreeMutation::operator()(Operon::RandomGenerator& random, Tree tree) const -> Tree
@@ -123,8 +127,10 @@ auto RemoveSubtreeMutation::operator()(Operon::RandomGenerator& random, Tree tre
     auto const& p = nodes[it->Parent];
     if (p.Arity > pset_.MinimumArity(p.HashValue)) {
         nodes[it->Parent].Arity--;
+        auto const start = static_cast<size_t>(std::distance(nodes.begin(), it)) - it->Length;
+        auto const length = it->Length + 1UL;
         nodes.erase(it - it->Length, it + 1);
-        tree.UpdateNodes();
+        tree.UpdateNodes(start, length, 0);
     }
     return tree;
 }
@@ -150,7 +156,7 @@ auto InsertSubtreeMutation::operator()(Operon::RandomGenerator& random, Tree tre
         return tree;
     }
 
-    auto index = std::uniform_int_distribution<decltype(n)>(1, n)(random);
+    auto index = Random::Uniform(random, decltype(n) { 1 }, n);
     size_t i = 0;
     for (; i < nodes.size(); ++i) {
         if (test(nodes[i]) && --index == 0) {
@@ -164,24 +170,19 @@ auto InsertSubtreeMutation::operator()(Operon::RandomGenerator& random, Tree tre
     auto availableDepth = std::max(tree.Depth(), maxDepth_) - nodes[i].Level;
     EXPECT(availableDepth > 0);
 
-    auto newLen = std::uniform_int_distribution<size_t>(1, availableLength)(random);
+    auto newLen = Random::Uniform(random, size_t { 1 }, availableLength);
 
     auto subtree = creator_(random, newLen, 1, availableDepth);
     coefficientInitializer_(random, subtree);
 
-    Operon::Vector<Node> mutated;
-    mutated.reserve(nodes.size() + newLen);
-
     // increase parent arity
     nodes[i].Arity++;
 
-    using Signed = std::make_signed_t<size_t>;
-    // copy nodes
-    std::copy(nodes.begin(), nodes.begin() + static_cast<Signed>(i - nodes[i].Length), std::back_inserter(mutated));
-    std::copy(subtree.Nodes().begin(), subtree.Nodes().end(), std::back_inserter(mutated));
-    std::copy(nodes.begin() + static_cast<Signed>(i - nodes[i].Length), nodes.end(), std::back_inserter(mutated));
+    // insert the new subtree as the last argument of the parent
+    Splice(nodes, i - nodes[i].Length, 0, subtree.Nodes());
+    NodePool::Release(std::move(subtree));
 
-    return Tree(mutated).UpdateNodes();
+    return tree.UpdateNodes();
 }
 
 auto ShuffleSubtreesMutation::operator()(Operon::RandomGenerator& random, Tree tree) const -> Tree
@@ -194,7 +195,7 @@ auto ShuffleSubtreesMutation::operator()(Operon::RandomGenerator& random, Tree t
     }
 
     // pick a random function node
-    auto idx = std::uniform_int_distribution<std::make_signed_t<size_t>>(1, nFunc)(random);
+    auto idx = Random::Uniform(random, decltype(nFunc) { 1 }, nFunc);
 
     // find the function node in the nodes array
     size_t i = 0;
@@ -5,28 +5,30 @@
 #include "operon/core/individual.hpp"
 
 namespace Operon {
-
-    auto DeductiveSorter::Sort(Operon::Span<Operon::Individual const> pop, Operon::Scalar eps) const -> NondominatedSorterBase::Result
+namespace {
+    // row(i) points to the m objectives of individual i
+    template <typename Row, typename Statistics>
+    auto DeductiveSort(size_t size, size_t m, Row&& row, Operon::Scalar eps, Statistics& stats) -> NondominatedSorterBase::Result
     {
         size_t n = 0; // total number of sorted solutions
         std::vector<std::vector<size_t>> fronts;
-        std::vector<bool> dominated(pop.size(), false);
-        std::vector<bool> sorted(pop.size(), false);
+        std::vector<bool> dominated(size, false);
+        std::vector<bool> sorted(size, false);
         auto dominatedOrSorted = [&](size_t i) { return sorted[i] || dominated[i]; };
 
-        while (n < pop.size()) {
+        while (n < size) {
             std::vector<size_t> front;
 
-            for (size_t i = 0; i < pop.size(); ++i) {
-                ++Stats.InnerOps;
+            for (size_t i = 0; i < size; ++i) {
+                ++stats.InnerOps;
                 if (!dominatedOrSorted(i)) {
-                    for (size_t j = i + 1; j < pop.size(); ++j) {
-                        ++Stats.InnerOps;
+                    for (size_t j = i + 1; j < size; ++j) {
+                        ++stats.InnerOps;
                         if (!dominatedOrSorted(j)) {
-                            ++Stats.DominanceComparisons;
-                            auto const& lhs = pop[i];
-                            auto const& rhs = pop[j];
-                            auto res = ParetoDominance{}(lhs.Fitness, rhs.Fitness, eps);
+                            ++stats.DominanceComparisons;
+                            auto const* lhs = row(i);
+                            auto const* rhs = row(j);
+                            auto res = ParetoDominance{}(lhs, lhs + m, rhs, rhs + m, eps);
 
                             dominated[i] = (res == Dominance::Right);
                             dominated[j] = (res == Dominance::Left);
@@ -49,5 +51,17 @@ namespace Operon {
         }
         return fronts;
     }
+} // namespace
+
+    auto DeductiveSorter::Sort(Operon::Span<Operon::Individual const> pop, Operon::Scalar eps) const -> NondominatedSorterBase::Result
+    {
+        if (pop.empty()) { return {}; }
+        return DeductiveSort(pop.size(), pop.front().Size(), [&](size_t i) { return pop[i].Fitness.data(); }, eps, Stats);
+    }
+
+    auto DeductiveSorter::Sort(Operon::Span<Operon::Scalar const> fitness, size_t m, Operon::Scalar eps) const -> NondominatedSorterBase::Result
+    {
+        return DeductiveSort(fitness.size() / m, m, [&](size_t i) { return fitness.data() + i * m; }, eps, Stats);
+    }
 
 }
@@ -10,14 +10,15 @@ namespace Operon {
     using Vec = Eigen::Matrix<int64_t, -1, 1, Eigen::ColMajor>;
     using Mat = Eigen::Matrix<int64_t, -1, -1, Eigen::ColMajor>;
 
-    inline auto ComputeComparisonMatrix(Operon::Span<Operon::Individual const> pop, Mat const& idx, Eigen::Index colIdx) noexcept
+    // get(i, k) returns objective k of individual i
+    template <typename Get>
+    inline auto ComputeComparisonMatrix(Eigen::Index n, Get const& get, Mat const& idx, Eigen::Index colIdx) noexcept
     {
-        auto const n = static_cast<Eigen::Index>(pop.size());
         Mat c = Mat::Zero(n, n);
         Mat::ConstColXpr b = idx.col(colIdx);
         c.row(b(0)).fill(1); // NOLINT
         for (auto i = 1; i < n; ++i) {
-            if (pop[b(i)][colIdx] == pop[b(i-1)][colIdx]) {
+            if (get(b(i), colIdx) == get(b(i-1), colIdx)) {
                 c.row(b(i)) = c.row(b(i-1));
             } else {
                 for (auto j = i; j < n; ++j) {
@@ -28,19 +29,19 @@ namespace Operon {
         return c;
     }
 
-    inline auto ComparisonMatrixSum(Operon::Span<Operon::Individual const> pop, Mat const& idx) noexcept {
-        Mat d = ComputeComparisonMatrix(pop, idx, 0);
+    template <typename Get>
+    inline auto ComparisonMatrixSum(Eigen::Index n, Get const& get, Mat const& idx) noexcept {
+        Mat d = ComputeComparisonMatrix(n, get, idx, 0);
         for (int i = 1; i < idx.cols(); ++i) {
-            d.noalias() += ComputeComparisonMatrix(pop, idx, i);
+            d.noalias() += ComputeComparisonMatrix(n, get, idx, i);
         }
         return d;
     }
 
-    inline auto ComputeDegreeMatrix(Operon::Span<Operon::Individual const> pop, Mat const& idx) noexcept
+    template <typename Get>
+    inline auto ComputeDegreeMatrix(Eigen::Index n, Eigen::Index m, Get const& get, Mat const& idx) noexcept
     {
-        auto const n = static_cast<Eigen::Index>(pop.size());
-        auto const m = static_cast<Eigen::Index>(pop.front().Fitness.size());
-        Mat d = ComparisonMatrixSum(pop, idx);
+        Mat d = ComparisonMatrixSum(n, get, idx);
         for (auto i = 0; i < n; ++i) {
             for (auto j = i; j < n; ++j) {
                 if (d(i, j) == m && d(j, i) == m) {
@@ -52,18 +53,16 @@ namespace Operon {
     }
 
 
-    auto DominanceDegreeSorter::Sort(Operon::Span<Operon::Individual const> pop, Operon::Scalar eps) const -> NondominatedSorterBase::Result
+    template <typename Get>
+    auto DominanceDegree(Eigen::Index n, Eigen::Index m, Get const& get, Operon::Scalar eps) -> NondominatedSorterBase::Result
     {
-        auto const n = static_cast<Eigen::Index>(pop.size());
-        auto const m = static_cast<Eigen::Index>(pop.front().Fitness.size());
-
         Operon::Less cmp;
         Mat idx = Vec::LinSpaced(n, 0, n-1).replicate(1, m);
         for (auto i = 0; i < m; ++i) {
             auto *data = idx.col(i).data();
-            std::sort(data, data + n, [&](auto a, auto b) { return cmp(pop[a][i], pop[b][i], eps); });
+            std::sort(data, data + n, [&](auto a, auto b) { return cmp(get(a, i), get(b, i), eps); });
         }
-        Mat d = ComputeDegreeMatrix(pop, idx);
+        Mat d = ComputeDegreeMatrix(n, m, get, idx);
         auto count = 0L; // number of assigned solutions
         std::vector<std::vector<size_t>> fronts;
         std::vector<size_t> tmp(n);
@@ -86,4 +85,17 @@ namespace Operon {
         }
         return fronts;
     }
+
+    auto DominanceDegreeSorter::Sort(Operon::Span<Operon::Individual const> pop, Operon::Scalar eps) const -> NondominatedSorterBase::Result
+    {
+        auto const n = static_cast<Eigen::Index>(pop.size());
+        auto const m = static_cast<Eigen::Index>(pop.front().Fitness.size());
+        return DominanceDegree(n, m, [&](auto i, auto k) { return pop[i][k]; }, eps);
+    }
+
+    auto DominanceDegreeSorter::Sort(Operon::Span<Operon::Scalar const> fitness, size_t m, Operon::Scalar eps) const -> NondominatedSorterBase::Result
+    {
+        auto const n = static_cast<Eigen::Index>(fitness.size() / m);
+        return DominanceDegree(n, static_cast<Eigen::Index>(m), [&, m](auto i, auto k) { return fitness[static_cast<size_t>(i) * m + static_cast<size_t>(k)]; }, eps);
+    }
 } // namespace Operon
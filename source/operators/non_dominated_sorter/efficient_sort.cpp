@@ -6,18 +6,19 @@
 
 namespace Operon {
 
-    template<EfficientSortStrategy SearchStrategy>
-    inline auto EfficientSortImpl(Operon::Span<Operon::Individual const> pop, Operon::Scalar eps) -> NondominatedSorterBase::Result
+    // row(i) points to the m objectives of individual i
+    template<EfficientSortStrategy SearchStrategy, size_t M, typename Row>
+    inline auto EfficientSortImpl(size_t n, size_t m, Row const& row, Operon::Scalar eps) -> NondominatedSorterBase::Result
     {
         // check if individual i is dominated by any individual in the front f
         auto dominated = [&](auto const& f, size_t i) {
             return std::any_of(f.rbegin(), f.rend(), [&](size_t j) {
-                return ParetoDominance{}(pop[j].Fitness, pop[i].Fitness, eps) == Dominance::Left;
+                return ParetoDominance{}.Compare<M>(row(j), row(i), m, eps) == Dominance::Left;
             });
         };
 
         std::vector<std::vector<size_t>> fronts;
-        for (size_t i = 0; i < pop.size(); ++i) {
+        for (size_t i = 0; i < n; ++i) {
             decltype(fronts)::iterator it;
             if constexpr (SearchStrategy == EfficientSortStrategy::Binary) { // binary search
                 it = std::partition_point(fronts.begin(), fronts.end(),
@@ -35,13 +36,45 @@ namespace Operon {
         return fronts;
     }
 
+    template<EfficientSortStrategy SearchStrategy, typename Row>
+    inline auto EfficientSortImpl(size_t n, size_t m, Row const& row, Operon::Scalar eps) -> NondominatedSorterBase::Result
+    {
+        if (n == 0) { return {}; }
+        return DispatchObjectives(m, [&](auto k) {
+            return EfficientSortImpl<SearchStrategy, decltype(k)::value>(n, m, row, eps);
+        });
+    }
+
+    template<EfficientSortStrategy SearchStrategy>
+    inline auto EfficientSortImpl(Operon::Span<Operon::Individual const> pop, Operon::Scalar eps) -> NondominatedSorterBase::Result
+    {
+        if (pop.empty()) { return {}; }
+        return EfficientSortImpl<SearchStrategy>(pop.size(), pop.front().Size(), [&](size_t i) { return pop[i].Fitness.data(); }, eps);
+    }
+
+    template<EfficientSortStrategy SearchStrategy>
+    inline auto EfficientSortImpl(Operon::Span<Operon::Scalar const> fitness, size_t m, Operon::Scalar eps) -> NondominatedSorterBase::Result
+    {
+        return EfficientSortImpl<SearchStrategy>(fitness.size() / m, m, [&](size_t i) { return fitness.data() + i * m; }, eps);
+    }
+
     auto EfficientBinarySorter::Sort(Operon::Span<Operon::Individual const> pop, Operon::Scalar eps) const -> NondominatedSorterBase::Result
     {
         return EfficientSortImpl<EfficientSortStrategy::Binary>(pop, eps);
     }
 
+    auto EfficientBinarySorter::Sort(Operon::Span<Operon::Scalar const> fitness, size_t m, Operon::Scalar eps) const -> NondominatedSorterBase::Result
+    {
+        return EfficientSortImpl<EfficientSortStrategy::Binary>(fitness, m, eps);
+    }
+
     auto EfficientSequentialSorter::Sort(Operon::Span<Operon::Individual const> pop, Operon::Scalar eps) const -> NondominatedSorterBase::Result
     {
         return EfficientSortImpl<EfficientSortStrategy::Sequential>(pop, eps);
     }
+
+    auto EfficientSequentialSorter::Sort(Operon::Span<Operon::Scalar const> fitness, size_t m, Operon::Scalar eps) const -> NondominatedSorterBase::Result
+    {
+        return EfficientSortImpl<EfficientSortStrategy::Sequential>(fitness, m, eps);
+    }
 } // namespace Operon
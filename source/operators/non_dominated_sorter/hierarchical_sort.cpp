@@ -7,17 +7,19 @@
 #include "operon/core/individual.hpp"
 
 namespace Operon {
-    auto
-    HierarchicalSorter::Sort(Operon::Span<Operon::Individual const> pop, Operon::Scalar eps) const -> NondominatedSorterBase::Result
+namespace {
+    // row(i) points to the m objectives of individual i
+    template <typename Row, typename Statistics>
+    auto HierarchicalSort(size_t n, size_t m, Row&& row, Operon::Scalar eps, Statistics& stats) -> NondominatedSorterBase::Result
     {
-        std::deque<size_t> q(pop.size());
+        std::deque<size_t> q(n);
         std::iota(q.begin(), q.end(), 0UL);
         std::vector<size_t> dominated;
-        dominated.reserve(pop.size());
+        dominated.reserve(n);
 
         std::vector<std::vector<size_t>> fronts;
         while (!q.empty()) {
-            ++Stats.InnerOps;
+            ++stats.InnerOps;
             std::vector<size_t> front;
 
             while (!q.empty()) {
@@ -26,7 +28,7 @@ namespace Operon {
                 auto nonDominatedCount = 0UL;
                 while (q.size() > nonDominatedCount) {
                     auto qj = q.front(); q.pop_front();
-                    if (ParetoDominance{}(pop[q1].Fitness, pop[qj].Fitness, eps) == Dominance::None) {
+                    if (ParetoDominance{}(row(q1), row(q1) + m, row(qj), row(qj) + m, eps) == Dominance::None) {
                         q.push_back(qj);
                         ++nonDominatedCount;
                     } else {
@@ -38,10 +40,23 @@ namespace Operon {
             dominated.clear();
             fronts.push_back(front);
 
-            std::stable_sort(q.begin(), q.end(), [&](auto  a, auto b) { return LexicographicalComparison{}(pop[a], pop[b]); });
+            std::stable_sort(q.begin(), q.end(), [&](auto  a, auto b) { return Less{}(row(a), row(a) + m, row(b), row(b) + m); });
         }
         return fronts;
     }
+} // namespace
 
-} // namespace Operon
+    auto
+    HierarchicalSorter::Sort(Operon::Span<Operon::Individual const> pop, Operon::Scalar eps) const -> NondominatedSorterBase::Result
+    {
+        if (pop.empty()) { return {}; }
+        return HierarchicalSort(pop.size(), pop.front().Size(), [&](size_t i) { return pop[i].Fitness.data(); }, eps, Stats);
+    }
+
+    auto
+    HierarchicalSorter::Sort(Operon::Span<Operon::Scalar const> fitness, size_t m, Operon::Scalar eps) const -> NondominatedSorterBase::Result
+    {
+        return HierarchicalSort(fitness.size() / m, m, [&](size_t i) { return fitness.data() + i * m; }, eps, Stats);
+    }
 
+} // namespace Operon
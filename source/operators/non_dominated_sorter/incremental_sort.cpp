@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <algorithm>
+
+#include "operon/operators/non_dominated_sorter.hpp"
+#include "operon/core/individual.hpp"
+
+namespace Operon {
+    namespace {
+        template <size_t N>
+        struct Rows {
+            Operon::Span<Operon::Scalar const> Fitness;
+            size_t M;
+            Operon::Scalar Eps;
+
+            [[nodiscard]] auto Row(size_t i) const { return Fitness.data() + i * M; }
+
+            // row j dominates row i
+            [[nodiscard]] auto Dominates(size_t j, size_t i) const -> bool
+            {
+                return ParetoDominance{}.Compare<N>(Row(j), Row(i), M, Eps) == Dominance::Left;
+            }
+
+            [[nodiscard]] auto Equal(size_t j, size_t i) const -> bool
+            {
+                return Operon::Equal{}(Row(j), Row(j) + M, Row(i), Row(i) + M, Eps);
+            }
+        };
+
+        // the first front without a dominator of row i
+        template <typename R>
+        auto FindFront(NondominatedSorterBase::Result const& fronts, R const& rows, size_t i) -> size_t
+        {
+            auto it = std::find_if(fronts.begin(), fronts.end(), [&](auto const& f) {
+                return std::none_of(f.rbegin(), f.rend(), [&](size_t j) { return rows.Dominates(j, i); });
+            });
+            return static_cast<size_t>(std::distance(fronts.begin(), it));
+        }
+
+        // puts row i into front k, the members dominated by row i move down one front, and so on
+        template <typename R>
+        auto InsertAt(NondominatedSorterBase::Result& fronts, R const& rows, size_t k, size_t i) -> void
+        {
+            std::vector<size_t> moved { i };
+            std::vector<size_t> next;
+            for (; k < fronts.size() && !moved.empty(); ++k) {
+                auto& front = fronts[k];
+                auto dominated = std::stable_partition(front.begin(), front.end(), [&](size_t j) {
+                    return std::none_of(moved.begin(), moved.end(), [&](size_t x) { return rows.Dominates(x, j); });
+                });
+                next.assign(dominated, front.end());
+                front.erase(dominated, front.end());
+                front.insert(front.end(), moved.begin(), moved.end());
+                moved.swap(next);
+            }
+            if (!moved.empty()) { fronts.push_back(std::move(moved)); }
+        }
+    } // namespace
+
+    auto IncrementalSorter::Sort(Operon::Span<Operon::Individual const> pop, Operon::Scalar eps) const -> NondominatedSorterBase::Result
+    {
+        if (pop.empty()) { return {}; }
+        auto const m = pop.front().Fitness.size();
+        std::vector<Operon::Scalar> fitness;
+        fitness.reserve(pop.size() * m);
+        for (auto const& ind : pop) {
+            fitness.insert(fitness.end(), ind.Fitness.begin(), ind.Fitness.end());
+        }
+        return Sort(Operon::Span<Operon::Scalar const>(fitness), m, eps);
+    }
+
+    auto IncrementalSorter::Sort(Operon::Span<Operon::Scalar const> fitness, size_t m, Operon::Scalar eps) const -> NondominatedSorterBase::Result
+    {
+        return DispatchObjectives(m, [&](auto k) {
+            Rows<decltype(k)::value> const rows { fitness, m, eps };
+            Result fronts;
+            for (size_t i = 0; i < fitness.size() / m; ++i) {
+                // equal rows are not dominated by each other, so unlike Insert they simply share a front
+                InsertAt(fronts, rows, FindFront(fronts, rows, i), i);
+            }
+            return fronts;
+        });
+    }
+
+    auto IncrementalSorter::Insert(Result& fronts, Operon::Span<Operon::Scalar const> fitness, size_t m, size_t i, Operon::Scalar eps) const -> bool
+    {
+        return DispatchObjectives(m, [&](auto n) {
+            Rows<decltype(n)::value> const rows { fitness, m, eps };
+            auto const k = FindFront(fronts, rows, i);
+            // an equal row has the same dominators, so it can only be found in front k
+            if (k < fronts.size() && std::any_of(fronts[k].begin(), fronts[k].end(), [&](size_t j) { return rows.Equal(j, i); })) {
+                return false;
+            }
+            InsertAt(fronts, rows, k, i);
+            return true;
+        });
+    }
+
+    auto IncrementalSorter::Remove(Result& fronts, Operon::Span<Operon::Scalar const> fitness, size_t m, size_t i, Operon::Scalar eps) const -> void
+    {
+        DispatchObjectives(m, [&](auto n) {
+            Rows<decltype(n)::value> const rows { fitness, m, eps };
+            auto k = fronts.size();
+            for (size_t f = 0; f < fronts.size(); ++f) {
+                if (auto it = std::find(fronts[f].begin(), fronts[f].end(), i); it != fronts[f].end()) {
+                    fronts[f].erase(it);
+                    k = f;
+                    break;
+                }
+            }
+            EXPECT(k < fronts.size());
+
+            // members of the next front that were dominated by a departed row move up if nothing else in front k dominates them
+            std::vector<size_t> departed { i };
+            std::vector<size_t> next;
+            for (; k + 1 < fronts.size() && !departed.empty(); ++k) {
+                auto& front = fronts[k + 1];
+                auto stays = std::stable_partition(front.begin(), front.end(), [&](size_t j) {
+                    return std::any_of(departed.begin(), departed.end(), [&](size_t x) { return rows.Dominates(x, j); })
+                        && std::none_of(fronts[k].begin(), fronts[k].end(), [&](size_t x) { return rows.Dominates(x, j); });
+                });
+                next.assign(front.begin(), stays);
+                front.erase(front.begin(), stays);
+                fronts[k].insert(fronts[k].end(), next.begin(), next.end());
+                departed.swap(next);
+            }
+        });
+        fronts.erase(std::remove_if(fronts.begin(), fronts.end(), [](auto const& f) { return f.empty(); }), fronts.end());
+    }
+} // namespace Operon
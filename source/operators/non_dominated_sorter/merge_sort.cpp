@@ -232,10 +232,10 @@ namespace detail {
 
 } // namespace detail
 
-    auto
-    MergeSorter::Sort(Operon::Span<Operon::Individual const> pop, Operon::Scalar eps) const -> NondominatedSorterBase::Result {
-        auto n = pop.size();
-        auto m = pop.front().Size(); 
+namespace {
+    // row(i) points to the m objectives of individual i
+    template <typename Row>
+    auto MergeSort(size_t n, size_t m, Row&& row, Operon::Scalar eps) -> NondominatedSorterBase::Result {
         detail::BitsetManager bsm(n);
 
         std::vector<int> ranking;
@@ -251,7 +251,7 @@ namespace detail {
 
         for (size_t i = 0; i < n; ++i) {
             population[i].resize(sortIndex + 1);
-            std::copy_n(pop[i].Fitness.begin(), m, population[i].begin());
+            std::copy_n(row(i), m, population[i].begin());
             population[i][solId] = static_cast<Operon::Scalar>(i);
             population[i][sortIndex] = static_cast<Operon::Scalar>(i); // because pop is already sorted when passed to Sort
         }
@@ -311,4 +311,15 @@ namespace detail {
 
         return fronts;
     }
+} // namespace
+
+    auto
+    MergeSorter::Sort(Operon::Span<Operon::Individual const> pop, Operon::Scalar eps) const -> NondominatedSorterBase::Result {
+        return MergeSort(pop.size(), pop.front().Size(), [&](size_t i) { return pop[i].Fitness.data(); }, eps);
+    }
+
+    auto
+    MergeSorter::Sort(Operon::Span<Operon::Scalar const> fitness, size_t m, Operon::Scalar eps) const -> NondominatedSorterBase::Result {
+        return MergeSort(fitness.size() / m, m, [&](size_t i) { return fitness.data() + i * m; }, eps);
+    }
 } // namespace Operon
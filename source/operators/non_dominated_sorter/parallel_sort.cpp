@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <algorithm>
+#include <taskflow/taskflow.hpp>
+#include <thread>
+
+#include "operon/operators/non_dominated_sorter.hpp"
+#include "operon/core/individual.hpp"
+
+namespace Operon {
+    namespace {
+        template <size_t M>
+        auto ParallelSortImpl(tf::Executor& executor, Operon::Span<Operon::Scalar const> fitness, size_t m, size_t minBlockSize, Operon::Scalar eps) -> NondominatedSorterBase::Result
+        {
+            auto const n = fitness.size() / m;
+            auto dominates = [&](size_t j, size_t i) {
+                return ParetoDominance{}.Compare<M>(fitness.data() + j * m, fitness.data() + i * m, m, eps) == Dominance::Left;
+            };
+
+            std::vector<std::vector<size_t>> fronts;
+            std::vector<size_t> rank(n, 0);
+
+            // enough blocks to keep the workers busy, but not so many that the scheduling overhead dominates
+            auto const workers = executor.num_workers();
+            auto const blockSize = std::max(minBlockSize, n / (workers * 16) + 1);
+
+            for (size_t lo = 0; lo < n; lo += blockSize) {
+                auto const hi = std::min(n, lo + blockSize);
+
+                // rank implied by the previous blocks: the highest front containing a dominator, searched top-down
+                if (!fronts.empty()) {
+                    tf::Taskflow taskflow;
+                    taskflow.for_each_index(lo, hi, size_t{1}, [&](size_t i) {
+                        for (auto f = fronts.size(); f > 0; --f) {
+                            auto const& front = fronts[f-1];
+                            if (std::any_of(front.rbegin(), front.rend(), [&](size_t j) { return dominates(j, i); })) {
+                                rank[i] = f;
+                                break;
+                            }
+                        }
+                    });
+                    executor.run(taskflow).wait();
+                }
+
+                // dominators within the block, only those that would increase the rank need to be checked
+                for (auto i = lo; i < hi; ++i) {
+                    for (auto j = lo; j < i; ++j) {
+                        if (rank[j] + 1 > rank[i] && dominates(j, i)) {
+                            rank[i] = rank[j] + 1;
+                        }
+                    }
+                }
+
+                for (auto i = lo; i < hi; ++i) {
+                    if (rank[i] == fronts.size()) { fronts.emplace_back(); }
+                    fronts[rank[i]].push_back(i);
+                }
+            }
+            return fronts;
+        }
+
+        auto ParallelSortImpl(tf::Executor& executor, Operon::Span<Operon::Scalar const> fitness, size_t m, size_t minBlockSize, Operon::Scalar eps) -> NondominatedSorterBase::Result
+        {
+            return DispatchObjectives(m, [&](auto k) { return ParallelSortImpl<decltype(k)::value>(executor, fitness, m, minBlockSize, eps); });
+        }
+    } // namespace
+
+    ParallelSorter::ParallelSorter(size_t threads, size_t minBlockSize)
+        : executor_(std::make_shared<tf::Executor>(std::max(size_t{1}, threads == 0 ? size_t{std::thread::hardware_concurrency()} : threads)))
+        , minBlockSize_(std::max(size_t{1}, minBlockSize))
+    {
+    }
+
+    auto ParallelSorter::Sort(Operon::Span<Operon::Individual const> pop, Operon::Scalar eps) const -> NondominatedSorterBase::Result
+    {
+        if (pop.empty()) { return {}; }
+        auto const m = pop.front().Fitness.size();
+        std::vector<Operon::Scalar> fitness;
+        fitness.reserve(pop.size() * m);
+        for (auto const& ind : pop) {
+            fitness.insert(fitness.end(), ind.Fitness.begin(), ind.Fitness.end());
+        }
+        return ParallelSortImpl(*executor_, Operon::Span<Operon::Scalar const>(fitness), m, minBlockSize_, eps);
+    }
+
+    auto ParallelSorter::Sort(Operon::Span<Operon::Scalar const> fitness, size_t m, Operon::Scalar eps) const -> NondominatedSorterBase::Result
+    {
+        if (fitness.empty()) { return {}; }
+        return ParallelSortImpl(*executor_, fitness, m, minBlockSize_, eps);
+    }
+} // namespace Operon
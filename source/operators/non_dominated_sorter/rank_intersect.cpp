@@ -1,6 +1,9 @@
 // SPDX-License-Identifier: MIT
 // SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
 
+#include <algorithm>
+#include <numeric>
+
 #include "operon/collections/bitset.hpp"
 #include "operon/core/individual.hpp"
 #include "operon/operators/non_dominated_sorter.hpp"
@@ -14,92 +17,232 @@ namespace detail {
     };
 } // namespace detail
 
-auto RankIntersectSorter::Sort(Operon::Span<Operon::Individual const> pop, Operon::Scalar eps) const -> NondominatedSorterBase::Result
-{
-    size_t const n = pop.size();
-    size_t const m = pop.front().Fitness.size();
-
-    using Bitset = Operon::Bitset<uint64_t>;
-
-    Bitset b(n, Bitset::OneBlock);
-    std::vector<Bitset> bs(n); // vector of bitsets (one for each individual)
-    std::vector<std::pair<size_t, size_t>> br(n); // vector of ranges keeping track of the first/last non-zero blocks
-    std::vector<detail::Item<Operon::Scalar>> items(n); // these items hold the values to be sorted along with their associated index
-
-    auto const nb = b.NumBlocks();
-    for (size_t i = 0; i < n; ++i) {
-        items[i].Index = i;
-        b.Reset(i);
-        bs[i] = b;
-        br[i] = { 0, nb - 1 };
-    }
-    std::vector<Bitset> rk; // vector of sets keeping track of individuals whose rank was updated
-    rk.emplace_back(n, Bitset::OneBlock);
+namespace {
+    // get(i, k) returns objective k of individual i
+    template <typename Get>
+    auto RankIntersect(size_t n, size_t m, Get&& get, Operon::Scalar eps) -> NondominatedSorterBase::Result
+    {
+        using Bitset = Operon::Bitset<uint64_t>;
+
+        Bitset b(n, Bitset::OneBlock);
+        std::vector<Bitset> bs(n); // vector of bitsets (one for each individual)
+        std::vector<std::pair<size_t, size_t>> br(n); // vector of ranges keeping track of the first/last non-zero blocks
+        std::vector<detail::Item<Operon::Scalar>> items(n); // these items hold the values to be sorted along with their associated index
+
+        auto const nb = b.NumBlocks();
+        for (size_t i = 0; i < n; ++i) {
+            items[i].Index = i;
+            b.Reset(i);
+            bs[i] = b;
+            br[i] = { 0, nb - 1 };
+        }
+        std::vector<Bitset> rk; // vector of sets keeping track of individuals whose rank was updated
+        rk.emplace_back(n, Bitset::OneBlock);
 
-    std::vector<size_t> rank(n, 0);
+        std::vector<size_t> rank(n, 0);
 
-    auto cmp = [eps](auto a, auto b) { return Operon::Less{}(a.Value, b.Value, eps); };
+        auto cmp = [eps](auto a, auto b) { return Operon::Less{}(a.Value, b.Value, eps); };
+
+        for (size_t k = 1; k < m; ++k) {
+            for (auto& item : items) {
+                item.Value = get(item.Index, k);
+            }
+            std::stable_sort(items.begin(), items.end(), cmp);
+            b.Fill(Bitset::OneBlock);
+
+            for (auto [_, i] : items) {
+                b.Reset(i);
+                auto [lo, hi] = br[i];
+                if (lo > hi) {
+                    continue;
+                }
+
+                auto* p = bs[i].Data();
+                auto const* q = b.Data();
+
+                // tighten the bounds around empty blocks
+                while (lo <= hi && !(p[lo] & q[lo])) {
+                    ++lo;
+                } // NOLINT
+                while (lo <= hi && !(p[hi] & q[hi])) {
+                    --hi;
+                } // NOLINT
+                br[i] = { lo, hi };
+
+                if (k < m - 1) {
+                    // perform the set intersection
+                    for (size_t j = lo; j <= hi; ++j) {
+                        p[j] &= q[j];
+                    }
+                } else {
+                    auto rnk = rank[i];
+                    if (rnk + 1UL == rk.size()) {
+                        rk.emplace_back(n, Bitset::ZeroBlock);
+                    }
+                    auto* r = rk[rnk].Data();
+                    auto* s = rk[rnk + 1].Data();
+
+                    for (size_t j = lo; j <= hi; ++j) {
+                        auto v = p[j] & q[j] & r[j]; // obtain the dominance set
+                        r[j] &= ~v; // remove dominated individuals from current rank set
+                        s[j] |= v; // add the individuals to the next rank set
+
+                        auto o = Bitset::BlockSize * j;
+                        while (v) {
+                            auto x = o + Bitset::CountTrailingZeros(v);
+                            v &= (v - 1);
+                            ++rank[x];
+                        }
+                    }
+                }
+            }
+        }
 
-    for (size_t k = 1; k < m; ++k) {
-        for (auto& item : items) {
-            item.Value = pop[item.Index][k];
+        std::vector<std::vector<size_t>> fronts;
+        fronts.resize(*std::max_element(rank.begin(), rank.end()) + 1);
+        for (size_t i = 0UL; i < n; ++i) {
+            fronts[rank[i]].push_back(i);
+        }
+        return fronts;
+    }
+    template <typename Get>
+    auto RankIntersectMatrix(size_t n, size_t m, Get&& get, Operon::Scalar eps, size_t tileBytes) -> NondominatedSorterBase::Result
+    {
+        using Bitset = Operon::Bitset<uint64_t>;
+        using Matrix = Operon::BitMatrix<uint64_t>;
+        constexpr auto S = Bitset::BlockSize;
+
+        if (m < 2) { // like above, no objective is intersected
+            std::vector<size_t> front(n);
+            std::iota(front.begin(), front.end(), size_t{0});
+            return { front };
         }
-        std::stable_sort(items.begin(), items.end(), cmp);
-        b.Fill(Bitset::OneBlock);
 
-        for (auto [_, i] : items) {
-            b.Reset(i);
-            auto [lo, hi] = br[i];
-            if (lo > hi) {
-                continue;
+        // the orders along the objectives 1..m-1, obtained by the same chain of stable sorts as above: every tile
+        // sweeps them again
+        std::vector<detail::Item<Operon::Scalar>> items(n);
+        for (size_t i = 0; i < n; ++i) { items[i].Index = i; }
+        auto cmp = [eps](auto a, auto b) { return Operon::Less{}(a.Value, b.Value, eps); };
+        std::vector<std::vector<size_t>> orders(m - 1, std::vector<size_t>(n));
+        for (size_t k = 1; k < m; ++k) {
+            for (auto& item : items) {
+                item.Value = get(item.Index, k);
             }
+            std::stable_sort(items.begin(), items.end(), cmp);
+            std::transform(items.begin(), items.end(), orders[k - 1].begin(), [](auto const& item) { return item.Index; });
+        }
 
-            auto* p = bs[i].Data();
-            auto const* q = b.Data();
-
-            // tighten the bounds around empty blocks
-            while (lo <= hi && !(p[lo] & q[lo])) {
-                ++lo;
-            } // NOLINT
-            while (lo <= hi && !(p[hi] & q[hi])) {
-                --hi;
-            } // NOLINT
-            br[i] = { lo, hi };
-
-            if (k < m - 1) {
-                // perform the set intersection
-                for (size_t j = lo; j <= hi; ++j) {
-                    p[j] &= q[j];
+        // rows per tile, a multiple of the block size
+        auto const rowBytes = Matrix::Stride(n) * sizeof(Bitset::Block);
+        auto const tile = std::max(S, tileBytes / rowBytes / S * S);
+
+        Bitset b(n, Bitset::OneBlock);
+        std::vector<Bitset> rk; // vector of sets keeping track of individuals whose rank was updated
+        rk.emplace_back(n, Bitset::OneBlock);
+        std::vector<size_t> rank(n, 0);
+
+        Matrix dominated;
+        std::vector<std::pair<size_t, size_t>> br(std::min(n, tile)); // ranges of the first/last non-zero blocks of the rows
+
+        for (size_t r0 = 0; r0 < n; r0 += tile) {
+            auto const r1 = std::min(n, r0 + tile);
+            auto const c0 = r0 / S; // the first block stored by the rows of this tile
+            dominated.Resize(r1 - r0, n - (c0 * S));
+            auto const nb = dominated.NumBlocks();
+            auto const last = Bitset::OneBlock >> (S * nb - dominated.Cols()); // the bits of the last block below n
+
+            // initially the individuals after i (in lexicographic order) are dominated by i
+            for (size_t i = r0; i < r1; ++i) {
+                auto* p = dominated.Row(i - r0);
+                std::fill_n(p, nb, Bitset::ZeroBlock);
+                auto const lo = i + 1 - (c0 * S);
+                if (lo < dominated.Cols()) {
+                    std::fill(p + (lo / S), p + nb, Bitset::OneBlock);
+                    p[lo / S] &= Bitset::OneBlock << (lo % S);
+                    p[nb - 1] &= last;
                 }
-            } else {
-                auto rnk = rank[i];
-                if (rnk + 1UL == rk.size()) {
-                    rk.emplace_back(n, Bitset::ZeroBlock);
-                }
-                auto* r = rk[rnk].Data();
-                auto* s = rk[rnk + 1].Data();
-
-                for (size_t j = lo; j <= hi; ++j) {
-                    auto v = p[j] & q[j] & r[j]; // obtain the dominance set
-                    r[j] &= ~v; // remove dominated individuals from current rank set
-                    s[j] |= v; // add the individuals to the next rank set
-
-                    auto o = Bitset::BlockSize * j;
-                    while (v) {
-                        auto x = o + Bitset::CountTrailingZeros(v);
-                        v &= (v - 1);
-                        ++rank[x];
+                br[i - r0] = { 0, nb - 1 };
+            }
+
+            for (size_t k = 1; k < m; ++k) {
+                b.Fill(Bitset::OneBlock);
+                auto const* q = b.Data() + c0;
+
+                for (auto i : orders[k - 1]) {
+                    b.Reset(i);
+                    if (i < r0 || i >= r1) {
+                        continue;
+                    }
+                    auto [lo, hi] = br[i - r0];
+                    if (lo > hi) {
+                        continue;
+                    }
+                    auto* p = dominated.Row(i - r0);
+
+                    // tighten the bounds around empty blocks
+                    while (lo <= hi && !(p[lo] & q[lo])) {
+                        ++lo;
+                    } // NOLINT
+                    while (lo <= hi && !(p[hi] & q[hi])) {
+                        --hi;
+                    } // NOLINT
+                    br[i - r0] = { lo, hi };
+
+                    if (k < m - 1) {
+                        if (lo <= hi) { BitOps::Intersect(p + lo, q + lo, hi - lo + 1); }
+                        continue;
+                    }
+
+                    // the rows before this tile have their final rank already, since they cannot be dominated by it
+                    auto rnk = rank[i];
+                    if (rnk + 1UL == rk.size()) {
+                        rk.emplace_back(n, Bitset::ZeroBlock);
+                    }
+                    auto* r = rk[rnk].Data() + c0;
+                    auto* s = rk[rnk + 1].Data() + c0;
+
+                    for (size_t j = lo; j <= hi; ++j) {
+                        auto v = p[j] & q[j] & r[j]; // obtain the dominance set
+                        r[j] &= ~v; // remove dominated individuals from current rank set
+                        s[j] |= v; // add the individuals to the next rank set
+
+                        auto o = S * (c0 + j);
+                        while (v) {
+                            auto x = o + Bitset::CountTrailingZeros(v);
+                            v &= (v - 1);
+                            ++rank[x];
+                        }
                     }
                 }
             }
         }
-    }
 
-    std::vector<std::vector<size_t>> fronts;
-    fronts.resize(*std::max_element(rank.begin(), rank.end()) + 1);
-    for (size_t i = 0UL; i < n; ++i) {
-        fronts[rank[i]].push_back(i);
+        std::vector<std::vector<size_t>> fronts;
+        fronts.resize(*std::max_element(rank.begin(), rank.end()) + 1);
+        for (size_t i = 0UL; i < n; ++i) {
+            fronts[rank[i]].push_back(i);
+        }
+        return fronts;
     }
-    return fronts;
+} // namespace
+
+auto RankIntersectSorter::Sort(Operon::Span<Operon::Individual const> pop, Operon::Scalar eps) const -> NondominatedSorterBase::Result
+{
+    return RankIntersect(pop.size(), pop.front().Fitness.size(), [&](auto i, auto k) { return pop[i][k]; }, eps);
+}
+
+auto RankIntersectSorter::Sort(Operon::Span<Operon::Scalar const> fitness, size_t m, Operon::Scalar eps) const -> NondominatedSorterBase::Result
+{
+    return RankIntersect(fitness.size() / m, m, [&](auto i, auto k) { return fitness[i * m + k]; }, eps);
+}
+
+auto RankIntersectMatrixSorter::Sort(Operon::Span<Operon::Individual const> pop, Operon::Scalar eps) const -> NondominatedSorterBase::Result
+{
+    return RankIntersectMatrix(pop.size(), pop.front().Fitness.size(), [&](auto i, auto k) { return pop[i][k]; }, eps, tileBytes_);
+}
+
+auto RankIntersectMatrixSorter::Sort(Operon::Span<Operon::Scalar const> fitness, size_t m, Operon::Scalar eps) const -> NondominatedSorterBase::Result
+{
+    return RankIntersectMatrix(fitness.size() / m, m, [&](auto i, auto k) { return fitness[i * m + k]; }, eps, tileBytes_);
 }
 } // namespace Operon
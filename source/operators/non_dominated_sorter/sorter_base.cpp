@@ -0,0 +1,30 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <stdexcept>
+
+#include "operon/core/individual.hpp"
+#include "operon/operators/non_dominated_sorter.hpp"
+
+namespace Operon {
+auto NondominatedSorterBase::Sort(Operon::Span<Operon::Scalar const> fitness, size_t m, Operon::Scalar eps) const -> Result
+{
+    EXPECT(m > 0 && fitness.size() % m == 0);
+    auto const n = fitness.size() / m;
+    std::vector<Individual> pop(n, Individual(m));
+    for (size_t i = 0; i < n; ++i) {
+        std::copy_n(fitness.begin() + static_cast<std::ptrdiff_t>(i * m), m, pop[i].Fitness.begin());
+    }
+    return Sort(Operon::Span<Individual const>(pop.data(), pop.size()), eps);
+}
+
+auto NondominatedSorterBase::Insert(Result& /*fronts*/, Operon::Span<Operon::Scalar const> /*fitness*/, size_t /*m*/, size_t /*i*/, Operon::Scalar /*eps*/) const -> bool
+{
+    throw std::runtime_error("NondominatedSorterBase::Insert: incremental updates are not supported by this sorter");
+}
+
+auto NondominatedSorterBase::Remove(Result& /*fronts*/, Operon::Span<Operon::Scalar const> /*fitness*/, size_t /*m*/, size_t /*i*/, Operon::Scalar /*eps*/) const -> void
+{
+    throw std::runtime_error("NondominatedSorterBase::Remove: incremental updates are not supported by this sorter");
+}
+} // namespace Operon
@@ -0,0 +1,431 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <optional>
+
+#include "operon/ceres/tiny_solver.h"
+#include "operon/core/instrumentation.hpp"
+#include "operon/operators/ode_evaluator.hpp"
+
+namespace Operon {
+
+namespace {
+    using Array = Eigen::Array<Operon::Scalar, -1, -1>;
+
+    // the right-hand sides of a system evaluated on all the trajectories at once. the state of the integration is an
+    // array with one row per trajectory: the columns [0, n) hold the states, the columns [n + s * p, n + (s + 1) * p)
+    // the sensitivities of state s with respect to the p coefficients of the first tree
+    class System {
+    public:
+        System(Interpreter const& interpreter, Dataset const& dataset, std::vector<Range> const& trajectories, Operon::Scalar step,
+            Operon::Span<Operon::Hash const> states, Operon::Span<TreeView const> rhs, Operon::Span<Operon::Scalar const> parameters, bool sensitivities)
+            : interpreter_(interpreter)
+            , trajectories_(trajectories)
+            , step_(step)
+            , states_(states.begin(), states.end())
+            , parameters_(parameters)
+            , lanes_(trajectories.size())
+        {
+            EXPECT(!states.empty() && states.size() == rhs.size());
+            EXPECT(parameters.empty() || parameters.size() == static_cast<size_t>(rhs.front().CoefficientsCount()));
+
+            // one scratch column per variable read by the system, the states first
+            std::vector<Operon::Hash> variables(states.begin(), states.end());
+            for (auto const& tree : rhs) {
+                for (auto const& n : tree.Nodes()) {
+                    if (n.IsVariable() && std::find(variables.begin(), variables.end(), n.HashValue) == variables.end()) {
+                        variables.push_back(n.HashValue);
+                    }
+                }
+            }
+
+            auto buffer = std::make_shared<std::vector<Operon::Scalar>>(variables.size() * lanes_);
+            std::vector<std::string> names;
+            std::vector<Operon::Span<Operon::Scalar const>> columns;
+            for (size_t i = 0; i < variables.size(); ++i) {
+                auto variable = dataset.GetVariable(variables[i]);
+                EXPECT(variable.has_value());
+                names.push_back(variable->Name);
+                columns.emplace_back(buffer->data() + i * lanes_, lanes_);
+                if (i >= states.size()) { inputs_.push_back({ dataset.GetValues(variables[i]), buffer->data() + i * lanes_ }); }
+            }
+            buffer_ = buffer;
+            scratch_.emplace(Dataset::FromColumns(names, columns, buffer));
+
+            numParameters_ = sensitivities ? static_cast<size_t>(rhs.front().CoefficientsCount()) : size_t { 0 };
+            supported_ = true;
+            for (auto const& tree : rhs) {
+                auto& program = programs_.emplace_back(interpreter.Compile<Operon::Scalar>(tree, *scratch_));
+                supported_ = supported_ && (!sensitivities || Interpreter::SupportsReverseMode(program));
+
+                // the state read by every leaf (-1 for the constants and the inputs)
+                auto& leaves = leaves_.emplace_back();
+                for (auto const& n : tree.Nodes()) {
+                    if (!n.IsLeaf()) { continue; }
+                    auto it = n.IsVariable() ? std::find(states.begin(), states.end(), n.HashValue) : states.end();
+                    leaves.push_back({ n.Value, it == states.end() ? -1 : static_cast<int64_t>(it - states.begin()),
+                        n.IsVariable() ? buffer->data() + static_cast<size_t>(std::find(variables.begin(), variables.end(), n.HashValue) - variables.begin()) * lanes_ : nullptr });
+                }
+                adjoints_.emplace_back(static_cast<Eigen::Index>(lanes_), static_cast<Eigen::Index>(leaves.size()));
+            }
+            if (!parameters.empty()) {
+                for (size_t k = 0; k < parameters.size(); ++k) { leaves_.front()[k].Weight = parameters[k]; }
+            }
+        }
+
+        [[nodiscard]] auto Supported() const -> bool { return supported_; }
+        [[nodiscard]] auto Columns() const -> Eigen::Index { return static_cast<Eigen::Index>(states_.size() * (1 + numParameters_)); }
+        [[nodiscard]] auto Lanes() const -> size_t { return lanes_; }
+
+        // the derivatives of the integration state y at time t within the interval starting at row k
+        auto operator()(size_t k, Operon::Scalar t, Array const& y, Array& dy) -> void
+        {
+            auto const n = states_.size();
+            auto const p = numParameters_;
+            auto const fraction = std::clamp(t / step_, Operon::Scalar { 0 }, Operon::Scalar { 1 });
+            auto const rows = static_cast<Eigen::Index>(lanes_);
+
+            // the inputs are interpolated between the rows (the trajectories which already ended keep their last row)
+            for (auto const& [values, column] : inputs_) {
+                for (size_t l = 0; l < lanes_; ++l) {
+                    auto const& r = trajectories_[l];
+                    auto const i = r.Start() + std::min(k, r.Size() - 1);
+                    auto const j = r.Start() + std::min(k + 1, r.Size() - 1);
+                    column[l] = values[i] + fraction * (values[j] - values[i]);
+                }
+            }
+            for (size_t s = 0; s < n; ++s) {
+                Eigen::Map<Eigen::Array<Operon::Scalar, -1, 1>>(buffer_->data() + s * lanes_, rows) = y.col(static_cast<Eigen::Index>(s));
+            }
+
+            auto const& interpreter = interpreter_.get();
+            Range const range { 0, lanes_ };
+            for (size_t j = 0; j < n; ++j) {
+                auto const* parameters = j == 0 && !parameters_.empty() ? parameters_.data() : nullptr;
+                Operon::Span<Operon::Scalar> out(dy.col(static_cast<Eigen::Index>(j)).data(), lanes_);
+                if (p == 0) {
+                    interpreter.Evaluate<Operon::Scalar>(programs_[j], range, out, parameters);
+                } else {
+                    interpreter.EvaluateJacobian<Operon::Scalar>(programs_[j], range, parameters, out, adjoints_[j].data(), /*leafAdjoints=*/true);
+                }
+            }
+            if (p == 0) { return; }
+
+            // dS_j/dt = sum_s df_j/dx_s * S_s (+ df_0/dtheta for the first state)
+            for (size_t j = 0; j < n; ++j) {
+                auto sj = dy.middleCols(static_cast<Eigen::Index>(n + j * p), static_cast<Eigen::Index>(p));
+                sj.setZero();
+                auto const& leaves = leaves_[j];
+                for (size_t i = 0; i < leaves.size(); ++i) {
+                    auto const& leaf = leaves[i];
+                    auto const adj = adjoints_[j].col(static_cast<Eigen::Index>(i));
+                    if (leaf.State >= 0) {
+                        auto const s = static_cast<size_t>(leaf.State);
+                        auto const ss = y.middleCols(static_cast<Eigen::Index>(n + s * p), static_cast<Eigen::Index>(p));
+                        sj += ss.colwise() * (leaf.Weight * adj);
+                    }
+                    if (j == 0) {
+                        // d(w * x) / dw = x, d(c) / dc = 1
+                        if (leaf.Values != nullptr) {
+                            sj.col(static_cast<Eigen::Index>(i)) += adj * Eigen::Map<Eigen::Array<Operon::Scalar, -1, 1> const>(leaf.Values, rows);
+                        } else {
+                            sj.col(static_cast<Eigen::Index>(i)) += adj;
+                        }
+                    }
+                }
+            }
+        }
+
+    private:
+        struct Input {
+            Operon::Span<Operon::Scalar const> Values; // the dataset column
+            Operon::Scalar* Column;                    // the scratch column
+        };
+
+        struct Leaf {
+            Operon::Scalar Weight;
+            int64_t State;                 // the index of the state read by the leaf, -1 otherwise
+            Operon::Scalar const* Values;  // the scratch column of a variable leaf, nullptr otherwise
+        };
+
+        std::reference_wrapper<Interpreter const> interpreter_;
+        std::vector<Range> const& trajectories_;
+        Operon::Scalar step_;
+        std::vector<Operon::Hash> states_;
+        Operon::Span<Operon::Scalar const> parameters_;
+        size_t lanes_;
+        size_t numParameters_ { 0 };
+        bool supported_ { true };
+
+        std::shared_ptr<std::vector<Operon::Scalar>> buffer_;
+        std::optional<Dataset> scratch_;
+        std::vector<Input> inputs_;
+        std::vector<Interpreter::Program<Operon::Scalar>> programs_;
+        std::vector<std::vector<Leaf>> leaves_;
+        std::vector<Eigen::Array<Operon::Scalar, -1, -1>> adjoints_;
+    };
+
+    // dormand-prince 5(4) tableau
+    constexpr std::array<Operon::Scalar, 7> DpC { 0, 1. / 5, 3. / 10, 4. / 5, 8. / 9, 1, 1 }; // NOLINT
+    constexpr std::array<std::array<Operon::Scalar, 6>, 7> DpA { { // NOLINT
+        { 0, 0, 0, 0, 0, 0 },
+        { 1. / 5, 0, 0, 0, 0, 0 },
+        { 3. / 40, 9. / 40, 0, 0, 0, 0 },
+        { 44. / 45, -56. / 15, 32. / 9, 0, 0, 0 },
+        { 19372. / 6561, -25360. / 2187, 64448. / 6561, -212. / 729, 0, 0 },
+        { 9017. / 3168, -355. / 33, 46732. / 5247, 49. / 176, -5103. / 18656, 0 },
+        { 35. / 384, 0, 500. / 1113, 125. / 192, -2187. / 6784, 11. / 84 } } };
+    // the difference between the fifth and the fourth order weights
+    constexpr std::array<Operon::Scalar, 7> DpE { 71. / 57600, 0, -71. / 16695, 71. / 1920, -17253. / 339200, 22. / 525, -1. / 40 }; // NOLINT
+} // namespace
+
+OdeIntegrator::OdeIntegrator(Interpreter const& interpreter, Dataset const& dataset, std::vector<Range> trajectories, Operon::Scalar step, OdeOptions options)
+    : interpreter_(interpreter)
+    , dataset_(dataset)
+    , trajectories_(std::move(trajectories))
+    , step_(step)
+    , options_(options)
+{
+    EXPECT(step > 0);
+    EXPECT(options.Substeps > 0);
+    for (auto const& r : trajectories_) {
+        EXPECT(r.Size() > 0 && r.End() <= dataset.Rows());
+        rows_ += r.Size();
+    }
+}
+
+auto OdeIntegrator::Observed(Operon::Hash variable) const -> Operon::Vector<Operon::Scalar>
+{
+    auto values = dataset_.get().GetValues(variable);
+    Operon::Vector<Operon::Scalar> observed;
+    observed.reserve(rows_);
+    for (auto const& r : trajectories_) {
+        std::copy_n(values.begin() + static_cast<std::ptrdiff_t>(r.Start()), r.Size(), std::back_inserter(observed));
+    }
+    return observed;
+}
+
+auto OdeIntegrator::Integrate(Operon::Span<Operon::Hash const> states, Operon::Span<TreeView const> rhs, Operon::Span<Operon::Scalar const> parameters, Operon::Span<Operon::Scalar> result, Operon::Scalar* sensitivities) const -> bool
+{
+    EXPECT(result.size() >= rows_);
+    if (trajectories_.empty()) { return true; }
+
+    System system(interpreter_, dataset_, trajectories_, step_, states, rhs, parameters, sensitivities != nullptr);
+    if (!system.Supported()) { return false; }
+
+    auto const lanes = system.Lanes();
+    auto const n = states.size();
+    auto const p = sensitivities != nullptr ? static_cast<size_t>(rhs.front().CoefficientsCount()) : size_t { 0 };
+    auto const rows = static_cast<Eigen::Index>(lanes);
+
+    std::vector<size_t> offsets(lanes);
+    size_t intervals { 0 };
+    for (size_t l = 0, offset = 0; l < lanes; offset += trajectories_[l].Size(), ++l) {
+        offsets[l] = offset;
+        intervals = std::max(intervals, trajectories_[l].Size() - 1);
+    }
+
+    // the initial states are observed, so their sensitivities are zero
+    Array y = Array::Zero(rows, system.Columns());
+    for (size_t s = 0; s < n; ++s) {
+        auto values = dataset_.get().GetValues(states[s]);
+        for (size_t l = 0; l < lanes; ++l) { y(static_cast<Eigen::Index>(l), static_cast<Eigen::Index>(s)) = values[trajectories_[l].Start()]; }
+    }
+
+    auto record = [&](size_t row) {
+        for (size_t l = 0; l < lanes; ++l) {
+            if (row >= trajectories_[l].Size()) { continue; }
+            auto const i = static_cast<Eigen::Index>(l);
+            result[offsets[l] + row] = y(i, 0);
+            for (size_t k = 0; k < p; ++k) {
+                sensitivities[k * rows_ + offsets[l] + row] = y(i, static_cast<Eigen::Index>(n + k)); // NOLINT
+            }
+        }
+    };
+
+    // only the trajectories which have not ended count towards the error and the failure checks
+    auto active = [&](size_t k, size_t l) { return k + 1 < trajectories_[l].Size(); };
+    auto finite = [&](size_t k) {
+        for (size_t l = 0; l < lanes; ++l) {
+            if (active(k, l) && !y.row(static_cast<Eigen::Index>(l)).isFinite().all()) { return false; }
+        }
+        return true;
+    };
+
+    record(0);
+    std::array<Array, DpC.size()> stages;
+    for (auto& s : stages) { s.resize(rows, system.Columns()); }
+    Array tmp(rows, system.Columns());
+
+    if (options_.Method == OdeMethod::RK4) {
+        auto const h = step_ / static_cast<Operon::Scalar>(options_.Substeps);
+        auto& [k1, k2, k3, k4, k5, k6, k7] = stages;
+        for (size_t k = 0; k < intervals; ++k) {
+            for (size_t i = 0; i < options_.Substeps; ++i) {
+                auto const t = static_cast<Operon::Scalar>(i) * h;
+                system(k, t, y, k1);
+                tmp = y + (h / 2) * k1;
+                system(k, t + h / 2, tmp, k2);
+                tmp = y + (h / 2) * k2;
+                system(k, t + h / 2, tmp, k3);
+                tmp = y + h * k3;
+                system(k, t + h, tmp, k4);
+                y += (h / 6) * (k1 + 2 * k2 + 2 * k3 + k4); // NOLINT
+            }
+            if (!finite(k)) { return false; }
+            record(k + 1);
+        }
+        return true;
+    }
+
+    // the last stage is evaluated at the accepted solution, so it is the first stage of the next step (the inputs are
+    // continuous across the rows)
+    Array next(rows, system.Columns());
+    auto h = step_;
+    size_t steps { 0 };
+    system(0, 0, y, stages[0]);
+    for (size_t k = 0; k < intervals; ++k) {
+        Operon::Scalar t { 0 };
+        while (t < step_) {
+            if (++steps > options_.MaxSteps) { return false; }
+            auto const dt = std::min(h, step_ - t);
+            for (size_t i = 1; i < DpC.size(); ++i) {
+                tmp = y;
+                for (size_t j = 0; j < i; ++j) {
+                    if (DpA[i][j] != 0) { tmp += (dt * DpA[i][j]) * stages[j]; }
+                }
+                if (i + 1 == DpC.size()) { next = tmp; }
+                system(k, t + DpC[i] * dt, tmp, stages[i]);
+            }
+
+            // the error norm of the states (not the sensitivities), over the trajectories which have not ended
+            auto const cols = static_cast<Eigen::Index>(n);
+            tmp.leftCols(cols).setZero();
+            for (size_t j = 0; j < DpE.size(); ++j) {
+                if (DpE[j] != 0) { tmp.leftCols(cols) += (dt * DpE[j]) * stages[j].leftCols(cols); }
+            }
+            Operon::Scalar error { 0 };
+            for (size_t l = 0; l < lanes; ++l) {
+                if (!active(k, l)) { continue; }
+                auto const i = static_cast<Eigen::Index>(l);
+                auto const scale = options_.Tolerance * (1 + y.row(i).leftCols(cols).abs().max(next.row(i).leftCols(cols).abs()));
+                error = std::max(error, (tmp.row(i).leftCols(cols).abs() / scale).maxCoeff());
+            }
+
+            constexpr Operon::Scalar safety { 0.9 };
+            constexpr Operon::Scalar minFactor { 0.2 };
+            constexpr Operon::Scalar maxFactor { 5 };
+            if (!std::isfinite(error)) {
+                h = dt * minFactor;
+                continue;
+            }
+            if (error <= 1) {
+                t = dt < step_ - t ? t + dt : step_;
+                y = next;
+                std::swap(stages[0], stages[DpC.size() - 1]);
+            }
+            auto const factor = error == 0 ? maxFactor : std::clamp(safety * std::pow(error, Operon::Scalar { -0.2 }), minFactor, maxFactor); // NOLINT
+            // a step shortened to land on the row does not shrink the next one
+            h = error <= 1 && dt < h ? h : dt * factor;
+        }
+        if (!finite(k)) { return false; }
+        record(k + 1);
+    }
+    return true;
+}
+
+namespace {
+    // the residuals of the integrated trajectories, with the forward sensitivities as the jacobian (column major)
+    struct OdeCostFunction {
+        using Scalar = Operon::Scalar;
+        enum { NUM_RESIDUALS = Eigen::Dynamic, NUM_PARAMETERS = Eigen::Dynamic }; // NOLINT
+
+        OdeIntegrator const& Integrator;
+        Operon::Span<Operon::Hash const> States;
+        Operon::Span<TreeView const> Rhs;
+        Operon::Span<Operon::Scalar const> Target;
+        size_t Parameters;
+
+        auto operator()(Scalar const* parameters, Scalar* residuals, Scalar* jacobian) const -> bool
+        {
+            Operon::Span<Scalar> res(residuals, Target.size());
+            if (!Integrator.Integrate(States, Rhs, { parameters, Parameters }, res, jacobian)) {
+                // rejected by the solver
+                std::fill(res.begin(), res.end(), std::numeric_limits<Scalar>::quiet_NaN());
+                return false;
+            }
+            std::transform(res.begin(), res.end(), Target.begin(), res.begin(), std::minus<>{});
+            return true;
+        }
+
+        [[nodiscard]] auto NumResiduals() const -> int { return static_cast<int>(Target.size()); }
+        [[nodiscard]] auto NumParameters() const -> int { return static_cast<int>(Parameters); }
+    };
+} // namespace
+
+auto OdeEvaluator::Trajectories() const -> std::vector<Range>
+{
+    return trajectories_.empty() ? std::vector<Range> { GetProblem().TrainingRange() } : trajectories_;
+}
+
+auto OdeEvaluator::BufferSize() const -> size_t
+{
+    size_t rows { 0 };
+    for (auto const& r : Trajectories()) { rows += r.Size(); }
+    return rows;
+}
+
+auto
+OdeEvaluator::operator()(Operon::RandomGenerator& /*random*/, Individual& ind, Operon::Span<Operon::Scalar> buf) const -> typename EvaluatorBase::ReturnType
+{
+    Instrumentation::ScopedTimer timer(Instrumentation::Operator::Evaluation);
+    IncrementEvaluationCounter();
+    auto& genotype = ind.Genotype;
+    if (Simplification()) { genotype.Simplify(); }
+
+    OdeIntegrator integrator(GetInterpreter(), GetDataset(), Trajectories(), step_, options_);
+    std::vector<Operon::Hash> states { GetProblem().TargetVariable().Hash };
+    states.insert(states.end(), states_.begin(), states_.end());
+    std::vector<TreeView> rhs { genotype };
+    rhs.insert(rhs.end(), system_.begin(), system_.end());
+    auto target = integrator.Observed(states.front());
+
+    auto const coefficients = static_cast<size_t>(genotype.CoefficientsCount());
+    if (auto const iterations = LocalOptimizationIterations(); iterations > 0 && coefficients > 0) {
+        Instrumentation::ScopedTimer optimization(Instrumentation::Operator::LocalOptimization);
+        OdeCostFunction cf { integrator, states, rhs, { target.data(), target.size() }, coefficients };
+        ceres::TinySolver<OdeCostFunction> solver;
+        solver.options.max_num_iterations = static_cast<int>(iterations);
+        auto x0 = genotype.GetCoefficients();
+        decltype(solver)::Parameters params = Eigen::Map<Eigen::Matrix<Operon::Scalar, -1, 1>>(x0.data(), static_cast<Eigen::Index>(x0.size()));
+        solver.Solve(cf, &params);
+        IncrementResidualEvaluations(static_cast<size_t>(solver.summary.iterations));
+        IncrementJacobianEvaluations(static_cast<size_t>(solver.summary.iterations));
+        if (params.allFinite() && solver.summary.final_cost <= solver.summary.initial_cost) {
+            genotype.SetCoefficients({ params.data(), x0.size() });
+        }
+    }
+
+    IncrementResidualEvaluations();
+    Operon::Vector<Operon::Scalar> estimatedValues;
+    if (buf.size() < integrator.Rows()) {
+        estimatedValues.resize(integrator.Rows());
+        buf = Operon::Span<Operon::Scalar>(estimatedValues.data(), estimatedValues.size());
+    }
+    auto result = buf.subspan(0, integrator.Rows());
+    if (!integrator.Integrate(states, rhs, {}, result)) {
+        return typename EvaluatorBase::ReturnType { std::numeric_limits<Operon::Scalar>::max() };
+    }
+
+    auto fit = static_cast<Operon::Scalar>(error_.get()(result, { target.data(), target.size() }));
+    if (!std::isfinite(fit)) {
+        fit = std::numeric_limits<Operon::Scalar>::max();
+    }
+    return typename EvaluatorBase::ReturnType { fit };
+}
+
+} // namespace Operon
@@ -0,0 +1,120 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <numeric>
+
+#include "operon/core/hypervolume.hpp"
+#include "operon/operators/non_dominated_sorter.hpp"
+#include "operon/operators/reinserter.hpp"
+
+namespace Operon {
+
+void ReinserterBase::Partition(Operon::Span<Individual const> a, Operon::Span<Individual const> b, size_t n) const
+{
+    auto const size = a.size() + b.size();
+    EXPECT(n <= size);
+    auto get = [&](size_t i) -> Individual const& { return i < a.size() ? a[i] : b[i - a.size()]; };
+
+    indices_.resize(size);
+    std::iota(indices_.begin(), indices_.end(), size_t{0});
+    auto nth = indices_.begin() + static_cast<std::ptrdiff_t>(n);
+    if (nth == indices_.end()) { return; }
+
+    if (key_) {
+        keys_.resize(size);
+        for (size_t i = 0; i < size; ++i) { keys_[i] = key_(get(i)); }
+        std::nth_element(indices_.begin(), nth, indices_.end(), [&](auto i, auto j) { return keys_[i] < keys_[j]; });
+    } else {
+        std::nth_element(indices_.begin(), nth, indices_.end(), [&](auto i, auto j) { return comp_(get(i), get(j)); });
+    }
+}
+
+void ReinserterBase::Exchange(Operon::Span<Individual> pop, Operon::Span<Individual> pool) const
+{
+    auto const n = pop.size();
+    auto const& indices = Indices();
+    EXPECT(indices.size() == n + pool.size());
+
+    // the pool individuals among the first n take the places of the population individuals outside of them
+    auto out = indices.begin() + static_cast<std::ptrdiff_t>(n);
+    for (auto it = indices.begin(); it != indices.begin() + static_cast<std::ptrdiff_t>(n); ++it) {
+        if (*it < n) { continue; }
+        out = std::find_if(out, indices.end(), [n](auto i) { return i < n; });
+        EXPECT(out != indices.end());
+        std::swap(pool[*it - n], pop[*out++]);
+    }
+}
+
+void KeepBestReinserter::operator()(Operon::RandomGenerator& /*random*/, Operon::Span<Individual> pop, Operon::Span<Individual> pool) const
+{
+    Partition(pop, pool, pop.size());
+    Exchange(pop, pool);
+}
+
+void ReplaceWorstReinserter::operator()(Operon::RandomGenerator& /*random*/, Operon::Span<Individual> pop, Operon::Span<Individual> pool) const
+{
+    auto const n = pop.size();
+    auto const m = pool.size();
+    auto const& indices = Indices();
+
+    // typically the pool and the population are the same size
+    if (n > m) {
+        // the worst m individuals of the population are replaced by the pool
+        Partition(pop, {}, n - m);
+        for (size_t k = 0; k < m; ++k) {
+            std::swap(pool[k], pop[indices[n - m + k]]);
+        }
+    } else if (n < m) {
+        // the population is replaced by the best n individuals of the pool
+        Partition({}, pool, n);
+        for (size_t k = 0; k < n; ++k) {
+            std::swap(pop[k], pool[indices[k]]);
+        }
+    } else {
+        std::swap_ranges(pool.begin(), pool.end(), pop.begin());
+    }
+}
+
+void HypervolumeReinserter::operator()(Operon::RandomGenerator& random, Operon::Span<Individual> pop, Operon::Span<Individual> pool) const
+{
+    auto const n = pop.size();
+    auto const size = n + pool.size();
+    if (pool.empty()) { return; }
+    auto get = [&](size_t i) -> Individual const& { return i < n ? pop[i] : pool[i - n]; };
+    auto const m = pop.front().Fitness.size();
+
+    // the sorters expect the fitness rows in lexicographic order
+    auto& indices = Indices();
+    indices.resize(size);
+    std::iota(indices.begin(), indices.end(), size_t{0});
+    std::stable_sort(indices.begin(), indices.end(), [&](auto i, auto j) { return LexicographicalComparison{}(get(i), get(j)); });
+    std::vector<Operon::Scalar> fitness;
+    fitness.reserve(size * m);
+    for (auto i : indices) { fitness.insert(fitness.end(), get(i).Fitness.begin(), get(i).Fitness.end()); }
+    auto const reference = Hypervolume::Reference(fitness, m);
+    auto fronts = sorter_.get()(Operon::Span<Operon::Scalar const>(fitness), m);
+
+    std::vector<bool> keep(size, false);
+    size_t kept{0};
+    std::vector<Operon::Scalar> points;
+    for (auto& front : fronts) {
+        if (kept == n) { break; }
+        // drop the least contributing individuals until the remainder of the front fits
+        while (kept + front.size() > n) {
+            points.clear();
+            for (auto i : front) { points.insert(points.end(), fitness.begin() + static_cast<std::ptrdiff_t>(i * m), fitness.begin() + static_cast<std::ptrdiff_t>((i + 1) * m)); }
+            auto contributions = Hypervolume::Contributions(random, points, m, reference, samples_);
+            auto worst = std::min_element(contributions.begin(), contributions.end()) - contributions.begin();
+            front.erase(front.begin() + worst);
+        }
+        for (auto i : front) { keep[indices[i]] = true; }
+        kept += front.size();
+    }
+
+    // the kept individuals go first, the pool individuals among them are moved into the population
+    std::iota(indices.begin(), indices.end(), size_t{0});
+    std::stable_partition(indices.begin(), indices.end(), [&](auto i) { return keep[i]; });
+    Exchange(pop, pool);
+}
+
+} // namespace Operon
@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <taskflow/taskflow.hpp>
+
+#include "operon/operators/evaluator.hpp"
+#include "operon/core/contracts.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Operon {
+
+ScreeningEvaluator::ScreeningEvaluator(Problem const& problem, ErrorMetric const& error, bool linearScaling, double fraction, double quantile)
+    : sample_(problem.GetDataset().Sample(problem.TrainingRange(), std::max(MinRows, static_cast<size_t>(fraction * static_cast<double>(problem.TrainingRange().Size())))))
+    , target_(problem.TargetVariable().Hash)
+    , error_(error)
+    , scaling_(linearScaling)
+    , quantile_(quantile)
+{
+    EXPECT(fraction > 0 && fraction <= 1);
+    EXPECT(quantile >= 0 && quantile <= 1);
+    sample_.StoreSinglePrecision();
+}
+
+auto ScreeningEvaluator::Screenable(Tree const& tree) const -> bool
+{
+    auto const& nodes = tree.Nodes();
+    return !nodes.empty() && std::none_of(nodes.begin(), nodes.end(), [](auto const& n) { return n.IsDynamic(); });
+}
+
+auto ScreeningEvaluator::Error(Tree const& tree) const -> Operon::Scalar
+{
+    auto const n = sample_.Rows();
+    thread_local Operon::Vector<float> single;
+    thread_local Operon::Vector<Operon::Scalar> estimated;
+    single.resize(n);
+    estimated.resize(n);
+
+    interpreter_.Evaluate<float>(tree, sample_, Range { 0, n }, Operon::Span<float>(single.data(), n));
+    std::copy(single.begin(), single.end(), estimated.begin());
+
+    auto const target = sample_.GetValues(target_);
+    Operon::Span<Operon::Scalar const> values(estimated.data(), n);
+    if (scaling_) {
+        auto [a, b] = FitLeastSquares(values, target);
+        std::transform(estimated.begin(), estimated.end(), estimated.begin(), [&](auto v) { return static_cast<Operon::Scalar>(v * a + b); });
+    }
+    auto const error = static_cast<Operon::Scalar>(error_.get()(values, target));
+    return std::isfinite(error) ? error : std::numeric_limits<Operon::Scalar>::max();
+}
+
+auto ScreeningEvaluator::operator()(Individual const& ind) const -> Operon::Scalar
+{
+    ++screened_;
+    if (!Screenable(ind.Genotype)) { return std::numeric_limits<Operon::Scalar>::lowest(); }
+    return Error(ind.Genotype);
+}
+
+auto ScreeningEvaluator::UpdateThreshold() const -> void
+{
+    // the unscreened individuals and the ones with a non-finite error do not count
+    errors_.erase(std::remove_if(errors_.begin(), errors_.end(), [](auto e) { return e == std::numeric_limits<Operon::Scalar>::lowest() || e == std::numeric_limits<Operon::Scalar>::max(); }), errors_.end());
+    if (errors_.empty()) {
+        threshold_ = std::numeric_limits<Operon::Scalar>::max();
+        return;
+    }
+    auto nth = errors_.begin() + static_cast<int64_t>(quantile_ * static_cast<double>(errors_.size() - 1));
+    std::nth_element(errors_.begin(), nth, errors_.end());
+    threshold_ = *nth;
+}
+
+auto ScreeningEvaluator::Prepare(Operon::Span<Individual const> pop) const -> void
+{
+    errors_.resize(pop.size());
+    std::transform(pop.begin(), pop.end(), errors_.begin(), [&](auto const& ind) {
+        return Screenable(ind.Genotype) ? Error(ind.Genotype) : std::numeric_limits<Operon::Scalar>::lowest();
+    });
+    UpdateThreshold();
+}
+
+auto ScreeningEvaluator::Prepare(tf::Subflow& subflow, Operon::Span<Individual const> pop) const -> void
+{
+    errors_.resize(pop.size());
+    auto screen = subflow.for_each_index(size_t{0}, pop.size(), size_t{1}, [this, pop](size_t i) {
+        errors_[i] = Screenable(pop[i].Genotype) ? Error(pop[i].Genotype) : std::numeric_limits<Operon::Scalar>::lowest();
+    }).name("screen population");
+    auto threshold = subflow.emplace([this]() { UpdateThreshold(); }).name("update threshold");
+    screen.precede(threshold);
+}
+
+} // namespace Operon
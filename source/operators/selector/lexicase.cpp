@@ -0,0 +1,202 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <taskflow/taskflow.hpp>
+
+#include "operon/collections/bitset.hpp"
+#include "operon/core/contracts.hpp"
+#include "operon/operators/evaluator.hpp"
+#include "operon/operators/selector.hpp"
+
+namespace Operon {
+
+namespace {
+    constexpr size_t BlockSize = 64;
+    // the pool becomes an array of indices once it holds fewer candidates than 1 / SparseRatio of the population
+    constexpr size_t SparseRatio = 32;
+    // the individuals per task computing the case errors in the parallel Prepare
+    constexpr size_t ErrorBlockSize = 32;
+
+    // the scratch space of a selection, per thread since the selections may run concurrently
+    struct Scratch {
+        std::vector<uint32_t> Order;
+        std::vector<uint64_t> Pool;
+        std::vector<uint32_t> Indices;
+        std::vector<Operon::Scalar> Errors; // cases x block of individuals (see Prepare)
+        std::vector<Operon::Scalar> Values; // see MedianAbsoluteDeviation
+    };
+
+    auto GetScratch() -> Scratch&
+    {
+        thread_local Scratch scratch;
+        return scratch;
+    }
+
+    // the median absolute deviation of the finite values
+    auto MedianAbsoluteDeviation(Operon::Span<Operon::Scalar const> values, std::vector<Operon::Scalar>& buffer) -> Operon::Scalar
+    {
+        buffer.clear();
+        std::copy_if(values.begin(), values.end(), std::back_inserter(buffer), [](auto v) { return std::isfinite(v); });
+        if (buffer.empty()) { return 0; }
+        auto median = [&]() {
+            auto mid = buffer.begin() + static_cast<int64_t>(buffer.size() / 2);
+            std::nth_element(buffer.begin(), mid, buffer.end());
+            return *mid;
+        };
+        auto const m = median();
+        for (auto& v : buffer) { v = std::abs(v - m); }
+        return median();
+    }
+
+    // one selection among n individuals on m cases: errors[c * n + i] is the error of individual i on case c
+    auto Lexicase(Operon::RandomGenerator& random, Operon::Scalar const* errors, Operon::Scalar const* epsilons, size_t n, size_t m) -> size_t
+    {
+        constexpr auto inf = std::numeric_limits<Operon::Scalar>::infinity();
+        auto& s = GetScratch();
+
+        // the cases in a random order, shuffled lazily as they are used
+        s.Order.resize(m);
+        std::iota(s.Order.begin(), s.Order.end(), uint32_t{0});
+
+        auto const blocks = (n + BlockSize - 1) / BlockSize;
+        s.Pool.assign(blocks, ~uint64_t{0});
+        if (n % BlockSize != 0) { s.Pool.back() >>= BlockSize - n % BlockSize; }
+        size_t count{n};
+        bool dense{true};
+
+        for (size_t k = 0; k < m && count > 1; ++k) {
+            std::swap(s.Order[k], s.Order[k + Random::Bounded(random, m - k)]);
+            auto const* row = errors + static_cast<size_t>(s.Order[k]) * n;
+            auto const epsilon = epsilons[s.Order[k]];
+
+            if (dense) {
+                // the best error in the pool, then the mask of the candidates within epsilon of it
+                auto best = inf;
+                for (size_t b = 0; b < blocks; ++b) {
+                    auto const bits = s.Pool[b];
+                    auto const* e = row + b * BlockSize;
+                    auto const w = std::min(BlockSize, n - b * BlockSize);
+                    for (size_t j = 0; j < w; ++j) {
+                        best = std::min(best, ((bits >> j) & 1U) != 0 ? e[j] : inf);
+                    }
+                }
+                auto const threshold = best + epsilon;
+                count = 0;
+                for (size_t b = 0; b < blocks; ++b) {
+                    auto const* e = row + b * BlockSize;
+                    auto const w = std::min(BlockSize, n - b * BlockSize);
+                    uint64_t mask{0};
+                    for (size_t j = 0; j < w; ++j) {
+                        mask |= static_cast<uint64_t>(e[j] <= threshold) << j;
+                    }
+                    s.Pool[b] &= mask;
+                    count += BitOps::PopCount(s.Pool[b]);
+                }
+
+                if (count * SparseRatio < n) {
+                    s.Indices.clear();
+                    for (size_t b = 0; b < blocks; ++b) {
+                        for (auto bits = s.Pool[b]; bits != 0; bits &= bits - 1) {
+                            s.Indices.push_back(static_cast<uint32_t>(b * BlockSize + Bitset<>::CountTrailingZeros(bits)));
+                        }
+                    }
+                    dense = false;
+                }
+            } else {
+                auto best = inf;
+                for (auto i : s.Indices) { best = std::min(best, row[i]); }
+                auto const threshold = best + epsilon;
+                s.Indices.erase(std::remove_if(s.Indices.begin(), s.Indices.end(), [&](auto i) { return !(row[i] <= threshold); }), s.Indices.end());
+                count = s.Indices.size();
+            }
+        }
+
+        // a random one of the remaining candidates
+        auto r = Random::Bounded(random, count);
+        if (!dense) { return s.Indices[r]; }
+        for (size_t b = 0; b < blocks; ++b) {
+            auto const c = BitOps::PopCount(s.Pool[b]);
+            if (r < c) {
+                auto bits = s.Pool[b];
+                for (; r > 0; --r) { bits &= bits - 1; }
+                return b * BlockSize + Bitset<>::CountTrailingZeros(bits);
+            }
+            r -= c;
+        }
+        return n - 1; // not reached
+    }
+} // namespace
+
+void LexicaseSelector::DrawCases() const
+{
+    auto const range = evaluator_.get().GetProblem().TrainingRange();
+    auto const m = std::min(cases_, range.Size());
+    EXPECT(m > 0);
+
+    // the cases are drawn without replacement (Floyd's algorithm) and sorted for locality
+    rows_.clear();
+    for (auto j = range.Size() - m; j < range.Size(); ++j) {
+        auto const t = Random::Bounded(random_, j + 1);
+        rows_.push_back(range.Start() + (std::find(rows_.begin(), rows_.end(), range.Start() + t) == rows_.end() ? t : j));
+    }
+    std::sort(rows_.begin(), rows_.end());
+}
+
+void LexicaseSelector::Prepare(Operon::Span<Individual const> pop) const
+{
+    SelectorBase::Prepare(pop);
+    DrawCases();
+    auto const m = rows_.size();
+
+    errors_.resize(m * pop.size());
+    evaluator_.get().CaseErrors(pop, { rows_.data(), rows_.size() }, { errors_.data(), errors_.size() });
+
+    epsilons_.assign(m, 0);
+    if (epsilon_) {
+        std::vector<Operon::Scalar> buffer;
+        for (size_t c = 0; c < m; ++c) { epsilons_[c] = MedianAbsoluteDeviation(Errors(c), buffer); }
+    }
+}
+
+void LexicaseSelector::Prepare(tf::Subflow& subflow, Operon::Span<Individual const> pop) const
+{
+    SelectorBase::Prepare(pop);
+    DrawCases();
+    auto const m = rows_.size();
+    auto const n = pop.size();
+    errors_.resize(m * n);
+    epsilons_.assign(m, 0);
+
+    // the errors of a block of individuals are computed into a scratch matrix, then copied into the rows of the cases
+    auto const blocks = (n + ErrorBlockSize - 1) / ErrorBlockSize;
+    auto errors = subflow.for_each_index(size_t{0}, blocks, size_t{1}, [this, pop, m, n](size_t b) {
+        auto const first = b * ErrorBlockSize;
+        auto const count = std::min(ErrorBlockSize, n - first);
+        auto& buffer = GetScratch().Errors;
+        buffer.resize(m * count);
+        evaluator_.get().CaseErrors(pop.subspan(first, count), { rows_.data(), rows_.size() }, { buffer.data(), buffer.size() });
+        for (size_t c = 0; c < m; ++c) {
+            std::copy_n(buffer.data() + c * count, count, errors_.data() + c * n + first);
+        }
+    }).name("case errors");
+
+    if (epsilon_) {
+        auto epsilons = subflow.for_each_index(size_t{0}, m, size_t{1}, [this](size_t c) {
+            epsilons_[c] = MedianAbsoluteDeviation(Errors(c), GetScratch().Values);
+        }).name("case epsilons");
+        errors.precede(epsilons);
+    }
+}
+
+auto LexicaseSelector::operator()(Operon::RandomGenerator& random) const -> size_t
+{
+    EXPECT(!Population().empty());
+    return Lexicase(random, errors_.data(), epsilons_.data(), Population().size(), rows_.size());
+}
+} // namespace Operon
@@ -2,40 +2,59 @@
 // SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
 
 #include <numeric>
+#include <taskflow/taskflow.hpp>
+#include <taskflow/algorithm/sort.hpp>
 #include "operon/operators/selector.hpp"
 
 namespace Operon {
 
+namespace {
+    template <typename Compare>
+    auto Tournament(Operon::RandomGenerator& random, size_t n, size_t tournamentSize, Compare&& compare) -> size_t
+    {
+        auto best = Random::Bounded(random, n);
+        for (size_t i = 1; i < tournamentSize; ++i) {
+            auto curr = Random::Bounded(random, n);
+            if (compare(curr, best)) {
+                best = curr;
+            }
+        }
+        return best;
+    }
+} // namespace
+
+void SelectorBase::Prepare(tf::Subflow& subflow, Operon::Span<Individual const> pop) const
+{
+    subflow.emplace([this, pop]() { Prepare(pop); }).name("prepare selector");
+}
+
 auto TournamentSelector::operator()(Operon::RandomGenerator& random) const -> size_t
 {
-    auto population = Population();
-    std::uniform_int_distribution<size_t> uniformInt(0, population.size() - 1);
-    auto best = uniformInt(random);
-    auto tournamentSize = GetTournamentSize();
-
-    for (size_t i = 1; i < tournamentSize; ++i) {
-        auto curr = uniformInt(random);
-        if (this->Compare(population[curr], population[best])) {
-            best = curr;
+    return Tournament(random, Population().size(), GetTournamentSize(), [&](auto i, auto j) { return Compare(i, j); });
+}
+
+void TournamentSelector::Select(Operon::RandomGenerator& random, Operon::Span<size_t> selected) const
+{
+    auto const n = Population().size();
+    auto const tournamentSize = GetTournamentSize();
+    if (HasKeys()) {
+        auto keys = Keys();
+        for (auto& s : selected) {
+            s = Tournament(random, n, tournamentSize, [&](auto i, auto j) { return keys[i] < keys[j]; });
+        }
+    } else {
+        auto population = Population();
+        for (auto& s : selected) {
+            s = Tournament(random, n, tournamentSize, [&](auto i, auto j) { return Compare(population[i], population[j]); });
         }
     }
-    return best;
 }
 
 auto RankTournamentSelector::operator()(Operon::RandomGenerator& random) const -> size_t
 {
-    auto population = Population();
-    std::uniform_int_distribution<size_t> uniformInt(0, population.size() - 1);
-    auto best = uniformInt(random);
-    auto tournamentSize = GetTournamentSize();
-
-    for (size_t i = 1; i < tournamentSize; ++i) {
-        auto curr = uniformInt(random);
-        if (best < curr) {
-            best = curr;
-        }
-    }
-    return best;
+    // the indices are sorted from best to worst, so the tournament is won by the lowest position
+    auto best = Tournament(random, indices_.size(), GetTournamentSize(), std::less<>{});
+    return indices_[best];
 }
 
 void RankTournamentSelector::Prepare(const Operon::Span<const Individual> pop) const
@@ -43,6 +62,14 @@ void RankTournamentSelector::Prepare(const Operon::Span<const Individual> pop) c
     SelectorBase::Prepare(pop);
     indices_.resize(pop.size());
     std::iota(indices_.begin(), indices_.end(), 0);
-    std::sort(indices_.begin(), indices_.end(), [&](auto i, auto j) { return Compare(pop[i], pop[j]); });
+    std::sort(indices_.begin(), indices_.end(), [&](auto i, auto j) { return Compare(i, j); });
+}
+
+void RankTournamentSelector::Prepare(tf::Subflow& subflow, Operon::Span<Individual const> pop) const
+{
+    SelectorBase::Prepare(pop);
+    indices_.resize(pop.size());
+    std::iota(indices_.begin(), indices_.end(), 0);
+    subflow.sort(indices_.begin(), indices_.end(), [this](auto i, auto j) { return Compare(i, j); }).name("sort population");
 }
 } // namespace Operon
@@ -0,0 +1,178 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <taskflow/taskflow.hpp>
+
+#include "operon/operators/semantic_sketch.hpp"
+#include "operon/core/contracts.hpp"
+#include "operon/operators/evaluator.hpp"
+#include "operon/random/random.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+namespace Operon {
+
+SemanticSketch::SemanticSketch(Problem const& problem, Interpreter const& interpreter, bool linearScaling, size_t dimensions, size_t rows, uint64_t seed, size_t capacity)
+    : sample_(problem.GetDataset().Sample(problem.TrainingRange(), rows))
+    , interpreter_(interpreter)
+    , scaling_(linearScaling)
+    , dimensions_(dimensions)
+    , table_(capacity)
+{
+    EXPECT(dimensions > 0);
+    auto const range = problem.TrainingRange();
+    auto const n = sample_.Rows();
+
+    // the same rows as Dataset::Sample
+    rows_.resize(n);
+    for (size_t i = 0; i < n; ++i) { rows_[i] = i * range.Size() / n; }
+    auto const target = sample_.GetValues(problem.TargetVariable().Hash);
+    target_.assign(target.begin(), target.end());
+
+    // E[|P'x|^2] = |x|^2 / n with the entries of P distributed as N(0, 1 / (n * dimensions))
+    auto random = Random::Stream(seed, 0, 0);
+    std::normal_distribution<double> normal(0, 1 / std::sqrt(static_cast<double>(n * dimensions)));
+    directions_.resize(n * dimensions);
+    std::generate(directions_.begin(), directions_.end(), [&]() { return static_cast<Operon::Scalar>(normal(random)); });
+}
+
+auto SemanticSketch::Project(Operon::Span<Operon::Scalar const> sample, Operon::Span<Operon::Scalar> sketch) const -> bool
+{
+    auto const n = sample_.Rows();
+    EXPECT(sample.size() == n);
+    EXPECT(sketch.size() == dimensions_);
+    if (!std::all_of(sample.begin(), sample.end(), [](auto v) { return std::isfinite(v); })) {
+        return false;
+    }
+
+    double a{1};
+    double b{0};
+    if (scaling_) {
+        std::tie(a, b) = FitLeastSquares(sample, Operon::Span<Operon::Scalar const>(target_.data(), target_.size()));
+        if (!std::isfinite(a) || !std::isfinite(b)) { return false; }
+    }
+
+    std::vector<double> acc(dimensions_, 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        auto const v = a * sample[i] + b;
+        auto const* p = directions_.data() + i * dimensions_;
+        for (size_t k = 0; k < dimensions_; ++k) { acc[k] += v * p[k]; }
+    }
+    std::transform(acc.begin(), acc.end(), sketch.begin(), [](auto v) { return static_cast<Operon::Scalar>(v); });
+    return std::all_of(sketch.begin(), sketch.end(), [](auto v) { return std::isfinite(v); });
+}
+
+auto SemanticSketch::Sketch(Tree const& tree, Operon::Span<Operon::Scalar> sketch) const -> bool
+{
+    auto const n = sample_.Rows();
+    auto const values = interpreter_.get().Evaluate<Operon::Scalar>(tree, sample_, Range { 0, n });
+    return Project({ values.data(), values.size() }, sketch);
+}
+
+void SemanticSketch::Record(Operon::Hash key, Operon::Span<Operon::Scalar const> estimated)
+{
+    thread_local Operon::Vector<Operon::Scalar> sample;
+    thread_local Operon::Vector<Operon::Scalar> sketch;
+    sample.resize(rows_.size());
+    sketch.resize(dimensions_);
+    EXPECT(estimated.size() > rows_.back());
+    std::transform(rows_.begin(), rows_.end(), sample.begin(), [&](auto i) { return estimated[i]; });
+    if (Project({ sample.data(), sample.size() }, { sketch.data(), sketch.size() })) {
+        table_.Insert(key, { sketch.data(), sketch.size() }, {});
+        ++recorded_;
+    }
+}
+
+void SemanticSketch::Record(Operon::Hash key, Tree const& tree)
+{
+    thread_local Operon::Vector<Operon::Scalar> sketch;
+    sketch.resize(dimensions_);
+    if (Sketch(tree, { sketch.data(), sketch.size() })) {
+        table_.Insert(key, { sketch.data(), sketch.size() }, {});
+        ++recorded_;
+    }
+}
+
+auto SemanticSketch::Collect(Individual const& ind, size_t i) const -> void
+{
+    Operon::Span<Operon::Scalar> sketch(sketches_.data() + i * dimensions_, dimensions_);
+    auto const key = ind.Genotype.Hash(Operon::HashMode::Strict).HashValue();
+    Operon::FitnessVector found;
+    Operon::Vector<Operon::Scalar> coefficients;
+    if (table_.Find(key, found, coefficients) && found.size() == dimensions_) {
+        std::copy(found.begin(), found.end(), sketch.begin());
+        valid_[i] = 1;
+        return;
+    }
+    ++computed_;
+    valid_[i] = static_cast<char>(Sketch(ind.Genotype, sketch));
+}
+
+auto SemanticSketch::Reduce() const -> void
+{
+    auto const n = valid_.size();
+    auto const m = static_cast<size_t>(std::count(valid_.begin(), valid_.end(), 1));
+    distances_.assign(n, std::numeric_limits<double>::max());
+    diversity_ = 0;
+    if (m < 2) { return; }
+
+    // the sum over j of |s_i - s_j|^2 is m |c_i|^2 + sum_j |c_j|^2 with c the sketches centered on their mean
+    std::vector<double> mean(dimensions_, 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        if (valid_[i] == 0) { continue; }
+        for (size_t k = 0; k < dimensions_; ++k) { mean[k] += sketches_[i * dimensions_ + k]; }
+    }
+    for (auto& v : mean) { v /= static_cast<double>(m); }
+
+    std::vector<double> norms(n, 0.0);
+    double total{0};
+    for (size_t i = 0; i < n; ++i) {
+        if (valid_[i] == 0) { continue; }
+        for (size_t k = 0; k < dimensions_; ++k) {
+            auto const c = sketches_[i * dimensions_ + k] - mean[k];
+            norms[i] += c * c;
+        }
+        total += norms[i];
+    }
+
+    auto const pairs = static_cast<double>(m - 1);
+    for (size_t i = 0; i < n; ++i) {
+        if (valid_[i] == 0) { continue; }
+        distances_[i] = std::sqrt((static_cast<double>(m) * norms[i] + total) / pairs);
+    }
+    diversity_ = std::sqrt(2 * total / pairs);
+}
+
+auto SemanticSketch::Distance(size_t i, size_t j) const -> double
+{
+    EXPECT(i < valid_.size() && j < valid_.size());
+    if (valid_[i] == 0 || valid_[j] == 0) { return std::numeric_limits<double>::max(); }
+    double d{0};
+    for (size_t k = 0; k < dimensions_; ++k) {
+        auto const e = static_cast<double>(sketches_[i * dimensions_ + k]) - sketches_[j * dimensions_ + k];
+        d += e * e;
+    }
+    return std::sqrt(d);
+}
+
+void SemanticSketch::Prepare(Operon::Span<Individual const> pop) const
+{
+    sketches_.assign(pop.size() * dimensions_, Operon::Scalar{0});
+    valid_.assign(pop.size(), 0);
+    for (size_t i = 0; i < pop.size(); ++i) { Collect(pop[i], i); }
+    Reduce();
+}
+
+void SemanticSketch::Prepare(tf::Subflow& subflow, Operon::Span<Individual const> pop) const
+{
+    sketches_.assign(pop.size() * dimensions_, Operon::Scalar{0});
+    valid_.assign(pop.size(), 0);
+    auto collect = subflow.for_each_index(size_t{0}, pop.size(), size_t{1}, [this, pop](size_t i) { Collect(pop[i], i); }).name("collect sketches");
+    auto reduce = subflow.emplace([this]() { Reduce(); }).name("reduce sketches");
+    collect.precede(reduce);
+}
+
+} // namespace Operon
@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include "operon/operators/surrogate.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace Operon {
+
+namespace {
+    // the initial covariance of the weights, large for a weak prior
+    constexpr double InitialCovariance = 1e4;
+
+    enum FeatureIndex : size_t { BiasFeature, LengthFeature, DepthFeature, TypeFeatures, ErrorFeature = TypeFeatures + NodeTypes::Count, ParentFeature };
+    static_assert(ParentFeature + 1 == SurrogateModel::Dimension);
+} // namespace
+
+SurrogateModel::SurrogateModel(Problem const& problem, Interpreter const& interpreter, ErrorMetric const& error, bool linearScaling, size_t rows)
+    : sample_(problem.GetDataset().Sample(problem.TrainingRange(), rows))
+    , target_(problem.TargetVariable().Hash)
+    , interpreter_(interpreter)
+    , error_(error)
+    , scaling_(linearScaling)
+    , w_(FeatureVector::Zero())
+    , p_(decltype(p_)::Identity() * InitialCovariance)
+    , weights_(FeatureVector::Zero())
+{
+}
+
+auto SurrogateModel::Features(Tree const& tree, Operon::Scalar parentFitness) const -> std::optional<FeatureVector>
+{
+    auto const n = sample_.Rows();
+    auto estimated = interpreter_.get().Evaluate<Operon::Scalar>(tree, sample_, Range { 0, n });
+    if (!std::all_of(estimated.begin(), estimated.end(), [](auto v) { return std::isfinite(v); })) {
+        return std::nullopt;
+    }
+    auto const target = sample_.GetValues(target_);
+    Operon::Span<Operon::Scalar const> values(estimated.data(), n);
+    if (scaling_) {
+        auto [a, b] = FitLeastSquares(values, target);
+        std::transform(estimated.begin(), estimated.end(), estimated.begin(), [&](auto v) { return static_cast<Operon::Scalar>(v * a + b); });
+    }
+    auto const error = error_.get()(values, target);
+    if (!std::isfinite(error)) { return std::nullopt; }
+
+    FeatureVector x = FeatureVector::Zero();
+    auto const& nodes = tree.Nodes();
+    x[BiasFeature] = 1;
+    x[LengthFeature] = std::log1p(static_cast<double>(nodes.size()));
+    x[DepthFeature] = std::log1p(static_cast<double>(tree.Depth()));
+    for (auto const& node : nodes) {
+        x[TypeFeatures + NodeTypes::GetIndex(node.Type)] += 1.0 / static_cast<double>(nodes.size());
+    }
+    x[ErrorFeature] = error;
+    x[ParentFeature] = std::isfinite(parentFitness) ? std::min(parentFitness, worst_) : worst_;
+    return x;
+}
+
+auto SurrogateModel::Discard(std::optional<FeatureVector> const& features) const -> bool
+{
+    if (!active_) { return false; }
+    auto const discard = !features || Predict(*features) - margin_ * rmse_ > threshold_;
+    if (discard) { ++discarded_; }
+    return discard;
+}
+
+void SurrogateModel::Update(FeatureVector const& features, Operon::Scalar fitness)
+{
+    if (!std::isfinite(fitness) || fitness == std::numeric_limits<Operon::Scalar>::max()) { return; }
+
+    std::scoped_lock lock(mutex_);
+    // recursive least squares with exponential forgetting
+    auto const residual = static_cast<double>(fitness) - w_.dot(features);
+    FeatureVector const px = p_ * features;
+    FeatureVector const gain = px / (forgetting_ + features.dot(px));
+    w_ += gain * residual;
+    p_ = (p_ - gain * px.transpose()) / forgetting_;
+
+    // the weights are determined once there are as many samples as features
+    if (samples_.fetch_add(1, std::memory_order_relaxed) >= Dimension) {
+        squaredError_ = forgetting_ * squaredError_ + residual * residual;
+        weight_ = forgetting_ * weight_ + 1;
+    }
+}
+
+void SurrogateModel::Prepare(Operon::Span<Individual const> pop)
+{
+    {
+        std::scoped_lock lock(mutex_);
+        weights_ = w_;
+        rmse_ = weight_ > 0 ? std::sqrt(squaredError_ / weight_) : std::numeric_limits<double>::max();
+    }
+
+    std::vector<Operon::Scalar> fitness;
+    fitness.reserve(pop.size());
+    for (auto const& ind : pop) {
+        if (!ind.Fitness.empty() && std::isfinite(ind[0]) && ind[0] < std::numeric_limits<Operon::Scalar>::max()) {
+            fitness.push_back(ind[0]);
+        }
+    }
+    active_ = samples_ >= minSamples_ && weight_ > 0 && !fitness.empty();
+    if (fitness.empty()) {
+        threshold_ = std::numeric_limits<Operon::Scalar>::max();
+        return;
+    }
+    worst_ = *std::max_element(fitness.begin(), fitness.end());
+    auto nth = fitness.begin() + static_cast<int64_t>(quantile_ * static_cast<double>(fitness.size() - 1));
+    std::nth_element(fitness.begin(), nth, fitness.end());
+    threshold_ = *nth;
+}
+
+} // namespace Operon
@@ -0,0 +1,58 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <exception>
+#include <mutex>
+#include <taskflow/taskflow.hpp>
+
+#include "operon/parser/infix.hpp"
+
+namespace Operon {
+    auto ModelParser::ParseMany(tf::Executor& executor, Operon::Span<std::string const> models, std::optional<Operon::HashMode> hash) const -> std::vector<Tree>
+    {
+        std::vector<Tree> trees(models.size());
+        if (models.empty()) { return trees; }
+
+        // a few chunks per worker, the models are usually of similar length
+        auto const chunks = std::min(models.size(), executor.num_workers() * 4UL);
+        auto const chunkSize = (models.size() + chunks - 1) / chunks;
+
+        std::mutex lock;
+        std::exception_ptr error;
+        size_t failed { models.size() };
+
+        tf::Taskflow taskflow;
+        taskflow.for_each_index(size_t { 0 }, models.size(), chunkSize, [&](size_t first) {
+            auto const last = std::min(first + chunkSize, models.size());
+            for (auto i = first; i < last; ++i) {
+                try {
+                    trees[i] = Parse(models[i]);
+                    if (hash) { [[maybe_unused]] auto const& t = trees[i].Hash(*hash); }
+                } catch (std::exception const& e) {
+                    // report the first model which failed
+                    std::scoped_lock guard(lock);
+                    if (i < failed) {
+                        failed = i;
+                        error = std::make_exception_ptr(std::invalid_argument(fmt::format("model {}: {}", i, e.what())));
+                    }
+                    return;
+                }
+            }
+        });
+        executor.run(taskflow).wait();
+
+        if (error) { std::rethrow_exception(error); }
+        return trees;
+    }
+
+    auto ModelParser::Duplicates(Operon::Span<Tree const> trees) -> std::vector<size_t>
+    {
+        std::vector<size_t> first(trees.size());
+        robin_hood::unordered_flat_map<Operon::Hash, size_t> seen;
+        seen.reserve(trees.size());
+        for (size_t i = 0; i < trees.size(); ++i) {
+            first[i] = seen.insert({ trees[i].HashValue(), i }).first->second;
+        }
+        return first;
+    }
+} // namespace Operon
@@ -48,6 +48,49 @@ TEST_CASE("Crossover")
         fmt::print("child\n{}\n", TreeFormatter::Format(child, ds, 2));
     }
 
+    SUBCASE("Incremental node update")
+    {
+        constexpr size_t maxDepth{1000};
+        constexpr size_t maxLength{50};
+        Operon::SubtreeCrossover cx(0.9, maxDepth, maxLength); // NOLINT
+
+        auto same = [](Tree const& lhs, Tree const& rhs) {
+            REQUIRE(lhs.Length() == rhs.Length());
+            for (size_t i = 0; i < lhs.Length(); ++i) {
+                auto const& a = lhs[i];
+                auto const& b = rhs[i];
+                CHECK(std::tie(a.Arity, a.Length, a.Depth, a.Level) == std::tie(b.Arity, b.Length, b.Depth, b.Level));
+                if (i + 1 < lhs.Length()) { CHECK(a.Parent == b.Parent); }
+            }
+        };
+
+        for (int n = 0; n < 1000; ++n) { // NOLINT
+            auto p1 = btc(random, maxLength, 1, maxDepth);
+            auto p2 = btc(random, maxLength, 1, maxDepth);
+            auto [i, j] = cx.FindCompatibleSwapLocations(random, p1, p2);
+
+            auto child = SubtreeCrossover::Cross(p1, p2, i, j);
+            auto reference = child;
+            reference.UpdateNodes();
+            same(child, reference);
+
+            // remove a branch of the root (the caller adjusts the arity of the parent)
+            auto r = child.Length() - 1;
+            if (child[r].Arity > 1) {
+                auto k = r - 1; // first child of the root
+                auto start = k - child[k].Length;
+                auto length = child[k].Length + 1UL;
+                auto& nodes = child.Nodes();
+                nodes[r].Arity--;
+                nodes.erase(nodes.begin() + static_cast<std::ptrdiff_t>(start), nodes.begin() + static_cast<std::ptrdiff_t>(k + 1));
+                reference = child;
+                reference.UpdateNodes();
+                child.UpdateNodes(start, length, 0);
+                same(child, reference);
+            }
+        }
+    }
+
     SUBCASE("Distribution of swap locations")
     {
         Operon::RandomGenerator rng(std::random_device{}());
@@ -86,6 +129,23 @@ TEST_CASE("Crossover")
         }
     }
 
+    SUBCASE("Swap location kind") {
+        constexpr size_t maxDepth{1000};
+        constexpr size_t maxLength{50};
+        for (auto p : { 0.0, 1.0 }) {
+            Operon::SubtreeCrossover cx(p, maxDepth, maxLength);
+            for (int k = 0; k < 1000; ++k) {
+                auto p1 = btc(random, maxLength, 1UL, maxDepth);
+                auto p2 = btc(random, maxLength, 1UL, maxDepth);
+                auto [i, j] = cx.FindCompatibleSwapLocations(random, p1, p2);
+                CHECK(i < p1.Length());
+                CHECK(j < p2.Length());
+                // the first parent always has leaf and function node candidates (unless it is a single node)
+                if (p1.Length() > 1) { CHECK(p1[i].IsLeaf() == (p == 0.0)); }
+            }
+        }
+    }
+
     SUBCASE("Child size") {
         const int n = 100000;
         std::vector<Tree> trees;
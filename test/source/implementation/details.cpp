@@ -3,7 +3,57 @@
 
 #include <doctest/doctest.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <taskflow/taskflow.hpp>
+#include <thread>
+
+#include "operon/algorithms/batch.hpp"
+#include "operon/algorithms/checkpoint.hpp"
+#include "operon/algorithms/engine.hpp"
+#include "operon/algorithms/gp.hpp"
+#include "operon/algorithms/termination.hpp"
+#include "operon/core/affinity.hpp"
+#include "operon/core/allocation.hpp"
+#include "operon/core/compact_tree.hpp"
+#include "operon/core/concurrent_queue.hpp"
+#include "operon/core/format.hpp"
+#include "operon/core/hypervolume.hpp"
 #include "operon/core/individual.hpp"
+#include "operon/core/instrumentation.hpp"
+#include "operon/core/memory.hpp"
+#include "operon/core/metrics.hpp"
+#include "operon/core/model_archive.hpp"
+#include "operon/core/node_pool.hpp"
+#include "operon/core/problem.hpp"
+#include "operon/core/pset.hpp"
+#include "operon/core/replicated_dataset.hpp"
+#include "operon/core/serialization.hpp"
+#include "operon/core/shared_forest.hpp"
+#include "operon/core/sharded_counter.hpp"
+#include "operon/core/small_vector.hpp"
+#include "operon/core/trace.hpp"
+#include "operon/interpreter/interpreter.hpp"
+#include "operon/interpreter/jit.hpp"
+#include "operon/interpreter/subtree_cache.hpp"
+#include "operon/operators/creator.hpp"
+#include "operon/operators/crossover.hpp"
+#include "operon/operators/evaluator.hpp"
+#include "operon/operators/generator.hpp"
+#include "operon/operators/initializer.hpp"
+#include "operon/operators/mutation.hpp"
+#include "operon/operators/non_dominated_sorter.hpp"
+#include "operon/operators/reinserter.hpp"
+#include "operon/operators/selector.hpp"
 
 namespace dt = doctest;
 
@@ -73,4 +123,1142 @@ namespace Operon::Test {
 
         CHECK(sizeof(Node) <= size_t { 64 });
     }
+
+    TEST_CASE("Compact tree" * dt::test_suite("[detail]"))
+    {
+        constexpr Operon::Hash x{1234};
+        Node var(NodeType::Variable, x);
+        var.Value = 2; // NOLINT
+        Tree tree { Node::Constant(3), var, Node(NodeType::Exp), Node(NodeType::Add) }; // NOLINT
+        tree.UpdateNodes();
+        (void) tree.Hash(Operon::HashMode::Strict);
+
+        CompactTree compact(tree);
+        CHECK(sizeof(CompactNode) < sizeof(Node));
+        CHECK(compact.Length() == tree.Length());
+        CHECK(compact.HashValue() == tree.HashValue());
+        CHECK(compact.GetCoefficients() == tree.GetCoefficients());
+
+        auto restored = compact.ToTree();
+        (void) restored.Hash(Operon::HashMode::Strict);
+        REQUIRE(restored.Length() == tree.Length());
+        for (size_t i = 0; i < tree.Length(); ++i) {
+            auto const& a = tree[i];
+            auto const& b = restored[i];
+            CHECK(a.Type == b.Type);
+            CHECK(a.HashValue == b.HashValue);
+            CHECK(a.CalculatedHashValue == b.CalculatedHashValue);
+            CHECK(a.Value == b.Value);
+            CHECK(std::tie(a.Arity, a.Length, a.Depth, a.Level, a.Parent) == std::tie(b.Arity, b.Length, b.Depth, b.Level, b.Parent));
+        }
+
+        std::vector<Operon::Scalar> coeff { 5, 7 }; // NOLINT
+        compact.SetCoefficients(coeff);
+        CHECK(compact.ToTree().GetCoefficients() == coeff);
+    }
+
+    TEST_CASE("Shared forest" * dt::test_suite("[detail]"))
+    {
+        constexpr Operon::Hash x{1234};
+        constexpr Operon::Hash y{5678};
+        Node var(NodeType::Variable, x);
+        var.Value = 2; // NOLINT
+        // exp(2x) + 3 and (exp(2x) + 3) * y share the subtree exp(2x) + 3
+        Tree a { Node::Constant(3), var, Node(NodeType::Exp), Node(NodeType::Add) }; // NOLINT
+        Tree b { Node(NodeType::Variable, y), Node::Constant(3), var, Node(NodeType::Exp), Node(NodeType::Add), Node(NodeType::Mul) }; // NOLINT
+        for (auto* t : { &a, &b }) {
+            t->UpdateNodes();
+            (void) t->Hash(Operon::HashMode::Strict);
+        }
+
+        SharedForest forest;
+        auto ha = forest.Insert(a);
+        auto hb = forest.Insert(b);
+        CHECK(forest.Size() == 6); // the nodes of b
+        CHECK(forest.Insert(a) == ha);
+        CHECK(forest.References(ha) == 3); // twice as a root, once as the child of the root of b
+        CHECK(forest.Length(hb) == b.Length());
+
+        auto same = [](Tree const& lhs, Tree const& rhs) {
+            return std::equal(lhs.Nodes().begin(), lhs.Nodes().end(), rhs.Nodes().begin(), rhs.Nodes().end(), [](auto const& u, auto const& v) {
+                return u.HashValue == v.HashValue && u.CalculatedHashValue == v.CalculatedHashValue && u.Value == v.Value
+                    && std::tie(u.Arity, u.Length, u.Depth, u.Level, u.Parent) == std::tie(v.Arity, v.Length, v.Depth, v.Level, v.Parent);
+            });
+        };
+        CHECK(same(forest.GetTree(ha), a));
+        CHECK(same(forest.GetTree(hb), b));
+
+        std::vector<std::byte> buffer;
+        std::array roots { hb, SharedForest::None, ha };
+        forest.Write({ roots.data(), roots.size() }, buffer);
+        size_t offset{0};
+        auto trees = SharedForest::Read({ buffer.data(), buffer.size() }, offset);
+        CHECK(offset == buffer.size());
+        REQUIRE(trees.size() == 3);
+        CHECK(same(trees[0], b));
+        CHECK(trees[1].Empty());
+        CHECK(same(trees[2], a));
+
+        // b keeps its subtree alive
+        forest.Release(ha);
+        forest.Release(ha);
+        CHECK(forest.Size() == 6);
+        forest.Release(hb);
+        CHECK(forest.Empty());
+        CHECK(forest.Insert(Tree{}) == SharedForest::None);
+    }
+
+    TEST_CASE("Node pool" * dt::test_suite("[detail]"))
+    {
+        NodePool::Clear();
+        Tree tree { Node::Constant(1), Node::Constant(2), Node(NodeType::Add) }; // NOLINT
+        tree.UpdateNodes();
+
+        auto copy = NodePool::Copy(tree);
+        CHECK(copy.Nodes() == tree.Nodes());
+
+        auto const* data = copy.Nodes().data();
+        NodePool::Release(std::move(copy));
+        CHECK(NodePool::Size() == 1);
+
+        // the released buffer is handed out again
+        auto nodes = NodePool::Acquire(2);
+        CHECK(nodes.empty());
+        CHECK(nodes.data() == data);
+        CHECK(NodePool::Size() == 0);
+
+        NodePool::Release(Operon::Vector<Node>{}); // buffers without capacity are not kept
+        CHECK(NodePool::Size() == 0);
+    }
+
+    TEST_CASE("Concurrent queue" * dt::test_suite("[detail]"))
+    {
+        ConcurrentQueue<size_t> queue(3); // NOLINT
+        CHECK(queue.Capacity() == 4);
+        for (size_t i = 0; i < queue.Capacity(); ++i) { CHECK(queue.TryPush(i)); }
+        size_t extra{4};
+        CHECK(!queue.TryPush(extra)); // full
+        for (size_t i = 0; i < queue.Capacity(); ++i) { CHECK(queue.TryPop() == i); }
+        CHECK(!queue.TryPop().has_value()); // empty
+
+        // several producers and consumers, every value arrives exactly once
+        constexpr size_t producers{4};
+        constexpr size_t values{10000};
+        ConcurrentQueue<size_t> shared(64); // NOLINT
+        std::vector<std::atomic_size_t> received(producers * values);
+        std::atomic_size_t count{0};
+        std::vector<std::thread> threads;
+        for (size_t p = 0; p < producers; ++p) {
+            threads.emplace_back([&, p]() {
+                for (size_t i = 0; i < values; ++i) {
+                    auto v = p * values + i;
+                    while (!shared.TryPush(v)) { std::this_thread::yield(); }
+                }
+            });
+            threads.emplace_back([&]() {
+                while (count < producers * values) {
+                    if (auto v = shared.TryPop()) { ++received[*v]; ++count; }
+                }
+            });
+        }
+        for (auto& t : threads) { t.join(); }
+        CHECK(std::all_of(received.begin(), received.end(), [](auto const& r) { return r == 1; }));
+    }
+
+    TEST_CASE("Sharded counter" * dt::test_suite("[detail]"))
+    {
+        constexpr size_t threads{8};
+        constexpr size_t increments{10'000};
+        ShardedCounter<> counter(4); // more threads than shards
+
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&]() {
+                for (size_t i = 0; i < increments; ++i) {
+                    ++counter;
+                    counter += 2;
+                    auto approximate = counter.Approximate();
+                    CHECK(approximate <= threads * increments * 3);
+                }
+            });
+        }
+        for (auto& w : workers) { w.join(); }
+
+        CHECK(counter.Load() == threads * increments * 3);
+        CHECK(counter.Approximate() <= counter.Load());
+        CHECK(counter.Load() < counter.Approximate() + counter.Slack());
+
+        counter = 100; // NOLINT
+        CHECK(counter.Load() == 100);
+        CHECK(counter.Approximate() <= 100);
+    }
+
+    TEST_CASE("Instrumentation" * dt::test_suite("[detail]"))
+    {
+        using Instrumentation::Operator;
+        using Instrumentation::Stage;
+        Instrumentation::Reset();
+        CHECK(std::string(Instrumentation::Name(Stage::GenerateOffspring)) == "generate offspring");
+
+        constexpr uint64_t ms{1'000'000}; // in nanoseconds
+        std::thread other([&]() { Instrumentation::Record(Stage::Reinsert, 0, 2 * ms, 0); });
+        other.join();
+        Instrumentation::Record(Stage::Reinsert, 3 * ms, ms, 1);
+        Instrumentation::Record(Operator::Mutation, ms, ms, 2);
+
+        // the counters of every thread are summed, also after the thread exited
+        auto profile = Instrumentation::Snapshot();
+        CHECK(profile[Stage::Reinsert].Wall == doctest::Approx(3e-3));
+        CHECK(profile[Stage::Reinsert].Cpu == doctest::Approx(3e-3));
+        CHECK(profile[Stage::Reinsert].Calls == 1);
+        CHECK(profile[Operator::Mutation].Calls == 2);
+        CHECK(profile[Operator::Crossover].Calls == 0);
+
+        Instrumentation::SetEnabled(true);
+        {
+            Instrumentation::ScopedTimer timer(Operator::Crossover);
+        }
+        Instrumentation::SetEnabled(false);
+        {
+            Instrumentation::ScopedTimer timer(Operator::Crossover);
+        }
+        CHECK(Instrumentation::Snapshot()[Operator::Crossover].Calls == (Instrumentation::Available() ? 1 : 0));
+
+        // the primitives are summed by type (or hash, for the dynamic ones) and value kind, the costliest first
+        using Instrumentation::ValueKind;
+        Instrumentation::RecordPrimitive(ValueKind::Scalar, Node(NodeType::Add), ms, 64); // NOLINT
+        Instrumentation::RecordPrimitive(ValueKind::Scalar, Node(NodeType::Add), ms, 36); // NOLINT
+        Instrumentation::RecordPrimitive(ValueKind::Dual, Node(NodeType::Add), ms, 64); // NOLINT
+        Instrumentation::RecordPrimitive(ValueKind::Dual, Node(NodeType::Dynamic, 42), 3 * ms, 64); // NOLINT
+        Instrumentation::RecordJacobian(ms, 100); // NOLINT
+        auto primitives = Instrumentation::PrimitiveSnapshot();
+        REQUIRE(primitives.Primitives.size() == 3);
+        CHECK(primitives.Primitives[0].Type == NodeType::Dynamic);
+        CHECK(primitives.Primitives[0].HashValue == 42);
+        CHECK(primitives.Primitives[1].Type == NodeType::Add);
+        CHECK(primitives.Primitives[1].Kind == ValueKind::Scalar);
+        CHECK(primitives.Primitives[1].Calls == 2);
+        CHECK(primitives.Primitives[1].Rows == 100);
+        CHECK(primitives.Primitives[1].Time == doctest::Approx(2e-3));
+        CHECK(primitives.JacobianCalls == 1);
+        CHECK(primitives.JacobianRows == 100);
+
+        // the hardware counts are summed like the timings, and also kept per thread
+        using Instrumentation::Event;
+        Instrumentation::EventCounts counts{};
+        counts[static_cast<size_t>(Event::Cycles)] = 1000; // NOLINT
+        counts[static_cast<size_t>(Event::Instructions)] = 2500; // NOLINT
+        counts[static_cast<size_t>(Event::CacheMisses)] = 10; // NOLINT
+        std::thread counting([&]() { Instrumentation::RecordEvents(Stage::EvaluatePopulation, counts); });
+        counting.join();
+        Instrumentation::RecordEvents(Stage::EvaluatePopulation, counts);
+        auto const events = Instrumentation::Snapshot();
+        auto const& evaluation = events[Stage::EvaluatePopulation];
+        CHECK(evaluation[Event::Cycles] == 2000);
+        CHECK(evaluation.Ipc() == doctest::Approx(2.5));
+        CHECK(evaluation.Traffic() == doctest::Approx(20.0 * Instrumentation::CacheLineSize));
+        auto const threads = Instrumentation::ThreadSnapshot();
+        CHECK(std::count_if(threads.begin(), threads.end(), [](auto const& p) { return p[Stage::EvaluatePopulation][Event::Instructions] == 2500; }) == 2);
+
+        // a timer counts when the events can be opened (not in every environment, e.g. without a pmu)
+        Instrumentation::SetEnabled(true);
+        if (Instrumentation::Available() && Instrumentation::SetHardwareCounting(true)) {
+            {
+                Instrumentation::ScopedTimer timer(Operator::Evaluation);
+                std::vector<double> values(1000, 1.0); // NOLINT
+                CHECK(std::accumulate(values.begin(), values.end(), 0.0) == 1000);
+            }
+            CHECK(Instrumentation::Snapshot()[Operator::Evaluation][Event::Instructions] > 0);
+        }
+        Instrumentation::SetHardwareCounting(false);
+        Instrumentation::SetEnabled(false);
+
+        Instrumentation::Reset();
+        CHECK(Instrumentation::Snapshot()[Stage::Reinsert].Calls == 0);
+        CHECK(Instrumentation::Snapshot()[Stage::EvaluatePopulation][Event::Cycles] == 0);
+        CHECK(Instrumentation::PrimitiveSnapshot().Primitives.empty());
+    }
+
+    TEST_CASE("Trace" * dt::test_suite("[detail]"))
+    {
+        tf::Executor executor(2);
+        auto trace = executor.make_observer<TraceObserver>();
+        CHECK(trace->Workers() == 2);
+
+        tf::Taskflow taskflow;
+        auto first = taskflow.emplace([]() { }).name("first");
+        auto second = taskflow.emplace([]() { }).name("second \"stage\"");
+        first.precede(second);
+        executor.run(taskflow).wait();
+        executor.remove_observer(trace);
+
+        size_t events{0};
+        for (size_t w = 0; w < trace->Workers(); ++w) {
+            for (auto const& e : trace->Events(w)) {
+                CHECK(e.Begin <= e.End);
+                ++events;
+            }
+        }
+        CHECK(events == 2);
+
+        std::ostringstream os;
+        trace->Dump(os);
+        auto json = os.str();
+        CHECK(json.find(R"("name":"first")") != std::string::npos);
+        CHECK(json.find(R"("name":"second \"stage\"")") != std::string::npos);
+
+        trace->Clear();
+        CHECK(trace->Events(0).empty());
+    }
+
+    TEST_CASE("Affinity" * dt::test_suite("[detail]"))
+    {
+        CHECK(Affinity::ParsePolicy("numa") == Affinity::Policy::NumaNodes);
+        CHECK_THROWS(Affinity::ParsePolicy("sockets"));
+
+        auto nodes = Affinity::Nodes();
+        REQUIRE(!nodes.empty());
+        CHECK(std::none_of(nodes.begin(), nodes.end(), [](auto const& n) { return n.empty(); }));
+    }
+
+    TEST_CASE("Checkpoint" * dt::test_suite("[detail]"))
+    {
+        Individual a(2);
+        a.Genotype = Tree { Node::Constant(2), Node(NodeType::Variable, 42), Node(NodeType::Add) }; // NOLINT
+        a.Genotype.UpdateNodes();
+        a.Fitness = { 1.5, 2.5 }; // NOLINT
+        a.Rank = 3; // NOLINT
+        a.Distance = 0.25; // NOLINT
+        std::vector<Individual> individuals { a, Individual(2) };
+
+        Operon::RandomGenerator random(1234); // NOLINT
+        CheckpointState state;
+        state.Generation = 7; // NOLINT
+        state.ResidualEvaluations = 100; // NOLINT
+        state.Fronts = 2;
+        state.StreamSeed = 42; // NOLINT
+        state.RandomStates.push_back(random.State());
+
+        auto buffer = Checkpoint::Encode(state, { individuals.data(), individuals.size() });
+        auto path = std::string("operon_checkpoint_test.bin");
+        Checkpoint::Save({ buffer.data(), buffer.size() }, path);
+        auto loaded = Checkpoint::Load(path);
+        std::remove(path.c_str());
+        CHECK(loaded == buffer);
+
+        CheckpointState restored;
+        auto result = Checkpoint::Decode({ loaded.data(), loaded.size() }, restored);
+        CHECK(restored.Generation == 7);
+        CHECK(restored.ResidualEvaluations == 100);
+        CHECK(restored.Fronts == 2);
+        CHECK(restored.StreamSeed == 42);
+        REQUIRE(result.size() == 2);
+        CHECK(result[0].Genotype.Nodes() == a.Genotype.Nodes());
+        CHECK(result[0].Genotype.Nodes()[0].Parent == 2);
+        CHECK(result[0].Fitness == a.Fitness);
+        CHECK(result[0].Rank == 3);
+        CHECK(result[0].Distance == 0.25);
+        CHECK(result[1].Genotype.Length() == 0);
+
+        // the restored generator continues the sequence
+        REQUIRE(restored.RandomStates.size() == 1);
+        Operon::RandomGenerator copy(0);
+        copy.SetState(restored.RandomStates.front());
+        CHECK(copy() == random());
+
+        buffer.resize(buffer.size() / 2);
+        CHECK_THROWS(Checkpoint::Decode({ buffer.data(), buffer.size() }, restored));
+    }
+
+    TEST_CASE("Random streams" * dt::test_suite("[detail]"))
+    {
+        // the same key gives the same stream, regardless of when or where it is derived
+        auto a = Random::Stream(1234, 5, 6); // NOLINT
+        auto b = Random::Stream(1234, 5, 6); // NOLINT
+        for (auto i = 0; i < 10; ++i) { CHECK(a() == b()); } // NOLINT
+
+        // every component of the key matters
+        std::vector<uint64_t> first;
+        for (auto [s, g, i, k] : std::vector<std::array<uint64_t, 4>> { { 1234, 5, 6, 0 }, { 1235, 5, 6, 0 }, { 1234, 4, 6, 0 }, { 1234, 5, 7, 0 }, { 1234, 5, 6, 1 }, { 1234, 6, 5, 0 } }) { // NOLINT
+            first.push_back(Random::Stream(s, g, i, k)());
+        }
+        std::sort(first.begin(), first.end());
+        CHECK(std::adjacent_find(first.begin(), first.end()) == first.end());
+    }
+
+    TEST_CASE("Model archive" * dt::test_suite("[detail]"))
+    {
+        std::vector<Variable> variables { { "x", 42, 0 }, { "y", 43, 1 } }; // NOLINT
+        Individual a(2);
+        a.Genotype = Tree { Node::Constant(2), Node(NodeType::Variable, 42), Node(NodeType::Mul), Node(NodeType::Variable, 43), Node(NodeType::Add) }; // NOLINT
+        a.Genotype.UpdateNodes();
+        a.Fitness = { 1.5, 2.5 }; // NOLINT
+        Individual b(2);
+        b.Genotype = Tree { Node(NodeType::Variable, 43) }; // NOLINT
+        b.Genotype.UpdateNodes();
+        b.Fitness = { 3, 4 }; // NOLINT
+        std::vector<Individual> individuals { a, b };
+
+        auto path = std::string("operon_model_archive_test.bin");
+        ModelArchive::Write(path, { individuals.data(), individuals.size() }, { variables.data(), variables.size() }, "{\"generation\":7}");
+        {
+            ModelArchive archive(path);
+            REQUIRE(archive.Size() == 2);
+            CHECK(archive.Objectives() == 2);
+            CHECK(archive.Metadata() == "{\"generation\":7}");
+            CHECK(archive.Variables().size() == 2);
+
+            auto nodes = archive.Nodes(0);
+            CHECK(std::equal(nodes.begin(), nodes.end(), a.Genotype.Nodes().begin(), a.Genotype.Nodes().end()));
+            CHECK(archive.GetTree(1).Nodes() == b.Genotype.Nodes());
+            auto ind = archive.GetIndividual(0);
+            CHECK(ind.Genotype.Nodes() == a.Genotype.Nodes());
+            CHECK(ind.Fitness == a.Fitness);
+            CHECK(archive.Fitness(1)[1] == 4);
+
+            // another dataset with the columns in a different order and other hashes
+            std::vector<Variable> other { { "y", 7, 0 }, { "z", 8, 1 }, { "x", 9, 2 } }; // NOLINT
+            archive.Remap({ other.data(), other.size() });
+            auto tree = archive.GetTree(0);
+            CHECK(tree.Nodes()[1].HashValue == 9);
+            CHECK(tree.Nodes()[3].HashValue == 7);
+            CHECK(tree.Nodes()[3].CalculatedHashValue == 7);
+            CHECK(tree.Nodes()[0].Value == 2);
+
+            std::vector<Variable> missing { { "x", 9, 0 } }; // NOLINT
+            CHECK_THROWS(archive.Remap({ missing.data(), missing.size() }));
+        }
+        std::remove(path.c_str());
+
+        // the variables of the models must be known
+        CHECK_THROWS(ModelArchive::Write(path, { individuals.data(), individuals.size() }, { variables.data(), 1 }));
+        std::remove(path.c_str());
+    }
+
+    TEST_CASE("Memory accounting" * dt::test_suite("[detail]"))
+    {
+        using Memory::Subsystem;
+        auto const before = Memory::Usage(Subsystem::Population);
+        {
+            Memory::Account account(Subsystem::Population, 1000); // NOLINT
+            CHECK(Memory::Usage(Subsystem::Population) == before + 1000);
+            account.Update(400); // NOLINT
+            CHECK(Memory::Usage(Subsystem::Population) == before + 400);
+        }
+        CHECK(Memory::Usage(Subsystem::Population) == before);
+
+        Individual ind(2);
+        CHECK(Memory::Footprint(ind) >= sizeof(Individual) + 2 * sizeof(Operon::Scalar));
+
+        // over the soft limit the caches evict, stop inserting, and the buffers shrink on their next use
+        constexpr size_t rows{100};
+        SubtreeCache<Operon::Scalar> cache(Range{0, rows});
+        for (Operon::Hash h = 0; h < 10; ++h) { // NOLINT
+            cache.Insert(h, Operon::Vector<Operon::Scalar>(rows));
+        }
+        CHECK(cache.Size() == 10);
+        Memory::Buffer<Operon::Vector<Operon::Scalar>> buffer(Subsystem::Interpreter);
+        CHECK(buffer.Get(rows).size() == rows);
+
+        auto const columns = 4 * cache.ColumnBytes();
+        Memory::SetSoftLimit(Memory::Total() - columns);
+        CHECK(Memory::OverLimit());
+        CHECK(Memory::Enforce() >= columns);
+        CHECK(!Memory::OverLimit());
+        CHECK(cache.Size() <= 6);
+        CHECK(buffer.Get(1).size() == 1);
+
+        auto const size = cache.Size();
+        Memory::SetSoftLimit(1);
+        cache.Insert(Operon::Hash{42}, Operon::Vector<Operon::Scalar>(rows)); // NOLINT
+        CHECK(cache.Size() == size);
+        Memory::SetSoftLimit(0);
+        CHECK(!Memory::OverLimit());
+    }
+
+    TEST_CASE("Allocation policy" * dt::test_suite("[detail]"))
+    {
+        auto aligned = [](void const* p, size_t alignment) { return reinterpret_cast<uintptr_t>(p) % alignment == 0; }; // NOLINT
+
+        Memory::AlignedVector<Operon::Scalar> small(3);
+        CHECK(aligned(small.data(), Memory::DefaultAlignment));
+
+        // a buffer as large as a huge page starts on a huge page boundary, and the copies keep the policy
+        Memory::SetAllocationPolicy({ Memory::PagePolicy::Transparent });
+        Memory::AlignedVector<Operon::Scalar> large(Memory::HugePageSize / sizeof(Operon::Scalar), 1);
+        Memory::SetAllocationPolicy({});
+        CHECK(aligned(large.data(), Memory::HugePageSize));
+        auto copy = large;
+        CHECK(aligned(copy.data(), Memory::HugePageSize));
+        CHECK(std::equal(copy.begin(), copy.end(), large.begin()));
+        CHECK(copy.get_allocator() == large.get_allocator());
+        CHECK(copy.get_allocator() != small.get_allocator());
+
+        CHECK(Memory::ParsePagePolicy("explicit") == Memory::PagePolicy::Explicit);
+        CHECK_THROWS_AS((void)Memory::ParsePagePolicy("gigantic"), std::invalid_argument);
+        CHECK_THROWS_AS(Memory::SetAllocationPolicy({ Memory::PagePolicy::Default, 3 }), std::invalid_argument);
+    }
+
+    TEST_CASE("Metrics sink" * dt::test_suite("[detail]"))
+    {
+        auto json = std::string("operon_metrics_test.jsonl");
+        auto prom = std::string("operon_metrics_test.prom");
+        std::remove(json.c_str());
+        {
+            MetricsSink sink({ json, prom });
+            for (size_t g = 0; g < 3; ++g) {
+                CHECK(sink.Push({ g, 0.5 * static_cast<double>(g), 100 * g, { { "avg len", 2.0 } } })); // NOLINT
+            }
+        } // the remaining samples are written by the destructor
+
+        std::ifstream f(json);
+        std::vector<std::string> lines;
+        for (std::string line; std::getline(f, line);) { lines.push_back(line); }
+        f.close();
+        std::remove(json.c_str());
+        REQUIRE(lines.size() == 3);
+        CHECK(lines[2].find(R"("generation":2)") != std::string::npos);
+        CHECK(lines[2].find(R"("evaluations_per_second":200)") != std::string::npos);
+        CHECK(lines[2].find(R"("avg_len":2)") != std::string::npos);
+
+        std::ifstream p(prom);
+        std::string text((std::istreambuf_iterator<char>(p)), std::istreambuf_iterator<char>());
+        p.close();
+        std::remove(prom.c_str());
+        CHECK(text.find("operon_generation 2\n") != std::string::npos);
+        CHECK(text.find("operon_generation_seconds 0.5\n") != std::string::npos);
+    }
+
+    TEST_CASE("Code formatter" * dt::test_suite("[detail]"))
+    {
+        // sin(2 * x1) + x2 / 3
+        Node x1(NodeType::Variable, 1);
+        x1.Value = 2;
+        Node x2(NodeType::Variable, 2);
+        x2.Value = 1;
+        Tree tree({ Node::Constant(3), x2, Node(NodeType::Div), x1, Node(NodeType::Sin), Node(NodeType::Add) });
+        tree.UpdateNodes();
+        std::unordered_map<Operon::Hash, std::string> names { { 1, "x1" }, { 2, "x2" } };
+
+        auto code = CodeFormatter::Format(tree, names, "f");
+        auto contains = [&](std::string const& str) { return code.find(str) != std::string::npos; };
+        // the inputs in the order of their first occurrence, one temporary per node
+        CHECK(contains(R"(f_inputs[] = { "x2", "x1" })"));
+        CHECK(contains("f_input_count = 2"));
+        CHECK(contains("t2 = t1 / (t0)"));
+        CHECK(contains("t4 = sin"));
+        CHECK(contains("t5 = t4 + t2"));
+        CHECK(contains("result[i] = t5"));
+
+        names.erase(1);
+        CHECK_THROWS(CodeFormatter::Format(tree, names, "f"));
+        CHECK_THROWS(CodeFormatter::Format(Tree({ Node(NodeType::Dynamic) }).UpdateNodes(), names, "f"));
+    }
+
+    TEST_CASE("JIT kernel" * dt::test_suite("[detail]"))
+    {
+        Dataset ds(std::vector<std::vector<Operon::Scalar>>{ { 1, 2, 3, 4 }, { 5, 6, 7, 8 } }); // NOLINT
+        auto variables = ds.Variables();
+        // sin(2 * x1) + x2 / 3
+        Node x1(NodeType::Variable, variables[0].Hash);
+        x1.Value = 2;
+        Node x2(NodeType::Variable, variables[1].Hash);
+        x2.Value = 1;
+        Tree tree({ Node::Constant(3), x2, Node(NodeType::Div), x1, Node(NodeType::Sin), Node(NodeType::Add) });
+        tree.UpdateNodes();
+
+        // the coefficients and the columns are arguments of the kernel
+        auto code = CodeFormatter::FormatKernel(tree);
+        CHECK(code.find("t0 = p[0]") != std::string::npos);
+        CHECK(code.find("t1 = p[1] * columns[0][i]") != std::string::npos);
+        CHECK(code.find("t3 = p[2] * columns[1][i]") != std::string::npos);
+
+        if (!Jit::Available()) { return; }
+        Interpreter interpreter;
+        Range range { 1, ds.Rows() };
+        std::array<Operon::Scalar, 3> parameters { 1, 2, 3 };
+        auto expected = interpreter.Evaluate<Operon::Scalar>(tree, ds, range);
+        auto expectedWithParameters = interpreter.Evaluate<Operon::Scalar>(tree, ds, range, parameters.data());
+
+        auto const threshold = Jit::Threshold();
+        Jit::SetThreshold(0);
+        auto program = interpreter.Compile<Operon::Scalar>(tree, ds);
+        if (Interpreter::Accelerate(program, range.Size())) {
+            Operon::Vector<Operon::Scalar> values(range.Size());
+            interpreter.Evaluate<Operon::Scalar>(program, range, { values.data(), values.size() });
+            for (size_t i = 0; i < values.size(); ++i) { CHECK(values[i] == doctest::Approx(expected[i])); }
+            // same structure, other coefficients
+            interpreter.Evaluate<Operon::Scalar>(program, range, { values.data(), values.size() }, parameters.data());
+            for (size_t i = 0; i < values.size(); ++i) { CHECK(values[i] == doctest::Approx(expectedWithParameters[i])); }
+        } else {
+            MESSAGE("no c compiler, the kernel was not compiled");
+        }
+        Jit::SetThreshold(threshold);
+    }
+
+    TEST_CASE("Replicated dataset" * dt::test_suite("[detail]"))
+    {
+        Dataset ds(std::vector<std::vector<Operon::Scalar>>{ { 1, 2, 3 }, { 4, 5, 6 } }); // NOLINT
+        ReplicatedDataset replicas(ds, 2);
+        REQUIRE(replicas.Size() == 2);
+        for (size_t i = 0; i < replicas.Size(); ++i) {
+            auto const& r = replicas.Replica(i);
+            CHECK(r.Values() == ds.Values());
+            CHECK(r.Values().data() != ds.Values().data());
+        }
+        CHECK(replicas.Local().Values() == ds.Values());
+    }
+
+    TEST_CASE("Small vector" * dt::test_suite("[detail]"))
+    {
+        using V = SmallVector<Operon::Scalar, 2>;
+        V a { 1, 2 };
+        CHECK(a.IsInline());
+        a.push_back(3); // spills to the heap, keeping the values
+        CHECK(!a.IsInline());
+        CHECK(a.capacity() >= 3);
+        CHECK(a == V{ 1, 2, 3 });
+
+        V b(std::move(a)); // the allocation is moved
+        CHECK(!b.IsInline());
+        CHECK(a.empty()); // NOLINT(bugprone-use-after-move,hicpp-invalid-access-moved)
+        CHECK(b.size() == 3);
+
+        V c { 4 };
+        V d(std::move(c)); // the inline values are copied
+        CHECK(d.IsInline());
+        CHECK(d.front() == 4);
+
+        d = b;
+        CHECK(d == b);
+        d.resize(1);
+        d.resize(2, 5); // NOLINT
+        CHECK(d == V{ 1, 5 });
+        std::vector<Operon::Scalar> values { 6, 7 }; // NOLINT
+        d.assign(values.begin(), values.end());
+        CHECK(d != b);
+        CHECK(std::equal(d.begin(), d.end(), values.begin()));
+
+        Individual ind(InlineObjectives);
+        CHECK(ind.Fitness.IsInline());
+    }
+
+    TEST_CASE("Serialization" * dt::test_suite("[detail]"))
+    {
+        Individual a(2);
+        a.Genotype = Tree { Node::Constant(2), Node(NodeType::Variable, 42), Node(NodeType::Add) }; // NOLINT
+        a.Genotype.Nodes()[1].Value = 3; // NOLINT
+        a.Genotype.UpdateNodes();
+        a.Fitness = { 1.5, 2.5 }; // NOLINT
+        Individual b(1); // empty tree
+        b[0] = 7; // NOLINT
+
+        std::vector<Individual> individuals { a, b };
+        auto buffer = Serialization::Write({ individuals.data(), individuals.size() });
+        CHECK(buffer.size() == sizeof(uint32_t) + Serialization::Size(a) + Serialization::Size(b));
+
+        auto result = Serialization::Read({ buffer.data(), buffer.size() });
+        REQUIRE(result.size() == 2);
+        CHECK(result[0].Genotype.Nodes() == a.Genotype.Nodes());
+        CHECK(result[0].Genotype.Nodes()[1].Value == 3);
+        CHECK(result[0].Genotype.Nodes()[0].Parent == 2);
+        CHECK(result[0].Genotype.Nodes()[2].Length == 2);
+        CHECK(result[0].Fitness == a.Fitness);
+        CHECK(result[1].Genotype.Length() == 0);
+        CHECK(result[1].Fitness == b.Fitness);
+    }
+
+    TEST_CASE("Compact serialization" * dt::test_suite("[detail]"))
+    {
+        std::vector<Variable> variables { { "x", 42, 0 }, { "y", 43, 1 } }; // NOLINT
+        auto individual = [](Operon::Vector<Node> nodes, Operon::Scalar fitness) {
+            Individual ind(1);
+            ind.Genotype = Tree(std::move(nodes));
+            ind.Genotype.UpdateNodes();
+            ind[0] = fitness;
+            return ind;
+        };
+        auto x = Node(NodeType::Variable, 42); // NOLINT
+        x.Value = 0.3; // NOLINT
+        auto y = Node(NodeType::Variable, 43); // NOLINT
+        auto add = Node(NodeType::Add);
+        add.Arity = 3; // n-ary
+        auto dynamic = Node(NodeType::Dynamic, 1234); // NOLINT
+        dynamic.Arity = 1;
+        dynamic.IsEnabled = false;
+
+        std::vector<Individual> individuals {
+            individual({ x, y, Node::Constant(1.1), add, dynamic }, 1.5), // NOLINT
+            individual({ x, Node(NodeType::Sin) }, 2.5), // NOLINT
+            Individual(2),
+        };
+        auto same = [](Individual const& a, Individual const& b, auto const& quantize) {
+            auto const& u = a.Genotype.Nodes();
+            auto const& v = b.Genotype.Nodes();
+            return a.Fitness == b.Fitness && std::equal(u.begin(), u.end(), v.begin(), v.end(), [&](auto const& p, auto const& q) {
+                return p.Type == q.Type && p.HashValue == q.HashValue && p.Arity == q.Arity && p.IsEnabled == q.IsEnabled
+                    && p.Length == q.Length && p.Parent == q.Parent && quantize(p.Value) == q.Value;
+            });
+        };
+
+        SUBCASE("Round trip")
+        {
+            // smaller than the native format, and smaller with every step of quantization
+            auto size = Serialization::Write({ individuals.data(), individuals.size() }).size();
+            for (auto precision : { Serialization::Precision::Exact, Serialization::Precision::Single, Serialization::Precision::BFloat16 }) {
+                Serialization::CompactCodec codec({ variables.data(), variables.size() }, precision);
+                auto buffer = codec.Encode({ individuals.data(), individuals.size() });
+                auto result = codec.Decode({ buffer.data(), buffer.size() });
+                REQUIRE(result.size() == individuals.size());
+                for (size_t i = 0; i < result.size(); ++i) {
+                    CHECK(same(individuals[i], result[i], [&](auto v) { return codec.Quantize(v); }));
+                }
+                CHECK(buffer.size() < size);
+                size = buffer.size();
+            }
+            Serialization::CompactCodec codec({ variables.data(), variables.size() }, Serialization::Precision::BFloat16);
+            CHECK(codec.Quantize(1.1) == doctest::Approx(1.1).epsilon(1e-2));
+            CHECK(codec.Quantize(1) == 1);
+
+            // the variables have to be in the table
+            Serialization::CompactCodec empty(Operon::Span<Variable const>{});
+            std::vector<std::byte> buffer;
+            CHECK_THROWS(empty.Encode(individuals[1], buffer));
+        }
+
+        SUBCASE("Delta encoding")
+        {
+            Serialization::CompactCodec codec({ variables.data(), variables.size() });
+            Serialization::DeltaEncoder encoder(codec);
+            Serialization::DeltaDecoder decoder(codec);
+
+            // a copy, a subtree replaced in the middle of the tree and a new tree
+            std::vector<Individual> next {
+                individuals[0],
+                individual({ x, Node::Constant(2), y, Node(NodeType::Mul), Node::Constant(1.1), add, dynamic }, 3), // NOLINT
+                individual({ y, Node(NodeType::Exp) }, 4), // NOLINT
+            };
+            auto first = encoder.Encode({ individuals.data(), individuals.size() });
+            auto second = encoder.Encode({ next.data(), next.size() });
+            CHECK(second.size() < codec.Encode({ next.data(), next.size() }).size());
+
+            std::vector<std::byte> log(first);
+            log.insert(log.end(), second.begin(), second.end());
+            size_t offset{0};
+            auto a = decoder.Decode({ log.data(), log.size() }, offset);
+            CHECK(offset == first.size());
+            auto b = decoder.Decode({ log.data(), log.size() }, offset);
+            CHECK(offset == log.size());
+            REQUIRE(a.size() == individuals.size());
+            REQUIRE(b.size() == next.size());
+            auto exact = [](auto v) { return v; };
+            for (size_t i = 0; i < a.size(); ++i) { CHECK(same(individuals[i], a[i], exact)); }
+            for (size_t i = 0; i < b.size(); ++i) { CHECK(same(next[i], b[i], exact)); }
+        }
+    }
+
+    TEST_CASE("Offspring filter" * dt::test_suite("[detail]"))
+    {
+        Operon::RandomGenerator random(1234);
+        auto make = [](Operon::Scalar value, size_t terms) {
+            Operon::Vector<Node> nodes { Node::Constant(value) };
+            for (size_t i = 0; i < terms; ++i) {
+                nodes.push_back(Node::Constant(1));
+                nodes.push_back(Node(NodeType::Add));
+            }
+            Tree tree(nodes);
+            tree.UpdateNodes();
+            return tree;
+        };
+
+        std::vector<Individual> pop(2);
+        pop[0].Genotype = make(2, 1); // NOLINT
+        pop[1].Genotype = make(3, 2); // NOLINT
+
+        OffspringFilter filter;
+        CHECK(!filter.Enabled());
+        filter.MaxLength(5); // NOLINT
+        filter.RejectClones(true);
+        filter.Prepare({ pop.data(), pop.size() });
+
+        using Verdict = OffspringFilter::Verdict;
+        CHECK(filter(random, make(4, 1)) == Verdict::Accepted); // NOLINT
+        CHECK(filter(random, make(2, 1)) == Verdict::Clone); // NOLINT
+        CHECK(filter(random, make(4, 3)) == Verdict::Oversized); // NOLINT
+
+        // every child longer than the average parent (four nodes) is discarded
+        filter.MaxLength(std::numeric_limits<size_t>::max());
+        filter.TarpeianProbability(1);
+        CHECK(filter(random, make(4, 1)) == Verdict::Accepted); // NOLINT
+        CHECK(filter(random, make(4, 2)) == Verdict::Tarpeian); // NOLINT
+
+        auto stats = filter.Statistics();
+        CHECK(stats.Checked == 5);
+        CHECK(stats.Rejected() == 3);
+
+        // a worker keeps its generation going when every child is rejected
+        filter.MaxRetries(2);
+        CHECK(filter(random, make(4, 1)) == Verdict::Accepted); // NOLINT
+        CHECK(filter(random, make(2, 1)) == Verdict::Clone); // NOLINT
+        CHECK(filter(random, make(2, 1)) == Verdict::Clone); // NOLINT
+        CHECK(filter(random, make(2, 1)) == Verdict::Accepted); // NOLINT
+        CHECK(filter.Statistics().Forced == 1);
+
+        filter.Prepare({ pop.data(), pop.size() });
+        CHECK(filter.LastStatistics().Checked == 9);
+        CHECK(filter.Statistics().Checked == 0);
+        CHECK(filter.TotalStatistics().Rejected() == 5);
+    }
+
+    TEST_CASE("Offspring selection" * dt::test_suite("[detail]"))
+    {
+        auto ds = Dataset("../data/Poly-10.csv", true);
+        auto problem = Problem(ds).Target("Y").TrainingRange({ 0, 250 }).TestRange({ 250, 500 }); // NOLINT
+        problem.GetPrimitiveSet().SetConfig(PrimitiveSet::Arithmetic);
+
+        BalancedTreeCreator creator { problem.GetPrimitiveSet(), problem.InputVariables(), /*bias=*/0.0 };
+        UniformTreeInitializer treeInitializer(creator);
+        treeInitializer.ParameterizeDistribution(2, 20); // NOLINT
+        treeInitializer.SetMaxDepth(6); // NOLINT
+        SubtreeCrossover crossover { 0.9, 6, 20 }; // NOLINT
+        ChangeVariableMutation mutator { problem.InputVariables() };
+
+        Interpreter interpreter;
+        MSE mse;
+        Evaluator evaluator(problem, interpreter, mse, /*linearScaling=*/true);
+        evaluator.SetLocalOptimizationIterations(0);
+        auto comp = [](auto const& lhs, auto const& rhs) { return lhs[0] < rhs[0]; };
+        TournamentSelector selector(comp);
+
+        constexpr size_t populationSize{20};
+        constexpr size_t pressure{3};
+        Operon::RandomGenerator random(1234);
+        std::vector<Individual> pop(populationSize);
+        Operon::Vector<Operon::Scalar> buf(problem.TrainingRange().Size());
+        for (auto& ind : pop) {
+            ind.Genotype = treeInitializer(random);
+            ind.Fitness = evaluator(random, ind, { buf.data(), buf.size() });
+        }
+
+        OffspringSelectionGenerator generator(evaluator, crossover, mutator, selector, selector);
+        generator.MaxSelectionPressure(pressure);
+
+        // the workers share the attempts of the generation, every attempt has exactly one outcome
+        auto generate = [&]() {
+            generator.Prepare({ pop.data(), pop.size() });
+            std::vector<std::thread> workers;
+            for (size_t w = 0; w < 4; ++w) {
+                workers.emplace_back([&, w]() {
+                    Operon::RandomGenerator rng(w);
+                    Operon::Vector<Operon::Scalar> buffer(problem.TrainingRange().Size());
+                    while (!generator.Terminate()) {
+                        Individual slot;
+                        generator.Generate(rng, 1.0, 0.25, { buffer.data(), buffer.size() }, slot); // NOLINT
+                    }
+                });
+            }
+            for (auto& t : workers) { t.join(); }
+            auto const stats = generator.Statistics();
+            CHECK(stats.Attempts == pressure * populationSize);
+            CHECK(stats.Accepted + stats.Lucky + stats.Rejected + stats.Cancelled == stats.Attempts);
+            return stats;
+        };
+
+        // the children are compared with their parents until the quota is met
+        auto const compared = generate();
+        CHECK(compared.Accepted + compared.Rejected > 0);
+
+        // without a quota every child is taken as it comes
+        generator.SuccessRatio(0);
+        auto const lucky = generate();
+        CHECK(lucky.Accepted == 0);
+        CHECK(lucky.Rejected == 0);
+        CHECK(lucky.Lucky > 0);
+
+        generator.Prepare({ pop.data(), pop.size() });
+        CHECK(generator.LastStatistics().Lucky == lucky.Lucky);
+        CHECK(generator.Statistics().Attempts == 0);
+    }
+
+    TEST_CASE("Reinserters" * dt::test_suite("[detail]"))
+    {
+        Operon::RandomGenerator random(1234);
+        auto make = [](std::vector<Operon::Scalar> const& values) {
+            std::vector<Individual> inds(values.size());
+            for (size_t i = 0; i < values.size(); ++i) { inds[i][0] = values[i]; }
+            return inds;
+        };
+        auto fitness = [](std::vector<Individual> const& inds) {
+            std::vector<Operon::Scalar> values;
+            for (auto const& ind : inds) { values.push_back(ind[0]); }
+            std::sort(values.begin(), values.end());
+            return values;
+        };
+        SingleObjectiveComparison comp{0};
+
+        for (auto keys : { false, true }) {
+            KeepBestReinserter keepBest(comp);
+            ReplaceWorstReinserter replaceWorst(comp);
+            if (keys) {
+                keepBest.SetKey(ObjectiveKey(0));
+                replaceWorst.SetKey(ObjectiveKey(0));
+            }
+
+            // the best of pop + pool, including pop individuals that are better than the displaced ones
+            auto pop = make({ 1, 2, 3 });
+            auto pool = make({ 0, 5, 5 });
+            keepBest(random, pop, pool);
+            CHECK(fitness(pop) == std::vector<Operon::Scalar>{ 0, 1, 2 });
+            CHECK(fitness(pool) == std::vector<Operon::Scalar>{ 3, 5, 5 });
+
+            // larger population: the worst individuals are replaced by the whole pool
+            pop = make({ 4, 1, 3, 2 });
+            pool = make({ 7, 8 });
+            replaceWorst(random, pop, pool);
+            CHECK(fitness(pop) == std::vector<Operon::Scalar>{ 1, 2, 7, 8 });
+
+            // larger pool: the population is replaced by the best of the pool
+            pop = make({ 1, 2 });
+            pool = make({ 9, 3, 8, 4 });
+            replaceWorst(random, pop, pool);
+            CHECK(fitness(pop) == std::vector<Operon::Scalar>{ 3, 4 });
+        }
+    }
+
+    TEST_CASE("Hypervolume" * dt::test_suite("[detail]"))
+    {
+        Operon::RandomGenerator random(1234);
+
+        // staircase of three points, the reference point bounds a 4 x 4 box
+        std::vector<Operon::Scalar> points { 1, 3, 2, 2, 3, 1 };
+        std::vector<Operon::Scalar> ref { 4, 4 };
+        CHECK(Hypervolume::Compute(points, 2, ref) == doctest::Approx(6));
+        auto c = Hypervolume::Contributions(random, points, 2, ref);
+        CHECK(c == std::vector<double>{ 1, 1, 1 });
+
+        // dominated and out of bounds points do not contribute
+        points = { 1, 1, 2, 2, 5, 0 };
+        CHECK(Hypervolume::Compute(points, 2, ref) == doctest::Approx(9));
+        CHECK(Hypervolume::Contributions(random, points, 2, ref) == std::vector<double>{ 5, 0, 0 });
+
+        // the exact contributions match the difference of hypervolumes, the estimates are close to them
+        std::uniform_real_distribution<Operon::Scalar> dist(0, 1);
+        for (size_t m : { 3, 5 }) {
+            constexpr size_t n { 20 };
+            points.resize(n * m);
+            std::generate(points.begin(), points.end(), [&]() { return dist(random); });
+            ref.assign(m, Operon::Scalar { 1.1 });
+            auto const total = Hypervolume::Compute(points, m, ref);
+            auto contributions = Hypervolume::Contributions(random, points, m, ref, 100000);
+            for (size_t i = 0; i < n; ++i) {
+                auto others = points;
+                others.erase(others.begin() + static_cast<std::ptrdiff_t>(i * m), others.begin() + static_cast<std::ptrdiff_t>((i + 1) * m));
+                auto expected = total - Hypervolume::Compute(others, m, ref);
+                CHECK(contributions[i] == doctest::Approx(expected).scale(total).epsilon(m <= Hypervolume::MaxExactObjectives ? 1e-9 : 1e-2));
+            }
+        }
+    }
+
+    TEST_CASE("Hypervolume reinserter" * dt::test_suite("[detail]"))
+    {
+        Operon::RandomGenerator random(1234);
+        auto make = [](std::vector<std::pair<Operon::Scalar, Operon::Scalar>> const& values) {
+            std::vector<Individual> inds(values.size(), Individual(2));
+            for (size_t i = 0; i < values.size(); ++i) { inds[i].Fitness = { values[i].first, values[i].second }; }
+            return inds;
+        };
+
+        RankIntersectSorter sorter;
+        HypervolumeReinserter reinserter(CrowdedComparison{}, sorter);
+        // the dominated point goes first, then the point of the front that contributes the least
+        auto pop = make({ { 1, 4 }, { 3, 3 }, { 4, 1 } });
+        auto pool = make({ { 2, 2 }, { 2.5, 1.9 } });
+        reinserter(random, pop, pool);
+        std::vector<std::pair<Operon::Scalar, Operon::Scalar>> kept;
+        for (auto const& ind : pop) { kept.emplace_back(ind[0], ind[1]); }
+        std::sort(kept.begin(), kept.end());
+        CHECK(kept == std::vector<std::pair<Operon::Scalar, Operon::Scalar>>{ { 1, 4 }, { 2, 2 }, { 4, 1 } });
+    }
+
+    TEST_CASE("Termination criteria" * dt::test_suite("[detail]"))
+    {
+        auto make = [](Operon::Scalar value) {
+            Individual ind(1);
+            ind[0] = value;
+            return ind;
+        };
+
+        SUBCASE("Best so far")
+        {
+            BestSoFar best(3);
+            CHECK(best.Best() == nullptr);
+            best.Offer(0, make(2));
+            best.Offer(2, make(1));
+            best.Offer(0, make(3)); // not better than the best of the worker
+            REQUIRE(best.Best() != nullptr);
+            CHECK((*best.Best())[0] == 1);
+            best.Reset();
+            CHECK(best.Best() == nullptr);
+        }
+
+        SUBCASE("Fitness stagnation")
+        {
+            FitnessStagnation stagnation(2, 0.5);
+            std::vector<Operon::Scalar> values{ 10, 5, 4, 3.8, 3.7, 1 };
+            std::vector<bool> stops;
+            for (size_t g = 0; g < values.size(); ++g) {
+                auto best = make(values[g]);
+                stops.push_back(stagnation({ g, &best }));
+            }
+            // the window is full from the third generation, the improvement over it is 6, 1.2, 0.3 then 2.8
+            CHECK(stops == std::vector<bool>{ false, false, false, false, true, false });
+            CHECK_FALSE(stagnation({ values.size(), nullptr })); // nothing evaluated yet
+            stagnation.Reset();
+            auto best = make(1);
+            CHECK_FALSE(stagnation({ 0, &best }));
+        }
+
+        SUBCASE("Hypervolume stagnation")
+        {
+            HypervolumeStagnation stagnation(1, 0, { 4, 4 });
+            std::vector<Operon::Scalar> front{ 1, 3, 3, 1 };
+            CHECK_FALSE(stagnation({ 0, nullptr, front, 2 }));
+            CHECK(stagnation({ 1, nullptr, front, 2 }));
+            front = { 1, 3, 2, 2, 3, 1 }; // a new point in the front
+            CHECK_FALSE(stagnation({ 2, nullptr, front, 2 }));
+        }
+
+        SUBCASE("Validation plateau")
+        {
+            size_t calls{0};
+            ValidationPlateau plateau([&](Individual const& ind) { ++calls; return 10 - ind[0]; }, 1);
+            auto a = make(3);
+            auto b = make(2);
+            auto c = make(5);
+            CHECK_FALSE(plateau({ 0, &a }));
+            CHECK(plateau({ 1, &a })); // the same best, the score is not recomputed
+            CHECK(calls == 1);
+            CHECK(plateau({ 2, &b })); // a new best with a worse score does not improve the best score
+            CHECK(calls == 2);
+            CHECK_FALSE(plateau({ 3, &c }));
+            CHECK(plateau.BestScore() == 5);
+        }
+    }
+
+    TEST_CASE("Engine" * dt::test_suite("[detail]"))
+    {
+        Engine engine(2);
+        CHECK(engine.Workers() == 2);
+        CHECK(engine.Executor().num_workers() == 2);
+        CHECK(engine.Buffers().size() == 2);
+
+        // the executor outlives the taskflows run on it
+        std::atomic_size_t sum{0};
+        for (size_t r = 0; r < 3; ++r) {
+            tf::Taskflow taskflow;
+            taskflow.for_each_index(size_t{0}, size_t{10}, size_t{1}, [&](size_t k) { sum += k; });
+            engine.Executor().run(taskflow).wait();
+        }
+        CHECK(sum == 3 * 45);
+
+        SUBCASE("Runs")
+        {
+            // two runs of an algorithm on the engine with the same seed: the second one gives the same result and
+            // reuses the evaluation buffers sized by the first one
+            auto ds = Dataset("../data/Poly-10.csv", true);
+            auto problem = Problem(ds).Target("Y").TrainingRange({ 0, 250 }).TestRange({ 250, 500 }); // NOLINT
+            problem.GetPrimitiveSet().SetConfig(PrimitiveSet::Arithmetic);
+
+            BalancedTreeCreator creator { problem.GetPrimitiveSet(), problem.InputVariables(), /*bias=*/0.0 };
+            UniformTreeInitializer treeInitializer(creator);
+            treeInitializer.ParameterizeDistribution(2, 20); // NOLINT
+            treeInitializer.SetMaxDepth(6); // NOLINT
+            NormalCoefficientInitializer coeffInitializer;
+            coeffInitializer.ParameterizeDistribution(Operon::Scalar { 0 }, Operon::Scalar { 1 });
+            SubtreeCrossover crossover { 0.9, 6, 20 }; // NOLINT
+            ChangeVariableMutation mutator { problem.InputVariables() };
+
+            Interpreter interpreter;
+            MSE mse;
+            Evaluator evaluator(problem, interpreter, mse, /*linearScaling=*/true);
+            evaluator.SetLocalOptimizationIterations(0);
+            auto comp = [](auto const& lhs, auto const& rhs) { return lhs[0] < rhs[0]; };
+            TournamentSelector selector(comp);
+            KeepBestReinserter reinserter(comp);
+            BasicOffspringGenerator generator(evaluator, crossover, mutator, selector, selector);
+
+            GeneticAlgorithmConfig config {};
+            config.Generations = 5; // NOLINT
+            config.PopulationSize = 50; // NOLINT
+            config.PoolSize = 50; // NOLINT
+            config.Evaluations = std::numeric_limits<size_t>::max();
+            config.TimeLimit = std::numeric_limits<size_t>::max();
+            config.CrossoverProbability = 1.0;
+            config.MutationProbability = 0.25; // NOLINT
+            GeneticProgrammingAlgorithm gp { problem, config, treeInitializer, coeffInitializer, generator, reinserter };
+
+            auto run = [&]() {
+                gp.Reset();
+                Operon::RandomGenerator random(1234); // NOLINT
+                gp.Run(engine, random);
+                CHECK(gp.Generation() == config.Generations);
+                auto parents = gp.Parents();
+                return std::min_element(parents.begin(), parents.end(), comp)->Fitness;
+            };
+
+            auto first = run();
+            std::vector<Operon::Scalar const*> buffers;
+            for (auto const& b : engine.Buffers()) {
+                CHECK(b.size() >= problem.TrainingRange().Size());
+                buffers.push_back(b.data());
+            }
+            CHECK(run() == first);
+            for (size_t i = 0; i < buffers.size(); ++i) {
+                CHECK(engine.Buffers()[i].data() == buffers[i]);
+            }
+        }
+    }
+
+    TEST_CASE("Batch runner" * dt::test_suite("[detail]"))
+    {
+        tf::Executor executor(4);
+        BatchRunner batch(2);
+        std::atomic_size_t active{0};
+        std::atomic_size_t peak{0};
+        for (size_t i = 0; i < 6; ++i) {
+            batch.Add([&, i](tf::Executor& ex) -> BatchRunner::Summary {
+                auto const n = ++active;
+                for (auto p = peak.load(); n > p && !peak.compare_exchange_weak(p, n);) { }
+                tf::Taskflow taskflow;
+                std::atomic_size_t sum{0};
+                taskflow.for_each_index(size_t{0}, size_t{100}, size_t{1}, [&](size_t k) { sum += k; });
+                ex.run(taskflow).wait();
+                --active;
+                if (i == 3) { throw std::runtime_error("failed"); }
+                return { { "index", static_cast<double>(i) }, { "sum", static_cast<double>(sum.load()) } };
+            });
+        }
+        auto results = batch.Run(executor);
+        REQUIRE(results.size() == 6);
+        CHECK(peak <= 2);
+        for (size_t i = 0; i < results.size(); ++i) {
+            CHECK(results[i].Index == i);
+            CHECK(results[i].Succeeded() == (i != 3));
+        }
+        CHECK(results[3].Error == "failed");
+        auto mean = BatchRunner::Mean(results);
+        REQUIRE(mean.size() == 2);
+        CHECK(mean[0].first == "index");
+        CHECK(mean[0].second == doctest::Approx((0 + 1 + 2 + 4 + 5) / 5.0));
+        CHECK(mean[1].second == doctest::Approx(4950));
+
+        SUBCASE("Shared dataset")
+        {
+            Dataset ds(std::vector<std::vector<Operon::Scalar>>{ { 1, 2, 3 }, { 4, 5, 6 } });
+            auto view = ds.View();
+            CHECK(view.IsView());
+            CHECK(view.GetValues(1).data() == ds.GetValues(1).data());
+            CHECK(std::equal(view.Variables().begin(), view.Variables().end(), ds.Variables().begin(), [](auto const& a, auto const& b) { return a.Name == b.Name && a.Hash == b.Hash; }));
+        }
+    }
 } // namespace Operon::Test
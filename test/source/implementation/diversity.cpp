@@ -2,12 +2,18 @@
 // SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
 
 #include <algorithm>
+#include <array>
 #include <doctest/doctest.h>
 #include <Eigen/Core>
+#include <fmt/core.h>
+#include <taskflow/taskflow.hpp>
 
 #include "operon/analyzers/diversity.hpp"
+#include "operon/core/comparison.hpp"
 #include "operon/core/dataset.hpp"
+#include "operon/core/distance.hpp"
 #include "operon/core/pset.hpp"
+#include "operon/core/simd.hpp"
 #include "operon/core/tree.hpp"
 #include "operon/operators/creator.hpp"
 #include "operon/operators/initializer.hpp"
@@ -48,6 +54,141 @@ TEST_CASE("diversity")
 
     PopulationDiversityAnalyzer<Tree> diversityAnalyzer;
     diversityAnalyzer.Prepare(trees);
+    auto exact = diversityAnalyzer(rd);
+
+    diversityAnalyzer.SetSignatureSize(Operon::Distance::DefaultSignatureSize);
+    diversityAnalyzer.Prepare(trees);
+    auto approx = diversityAnalyzer(rd);
+    fmt::print("diversity: exact {}, minhash {}\n", exact, approx);
+    CHECK(std::abs(exact - approx) < 0.05);
+}
+
+TEST_CASE("pairwise distance matrix")
+{
+    Operon::RandomGenerator rd(1234);
+    std::uniform_int_distribution<Operon::Hash> dist(0, 100);
+
+    // more sets than the block size so that off-diagonal tiles are exercised
+    constexpr size_t n = 150;
+    std::vector<Operon::Vector<Operon::Hash>> sets(n);
+    for (auto& s : sets) {
+        s.resize(std::uniform_int_distribution<size_t>(1, 50)(rd));
+        std::generate(s.begin(), s.end(), [&]() { return dist(rd); });
+        std::sort(s.begin(), s.end());
+    }
+
+    tf::Executor executor(4);
+    Operon::Span<Operon::Vector<Operon::Hash> const> span(sets.data(), sets.size());
+    std::vector<double> matrix(n * n);
+    Operon::Distance::PairwiseMatrix(executor, span, Operon::Span<double>(matrix.data(), matrix.size()), Operon::Distance::Jaccard, 32);
+    auto means = Operon::Distance::PairwiseMeans(executor, span, Operon::Distance::Jaccard, 32);
+
+    for (size_t i = 0; i < n; ++i) {
+        double sum{0};
+        for (size_t j = 0; j < n; ++j) {
+            auto d = i == j ? 0.0 : Operon::Distance::Jaccard(sets[i], sets[j]);
+            CHECK(matrix[i * n + j] == doctest::Approx(d));
+            sum += d;
+        }
+        CHECK(means[i] == doctest::Approx(sum / (n - 1)));
+    }
+}
+
+TEST_CASE("minhash distance")
+{
+    // two identical sets and one disjoint set
+    std::vector<Operon::Vector<Operon::Hash>> sets {
+        { 1, 2, 3, 4, 5, 6, 7, 8 },
+        { 1, 2, 3, 4, 5, 6, 7, 8 },
+        { 9, 10, 11, 12, 13, 14, 15, 16 }
+    };
+    auto distances = Operon::Distance::MeanJaccardMinHash(Operon::Span<Operon::Vector<Operon::Hash> const>(sets.data(), sets.size()), 128);
+    REQUIRE(distances.size() == sets.size());
+    CHECK(distances[0] == doctest::Approx(0.5)); // distance zero to its copy and one to the disjoint set
+    CHECK(distances[1] == doctest::Approx(0.5));
+    CHECK(distances[2] == doctest::Approx(1.0));
+}
+
+TEST_CASE("portable simd")
+{
+    MESSAGE("simd target: " << Operon::Simd::Target);
+
+    SUBCASE("vectors")
+    {
+        using V = Operon::Simd::Vec<double, 4>;
+        std::array<double, 4> values { 1, -2, 3, -4 };
+        auto v = V::Load(values.data());
+        CHECK(Operon::Simd::ReduceAdd(v) == -2);
+        CHECK(Operon::Simd::ReduceAdd(Operon::Simd::Abs(v)) == 10);
+        CHECK(Operon::Simd::ReduceAdd(Operon::Simd::Cutoff(v, 3)) == 2);
+        CHECK(Operon::Simd::ReduceAdd(V::LoadPartial(values.data(), 2)) == -1);
+        CHECK(Operon::Simd::Any(v > V(2.5)));
+        CHECK(!Operon::Simd::Any(v > V(3.5)));
+        CHECK(Operon::Simd::ReduceAdd(Operon::Simd::Min(v, V(0.0))) == -6);
+
+        using U = Operon::Simd::Vec<uint32_t, 8>;
+        auto u = U::Iota();
+        CHECK(Operon::Simd::Any(u == U(7)));
+        CHECK(!Operon::Simd::Any(u == U(8)));
+    }
+
+    SUBCASE("dominance")
+    {
+        Operon::RandomGenerator rd(1234);
+        std::uniform_int_distribution<int> dist(0, 2);
+        auto reference = [](auto const* a, auto const* b, size_t m) {
+            bool better { false };
+            bool worse { false };
+            for (size_t i = 0; i < m; ++i) {
+                better |= a[i] < b[i];
+                worse |= b[i] < a[i];
+            }
+            return Operon::detail::MakeDominance(better, worse);
+        };
+        for (int k = 0; k < 1000; ++k) {
+            std::array<double, 8> a{};
+            std::array<double, 8> b{};
+            for (size_t i = 0; i < a.size(); ++i) { a[i] = dist(rd); b[i] = dist(rd); }
+            CHECK(Operon::detail::FixedDominance<2>(a.data(), b.data(), 0.0) == reference(a.data(), b.data(), 2));
+            CHECK(Operon::detail::FixedDominance<3>(a.data(), b.data(), 0.0) == reference(a.data(), b.data(), 3));
+            CHECK(Operon::detail::FixedDominance<8>(a.data(), b.data(), 0.0) == reference(a.data(), b.data(), 8));
+        }
+    }
+
+    SUBCASE("jaccard and minhash")
+    {
+        Operon::RandomGenerator rd(1234);
+        std::uniform_int_distribution<Operon::Hash> dist(0, 200);
+        auto random = [&]() {
+            Operon::Vector<Operon::Hash> h(dist(rd) % 100 + 1);
+            std::generate(h.begin(), h.end(), [&]() { return dist(rd); });
+            std::sort(h.begin(), h.end());
+            h.erase(std::unique(h.begin(), h.end()), h.end());
+            return h;
+        };
+        for (int k = 0; k < 1000; ++k) {
+            auto a = random();
+            auto b = random();
+            Operon::Vector<Operon::Hash> c;
+            std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(c));
+            auto const n = static_cast<double>(a.size() + b.size());
+            CHECK(Operon::Distance::Jaccard(a, b) == doctest::Approx((n - 2 * static_cast<double>(c.size())) / n));
+
+            // the signature of a union is the minimum of the signatures, also in the slots past the last full vector
+            Operon::Vector<Operon::Hash> u;
+            std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(u));
+            constexpr size_t slots = 13;
+            std::array<Operon::Hash, slots> sa{};
+            std::array<Operon::Hash, slots> sb{};
+            std::array<Operon::Hash, slots> su{};
+            Operon::Distance::MinHash(a, Operon::Span<Operon::Hash>(sa.data(), slots));
+            Operon::Distance::MinHash(b, Operon::Span<Operon::Hash>(sb.data(), slots));
+            Operon::Distance::MinHash(u, Operon::Span<Operon::Hash>(su.data(), slots));
+            for (size_t i = 0; i < slots; ++i) {
+                CHECK(su[i] == std::min(sa[i], sb[i]));
+            }
+        }
+    }
 }
 
 } // namespace Operon::Test
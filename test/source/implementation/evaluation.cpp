@@ -1,11 +1,31 @@
 // SPDX-License-Identifier: MIT
 // SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
 //
+#include <cstdio>
+#include <numeric>
 #include <doctest/doctest.h>
+#include <taskflow/taskflow.hpp>
+#include "operon/algorithms/model_report.hpp"
+#include "operon/core/chunked_dataset.hpp"
 #include "operon/core/dataset.hpp"
+#include "operon/core/indexed_dataset.hpp"
 #include "operon/core/format.hpp"
+#include "operon/error_metrics/error_metrics.hpp"
 #include "operon/interpreter/interpreter.hpp"
+#include "operon/interpreter/plugin.hpp"
+#include "operon/nnls/batch_optimizer.hpp"
 #include "operon/nnls/nnls.hpp"
+#include "operon/operators/coefficient_cache.hpp"
+#include "operon/operators/crossover.hpp"
+#include "operon/operators/evaluator.hpp"
+#include "operon/operators/fingerprint_cache.hpp"
+#include "operon/operators/fitness_cache.hpp"
+#include "operon/operators/generator.hpp"
+#include "operon/operators/mutation.hpp"
+#include "operon/operators/ode_evaluator.hpp"
+#include "operon/operators/selector.hpp"
+#include "operon/operators/semantic_sketch.hpp"
+#include "operon/operators/surrogate.hpp"
 #include "operon/parser/infix.hpp"
 
 namespace Operon::Test {
@@ -59,6 +79,403 @@ TEST_CASE("Evaluation correctness")
         auto res3 = X.col(0) - X.col(1) + X.col(2);
         CHECK(std::all_of(indices.begin(), indices.end(), [&](auto i) { return std::abs(estimatedValues[i] - res3(i)) < eps; }));
     }
+
+    SUBCASE("Subtree view")
+    {
+        const auto eps = 1e-6;
+
+        auto tree = InfixParser::Parse("(X1 * X2) + sin(X3 - 2.5)", tmap, map);
+        auto i = tree.Length() - 2; // root of a child branch of the root node
+        auto view = tree.View(i);
+        auto copy = tree.Subtree(i);
+        REQUIRE(view.Length() == copy.Length());
+        CHECK(view.Nodes().data() == tree.Nodes().data() + (i - tree[i].Length));
+
+        auto fromView = interpreter.Evaluate<Operon::Scalar>(view, ds, range);
+        auto fromCopy = interpreter.Evaluate<Operon::Scalar>(copy, ds, range);
+        CHECK(std::all_of(indices.begin(), indices.end(), [&](auto k) { return std::abs(fromView[k] - fromCopy[k]) < eps; }));
+
+        CHECK(view.Hash(Operon::HashMode::Strict).HashValue() == copy.Hash(Operon::HashMode::Strict).HashValue());
+        CHECK(InfixFormatter::Format(view, ds) == InfixFormatter::Format(copy, ds));
+        CHECK(view.GetCoefficients() == copy.GetCoefficients());
+    }
+
+    SUBCASE("Compiled program")
+    {
+        const auto eps = 1e-6;
+
+        auto tree = InfixParser::Parse("(X1 * X2) + sin(X3) - 2.5", tmap, map);
+        auto expected = interpreter.Evaluate<Operon::Scalar>(tree, ds, range);
+
+        auto program = interpreter.Compile<Operon::Scalar>(tree, ds);
+        CHECK(program.Size() == tree.Length());
+
+        Operon::Vector<Operon::Scalar> actual(range.Size());
+        // evaluate the same program twice to make sure it is reusable
+        for (auto k = 0; k < 2; ++k) {
+            interpreter.Evaluate<Operon::Scalar>(program, range, Operon::Span<Operon::Scalar>(actual));
+            CHECK(std::all_of(indices.begin(), indices.end(), [&](auto i) { return std::abs(expected[i] - actual[i]) < eps; }));
+        }
+
+        // the program picks up new parameters without recompilation
+        auto coeff = tree.GetCoefficients();
+        std::transform(coeff.begin(), coeff.end(), coeff.begin(), [](auto c) { return c * 2; });
+        interpreter.Evaluate<Operon::Scalar>(program, range, Operon::Span<Operon::Scalar>(actual), coeff.data());
+        tree.SetCoefficients(coeff);
+        expected = interpreter.Evaluate<Operon::Scalar>(tree, ds, range);
+        CHECK(std::all_of(indices.begin(), indices.end(), [&](auto i) { return std::abs(expected[i] - actual[i]) < eps; }));
+    }
+
+    SUBCASE("Common subexpression elimination")
+    {
+        const auto eps = 1e-6;
+
+        auto tree = InfixParser::Parse("(sin(X1 * X2) + X3) * (sin(X1 * X2) + X3) - sin(X1 * X2)", tmap, map);
+        auto expected = interpreter.Evaluate<Operon::Scalar>(tree, ds, range);
+
+        auto program = interpreter.Compile<Operon::Scalar>(tree, ds, /*deduplicate=*/true);
+        auto skipped = std::count_if(program.Code.begin(), program.Code.end(), [](auto const& op) { return op.Skip; });
+        CHECK(skipped > 0);
+
+        Operon::Vector<Operon::Scalar> actual(range.Size());
+        interpreter.Evaluate<Operon::Scalar>(program, range, Operon::Span<Operon::Scalar>(actual));
+        CHECK(std::all_of(indices.begin(), indices.end(), [&](auto i) { return std::abs(expected[i] - actual[i]) < eps; }));
+    }
+
+    SUBCASE("Subtree cache")
+    {
+        const auto eps = 1e-6;
+
+        SubtreeCache<Operon::Scalar> cache(range);
+        Operon::Vector<Operon::Scalar> actual(range.Size());
+
+        auto parent = InfixParser::Parse("(X1 * X2 + X3) * sin(X4 - X5)", tmap, map);
+        interpreter.Evaluate<Operon::Scalar>(parent, ds, range, Operon::Span<Operon::Scalar>(actual), cache);
+        CHECK(cache.Size() > 0);
+
+        // the child shares the (X1 * X2 + X3) subtree with the parent
+        auto child = InfixParser::Parse("(X1 * X2 + X3) * cos(X4 - X5)", tmap, map);
+        auto hits = cache.Hits();
+        interpreter.Evaluate<Operon::Scalar>(child, ds, range, Operon::Span<Operon::Scalar>(actual), cache);
+        CHECK(cache.Hits() > hits);
+
+        auto expected = interpreter.Evaluate<Operon::Scalar>(child, ds, range);
+        CHECK(std::all_of(indices.begin(), indices.end(), [&](auto i) { return std::abs(expected[i] - actual[i]) < eps; }));
+    }
+
+    SUBCASE("Streaming evaluation")
+    {
+        const auto eps = 1e-6;
+
+        auto tree = InfixParser::Parse("(X1 * X2) + sin(X3) - 2.5", tmap, map);
+        auto expected = interpreter.Evaluate<Operon::Scalar>(tree, ds, range);
+        auto program = interpreter.Compile<Operon::Scalar>(tree, ds);
+
+        Operon::Vector<Operon::Scalar> actual(range.Size());
+        interpreter.EvaluateStreaming<Operon::Scalar>(program, range, [&](auto values, auto offset) {
+            std::copy(values.begin(), values.end(), actual.begin() + static_cast<int64_t>(offset));
+            return true;
+        });
+        CHECK(std::all_of(indices.begin(), indices.end(), [&](auto i) { return std::abs(expected[i] - actual[i]) < eps; }));
+
+        // returning false from the callback stops the evaluation
+        size_t batches{0};
+        interpreter.EvaluateStreaming<Operon::Scalar>(program, range, [&](auto /*values*/, auto /*offset*/) { return ++batches < 2; });
+        CHECK(batches == 2);
+    }
+
+    SUBCASE("Batch evaluation")
+    {
+        const auto eps = 1e-6;
+
+        std::vector<Tree> trees {
+            InfixParser::Parse("X1 + X2 + X3", tmap, map),
+            InfixParser::Parse("exp(X1) * X4", tmap, map),
+            InfixParser::Parse("(X5 - X6) / (X7 + 1)", tmap, map)
+        };
+        auto results = interpreter.EvaluateBatch<Operon::Scalar>(trees, ds, range);
+        REQUIRE(results.size() == trees.size());
+
+        for (size_t i = 0; i < trees.size(); ++i) {
+            auto expected = interpreter.Evaluate<Operon::Scalar>(trees[i], ds, range);
+            CHECK(std::all_of(indices.begin(), indices.end(), [&](auto j) { return std::abs(expected[j] - results[i][j]) < eps; }));
+        }
+    }
+}
+
+TEST_CASE("Binary dataset")
+{
+    auto csv = Dataset("../data/Poly-10.csv", true);
+    auto const path = std::string("poly-10.opds");
+    csv.WriteBinary(path);
+    CHECK(Dataset::IsBinary(path));
+    CHECK(!Dataset::IsBinary("../data/Poly-10.csv"));
+
+    auto bin = Dataset(path);
+    CHECK(bin.IsView());
+    CHECK(bin == csv);
+    CHECK(reinterpret_cast<uintptr_t>(bin.GetValues(0).data()) % Dataset::BinaryAlignment == 0); // NOLINT
+
+    // copies of a mapped dataset remain views of the same mapping
+    auto copy = bin; // NOLINT
+    CHECK(copy.IsView());
+    CHECK(copy.GetValues("X1").data() == bin.GetValues("X1").data());
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Chunked dataset")
+{
+    auto csv = Dataset("../data/Poly-10.csv", true);
+    auto const path = std::string("poly-10-chunked.opds");
+    csv.WriteBinary(path);
+
+    auto const blockRows = 100;
+    ChunkedDataset chunked(path, blockRows, /*releaseBlocks=*/true);
+    CHECK(chunked.GetDataset().IsView());
+    CHECK(chunked.Rows() == csv.Rows());
+
+    Range range { 0, chunked.Rows() };
+    size_t blocks{0};
+    size_t rows{0};
+    chunked.ForEachBlock(range, [&](Range block) {
+        ++blocks;
+        rows += block.Size();
+        return true;
+    });
+    CHECK(rows == range.Size());
+    CHECK(blocks == (range.Size() + blockRows - 1) / blockRows);
+
+    // streaming evaluation block by block gives the same fitness
+    Problem problem(chunked.GetDataset());
+    std::unordered_map<std::string, Operon::Hash> map;
+    for (auto const& v : chunked.GetDataset().Variables()) {
+        map.insert({ v.Name, v.Hash });
+    }
+    Interpreter interpreter;
+    NMSE nmse;
+    Evaluator evaluator(problem, interpreter, nmse, /*linearScaling=*/false);
+    evaluator.SetLocalOptimizationIterations(0);
+
+    Individual ind;
+    ind.Genotype = InfixParser::Parse("X1 * X2 + X3 * X4", InfixParser::DefaultTokens(), map);
+    Operon::RandomGenerator rng(1234);
+    auto expected = evaluator(rng, ind, {});
+    evaluator.SetChunkedDataset(&chunked);
+    auto actual = evaluator(rng, ind, {});
+    CHECK(std::abs(expected.front() - actual.front()) < 1e-5);
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Single precision storage")
+{
+    auto ds = Dataset("../data/Poly-10.csv", true);
+    ds.StoreSinglePrecision();
+    REQUIRE(ds.HasSinglePrecision());
+
+    auto const hash = ds.Variables().front().Hash;
+    auto single = ds.GetValuesAs<float>(hash);
+    auto values = ds.GetValues(hash);
+    REQUIRE(single.size() == values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        CHECK(single[i] == static_cast<float>(values[i]));
+    }
+
+#if !defined(USE_SINGLE_PRECISION)
+    // evaluate in float, compare with the double precision output
+    std::unordered_map<std::string, Operon::Hash> map;
+    for (auto const& v : ds.Variables()) {
+        map.insert({ v.Name, v.Hash });
+    }
+    auto tree = InfixParser::Parse("X1 * X2 + sin(X3) - X4 / 2", InfixParser::DefaultTokens(), map);
+    Range range { 0, ds.Rows() };
+
+    GenericInterpreter<float, Operon::Scalar, Operon::Dual> interpreter;
+    auto f32 = interpreter.Evaluate<float>(tree, ds, range);
+    auto f64 = interpreter.Evaluate<Operon::Scalar>(tree, ds, range);
+    for (size_t i = 0; i < f64.size(); ++i) {
+        CHECK(std::abs(static_cast<double>(f32[i]) - f64[i]) < 1e-4 * (1 + std::abs(f64[i])));
+    }
+
+    // without the single precision copy the columns are cast by the program
+    auto plain = Dataset("../data/Poly-10.csv", true);
+    REQUIRE(!plain.HasSinglePrecision());
+    auto cast = interpreter.Evaluate<float>(tree, plain, range);
+    REQUIRE(cast.size() == f32.size());
+    for (size_t i = 0; i < f32.size(); ++i) {
+        CHECK(cast[i] == f32[i]);
+    }
+#endif
+}
+
+TEST_CASE("Indexed dataset")
+{
+    auto ds = Dataset("../data/Poly-10.csv", true);
+    Operon::RandomGenerator rng(1234);
+
+    auto const blockRows = 64;
+    auto shuffled = IndexedDataset::Shuffled(ds, rng, blockRows);
+    REQUIRE(shuffled.Rows() == ds.Rows());
+    CHECK(shuffled.BlockCount() == (ds.Rows() + blockRows - 1) / blockRows);
+
+    auto indices = shuffled.Indices();
+    auto const hash = ds.Variables().front().Hash;
+    auto values = ds.GetValues(hash);
+
+    // blocks and materialized ranges contain the permuted rows
+    auto const& block = shuffled.Block(1);
+    CHECK(&block == &shuffled.Block(1)); // gathered only once
+    for (size_t i = 0; i < block.Rows(); ++i) {
+        CHECK(block.GetValues(hash)[i] == values[indices[blockRows + i]]);
+    }
+    auto all = shuffled.Materialize();
+    CHECK(all.Variables().size() == ds.Variables().size());
+    for (size_t i = 0; i < all.Rows(); ++i) {
+        CHECK(all.GetValues(hash)[i] == values[indices[i]]);
+    }
+
+    auto folds = IndexedDataset::Folds(ds.Rows(), 3, rng);
+    REQUIRE(folds.size() == 3);
+    std::vector<size_t> covered;
+    for (auto const& f : folds) {
+        CHECK(f.size() >= ds.Rows() / 3);
+        covered.insert(covered.end(), f.begin(), f.end());
+    }
+    std::sort(covered.begin(), covered.end());
+    CHECK(covered.size() == ds.Rows());
+    CHECK(std::adjacent_find(covered.begin(), covered.end()) == covered.end());
+}
+
+TEST_CASE("Dataset from columns")
+{
+    std::vector<Operon::Scalar> values { 1, 2, 3, 4, 5, 6 };
+    std::vector<std::string> names { "a", "b" };
+
+    SUBCASE("Contiguous")
+    {
+        std::vector<Operon::Span<Operon::Scalar const>> columns { { values.data(), 3 }, { values.data() + 3, 3 } };
+        auto ds = Dataset::FromColumns(names, columns);
+        CHECK(ds.IsView());
+        CHECK(ds.GetValues("b").data() == values.data() + 3);
+    }
+
+    SUBCASE("Scattered")
+    {
+        std::vector<Operon::Span<Operon::Scalar const>> columns { { values.data() + 3, 3 }, { values.data(), 3 } };
+        auto ds = Dataset::FromColumns(names, columns);
+        CHECK(!ds.IsView());
+        CHECK(ds.GetValues("a")[0] == 4);
+        CHECK(ds.GetValues("b")[2] == 3);
+    }
+}
+
+TEST_CASE("Simplification")
+{
+    auto ds = Dataset("../data/Poly-10.csv", true);
+    auto range = Range { 0, ds.Rows() };
+    Interpreter interpreter;
+
+    robin_hood::unordered_map<std::string, Operon::Hash> map;
+    for (auto const& v : ds.Variables()) { map[v.Name] = v.Hash; }
+    auto tmap = InfixParser::DefaultTokens();
+
+    auto check = [&](std::string const& infix, size_t expectedLength) {
+        auto tree = InfixParser::Parse(infix, tmap, map);
+        auto simplified = tree;
+        simplified.Simplify();
+        CHECK(simplified.Length() == expectedLength);
+
+        auto lhs = interpreter.Evaluate<Operon::Scalar>(tree, ds, range);
+        auto rhs = interpreter.Evaluate<Operon::Scalar>(simplified, ds, range);
+        for (size_t i = 0; i < lhs.size(); ++i) {
+            CHECK(lhs[i] == doctest::Approx(rhs[i]));
+        }
+    };
+
+    check("(2.0 + 3.0) * X1", 3);             // constant folding
+    check("X1 * 1.0 + 0.0", 1);               // identities
+    check("X1 + 2.0 + X2 + 3.0", 4);          // flattened, merged constants
+    check("X1 - X1 + X2", 1);                 // identical subtrees
+    check("square(sqrt(X2 * X2))", 3);        // square(sqrt(x)) = x
+    check("sin(X1) / sin(X1)", 1);
+}
+
+TEST_CASE("Column statistics")
+{
+    std::vector<Operon::Scalar> values { 1, 2, 3, 4, 5, 6 };
+    std::vector<std::string> names { "a", "b" };
+    std::vector<Operon::Span<Operon::Scalar const>> columns { { values.data(), 3 }, { values.data() + 3, 3 } };
+    auto ds = Dataset::FromColumns(names, columns);
+    auto b = ds.GetVariable("b").value();
+
+    auto stats = ds.Statistics(b, Range(0, 3));
+    CHECK(stats.Count == 3);
+    CHECK(stats.Mean == doctest::Approx(5));
+    CHECK(stats.Variance == doctest::Approx(2. / 3));
+    CHECK(stats.Min == 4);
+    CHECK(stats.Max == 6);
+
+    auto part = ds.Statistics(b.Hash, Range(1, 3));
+    CHECK(part.Count == 2);
+    CHECK(part.Mean == doctest::Approx(5.5));
+
+    // the streamed normalization agrees with the one computed from the target values
+    NMSE nmse; R2 r2;
+    auto target = ds.GetValues(b.Hash);
+    CHECK(nmse.Normalization(stats) == doctest::Approx(nmse.Normalization(target)));
+    CHECK(r2.Normalization(stats) == doctest::Approx(r2.Normalization(target)));
+
+    std::vector<Operon::Scalar> estimated { 4.5, 5, 6.5 };
+    Operon::Span<Operon::Scalar const> est(estimated.data(), estimated.size());
+    auto streamed = r2.Finalize(r2.Accumulate(est, target), target.size(), r2.Normalization(stats));
+    CHECK(streamed == doctest::Approx(r2(est, target)));
+}
+
+TEST_CASE("Bulk preprocessing")
+{
+    auto ds = Dataset("../data/Poly-10.csv", /*hasHeader=*/true);
+    auto const original = ds;
+    auto reference = ds;
+    Range range { 0, ds.Rows() / 2 };
+
+    std::vector<size_t> columns;
+    for (auto const& v : ds.Variables()) {
+        if (v.Name != "Y") { columns.push_back(v.Index); }
+    }
+    ds.Preprocess(columns, range, ColumnScaling::Standardize);
+    for (auto i : columns) { reference.Standardize(i, range); }
+
+    for (auto const& v : ds.Variables()) {
+        auto values = ds.GetValues(v.Hash);
+        auto expected = reference.GetValues(v.Hash);
+        CHECK(std::equal(values.begin(), values.end(), expected.begin()));
+
+        // the cached statistics are those of the transformed values
+        auto stats = ds.Statistics(v.Hash, range);
+        auto computed = Dataset(ds).Statistics(v.Hash, range);
+        CHECK(stats.Mean == doctest::Approx(computed.Mean));
+        CHECK(stats.Variance == doctest::Approx(computed.Variance));
+        CHECK(stats.Min == doctest::Approx(computed.Min));
+        CHECK(stats.Max == doctest::Approx(computed.Max));
+
+        // the transforms are inverted
+        auto transform = ds.Transform(v.Hash);
+        CHECK(transform.IsIdentity() == (v.Name == "Y"));
+        auto source = original.GetValues(v.Hash);
+        for (size_t i = 0; i < values.size(); ++i) {
+            CHECK(transform.Invert(values[i]) == doctest::Approx(source[i]));
+        }
+    }
+
+    // the transforms compose
+    ds.Preprocess(columns, range, ColumnScaling::Normalize, 2);
+    for (auto const& v : ds.Variables()) {
+        if (v.Name == "Y") { continue; }
+        CHECK(ds.Statistics(v.Hash, range).Min == doctest::Approx(0));
+        CHECK(ds.Statistics(v.Hash, range).Max == doctest::Approx(1));
+        auto values = ds.GetValues(v.Hash);
+        auto source = original.GetValues(v.Hash);
+        CHECK(ds.Transform(v.Hash).Invert(values.back()) == doctest::Approx(source.back()));
+    }
 }
 
 TEST_CASE("Numeric optimization")
@@ -129,5 +546,1582 @@ TEST_CASE("tiny bug")
 }
 
 
-} // namespace Operon::Test
+TEST_CASE("Reverse mode jacobian")
+{
+    auto ds = Dataset("../data/Pagie-1.csv", true);
+    std::unordered_map<std::string, Operon::Hash> map;
+    for (auto const& v : ds.Variables()) {
+        map.insert({ v.Name, v.Hash });
+    }
+    auto tmap = InfixParser::DefaultTokens();
+
+    Interpreter interpreter;
+    auto range = Range { 0, ds.Rows() };
+    auto target = ds.GetValues("F");
+
+    for (auto const* infix : {
+        "(2.5 * X + 1.5 * Y) * (0.5 * X - Y) / (1.2 + Y)",
+        "exp(0.1 * X) - sin(Y * 0.7) + cos(X) * tanh(Y)",
+        "sqrt(square(X) + 1) + log(square(Y) + 1) - square(X) * 0.3",
+        "1.5 * X - 2.3 * Y - 0.5 * X - Y" }) {
+        auto tree = InfixParser::Parse(infix, tmap, map);
+        ResidualEvaluator re(interpreter, tree, ds, target, range);
+        REQUIRE(re.HasReverseMode());
+
+        auto coeff = tree.GetCoefficients();
+        auto const rows = static_cast<Eigen::Index>(re.NumResiduals());
+        auto const cols = static_cast<Eigen::Index>(re.NumParameters());
+
+        Eigen::Matrix<Operon::Scalar, -1, -1> forward(rows, cols);
+        Eigen::Matrix<Operon::Scalar, -1, -1> reverse(rows, cols);
+        Eigen::Matrix<Operon::Scalar, -1, 1> r1(rows);
+        Eigen::Matrix<Operon::Scalar, -1, 1> r2(rows);
+
+        Eigen::Matrix<Operon::Scalar, -1, -1> adaptive(rows, cols);
+        detail::Autodiff<ResidualEvaluator, Operon::Dual, Operon::Scalar, Eigen::ColMajor>(re, coeff.data(), r1.data(), forward.data());
+        detail::AutodiffAdaptive<ResidualEvaluator, Operon::Scalar, Eigen::ColMajor>(re, coeff.data(), nullptr, adaptive.data());
+        re.Jacobian<Eigen::ColMajor>(coeff.data(), r2.data(), reverse.data());
+
+        auto const eps = 1e-4;
+        CHECK((r1 - r2).cwiseAbs().maxCoeff() < eps);
+        CHECK((forward - reverse).cwiseAbs().maxCoeff() < eps * (1 + forward.cwiseAbs().maxCoeff()));
+        CHECK((forward - adaptive).cwiseAbs().maxCoeff() < eps * (1 + forward.cwiseAbs().maxCoeff()));
+    }
+}
+
+TEST_CASE("Mixed dual evaluation")
+{
+    auto ds = Dataset("../data/Pagie-1.csv", true);
+    std::unordered_map<std::string, Operon::Hash> map;
+    for (auto const& v : ds.Variables()) {
+        map.insert({ v.Name, v.Hash });
+    }
+    auto tmap = InfixParser::DefaultTokens();
+
+    Interpreter interpreter;
+    auto range = Range { 0, ds.Rows() };
+    auto tree = InfixParser::Parse("exp(0.1 * X) * (2.5 * X + 1.5 * Y) - sin(Y * 0.7) / (1.2 + cos(0.3 * X)) + log(square(Y) + 1)", tmap, map);
+    auto coeff = tree.GetCoefficients();
+    REQUIRE(coeff.size() > static_cast<size_t>(Operon::Dual::DIMENSION));
+
+    auto scalar = interpreter.Compile<Operon::Scalar>(tree, ds);
+    auto dual = interpreter.Compile<Operon::Dual>(tree, ds);
+    Operon::Vector<Operon::Dual> parameters(coeff.size());
+    Operon::Vector<Operon::Dual> expected(range.Size());
+    Operon::Vector<Operon::Dual> actual(range.Size());
+
+    // one jet chunk at a time, as in detail::Autodiff
+    for (size_t s = 0; s < coeff.size(); s += Operon::Dual::DIMENSION) {
+        for (size_t i = 0; i < coeff.size(); ++i) {
+            parameters[i].a = coeff[i];
+            parameters[i].v.setZero();
+            if (i >= s && i < s + Operon::Dual::DIMENSION) { parameters[i].v[static_cast<Eigen::Index>(i - s)] = 1; }
+        }
+        interpreter.Evaluate<Operon::Dual>(dual, range, { expected.data(), expected.size() }, parameters.data());
+        interpreter.EvaluateMixed<Operon::Dual>(scalar, dual, range, { actual.data(), actual.size() }, parameters.data());
+
+        auto maxError{0.0};
+        for (size_t i = 0; i < range.Size(); ++i) {
+            maxError = std::max(maxError, static_cast<double>(std::abs(expected[i].a - actual[i].a)));
+            maxError = std::max(maxError, static_cast<double>((expected[i].v - actual[i].v).cwiseAbs().maxCoeff()));
+        }
+        CHECK(maxError < 1e-6);
+    }
+}
+
+namespace {
+    // the kernels of a plugin, given by a descriptor in the process instead of a shared library
+    void PluginMul(double* out, double const* const* args, int /*arity*/, int rows)
+    {
+        for (int r = 0; r < rows; ++r) { out[r] = args[0][r] * args[1][r]; } // NOLINT
+    }
+
+    void PluginMulDual(double* out, double* dout, double const* const* args, double const* const* dargs, int /*arity*/, int rows, int width)
+    {
+        PluginMul(out, args, 2, rows);
+        for (int j = 0; j < width; ++j) {
+            for (int r = 0; r < rows; ++r) {
+                dout[j * rows + r] = dargs[0][j * rows + r] * args[1][r] + args[0][r] * dargs[1][j * rows + r]; // NOLINT
+            }
+        }
+    }
+
+    void PluginSub(double* out, double const* const* args, int /*arity*/, int rows)
+    {
+        for (int r = 0; r < rows; ++r) { out[r] = args[0][r] - args[1][r]; } // NOLINT
+    }
+} // namespace
+
+TEST_CASE("Primitive plugin")
+{
+    constexpr Eigen::Index rows{1000};
+    Eigen::Matrix<Operon::Scalar, -1, -1> data = Eigen::Matrix<Operon::Scalar, -1, -1>::Random(rows, 3);
+    Dataset ds(data);
+    auto const x = ds.Variables()[0].Hash;
+    auto const y = ds.Variables()[1].Hash;
+    auto const range = Range { 0, ds.Rows() };
+    auto const target = ds.GetValues(ds.Variables()[2].Hash);
+
+    std::array descriptors {
+        operon_primitive { "plugin_mul", 2, 2, PluginMul, PluginMulDual },
+        operon_primitive { "plugin_sub", 2, 2, PluginSub, nullptr }, // differentiated numerically
+    };
+    operon_plugin plugin { OPERON_PLUGIN_ABI_VERSION, static_cast<uint32_t>(descriptors.size()), descriptors.data() };
+    auto const primitives = Plugin::Read(plugin);
+    REQUIRE(primitives.size() == 2);
+    CHECK(primitives[0].Hash == Plugin::HashName("plugin_mul"));
+
+    Interpreter interpreter;
+    for (auto const& p : primitives) { Plugin::Register(interpreter.GetDispatchTable(), p); }
+
+    PrimitiveSet pset(PrimitiveSet::Arithmetic);
+    CHECK(Plugin::Add(pset, primitives[0]));
+    CHECK(pset.Contains(primitives[0].Hash));
+
+    // the same tree with the plugin primitive and the built-in one
+    auto make = [&](Node f) {
+        Node vx(NodeType::Variable, x);
+        Node vy(NodeType::Variable, y);
+        vx.Value = 1.5; // NOLINT
+        vy.Value = -0.5; // NOLINT
+        f.Arity = 2;
+        Tree tree({ vy, vx, f });
+        tree.UpdateNodes();
+        return tree;
+    };
+
+    for (auto [p, builtin] : { std::pair{0, NodeType::Mul}, std::pair{1, NodeType::Sub} }) {
+        auto const dynamic = make(primitives[p].MakeNode());
+        auto const reference = make(Node(builtin));
+
+        auto const expected = interpreter.Evaluate<Operon::Scalar>(reference, ds, range);
+        auto const actual = interpreter.Evaluate<Operon::Scalar>(dynamic, ds, range);
+        auto maxError{0.0};
+        for (size_t i = 0; i < range.Size(); ++i) { maxError = std::max(maxError, static_cast<double>(std::abs(expected[i] - actual[i]))); }
+        CHECK(maxError < 1e-12);
+
+        // forward mode jacobians, from the dual kernel and from the central differences
+        ResidualEvaluator re1(interpreter, reference, ds, target, range);
+        ResidualEvaluator re2(interpreter, dynamic, ds, target, range);
+        CHECK(!re2.HasReverseMode());
+        auto coeff = reference.GetCoefficients();
+        Eigen::Matrix<Operon::Scalar, -1, -1> j1(rows, 2);
+        Eigen::Matrix<Operon::Scalar, -1, -1> j2(rows, 2);
+        detail::Autodiff<ResidualEvaluator, Operon::Dual, Operon::Scalar, Eigen::ColMajor>(re1, coeff.data(), nullptr, j1.data());
+        detail::Autodiff<ResidualEvaluator, Operon::Dual, Operon::Scalar, Eigen::ColMajor>(re2, coeff.data(), nullptr, j2.data());
+        CHECK((j1 - j2).cwiseAbs().maxCoeff() < (p == 0 ? 1e-12 : 1e-6));
+    }
+
+    descriptors[1].max_arity = Plugin::MaxArity + 1;
+    CHECK_THROWS_AS((void)Plugin::Read(plugin), std::runtime_error);
+    plugin.abi_version = OPERON_PLUGIN_ABI_VERSION + 1;
+    CHECK_THROWS_AS((void)Plugin::Read(plugin), std::runtime_error);
+    CHECK_THROWS_AS((void)Plugin::Load("./no-such-plugin.so"), std::runtime_error);
+}
+
+TEST_CASE("Fused evaluation")
+{
+    auto ds = Dataset("../data/Pagie-1.csv", true);
+    std::unordered_map<std::string, Operon::Hash> map;
+    for (auto const& v : ds.Variables()) {
+        map.insert({ v.Name, v.Hash });
+    }
+    auto tmap = InfixParser::DefaultTokens();
+
+    Interpreter interpreter;
+    auto range = Range { 0, ds.Rows() };
+    using Fusion = Interpreter::Program<Operon::Scalar>::Fusion;
+
+    for (auto const* infix : { "2.5 * X + 1.5 * Y + 1", "exp(0.1 * X)", "square(0.7 * Y) * X * Y * 1.3 * X * (0.2 * Y)", "sin(Y * 0.7) / (1.2 + cos(0.3 * X) + log(square(Y) + 1))" }) {
+        auto tree = InfixParser::Parse(infix, tmap, map);
+        auto coeff = tree.GetCoefficients();
+
+        auto scalar = interpreter.Compile<Operon::Scalar>(tree, ds);
+        CHECK(std::any_of(scalar.Code.begin(), scalar.Code.end(), [](auto const& op) { return op.Fuse != Fusion::None; }));
+
+        // the dual programs do not use the superinstructions
+        auto dual = interpreter.Compile<Operon::Dual>(tree, ds);
+        Operon::Vector<Operon::Dual> parameters(coeff.size());
+        for (size_t i = 0; i < coeff.size(); ++i) { parameters[i].a = coeff[i]; parameters[i].v.setZero(); }
+        Operon::Vector<Operon::Dual> expected(range.Size());
+        interpreter.Evaluate<Operon::Dual>(dual, range, { expected.data(), expected.size() }, parameters.data());
+
+        Operon::Vector<Operon::Scalar> actual(range.Size());
+        Operon::Vector<Operon::Scalar> weighted(range.Size());
+        interpreter.Evaluate<Operon::Scalar>(scalar, range, { actual.data(), actual.size() });
+        interpreter.Evaluate<Operon::Scalar>(scalar, range, { weighted.data(), weighted.size() }, coeff.data());
+
+        auto maxError{0.0};
+        for (size_t i = 0; i < range.Size(); ++i) {
+            maxError = std::max(maxError, static_cast<double>(std::abs(expected[i].a - actual[i])));
+            maxError = std::max(maxError, static_cast<double>(std::abs(expected[i].a - weighted[i])));
+        }
+        CHECK(maxError < 1e-6);
+    }
+}
+
+TEST_CASE("Direct output evaluation")
+{
+    auto ds = Dataset("../data/Pagie-1.csv", true);
+    std::unordered_map<std::string, Operon::Hash> map;
+    for (auto const& v : ds.Variables()) {
+        map.insert({ v.Name, v.Hash });
+    }
+    auto tmap = InfixParser::DefaultTokens();
+
+    Interpreter interpreter;
+
+    // the root writes into the output, partial batches are computed over their rows only
+    for (auto const* infix : { "X + Y * 2.1", "exp(0.1 * X)", "sin(X) / (1.5 + Y)", "pow(square(X), 1.2)", "sqrt(square(X) + Y)" }) {
+        auto tree = InfixParser::Parse(infix, tmap, map);
+        auto program = interpreter.Compile<Operon::Scalar>(tree, ds);
+
+        for (auto range : { Range { 0, ds.Rows() }, Range { 3, 70 }, Range { 1, 2 } }) {
+            Operon::Vector<Operon::Scalar> expected(range.Size());
+            interpreter.EvaluateStreaming<Operon::Scalar>(program, range, [&](auto values, size_t offset) {
+                std::copy(values.begin(), values.end(), expected.begin() + static_cast<std::ptrdiff_t>(offset));
+                return true;
+            });
+
+            Operon::Vector<Operon::Scalar> actual(range.Size());
+            interpreter.Evaluate<Operon::Scalar>(program, range, { actual.data(), actual.size() });
+            // the scalar tail of a partial batch may round differently than the packet math
+            auto maxError{0.0};
+            for (size_t i = 0; i < range.Size(); ++i) {
+                maxError = std::max(maxError, static_cast<double>(std::abs(expected[i] - actual[i])));
+            }
+            CHECK(maxError < 1e-6);
+        }
+    }
+}
+
+TEST_CASE("Gather evaluation")
+{
+    auto ds = Dataset("../data/Poly-10.csv", true);
+    std::unordered_map<std::string, Operon::Hash> map;
+    for (auto const& v : ds.Variables()) {
+        map.insert({ v.Name, v.Hash });
+    }
+    auto tree = InfixParser::Parse("X1 * X2 + sin(X5) / (X6 + 2) + X1 * X2", InfixParser::DefaultTokens(), map);
+
+    Interpreter interpreter;
+    auto const full = interpreter.Evaluate<Operon::Scalar>(tree, ds, Range { 0, ds.Rows() });
+
+    // a random sample with repetitions, more rows than a batch
+    Operon::RandomGenerator rng(1234);
+    std::vector<uint32_t> rows(1000); // NOLINT
+    for (auto& r : rows) { r = static_cast<uint32_t>(Random::Bounded(rng, ds.Rows())); }
+    Operon::Span<uint32_t const> sample(rows.data(), rows.size());
+
+    Operon::Vector<Operon::Scalar> estimated(rows.size());
+    for (auto deduplicate : { false, true }) {
+        auto const program = interpreter.Compile<Operon::Scalar>(tree, ds, deduplicate);
+        interpreter.Evaluate<Operon::Scalar>(program, sample, { estimated.data(), estimated.size() });
+        for (size_t i = 0; i < rows.size(); ++i) {
+            CHECK(estimated[i] == doctest::Approx(full[rows[i]]));
+        }
+    }
+
+    // the gathered targets give the reductions of the materialized ones
+    auto const target = ds.GetValues("Y");
+    Operon::Vector<Operon::Scalar> gathered(rows.size());
+    Kernels::Gather(target, sample, { gathered.data(), gathered.size() });
+    Operon::Span<Operon::Scalar const> x(estimated.data(), estimated.size());
+    Operon::Span<Operon::Scalar const> y(gathered.data(), gathered.size());
+    CHECK(Kernels::SumOfSquaredErrors(x, target, sample) == doctest::Approx(Kernels::SumOfSquaredErrors(x, y)));
+    CHECK(Kernels::SumOfAbsoluteErrors(x, target, sample) == doctest::Approx(Kernels::SumOfAbsoluteErrors(x, y)));
+    CHECK(Kernels::Moments(x, target, sample).Covariance == doctest::Approx(Kernels::Moments(x, y).Covariance));
+}
+
+TEST_CASE("Packed inputs")
+{
+    auto ds = Dataset("../data/Poly-10.csv", true);
+    std::unordered_map<std::string, Operon::Hash> map;
+    for (auto const& v : ds.Variables()) {
+        map.insert({ v.Name, v.Hash });
+    }
+    auto parse = [&](auto const* model) { return InfixParser::Parse(model, InfixParser::DefaultTokens(), map); };
+
+    // tiles smaller than a batch and not dividing the rows, so the batches end early and the last tile is partial
+    constexpr size_t tileRows{37};
+    Problem problem(ds);
+    CHECK(problem.GetPackedInputs() == nullptr);
+    problem.PackInputs(tileRows);
+    auto const* packed = problem.GetPackedInputs();
+    REQUIRE(packed != nullptr);
+    CHECK(packed->Cols() == problem.InputVariables().size());
+    CHECK(packed->Tiles() == (ds.Rows() + tileRows - 1) / tileRows);
+    CHECK(packed->Column(problem.TargetVariable().Hash) == -1);
+    for (size_t c = 0; c < packed->Cols(); ++c) {
+        auto const values = ds.GetValues(problem.InputVariables()[c]);
+        for (auto r : { size_t{0}, tileRows - 1, tileRows, ds.Rows() - 1 }) {
+            CHECK(packed->Value(r, c) == values[r]);
+        }
+    }
+
+    Interpreter interpreter;
+    auto const range = Range { 3, ds.Rows() - 5 };
+    auto const tree = parse("X1 * X2 + sin(X5) / (X6 + 2) + X1 * X2");
+    auto const expected = interpreter.Evaluate<Operon::Scalar>(tree, ds, range);
+
+    for (auto deduplicate : { false, true }) {
+        auto const program = interpreter.Compile<Operon::Scalar>(tree, ds, *packed, deduplicate);
+        CHECK(program.TileRows == tileRows);
+
+        Operon::Vector<Operon::Scalar> estimated(range.Size());
+        interpreter.Evaluate<Operon::Scalar>(program, range, { estimated.data(), estimated.size() });
+        for (size_t i = 0; i < range.Size(); ++i) { CHECK(estimated[i] == doctest::Approx(expected[i])); }
+
+        size_t rows{0};
+        interpreter.EvaluateStreaming<Operon::Scalar>(program, range, [&](auto values, auto offset) {
+            CHECK(offset == rows);
+            CHECK(values.size() <= tileRows);
+            for (size_t i = 0; i < values.size(); ++i) { CHECK(values[i] == doctest::Approx(expected[offset + i])); }
+            rows += values.size();
+            return true;
+        });
+        CHECK(rows == range.Size());
+
+        std::vector<uint32_t> sample { 0, 36, 37, 400, 4, 4, static_cast<uint32_t>(ds.Rows() - 1) };
+        Operon::Vector<Operon::Scalar> gathered(sample.size());
+        interpreter.Evaluate<Operon::Scalar>(program, Operon::Span<uint32_t const>(sample.data(), sample.size()), { gathered.data(), gathered.size() });
+        auto const full = interpreter.Evaluate<Operon::Scalar>(tree, ds, Range { 0, ds.Rows() });
+        for (size_t i = 0; i < sample.size(); ++i) { CHECK(gathered[i] == doctest::Approx(full[sample[i]])); }
+    }
+
+    // the target is not packed, the tree reads the dataset
+    CHECK(interpreter.Compile<Operon::Scalar>(parse("X1 + Y"), ds, *packed).TileRows == 0);
+
+    // the evaluator gives the same fitness on the packed inputs
+    MSE mse;
+    Evaluator evaluator(problem, interpreter, mse, /*linearScaling=*/true);
+    evaluator.SetLocalOptimizationIterations(0);
+    Operon::RandomGenerator rng(1234);
+    Individual ind;
+    ind.Genotype = tree;
+    auto const fitness = evaluator(rng, ind, {});
+    Problem unpacked(ds);
+    Evaluator reference(unpacked, interpreter, mse, /*linearScaling=*/true);
+    reference.SetLocalOptimizationIterations(0);
+    CHECK(fitness.front() == doctest::Approx(reference(rng, ind, {}).front()));
+
+    // scaling the data drops the packed copy
+    problem.StandardizeData(problem.TrainingRange());
+    CHECK(problem.GetPackedInputs() == nullptr);
+}
+
+TEST_CASE("Virtual columns")
+{
+    auto ds = Dataset("../data/Poly-10.csv", true);
+    auto const x1 = ds.GetVariable("X1").value();
+    auto const x2 = ds.GetVariable("X2").value();
+    auto const cols = ds.Cols();
+    auto const n = ds.Rows();
+
+    // the lag view reads the column of its source
+    constexpr size_t lag{3};
+    auto const lagged = ds.AddLag(x1, lag);
+    CHECK(lagged.Name == "X1_lag3");
+    CHECK(lagged.Index == cols);
+    CHECK(ds.Cols() == cols);
+    CHECK(ds.IsVirtual(lagged.Hash));
+    CHECK(ds.FirstRow(lagged.Hash) == lag);
+    CHECK(ds.GetValues(lagged).data() == ds.GetValues(x1).data());
+    CHECK(ds.GetValues(lagged).size() == n - lag);
+    CHECK_THROWS(ds.AddLag(x1, lag));
+    CHECK_THROWS(ds.AddLag(x1, n));
+    CHECK_THROWS(ds.AddLag(lagged, n - lag));
+
+    constexpr Operon::Scalar step{0.5};
+    auto const derivative = ds.AddDerivative(x1, step);
+    CHECK(derivative.Name == "dX1");
+    CHECK(ds.FirstRow(derivative.Hash) == 0);
+    auto const x = ds.GetValues(x1);
+    auto const dx = ds.GetValues(derivative);
+    CHECK(dx[0] == doctest::Approx((x[1] - x[0]) / step));
+    CHECK(dx[10] == doctest::Approx((x[11] - x[9]) / (2 * step)));
+    CHECK(dx[n - 1] == doctest::Approx((x[n - 1] - x[n - 2]) / step));
+    CHECK(ds.VirtualSizeInBytes() == n * sizeof(Operon::Scalar));
+    // a new derivative leaves the values of the existing ones in place
+    auto const second = ds.AddDerivative(x2);
+    CHECK(ds.GetValues(derivative).data() == dx.data());
+    CHECK(ds.GetValues(second)[10] == doctest::Approx((ds.GetValues(x2)[11] - ds.GetValues(x2)[9]) / 2));
+
+    std::unordered_map<std::string, Operon::Hash> map;
+    for (auto const& v : ds.Variables()) { map.insert({ v.Name, v.Hash }); }
+    for (auto const& v : ds.VirtualVariables()) { map.insert({ v.Name, v.Hash }); }
+    auto parse = [&](auto const* model) { return InfixParser::Parse(model, InfixParser::DefaultTokens(), map); };
+
+    // the interpreter reads them like the other variables, from the first row of the lag on
+    Interpreter interpreter;
+    auto const range = Range { lag, n };
+    auto const y = ds.GetValues(x2);
+    std::vector<std::pair<char const*, std::function<Operon::Scalar(size_t)>>> models {
+        { "X1_lag3 + X2", [&](size_t r) { return x[r - lag] + y[r]; } },
+        { "X1_lag3 * X2 + dX1", [&](size_t r) { return x[r - lag] * y[r] + dx[r]; } },
+        { "sin(X1_lag3) * dX1", [&](size_t r) { return std::sin(x[r - lag]) * dx[r]; } },
+    };
+    for (auto const& [model, expected] : models) {
+        auto const tree = parse(model);
+        CHECK(interpreter.Compile<Operon::Scalar>(tree, ds).FirstRow == lag);
+        auto const estimated = interpreter.Evaluate<Operon::Scalar>(tree, ds, range);
+        for (size_t r = lag; r < n; ++r) { CHECK(estimated[r - lag] == doctest::Approx(expected(r))); }
+    }
 
+    auto const tree = parse("X1_lag3 * X2 + dX1");
+    std::vector<uint32_t> rows { 3, 100, 4, static_cast<uint32_t>(n - 1) };
+    Operon::Vector<Operon::Scalar> gathered(rows.size());
+    interpreter.Evaluate<Operon::Scalar>(tree, ds, Operon::Span<uint32_t const>(rows.data(), rows.size()), { gathered.data(), gathered.size() });
+    for (size_t i = 0; i < rows.size(); ++i) { CHECK(gathered[i] == doctest::Approx(x[rows[i] - lag] * y[rows[i]] + dx[rows[i]])); }
+
+    // the copies rebase the lag views on their own columns
+    Dataset copy(ds);
+    CHECK(copy.GetValues(lagged).data() == copy.GetValues(x1).data());
+    CHECK(copy.FirstRow(lagged.Hash) == lag);
+
+    // the derivative follows its scaled source, the lag view reads it
+    ds.Standardize(x1.Index, range);
+    ds.Standardize(derivative.Index, range); // does nothing
+    auto const z = ds.GetValues(x1);
+    CHECK(ds.GetValues(derivative)[10] == doctest::Approx((z[11] - z[9]) / (2 * step)));
+    CHECK(ds.GetValues(lagged)[0] == z[0]);
+    CHECK(ds.Statistics(lagged.Hash, range).Mean == doctest::Approx(ds.Statistics(x1.Hash, Range { 0, n - lag }).Mean));
+    CHECK_THROWS(ds.Statistics(lagged.Hash, Range { 0, n }));
+    CHECK_THROWS(ds.Sample(Range { 0, n }, 10));
+    Operon::RandomGenerator rng(1234);
+    CHECK_THROWS(ds.Shuffle(rng));
+}
+
+TEST_CASE("Specialized kernels")
+{
+    auto ds = Dataset("../data/Pagie-1.csv", true);
+    std::unordered_map<std::string, Operon::Hash> map;
+    for (auto const& v : ds.Variables()) {
+        map.insert({ v.Name, v.Hash });
+    }
+    auto tmap = InfixParser::DefaultTokens();
+    auto range = Range { 0, ds.Rows() };
+
+    Interpreter generic;
+    Interpreter interpreter;
+    CHECK(interpreter.Kernel() == Operon::detail::GenericKernel);
+    interpreter.SetKernel(PrimitiveSet::Arithmetic | NodeType::Exp);
+    CHECK(interpreter.Kernel() == PrimitiveSet::TypeCoherent);
+    interpreter.SetKernel(PrimitiveSet::Full | NodeType::Floor);
+    CHECK(interpreter.Kernel() == Operon::detail::GenericKernel);
+
+    for (auto kernel : Interpreter::Kernels) {
+        interpreter.SetKernel(kernel);
+        for (auto const* infix : { "X * Y + (X - 2.5) / (Y + 3.0) - 0.5 * X", "exp(0.1 * X) * sin(Y) + log(square(X) + 1)", "tan(X * 0.1) + sqrt(square(Y) + 2) * cbrt(X)" }) {
+            auto tree = InfixParser::Parse(infix, tmap, map);
+            auto program = interpreter.Compile<Operon::Scalar>(tree, ds);
+            auto inKernel = std::all_of(tree.Nodes().begin(), tree.Nodes().end(), [&](auto const& n) { return (kernel & n.Type) == n.Type; });
+            CHECK(program.Specialization == (inKernel ? kernel : Operon::detail::GenericKernel));
+
+            auto coeff = tree.GetCoefficients();
+            for (auto const* parameters : { static_cast<Operon::Scalar const*>(nullptr), coeff.data() }) {
+                auto expected = generic.Evaluate<Operon::Scalar>(tree, ds, range, parameters);
+                Operon::Vector<Operon::Scalar> actual(range.Size());
+                interpreter.Evaluate<Operon::Scalar>(program, range, { actual.data(), actual.size() }, parameters);
+                CHECK(std::equal(expected.begin(), expected.end(), actual.begin()));
+            }
+        }
+    }
+}
+
+TEST_CASE("Variable projection")
+{
+    auto ds = Dataset("../data/Pagie-1.csv", true);
+    std::unordered_map<std::string, Operon::Hash> map;
+    for (auto const& v : ds.Variables()) {
+        map.insert({ v.Name, v.Hash });
+    }
+    auto tmap = InfixParser::DefaultTokens();
+
+    Interpreter interpreter;
+    auto range = Range { 0, ds.Rows() };
+    auto x = ds.GetValues("X");
+    auto y = ds.GetValues("Y");
+
+    // y = 3 x - 2 y + sin(0.8 x) + 0.5
+    Operon::Vector<Operon::Scalar> target(range.Size());
+    for (size_t i = 0; i < target.size(); ++i) {
+        target[i] = 3 * x[i] - 2 * y[i] + std::sin(0.8F * x[i]) + 0.5F; // NOLINT
+    }
+
+    auto tree = InfixParser::Parse("X - Y + sin(1.0 * X) + 1", tmap, map);
+    auto linear = FindLinearCoefficients(tree);
+    CHECK(linear.size() == 3); // the weights of X and Y and the additive constant
+    CHECK(std::count_if(linear.begin(), linear.end(), [](auto const& c) { return c.Sign < 0; }) == 1);
+
+    NonlinearLeastSquaresOptimizer<OptimizerType::VARPRO> optimizer(interpreter, tree, ds);
+    auto summary = optimizer.Optimize(target, range, 50);
+    CHECK(summary.Success);
+
+    auto estimated = interpreter.Evaluate<Operon::Scalar>(tree, ds, range);
+    auto maxError{0.0};
+    for (size_t i = 0; i < target.size(); ++i) {
+        maxError = std::max(maxError, static_cast<double>(std::abs(estimated[i] - target[i])));
+    }
+    CHECK(maxError < 1e-3);
+}
+
+TEST_CASE("Normal equations")
+{
+    auto ds = Dataset("../data/Pagie-1.csv", true);
+    std::unordered_map<std::string, Operon::Hash> map;
+    for (auto const& v : ds.Variables()) {
+        map.insert({ v.Name, v.Hash });
+    }
+    auto tmap = InfixParser::DefaultTokens();
+
+    Interpreter interpreter;
+    auto range = Range { 0, ds.Rows() };
+    auto x = ds.GetValues("X");
+    auto y = ds.GetValues("Y");
+
+    // y = 3 x - 2 y + sin(0.8 x) + 0.5
+    Operon::Vector<Operon::Scalar> target(range.Size());
+    for (size_t i = 0; i < target.size(); ++i) {
+        target[i] = 3 * x[i] - 2 * y[i] + std::sin(0.8F * x[i]) + 0.5F; // NOLINT
+    }
+
+    auto tree = InfixParser::Parse("X - Y + sin(1.0 * X) + 1", tmap, map);
+    auto coeff = tree.GetCoefficients();
+
+    // the accumulated normal equations match those of the full jacobian
+    ResidualEvaluator re(interpreter, tree, ds, target, range);
+    auto const rows = static_cast<Eigen::Index>(re.NumResiduals());
+    auto const k = static_cast<Eigen::Index>(re.NumParameters());
+    Eigen::Matrix<Operon::Scalar, -1, -1> jac(rows, k);
+    Eigen::Matrix<Operon::Scalar, -1, 1> res(rows);
+    re.Jacobian<Eigen::ColMajor>(coeff.data(), res.data(), jac.data());
+
+    Eigen::Matrix<Operon::Scalar, -1, -1> a(k, k);
+    Eigen::Matrix<Operon::Scalar, -1, 1> g(k);
+    auto cost = re.NormalEquations(coeff.data(), a.data(), g.data());
+    auto const eps = 1e-4;
+    CHECK(std::abs(cost - 0.5 * res.squaredNorm()) < eps * (1 + cost));
+    CHECK(std::abs(cost - re.Cost(coeff.data())) < eps * (1 + cost));
+    Eigen::Matrix<Operon::Scalar, -1, -1> ata = jac.transpose() * jac;
+    Eigen::Matrix<Operon::Scalar, -1, 1> atr = jac.transpose() * res;
+    CHECK((a - ata).cwiseAbs().maxCoeff() < eps * (1 + ata.cwiseAbs().maxCoeff()));
+    CHECK((g - atr).cwiseAbs().maxCoeff() < eps * (1 + atr.cwiseAbs().maxCoeff()));
+
+    NonlinearLeastSquaresOptimizer<OptimizerType::NORMAL> optimizer(interpreter, tree, ds);
+    auto summary = optimizer.Optimize(target, range, 50);
+    CHECK(summary.Success);
+    CHECK(summary.FinalCost < 1e-3);
+
+    // the workspace of the thread is reused: a second run gives the same coefficients and a smaller problem keeps the
+    // storage of the larger one
+    auto& workspace = OptimizerWorkspace::Local();
+    auto const capacity = workspace.Capacity(1);
+    CHECK(capacity >= static_cast<size_t>(k * k));
+    auto other = InfixParser::Parse("X - Y + sin(1.0 * X) + 1", tmap, map);
+    NonlinearLeastSquaresOptimizer<OptimizerType::NORMAL>(interpreter, other, ds).Optimize(target, range, 50);
+    auto const expected = tree.GetCoefficients();
+    auto const actual = other.GetCoefficients();
+    REQUIRE(actual.size() == expected.size());
+    for (size_t i = 0; i < actual.size(); ++i) {
+        CHECK(actual[i] == doctest::Approx(expected[i]).epsilon(1e-4));
+    }
+    auto small = InfixParser::Parse("X + 1", tmap, map);
+    NonlinearLeastSquaresOptimizer<OptimizerType::NORMAL>(interpreter, small, ds).Optimize(target, range, 50);
+    CHECK(workspace.Capacity(1) == capacity);
+}
+
+TEST_CASE("Mini-batch optimizer")
+{
+    auto ds = Dataset("../data/Pagie-1.csv", true);
+    std::unordered_map<std::string, Operon::Hash> map;
+    for (auto const& v : ds.Variables()) {
+        map.insert({ v.Name, v.Hash });
+    }
+    auto tmap = InfixParser::DefaultTokens();
+
+    Interpreter interpreter;
+    auto range = Range { 0, ds.Rows() };
+    auto x = ds.GetValues("X");
+    auto y = ds.GetValues("Y");
+
+    // y = 3 x - 2 y + sin(0.8 x) + 0.5
+    Operon::Vector<Operon::Scalar> target(range.Size());
+    for (size_t i = 0; i < target.size(); ++i) {
+        target[i] = 3 * x[i] - 2 * y[i] + std::sin(0.8F * x[i]) + 0.5F; // NOLINT
+    }
+
+    auto tree = InfixParser::Parse("X - Y + sin(1.0 * X) + 1", tmap, map);
+    ResidualEvaluator re(interpreter, tree, ds, target, range);
+    auto coeff = tree.GetCoefficients();
+    auto const initial = re.Cost(coeff.data());
+
+    MiniBatchOptions options;
+    options.BatchSize = 256; // NOLINT
+    constexpr size_t steps { 2000 };
+    NonlinearLeastSquaresOptimizer<OptimizerType::MINIBATCH> optimizer(interpreter, tree, ds, options);
+    auto summary = optimizer.Optimize(target, range, steps);
+    CHECK(summary.Success);
+    CHECK(summary.JacobianEvaluations == steps);
+    CHECK(summary.FunctionEvaluations == 2);
+
+    coeff = tree.GetCoefficients();
+    CHECK(re.Cost(coeff.data()) < 1e-2 * initial);
+}
+
+TEST_CASE("Mini-batch evaluation")
+{
+    auto ds = Dataset("../data/Pagie-1.csv", true);
+    Problem problem(ds);
+    std::unordered_map<std::string, Operon::Hash> map;
+    for (auto const& v : ds.Variables()) {
+        map.insert({ v.Name, v.Hash });
+    }
+
+    Interpreter interpreter;
+    MSE mse;
+    Evaluator evaluator(problem, interpreter, mse, /*linearScaling=*/false);
+    evaluator.SetLocalOptimizationIterations(5);
+    evaluator.SetMiniBatchSize(16); // NOLINT
+
+    // every evaluation draws its own blocks of rows, so the same tree ends up with other coefficients
+    Individual ind;
+    ind.Genotype = InfixParser::Parse("1.0 * X + sin(1.0 * Y) + 1", InfixParser::DefaultTokens(), map);
+    Operon::RandomGenerator rng(1234);
+    std::vector<std::vector<Operon::Scalar>> coefficients;
+    for (auto i = 0; i < 8; ++i) { // NOLINT
+        auto copy = ind;
+        evaluator(rng, copy, {});
+        coefficients.push_back(copy.Genotype.GetCoefficients());
+    }
+    std::sort(coefficients.begin(), coefficients.end());
+    CHECK(std::unique(coefficients.begin(), coefficients.end()) - coefficients.begin() > 1);
+}
+
+TEST_CASE("Batch optimizer")
+{
+    auto ds = Dataset("../data/Pagie-1.csv", true);
+    std::unordered_map<std::string, Operon::Hash> map;
+    for (auto const& v : ds.Variables()) {
+        map.insert({ v.Name, v.Hash });
+    }
+    auto tmap = InfixParser::DefaultTokens();
+
+    Interpreter interpreter;
+    auto range = Range { 0, ds.Rows() };
+    auto x = ds.GetValues("X");
+    auto y = ds.GetValues("Y");
+
+    // y = 2 x + sin(0.5 y) - 1
+    Operon::Vector<Operon::Scalar> target(range.Size());
+    for (size_t i = 0; i < target.size(); ++i) {
+        target[i] = 2 * x[i] + std::sin(0.5F * y[i]) - 1; // NOLINT
+    }
+
+    std::vector<Tree> trees {
+        InfixParser::Parse("1.0 * X + sin(1.0 * Y) + 0.0", tmap, map),
+        InfixParser::Parse("1.0 * X * Y", tmap, map),
+        InfixParser::Parse("X + Y", tmap, map), // variable weights are coefficients too
+    };
+
+    tf::Executor executor(2);
+    BatchOptimizerOptions options;
+    options.Iterations = 50; // NOLINT
+    auto summaries = OptimizeBatch(executor, interpreter, { trees.data(), trees.size() }, ds, { target.data(), target.size() }, range, options);
+    REQUIRE(summaries.size() == trees.size());
+    CHECK(summaries[0].Success);
+    CHECK(summaries[0].FinalCost < 1e-6);
+    CHECK(summaries[1].FinalCost <= summaries[1].InitialCost);
+    CHECK(summaries[2].FinalCost <= summaries[2].InitialCost);
+    CHECK(summaries[2].Iterations <= options.Iterations);
+
+    auto estimated = interpreter.Evaluate<Operon::Scalar>(trees[0], ds, range);
+    auto maxError{0.0};
+    for (size_t i = 0; i < target.size(); ++i) {
+        maxError = std::max(maxError, static_cast<double>(std::abs(estimated[i] - target[i])));
+    }
+    CHECK(maxError < 1e-3);
+}
+
+TEST_CASE("Fitness cache")
+{
+    FitnessCache cache(FitnessCache::ShardCount); // one entry per shard
+    Operon::FitnessVector fitness;
+    Operon::Vector<Operon::Scalar> coefficients;
+
+    Operon::FitnessVector f1{0.5};
+    Operon::Vector<Operon::Scalar> c1{1.0, 2.0};
+    cache.Insert(1, f1, c1);
+    REQUIRE(cache.Find(1, fitness, coefficients));
+    CHECK(fitness == f1);
+    CHECK(coefficients == c1);
+    CHECK(!cache.Find(2, fitness, coefficients));
+
+    // hashes 1 and 1 + ShardCount share a shard, the second insertion evicts the first
+    cache.Insert(1 + FitnessCache::ShardCount, f1, c1);
+    CHECK(!cache.Find(1, fitness, coefficients));
+    CHECK(cache.Find(1 + FitnessCache::ShardCount, fitness, coefficients));
+    CHECK(cache.Size() == 1);
+    CHECK(cache.Hits() == 2);
+    CHECK(cache.Misses() == 2);
+
+    cache.Clear();
+    CHECK(cache.Size() == 0);
+
+    SUBCASE("Evaluator")
+    {
+        auto ds = Dataset("../data/Poly-10.csv", true);
+        Problem problem(ds);
+        problem.Target("Y");
+        std::unordered_map<std::string, Operon::Hash> map;
+        for (auto const& v : ds.Variables()) {
+            map.insert({ v.Name, v.Hash });
+        }
+        Interpreter interpreter;
+        MSE mse;
+        Evaluator evaluator(problem, interpreter, mse, /*linearScaling=*/false);
+        evaluator.SetFitnessCache(&cache);
+        evaluator.SetLocalOptimizationIterations(0);
+        Operon::RandomGenerator rng(1234);
+
+        // the lookups leave the relaxed hash values of the tree, the hits are not counted as evaluations
+        Individual ind;
+        ind.Genotype = InfixParser::Parse("X1 * X2 + 2 * X3", InfixParser::DefaultTokens(), map);
+        auto const relaxed = ind.Genotype.Hash(Operon::HashMode::Relaxed).HashValue();
+        auto const f1 = evaluator(rng, ind, {});
+        CHECK(ind.Genotype.HashValue() == relaxed);
+        auto const f2 = evaluator(rng, ind, {});
+        CHECK(ind.Genotype.HashValue() == relaxed);
+        CHECK(f1 == f2);
+        CHECK(evaluator.CacheHits() == 1);
+        CHECK(evaluator.EvaluationCount() == 1);
+    }
+}
+
+TEST_CASE("Coefficient cache")
+{
+    auto ds = Dataset("../data/Pagie-1.csv", true);
+    std::unordered_map<std::string, Operon::Hash> map;
+    for (auto const& v : ds.Variables()) {
+        map.insert({ v.Name, v.Hash });
+    }
+    auto tmap = InfixParser::DefaultTokens();
+
+    CoefficientCache cache;
+    auto parent = InfixParser::Parse("2.5 * X + sin(0.3 * Y)", tmap, map);
+    cache.Insert(parent, 1);
+
+    SUBCASE("Exact")
+    {
+        auto tree = InfixParser::Parse("1.0 * X + sin(1.0 * Y)", tmap, map);
+        auto [count, exact] = cache.WarmStart(tree);
+        CHECK(exact);
+        CHECK(count == parent.GetCoefficients().size());
+        CHECK(tree.GetCoefficients() == parent.GetCoefficients());
+    }
+
+    SUBCASE("Inherited subtree")
+    {
+        auto tree = InfixParser::Parse("cos(X) * sin(1.0 * Y)", tmap, map);
+        auto [count, exact] = cache.WarmStart(tree);
+        CHECK(!exact);
+        CHECK(count == 2); // the constant and the weight of Y
+        auto coeff = tree.GetCoefficients();
+        CHECK(std::find(coeff.begin(), coeff.end(), Operon::Scalar{0.3}) != coeff.end());
+    }
+
+    SUBCASE("Unrelated")
+    {
+        auto tree = InfixParser::Parse("cos(1.0 * X)", tmap, map);
+        auto coeff = tree.GetCoefficients();
+        auto [count, exact] = cache.WarmStart(tree);
+        CHECK(!exact);
+        CHECK(count == 0);
+        CHECK(tree.GetCoefficients() == coeff);
+    }
+
+    SUBCASE("Best")
+    {
+        // the coefficients tuned in a worse fitting tree do not replace the cached ones, those of a better one do
+        cache.Insert(InfixParser::Parse("1.5 * X + sin(0.7 * Y)", tmap, map), 2);
+        auto tree = InfixParser::Parse("1.0 * X + sin(1.0 * Y)", tmap, map);
+        std::ignore = cache.WarmStart(tree);
+        CHECK(tree.GetCoefficients() == parent.GetCoefficients());
+
+        auto better = InfixParser::Parse("3.5 * X + sin(0.1 * Y)", tmap, map);
+        cache.Insert(better, Operon::Scalar{0.5});
+        std::ignore = cache.WarmStart(tree);
+        CHECK(tree.GetCoefficients() == better.GetCoefficients());
+    }
+}
+
+TEST_CASE("Fingerprint cache")
+{
+    auto ds = Dataset("../data/Poly-10.csv", true);
+    Problem problem(ds);
+    std::unordered_map<std::string, Operon::Hash> map;
+    for (auto const& v : ds.Variables()) {
+        map.insert({ v.Name, v.Hash });
+    }
+    auto parse = [&](auto const* model) { return InfixParser::Parse(model, InfixParser::DefaultTokens(), map); };
+
+    Interpreter interpreter;
+    FingerprintCache cache(problem);
+    CHECK(cache.Rows() == FingerprintCache::DefaultRows);
+
+    auto fingerprint = [&](auto const* model, bool standardize) { return cache.Fingerprint(interpreter, parse(model), standardize); };
+    CHECK(fingerprint("X1 * X2", false) == fingerprint("X2 * X1 + 0", false));
+    CHECK(fingerprint("X1", false) != fingerprint("X2", false));
+    CHECK(fingerprint("X1", false) != fingerprint("2 * X1 + 1", false));
+    // equivalent up to the linear scaling
+    CHECK(fingerprint("X1", true) == fingerprint("1 - 2 * X1", true));
+    CHECK(fingerprint("X1", true) != fingerprint("X1 * X1", true));
+    CHECK(!fingerprint("log(X1 - X1)", false));
+
+    SUBCASE("Evaluator")
+    {
+        MSE mse;
+        Evaluator evaluator(problem, interpreter, mse, false);
+        evaluator.SetLocalOptimizationIterations(0);
+        evaluator.SetFingerprintCache(&cache);
+        Operon::RandomGenerator rng(1234);
+
+        Individual ind;
+        ind.Genotype = parse("X1 * X2 + X3");
+        auto const fitness = evaluator(rng, ind, {});
+        CHECK(cache.Size() == 1);
+        auto const residuals = evaluator.ResidualEvaluations();
+
+        ind.Genotype = parse("X3 + X2 * X1");
+        CHECK(evaluator(rng, ind, {}) == fitness);
+        CHECK(evaluator.ResidualEvaluations() == residuals);
+        CHECK(cache.Hits() == 1);
+    }
+
+    SUBCASE("Coefficients")
+    {
+        MSE mse;
+        Evaluator evaluator(problem, interpreter, mse, false);
+        evaluator.SetLocalOptimizationIterations(10);
+        evaluator.SetFingerprintCache(&cache);
+        Operon::RandomGenerator rng(1234);
+
+        Individual ind;
+        ind.Genotype = parse("X1 * X2 + X3");
+        auto const fitness = evaluator(rng, ind, {});
+        auto const coefficients = ind.Genotype.GetCoefficients();
+        auto const residuals = evaluator.ResidualEvaluations();
+
+        // the hit gets the fitted coefficients with their fitness
+        ind.Genotype = parse("X3 + X2 * X1");
+        CHECK(evaluator(rng, ind, {}) == fitness);
+        CHECK(ind.Genotype.GetCoefficients() == coefficients);
+        CHECK(evaluator.ResidualEvaluations() == residuals);
+
+        // without a place for every coefficient the tree is evaluated
+        ind.Genotype = parse("X1 * X2 + X3 + 0");
+        evaluator(rng, ind, {});
+        CHECK(evaluator.ResidualEvaluations() > residuals);
+    }
+}
+
+TEST_CASE("Screening evaluator")
+{
+    auto ds = Dataset("../data/Poly-10.csv", true);
+    Problem problem(ds);
+    problem.Target("Y");
+    std::unordered_map<std::string, Operon::Hash> map;
+    for (auto const& v : ds.Variables()) {
+        map.insert({ v.Name, v.Hash });
+    }
+    auto make = [&](auto const* model) {
+        Individual ind;
+        ind.Genotype = InfixParser::Parse(model, InfixParser::DefaultTokens(), map);
+        return ind;
+    };
+
+    MSE mse;
+    ScreeningEvaluator screening(problem, mse, /*linearScaling=*/true, /*fraction=*/0.5, /*quantile=*/0.5);
+    auto const range = problem.TrainingRange();
+    CHECK(screening.Rows() == std::min(range.Size(), std::max(ScreeningEvaluator::MinRows, range.Size() / 2)));
+
+    auto good = make("X1 * X2 + X3 * X4 + X5 * X6");
+    auto fair = make("X1 * X2 + X3 * X4");
+    auto poor = make("X7");
+
+    // close to the double precision error on the same rows
+    auto const sample = ds.Sample(problem.TrainingRange(), screening.Rows());
+    Interpreter interpreter;
+    auto estimated = interpreter.Evaluate<Operon::Scalar>(good.Genotype, sample, Range { 0, sample.Rows() });
+    auto target = sample.GetValues(problem.TargetVariable().Hash);
+    auto [a, b] = FitLeastSquares(Operon::Span<Operon::Scalar const>(estimated), target);
+    for (auto& v : estimated) { v = static_cast<Operon::Scalar>(v * a + b); }
+    auto const exact = mse(estimated, target);
+    CHECK(std::abs(screening(good) - exact) < 1e-4 * (1 + exact));
+
+    CHECK(screening(good) < screening(fair));
+    CHECK(screening(fair) < screening(poor));
+
+    // not prepared: everything is promoted
+    CHECK(screening.Promote(poor));
+
+    std::vector<Individual> population { make("X1 * X2 + X3 * X4"), make("X1 * X2 + X3 * X4"), make("X7") };
+    screening.Prepare(population);
+    CHECK(screening.Threshold() == screening(fair));
+    CHECK(screening.Promote(good));
+    CHECK(screening.Promote(fair));
+    CHECK(!screening.Promote(poor));
+    CHECK(screening.Promote(screening(poor), /*force=*/true));
+    CHECK(screening.Promoted() == 4);
+}
+
+TEST_CASE("Surrogate model")
+{
+    auto ds = Dataset("../data/Poly-10.csv", true);
+    Problem problem(ds);
+    problem.Target("Y");
+    std::unordered_map<std::string, Operon::Hash> map;
+    for (auto const& v : ds.Variables()) {
+        map.insert({ v.Name, v.Hash });
+    }
+
+    Interpreter interpreter;
+    MSE mse;
+    Evaluator evaluator(problem, interpreter, mse, true);
+    evaluator.SetLocalOptimizationIterations(0);
+    Operon::RandomGenerator rng(1234);
+
+    auto make = [&](auto const* model) {
+        Individual ind;
+        ind.Genotype = InfixParser::Parse(model, InfixParser::DefaultTokens(), map);
+        ind.Fitness = evaluator(rng, ind, {});
+        return ind;
+    };
+
+    SurrogateModel surrogate(problem, interpreter, mse);
+    CHECK(surrogate.Rows() == std::min(SurrogateModel::DefaultRows, problem.TrainingRange().Size()));
+    surrogate.SetMinSamples(20);
+    surrogate.SetQuantile(1);
+
+    std::vector<Individual> models {
+        make("X1 * X2 + X3 * X4 + X5 * X6"),
+        make("X1 * X2 + X3 * X4"),
+        make("X1 * X2"),
+        make("X7 + X8"),
+        make("X7"),
+    };
+    constexpr Operon::Scalar parentFitness{0.2};
+    auto features = [&](auto const& ind) { return surrogate.Features(ind.Genotype, parentFitness); };
+
+    // inactive until it learned from enough evaluations
+    surrogate.Prepare(models);
+    CHECK(!surrogate.Active());
+    CHECK(!surrogate.Discard(features(models.back())));
+
+    for (size_t i = 0; i < 4 * SurrogateModel::Dimension; ++i) {
+        auto const& ind = models[i % models.size()];
+        auto x = features(ind);
+        REQUIRE(x.has_value());
+        surrogate.Update(*x, ind[0]);
+    }
+    CHECK(surrogate.Samples() == 4 * SurrogateModel::Dimension);
+
+    std::vector<Individual> population { models[0], models[0], models[1] };
+    surrogate.Prepare(population);
+    CHECK(surrogate.Active());
+    CHECK(surrogate.Threshold() == models[1][0]);
+    for (auto const& ind : models) {
+        CHECK(std::abs(surrogate.Predict(*features(ind)) - ind[0]) < 1e-2);
+    }
+    CHECK(!surrogate.Discard(features(models[0])));
+    CHECK(!surrogate.Discard(features(models[1])));
+    CHECK(surrogate.Discard(features(models.back())));
+    // not finite on the sample
+    Individual poor;
+    poor.Genotype = InfixParser::Parse("log(X1 - X1)", InfixParser::DefaultTokens(), map);
+    CHECK(!features(poor).has_value());
+    CHECK(surrogate.Discard(features(poor)));
+    CHECK(surrogate.Discarded() == 2);
+}
+
+TEST_CASE("Brood threads")
+{
+    auto ds = Dataset("../data/Poly-10.csv", true);
+    Problem problem(ds);
+    problem.Target("Y");
+    std::unordered_map<std::string, Operon::Hash> map;
+    for (auto const& v : ds.Variables()) {
+        map.insert({ v.Name, v.Hash });
+    }
+
+    Interpreter interpreter;
+    MSE mse;
+    Evaluator evaluator(problem, interpreter, mse, true);
+    evaluator.SetLocalOptimizationIterations(0);
+    Operon::RandomGenerator rng(1234);
+
+    std::vector<Individual> population;
+    for (auto const* model : { "X1 * X2 + X3 * X4", "X5 * X6 + X7", "X1 * X7 * X9 + X3", "X3 * X6 * X10 - X2" }) {
+        Individual ind;
+        ind.Genotype = InfixParser::Parse(model, InfixParser::DefaultTokens(), map);
+        ind.Fitness = evaluator(rng, ind, {});
+        population.push_back(std::move(ind));
+    }
+
+    auto comp = [](auto const& lhs, auto const& rhs) { return lhs[0] < rhs[0]; };
+    TournamentSelector selector(comp);
+    selector.Prepare(population);
+    SubtreeCrossover crossover(0.9, 10, 50); // NOLINT
+    ChangeVariableMutation mutator(problem.InputVariables());
+
+    // the same children are generated on the calling thread and on the brood executor, over several broods which
+    // reuse the scratch space
+    BroodOffspringGenerator sequential(evaluator, crossover, mutator, selector, selector);
+    BroodOffspringGenerator parallel(evaluator, crossover, mutator, selector, selector);
+    parallel.BroodThreads(4);
+    Operon::Vector<Operon::Scalar> buf(problem.TrainingRange().Size());
+    for (auto seed : { 1, 2, 3, 4, 5 }) {
+        Operon::RandomGenerator r1(seed);
+        Operon::RandomGenerator r2(seed);
+        Individual a;
+        Individual b;
+        REQUIRE(sequential.Generate(r1, 1.0, 0.5, buf, a)); // NOLINT
+        REQUIRE(parallel.Generate(r2, 1.0, 0.5, buf, b));   // NOLINT
+        CHECK(a.Genotype.Hash(Operon::HashMode::Strict).HashValue() == b.Genotype.Hash(Operon::HashMode::Strict).HashValue());
+        CHECK(a[0] == b[0]);
+    }
+}
+
+TEST_CASE("Semantic sketch")
+{
+    auto ds = Dataset("../data/Poly-10.csv", true);
+    Problem problem(ds);
+    problem.Target("Y");
+    std::unordered_map<std::string, Operon::Hash> map;
+    for (auto const& v : ds.Variables()) {
+        map.insert({ v.Name, v.Hash });
+    }
+
+    Interpreter interpreter;
+    MSE mse;
+    Evaluator evaluator(problem, interpreter, mse, false);
+    evaluator.SetLocalOptimizationIterations(0);
+    Operon::RandomGenerator rng(1234);
+
+    constexpr size_t dimensions{256};
+    SemanticSketch sketch(problem, interpreter, /*linearScaling=*/false, dimensions);
+    evaluator.SetSemanticSketch(&sketch);
+    CHECK(sketch.Rows() == std::min(SemanticSketch::DefaultRows, problem.TrainingRange().Size()));
+
+    std::vector<Individual> pop;
+    for (auto const* model : { "X1 * X2 + X3 * X4", "X1 * X2 + X3 * X4", "X1 * X2", "X7 + X8", "log(X1 - X1)" }) {
+        Individual ind;
+        ind.Genotype = InfixParser::Parse(model, InfixParser::DefaultTokens(), map);
+        ind.Fitness = evaluator(rng, ind, {});
+        pop.push_back(ind);
+    }
+    // the not finite model is not recorded, the others are projected from the outputs of their evaluation
+    CHECK(sketch.Recorded() == 4);
+    sketch.Prepare(pop);
+    CHECK(sketch.Computed() == 1);
+
+    // the root mean squared difference of the outputs on the sampled rows
+    auto const sample = ds.Sample(problem.TrainingRange(), sketch.Rows());
+    auto rmsd = [&](auto const& lhs, auto const& rhs) {
+        auto const x = interpreter.Evaluate<Operon::Scalar>(lhs.Genotype, sample, Range { 0, sample.Rows() });
+        auto const y = interpreter.Evaluate<Operon::Scalar>(rhs.Genotype, sample, Range { 0, sample.Rows() });
+        double sum{0};
+        for (size_t i = 0; i < x.size(); ++i) { sum += (x[i] - y[i]) * (x[i] - y[i]); }
+        return std::sqrt(sum / static_cast<double>(x.size()));
+    };
+
+    CHECK(sketch.Distance(0, 1) == doctest::Approx(0));
+    for (auto [i, j] : { std::pair{0, 2}, std::pair{0, 3}, std::pair{2, 3} }) {
+        // the relative error of the projection is about 1 / sqrt(2 * dimensions)
+        CHECK(std::abs(sketch.Distance(i, j) - rmsd(pop[i], pop[j])) < 0.2 * rmsd(pop[i], pop[j]));
+    }
+    CHECK(sketch.Distance(0, 4) == std::numeric_limits<double>::max());
+
+    // the reduction agrees with the pairwise distances of the valid sketches
+    auto distances = sketch.MeanDistances();
+    REQUIRE(distances.size() == pop.size());
+    double total{0};
+    for (size_t i = 0; i < 4; ++i) {
+        double sum{0};
+        for (size_t j = 0; j < 4; ++j) { sum += i == j ? 0 : std::pow(sketch.Distance(i, j), 2); }
+        CHECK(distances[i] == doctest::Approx(std::sqrt(sum / 3)));
+        total += sum;
+    }
+    CHECK(sketch.Diversity() == doctest::Approx(std::sqrt(total / 12)));
+    CHECK(distances[4] == std::numeric_limits<double>::max());
+
+    // the same distances with the behavioural diversity evaluator
+    DiversityEvaluator diversity(problem, sketch);
+    diversity.Prepare(pop);
+    CHECK(diversity(rng, pop[2], {}).front() == doctest::Approx(distances[2]));
+}
+
+TEST_CASE("Lexicase selection")
+{
+    auto ds = Dataset("../data/Poly-10.csv", true);
+    Problem problem(ds);
+    problem.Target("Y");
+    std::unordered_map<std::string, Operon::Hash> map;
+    for (auto const& v : ds.Variables()) {
+        map.insert({ v.Name, v.Hash });
+    }
+    auto individual = [&](auto const* model) {
+        Individual ind;
+        ind.Genotype = InfixParser::Parse(model, InfixParser::DefaultTokens(), map);
+        return ind;
+    };
+    auto const* exact = "X1 * X2 + X3 * X4 + X5 * X6 + X1 * X7 * X9 + X3 * X6 * X10";
+
+    Interpreter interpreter;
+    MSE mse;
+    Evaluator evaluator(problem, interpreter, mse, false);
+    LexicaseSelector selector(evaluator, LexicaseSelector::DefaultCases, 1234);
+    selector.SetEpsilon(false);
+    Operon::RandomGenerator rng(1234);
+
+    SUBCASE("Cases")
+    {
+        std::vector<Individual> pop { individual("X1"), individual(exact) };
+        selector.Prepare(pop);
+        auto rows = selector.Rows();
+        REQUIRE(rows.size() == LexicaseSelector::DefaultCases);
+        CHECK(std::is_sorted(rows.begin(), rows.end()));
+        CHECK(std::adjacent_find(rows.begin(), rows.end()) == rows.end());
+        CHECK(rows.back() < problem.TrainingRange().End());
+        for (size_t c = 0; c < rows.size(); ++c) {
+            CHECK(selector.Errors(c)[1] < selector.Errors(c)[0]);
+        }
+    }
+
+    SUBCASE("Elite")
+    {
+        // the only individual which is the best on every case is always selected
+        std::vector<Individual> pop(100, individual("X1")); // NOLINT
+        pop.push_back(individual("X2"));
+        pop.insert(pop.begin() + 57, individual(exact)); // NOLINT
+        selector.Prepare(pop);
+        for (int i = 0; i < 100; ++i) { CHECK(selector(rng) == 57); } // NOLINT
+    }
+
+    SUBCASE("Ties")
+    {
+        // few candidates left after the first case (the index array filter), chosen at random among the tied ones
+        std::vector<Individual> pop(300, individual("X1")); // NOLINT
+        for (int i = 0; i < 5; ++i) { pop[i * 60] = individual(exact); } // NOLINT
+        selector.Prepare(pop);
+        std::vector<size_t> hits(pop.size());
+        for (int i = 0; i < 1000; ++i) { ++hits[selector(rng)]; } // NOLINT
+        for (size_t i = 0; i < pop.size(); ++i) {
+            CHECK((hits[i] > 0) == (i % 60 == 0));
+        }
+    }
+
+    SUBCASE("Parallel prepare")
+    {
+        // the same cases, errors and epsilons as the sequential Prepare
+        std::vector<Individual> pop;
+        for (auto const* model : { "X1", "X2 * X3", exact, "X4 + X5", "X6 * X6" }) {
+            for (int i = 0; i < 20; ++i) { pop.push_back(individual(model)); } // NOLINT
+        }
+        auto pick = [&](size_t i) { return i % 3 == 0 ? "X1 * X7" : "X8"; };
+        for (size_t i = 0; i < pop.size(); i += 7) { pop[i] = individual(pick(i)); } // NOLINT
+        selector.SetEpsilon(true);
+        LexicaseSelector parallel(evaluator, LexicaseSelector::DefaultCases, 1234);
+
+        tf::Executor executor(4);
+        tf::Taskflow taskflow;
+        taskflow.emplace([&](tf::Subflow& sf) { parallel.Prepare(sf, pop); });
+        executor.run(taskflow).wait();
+        selector.Prepare(pop);
+
+        REQUIRE(parallel.Rows().size() == selector.Rows().size());
+        CHECK(std::equal(parallel.Rows().begin(), parallel.Rows().end(), selector.Rows().begin()));
+        for (size_t c = 0; c < selector.Rows().size(); ++c) {
+            CHECK(std::equal(parallel.Errors(c).begin(), parallel.Errors(c).end(), selector.Errors(c).begin()));
+        }
+        Operon::RandomGenerator r1(42); // NOLINT
+        Operon::RandomGenerator r2(42); // NOLINT
+        for (int i = 0; i < 100; ++i) { CHECK(parallel(r1) == selector(r2)); } // NOLINT
+    }
+}
+
+TEST_CASE("Parallel rank tournament prepare")
+{
+    std::vector<Individual> pop(1000); // NOLINT
+    Operon::RandomGenerator random(1234);
+    std::vector<Operon::Scalar> fitness(pop.size());
+    std::iota(fitness.begin(), fitness.end(), Operon::Scalar{0});
+    std::shuffle(fitness.begin(), fitness.end(), random);
+    for (size_t i = 0; i < pop.size(); ++i) { pop[i].Fitness = { fitness[i] }; }
+
+    auto comp = [](auto const& lhs, auto const& rhs) { return lhs[0] < rhs[0]; };
+    RankTournamentSelector sequential(comp);
+    RankTournamentSelector parallel(comp);
+    sequential.Prepare(pop);
+
+    tf::Executor executor(4);
+    tf::Taskflow taskflow;
+    taskflow.emplace([&](tf::Subflow& sf) { parallel.Prepare(sf, pop); });
+    executor.run(taskflow).wait();
+
+    // the fitness values are distinct, so both selectors rank the population in the same order
+    Operon::RandomGenerator r1(42); // NOLINT
+    Operon::RandomGenerator r2(42); // NOLINT
+    for (int i = 0; i < 1000; ++i) { CHECK(parallel(r1) == sequential(r2)); } // NOLINT
+}
+
+TEST_CASE("Batch evaluator")
+{
+    auto ds = Dataset("../data/Poly-10.csv", true);
+    Problem problem(ds);
+    std::unordered_map<std::string, Operon::Hash> map;
+    for (auto const& v : ds.Variables()) {
+        map.insert({ v.Name, v.Hash });
+    }
+    std::vector<Individual> individuals;
+    for (auto const* model : { "X1 * X2 + X3 * X4", "sin(X5) / (X6 + 2)", "exp(X7 * 0.1) - X8 * X9 * X10", "X1" }) {
+        Individual ind;
+        ind.Genotype = InfixParser::Parse(model, InfixParser::DefaultTokens(), map);
+        individuals.push_back(ind);
+    }
+
+    Interpreter interpreter;
+    Operon::RandomGenerator rng(1234);
+    tf::Executor executor(2);
+    MSE mse;
+    MAE mae;
+    C2 c2;
+    for (auto const* metric : std::array<ErrorMetric const*, 3> { &mse, &mae, &c2 }) {
+        for (auto scaling : { false, true }) {
+            Evaluator evaluator(problem, interpreter, *metric, scaling);
+            evaluator.SetLocalOptimizationIterations(0);
+            BatchEvaluator batch(problem, interpreter, *metric, scaling);
+            batch.SetLocalOptimizationIterations(0);
+            // tiles and groups which do not divide the rows and the individuals
+            batch.SetTileSize(37); // NOLINT
+            batch.SetGroupSize(3);
+
+            auto fitness = batch.EvaluateBatch(rng, executor, { individuals.data(), individuals.size() });
+            REQUIRE(fitness.size() == individuals.size());
+            for (size_t i = 0; i < individuals.size(); ++i) {
+                auto expected = evaluator(rng, individuals[i], {}).front();
+                CHECK(fitness[i] == doctest::Approx(expected).epsilon(1e-4));
+                CHECK(batch(rng, individuals[i], {}).front() == doctest::Approx(expected).epsilon(1e-4));
+            }
+        }
+    }
+}
+
+TEST_CASE("Batch evaluator with batched optimization")
+{
+    auto ds = Dataset("../data/Poly-10.csv", true);
+    Problem problem(ds);
+    std::unordered_map<std::string, Operon::Hash> map;
+    for (auto const& v : ds.Variables()) {
+        map.insert({ v.Name, v.Hash });
+    }
+    std::vector<Individual> individuals;
+    for (auto const* model : { "0.5 * X1 * X2 + 2.0 * X3 * X4", "sin(X5) / (X6 + 2)", "X1", "1.5 * X1 * X2 - 0.1" }) {
+        Individual ind;
+        ind.Genotype = InfixParser::Parse(model, InfixParser::DefaultTokens(), map);
+        individuals.push_back(ind);
+    }
+    auto initial = individuals;
+
+    Interpreter interpreter;
+    Operon::RandomGenerator rng(1234);
+    tf::Executor executor(2);
+    MSE mse;
+    BatchEvaluator reference(problem, interpreter, mse, /*linearScaling=*/false);
+    reference.SetLocalOptimizationIterations(0);
+    auto before = reference.EvaluateBatch(rng, executor, { initial.data(), initial.size() });
+
+    BatchEvaluator batch(problem, interpreter, mse, /*linearScaling=*/false);
+    batch.SetLocalOptimizationIterations(10); // NOLINT
+    batch.SetBatchedOptimization(true);
+    batch.SetGroupSize(3);
+    auto after = batch.EvaluateBatch(rng, executor, { individuals.data(), individuals.size() });
+    REQUIRE(after.size() == individuals.size());
+    CHECK(batch.JacobianEvaluations() > 0);
+
+    for (size_t i = 0; i < individuals.size(); ++i) {
+        CHECK(after[i] <= before[i]);
+        // the fitness is computed with the optimized coefficients
+        CHECK(after[i] == doctest::Approx(reference.EvaluateBatch(rng, executor, { &individuals[i], 1 }).front()).epsilon(1e-4));
+    }
+    CHECK(after[0] < before[0]);
+    CHECK(individuals[0].Genotype.GetCoefficients() != initial[0].Genotype.GetCoefficients());
+}
+
+TEST_CASE("Cross-validation evaluator")
+{
+    auto ds = Dataset("../data/Poly-10.csv", true);
+    Problem problem(ds);
+    problem.TrainingRange({ 0, 250 }); // NOLINT
+    std::unordered_map<std::string, Operon::Hash> map;
+    for (auto const& v : ds.Variables()) {
+        map.insert({ v.Name, v.Hash });
+    }
+    Individual ind;
+    ind.Genotype = InfixParser::Parse("X1 * X2 + sin(X5) / (X6 + 2)", InfixParser::DefaultTokens(), map);
+
+    Interpreter interpreter;
+    Operon::RandomGenerator rng(1234);
+    MSE mse;
+    MAE mae;
+    constexpr size_t folds{4};
+    for (auto const* metric : std::array<ErrorMetric const*, 2> { &mse, &mae }) {
+        for (auto scaling : { false, true }) {
+            CrossValidationEvaluator cv(problem, interpreter, folds, *metric, scaling);
+            cv.SetLocalOptimizationIterations(0);
+            CHECK(cv.Fold(0).Start() == 0);
+            CHECK(cv.Fold(folds - 1).End() == 250);
+
+            // every fold error matches an evaluation restricted to the fold
+            auto errors = cv.FoldErrors(ind.Genotype, {});
+            REQUIRE(errors.size() == folds);
+            double mean{0};
+            for (size_t f = 0; f < folds; ++f) {
+                auto fold = problem;
+                fold.TrainingRange(cv.Fold(f));
+                Evaluator evaluator(fold, interpreter, *metric, scaling);
+                evaluator.SetLocalOptimizationIterations(0);
+                CHECK(errors[f] == doctest::Approx(evaluator(rng, ind, {}).front()).epsilon(1e-4));
+                mean += errors[f] / folds;
+            }
+
+            auto fit = cv(rng, ind, {});
+            REQUIRE(fit.size() == 2);
+            CHECK(fit[0] == doctest::Approx(mean).epsilon(1e-4));
+            CHECK(fit[1] >= 0);
+        }
+    }
+}
+
+TEST_CASE("Model report")
+{
+    auto ds = Dataset("../data/Poly-10.csv", true);
+    Problem problem(ds);
+    problem.TrainingRange(Range { 0, 250 }); // NOLINT
+    problem.TestRange(Range { 250, 500 }); // NOLINT
+    std::unordered_map<std::string, Operon::Hash> map;
+    for (auto const& v : ds.Variables()) {
+        map.insert({ v.Name, v.Hash });
+    }
+
+    Interpreter interpreter;
+    ModelReport report(problem, interpreter);
+    auto const target = problem.TargetValues();
+    auto const train = problem.TrainingRange();
+    auto const test = problem.TestRange();
+    using Span = Operon::Span<Operon::Scalar const>;
+
+    std::vector<Tree> trees;
+    std::vector<std::future<ModelStatistics>> pending;
+    for (auto const* model : { "X1 * X2 + X3 * X4", "sin(X5) / (X6 + 2)", "exp(X7 * 0.1) - X8 * X9 * X10" }) {
+        trees.push_back(InfixParser::Parse(model, InfixParser::DefaultTokens(), map));
+        pending.push_back(report.Submit(trees.back()));
+    }
+
+    for (size_t i = 0; i < trees.size(); ++i) {
+        // the separate evaluations and metrics computed from the scaled values
+        auto estimatedTrain = interpreter.Evaluate<Operon::Scalar>(trees[i], ds, train);
+        auto estimatedTest = interpreter.Evaluate<Operon::Scalar>(trees[i], ds, test);
+        auto targetTrain = target.subspan(train.Start(), train.Size());
+        auto targetTest = target.subspan(test.Start(), test.Size());
+        auto [a, b] = FitLeastSquares(Span(estimatedTrain.data(), estimatedTrain.size()), targetTrain);
+        for (auto* v : { &estimatedTrain, &estimatedTest }) {
+            std::transform(v->begin(), v->end(), v->begin(), [a=a, b=b](auto x) { return static_cast<Operon::Scalar>(a * x + b); });
+        }
+
+        auto const stats = report(trees[i]);
+        auto const async = pending[i].get();
+        CHECK(stats.Scale == doctest::Approx(a).epsilon(1e-5));
+        CHECK(stats.Offset == doctest::Approx(b).epsilon(1e-5));
+        CHECK(stats.R2Train == doctest::Approx(-R2{}(estimatedTrain, targetTrain)).epsilon(1e-4));
+        CHECK(stats.R2Test == doctest::Approx(-R2{}(estimatedTest, targetTest)).epsilon(1e-4));
+        CHECK(stats.NmseTrain == doctest::Approx(NMSE{}(estimatedTrain, targetTrain)).epsilon(1e-4));
+        CHECK(stats.NmseTest == doctest::Approx(NMSE{}(estimatedTest, targetTest)).epsilon(1e-4));
+        CHECK(stats.MaeTrain == doctest::Approx(MAE{}(estimatedTrain, targetTrain)).epsilon(1e-4));
+        CHECK(stats.MaeTest == doctest::Approx(MAE{}(estimatedTest, targetTest)).epsilon(1e-4));
+        // the worker computes the same statistics
+        CHECK(async.R2Test == stats.R2Test);
+        CHECK(async.MaeTest == stats.MaeTest);
+    }
+}
+
+TEST_CASE("Error metric kernels")
+{
+    Operon::RandomGenerator rng(1234);
+    std::normal_distribution<double> dist(0, 1);
+
+    // sizes which do not divide the vector width, and a large offset which makes naive single precision sums drift
+    for (size_t n : { 1UL, 7UL, 1000UL, 1UL << 20U }) {
+        std::vector<double> x(n);
+        std::vector<double> y(n);
+        for (size_t i = 0; i < n; ++i) {
+            y[i] = 1000 + dist(rng); // NOLINT
+            x[i] = y[i] + 0.1 * dist(rng); // NOLINT
+        }
+        std::vector<float> xf(x.begin(), x.end());
+        std::vector<float> yf(y.begin(), y.end());
+
+        // reference in long double over the single precision values
+        long double sse{0};
+        long double sae{0};
+        long double sum{0};
+        for (size_t i = 0; i < n; ++i) {
+            auto e = static_cast<long double>(xf[i]) - static_cast<long double>(yf[i]);
+            sse += e * e;
+            sae += std::abs(e);
+            sum += yf[i];
+        }
+        auto mean = sum / static_cast<long double>(n);
+        long double ss{0};
+        for (auto v : yf) { ss += (v - mean) * (v - mean); }
+
+        Operon::Span<float const> sx(xf.data(), n);
+        Operon::Span<float const> sy(yf.data(), n);
+        CHECK(Kernels::SumOfSquaredErrors(sx, sy) == doctest::Approx(static_cast<double>(sse)).epsilon(1e-12));
+        CHECK(Kernels::SumOfAbsoluteErrors(sx, sy) == doctest::Approx(static_cast<double>(sae)).epsilon(1e-12));
+        CHECK(Kernels::Mean(sy) == doctest::Approx(static_cast<double>(mean)).epsilon(1e-12));
+        CHECK(Kernels::Variance(sy) == doctest::Approx(static_cast<double>(ss / static_cast<long double>(n))).epsilon(1e-9));
+
+        // the double precision kernels agree with vstat
+        Operon::Span<double const> dx(x.data(), n);
+        Operon::Span<double const> dy(y.data(), n);
+        auto stats = vstat::bivariate::accumulate<double>(x.data(), y.data(), n);
+        auto m = Kernels::Moments(dx, dy);
+        CHECK(m.MeanX == doctest::Approx(stats.mean_x));
+        CHECK(m.MeanY == doctest::Approx(stats.mean_y));
+        CHECK(m.VarianceX == doctest::Approx(stats.variance_x));
+        CHECK(m.VarianceY == doctest::Approx(stats.variance_y));
+        CHECK(m.Covariance == doctest::Approx(stats.covariance));
+        if (n > 1) {
+            CHECK(CorrelationCoefficient(dx, dy) == doctest::Approx(stats.correlation));
+            CHECK(R2Score(dx, dy) == doctest::Approx(R2Score(x.begin(), x.end(), y.begin())));
+            CHECK(NormalizedMeanSquaredError(dx, dy) == doctest::Approx(NormalizedMeanSquaredError(x.begin(), x.end(), y.begin())));
+        }
+        CHECK(MeanSquaredError(dx, dy) == doctest::Approx(MeanSquaredError(x.begin(), x.end(), y.begin())));
+        CHECK(MeanAbsoluteError(dx, dy) == doctest::Approx(MeanAbsoluteError(x.begin(), x.end(), y.begin())));
+    }
+}
+
+TEST_CASE("Fused linear scaling")
+{
+    Operon::RandomGenerator rng(1234);
+    std::uniform_real_distribution<Operon::Scalar> dist(-1, 1);
+
+    auto const n = 1000UL;
+    Operon::Vector<Operon::Scalar> x(n);
+    Operon::Vector<Operon::Scalar> y(n);
+    for (auto i = 0UL; i < n; ++i) {
+        x[i] = dist(rng);
+        y[i] = 3 * x[i] - 2 + dist(rng) * 0.1F; // NOLINT
+    }
+
+    using Span = Operon::Span<Operon::Scalar const>;
+    auto [a, b] = FitLeastSquares(Span(x.data(), x.size()), Span(y.data(), y.size()));
+    Operon::Vector<Operon::Scalar> z(n);
+    std::transform(x.begin(), x.end(), z.begin(), [a=a, b=b](auto v) { return a * v + b; });
+    auto moments = ComputeScalingMoments(Span(x.data(), x.size()), Span(y.data(), y.size()));
+
+    MSE mse; RMSE rmse; NMSE nmse; R2 r2; C2 c2;
+    auto const eps = 1e-4;
+    std::array<ErrorMetric const*, 5> metrics { &mse, &rmse, &nmse, &r2, &c2 };
+    for (auto const* metric : metrics) {
+        REQUIRE(metric->HasScaledForm());
+        CHECK(std::abs(metric->ScaledError(moments) - (*metric)(Span(z.data(), z.size()), Span(y.data(), y.size()))) < eps);
+    }
+}
+
+TEST_CASE("ODE evaluator")
+{
+    // x' = -x / 2 + u / 20 + 1 / 10 with u = t, so that x = 3 exp(-t / 2) + t / 10
+    constexpr size_t n { 41 };
+    constexpr Operon::Scalar step { 0.1 };
+    Eigen::Matrix<Operon::Scalar, -1, -1> values(n, 2);
+    for (size_t i = 0; i < n; ++i) {
+        auto const t = step * static_cast<Operon::Scalar>(i);
+        values(static_cast<Eigen::Index>(i), 0) = 3 * std::exp(-t / 2) + t / 10; // NOLINT
+        values(static_cast<Eigen::Index>(i), 1) = t;
+    }
+    Dataset ds(values);
+    ds.SetVariableNames({ "x", "u" });
+    auto x = ds.GetVariable("x").value();
+    auto u = ds.GetVariable("u").value();
+
+    Node nx(NodeType::Variable, x.Hash);
+    nx.Value = -0.5; // NOLINT
+    Node nu(NodeType::Variable, u.Hash);
+    nu.Value = 0.05; // NOLINT
+    Node c(NodeType::Constant);
+    c.Value = 0.1; // NOLINT
+    Tree tree({ c, nu, nx, Node(NodeType::Add), Node(NodeType::Add) });
+    tree.UpdateNodes();
+
+    Interpreter interpreter;
+    std::vector<Operon::Hash> states { x.Hash };
+    std::vector<TreeView> rhs { tree };
+
+    SUBCASE("Integration")
+    {
+        for (auto method : { OdeMethod::RK4, OdeMethod::RK45 }) {
+            OdeOptions options;
+            options.Method = method;
+            options.Tolerance = 1e-10; // NOLINT
+            // two trajectories of different lengths, integrated together
+            OdeIntegrator integrator(interpreter, ds, { Range { 0, n }, Range { 10, 30 } }, step, options); // NOLINT
+            std::vector<Operon::Scalar> result(integrator.Rows());
+            std::vector<Operon::Scalar> sensitivities(integrator.Rows() * 3);
+            REQUIRE(integrator.Integrate(states, rhs, {}, { result.data(), result.size() }, sensitivities.data()));
+            auto observed = integrator.Observed(x.Hash);
+            for (size_t i = 0; i < result.size(); ++i) {
+                CHECK(result[i] == doctest::Approx(observed[i]).epsilon(1e-6));
+            }
+
+            // the sensitivities agree with central differences
+            auto parameters = tree.GetCoefficients();
+            for (size_t k = 0; k < parameters.size(); ++k) {
+                constexpr Operon::Scalar eps { 1e-6 };
+                std::vector<Operon::Scalar> lo(integrator.Rows());
+                std::vector<Operon::Scalar> hi(integrator.Rows());
+                auto p = parameters;
+                p[k] += eps;
+                REQUIRE(integrator.Integrate(states, rhs, p, { hi.data(), hi.size() }));
+                p[k] -= 2 * eps;
+                REQUIRE(integrator.Integrate(states, rhs, p, { lo.data(), lo.size() }));
+                for (size_t i = 0; i < result.size(); ++i) {
+                    CHECK(sensitivities[k * result.size() + i] == doctest::Approx((hi[i] - lo[i]) / (2 * eps)).epsilon(1e-4));
+                }
+            }
+        }
+    }
+
+    SUBCASE("Coefficient fitting")
+    {
+        std::vector<Variable> inputs { x, u };
+        Problem problem(ds, inputs, x, Range { 0, n }, Range { 0, n });
+        Operon::RandomGenerator rng(1234);
+        OdeEvaluator evaluator(problem, interpreter, step);
+
+        Individual ind;
+        ind.Genotype = tree;
+        ind.Genotype.SetCoefficients(std::vector<Operon::Scalar> { 1, 0.3, -0.2 }); // NOLINT
+        evaluator.SetLocalOptimizationIterations(0);
+        auto before = evaluator(rng, ind, {}).front();
+        evaluator.SetLocalOptimizationIterations(50); // NOLINT
+        auto after = evaluator(rng, ind, {}).front();
+        CHECK(after < before);
+        CHECK(after < 1e-8);
+        auto coefficients = ind.Genotype.GetCoefficients();
+        CHECK(coefficients[2] == doctest::Approx(-0.5).epsilon(1e-3));
+    }
+}
+
+} // namespace Operon::Test
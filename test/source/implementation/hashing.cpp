@@ -13,6 +13,7 @@
 #include "operon/core/pset.hpp"
 #include "operon/core/variable.hpp"
 #include "operon/hash/hash.hpp"
+#include "operon/hash/population.hpp"
 #include "operon/operators/creator.hpp"
 
 
@@ -163,4 +164,26 @@ TEST_CASE("Hash collisions") {
     auto s32 = static_cast<double>(set32.size());
     fmt::print("total nodes: {}, {:.3f}% unique, unique 64-bit hashes: {}, unique 32-bit hashes: {}, collision rate: {:.3f}%\n", totalNodes, s64/static_cast<double>(totalNodes) * 100, s64, s32, (1 - s32/s64) * 100);
 }
+
+TEST_CASE("Population hashing") {
+    Operon::RandomGenerator rd(1234);
+    auto ds = Dataset("../data/Poly-10.csv", true);
+
+    auto variables = ds.Variables();
+    PrimitiveSet grammar;
+    grammar.SetConfig(PrimitiveSet::Arithmetic);
+    auto btc = BalancedTreeCreator { grammar, variables };
+
+    constexpr size_t n = 1000;
+    constexpr size_t maxLength = 100;
+    std::uniform_int_distribution<size_t> sizeDistribution(1, maxLength);
+    std::vector<Tree> trees(n);
+    std::generate(trees.begin(), trees.end(), [&]() { return btc(rd, sizeDistribution(rd), 1, maxLength); });
+
+    auto copies = trees;
+    HashPopulation(Operon::Span<Tree const>(trees.data(), trees.size()), Operon::HashMode::Strict, 4);
+    for (size_t i = 0; i < n; ++i) {
+        CHECK(trees[i].HashValue() == copies[i].Hash(Operon::HashMode::Strict).HashValue());
+    }
+}
 } // namespace Operon::Test
@@ -3,6 +3,7 @@
 
 #include <doctest/doctest.h>
 #include <robin_hood.h>
+#include <taskflow/taskflow.hpp>
 
 #include "operon/hash/hash.hpp"
 #include "operon/interpreter/interpreter.hpp"
@@ -232,6 +233,67 @@ TEST_SUITE("[implementation]")
             fmt::print("{} = {}\n", InfixFormatter::Format(t1, map, 3), v1);
             fmt::print("{} = {}\n", InfixFormatter::Format(t2, map, 3), v2);
         }
+
+        SUBCASE("Population")
+        {
+            Operon::Dataset ds("./data/Poly-10.csv", true);
+            Operon::PrimitiveSet pset;
+            pset.SetConfig(PrimitiveSet::Arithmetic | NodeType::Exp | NodeType::Log | NodeType::Sin | NodeType::Square | NodeType::Aq | NodeType::Pow);
+            Operon::RandomGenerator rng(1234);
+            Operon::BalancedTreeCreator btc(pset, ds.Variables());
+
+            std::vector<Individual> individuals(100); // NOLINT
+            for (auto& ind : individuals) {
+                ind.Genotype = btc(rng, 30, 1, 10); // NOLINT
+            }
+
+            tf::Executor executor(2);
+            auto models = InfixFormatter::FormatMany(executor, individuals, ds, 5);
+            REQUIRE(models.size() == individuals.size());
+
+            std::unordered_map<Operon::Hash, std::string> names;
+            for (auto const& v : ds.Variables()) {
+                names.insert({ v.Hash, v.Name });
+            }
+            fmt::memory_buffer buffer;
+            for (size_t i = 0; i < individuals.size(); ++i) {
+                CHECK(models[i] == InfixFormatter::Format(individuals[i].Genotype, ds, 5));
+
+                // the buffer overload appends
+                auto const size = buffer.size();
+                InfixFormatter::Format(individuals[i].Genotype, names, buffer, 5);
+                CHECK(std::string(buffer.data() + size, buffer.size() - size) == models[i]);
+            }
+        }
+    }
+
+    TEST_CASE("Model parser")
+    {
+        Operon::Dataset ds("./data/Poly-10.csv", true);
+        std::vector<std::string> models { "X1 * X2 + X3", "sin(X4) / (X5 + 2)", "X1 * X2 + X3", "exp(X6) - X7", "X3 + X1 * X2" };
+
+        ModelParser parser(ds.Variables());
+        tf::Executor executor(2);
+        auto trees = parser.ParseMany(executor, models, Operon::HashMode::Strict);
+        REQUIRE(trees.size() == models.size());
+
+        robin_hood::unordered_flat_map<std::string, Operon::Hash> vmap;
+        for (auto const& v : ds.Variables()) {
+            vmap.insert({ v.Name, v.Hash });
+        }
+        for (size_t i = 0; i < models.size(); ++i) {
+            auto expected = InfixParser::Parse(models[i], InfixParser::DefaultTokens(), vmap);
+            expected.Hash(Operon::HashMode::Strict);
+            CHECK(trees[i].HashValue() == expected.HashValue());
+            CHECK(parser.Parse(models[i]).Length() == expected.Length());
+        }
+
+        // the hash is order independent for commutative functions, so the last model is a duplicate as well
+        auto duplicates = ModelParser::Duplicates(trees);
+        CHECK(duplicates == std::vector<size_t> { 0, 1, 0, 3, 0 });
+
+        std::vector<std::string> invalid { "X1 + X2", "X1 + Y" };
+        CHECK_THROWS_AS(parser.ParseMany(executor, invalid), std::invalid_argument);
     }
 }
 
@@ -2,6 +2,7 @@
 // SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
 
 #include <algorithm>
+#include <tuple>
 #include <doctest/doctest.h>
 
 #include "operon/core/dataset.hpp"
@@ -54,6 +55,35 @@ TEST_CASE("Sample nodes from grammar")
     REQUIRE(chi <= criticalValue);
 }
 
+TEST_CASE("Sample nodes by arity")
+{
+    PrimitiveSet grammar;
+    grammar.SetConfig(PrimitiveSet::Full);
+    grammar.SetMinMaxArity(Node(NodeType::Add).HashValue, 2, 5);
+    Operon::RandomGenerator rd(1234);
+
+    for (auto [lo, hi] : { std::pair{0UL, 0UL}, std::pair{1UL, 1UL}, std::pair{2UL, 2UL}, std::pair{1UL, 2UL}, std::pair{3UL, 10UL} }) {
+        for (auto i = 0; i < 1000; ++i) {
+            auto node = grammar.SampleRandomSymbol(rd, lo, hi);
+            CHECK(node.Arity >= lo);
+            CHECK(node.Arity <= hi);
+            auto [amin, amax] = grammar.MinMaxArity(node.HashValue);
+            CHECK(node.Arity >= amin);
+            CHECK(node.Arity <= amax);
+        }
+    }
+    CHECK_THROWS(std::ignore = grammar.SampleRandomSymbol(rd, 6, 10));
+
+    // the sampling tables follow changes to the primitive set
+    grammar.Disable(Node(NodeType::Add).HashValue);
+    grammar.SetFrequency(Node(NodeType::Sub).HashValue, 0);
+    for (auto i = 0; i < 1000; ++i) {
+        auto node = grammar.SampleRandomSymbol(rd, 2, 2);
+        CHECK(!node.Is<NodeType::Add, NodeType::Sub>());
+    }
+    CHECK_THROWS(std::ignore = grammar.SampleRandomSymbol(rd, 3, 10));
+}
+
 auto GenerateTrees(Operon::RandomGenerator& random, Operon::CreatorBase& creator, std::vector<size_t> lengths, size_t maxDepth) -> std::vector<Tree>
 {
     std::vector<Tree> trees;
@@ -3,6 +3,8 @@
 
 #include <doctest/doctest.h>
 
+#include <array>
+
 #include "operon/core/dataset.hpp"
 #include "operon/core/format.hpp"
 #include "operon/core/pset.hpp"
@@ -47,4 +49,71 @@ TEST_CASE("InsertSubtreeMutation")
     fmt::print("{}\n", TreeFormatter::Format(child, ds));
 }
 
+TEST_CASE("ReplaceSubtreeMutation")
+{
+    auto ds = Dataset("../data/Poly-10.csv", true);
+    auto variables = ds.Variables();
+    constexpr size_t maxDepth = 1000;
+    constexpr size_t maxLength = 100;
+
+    PrimitiveSet grammar;
+    grammar.SetConfig(PrimitiveSet::Arithmetic | NodeType::Log | NodeType::Exp);
+    BalancedTreeCreator btc { grammar, variables, /* bias= */ 0.0 };
+    UniformCoefficientInitializer cfi;
+
+    Operon::RandomGenerator random(1234);
+    auto sizeDistribution = std::uniform_int_distribution<size_t>(1, maxLength);
+    ReplaceSubtreeMutation mut(btc, cfi, maxDepth, maxLength);
+
+    // the subtree is spliced in place, the node information must match a full update
+    for (int i = 0; i < 1000; ++i) {
+        auto child = mut(random, btc(random, sizeDistribution(random), 1, maxDepth));
+        auto expected = Tree(child.Nodes()).UpdateNodes();
+        REQUIRE(child.Length() <= maxLength);
+        for (size_t j = 0; j < child.Length(); ++j) {
+            CHECK(child[j].Length == expected[j].Length);
+            CHECK(child[j].Depth == expected[j].Depth);
+            CHECK(child[j].Level == expected[j].Level);
+            CHECK(child[j].Parent == expected[j].Parent);
+        }
+    }
 }
+
+namespace {
+    struct CountingMutation : public MutatorBase {
+        explicit CountingMutation(size_t& count) : count_(count) { }
+        auto operator()(Operon::RandomGenerator& /*random*/, Tree tree) const -> Tree override
+        {
+            ++count_.get();
+            return tree;
+        }
+
+    private:
+        std::reference_wrapper<size_t> count_;
+    };
+} // namespace
+
+TEST_CASE("MultiMutation")
+{
+    std::array<size_t, 3> counts {};
+    std::array<double, 3> probabilities { 0.5, 0.3, 0.2 };
+    CountingMutation m0(counts[0]);
+    CountingMutation m1(counts[1]);
+    CountingMutation m2(counts[2]);
+
+    MultiMutation mut;
+    mut.Add(m0, probabilities[0]);
+    mut.Add(m1, probabilities[1]);
+    mut.Add(m2, probabilities[2]);
+
+    Operon::RandomGenerator random(1234);
+    constexpr size_t n = 100000;
+    for (size_t i = 0; i < n; ++i) {
+        mut(random, Tree{});
+    }
+    for (size_t i = 0; i < counts.size(); ++i) {
+        CHECK(static_cast<double>(counts[i]) / n == doctest::Approx(probabilities[i]).epsilon(0.05));
+    }
+}
+
+} // namespace Operon::Test
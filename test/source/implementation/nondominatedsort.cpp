@@ -2,12 +2,16 @@
 // SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
 
 #include <doctest/doctest.h>
+#include <bitset>
+#include <numeric>
 #include <random>
 #include <thread>
 #include <fmt/ranges.h>
 
 #include "operon/algorithms/nsga2.hpp"
+#include "operon/collections/bitset.hpp"
 #include "operon/core/dataset.hpp"
+#include "operon/core/pareto_archive.hpp"
 #include "operon/core/pset.hpp"
 #include "operon/interpreter/interpreter.hpp"
 #include "operon/operators/creator.hpp"
@@ -79,7 +83,7 @@ TEST_CASE("non-dominated sort" * doctest::test_suite("[implementation]"))
         std::vector<std::vector<Operon::Scalar>> points = {{0, 7}, {1, 5}, {2, 3}, {4, 2}, {7, 1}, {10, 0}, {2, 6}, {4, 4}, {10, 2}, {6, 6}, {9, 5}};
         std::vector<Individual> pop(points.size());
         for (size_t i = 0; i < points.size(); ++i) {
-            pop[i].Fitness = points[i];
+            pop[i].Fitness.assign(points[i].begin(), points[i].end());
         }
         fmt::print("DS\n");
         DeductiveSorter ds;
@@ -122,7 +126,7 @@ TEST_CASE("non-dominated sort" * doctest::test_suite("[implementation]"))
         std::vector<std::vector<Operon::Scalar>> points = {{1, 2, 3}, {-2, 3, 7}, {-1, -2, -3}, {0, 0, 0}};
         std::vector<Individual> pop(points.size());
         for (size_t i = 0; i < points.size(); ++i) {
-            pop[i].Fitness = points[i];
+            pop[i].Fitness.assign(points[i].begin(), points[i].end());
         }
         std::stable_sort(pop.begin(), pop.end(), LexicographicalComparison{});
         fmt::print("DS\n");
@@ -179,7 +183,7 @@ TEST_CASE("non-dominated sort" * doctest::test_suite("[implementation]"))
 
         std::vector<Individual> pop(points.size());
         for (size_t i = 0; i < points.size(); ++i) {
-            pop[i].Fitness = points[i];
+            pop[i].Fitness.assign(points[i].begin(), points[i].end());
         }
         std::vector<int> indices(points.size());
         std::iota(indices.begin(), indices.end(), 0);
@@ -322,6 +326,153 @@ TEST_CASE("non-dominated sort" * doctest::test_suite("[implementation]"))
 
     }
 
+    SUBCASE("fitness matrix")
+    {
+        // the matrix overload gives the same fronts as the population overload
+        std::uniform_real_distribution<Operon::Scalar> dist(0, 1);
+        for (size_t m = 2; m <= 4; ++m) {
+            auto pop = initializePop(rd, dist, 500, m);
+            std::stable_sort(pop.begin(), pop.end(), LexicographicalComparison{});
+            std::vector<Operon::Scalar> fitness;
+            for (auto const& ind : pop) { fitness.insert(fitness.end(), ind.Fitness.begin(), ind.Fitness.end()); }
+            Operon::Span<Operon::Scalar const> f(fitness.data(), fitness.size());
+
+            CHECK(RankIntersectSorter{}(f, m) == RankIntersectSorter{}(pop));
+            CHECK(RankOrdinalSorter{}(f, m) == RankOrdinalSorter{}(pop));
+            CHECK(DominanceDegreeSorter{}(f, m) == DominanceDegreeSorter{}(pop));
+            CHECK(DeductiveSorter{}(f, m) == DeductiveSorter{}(pop));
+            CHECK(HierarchicalSorter{}(f, m) == HierarchicalSorter{}(pop));
+            CHECK(EfficientBinarySorter{}(f, m) == EfficientBinarySorter{}(pop));
+            CHECK(EfficientSequentialSorter{}(f, m) == EfficientSequentialSorter{}(pop));
+            CHECK(MergeSorter{}(f, m) == MergeSorter{}(pop));
+        }
+    }
+
+    SUBCASE("parallel sort")
+    {
+        auto normalize = [](auto fronts) {
+            for (auto& f : fronts) { std::sort(f.begin(), f.end()); }
+            return fronts;
+        };
+        std::uniform_real_distribution<Operon::Scalar> dist(0, 1);
+        ParallelSorter ps(4, 16); // small blocks so that several blocks are compared in parallel
+        for (size_t m = 2; m <= 5; ++m) {
+            auto pop = initializePop(rd, dist, 1000, m);
+            std::stable_sort(pop.begin(), pop.end(), LexicographicalComparison{});
+            CHECK(normalize(ps(pop)) == normalize(RankIntersectSorter{}(pop)));
+        }
+    }
+
+    SUBCASE("rank intersect matrix")
+    {
+        // the same fronts with a single tile and with tiles of one block of rows (the smallest size), also with ties
+        std::uniform_real_distribution<Operon::Scalar> uniform(0, 1);
+        std::uniform_int_distribution<int> discrete(0, 7);
+        auto ties = [&](auto& random) { return static_cast<Operon::Scalar>(discrete(random)); };
+        for (size_t m = 2; m <= 4; ++m) {
+            for (size_t n : { 1UL, 63UL, 1000UL }) {
+                auto pop = m == 3 ? initializePop(rd, ties, n, m) : initializePop(rd, uniform, n, m);
+                std::stable_sort(pop.begin(), pop.end(), LexicographicalComparison{});
+                auto expected = RankIntersectSorter{}(pop);
+                CHECK(RankIntersectMatrixSorter{}(pop) == expected);
+                CHECK(RankIntersectMatrixSorter{1}(pop) == expected);
+
+                std::vector<Operon::Scalar> fitness;
+                for (auto const& ind : pop) { fitness.insert(fitness.end(), ind.Fitness.begin(), ind.Fitness.end()); }
+                CHECK(RankIntersectMatrixSorter{1}(Operon::Span<Operon::Scalar const>(fitness.data(), fitness.size()), m) == expected);
+            }
+        }
+
+        // the vectorized kernels agree with the scalar loops, also for lengths which do not divide the vector width
+        std::vector<uint64_t> p(37); // NOLINT
+        std::vector<uint64_t> q(p.size());
+        for (size_t i = 0; i < p.size(); ++i) { p[i] = rd(); q[i] = rd(); }
+        size_t count{0};
+        size_t intersect{0};
+        for (size_t i = 0; i < p.size(); ++i) {
+            count += std::bitset<64>(p[i]).count(); // NOLINT
+            intersect += std::bitset<64>(p[i] & q[i]).count(); // NOLINT
+        }
+        CHECK(BitOps::PopCount(p.data(), p.size()) == count);
+        CHECK(BitOps::IntersectCount(p.data(), q.data(), p.size()) == intersect);
+        BitOps::Intersect(p.data(), q.data(), p.size());
+        CHECK(BitOps::PopCount(p.data(), p.size()) == intersect);
+
+        BitMatrix<uint64_t> matrix(3, 100); // NOLINT
+        CHECK(matrix.Stride() == BitMatrix<uint64_t>::Alignment / sizeof(uint64_t));
+        CHECK(matrix.NumBlocks() == 2);
+        CHECK(reinterpret_cast<uintptr_t>(matrix.Row(1)) % BitMatrix<uint64_t>::Alignment == 0); // NOLINT
+    }
+
+    SUBCASE("fixed size dominance")
+    {
+        // the fixed size kernels agree with the generic comparison (also with ties and epsilon)
+        std::uniform_int_distribution<int> dist(0, 3);
+        for (Operon::Scalar eps : { Operon::Scalar{0}, Operon::Scalar{1} }) {
+            for (size_t m : { 2, 3, 4, 5, 8 }) {
+                for (int r = 0; r < 1000; ++r) {
+                    std::vector<Operon::Scalar> a(m);
+                    std::vector<Operon::Scalar> b(m);
+                    std::generate(a.begin(), a.end(), [&]() { return static_cast<Operon::Scalar>(dist(rd)); });
+                    std::generate(b.begin(), b.end(), [&]() { return static_cast<Operon::Scalar>(dist(rd)); });
+                    auto expected = ParetoDominance{}(a, b, eps);
+                    auto actual = DispatchObjectives(m, [&](auto k) { return ParetoDominance{}.Compare<decltype(k)::value>(a.data(), b.data(), m, eps); });
+                    CHECK(actual == expected);
+                }
+            }
+        }
+    }
+
+    SUBCASE("incremental sort")
+    {
+        auto normalize = [](auto fronts) {
+            for (auto& f : fronts) { std::sort(f.begin(), f.end()); }
+            return fronts;
+        };
+        std::uniform_real_distribution<Operon::Scalar> dist(0, 1);
+        constexpr size_t n{300};
+        constexpr size_t m{3};
+        auto pop = initializePop(rd, dist, n, m);
+        std::stable_sort(pop.begin(), pop.end(), LexicographicalComparison{});
+        std::vector<Operon::Scalar> fitness;
+        for (auto const& ind : pop) { fitness.insert(fitness.end(), ind.Fitness.begin(), ind.Fitness.end()); }
+        Operon::Span<Operon::Scalar const> f(fitness.data(), fitness.size());
+
+        // reference fronts of a subset of the rows (in increasing order, hence still lexicographically sorted)
+        auto reference = [&](std::vector<size_t> const& rows) {
+            std::vector<Individual> sub;
+            for (auto i : rows) { sub.push_back(pop[i]); }
+            auto fronts = RankIntersectSorter{}(sub);
+            for (auto& fr : fronts) {
+                for (auto& i : fr) { i = rows[i]; }
+            }
+            return normalize(fronts);
+        };
+
+        IncrementalSorter is;
+        CHECK(is.IsIncremental());
+        CHECK_FALSE(RankIntersectSorter{}.IsIncremental());
+        CHECK(normalize(is(pop)) == normalize(RankIntersectSorter{}(pop)));
+
+        // start from the even rows, insert the odd rows (in reverse), then remove every third row
+        std::vector<size_t> rows;
+        for (size_t i = 0; i < n; i += 2) { rows.push_back(i); }
+        auto fronts = reference(rows);
+        for (auto i = n - 1; i < n; i -= 2) {
+            CHECK(is.Insert(fronts, f, m, i, 0));
+        }
+        std::vector<size_t> all(n);
+        std::iota(all.begin(), all.end(), size_t{0});
+        CHECK(normalize(fronts) == reference(all));
+        CHECK_FALSE(is.Insert(fronts, f, m, 0, 0)); // already present
+
+        std::vector<size_t> kept;
+        for (size_t i = 0; i < n; ++i) {
+            if (i % 3 == 0) { is.Remove(fronts, f, m, i, 0); } else { kept.push_back(i); }
+        }
+        CHECK(normalize(fronts) == reference(kept));
+    }
+
     SUBCASE("bit density")
     {
         size_t reps = 1000;
@@ -414,4 +565,82 @@ TEST_CASE("non-dominated sort" * doctest::test_suite("[implementation]"))
     }
 }
 
+TEST_CASE("pareto archive" * doctest::test_suite("[implementation]"))
+{
+    Operon::RandomGenerator rd(1234);
+    std::uniform_real_distribution<Operon::Scalar> dist(0, 1);
+
+    // points close to a front, so that many of them are non-dominated
+    constexpr size_t n{20000};
+    constexpr Operon::Scalar eps{0.01};
+    std::vector<Individual> points(n);
+    for (auto& p : points) {
+        auto x = dist(rd);
+        p.Fitness = { x, 1 - x + dist(rd) * 0.05F }; // NOLINT
+    }
+    auto box = [&](Individual const& ind, size_t k) { return static_cast<int64_t>(std::floor(ind[k] / eps)); };
+
+    auto check = [&](ParetoArchive const& archive) {
+        auto members = archive.Members();
+        CHECK(members.size() == archive.Size());
+        CHECK(!members.empty());
+        // at most one member per box, and the boxes are mutually non-dominated
+        for (size_t i = 0; i < members.size(); ++i) {
+            for (size_t j = 0; j < members.size(); ++j) {
+                if (i == j) { continue; }
+                auto leq = box(members[i], 0) <= box(members[j], 0) && box(members[i], 1) <= box(members[j], 1);
+                CHECK_FALSE(leq);
+            }
+        }
+        // every point is covered by a member whose box is smaller or equal
+        for (auto const& p : points) {
+            auto covered = std::any_of(members.begin(), members.end(), [&](auto const& a) { return box(a, 0) <= box(p, 0) && box(a, 1) <= box(p, 1); });
+            CHECK(covered);
+        }
+        for (auto const& a : members) {
+            CHECK(archive.Dominates({ a.Fitness.data(), a.Fitness.size() })); // equal to a member
+        }
+    };
+
+    SUBCASE("sequential")
+    {
+        ParetoArchive archive(2, eps);
+        CHECK(archive.Insert({ points.data(), points.size() }) > 0);
+        check(archive);
+
+        Individual invalid;
+        invalid.Fitness = { std::numeric_limits<Operon::Scalar>::quiet_NaN(), 0 };
+        CHECK_FALSE(archive.Insert(invalid));
+
+        archive.Clear();
+        CHECK(archive.Size() == 0);
+    }
+
+    SUBCASE("concurrent")
+    {
+        ParetoArchive archive(2, eps);
+        tf::Executor executor(4);
+        tf::Taskflow taskflow;
+        taskflow.for_each_index(size_t{0}, n, size_t{1}, [&](size_t i) { archive.Insert(points[i]); });
+        executor.run(taskflow).wait();
+        check(archive);
+    }
+
+    SUBCASE("genotype")
+    {
+        // the members are stored as compact trees, the individuals are restored with their genotypes
+        ParetoArchive archive(2, eps);
+        Individual ind;
+        ind.Genotype = Tree { Node::Constant(3), Node(NodeType::Exp) }.UpdateNodes(); // NOLINT
+        ind.Fitness = { 0.5, 0.5 }; // NOLINT
+        CHECK(archive.Insert(ind));
+        auto members = archive.Members();
+        REQUIRE(members.size() == 1);
+        CHECK(members.front().Fitness == ind.Fitness);
+        REQUIRE(members.front().Genotype.Length() == ind.Genotype.Length());
+        CHECK(members.front().Genotype.GetCoefficients() == ind.Genotype.GetCoefficients());
+        CHECK(members.front().Genotype.Nodes().back().Type == NodeType::Exp);
+    }
+}
+
 } // namespace Operon::Test
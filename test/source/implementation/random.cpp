@@ -44,4 +44,60 @@ TEST_CASE("random sampling" * dt::test_suite("[implementation]"))
     }
 }
 
+TEST_CASE("bounded and real conversions" * dt::test_suite("[implementation]"))
+{
+    Operon::Random::RomuTrio rng(1234); // NOLINT
+    size_t samples = 700'000;
+
+    SUBCASE("bounded") {
+        std::vector<size_t> counts(7, 0); // NOLINT
+        for (size_t i = 0; i < samples; ++i) {
+            counts[Operon::Random::Bounded(rng, counts.size())]++;
+        }
+        for (auto c : counts) {
+            CHECK(c > 99'000); // NOLINT
+            CHECK(c < 101'000); // NOLINT
+        }
+        // the upper half of the 64 bit range
+        auto const n = (uint64_t{1} << 63U) + 1; // NOLINT
+        for (size_t i = 0; i < 1000; ++i) { CHECK(Operon::Random::Bounded(rng, n) < n); } // NOLINT
+    }
+
+    SUBCASE("uniform") {
+        for (size_t i = 0; i < samples; ++i) {
+            auto v = Operon::Random::Uniform(rng, -3, 4); // NOLINT
+            CHECK((-3 <= v && v <= 4));
+            auto r = Operon::Random::Uniform(rng, 2.0, 2.5); // NOLINT
+            CHECK((2.0 <= r && r < 2.5));
+        }
+        // the full range of a type
+        auto lo = std::numeric_limits<int64_t>::min();
+        auto hi = std::numeric_limits<int64_t>::max();
+        [[maybe_unused]] auto v = Operon::Random::Uniform(rng, lo, hi);
+        CHECK(Operon::Random::Uniform(rng, size_t{5}, size_t{5}) == 5);
+    }
+
+    SUBCASE("real") {
+        double sum{0};
+        for (size_t i = 0; i < samples; ++i) {
+            auto d = Operon::Random::Real<double>(rng);
+            auto f = Operon::Random::Real<float>(rng);
+            CHECK((0 <= d && d < 1));
+            CHECK((0 <= f && f < 1));
+            sum += d;
+        }
+        CHECK(std::abs(sum / static_cast<double>(samples) - 0.5) < 0.01); // NOLINT
+    }
+
+    SUBCASE("other generators") {
+        // generators of less than 64 bits go through the standard distributions
+        std::mt19937 mt(1234); // NOLINT
+        for (size_t i = 0; i < 1000; ++i) { // NOLINT
+            CHECK(Operon::Random::Bounded(mt, 3) < 3);
+            auto d = Operon::Random::Real<double>(mt);
+            CHECK((0 <= d && d < 1));
+        }
+    }
+}
+
 } // namespace
@@ -0,0 +1,102 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#if !defined(_WIN32)
+#include <doctest/doctest.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <array>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fmt/core.h>
+#include <taskflow/taskflow.hpp>
+
+#include "operon/core/dataset.hpp"
+#include "operon/core/node.hpp"
+#include "operon/core/tree.hpp"
+#include "service.hpp"
+
+namespace Operon::Test {
+
+TEST_CASE("Service over a socket pair")
+{
+    constexpr auto path { "../data/Poly-10.csv" };
+    tf::Executor executor(2);
+
+    // the fit returns the first variable of the dataset given by its options, after a line of progress
+    Operon::Service service(executor, [](std::vector<std::string> const& arguments, Operon::Service& service, std::FILE* out) {
+        REQUIRE(arguments.size() == 3);
+        CHECK(arguments[0] == "operon_gp");
+        CHECK(arguments[1] == "--dataset");
+        auto const ds = service.GetDataset(arguments[2]);
+        auto leaf = Node(NodeType::Variable, ds->Variables().front().Hash);
+        std::fprintf(out, "fitting\n"); // NOLINT
+        return Tree({ leaf }).UpdateNodes();
+    });
+
+    std::array<int, 2> fds {};
+    REQUIRE(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds.data()) == 0);
+    std::thread server([&]() { ServeConnection(service, fds[1]); });
+
+    auto* client = ::fdopen(fds[0], "r+");
+    REQUIRE(client != nullptr);
+    auto request = [&](std::string const& line) {
+        std::fputs((line + "\n").c_str(), client);
+        std::fflush(client);
+    };
+    // the lines of the reply up to the final one (done or error)
+    auto reply = [&]() {
+        std::vector<std::string> lines;
+        std::string line;
+        for (int c = std::fgetc(client); c != EOF; c = std::fgetc(client)) {
+            if (c != '\n') { line.push_back(static_cast<char>(c)); continue; }
+            lines.push_back(line);
+            if (line.rfind("done", 0) == 0 || line.rfind("error", 0) == 0) { break; }
+            line.clear();
+        }
+        return lines;
+    };
+
+    Dataset ds(path, true);
+    request(fmt::format("load {}", path));
+    CHECK(reply().back() == fmt::format("done {} {}", ds.Rows(), ds.Cols()));
+
+    request(fmt::format("fit --dataset {}", path));
+    auto fit = reply();
+    REQUIRE(fit.size() == 2);
+    CHECK(fit.front() == "fitting");
+    CHECK(fit.back() == "done 0");
+
+    request(fmt::format("predict 0 {} 10:15", path));
+    auto predict = reply();
+    REQUIRE(predict.size() == 6);
+    CHECK(predict.back() == "done 5");
+    auto const values = ds.GetValues(ds.Variables().front().Hash);
+    for (size_t i = 0; i < 5; ++i) {
+        CHECK(std::stod(predict[i]) == doctest::Approx(values[10 + i]));
+    }
+
+    request("predict 1 x");
+    CHECK(reply().back().rfind("error", 0) == 0);
+
+    // the released model and dataset are gone
+    request("drop 0");
+    CHECK(reply().back() == "done");
+    CHECK(service.ModelCount() == 0);
+    request(fmt::format("unload {}", path));
+    CHECK(reply().back() == "done");
+    CHECK(service.DatasetCount() == 0);
+    request(fmt::format("predict 0 {}", path));
+    CHECK(reply().back() == "error unknown model 0");
+
+    request("quit");
+    server.join();
+    std::fclose(client);
+}
+
+} // namespace Operon::Test
+#endif
@@ -0,0 +1,241 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <algorithm>
+#include <array>
+#include <doctest/doctest.h>
+#include <fmt/format.h>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <taskflow/taskflow.hpp>
+#include <thread>
+
+#include "operon/algorithms/config.hpp"
+#include "operon/algorithms/gp.hpp"
+#include "operon/algorithms/nsga2.hpp"
+#include "operon/core/dataset.hpp"
+#include "operon/core/problem.hpp"
+#include "operon/core/pset.hpp"
+#include "operon/interpreter/interpreter.hpp"
+#include "operon/operators/creator.hpp"
+#include "operon/operators/crossover.hpp"
+#include "operon/operators/evaluator.hpp"
+#include "operon/operators/generator.hpp"
+#include "operon/operators/initializer.hpp"
+#include "operon/operators/mutation.hpp"
+#include "operon/operators/non_dominated_sorter.hpp"
+#include "operon/operators/reinserter.hpp"
+#include "operon/operators/selector.hpp"
+
+#include "nanobench.h"
+
+namespace Operon::Test {
+    namespace nb = ankerl::nanobench;
+
+    namespace {
+        // the bundled problems (see the json files next to the csv files)
+        struct Benchmark {
+            char const* Name;
+            char const* Target;
+            size_t TrainingRows;
+        };
+
+        constexpr std::array Benchmarks {
+            Benchmark { "AirfoilSelfNoise", "Y", 1000 },
+            Benchmark { "Breiman-I", "Y", 5001 },
+            Benchmark { "Chemical-I", "y", 711 },
+            Benchmark { "Concrete", "Y", 500 },
+            Benchmark { "Friedman-I", "Y", 5000 },
+            Benchmark { "Friedman-II", "Y", 5000 },
+            Benchmark { "Pagie-1", "F", 676 },
+            Benchmark { "Poly-10", "Y", 250 },
+            Benchmark { "Sextic", "Y", 50 },
+            Benchmark { "Vladislavleva-1", "Y", 100 },
+            Benchmark { "Vladislavleva-2", "Y", 100 },
+            Benchmark { "Vladislavleva-3", "Y", 600 },
+            Benchmark { "Vladislavleva-4", "Y", 1024 },
+            Benchmark { "Vladislavleva-5", "Y", 300 },
+            Benchmark { "Vladislavleva-6", "Y", 30 },
+            Benchmark { "Vladislavleva-7", "Y", 300 },
+            Benchmark { "Vladislavleva-8", "Y", 50 },
+        };
+
+        enum class Algorithm { GP, NSGA2 };
+
+        // the counters of one run
+        struct Throughput {
+            size_t Generations{0};
+            size_t Evaluations{0};
+            double NodeRows{0}; // estimated: evaluations times the average length of the evaluated trees times the rows
+        };
+
+        // 1, 2, 4, ... and the number of hardware threads
+        auto ThreadCounts() -> std::vector<size_t>
+        {
+            auto const n = std::max(size_t{1}, static_cast<size_t>(std::thread::hardware_concurrency()));
+            std::vector<size_t> counts;
+            for (size_t i = 1; i < n; i *= 2) { counts.push_back(i); }
+            counts.push_back(n);
+            return counts;
+        }
+
+        auto MeanLength(Operon::Span<Individual const> individuals) -> double
+        {
+            if (individuals.empty()) { return 0; }
+            auto total = std::transform_reduce(individuals.begin(), individuals.end(), 0UL, std::plus<> {}, [](auto const& ind) { return ind.Genotype.Length(); });
+            return static_cast<double>(total) / static_cast<double>(individuals.size());
+        }
+
+        // one complete run of the algorithm with a fixed seed, the setup is not timed
+        auto Run(nb::Bench& bench, std::string const& name, Dataset const& ds, Benchmark const& benchmark, Algorithm algorithm, size_t iterations, size_t threads) -> Throughput
+        {
+            constexpr size_t populationSize { 1000 };
+            constexpr size_t generations { 20 };
+            constexpr size_t maxLength { 50 };
+            constexpr size_t maxDepth { 10 };
+            constexpr double crossoverInternalProbability { 0.9 };
+            constexpr uint64_t seed { 1234 };
+
+            std::vector<Variable> inputs;
+            auto variables = ds.Variables();
+            std::copy_if(variables.begin(), variables.end(), std::back_inserter(inputs), [&](auto const& v) { return v.Name != benchmark.Target; });
+
+            Range trainingRange { 0, benchmark.TrainingRows };
+            Range testRange { benchmark.TrainingRows, ds.Rows() };
+            auto problem = Problem(ds).Inputs(inputs).Target(benchmark.Target).TrainingRange(trainingRange).TestRange(testRange);
+            problem.GetPrimitiveSet().SetConfig(PrimitiveSet::Arithmetic | NodeType::Exp | NodeType::Log | NodeType::Sin | NodeType::Cos);
+
+            BalancedTreeCreator creator { problem.GetPrimitiveSet(), problem.InputVariables(), /*bias=*/0.0 };
+            auto [amin, amax] = problem.GetPrimitiveSet().FunctionArityLimits();
+            UniformTreeInitializer treeInitializer(creator);
+            treeInitializer.ParameterizeDistribution(amin + 1, maxLength);
+            treeInitializer.SetMinDepth(1);
+            treeInitializer.SetMaxDepth(maxDepth);
+
+            NormalCoefficientInitializer coeffInitializer;
+            coeffInitializer.ParameterizeDistribution(Operon::Scalar { 0 }, Operon::Scalar { 1 });
+
+            SubtreeCrossover crossover { crossoverInternalProbability, maxDepth, maxLength };
+            MultiMutation mutator {};
+            OnePointMutation<std::normal_distribution<Operon::Scalar>> onePoint;
+            onePoint.ParameterizeDistribution(Operon::Scalar { 0 }, Operon::Scalar { 1 });
+            ChangeVariableMutation changeVar { problem.InputVariables() };
+            ChangeFunctionMutation changeFunc { problem.GetPrimitiveSet() };
+            ReplaceSubtreeMutation replaceSubtree { creator, coeffInitializer, maxDepth, maxLength };
+            InsertSubtreeMutation insertSubtree { creator, coeffInitializer, maxDepth, maxLength };
+            RemoveSubtreeMutation removeSubtree { problem.GetPrimitiveSet() };
+            mutator.Add(onePoint, 1.0);
+            mutator.Add(changeVar, 1.0);
+            mutator.Add(changeFunc, 1.0);
+            mutator.Add(replaceSubtree, 1.0);
+            mutator.Add(insertSubtree, 1.0);
+            mutator.Add(removeSubtree, 1.0);
+
+            GeneticAlgorithmConfig config {};
+            config.Generations = generations;
+            config.PopulationSize = populationSize;
+            config.PoolSize = populationSize;
+            config.Evaluations = std::numeric_limits<size_t>::max();
+            config.Iterations = iterations;
+            config.CrossoverProbability = 1.0;
+            config.MutationProbability = 0.25; // NOLINT
+            config.TimeLimit = std::numeric_limits<size_t>::max();
+            config.Seed = seed;
+
+            Interpreter interpreter;
+            Evaluator errorEvaluator(problem, interpreter, MSE {}, /*linearScaling=*/true);
+            errorEvaluator.SetLocalOptimizationIterations(iterations);
+            errorEvaluator.SetBudget(config.Evaluations);
+
+            Throughput result;
+            auto const rows = static_cast<double>(trainingRange.Size());
+            size_t evaluations { 0 };
+            auto count = [&](auto const& algo) {
+                auto const total = errorEvaluator.TotalEvaluations();
+                auto const evaluated = algo.Generation() == 0 ? algo.Parents() : algo.Offspring();
+                result.NodeRows += static_cast<double>(total - evaluations) * MeanLength(evaluated) * rows;
+                evaluations = total;
+            };
+
+            tf::Executor executor(threads);
+            Operon::RandomGenerator random(seed);
+
+            if (algorithm == Algorithm::GP) {
+                auto comp = [](auto const& lhs, auto const& rhs) { return lhs[0] < rhs[0]; };
+                TournamentSelector selector(comp);
+                selector.SetKey(ObjectiveKey(0));
+                KeepBestReinserter reinserter(comp);
+                reinserter.SetKey(ObjectiveKey(0));
+                BasicOffspringGenerator generator(errorEvaluator, crossover, mutator, selector, selector);
+
+                GeneticProgrammingAlgorithm gp { problem, config, treeInitializer, coeffInitializer, generator, reinserter };
+                bench.run(name, [&]() { gp.Run(executor, random, [&]() { count(gp); }); });
+                result.Generations = gp.Generation();
+            } else {
+                LengthEvaluator lengthEvaluator(problem);
+                MultiEvaluator evaluator(problem);
+                evaluator.Add(errorEvaluator);
+                evaluator.Add(lengthEvaluator);
+
+                CrowdedComparison comp;
+                TournamentSelector selector(comp);
+                selector.SetKey(CrowdedKey());
+                KeepBestReinserter reinserter(comp);
+                reinserter.SetKey(CrowdedKey());
+                BasicOffspringGenerator generator(evaluator, crossover, mutator, selector, selector);
+                RankIntersectSorter sorter;
+
+                NSGA2 gp { problem, config, treeInitializer, coeffInitializer, generator, reinserter, sorter };
+                bench.run(name, [&]() { gp.Run(executor, random, [&]() { count(gp); }); });
+                result.Generations = gp.Generation();
+            }
+            result.Evaluations = errorEvaluator.TotalEvaluations();
+            return result;
+        }
+    } // namespace
+
+    // end-to-end throughput of the algorithms on the bundled problems: every configuration (algorithm, problem, local
+    // search on/off, number of threads) is one complete run with a fixed seed. the results go to gp_throughput.csv (the
+    // derived rates) and gp_throughput.json (the nanobench measurements) in the working directory, which should be the
+    // root of the repository (the problems are read from ./data)
+    TEST_CASE("GP throughput" * doctest::test_suite("[performance]"))
+    {
+        constexpr size_t localSearchIterations { 10 };
+
+        std::ofstream csv("./gp_throughput.csv");
+        csv << "algorithm,problem,rows,iterations,threads,seconds,generations,evaluations,evaluations_per_second,generations_per_second,node_rows_per_second\n";
+
+        nb::Bench bench;
+        bench.title("GP throughput").unit("run").epochs(1).epochIterations(1).warmup(0).performanceCounters(true);
+
+        for (auto const& benchmark : Benchmarks) {
+            auto const path = fmt::format("./data/{}.csv", benchmark.Name);
+            if (!std::ifstream(path)) {
+                MESSAGE(fmt::format("{}: not found, skipping", path));
+                continue;
+            }
+            Dataset ds(path, /*hasHeader=*/true);
+
+            for (auto algorithm : { Algorithm::GP, Algorithm::NSGA2 }) {
+                for (auto iterations : { size_t { 0 }, localSearchIterations }) {
+                    for (auto threads : ThreadCounts()) {
+                        auto const* algo = algorithm == Algorithm::GP ? "gp" : "nsga2";
+                        auto name = fmt::format("{} {} iterations={} threads={}", algo, benchmark.Name, iterations, threads);
+                        auto result = Run(bench, name, ds, benchmark, algorithm, iterations, threads);
+                        auto seconds = bench.results().back().median(nb::Result::Measure::elapsed);
+                        csv << fmt::format("{},{},{},{},{},{},{},{},{},{},{}\n", algo, benchmark.Name, benchmark.TrainingRows, iterations, threads, seconds,
+                            result.Generations, result.Evaluations,
+                            static_cast<double>(result.Evaluations) / seconds,
+                            static_cast<double>(result.Generations) / seconds,
+                            result.NodeRows / seconds);
+                        csv.flush();
+                    }
+                }
+            }
+        }
+
+        std::ofstream json("./gp_throughput.json");
+        bench.render(nb::templates::json(), json);
+    }
+} // namespace Operon::Test
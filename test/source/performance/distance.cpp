@@ -2,6 +2,8 @@
 // SPDX-FileCopyrightText: Copyright 2019-2021 Heal Research
 
 #include <doctest/doctest.h>
+#include <taskflow/taskflow.hpp>
+#include <thread>
 
 #include "operon/core/dataset.hpp"
 #include "operon/core/format.hpp"
@@ -13,6 +15,8 @@
 
 #include "nanobench.h"
 
+namespace nb = ankerl::nanobench;
+
 namespace Operon {
 namespace Test {
 
@@ -27,10 +31,10 @@ struct ComputeDistanceMatrix {
         double d = 0;
         for (size_t i = 0; i < hashes.size() - 1; ++i) {
             for (size_t j = i+1; j < hashes.size(); ++j) {
-                d += static_cast<double>(Operon::Distance::Jaccard(hashes[i], hashes[j]));
+                d += static_cast<double>(f_(hashes[i], hashes[j]));
             }
         }
-        return 2 * d / (hashes.size() * hashes.size()-1);
+        return 2 * d / static_cast<double>(hashes.size() * (hashes.size() - 1));
     }
 
     Callable f_;
@@ -109,6 +113,67 @@ TEST_CASE("Intersection performance")
         fmt::print("d = {}\n", d);
     }
 }
+
+TEST_CASE("Pairwise distance performance")
+{
+    constexpr size_t n = 5000;
+    constexpr size_t maxLength = 100;
+    constexpr size_t maxDepth = 1000;
+    constexpr size_t minEpochIterations = 5;
+
+    Operon::RandomGenerator rd(1234);
+    Eigen::Matrix<Operon::Scalar, -1, -1> data = decltype(data)::Random(10, 10);
+    auto ds = Dataset(data);
+
+    PrimitiveSet pset;
+    pset.SetConfig(PrimitiveSet::Arithmetic);
+    auto variables = ds.Variables();
+    auto creator = BalancedTreeCreator { pset, variables };
+    std::uniform_int_distribution<size_t> sizeDistribution(1, maxLength);
+
+    std::vector<Operon::Vector<Operon::Hash>> hashes(n);
+    for (auto& h : hashes) {
+        auto tree = creator(rd, sizeDistribution(rd), 0, maxDepth);
+        auto const& nodes = tree.Hash(Operon::HashMode::Strict).Nodes();
+        std::transform(nodes.begin(), nodes.end(), std::back_inserter(h), [](auto const& node) { return node.CalculatedHashValue; });
+        std::sort(h.begin(), h.end());
+    }
+    Operon::Span<Operon::Vector<Operon::Hash> const> sets(hashes.data(), hashes.size());
+
+    nb::Bench b;
+    b.title("pairwise distance").relative(true).performanceCounters(true).minEpochIterations(minEpochIterations);
+    b.batch(n * (n - 1) / 2);
+
+    SUBCASE("serial baseline")
+    {
+        b.run("nested loop", [&]() {
+            double sum{0};
+            for (size_t i = 0; i < n - 1; ++i) {
+                for (size_t j = i + 1; j < n; ++j) {
+                    sum += Distance::Jaccard(hashes[i], hashes[j]);
+                }
+            }
+            nb::doNotOptimizeAway(sum);
+        });
+    }
+
+    SUBCASE("pairwise means")
+    {
+        for (size_t i = 1; i <= std::thread::hardware_concurrency(); ++i) {
+            tf::Executor executor(i);
+            b.run(fmt::format("N = {}", i), [&]() { nb::doNotOptimizeAway(Distance::PairwiseMeans(executor, sets)); });
+        }
+    }
+
+    SUBCASE("pairwise matrix")
+    {
+        std::vector<double> matrix(n * n);
+        for (size_t i = 1; i <= std::thread::hardware_concurrency(); ++i) {
+            tf::Executor executor(i);
+            b.run(fmt::format("N = {}", i), [&]() { Distance::PairwiseMatrix(executor, sets, Operon::Span<double>(matrix.data(), matrix.size())); });
+        }
+    }
+}
 } // namespace Test
 } // namespace Operon
 
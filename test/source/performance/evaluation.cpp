@@ -10,6 +10,7 @@
 
 #include "operon/algorithms/config.hpp"
 #include "operon/algorithms/nsga2.hpp"
+#include "operon/core/allocation.hpp"
 #include "operon/core/dataset.hpp"
 #include "operon/core/pset.hpp"
 #include "operon/interpreter/dispatch_table.hpp"
@@ -163,6 +164,109 @@ namespace Operon::Test {
         }
     }
 
+    // compares the primitive kernels used by the interpreter (vectorclass-based when built with
+    // USE_VECTORIZED_MATH) against the plain Eigen array expressions
+    TEST_CASE("Primitive kernel performance")
+    {
+        using T = Operon::Scalar;
+        using A = detail::Array<T>;
+        using R = detail::Ref<T>;
+
+        constexpr size_t minEpochIterations = 100;
+
+        A x = (A::Random() + T{1}) / T{2}; // values in [0, 1] are fine for every primitive
+        A y;
+
+        auto test = [&](nb::Bench& b, std::string const& name, auto&& kernel, auto&& reference) {
+            b.batch(x.size());
+            b.run(fmt::format("{} (kernel)", name), [&]() { kernel(R(y), R(x)); nb::doNotOptimizeAway(y); });
+            b.run(fmt::format("{} (eigen)", name), [&]() { y = reference(x); nb::doNotOptimizeAway(y); });
+        };
+
+        nb::Bench b;
+        b.title("primitive kernels").relative(true).performanceCounters(true).minEpochIterations(minEpochIterations);
+
+        test(b, "exp",   Function<NodeType::Exp>{},   [](auto const& v) { return v.exp(); });
+        test(b, "log",   Function<NodeType::Log>{},   [](auto const& v) { return v.log(); });
+        test(b, "sin",   Function<NodeType::Sin>{},   [](auto const& v) { return v.sin(); });
+        test(b, "cos",   Function<NodeType::Cos>{},   [](auto const& v) { return v.cos(); });
+        test(b, "tan",   Function<NodeType::Tan>{},   [](auto const& v) { return v.tan(); });
+        test(b, "asin",  Function<NodeType::Asin>{},  [](auto const& v) { return v.asin(); });
+        test(b, "acos",  Function<NodeType::Acos>{},  [](auto const& v) { return v.acos(); });
+        test(b, "atan",  Function<NodeType::Atan>{},  [](auto const& v) { return v.atan(); });
+        test(b, "sinh",  Function<NodeType::Sinh>{},  [](auto const& v) { return v.sinh(); });
+        test(b, "cosh",  Function<NodeType::Cosh>{},  [](auto const& v) { return v.cosh(); });
+        test(b, "tanh",  Function<NodeType::Tanh>{},  [](auto const& v) { return v.tanh(); });
+        test(b, "sqrt",  Function<NodeType::Sqrt>{},  [](auto const& v) { return v.sqrt(); });
+        test(b, "cbrt",  Function<NodeType::Cbrt>{},  [](auto const& v) { return v.unaryExpr([](auto a) { return ceres::cbrt(a); }); });
+        test(b, "log1p", Function<NodeType::Log1p>{}, [](auto const& v) { return v.log1p(); });
+    }
+
+    // hash table lookup of the variable columns (done once per variable node when compiling a tree)
+    // against the binary search over the sorted variables it replaced
+    TEST_CASE("Dataset column lookup")
+    {
+        constexpr size_t rows = 100;
+        constexpr size_t cols = 500;
+        std::vector<std::vector<Operon::Scalar>> values(cols, std::vector<Operon::Scalar>(rows, 0));
+        Dataset ds(values);
+
+        std::vector<Operon::Hash> hashes;
+        for (auto const& v : ds.Variables()) { hashes.push_back(v.Hash); }
+        Operon::RandomGenerator rng(1234);
+        std::shuffle(hashes.begin(), hashes.end(), rng);
+        auto variables = ds.Variables();
+
+        nb::Bench b;
+        b.title("column lookup").relative(true).batch(hashes.size());
+        b.run("binary search", [&]() {
+            for (auto h : hashes) {
+                auto it = std::partition_point(variables.begin(), variables.end(), [&](auto const& v) { return v.Hash < h; });
+                nb::doNotOptimizeAway(ds.GetValues(static_cast<int>(it->Index)).data());
+            }
+        });
+        b.run("hash table", [&]() {
+            for (auto h : hashes) { nb::doNotOptimizeAway(ds.GetValues(h).data()); }
+        });
+    }
+
+    // evaluates the same trees over a dataset of a few hundred megabytes backed by small pages and by transparent
+    // huge pages (see Memory::PagePolicy). the difference shows in the dtlb misses, which nanobench does not count, so
+    // it is best read with perf stat
+    TEST_CASE("Huge page performance")
+    {
+        constexpr size_t n = 100;
+        constexpr size_t maxLength = 50;
+        constexpr size_t maxDepth = 1000;
+        constexpr size_t nrow = 2'000'000;
+        constexpr size_t ncol = 20;
+
+        Eigen::Matrix<Operon::Scalar, -1, -1> data = decltype(data)::Random(nrow, ncol);
+        Operon::RandomGenerator rd(1234);
+
+        PrimitiveSet pset(PrimitiveSet::Arithmetic);
+        Dataset const reference(data);
+        auto inputs = reference.Variables();
+        auto creator = BalancedTreeCreator { pset, inputs };
+        std::uniform_int_distribution<size_t> sizeDistribution(1, maxLength);
+        std::vector<Tree> trees(n);
+        std::generate(trees.begin(), trees.end(), [&]() { return creator(rd, sizeDistribution(rd), 0, maxDepth); });
+
+        Interpreter interpreter;
+        Range range { 0, nrow };
+        tf::Executor executor(std::thread::hardware_concurrency());
+
+        nb::Bench b;
+        b.title("huge pages").relative(true).batch(TotalNodes(trees) * range.Size()).minEpochIterations(2);
+
+        for (auto [policy, name] : { std::pair{Memory::PagePolicy::Default, "small pages"}, std::pair{Memory::PagePolicy::Transparent, "transparent huge pages"} }) {
+            Memory::SetAllocationPolicy({ policy });
+            Dataset const ds(reference); // the copy is advised with the policy in effect
+            b.run(name, [&]() { Evaluate<Operon::Scalar>(executor, interpreter, trees, ds, range); });
+        }
+        Memory::SetAllocationPolicy({});
+    }
+
     TEST_CASE("Evaluator performance")
     {
         const size_t n         = 1000;
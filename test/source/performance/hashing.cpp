@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <doctest/doctest.h>
+#include <taskflow/taskflow.hpp>
+#include <thread>
+
+#include "nanobench.h"
+#include "operon/core/dataset.hpp"
+#include "operon/core/pset.hpp"
+#include "operon/hash/hash.hpp"
+#include "operon/hash/population.hpp"
+#include "operon/operators/creator.hpp"
+
+namespace nb = ankerl::nanobench;
+
+namespace Operon::Test {
+
+TEST_CASE("Population hashing performance")
+{
+    constexpr size_t n = 10000;
+    constexpr size_t maxLength = 100;
+    constexpr size_t maxDepth = 1000;
+    constexpr size_t minEpochIterations = 5;
+
+    Operon::RandomGenerator rd(1234);
+    Eigen::Matrix<Operon::Scalar, -1, -1> data = decltype(data)::Random(10, 10);
+    auto ds = Dataset(data);
+
+    PrimitiveSet pset;
+    pset.SetConfig(PrimitiveSet::Arithmetic);
+    auto variables = ds.Variables();
+    auto creator = BalancedTreeCreator { pset, variables };
+    std::uniform_int_distribution<size_t> sizeDistribution(1, maxLength);
+
+    std::vector<Tree> trees(n);
+    std::generate(trees.begin(), trees.end(), [&]() { return creator(rd, sizeDistribution(rd), 0, maxDepth); });
+    auto totalNodes = std::transform_reduce(trees.begin(), trees.end(), size_t{0}, std::plus<>{}, [](auto const& t) { return t.Length(); });
+    Operon::Span<Tree const> population(trees.data(), trees.size());
+
+    nb::Bench b;
+    b.title("population hashing").relative(true).performanceCounters(true).minEpochIterations(minEpochIterations);
+    b.batch(totalNodes);
+
+    SUBCASE("hasher")
+    {
+        // cost of the byte hasher for a leaf key (hash value + coefficient)
+        std::array<uint8_t, sizeof(Operon::Hash) + sizeof(Operon::Scalar)> key {};
+        b.batch(1).run("leaf key", [&]() {
+            ++key[0];
+            nb::doNotOptimizeAway(Operon::Hasher{}(key.data(), key.size()));
+        });
+    }
+
+    SUBCASE("serial baseline")
+    {
+        for (auto mode : { Operon::HashMode::Strict, Operon::HashMode::Relaxed }) {
+            b.run(fmt::format("Tree::Hash ({})", mode == Operon::HashMode::Strict ? "strict" : "relaxed"), [&]() {
+                for (auto const& t : trees) { nb::doNotOptimizeAway(t.Hash(mode).HashValue()); }
+            });
+        }
+    }
+
+    SUBCASE("parallel")
+    {
+        for (size_t i = 1; i <= std::thread::hardware_concurrency(); ++i) {
+            tf::Executor executor(i);
+            b.run(fmt::format("N = {}", i), [&]() { HashPopulation(executor, population, Operon::HashMode::Strict); });
+        }
+    }
+}
+
+} // namespace Operon::Test
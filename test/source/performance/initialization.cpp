@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <doctest/doctest.h>
+#include <taskflow/taskflow.hpp>
+#include <thread>
+
+#include "nanobench.h"
+#include "operon/core/dataset.hpp"
+#include "operon/core/pset.hpp"
+#include "operon/operators/creator.hpp"
+#include "operon/operators/initializer.hpp"
+
+namespace nb = ankerl::nanobench;
+
+namespace Operon::Test {
+
+TEST_CASE("Population initialization performance")
+{
+    constexpr size_t n = 100000;
+    constexpr size_t maxLength = 50;
+    constexpr size_t maxDepth = 1000;
+
+    Operon::RandomGenerator rd(1234);
+    Eigen::Matrix<Operon::Scalar, -1, -1> data = decltype(data)::Random(10, 10);
+    auto ds = Dataset(data);
+    auto variables = ds.Variables();
+
+    PrimitiveSet pset;
+    pset.SetConfig(PrimitiveSet::TypeCoherent);
+
+    BalancedTreeCreator btc { pset, variables };
+    ProbabilisticTreeCreator ptc { pset, variables };
+    GrowTreeCreator grow { pset, variables };
+
+    std::vector<Tree> trees(n);
+    std::vector<Operon::RandomGenerator> rngs;
+    for (size_t i = 0; i < n; ++i) { rngs.emplace_back(rd()); }
+
+    nb::Bench b;
+    b.title("population initialization").relative(true).minEpochIterations(1).batch(n);
+
+    for (auto* creator : std::initializer_list<CreatorBase*>{ &btc, &ptc, &grow }) {
+        UniformTreeInitializer treeInit(*creator);
+        treeInit.ParameterizeDistribution(size_t{1}, maxLength);
+        treeInit.SetMaxDepth(creator == static_cast<CreatorBase*>(&grow) ? size_t{6} : maxDepth);
+
+        for (size_t threads : { size_t{1}, size_t{std::thread::hardware_concurrency()} }) {
+            tf::Executor executor(threads);
+            auto name = creator == static_cast<CreatorBase*>(&btc) ? "BTC" : creator == static_cast<CreatorBase*>(&ptc) ? "PTC2" : "Grow";
+            b.run(fmt::format("{} (N = {})", name, threads), [&]() {
+                tf::Taskflow taskflow;
+                taskflow.for_each_index(size_t{0}, n, size_t{1}, [&](size_t i) { trees[i] = treeInit(rngs[i]); });
+                executor.run(taskflow).wait();
+            });
+        }
+    }
+}
+
+} // namespace Operon::Test
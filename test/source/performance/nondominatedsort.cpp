@@ -105,12 +105,14 @@ TEST_CASE("non-dominated sort" * doctest::test_suite("[performance]"))
     EfficientSequentialSorter ensSs;
     RankOrdinalSorter ro;
     RankIntersectSorter rs;
+    RankIntersectMatrixSorter rsm;
     MergeSorter ms_;
 
     SUBCASE("point cloud all")
     {
         bench.minEpochIterations(10);
         Test("RS", bench, [&](auto pop) { return rs(pop); }, rd, dist, ns, ms);
+        Test("RS-M", bench, [&](auto pop) { return rsm(pop); }, rd, dist, ns, ms);
         Test("RO", bench, [&](auto pop) { return ro(pop); }, rd, dist, ns, ms);
         //Test("DS", bench, [&](auto pop){ return ds.Sort(pop); }, rd, dist, ns, ms);
         //Test("HS", bench, [&](auto pop){ return ds.Sort(pop); }, rd, dist, ns, ms);
@@ -155,6 +157,17 @@ TEST_CASE("non-dominated sort" * doctest::test_suite("[performance]"))
     SUBCASE("point cloud ENS-SS") { Test("ENS-SS", bench, ensSs, rd, dist, ns, ms); }
     SUBCASE("point cloud MS") { Test("MNDS", bench, ms_, rd, dist, ns, ms); }
 
+    SUBCASE("point cloud parallel")
+    {
+        std::vector<size_t> sizes { 1000, 10000, 50000, 100000 };
+        bench.minEpochIterations(1);
+        for (size_t t : { size_t{1}, size_t{std::thread::hardware_concurrency()} }) {
+            ParallelSorter ps(t);
+            Test(fmt::format("PS (threads = {})", t), bench, ps, rd, dist, sizes, ms);
+        }
+        Test("RS", bench, rs, rd, dist, sizes, ms);
+    }
+
     //using F = std::function<std::vector<std::vector<size_t>>(Operon::Span<Operon::Individual const>)>;
     auto check_complexity = [&](size_t m, auto&& sorter) {
         std::vector<size_t> sizes { 500, 1000, 2000, 3000, 4000, 5000, 6000, 7000, 8000, 9000, 10000 };
@@ -0,0 +1,220 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <doctest/doctest.h>
+#include <fmt/format.h>
+#include <fstream>
+#include <random>
+
+#include "operon/core/dataset.hpp"
+#include "operon/core/pset.hpp"
+#include "operon/error_metrics/mean_squared_error.hpp"
+#include "operon/interpreter/interpreter.hpp"
+#include "operon/nnls/nnls.hpp"
+#include "operon/operators/creator.hpp"
+
+#include "nanobench.h"
+
+namespace Operon::Test {
+    namespace nb = ankerl::nanobench;
+
+    namespace {
+        // a fitting problem with a known solution: the target is the response of the tree with its original
+        // coefficients, the fit starts from perturbed ones
+        struct Fit {
+            Tree Model;
+            std::vector<Operon::Scalar> Start;
+            Operon::Vector<Operon::Scalar> Target;
+        };
+
+        // the statistics of the fits of one measurement
+        struct FitStatistics {
+            size_t Fits { 0 };
+            size_t Converged { 0 };
+            size_t ResidualEvaluations { 0 };
+            size_t JacobianEvaluations { 0 };
+            double InitialCost { 0 };
+            double FinalCost { 0 };
+        };
+
+        // the cost in the convention of the solvers (half the sum of squared residuals), the eigen based backends do not
+        // report it
+        auto Cost(Interpreter const& interpreter, Tree const& tree, Dataset const& ds, Range range, Operon::Span<Operon::Scalar const> target) -> double
+        {
+            auto estimated = interpreter.Evaluate<Operon::Scalar>(tree, ds, range);
+            auto mse = MeanSquaredError<Operon::Scalar>({ estimated.data(), estimated.size() }, target);
+            return 0.5 * mse * static_cast<double>(target.size()); // NOLINT
+        }
+
+        template <OptimizerType O, DerivativeMethod D = DerivativeMethod::AUTODIFF>
+        auto Optimize(Interpreter const& interpreter, Dataset const& ds, Range range, std::vector<Fit>& fits, size_t iterations) -> FitStatistics
+        {
+            FitStatistics stats;
+            for (auto& fit : fits) {
+                fit.Model.SetCoefficients(fit.Start);
+                NonlinearLeastSquaresOptimizer<O> optimizer(interpreter, fit.Model, ds);
+                auto summary = optimizer.template Optimize<D>({ fit.Target.data(), fit.Target.size() }, range, iterations);
+                ++stats.Fits;
+                stats.Converged += static_cast<size_t>(summary.Success);
+                stats.ResidualEvaluations += static_cast<size_t>(summary.FunctionEvaluations);
+                stats.JacobianEvaluations += static_cast<size_t>(summary.JacobianEvaluations);
+            }
+            return stats;
+        }
+    } // namespace
+
+    // the local optimization backends (and the derivative methods where a backend supports more than one) on the same
+    // fits, across tree lengths (and thus coefficient counts) and row counts. the results go to optimizer.csv (wall time
+    // per fit and per converged fit, evaluation counts, costs before and after) and optimizer.json (nanobench)
+    TEST_CASE("Local optimization backends" * doctest::test_suite("[performance]"))
+    {
+        constexpr std::array<size_t, 4> lengths { 10, 25, 50, 100 };
+        constexpr std::array<size_t, 3> rowCounts { 100, 1000, 10000 };
+        constexpr size_t ncol { 5 };
+        constexpr size_t nfits { 100 };
+        constexpr size_t iterations { 50 };
+        constexpr size_t maxDepth { 1000 };
+        constexpr Operon::Scalar perturbation { 0.2 };
+        constexpr uint64_t seed { 1234 };
+
+        std::srand(seed); // NOLINT
+        Operon::RandomGenerator random(seed);
+        Interpreter interpreter;
+
+        std::ofstream csv("./optimizer.csv");
+        csv << "backend,derivative,length,coefficients,rows,fits,converged,seconds_per_fit,seconds_per_converged_fit,residual_evaluations_per_fit,jacobian_evaluations_per_fit,initial_cost,final_cost\n";
+
+        nb::Bench bench;
+        bench.title("Local optimization").relative(false).performanceCounters(true).unit("fit").batch(nfits).epochs(3).epochIterations(1); // NOLINT
+
+        for (auto rows : rowCounts) {
+            Eigen::Matrix<Operon::Scalar, -1, -1> data = decltype(data)::Random(static_cast<Eigen::Index>(rows), ncol);
+            Dataset ds(data);
+            Range range { 0, rows };
+            auto variables = ds.Variables();
+
+            PrimitiveSet pset;
+            pset.SetConfig(PrimitiveSet::Arithmetic | NodeType::Exp | NodeType::Log | NodeType::Sin);
+            BalancedTreeCreator creator { pset, variables };
+            std::normal_distribution<Operon::Scalar> noise(Operon::Scalar { 1 }, perturbation);
+
+            for (auto length : lengths) {
+                std::vector<Fit> fits;
+                double coefficients { 0 };
+                while (fits.size() < nfits) {
+                    auto tree = creator(random, length, 0, maxDepth);
+                    auto target = interpreter.Evaluate<Operon::Scalar>(tree, ds, range);
+                    // skip models with undefined responses (e.g. the log of a negative value)
+                    if (!std::all_of(target.begin(), target.end(), [](auto v) { return std::isfinite(v); })) { continue; }
+                    auto start = tree.GetCoefficients();
+                    std::transform(start.begin(), start.end(), start.begin(), [&](auto c) { return c * noise(random); });
+                    coefficients += static_cast<double>(start.size());
+                    fits.push_back({ std::move(tree), std::move(start), std::move(target) });
+                }
+                coefficients /= static_cast<double>(fits.size());
+
+                auto test = [&](std::string const& backend, std::string const& derivative, auto&& optimize) {
+                    FitStatistics stats;
+                    bench.run(fmt::format("{} {} length={} rows={}", backend, derivative, length, rows), [&]() { stats = optimize(); });
+
+                    // the costs of the optimized models (the coefficients of the last measured run)
+                    for (auto& fit : fits) {
+                        stats.FinalCost += Cost(interpreter, fit.Model, ds, range, { fit.Target.data(), fit.Target.size() });
+                        fit.Model.SetCoefficients(fit.Start);
+                        stats.InitialCost += Cost(interpreter, fit.Model, ds, range, { fit.Target.data(), fit.Target.size() });
+                    }
+
+                    auto const seconds = bench.results().back().median(nb::Result::Measure::elapsed);
+                    auto const n = static_cast<double>(stats.Fits);
+                    csv << fmt::format("{},{},{},{},{},{},{},{},{},{},{},{},{}\n", backend, derivative, length, coefficients, rows, stats.Fits, stats.Converged,
+                        seconds / n, stats.Converged == 0 ? 0.0 : seconds / static_cast<double>(stats.Converged),
+                        static_cast<double>(stats.ResidualEvaluations) / n, static_cast<double>(stats.JacobianEvaluations) / n,
+                        stats.InitialCost / n, stats.FinalCost / n);
+                    csv.flush();
+                };
+
+                test("tiny", "autodiff", [&]() { return Optimize<OptimizerType::TINY>(interpreter, ds, range, fits, iterations); });
+                test("eigen", "autodiff", [&]() { return Optimize<OptimizerType::EIGEN>(interpreter, ds, range, fits, iterations); });
+                test("varpro", "autodiff", [&]() { return Optimize<OptimizerType::VARPRO>(interpreter, ds, range, fits, iterations); });
+#if defined(HAVE_CERES)
+                test("ceres", "autodiff", [&]() { return Optimize<OptimizerType::CERES, DerivativeMethod::AUTODIFF>(interpreter, ds, range, fits, iterations); });
+                test("ceres", "numeric", [&]() { return Optimize<OptimizerType::CERES, DerivativeMethod::NUMERIC>(interpreter, ds, range, fits, iterations); });
+#endif
+            }
+        }
+
+        std::ofstream json("./optimizer.json");
+        bench.render(nb::templates::json(), json);
+    }
+
+    // the forward mode jacobian at every jet width, for trees grouped by their number of coefficients: the crossover
+    // points between the widths calibrate Operon::JetWidth. results go to jet_width.csv (seconds per jacobian)
+    TEST_CASE("Jet width" * doctest::test_suite("[performance]"))
+    {
+        constexpr size_t rows { 1000 };
+        constexpr size_t ncol { 5 };
+        constexpr size_t maxCoefficients { 40 };
+        constexpr size_t ntrees { 20 };
+        constexpr size_t maxLength { 120 };
+        constexpr size_t maxDepth { 1000 };
+        constexpr uint64_t seed { 1234 };
+
+        Operon::RandomGenerator random(seed);
+        Interpreter interpreter;
+
+        Eigen::Matrix<Operon::Scalar, -1, -1> data = decltype(data)::Random(static_cast<Eigen::Index>(rows), ncol);
+        Dataset ds(data);
+        Range range { 0, rows };
+        auto variables = ds.Variables();
+        Operon::Vector<Operon::Scalar> target(rows, Operon::Scalar { 1 });
+
+        PrimitiveSet pset;
+        pset.SetConfig(PrimitiveSet::Arithmetic | NodeType::Exp | NodeType::Log | NodeType::Sin | NodeType::Cos);
+        BalancedTreeCreator creator { pset, variables };
+
+        std::vector<std::vector<Tree>> trees(maxCoefficients + 1);
+        for (size_t length = 1; std::any_of(trees.begin() + 1, trees.end(), [](auto const& t) { return t.size() < ntrees; }); ++length) {
+            auto tree = creator(random, length % maxLength + 1, 0, maxDepth);
+            auto k = tree.GetCoefficients().size();
+            if (k > 0 && k <= maxCoefficients && trees[k].size() < ntrees) { trees[k].push_back(std::move(tree)); }
+        }
+
+        std::ofstream csv("./jet_width.csv");
+        csv << "coefficients,width,seconds_per_jacobian,chosen\n";
+
+        nb::Bench bench;
+        bench.title("Jet width").relative(false).performanceCounters(true).unit("jacobian").batch(ntrees).epochs(3); // NOLINT
+
+        for (size_t k = 1; k <= maxCoefficients; ++k) {
+            for (auto width : JetWidths) {
+                std::vector<ResidualEvaluator> evaluators;
+                evaluators.reserve(ntrees);
+                for (auto const& tree : trees[k]) { evaluators.emplace_back(interpreter, tree, ds, target, range); }
+                Operon::Vector<Operon::Scalar> residuals(rows);
+                Operon::Vector<Operon::Scalar> jacobian(rows * k);
+
+                DispatchJetWidth(width, [&](auto jet) {
+                    using Dual = decltype(jet);
+                    bench.run(fmt::format("coefficients={} width={}", k, width), [&]() {
+                        for (size_t i = 0; i < evaluators.size(); ++i) {
+                            auto coeff = trees[k][i].GetCoefficients();
+                            detail::Autodiff<ResidualEvaluator, Dual, Operon::Scalar>(evaluators[i], coeff.data(), residuals.data(), jacobian.data());
+                        }
+                        nb::doNotOptimizeAway(jacobian);
+                    });
+                    return true;
+                });
+
+                auto const seconds = bench.results().back().median(nb::Result::Measure::elapsed);
+                csv << fmt::format("{},{},{},{}\n", k, width, seconds / static_cast<double>(ntrees), static_cast<int>(JetWidth(k) == width));
+            }
+        }
+
+        std::ofstream json("./jet_width.json");
+        bench.render(nb::templates::json(), json);
+    }
+} // namespace Operon::Test
@@ -0,0 +1,289 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <doctest/doctest.h>
+#include <fmt/format.h>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <taskflow/taskflow.hpp>
+#include <thread>
+
+#include "operon/algorithms/config.hpp"
+#include "operon/algorithms/gp.hpp"
+#include "operon/core/dataset.hpp"
+#include "operon/core/problem.hpp"
+#include "operon/core/pset.hpp"
+#include "operon/interpreter/interpreter.hpp"
+#include "operon/operators/creator.hpp"
+#include "operon/operators/crossover.hpp"
+#include "operon/operators/evaluator.hpp"
+#include "operon/operators/generator.hpp"
+#include "operon/operators/initializer.hpp"
+#include "operon/operators/mutation.hpp"
+#include "operon/operators/reinserter.hpp"
+#include "operon/operators/selector.hpp"
+
+#include "nanobench.h"
+
+namespace Operon::Test {
+    namespace nb = ankerl::nanobench;
+
+    namespace {
+        constexpr std::array<size_t, 5> ScalingRows { 1'000, 10'000, 100'000, 1'000'000, 10'000'000 };
+        constexpr std::array<size_t, 2> ScalingColumns { 5, 25 };
+        constexpr std::array<size_t, 3> ScalingLengths { 10, 50, 100 };
+
+        constexpr size_t MaxCells { 50'000'000 };  // larger datasets (rows times columns) are skipped
+        constexpr size_t NodeRowBudget { 500'000'000 }; // per measurement, the number of trees is scaled down to it
+
+        // 1, 2, 4, ... and the number of hardware threads
+        auto WorkerCounts() -> std::vector<size_t>
+        {
+            auto const n = std::max(size_t{1}, static_cast<size_t>(std::thread::hardware_concurrency()));
+            std::vector<size_t> counts;
+            for (size_t i = 1; i < n; i *= 2) { counts.push_back(i); }
+            counts.push_back(n);
+            return counts;
+        }
+
+        // the interpreter streams the dataset columns of the variable leaves and the output through memory, the
+        // intermediate values stay in the (cache resident) batch buffers. every function node is one operation per row.
+        auto BytesPerFlop(std::vector<Tree> const& trees) -> double
+        {
+            size_t bytes { 0 };
+            size_t flops { 0 };
+            for (auto const& tree : trees) {
+                for (auto const& node : tree.Nodes()) {
+                    if (node.IsVariable()) { bytes += sizeof(Operon::Scalar); }
+                    if (!node.IsLeaf()) { ++flops; }
+                }
+                bytes += sizeof(Operon::Scalar);
+            }
+            return flops == 0 ? std::numeric_limits<double>::infinity() : static_cast<double>(bytes) / static_cast<double>(flops);
+        }
+
+        auto NodeCount(std::vector<Tree> const& trees) -> size_t
+        {
+            return std::transform_reduce(trees.begin(), trees.end(), size_t { 0 }, std::plus<> {}, [](auto const& t) { return t.Length(); });
+        }
+
+        // writes one line per measurement, the parallel efficiency is relative to the single worker measurement of the
+        // same configuration (T1 / (N * TN))
+        class Report {
+            std::ofstream csv_;
+            std::map<std::string, double> serial_;
+
+        public:
+            explicit Report(std::string const& path)
+                : csv_(path)
+            {
+                csv_ << "benchmark,rows,columns,length,trees,workers,seconds,node_rows_per_second,speedup,parallel_efficiency,bytes_per_flop\n";
+            }
+
+            auto Write(nb::Bench const& bench, std::string const& benchmark, size_t rows, size_t cols, size_t length, std::vector<Tree> const& trees, size_t workers) -> void
+            {
+                auto const seconds = bench.results().back().median(nb::Result::Measure::elapsed);
+                auto const key = fmt::format("{} {} {} {}", benchmark, rows, cols, length);
+                if (workers == 1) { serial_[key] = seconds; }
+                auto it = serial_.find(key);
+                auto const speedup = it == serial_.end() ? 0.0 : it->second / seconds;
+                auto const nodeRows = static_cast<double>(NodeCount(trees)) * static_cast<double>(rows);
+                csv_ << fmt::format("{},{},{},{},{},{},{},{},{},{},{}\n", benchmark, rows, cols, length, trees.size(), workers, seconds,
+                    nodeRows / seconds, speedup, speedup / static_cast<double>(workers), BytesPerFlop(trees));
+                csv_.flush();
+            }
+        };
+
+        // Eigen::Random draws from std::rand, which the test cases seed
+        auto RandomDataset(size_t rows, size_t cols) -> Dataset
+        {
+            Eigen::Matrix<Operon::Scalar, -1, -1> data = decltype(data)::Random(static_cast<Eigen::Index>(rows), static_cast<Eigen::Index>(cols));
+            return Dataset(data);
+        }
+
+        auto Inputs(Dataset const& ds, std::string const& target) -> std::vector<Variable>
+        {
+            std::vector<Variable> inputs;
+            auto variables = ds.Variables();
+            std::copy_if(variables.begin(), variables.end(), std::back_inserter(inputs), [&](auto const& v) { return v.Name != target; });
+            return inputs;
+        }
+
+        auto Trees(Operon::RandomGenerator& random, PrimitiveSet const& pset, std::vector<Variable> const& inputs, size_t length, size_t count) -> std::vector<Tree>
+        {
+            constexpr size_t maxDepth { 1000 };
+            BalancedTreeCreator creator { pset, inputs };
+            std::vector<Tree> trees(count);
+            std::generate(trees.begin(), trees.end(), [&]() { return creator(random, length, 0, maxDepth); });
+            return trees;
+        }
+    } // namespace
+
+    // how the evaluation scales with the size of the data and the number of workers: sweeps the rows, the columns, the
+    // tree length and the workers over synthetic data. the results go to scaling.csv (with the parallel efficiency and
+    // the bytes per flop estimate) and scaling.json (the nanobench measurements, with the performance counters where
+    // the platform provides them)
+    TEST_CASE("Scaling" * doctest::test_suite("[performance]"))
+    {
+        constexpr size_t minTrees { 16 }; // enough work items to occupy the workers
+        constexpr uint64_t seed { 1234 };
+
+        std::srand(seed); // NOLINT
+        Operon::RandomGenerator random(seed);
+        Report report("./scaling.csv");
+
+        nb::Bench bench;
+        bench.title("Scaling").relative(false).performanceCounters(true).epochs(3).epochIterations(1).warmup(1); // NOLINT
+
+        Interpreter interpreter;
+
+        for (auto rows : ScalingRows) {
+            for (auto cols : ScalingColumns) {
+                if (rows * cols > MaxCells) { continue; }
+                auto ds = RandomDataset(rows, cols);
+                auto target = ds.Variables().back().Name;
+                auto inputs = Inputs(ds, target);
+                Range range { 0, rows };
+
+                auto problem = Problem(ds).Inputs(inputs).Target(target).TrainingRange(range).TestRange(range);
+                problem.GetPrimitiveSet().SetConfig(PrimitiveSet::Arithmetic);
+
+                for (auto length : ScalingLengths) {
+                    auto count = std::max(minTrees, NodeRowBudget / (rows * length));
+                    auto trees = Trees(random, problem.GetPrimitiveSet(), inputs, length, count);
+
+                    std::vector<Individual> individuals(trees.size());
+                    for (size_t i = 0; i < trees.size(); ++i) { individuals[i].Genotype = trees[i]; }
+
+                    Evaluator evaluator(problem, interpreter, MSE {}, /*linearScaling=*/true);
+                    evaluator.SetLocalOptimizationIterations(0);
+                    evaluator.SetBudget(std::numeric_limits<size_t>::max());
+
+                    for (auto workers : WorkerCounts()) {
+                        tf::Executor executor(workers);
+                        std::vector<Operon::Vector<Operon::Scalar>> slots(executor.num_workers(), Operon::Vector<Operon::Scalar>(rows));
+                        // the generator is not thread safe, every worker draws from its own (seeded from the main one)
+                        std::vector<Operon::RandomGenerator> rngs;
+                        rngs.reserve(executor.num_workers());
+                        for (size_t i = 0; i < executor.num_workers(); ++i) { rngs.emplace_back(random()); }
+                        bench.batch(NodeCount(trees) * rows).unit("node-row");
+
+                        {
+                            tf::Taskflow taskflow;
+                            taskflow.for_each(trees.begin(), trees.end(), [&](auto const& tree) {
+                                auto& slot = slots[executor.this_worker_id()];
+                                interpreter.Evaluate<Operon::Scalar>(tree, ds, range, Operon::Span<Operon::Scalar> { slot.data(), slot.size() });
+                            });
+                            bench.run(fmt::format("interpreter rows={} cols={} length={} workers={}", rows, cols, length, workers), [&]() { executor.run(taskflow).wait(); });
+                            report.Write(bench, "interpreter", rows, cols, length, trees, workers);
+                        }
+
+                        {
+                            tf::Taskflow taskflow;
+                            taskflow.for_each(individuals.begin(), individuals.end(), [&](auto& ind) {
+                                auto const id = executor.this_worker_id();
+                                nb::doNotOptimizeAway(evaluator(rngs[id], ind, slots[id]));
+                            });
+                            bench.run(fmt::format("evaluator rows={} cols={} length={} workers={}", rows, cols, length, workers), [&]() { executor.run(taskflow).wait(); });
+                            report.Write(bench, "evaluator", rows, cols, length, trees, workers);
+                        }
+                    }
+                }
+            }
+        }
+
+        std::ofstream json("./scaling.json");
+        bench.render(nb::templates::json(), json);
+    }
+
+    // one generation of the genetic programming loop (initialization, evaluation of the initial population, one round
+    // of variation, evaluation and reinsertion), results in scaling_generation.csv and scaling_generation.json
+    TEST_CASE("Scaling generation" * doctest::test_suite("[performance]"))
+    {
+        constexpr size_t populationSize { 1000 };
+        constexpr size_t maxLength { 50 };
+        constexpr size_t maxDepth { 10 };
+        constexpr size_t maxRows { 1'000'000 }; // a generation evaluates two populations
+        constexpr uint64_t seed { 1234 };
+
+        std::srand(seed); // NOLINT
+        Operon::RandomGenerator random(seed);
+        Report report("./scaling_generation.csv");
+
+        nb::Bench bench;
+        bench.title("Scaling generation").performanceCounters(true).epochs(1).epochIterations(1).warmup(0);
+
+        for (auto rows : ScalingRows) {
+            if (rows > maxRows) { continue; }
+            for (auto cols : ScalingColumns) {
+                auto ds = RandomDataset(rows, cols);
+                auto target = ds.Variables().back().Name;
+                auto inputs = Inputs(ds, target);
+                Range range { 0, rows };
+
+                auto problem = Problem(ds).Inputs(inputs).Target(target).TrainingRange(range).TestRange(range);
+                problem.GetPrimitiveSet().SetConfig(PrimitiveSet::Arithmetic);
+
+                BalancedTreeCreator creator { problem.GetPrimitiveSet(), problem.InputVariables() };
+                auto [amin, amax] = problem.GetPrimitiveSet().FunctionArityLimits();
+                UniformTreeInitializer treeInitializer(creator);
+                treeInitializer.ParameterizeDistribution(amin + 1, maxLength);
+                treeInitializer.SetMinDepth(1);
+                treeInitializer.SetMaxDepth(maxDepth);
+                UniformCoefficientInitializer coeffInitializer;
+                coeffInitializer.ParameterizeDistribution(Operon::Scalar { -1 }, Operon::Scalar { +1 });
+
+                SubtreeCrossover crossover { 0.9, maxDepth, maxLength }; // NOLINT
+                MultiMutation mutator {};
+                ChangeVariableMutation changeVar { problem.InputVariables() };
+                ChangeFunctionMutation changeFunc { problem.GetPrimitiveSet() };
+                RemoveSubtreeMutation removeSubtree { problem.GetPrimitiveSet() };
+                mutator.Add(changeVar, 1.0);
+                mutator.Add(changeFunc, 1.0);
+                mutator.Add(removeSubtree, 1.0);
+
+                GeneticAlgorithmConfig config {};
+                config.Generations = 1;
+                config.PopulationSize = populationSize;
+                config.PoolSize = populationSize;
+                config.Evaluations = std::numeric_limits<size_t>::max();
+                config.Iterations = 0;
+                config.CrossoverProbability = 1.0;
+                config.MutationProbability = 0.25; // NOLINT
+                config.TimeLimit = std::numeric_limits<size_t>::max();
+                config.Seed = seed;
+
+                Interpreter interpreter;
+                Evaluator evaluator(problem, interpreter, MSE {}, /*linearScaling=*/true);
+                evaluator.SetLocalOptimizationIterations(0);
+                evaluator.SetBudget(config.Evaluations);
+
+                auto comp = [](auto const& lhs, auto const& rhs) { return lhs[0] < rhs[0]; };
+                TournamentSelector selector(comp);
+                selector.SetKey(ObjectiveKey(0));
+                KeepBestReinserter reinserter(comp);
+                reinserter.SetKey(ObjectiveKey(0));
+                BasicOffspringGenerator generator(evaluator, crossover, mutator, selector, selector);
+
+                for (auto workers : WorkerCounts()) {
+                    tf::Executor executor(workers);
+                    Operon::RandomGenerator rng(seed);
+                    GeneticProgrammingAlgorithm gp { problem, config, treeInitializer, coeffInitializer, generator, reinserter };
+                    bench.run(fmt::format("generation rows={} cols={} workers={}", rows, cols, workers), [&]() { gp.Run(executor, rng); });
+
+                    std::vector<Tree> trees;
+                    for (auto const& ind : gp.Offspring()) { trees.push_back(ind.Genotype); }
+                    report.Write(bench, "generation", rows, cols, maxLength, trees, workers);
+                }
+            }
+        }
+
+        std::ofstream json("./scaling_generation.json");
+        bench.render(nb::templates::json(), json);
+    }
+} // namespace Operon::Test
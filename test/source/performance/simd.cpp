@@ -0,0 +1,163 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <algorithm>
+#include <doctest/doctest.h>
+#include <fmt/format.h>
+#include <numeric>
+#include <random>
+
+#include "nanobench.h"
+#include "operon/core/comparison.hpp"
+#include "operon/core/distance.hpp"
+#include "operon/core/simd.hpp"
+#include "operon/error_metrics/kernels.hpp"
+#include "operon/random/random.hpp"
+
+namespace nb = ankerl::nanobench;
+
+namespace Operon::Test {
+
+// the explicitly vectorized kernels against plain scalar loops, on the vectors of the target they were built for (the
+// titles name the target: sse2/avx2/avx512 on x86, neon/sve on ARM)
+TEST_CASE("SIMD kernel performance")
+{
+    constexpr size_t minEpochIterations = 100;
+    Operon::RandomGenerator rd(1234);
+
+    SUBCASE("set intersection")
+    {
+        constexpr size_t n = 1000;
+        std::uniform_int_distribution<Operon::Hash> dist(0, 1000);
+        std::vector<Operon::Vector<Operon::Hash>> sets(n);
+        for (auto& s : sets) {
+            s.resize(dist(rd) % 100 + 1);
+            std::generate(s.begin(), s.end(), [&]() { return dist(rd); });
+            std::sort(s.begin(), s.end());
+        }
+
+        nb::Bench b;
+        b.title(fmt::format("jaccard distance ({})", Simd::Target)).relative(true).performanceCounters(true).minEpochIterations(minEpochIterations);
+        b.batch(n - 1);
+        b.run("scalar", [&]() {
+            double sum{0};
+            for (size_t i = 1; i < n; ++i) {
+                auto const& p = sets[i - 1];
+                auto const& q = sets[i];
+                size_t c{0};
+                for (size_t u = 0, v = 0; u < p.size() && v < q.size();) {
+                    c += p[u] == q[v];
+                    auto const a = p[u];
+                    auto const t = q[v];
+                    u += a <= t;
+                    v += a >= t;
+                }
+                auto const m = static_cast<double>(p.size() + q.size());
+                sum += (m - 2 * static_cast<double>(c)) / m;
+            }
+            nb::doNotOptimizeAway(sum);
+        });
+        b.run("simd", [&]() {
+            double sum{0};
+            for (size_t i = 1; i < n; ++i) { sum += Distance::Jaccard(sets[i - 1], sets[i]); }
+            nb::doNotOptimizeAway(sum);
+        });
+    }
+
+    SUBCASE("minhash")
+    {
+        constexpr size_t n = 100;
+        constexpr size_t k = Distance::DefaultSignatureSize;
+        std::vector<Operon::Vector<Operon::Hash>> sets(n);
+        for (auto& s : sets) {
+            s.resize(100);
+            std::generate(s.begin(), s.end(), [&]() { return rd(); });
+        }
+        std::vector<Operon::Hash> signature(k);
+
+        nb::Bench b;
+        b.title(fmt::format("minhash signatures ({})", Simd::Target)).relative(true).performanceCounters(true).minEpochIterations(minEpochIterations);
+        b.batch(n * k);
+        b.run("scalar", [&]() {
+            for (auto const& s : sets) {
+                std::fill(signature.begin(), signature.end(), std::numeric_limits<Operon::Hash>::max());
+                for (auto h : s) {
+                    for (size_t j = 0; j < k; ++j) {
+                        Operon::Hash z = h + (j + 1) * 0x9e3779b97f4a7c15ULL;
+                        z = (z ^ (z >> 30U)) * 0xbf58476d1ce4e5b9ULL;
+                        z = (z ^ (z >> 27U)) * 0x94d049bb133111ebULL;
+                        signature[j] = std::min(signature[j], z ^ (z >> 31U));
+                    }
+                }
+                nb::doNotOptimizeAway(signature);
+            }
+        });
+        b.run("simd", [&]() {
+            for (auto const& s : sets) {
+                Distance::MinHash(s, Operon::Span<Operon::Hash>(signature.data(), signature.size()));
+                nb::doNotOptimizeAway(signature);
+            }
+        });
+    }
+
+    SUBCASE("dominance")
+    {
+        constexpr size_t n = 10000;
+        constexpr size_t m = 8;
+        std::uniform_real_distribution<Operon::Scalar> dist(0, 1);
+        std::vector<Operon::Scalar> points(n * m);
+        std::generate(points.begin(), points.end(), [&]() { return dist(rd); });
+
+        nb::Bench b;
+        b.title(fmt::format("dominance ({})", Simd::Target)).relative(true).performanceCounters(true).minEpochIterations(minEpochIterations);
+        b.batch(n - 1);
+        auto test = [&](auto dim) {
+            constexpr size_t d = decltype(dim)::value;
+            b.run(fmt::format("m = {} (scalar)", d), [&]() {
+                int sum{0};
+                for (size_t i = 1; i < n; ++i) {
+                    sum += static_cast<int>(ParetoDominance<>{}(points.data() + (i - 1) * m, points.data() + (i - 1) * m + d, points.data() + i * m, points.data() + i * m + d));
+                }
+                nb::doNotOptimizeAway(sum);
+            });
+            b.run(fmt::format("m = {} (simd)", d), [&]() {
+                int sum{0};
+                for (size_t i = 1; i < n; ++i) {
+                    sum += static_cast<int>(detail::FixedDominance<d>(points.data() + (i - 1) * m, points.data() + i * m, Operon::Scalar{0}));
+                }
+                nb::doNotOptimizeAway(sum);
+            });
+        };
+        test(std::integral_constant<size_t, 2>{});
+        test(std::integral_constant<size_t, 3>{});
+        test(std::integral_constant<size_t, 4>{});
+        test(std::integral_constant<size_t, 8>{});
+    }
+
+    SUBCASE("error metrics")
+    {
+        constexpr size_t n = 10000;
+        std::normal_distribution<Operon::Scalar> dist(0, 1);
+        std::vector<Operon::Scalar> x(n);
+        std::vector<Operon::Scalar> y(n);
+        std::generate(x.begin(), x.end(), [&]() { return dist(rd); });
+        std::generate(y.begin(), y.end(), [&]() { return dist(rd); });
+        Operon::Span<Operon::Scalar const> sx(x.data(), n);
+        Operon::Span<Operon::Scalar const> sy(y.data(), n);
+
+        nb::Bench b;
+        b.title(fmt::format("error metric kernels ({})", Simd::Target)).relative(true).performanceCounters(true).minEpochIterations(minEpochIterations);
+        b.batch(n);
+        b.run("sse (scalar)", [&]() {
+            nb::doNotOptimizeAway(std::transform_reduce(x.begin(), x.end(), y.begin(), 0.0, std::plus<>{}, [](auto a, auto b) { auto e = static_cast<double>(a - b); return e * e; }));
+        });
+        b.run("sse (simd)", [&]() { nb::doNotOptimizeAway(Kernels::SumOfSquaredErrors(sx, sy)); });
+        b.run("sae (scalar)", [&]() {
+            nb::doNotOptimizeAway(std::transform_reduce(x.begin(), x.end(), y.begin(), 0.0, std::plus<>{}, [](auto a, auto b) { return std::abs(static_cast<double>(a - b)); }));
+        });
+        b.run("sae (simd)", [&]() { nb::doNotOptimizeAway(Kernels::SumOfAbsoluteErrors(sx, sy)); });
+        b.run("moments (simd)", [&]() { nb::doNotOptimizeAway(Kernels::Moments(sx, sy)); });
+    }
+}
+
+} // namespace Operon::Test
@@ -0,0 +1,177 @@
+// SPDX-License-Identifier: MIT
+// SPDX-FileCopyrightText: Copyright 2019-2022 Heal Research
+
+#include <array>
+#include <cstdlib>
+#include <doctest/doctest.h>
+#include <fmt/format.h>
+#include <fstream>
+#include <new>
+
+#include "operon/core/constants.hpp"
+#include "operon/core/dataset.hpp"
+#include "operon/core/pset.hpp"
+#include "operon/operators/creator.hpp"
+#include "operon/operators/crossover.hpp"
+#include "operon/operators/initializer.hpp"
+#include "operon/operators/mutation.hpp"
+
+#include "nanobench.h"
+
+// the variation benchmarks report the allocations per operation: the library allocates through the global operator
+// new, which only counts the allocations of a thread inside an AllocationScope (the other tests of the binary, and
+// the other threads, allocate as usual)
+namespace {
+    thread_local size_t* allocations { nullptr }; // NOLINT
+
+    class AllocationScope {
+    public:
+        explicit AllocationScope(size_t& count)
+            : previous_(allocations)
+        {
+            allocations = &count;
+        }
+        AllocationScope(AllocationScope const&) = delete;
+        AllocationScope(AllocationScope&&) = delete;
+        auto operator=(AllocationScope const&) -> AllocationScope& = delete;
+        auto operator=(AllocationScope&&) -> AllocationScope& = delete;
+        ~AllocationScope() { allocations = previous_; }
+
+    private:
+        size_t* previous_;
+    };
+} // namespace
+
+auto operator new(std::size_t size) -> void*
+{
+    if (allocations != nullptr) { ++*allocations; }
+    if (auto* p = std::malloc(size == 0 ? 1 : size)) { return p; } // NOLINT
+    throw std::bad_alloc {};
+}
+
+auto operator new[](std::size_t size) -> void*
+{
+    return ::operator new(size);
+}
+
+auto operator delete(void* p) noexcept -> void
+{
+    std::free(p); // NOLINT
+}
+
+auto operator delete[](void* p) noexcept -> void
+{
+    std::free(p); // NOLINT
+}
+
+auto operator delete(void* p, std::size_t /*unused*/) noexcept -> void
+{
+    std::free(p); // NOLINT
+}
+
+auto operator delete[](void* p, std::size_t /*unused*/) noexcept -> void
+{
+    std::free(p); // NOLINT
+}
+
+namespace Operon::Test {
+    namespace nb = ankerl::nanobench;
+
+    // the variation operators and the tree maintenance routines on trees of increasing length, one operation per
+    // iteration. the results go to variation.csv (operations per second and allocations per operation) and
+    // variation.json (nanobench)
+    TEST_CASE("Variation operator performance" * doctest::test_suite("[performance]"))
+    {
+        constexpr std::array<size_t, 5> lengths { 10, 30, 100, 300, 1000 };
+        constexpr size_t n { 1000 }; // trees per length, the operations cycle through them
+        constexpr size_t maxDepth { 1000 };
+        constexpr double internalProbability { 0.9 };
+        constexpr uint64_t seed { 1234 };
+
+        std::srand(seed); // NOLINT
+        Operon::RandomGenerator random(seed);
+        Eigen::Matrix<Operon::Scalar, -1, -1> data = decltype(data)::Random(10, 10); // NOLINT
+        auto ds = Dataset(data);
+        auto variables = ds.Variables();
+
+        PrimitiveSet pset;
+        pset.SetConfig(PrimitiveSet::Arithmetic | NodeType::Exp | NodeType::Log | NodeType::Sin | NodeType::Cos);
+
+        BalancedTreeCreator btc { pset, variables };
+        ProbabilisticTreeCreator ptc { pset, variables };
+        GrowTreeCreator grow { pset, variables };
+
+        NormalCoefficientInitializer coeffInit;
+        coeffInit.ParameterizeDistribution(Operon::Scalar { 0 }, Operon::Scalar { 1 });
+
+        OnePointMutation<std::normal_distribution<Operon::Scalar>> onePoint;
+        onePoint.ParameterizeDistribution(Operon::Scalar { 0 }, Operon::Scalar { 1 });
+        MultiPointMutation<std::normal_distribution<Operon::Scalar>> multiPoint;
+        multiPoint.ParameterizeDistribution(Operon::Scalar { 0 }, Operon::Scalar { 1 });
+        DiscretePointMutation discretePoint;
+        for (auto v : Operon::Math::Constants) { discretePoint.Add(static_cast<Operon::Scalar>(v), 1); }
+        ChangeVariableMutation changeVar { variables };
+        ChangeFunctionMutation changeFunc { pset };
+        RemoveSubtreeMutation removeSubtree { pset };
+        ShuffleSubtreesMutation shuffleSubtrees;
+
+        std::ofstream csv("./variation.csv");
+        csv << "benchmark,length,operations_per_second,allocations_per_operation\n";
+
+        nb::Bench bench;
+        bench.title("Variation operators").relative(false).performanceCounters(true).minEpochIterations(100); // NOLINT
+
+        for (auto length : lengths) {
+            std::vector<Tree> trees(n);
+            std::generate(trees.begin(), trees.end(), [&]() { return btc(random, length, 0, maxDepth); });
+            auto const maxLength = 2 * length;
+
+            SubtreeCrossover crossover { internalProbability, maxDepth, maxLength };
+            InsertSubtreeMutation insertSubtree { btc, coeffInit, maxDepth, maxLength };
+            ReplaceSubtreeMutation replaceSubtree { btc, coeffInit, maxDepth, maxLength };
+
+            // op is called with the index of the next tree
+            auto test = [&](std::string const& name, auto&& op) {
+                size_t i { 0 };
+                size_t count { 0 }; // only those of the operation, not those of the benchmark
+                bench.run(fmt::format("{} length={}", name, length), [&]() {
+                    AllocationScope scope(count);
+                    op(i++ % n);
+                });
+                auto const seconds = bench.results().back().median(nb::Result::Measure::elapsed);
+                csv << fmt::format("{},{},{},{}\n", name, length, 1.0 / seconds, static_cast<double>(count) / static_cast<double>(i));
+                csv.flush();
+            };
+
+            test("subtree crossover", [&](size_t i) { nb::doNotOptimizeAway(crossover(random, trees[i], trees[(i + 1) % n])); });
+
+            auto mutation = [&](std::string const& name, MutatorBase const& mutator) {
+                test(name, [&](size_t i) { nb::doNotOptimizeAway(mutator(random, trees[i])); });
+            };
+            mutation("one point mutation", onePoint);
+            mutation("multi point mutation", multiPoint);
+            mutation("discrete point mutation", discretePoint);
+            mutation("change variable mutation", changeVar);
+            mutation("change function mutation", changeFunc);
+            mutation("remove subtree mutation", removeSubtree);
+            mutation("insert subtree mutation", insertSubtree);
+            mutation("replace subtree mutation", replaceSubtree);
+            mutation("shuffle subtrees mutation", shuffleSubtrees);
+
+            // the grow creator has no target length, the depth limit gives trees of the same order of magnitude
+            size_t growDepth { 1 };
+            while ((size_t { 1 } << growDepth) <= length) { ++growDepth; }
+            test("balanced tree creator", [&](size_t /*unused*/) { nb::doNotOptimizeAway(btc(random, length, 0, maxDepth)); });
+            test("probabilistic tree creator", [&](size_t /*unused*/) { nb::doNotOptimizeAway(ptc(random, length, 0, maxDepth)); });
+            test("grow tree creator", [&](size_t /*unused*/) { nb::doNotOptimizeAway(grow(random, length, 0, growDepth)); });
+
+            test("tree hash (strict)", [&](size_t i) { nb::doNotOptimizeAway(trees[i].Hash(Operon::HashMode::Strict)); });
+            test("tree hash (relaxed)", [&](size_t i) { nb::doNotOptimizeAway(trees[i].Hash(Operon::HashMode::Relaxed)); });
+            test("tree sort", [&](size_t i) { nb::doNotOptimizeAway(trees[i].Sort()); });
+            test("tree update nodes", [&](size_t i) { nb::doNotOptimizeAway(trees[i].UpdateNodes()); });
+        }
+
+        std::ofstream json("./variation.json");
+        bench.render(nb::templates::json(), json);
+    }
+} // namespace Operon::Test